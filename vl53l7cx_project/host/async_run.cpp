@@ -0,0 +1,258 @@
+/**
+ * VL53L7CX Asynchronous Transfers on the Simulated Device
+ *
+ * Runs the async engine (vl53l7cx_async.c) of the host platform layer with a
+ * completion delay (async_delay_us of the platform structure) on the
+ * register-level simulator (vl53l7cx_simulator.hpp), and checks:
+ *   callback   VL53L7CX_RdMultiAsync() of a frame: busy at submission, a
+ *              second submission refused, the buffer untouched until the
+ *              transfer completes, one callback in state DONE after the delay
+ *              and the transfer time
+ *   frames     vl53l7cx_start_ranging_data_read() then polls while busy and
+ *              vl53l7cx_finish_ranging_data_read(); each frame is checked
+ *              against the scene
+ *   timeout    vl53l7cx_finish_ranging_data_read() with a timeout shorter than
+ *              the delay: timeout error after the timeout, transfer aborted
+ *              (the frame is never read), engine free for the next transfer
+ *   abort      VL53L7CX_WaitAsync() timing out on a transfer with a callback:
+ *              one callback in state TIMEOUT
+ *   failed     a frame read refused by the bus, seen by VL53L7CX_PollAsync():
+ *              vl53l7cx_finish_ranging_data_read() returns an error and leaves
+ *              the results untouched
+ *   unstarted  vl53l7cx_finish_ranging_data_read() with no read started, and
+ *              again after a frame was decoded: invalid parameter, results
+ *              untouched
+ *
+ * Usage: vl53l7cx_async [--delay-us us] [--frames n]
+ *
+ * The delay must be more than 1 ms (the timeout of the timeout checks). The
+ * exit status is 1 if a check fails.
+ */
+
+#include <cinttypes>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+#include "vl53l7cx_simulator.hpp"
+#include "vl53l7cx_check.hpp"
+
+namespace {
+
+using vl53l7cx::check;
+using vl53l7cx::compare;
+
+struct Completion {
+    unsigned calls = 0;
+    uint8_t state = VL53L7CX_ASYNC_IDLE;
+    uint64_t latency_us = 0;
+};
+
+void on_complete(VL53L7CX_AsyncXfer *p_xfer, void *p_user)
+{
+    Completion *completion = static_cast<Completion *>(p_user);
+    completion->calls++;
+    completion->state = p_xfer->state;
+    completion->latency_us = p_xfer->complete_time_us - p_xfer->submit_time_us;
+}
+
+/* Wait for the next frame; false after a second without one */
+bool wait_frame(VL53L7CX_Configuration &dev, vl53l7cx::SimulatedDevice &device)
+{
+    uint64_t start_us = device.time_us();
+    uint8_t ready = 0;
+    while (vl53l7cx_check_data_ready(&dev, &ready) == VL53L7CX_STATUS_OK && !ready) {
+        (void)VL53L7CX_WaitUs(&dev.platform, 1000);
+        if (device.time_us() - start_us > 1000000) {
+            return false;
+        }
+    }
+    return ready != 0;
+}
+
+/* Bus access refused by the device (NACK) */
+uint8_t refuse(void *p_ctx, uint16_t address, uint8_t *p_values, uint32_t size)
+{
+    (void)p_ctx;
+    (void)address;
+    (void)p_values;
+    (void)size;
+    return 255;
+}
+
+} // namespace
+
+int main(int argc, char **argv)
+{
+    uint32_t delay_us = 2000;
+    unsigned nb_frames = 20;
+
+    for (int i = 1; i < argc; i++) {
+        if (std::strcmp(argv[i], "--delay-us") == 0 && i + 1 < argc) {
+            delay_us = static_cast<uint32_t>(std::atol(argv[++i]));
+        } else if (std::strcmp(argv[i], "--frames") == 0 && i + 1 < argc) {
+            nb_frames = static_cast<unsigned>(std::atoi(argv[++i]));
+        } else {
+            std::fprintf(stderr, "Usage: %s [--delay-us us] [--frames n]\n", argv[0]);
+            return 2;
+        }
+    }
+    if (delay_us <= 1000 + VL53L7CX_HOST_ASYNC_STEP_US) {
+        std::fprintf(stderr, "The delay must be more than %u us\n",
+                1000 + VL53L7CX_HOST_ASYNC_STEP_US);
+        return 2;
+    }
+
+    vl53l7cx::SimulatedDevice device;
+    static VL53L7CX_Configuration dev;
+    static VL53L7CX_ResultsData results, expected;
+    dev.platform.address = VL53L7CX_DEFAULT_I2C_ADDRESS;
+    device.attach(dev);
+
+    uint8_t status = vl53l7cx_init(&dev);
+    status |= vl53l7cx_set_ranging_frequency_hz(&dev, 30);
+    status |= vl53l7cx_start_ranging(&dev);
+    if (status != VL53L7CX_STATUS_OK) {
+        std::printf("init FAILED (status %u)\n", status);
+        return 1;
+    }
+    dev.platform.async_delay_us = delay_us;
+    std::printf("delay %" PRIu32 " us, frames of %" PRIu32 " bytes\n", delay_us,
+            dev.data_read_size);
+    bool ok = true;
+
+    // Callback: nothing reaches the buffer before the delay, one DONE after it
+    {
+        Completion completion;
+        std::vector<uint8_t> buffer(dev.data_read_size, 0xA5), other(dev.data_read_size);
+        bool ready = wait_frame(dev, device);
+        uint8_t submitted = VL53L7CX_RdMultiAsync(&dev.platform, 0x0, buffer.data(),
+                dev.data_read_size, on_complete, &completion);
+        uint8_t refused = VL53L7CX_RdMultiAsync(&dev.platform, 0x0, other.data(),
+                dev.data_read_size, NULL, NULL);
+        uint8_t busy = VL53L7CX_PollAsync(&dev.platform);
+        bool untouched = std::vector<uint8_t>(dev.data_read_size, 0xA5) == buffer;
+        uint64_t bus_us = device.stats().bus_us;
+        uint8_t waited = VL53L7CX_WaitAsync(&dev.platform, 50);
+        bus_us = device.stats().bus_us - bus_us;
+        bool filled = std::vector<uint8_t>(dev.data_read_size, 0xA5) != buffer;
+        std::printf("  %u callback, state %u, after %" PRIu64 " us (%" PRIu64 " us on the bus)\n",
+                completion.calls, completion.state, completion.latency_us, bus_us);
+        ok &= check("callback", ready && submitted == 0 && refused != 0
+                && busy == VL53L7CX_ASYNC_BUSY && untouched && waited == 0 && filled
+                && completion.calls == 1 && completion.state == VL53L7CX_ASYNC_DONE
+                && completion.latency_us >= delay_us
+                && completion.latency_us <= delay_us + VL53L7CX_HOST_ASYNC_STEP_US + bus_us
+                && !vl53l7cx_async_is_busy(&dev.platform.async));
+    }
+
+    // Frames: the read runs in the background, the decoded results are the scene
+    {
+        unsigned decoded = 0, mismatches = 0;
+        uint64_t busy_polls = 0;
+        status = 0;
+        while (status == VL53L7CX_STATUS_OK && decoded < nb_frames) {
+            if (!wait_frame(dev, device)) {
+                status = VL53L7CX_STATUS_TIMEOUT_ERROR;
+                break;
+            }
+            status |= vl53l7cx_start_ranging_data_read(&dev);
+            while (VL53L7CX_PollAsync(&dev.platform) == VL53L7CX_ASYNC_BUSY) {
+                busy_polls++;
+                (void)VL53L7CX_WaitUs(&dev.platform, 250);
+            }
+            status |= vl53l7cx_finish_ranging_data_read(&dev, &results, 50);
+            decoded++;
+            if (!device.last_frame(expected) || compare(expected, results, device.resolution())) {
+                mismatches++;
+            }
+        }
+        std::printf("  %u frames, %u mismatches, %.1f busy polls per frame\n", decoded,
+                mismatches, decoded ? double(busy_polls) / decoded : 0.0);
+        ok &= check("frames", status == VL53L7CX_STATUS_OK && decoded == nb_frames
+                && mismatches == 0 && busy_polls >= nb_frames);
+    }
+
+    // Timeout: the transfer is aborted before it reaches the device
+    {
+        bool ready = wait_frame(dev, device);
+        uint64_t frames_read = device.stats().frames_read;
+        uint8_t started = vl53l7cx_start_ranging_data_read(&dev);
+        uint64_t start_us = device.time_us();
+        uint8_t finished = vl53l7cx_finish_ranging_data_read(&dev, &results, 1);
+        uint64_t elapsed_us = device.time_us() - start_us;
+        bool aborted = !vl53l7cx_async_is_busy(&dev.platform.async)
+                && device.stats().frames_read == frames_read;
+        status = vl53l7cx_start_ranging_data_read(&dev);
+        status |= vl53l7cx_finish_ranging_data_read(&dev, &results, 50);
+        bool next = status == VL53L7CX_STATUS_OK && device.stats().frames_read == frames_read + 1
+                && device.last_frame(expected)
+                && compare(expected, results, device.resolution()) == 0;
+        std::printf("  timed out after %" PRIu64 " us, %s, next read %s\n", elapsed_us,
+                aborted ? "aborted" : "NOT ABORTED", next ? "ok" : "FAILED");
+        ok &= check("timeout", ready && started == 0
+                && finished == VL53L7CX_STATUS_TIMEOUT_ERROR && elapsed_us >= 1000
+                && elapsed_us <= 1000 + VL53L7CX_HOST_ASYNC_STEP_US && aborted && next);
+    }
+
+    // Abort: the callback reports the timeout
+    {
+        Completion completion;
+        std::vector<uint8_t> buffer(dev.data_read_size, 0xA5);
+        bool ready = wait_frame(dev, device);
+        uint8_t submitted = VL53L7CX_RdMultiAsync(&dev.platform, 0x0, buffer.data(),
+                dev.data_read_size, on_complete, &completion);
+        uint8_t waited = VL53L7CX_WaitAsync(&dev.platform, 1);
+        uint8_t idle = VL53L7CX_PollAsync(&dev.platform);
+        bool untouched = std::vector<uint8_t>(dev.data_read_size, 0xA5) == buffer;
+        std::printf("  %u callback, state %u, after %" PRIu64 " us\n", completion.calls,
+                completion.state, completion.latency_us);
+        ok &= check("abort", ready && submitted == 0 && waited != 0
+                && idle == VL53L7CX_ASYNC_IDLE && untouched && completion.calls == 1
+                && completion.state == VL53L7CX_ASYNC_TIMEOUT);
+    }
+
+    // Failed: the transfer ends in error while polled, finish reports it
+    {
+        const VL53L7CX_HostBusOps *p_bus = dev.platform.p_bus;
+        VL53L7CX_HostBusOps refusing = *p_bus;
+        refusing.read = refuse;
+        bool ready = wait_frame(dev, device);
+        std::memset(&results, 0xA5, sizeof(results));
+        expected = results;
+        uint8_t started = vl53l7cx_start_ranging_data_read(&dev);
+        dev.platform.p_bus = &refusing;
+        uint8_t state;
+        while ((state = VL53L7CX_PollAsync(&dev.platform)) == VL53L7CX_ASYNC_BUSY) {
+            (void)VL53L7CX_WaitUs(&dev.platform, 250);
+        }
+        dev.platform.p_bus = p_bus;
+        uint8_t finished = vl53l7cx_finish_ranging_data_read(&dev, &results, 50);
+        bool untouched = std::memcmp(&results, &expected, sizeof(results)) == 0;
+        std::printf("  ended in state %u, finish status %u\n", state, finished);
+        ok &= check("failed", ready && started == 0 && state == VL53L7CX_ASYNC_ERROR
+                && finished == VL53L7CX_STATUS_ERROR && untouched);
+    }
+
+    // Unstarted: nothing to decode, before a read and after its frame
+    {
+        std::memset(&results, 0xA5, sizeof(results));
+        expected = results;
+        uint8_t never = vl53l7cx_finish_ranging_data_read(&dev, &results, 50);
+        bool untouched = std::memcmp(&results, &expected, sizeof(results)) == 0;
+        bool ready = wait_frame(dev, device);
+        status = vl53l7cx_start_ranging_data_read(&dev);
+        status |= vl53l7cx_finish_ranging_data_read(&dev, &results, 50);
+        std::memset(&results, 0xA5, sizeof(results));
+        uint8_t again = vl53l7cx_finish_ranging_data_read(&dev, &results, 50);
+        untouched &= std::memcmp(&results, &expected, sizeof(results)) == 0;
+        ok &= check("unstarted", never == VL53L7CX_STATUS_INVALID_PARAM && ready
+                && status == VL53L7CX_STATUS_OK && again == VL53L7CX_STATUS_INVALID_PARAM
+                && untouched);
+    }
+
+    dev.platform.async_delay_us = 0;
+    status = vl53l7cx_stop_ranging(&dev);
+    ok &= status == VL53L7CX_STATUS_OK;
+    return ok ? 0 : 1;
+}
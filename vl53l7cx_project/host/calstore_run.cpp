@@ -0,0 +1,241 @@
+/**
+ * VL53L7CX Calibration Store on the Simulated Device
+ *
+ * Runs the calibration store (vl53l7cx_calstore.h) with its file backend
+ * (vl53l7cx_calstore_init_file()) on register-level simulators
+ * (vl53l7cx_simulator.hpp) with different NVM content, and checks:
+ *   round trip  a calibration (Xtalk buffer and margin) captured and saved,
+ *               then loaded after a power cycle, is the record captured, and
+ *               applying it gives the sensor its Xtalk buffer and margin back
+ *   empty       a slot never written (inside or past the end of the file)
+ *               loads as EMPTY
+ *   corrupted   a record with a byte flipped, or cut short (partial write),
+ *               loads as CORRUPTED
+ *   old version a record of another format version loads as OLD_VERSION
+ *   other       a record applied to another sensor returns OTHER_SENSOR and
+ *               sends nothing
+ *   slots       slots past the store are refused with ERROR
+ *
+ * Usage: vl53l7cx_calstore [--file path]
+ *
+ * The store file (by default a temporary one, removed at the end) is
+ * overwritten. The exit status is 1 if a check fails.
+ */
+
+#include <unistd.h>
+#include <cinttypes>
+#include <cstddef>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+#include "vl53l7cx_simulator.hpp"
+#include "vl53l7cx_check.hpp"
+
+extern "C" {
+#include "vl53l7cx_calstore.h"
+#include "vl53l7cx_plugin_xtalk.h"
+}
+
+namespace {
+
+using vl53l7cx::check;
+
+const uint8_t kSlots = 4;
+const uint8_t kSlot = 1;            // Slot 0 stays erased
+const uint32_t kMargin = 120;       // kcps/spads, 50 by default
+
+struct Sensor {
+    vl53l7cx::SimulatedDevice device;
+    VL53L7CX_Configuration dev;
+
+    explicit Sensor(uint32_t nvm_seed) : device(options(nvm_seed)) {}
+
+    static vl53l7cx::SimulatorOptions options(uint32_t nvm_seed)
+    {
+        vl53l7cx::SimulatorOptions options;
+        options.nvm_seed = nvm_seed;
+        return options;
+    }
+
+    /* Host reset: fresh configuration, cold init */
+    bool init()
+    {
+        std::memset(&dev, 0, sizeof(dev));
+        dev.platform.address = VL53L7CX_DEFAULT_I2C_ADDRESS;
+        device.attach(dev);
+        return vl53l7cx_init(&dev) == VL53L7CX_STATUS_OK;
+    }
+};
+
+/* Xtalk buffer and margin of a sensor, as given by the driver */
+bool read_xtalk(VL53L7CX_Configuration &dev, std::vector<uint8_t> &xtalk, uint32_t &margin)
+{
+    xtalk.assign(VL53L7CX_XTALK_BUFFER_SIZE, 0);
+    return vl53l7cx_get_caldata_xtalk(&dev, xtalk.data()) == VL53L7CX_STATUS_OK
+            && vl53l7cx_get_xtalk_margin(&dev, &margin) == VL53L7CX_STATUS_OK;
+}
+
+/* A calibration of its own: the data of each block of an Xtalk buffer
+ * (firmware order, headers and end of list kept) changed */
+void alter_xtalk(std::vector<uint8_t> &xtalk)
+{
+    size_t pos = 0;
+    while (pos + 4 <= xtalk.size()) {
+        uint32_t header = (uint32_t(xtalk[pos]) << 24) | (uint32_t(xtalk[pos + 1]) << 16)
+                | (uint32_t(xtalk[pos + 2]) << 8) | xtalk[pos + 3];
+        uint32_t type = header & 0xf, size = (header >> 4) & 0xfff;
+        if (header == 0x0000000f) {
+            break;
+        }
+        size = (type >= 0x1 && type < 0xd) ? type * size : size;
+        for (size_t i = pos + 4; i < pos + 4 + size && i < xtalk.size(); i++) {
+            xtalk[i] = static_cast<uint8_t>(xtalk[i] + 0x11);
+        }
+        pos += 4 + size;
+    }
+}
+
+/* Change the bytes of a record in the store file */
+bool patch_file(const std::string &path, uint8_t slot, size_t offset, const void *p_data,
+        size_t size)
+{
+    FILE *p_file = std::fopen(path.c_str(), "r+b");
+    if (!p_file) {
+        return false;
+    }
+    bool ok = std::fseek(p_file, long(slot * sizeof(VL53L7CX_CalRecord) + offset), SEEK_SET) == 0
+            && std::fwrite(p_data, 1, size, p_file) == size;
+    return std::fclose(p_file) == 0 && ok;
+}
+
+bool truncate_file(const std::string &path, size_t size)
+{
+    return ::truncate(path.c_str(), static_cast<off_t>(size)) == 0;
+}
+
+} // namespace
+
+int main(int argc, char **argv)
+{
+    std::string path;
+    bool temporary = false;
+
+    for (int i = 1; i < argc; i++) {
+        if (std::strcmp(argv[i], "--file") == 0 && i + 1 < argc) {
+            path = argv[++i];
+        } else {
+            std::fprintf(stderr, "Usage: %s [--file path]\n", argv[0]);
+            return 2;
+        }
+    }
+    if (path.empty()) {
+        char name[] = "/tmp/vl53l7cx_calstore_XXXXXX";
+        int fd = mkstemp(name);
+        if (fd < 0) {
+            std::fprintf(stderr, "Cannot create a temporary file\n");
+            return 1;
+        }
+        close(fd);
+        path = name;
+        temporary = true;
+    }
+    std::remove(path.c_str());
+
+    static Sensor sensor(1), other(2);
+    static VL53L7CX_CalRecord captured, record;
+    VL53L7CX_CalStore store;
+    bool ok = true;
+
+    if (!sensor.init() || !other.init()
+            || vl53l7cx_calstore_init_file(&store, path.c_str(), kSlots) != VL53L7CX_CALSTORE_OK) {
+        std::printf("init FAILED\n");
+        return 1;
+    }
+    std::printf("%s: %u slots of %zu bytes\n", path.c_str(), kSlots, sizeof(VL53L7CX_CalRecord));
+
+    // Round trip: calibrate, capture and save, then power cycle and apply
+    {
+        std::vector<uint8_t> xtalk, defaults;
+        uint32_t margin = 0, default_margin = 0;
+        bool read = read_xtalk(sensor.dev, defaults, default_margin);
+
+        xtalk = defaults;
+        alter_xtalk(xtalk);
+        uint8_t status = vl53l7cx_set_caldata_xtalk(&sensor.dev, xtalk.data());
+        status |= vl53l7cx_set_xtalk_margin(&sensor.dev, kMargin);
+        uint8_t saved = vl53l7cx_calstore_capture(&sensor.dev, &captured);
+        saved |= vl53l7cx_calstore_save(&store, kSlot, &captured);
+        bool calibrated = xtalk != defaults
+                && std::memcmp(captured.xtalk_data, xtalk.data(), xtalk.size()) == 0
+                && captured.xtalk_margin == kMargin;
+
+        sensor.device.power_cycle();
+        bool reset = sensor.init() && read_xtalk(sensor.dev, xtalk, margin)
+                && xtalk == defaults && margin == default_margin;
+        uint8_t loaded = vl53l7cx_calstore_load(&store, kSlot, &record);
+        bool same = std::memcmp(&record, &captured, sizeof(record)) == 0;
+        uint8_t applied = vl53l7cx_calstore_apply(&sensor.dev, &record);
+        bool restored = read_xtalk(sensor.dev, xtalk, margin)
+                && std::memcmp(xtalk.data(), captured.xtalk_data, xtalk.size()) == 0
+                && margin == kMargin;
+        std::printf("  margin %" PRIu32 " after apply (%" PRIu32 " by default)\n", margin,
+                default_margin);
+        ok &= check("round trip", read && status == VL53L7CX_STATUS_OK && calibrated
+                && saved == VL53L7CX_CALSTORE_OK && reset && loaded == VL53L7CX_CALSTORE_OK
+                && same && applied == VL53L7CX_CALSTORE_OK && restored);
+    }
+
+    // Empty: slot 0 before the record, slot 3 past the end of the file
+    ok &= check("empty", vl53l7cx_calstore_load(&store, 0, &record) == VL53L7CX_CALSTORE_EMPTY
+            && vl53l7cx_calstore_load(&store, kSlots - 1, &record) == VL53L7CX_CALSTORE_EMPTY);
+
+    // Corrupted: one Xtalk byte flipped, then the record cut short
+    {
+        uint8_t flipped = static_cast<uint8_t>(captured.xtalk_data[100] ^ 0x01);
+        bool patched = patch_file(path, kSlot,
+                offsetof(VL53L7CX_CalRecord, xtalk_data) + 100, &flipped, 1);
+        uint8_t bad_crc = vl53l7cx_calstore_load(&store, kSlot, &record);
+        patched &= vl53l7cx_calstore_save(&store, kSlot, &captured) == VL53L7CX_CALSTORE_OK
+                && truncate_file(path, kSlot * sizeof(VL53L7CX_CalRecord)
+                        + offsetof(VL53L7CX_CalRecord, xtalk_data));
+        uint8_t cut = vl53l7cx_calstore_load(&store, kSlot, &record);
+        ok &= check("corrupted", patched && bad_crc == VL53L7CX_CALSTORE_CORRUPTED
+                && cut == VL53L7CX_CALSTORE_CORRUPTED);
+    }
+
+    // Old version: a record of the previous format
+    {
+        uint16_t version = VL53L7CX_CALSTORE_VERSION - 1;
+        bool patched = vl53l7cx_calstore_save(&store, kSlot, &captured) == VL53L7CX_CALSTORE_OK
+                && patch_file(path, kSlot, offsetof(VL53L7CX_CalRecord, version), &version,
+                        sizeof(version));
+        ok &= check("old version", patched
+                && vl53l7cx_calstore_load(&store, kSlot, &record) == VL53L7CX_CALSTORE_OLD_VERSION);
+    }
+
+    // Other sensor: the record loads, but is not applied
+    {
+        std::vector<uint8_t> xtalk;
+        uint32_t margin = 0;
+        bool saved = vl53l7cx_calstore_save(&store, kSlot, &captured) == VL53L7CX_CALSTORE_OK;
+        uint8_t loaded = vl53l7cx_calstore_load(&store, kSlot, &record);
+        uint64_t writes = other.device.stats().writes;
+        uint8_t applied = vl53l7cx_calstore_apply(&other.dev, &record);
+        writes = other.device.stats().writes - writes;
+        bool untouched = read_xtalk(other.dev, xtalk, margin) && margin != kMargin;
+        ok &= check("other", saved && loaded == VL53L7CX_CALSTORE_OK
+                && applied == VL53L7CX_CALSTORE_OTHER_SENSOR && writes == 0 && untouched);
+    }
+
+    // Slots: past the store
+    ok &= check("slots", vl53l7cx_calstore_save(&store, kSlots, &captured)
+                    == VL53L7CX_CALSTORE_ERROR
+            && vl53l7cx_calstore_load(&store, kSlots, &record) == VL53L7CX_CALSTORE_ERROR);
+
+    if (temporary) {
+        std::remove(path.c_str());
+    }
+    return ok ? 0 : 1;
+}
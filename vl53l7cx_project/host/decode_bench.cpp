@@ -0,0 +1,238 @@
+/**
+ * VL53L7CX Frame Decoding Benchmark
+ *
+ * Decodes raw frames of the synthetic scene of the simulator (every output of
+ * the build, 4x4 and 8x8, firmware byte order as read at address 0x0) with the
+ * driver, through vl53l7cx_finish_ranging_data_read() on a transfer marked
+ * as complete (the decoder alone), and with the decoder the driver had before:
+ * VL53L7CX_SwapBuffer() on the whole frame, then a memcpy() of each block.
+ * For each resolution it reports:
+ *   - the frames decoded differently (whole results structure, stream count
+ *     and status, on valid frames and frames with a wrong footer id);
+ *   - the time per frame of both, and the cycles per frame (time stamp
+ *     counter, x86).
+ *
+ * Usage: vl53l7cx_decode_bench [--rounds n]
+ *
+ * The exit status is 1 if a frame is decoded differently.
+ */
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define HAVE_TSC 1
+#endif
+
+#include "vl53l7cx_simulator.hpp"
+#include "vl53l7cx_replay.hpp"
+
+namespace {
+
+const unsigned kFrames = 64;        // Frames decoded per round
+
+/* Decoder of the driver before the single pass: swap the whole frame, then
+ * copy each block (raw format) */
+uint8_t decode_reference(uint8_t *buffer, uint32_t size, VL53L7CX_ResultsData &results,
+        uint8_t &streamcount)
+{
+    streamcount = buffer[0];
+    VL53L7CX_SwapBuffer(buffer, static_cast<uint16_t>(size));
+
+    for (uint32_t i = 16; i < size; i += 4) {
+        union Block_header *bh = reinterpret_cast<union Block_header *>(&buffer[i]);
+        uint32_t msize = (bh->type > 0x1 && bh->type < 0xd) ? bh->type * bh->size : bh->size;
+        void *dst = nullptr;
+        switch (bh->idx) {
+        case VL53L7CX_METADATA_IDX:
+            results.silicon_temp_degc = static_cast<int8_t>(buffer[i + 12]);
+            break;
+#ifndef VL53L7CX_DISABLE_AMBIENT_PER_SPAD
+        case VL53L7CX_AMBIENT_RATE_IDX:
+            dst = results.ambient_per_spad;
+            break;
+#endif
+#ifndef VL53L7CX_DISABLE_NB_SPADS_ENABLED
+        case VL53L7CX_SPAD_COUNT_IDX:
+            dst = results.nb_spads_enabled;
+            break;
+#endif
+#ifndef VL53L7CX_DISABLE_NB_TARGET_DETECTED
+        case VL53L7CX_NB_TARGET_DETECTED_IDX:
+            dst = results.nb_target_detected;
+            break;
+#endif
+#ifndef VL53L7CX_DISABLE_SIGNAL_PER_SPAD
+        case VL53L7CX_SIGNAL_RATE_IDX:
+            dst = results.signal_per_spad;
+            break;
+#endif
+#ifndef VL53L7CX_DISABLE_RANGE_SIGMA_MM
+        case VL53L7CX_RANGE_SIGMA_MM_IDX:
+            dst = results.range_sigma_mm;
+            break;
+#endif
+#ifndef VL53L7CX_DISABLE_DISTANCE_MM
+        case VL53L7CX_DISTANCE_IDX:
+            dst = results.distance_mm;
+            break;
+#endif
+#ifndef VL53L7CX_DISABLE_REFLECTANCE_PERCENT
+        case VL53L7CX_REFLECTANCE_EST_PC_IDX:
+            dst = results.reflectance;
+            break;
+#endif
+#ifndef VL53L7CX_DISABLE_TARGET_STATUS
+        case VL53L7CX_TARGET_STATUS_IDX:
+            dst = results.target_status;
+            break;
+#endif
+#ifndef VL53L7CX_DISABLE_MOTION_INDICATOR
+        case VL53L7CX_MOTION_DETEC_IDX:
+            dst = &results.motion_indicator;
+            break;
+#endif
+        default:
+            break;
+        }
+        if (dst) {
+            std::memcpy(dst, &buffer[i + 4], msize);
+        }
+        i += msize;
+    }
+
+    uint16_t header_id = static_cast<uint16_t>((buffer[0x8] << 8) | buffer[0x9]);
+    uint16_t footer_id = static_cast<uint16_t>((buffer[size - 4] << 8) | buffer[size - 3]);
+    return header_id != footer_id ? VL53L7CX_STATUS_CORRUPTED_FRAME : VL53L7CX_STATUS_OK;
+}
+
+struct Timing {
+    double ns = 0.0;
+    uint64_t cycles = 0;
+};
+
+template <typename F>
+void timed(Timing &timing, F run)
+{
+#ifdef HAVE_TSC
+    uint64_t tsc = __rdtsc();
+#endif
+    auto start = std::chrono::steady_clock::now();
+    run();
+    timing.ns += std::chrono::duration<double, std::nano>(
+            std::chrono::steady_clock::now() - start).count();
+#ifdef HAVE_TSC
+    timing.cycles += __rdtsc() - tsc;
+#endif
+}
+
+/* Decode kFrames frames of a resolution rounds times with both decoders;
+ * returns the frames decoded differently */
+unsigned bench(uint8_t resolution, unsigned rounds)
+{
+    const uint32_t mask = VL53L7CX_OUTPUT_AVAILABLE;
+    const uint32_t size = vl53l7cx::ranging_frame_size(resolution, mask);
+    std::vector<std::vector<uint8_t>> frames(kFrames, std::vector<uint8_t>(size));
+
+    // One configuration per frame, its temp_buffer holding the frame
+    static VL53L7CX_Configuration devs[kFrames];
+#ifdef VL53L7CX_SHARED_TEMP_BUFFER
+    static VL53L7CX_TempArena arenas[kFrames];
+#endif
+    static VL53L7CX_ResultsData results[kFrames], expected[kFrames];
+    std::vector<std::vector<uint8_t>> buffers(kFrames);
+    std::vector<uint8_t> streamcounts(kFrames);
+
+    for (unsigned f = 0; f < kFrames; f++) {
+        VL53L7CX_ResultsData scene;
+        std::memset(&scene, 0, sizeof(scene));
+        vl53l7cx::synthetic_scene(f, f * 66667ULL, resolution, scene);
+        // Every 8th frame has a wrong footer id
+        uint16_t id = static_cast<uint16_t>(f + 1);
+        vl53l7cx::encode_ranging_frame(scene, resolution, mask, static_cast<uint8_t>(f), id,
+                f % 8 == 7 ? static_cast<uint16_t>(id + 1) : id, frames[f].data(), size);
+
+        std::memset(&devs[f], 0, sizeof(devs[f]));
+#ifdef VL53L7CX_SHARED_TEMP_BUFFER
+        (void)vl53l7cx_set_temp_arena(&devs[f], &arenas[f]);
+#endif
+        devs[f].data_read_size = size;
+    }
+
+    Timing driver, reference;
+    unsigned differ = 0;
+    for (unsigned round = 0; round < rounds; round++) {
+        // The reference swaps its buffers in place: refill them, and the
+        // buffers of the driver so that both start from the same cache state
+        for (unsigned f = 0; f < kFrames; f++) {
+            buffers[f] = frames[f];
+            std::memcpy(devs[f].temp_buffer, frames[f].data(), size);
+            devs[f].platform.async_xfer.state = VL53L7CX_ASYNC_DONE;
+        }
+        std::vector<uint8_t> statuses(kFrames), reference_statuses(kFrames);
+
+        timed(reference, [&] {
+            for (unsigned f = 0; f < kFrames; f++) {
+                reference_statuses[f] = decode_reference(buffers[f].data(), size, expected[f],
+                        streamcounts[f]);
+            }
+        });
+        timed(driver, [&] {
+            for (unsigned f = 0; f < kFrames; f++) {
+                statuses[f] = vl53l7cx_finish_ranging_data_read(&devs[f], &results[f], 0);
+            }
+        });
+
+        if (round == 0) {
+            for (unsigned f = 0; f < kFrames; f++) {
+                bool corrupted = f % 8 == 7;
+                uint8_t status = corrupted ? VL53L7CX_STATUS_CORRUPTED_FRAME : VL53L7CX_STATUS_OK;
+                if (statuses[f] != reference_statuses[f] || statuses[f] != status
+                        || devs[f].streamcount != streamcounts[f]
+                        || std::memcmp(&results[f], &expected[f], sizeof(results[f])) != 0) {
+                    differ++;
+                }
+            }
+        }
+    }
+
+    double decodes = double(rounds) * kFrames;
+    std::printf("%ux%u  %4u bytes  %u differ  driver %7.1f ns", resolution == 16 ? 4 : 8,
+            resolution == 16 ? 4 : 8, size, differ, driver.ns / decodes);
+#ifdef HAVE_TSC
+    std::printf(" %6.0f cycles", double(driver.cycles) / decodes);
+#endif
+    std::printf("  swap+memcpy %7.1f ns", reference.ns / decodes);
+#ifdef HAVE_TSC
+    std::printf(" %6.0f cycles", double(reference.cycles) / decodes);
+#endif
+    std::printf("  x%.2f\n", driver.ns > 0 ? reference.ns / driver.ns : 0.0);
+    return differ;
+}
+
+} // namespace
+
+int main(int argc, char **argv)
+{
+    unsigned rounds = 2000;
+
+    for (int i = 1; i < argc; i++) {
+        if (std::strcmp(argv[i], "--rounds") == 0 && i + 1 < argc) {
+            rounds = static_cast<unsigned>(std::atoi(argv[++i]));
+        } else {
+            std::fprintf(stderr, "Usage: %s [--rounds n]\n", argv[0]);
+            return 2;
+        }
+    }
+    if (rounds == 0) {
+        rounds = 1;
+    }
+
+    unsigned differ = bench(VL53L7CX_RESOLUTION_4X4, rounds);
+    differ += bench(VL53L7CX_RESOLUTION_8X8, rounds);
+    return differ == 0 ? 0 : 1;
+}
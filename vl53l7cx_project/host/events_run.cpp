@@ -0,0 +1,268 @@
+/**
+ * VL53L7CX Event-Driven Acquisition on the Simulated Device
+ *
+ * Feeds an event source (vl53l7cx_events.h) from a simulated INT pin, which
+ * fires when the register-level simulator (vl53l7cx_simulator.hpp) has a new
+ * frame, and checks vl53l7cx_events_acquire():
+ *   interrupt  every frame read once, with the time of its interrupt, and no
+ *              other bus access (no data ready polls)
+ *   backlog    frames missed while the host was busy collapse into one read of
+ *              the latest frame
+ *   overflow   interrupts beyond the queue size are counted as dropped
+ *   no int     INT pin not wired: timeout error after the timeout, no bus
+ *              access while waiting
+ *   fallback   INT pin not wired, the loop of main_st_driver.c (acquire, then
+ *              one vl53l7cx_check_data_ready() on timeout): frames read with a
+ *              timeout of one frame period and of 100 ms, against polling
+ *              every 10 ms; the frame period must read more than 100 ms
+ *
+ * Usage: vl53l7cx_events [--freq hz] [--frames n] [--i2c-hz hz]
+ *
+ * The exit status is 1 if a check fails.
+ */
+
+#include <cinttypes>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include "vl53l7cx_simulator.hpp"
+#include "vl53l7cx_check.hpp"
+
+extern "C" {
+#include "vl53l7cx_events.h"
+}
+
+namespace {
+
+using vl53l7cx::check;
+using vl53l7cx::compare;
+
+/* INT pin of a simulated sensor: wait() lets the device clock run up to the
+ * next frame and pushes one event per frame ready, at its ready time */
+struct InterruptLine {
+    vl53l7cx::SimulatedDevice &device;
+    VL53L7CX_Configuration &dev;
+    VL53L7CX_EventSource source;
+    bool wired = true;
+    uint64_t next_frame = 0;
+
+    InterruptLine(vl53l7cx::SimulatedDevice &d, VL53L7CX_Configuration &c) : device(d), dev(c)
+    {
+        static const VL53L7CX_EventSourceOps ops = {wait, time_us};
+        vl53l7cx_event_source_init(&source, &ops, this);
+        // Frames already ready raised no interrupt for this source
+        while (device.frame_ready_us(next_frame) <= device.time_us()) {
+            next_frame++;
+        }
+    }
+
+    /* Interrupts of the frames ready by now */
+    bool fire()
+    {
+        bool fired = false;
+        uint64_t ready_us;
+        while ((ready_us = device.frame_ready_us(next_frame)) <= device.time_us()) {
+            if (wired) {
+                (void)vl53l7cx_event_push(&source.queue, VL53L7CX_EVENT_DATA_READY, ready_us);
+                fired = true;
+            }
+            next_frame++;
+        }
+        return fired;
+    }
+
+    static void wait(void *ctx, uint32_t timeout_us)
+    {
+        InterruptLine &line = *static_cast<InterruptLine *>(ctx);
+        if (line.fire()) {
+            return;
+        }
+        uint64_t now_us = line.device.time_us();
+        uint64_t until_us = now_us + timeout_us;
+        if (line.wired && line.device.frame_ready_us(line.next_frame) < until_us) {
+            until_us = line.device.frame_ready_us(line.next_frame);
+        }
+        (void)VL53L7CX_WaitUs(&line.dev.platform, static_cast<uint32_t>(until_us - now_us));
+        (void)line.fire();
+    }
+
+    static uint64_t time_us(void *ctx)
+    {
+        return static_cast<InterruptLine *>(ctx)->device.time_us();
+    }
+};
+
+struct Acquired {
+    unsigned frames = 0;
+    uint64_t timestamp_us = 0;
+    uint64_t latency_us = 0;
+};
+
+void on_frame(VL53L7CX_Configuration *p_dev, VL53L7CX_ResultsData *p_results,
+        uint64_t timestamp_us, void *p_user)
+{
+    (void)p_results;
+    Acquired &acquired = *static_cast<Acquired *>(p_user);
+    acquired.frames++;
+    acquired.timestamp_us = timestamp_us;
+    acquired.latency_us += VL53L7CX_GetTimeUs(&p_dev->platform) - timestamp_us;
+}
+
+/* Frames read in duration_us by the loop of main_st_driver.c, INT pin silent:
+ * acquire with timeout_ms, then one data ready poll. timeout_ms 0 is the
+ * polling loop (data ready poll, then a 10 ms wait). */
+unsigned fallback_frames(VL53L7CX_Configuration &dev, InterruptLine &line,
+        VL53L7CX_ResultsData &results, uint32_t timeout_ms, uint64_t duration_us)
+{
+    uint64_t end_us = line.device.time_us() + duration_us;
+    unsigned frames = 0;
+    uint8_t ready = 0;
+    while (line.device.time_us() < end_us) {
+        if (timeout_ms == 0) {
+            (void)vl53l7cx_check_data_ready(&dev, &ready);
+            if (ready) {
+                frames += vl53l7cx_get_ranging_data(&dev, &results) == VL53L7CX_STATUS_OK;
+            }
+            (void)VL53L7CX_WaitMs(&dev.platform, 10);
+            continue;
+        }
+        uint8_t status = vl53l7cx_events_acquire(&dev, &line.source, &results, timeout_ms,
+                NULL, NULL);
+        if (status == VL53L7CX_STATUS_TIMEOUT_ERROR) {
+            (void)vl53l7cx_check_data_ready(&dev, &ready);
+            if (ready) {
+                frames += vl53l7cx_get_ranging_data(&dev, &results) == VL53L7CX_STATUS_OK;
+            }
+        } else {
+            frames += status == VL53L7CX_STATUS_OK;
+        }
+    }
+    return frames;
+}
+
+} // namespace
+
+int main(int argc, char **argv)
+{
+    vl53l7cx::SimulatorOptions options;
+    unsigned frequency_hz = 15;
+    unsigned nb_frames = 30;
+
+    for (int i = 1; i < argc; i++) {
+        if (std::strcmp(argv[i], "--freq") == 0 && i + 1 < argc) {
+            frequency_hz = static_cast<unsigned>(std::atoi(argv[++i]));
+        } else if (std::strcmp(argv[i], "--frames") == 0 && i + 1 < argc) {
+            nb_frames = static_cast<unsigned>(std::atoi(argv[++i]));
+        } else if (std::strcmp(argv[i], "--i2c-hz") == 0 && i + 1 < argc) {
+            options.i2c_hz = static_cast<uint32_t>(std::atol(argv[++i]));
+        } else {
+            std::fprintf(stderr, "Usage: %s [--freq hz] [--frames n] [--i2c-hz hz]\n", argv[0]);
+            return 2;
+        }
+    }
+    if (frequency_hz == 0 || nb_frames == 0) {
+        std::fprintf(stderr, "The frequency and the number of frames must not be 0\n");
+        return 2;
+    }
+
+    vl53l7cx::SimulatedDevice device(options);
+    static VL53L7CX_Configuration dev;
+    static VL53L7CX_ResultsData results, expected;
+    dev.platform.address = VL53L7CX_DEFAULT_I2C_ADDRESS;
+    device.attach(dev);
+
+    uint8_t status = vl53l7cx_init(&dev);
+    status |= vl53l7cx_set_ranging_frequency_hz(&dev, static_cast<uint8_t>(frequency_hz));
+    status |= vl53l7cx_start_ranging(&dev);
+    if (status != VL53L7CX_STATUS_OK) {
+        std::printf("init FAILED (status %u)\n", status);
+        return 1;
+    }
+    const uint32_t period_us = 1000000 / frequency_hz;
+    const uint32_t period_ms = (period_us + 999) / 1000;
+    std::printf("%u Hz, I2C at %u kHz, frames of %" PRIu32 " bytes\n", frequency_hz,
+            options.i2c_hz / 1000, dev.data_read_size);
+    InterruptLine line(device, dev);
+    bool ok = true;
+
+    // Interrupt: one read per frame, stamped with the time of its interrupt
+    {
+        Acquired acquired;
+        unsigned late = 0, mismatches = 0;
+        uint64_t first_frame = line.next_frame;
+        device.reset_stats();
+        status = 0;
+        for (unsigned i = 0; i < nb_frames && status == VL53L7CX_STATUS_OK; i++) {
+            status = vl53l7cx_events_acquire(&dev, &line.source, &results, 2 * period_ms,
+                    on_frame, &acquired);
+            late += acquired.timestamp_us != device.frame_ready_us(first_frame + i) ? 1 : 0;
+            if (!device.last_frame(expected) || compare(expected, results, device.resolution())) {
+                mismatches++;
+            }
+        }
+        std::printf("  %u frames, %u late, %u mismatches, %" PRIu64 " bus reads, "
+                "latency %.1f us\n", acquired.frames, late, mismatches, device.stats().reads,
+                acquired.frames ? double(acquired.latency_us) / acquired.frames : 0.0);
+        ok &= check("interrupt", status == VL53L7CX_STATUS_OK && acquired.frames == nb_frames
+                && late == 0 && mismatches == 0 && device.stats().reads == nb_frames
+                && device.stats().overwritten == 0);
+    }
+
+    // Backlog: three frames ready while the host was busy, one read
+    {
+        Acquired acquired;
+        VL53L7CX_Event event;
+        (void)VL53L7CX_WaitUs(&dev.platform, 3 * period_us);
+        uint64_t latest_us = device.frame_ready_us(line.next_frame + 2);
+        status = vl53l7cx_events_acquire(&dev, &line.source, &results, 2 * period_ms,
+                on_frame, &acquired);
+        bool empty = vl53l7cx_event_pop(&line.source.queue, &event) != 0;
+        bool latest = device.last_frame(expected)
+                && compare(expected, results, device.resolution()) == 0;
+        ok &= check("backlog", status == VL53L7CX_STATUS_OK && acquired.frames == 1
+                && acquired.timestamp_us == latest_us && empty && latest);
+    }
+
+    // Overflow: the queue keeps VL53L7CX_EVENT_QUEUE_SIZE interrupts
+    {
+        const unsigned extra = 4;
+        uint32_t dropped = line.source.queue.dropped;
+        (void)VL53L7CX_WaitUs(&dev.platform, (VL53L7CX_EVENT_QUEUE_SIZE + extra) * period_us);
+        status = vl53l7cx_events_acquire(&dev, &line.source, &results, 2 * period_ms,
+                NULL, NULL);
+        dropped = line.source.queue.dropped - dropped;
+        bool latest = device.last_frame(expected)
+                && compare(expected, results, device.resolution()) == 0;
+        std::printf("  %" PRIu32 " interrupts dropped\n", dropped);
+        ok &= check("overflow", status == VL53L7CX_STATUS_OK && dropped == extra && latest);
+    }
+
+    // No INT: the wait times out without touching the bus
+    {
+        line.wired = false;
+        device.reset_stats();
+        uint64_t start_us = device.time_us();
+        status = vl53l7cx_events_acquire(&dev, &line.source, &results, period_ms, NULL, NULL);
+        uint64_t elapsed_us = device.time_us() - start_us;
+        std::printf("  timed out after %" PRIu64 " us\n", elapsed_us);
+        ok &= check("no int", status == VL53L7CX_STATUS_TIMEOUT_ERROR
+                && elapsed_us == period_ms * 1000ULL && device.stats().reads == 0
+                && device.stats().writes == 0);
+    }
+
+    // Fallback: frames read by the example loop with the INT pin silent
+    {
+        const uint64_t duration_us = uint64_t(nb_frames) * period_us;
+        unsigned at_period = fallback_frames(dev, line, results, period_ms, duration_us);
+        unsigned at_100ms = fallback_frames(dev, line, results, 100, duration_us);
+        unsigned polled = fallback_frames(dev, line, results, 0, duration_us);
+        std::printf("  %u frames produced: %u read with a %" PRIu32 " ms timeout, %u with "
+                "100 ms, %u polling every 10 ms\n", nb_frames, at_period, period_ms, at_100ms,
+                polled);
+        ok &= check("fallback", at_period > at_100ms);
+    }
+
+    status = vl53l7cx_stop_ranging(&dev);
+    ok &= status == VL53L7CX_STATUS_OK;
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,294 @@
+/**
+ * VL53L7CX Temporal Filter Benchmark
+ *
+ * Runs vl53l7cx_filter_apply() on frames of the synthetic scene of the
+ * simulator with Gaussian noise of range_sigma_mm, spikes, and targets
+ * reported invalid from time to time. For the median, exponential and Kalman
+ * filters it reports:
+ *   - the equivalence with a double precision reference of the same filter
+ *     (largest difference, frames filtered differently),
+ *   - the noise (RMS error against the scene) before and after the filter, on
+ *     every target and on targets whose distance did not change for a second
+ *     (moving objects add the delay of the filter to the error),
+ *   - the time per frame, and the cycles per frame (time stamp counter, x86).
+ *
+ * Usage: vl53l7cx_filter_bench [--frames n] [--resolution 4|8] [--seed n]
+ *        [--spikes %] [--invalid %]
+ *
+ * --spikes and --invalid give the share of distances moved by 300 mm and of
+ * targets reported invalid (1 % each by default).
+ *
+ * The exit status is 1 if a filter differs from its reference by more than
+ * 1 distance unit (0.25 mm in raw format).
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <vector>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define HAVE_TSC 1
+#endif
+
+#include "vl53l7cx_simulator.hpp"
+
+extern "C" {
+#include "vl53l7cx_filter.h"
+}
+
+namespace {
+
+#ifdef VL53L7CX_USE_RAW_FORMAT
+constexpr double kUnitsPerMm = 4.0;
+constexpr double kSigmaScale = 128.0;
+#else
+constexpr double kUnitsPerMm = 1.0;
+constexpr double kSigmaScale = 1.0;
+#endif
+
+constexpr size_t kPoints = 64 * VL53L7CX_NB_TARGET_PER_ZONE;
+
+bool valid_target(const VL53L7CX_ResultsData &results, size_t zone, size_t target)
+{
+    size_t i = zone * VL53L7CX_NB_TARGET_PER_ZONE + target;
+    return target < results.nb_target_detected[zone] && results.target_status[i] < 32
+            && ((VL53L7CX_FILTER_DEFAULT_STATUS_MASK >> results.target_status[i]) & 1U);
+}
+
+/* Target at the same distance in the scene for the last second (15 frames) */
+bool steady(const std::vector<VL53L7CX_ResultsData> &clean, unsigned f, size_t i)
+{
+    for (unsigned k = 1; k <= 15 && k <= f; k++) {
+        if (clean[f - k].distance_mm[i] != clean[f].distance_mm[i]) {
+            return false;
+        }
+    }
+    return f >= 15;
+}
+
+/* Double precision filters, with the parameters of vl53l7cx_filter_init() */
+class Reference {
+public:
+    explicit Reference(uint8_t mode) : mode_(mode) {}
+
+    void apply(VL53L7CX_ResultsData &results, uint8_t resolution)
+    {
+        for (size_t zone = 0; zone < resolution; zone++) {
+            for (size_t target = 0; target < VL53L7CX_NB_TARGET_PER_ZONE; target++) {
+                size_t i = zone * VL53L7CX_NB_TARGET_PER_ZONE + target;
+                State &s = state_[i];
+                if (!valid_target(results, zone, target)) {
+                    s.count = 0;
+                    continue;
+                }
+                double z = results.distance_mm[i];
+                double out = z;
+                if (mode_ == VL53L7CX_FILTER_NONE) {
+                    continue;
+                } else if (mode_ == VL53L7CX_FILTER_MEDIAN) {
+                    if (s.count == 0) {
+                        s.history.clear();
+                    }
+                    s.history.push_back(results.distance_mm[i]);
+                    if (s.history.size() > VL53L7CX_FILTER_DEFAULT_MEDIAN_SIZE) {
+                        s.history.erase(s.history.begin());
+                    }
+                    std::vector<int16_t> sorted(s.history);
+                    std::sort(sorted.begin(), sorted.end());
+                    out = sorted[sorted.size() / 2];
+                } else if (mode_ == VL53L7CX_FILTER_EXPONENTIAL) {
+                    s.x = s.count == 0 ? z
+                            : s.x + VL53L7CX_FILTER_DEFAULT_ALPHA_Q8 / 256.0 * (z - s.x);
+                    out = s.x;
+                } else {
+                    double sigma = results.range_sigma_mm[i] / kSigmaScale * kUnitsPerMm;
+                    double r = std::max(sigma * sigma, 1.0);
+                    double q = VL53L7CX_FILTER_DEFAULT_PROCESS_MM2 * kUnitsPerMm * kUnitsPerMm;
+                    double gate = VL53L7CX_FILTER_DEFAULT_GATE_SIGMA;
+                    if (s.count == 0) {
+                        s.x = z;
+                        s.p = r;
+                        s.rejected = false;
+                    } else if ((z - s.x) * (z - s.x) > gate * gate * (s.p + q + r)) {
+                        if (s.rejected) {
+                            s.x = z;
+                            s.p = r;
+                        }
+                        s.rejected = !s.rejected;
+                    } else {
+                        double p = s.p + q;
+                        double k = p / (p + r);
+                        s.x += k * (z - s.x);
+                        s.p = p * (1.0 - k);
+                        s.rejected = false;
+                    }
+                    out = s.x;
+                }
+                s.count++;
+                results.distance_mm[i] = static_cast<int16_t>(std::lround(out));
+            }
+        }
+    }
+
+private:
+    struct State {
+        double x = 0.0;
+        double p = 0.0;
+        unsigned count = 0;
+        bool rejected = false;
+        std::vector<int16_t> history;
+    };
+    uint8_t mode_;
+    State state_[kPoints];
+};
+
+/* Noisy frames of the scene, and the scene itself */
+void make_frames(unsigned nb_frames, uint8_t resolution, uint32_t seed, double spikes,
+        double invalid, std::vector<VL53L7CX_ResultsData> &noisy, std::vector<VL53L7CX_ResultsData> &clean)
+{
+    std::mt19937 rng(seed);
+    std::normal_distribution<double> gauss(0.0, 1.0);
+    std::uniform_real_distribution<double> uniform(0.0, 1.0);
+
+    noisy.resize(nb_frames);
+    clean.resize(nb_frames);
+    for (unsigned f = 0; f < nb_frames; f++) {
+        std::memset(&clean[f], 0, sizeof(clean[f]));
+        // 15 Hz
+        vl53l7cx::synthetic_scene(f, uint64_t(f) * 1000000ULL / 15, resolution, clean[f]);
+        noisy[f] = clean[f];
+        for (size_t i = 0; i < size_t(resolution) * VL53L7CX_NB_TARGET_PER_ZONE; i++) {
+            double sigma = noisy[f].range_sigma_mm[i] / kSigmaScale * kUnitsPerMm;
+            double d = noisy[f].distance_mm[i] + gauss(rng) * sigma;
+            double u = uniform(rng);
+            if (u < spikes) {
+                d += 300.0 * kUnitsPerMm;               // Spike
+            } else if (u < spikes + invalid) {
+                noisy[f].target_status[i] = 255;        // Invalid
+            }
+            noisy[f].distance_mm[i] = static_cast<int16_t>(std::lround(d));
+        }
+    }
+}
+
+const char *mode_name(uint8_t mode)
+{
+    switch (mode) {
+        case VL53L7CX_FILTER_MEDIAN: return "median";
+        case VL53L7CX_FILTER_EXPONENTIAL: return "exponential";
+        case VL53L7CX_FILTER_KALMAN: return "kalman";
+        default: return "none";
+    }
+}
+
+} // namespace
+
+int main(int argc, char **argv)
+{
+    unsigned nb_frames = 3000;
+    uint8_t resolution = VL53L7CX_RESOLUTION_8X8;
+    uint32_t seed = 1;
+    double spikes = 0.01, invalid = 0.01;
+
+    for (int i = 1; i < argc; i++) {
+        if (std::strcmp(argv[i], "--frames") == 0 && i + 1 < argc) {
+            nb_frames = static_cast<unsigned>(std::atoi(argv[++i]));
+        } else if (std::strcmp(argv[i], "--resolution") == 0 && i + 1 < argc) {
+            resolution = std::atoi(argv[++i]) == 4 ? VL53L7CX_RESOLUTION_4X4
+                    : VL53L7CX_RESOLUTION_8X8;
+        } else if (std::strcmp(argv[i], "--seed") == 0 && i + 1 < argc) {
+            seed = static_cast<uint32_t>(std::atol(argv[++i]));
+        } else if (std::strcmp(argv[i], "--spikes") == 0 && i + 1 < argc) {
+            spikes = std::atof(argv[++i]) / 100.0;
+        } else if (std::strcmp(argv[i], "--invalid") == 0 && i + 1 < argc) {
+            invalid = std::atof(argv[++i]) / 100.0;
+        } else {
+            std::fprintf(stderr, "Usage: %s [--frames n] [--resolution 4|8] [--seed n] "
+                    "[--spikes %%] [--invalid %%]\n", argv[0]);
+            return 2;
+        }
+    }
+    if (nb_frames == 0) {
+        std::fprintf(stderr, "--frames must be positive\n");
+        return 2;
+    }
+
+    std::vector<VL53L7CX_ResultsData> noisy, clean;
+    make_frames(nb_frames, resolution, seed, spikes, invalid, noisy, clean);
+    std::printf("%u frames %ux%u, %u target(s) per zone\n", nb_frames,
+            resolution == VL53L7CX_RESOLUTION_4X4 ? 4 : 8,
+            resolution == VL53L7CX_RESOLUTION_4X4 ? 4 : 8,
+            unsigned(VL53L7CX_NB_TARGET_PER_ZONE));
+
+    bool failed = false;
+    for (uint8_t mode : {VL53L7CX_FILTER_NONE, VL53L7CX_FILTER_MEDIAN,
+            VL53L7CX_FILTER_EXPONENTIAL, VL53L7CX_FILTER_KALMAN}) {
+        static VL53L7CX_Filter filter;
+        vl53l7cx_filter_init(&filter, mode);
+        Reference reference(mode);
+
+        // Equivalence and noise
+        int max_diff = 0;
+        unsigned frames_diff = 0;
+        double error2 = 0.0, steady2 = 0.0;
+        unsigned long samples = 0, steady_samples = 0;
+        for (unsigned f = 0; f < nb_frames; f++) {
+            VL53L7CX_ResultsData fixed = noisy[f], ref = noisy[f];
+            (void)vl53l7cx_filter_apply(&filter, &fixed, resolution);
+            reference.apply(ref, resolution);
+            int diff = 0;
+            for (size_t zone = 0; zone < resolution; zone++) {
+                for (size_t target = 0; target < VL53L7CX_NB_TARGET_PER_ZONE; target++) {
+                    size_t i = zone * VL53L7CX_NB_TARGET_PER_ZONE + target;
+                    diff = std::max(diff, std::abs(fixed.distance_mm[i] - ref.distance_mm[i]));
+                    // Noise after the first second, on valid targets
+                    if (f >= 15 && valid_target(fixed, zone, target)) {
+                        double e = (fixed.distance_mm[i] - clean[f].distance_mm[i]) / kUnitsPerMm;
+                        error2 += e * e;
+                        samples++;
+                        if (steady(clean, f, i)) {
+                            steady2 += e * e;
+                            steady_samples++;
+                        }
+                    }
+                }
+            }
+            max_diff = std::max(max_diff, diff);
+            frames_diff += diff > 1 ? 1 : 0;
+        }
+
+        // Time per frame, on copies of the noisy frames
+        vl53l7cx_filter_init(&filter, mode);
+        std::vector<VL53L7CX_ResultsData> work(noisy);
+        auto start = std::chrono::steady_clock::now();
+#ifdef HAVE_TSC
+        uint64_t tsc = __rdtsc();
+#endif
+        for (VL53L7CX_ResultsData &frame : work) {
+            (void)vl53l7cx_filter_apply(&filter, &frame, resolution);
+        }
+#ifdef HAVE_TSC
+        tsc = __rdtsc() - tsc;
+#endif
+        double seconds = std::chrono::duration<double>(
+                std::chrono::steady_clock::now() - start).count();
+
+        bool mode_failed = max_diff > 1;
+        std::printf("%-12s rms %6.2f mm (steady %5.2f mm)  reference: max diff %d, %u frames"
+                "  %7.1f ns/frame", mode_name(mode), samples ? std::sqrt(error2 / samples) : 0.0,
+                steady_samples ? std::sqrt(steady2 / steady_samples) : 0.0, max_diff,
+                frames_diff, seconds * 1e9 / nb_frames);
+#ifdef HAVE_TSC
+        std::printf("  %7.0f cycles/frame", double(tsc) / nb_frames);
+#endif
+        std::printf("  %u restarts%s\n", filter.restarts, mode_failed ? "  FAILED" : "");
+        failed |= mode_failed;
+    }
+    return failed ? 1 : 0;
+}
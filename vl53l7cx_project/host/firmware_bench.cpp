@@ -0,0 +1,81 @@
+/**
+ * VL53L7CX Compressed Firmware Benchmark
+ *
+ * Runs vl53l7cx_init() on the register-level simulator (vl53l7cx_simulator.hpp)
+ * with the driver built with VL53L7CX_COMPRESSED_FIRMWARE, so the firmware is
+ * decoded from the generated vl53l7cx_firmware_lz.h during the download. After
+ * each init the firmware RAM of the device is compared byte for byte with
+ * VL53L7CX_FIRMWARE, and the host time gives the decode and download
+ * throughput (the simulated bus only copies the bytes).
+ *
+ * Usage: vl53l7cx_firmware_bench [--runs n] [--i2c-hz hz]
+ *
+ * The exit status is 1 if an init fails or the firmware RAM differs.
+ */
+
+#include <chrono>
+#include <cinttypes>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include "vl53l7cx_simulator.hpp"
+
+extern "C" {
+#include "vl53l7cx_buffers.h"
+}
+
+int main(int argc, char **argv)
+{
+    unsigned runs = 20;
+    vl53l7cx::SimulatorOptions options;
+    options.i2c_hz = 1000000;
+
+    for (int i = 1; i < argc; i++) {
+        if (std::strcmp(argv[i], "--runs") == 0 && i + 1 < argc) {
+            runs = static_cast<unsigned>(std::atoi(argv[++i]));
+        } else if (std::strcmp(argv[i], "--i2c-hz") == 0 && i + 1 < argc) {
+            options.i2c_hz = static_cast<uint32_t>(std::atol(argv[++i]));
+        } else {
+            std::fprintf(stderr, "Usage: %s [--runs n] [--i2c-hz hz]\n", argv[0]);
+            return 2;
+        }
+    }
+    if (runs == 0) {
+        runs = 1;
+    }
+
+    const size_t size = sizeof(VL53L7CX_FIRMWARE);
+    unsigned failures = 0, mismatches = 0;
+    double host_s = 0.0;
+    uint64_t device_us = 0;
+    for (unsigned run = 0; run < runs; run++) {
+        // Cold init on a new device each time: every run downloads the firmware
+        vl53l7cx::SimulatedDevice device(options);
+        static VL53L7CX_Configuration dev;
+        std::memset(&dev, 0, sizeof(dev));
+        dev.platform.address = VL53L7CX_DEFAULT_I2C_ADDRESS;
+        device.attach(dev);
+
+        auto start = std::chrono::steady_clock::now();
+        uint8_t status = vl53l7cx_init(&dev);
+        host_s += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        device_us += device.time_us();
+
+        const std::vector<uint8_t> &firmware = device.firmware();
+        if (status != VL53L7CX_STATUS_OK || !device.running()) {
+            failures++;
+        } else if (device.stats().firmware_bytes != size
+                || std::memcmp(firmware.data(), VL53L7CX_FIRMWARE, size) != 0) {
+            mismatches++;
+        }
+    }
+
+    double init_us = host_s * 1e6 / runs;
+    std::printf("%u cold inits, %zu bytes of firmware: %u failed, %u differ\n", runs, size,
+            failures, mismatches);
+    std::printf("host %.1f us per init (%.1f MB/s of firmware decoded and written), "
+            "device %.1f ms at %u kHz\n", init_us, init_us > 0 ? size / init_us : 0.0,
+            device_us / 1e3 / runs, options.i2c_hz / 1000);
+
+    return (failures == 0 && mismatches == 0) ? 0 : 1;
+}
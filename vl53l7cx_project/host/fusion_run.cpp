@@ -0,0 +1,451 @@
+/**
+ * VL53L7CX Multi-Sensor Fusion Run
+ *
+ * Runs the fusion (vl53l7cx_fusion.h) with its two sides on two threads, as
+ * on the two RP2350 cores: the acquisition thread reads the frames of every
+ * sensor through the driver, timestamps them when they are ready and pushes
+ * them into the rings; the main thread drains the rings every --period-us
+ * and builds fused frames at the newest time every sensor has reached, once
+ * with the nearest frames and once with interpolated ones.
+ *
+ * Sensors are either simulated (vl53l7cx_simulator.hpp): --sensors devices
+ * at 15 Hz in 4x4, started at different times, each on its own clock (offset
+ * from the common clock given to the fusion) and seeing a surface moving by
+ * +-300 mm in 2 s; or the sensors of a recording (vl53l7cx_replay.hpp),
+ * timestamped with their recorded board times.
+ *
+ * It reports the fusion time, the skew of the sensors and the offsets of the
+ * frames used, the frames missed (driver) and dropped (rings full), and for
+ * simulated sensors the distance error of both modes against the surface.
+ *
+ * Usage: vl53l7cx_fusion [<recording>] [--sensors n] [--seconds s] [--speed x]
+ *        [--period-us us]
+ *   --sensors    simulated sensors, 1 to 4 (default 4)
+ *   --seconds    device time simulated (default 5)
+ *   --speed      device clock / wall clock (default 2)
+ *   --period-us  fusion period (default 5000)
+ *
+ * The exit status is 1 if no frame was fused or, for simulated sensors, if
+ * interpolation does not lower the error of the nearest frames.
+ */
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cinttypes>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include "vl53l7cx_replay.hpp"
+#include "vl53l7cx_simulator.hpp"
+
+extern "C" {
+#include "vl53l7cx_fusion.h"
+}
+
+namespace {
+
+constexpr uint8_t kFrequencyHz = 15;
+constexpr uint32_t kPollUs = 1000;
+constexpr double kPi = 3.14159265358979323846;
+
+#ifdef VL53L7CX_USE_RAW_FORMAT
+constexpr double kUnitsPerMm = 4.0;
+#else
+constexpr double kUnitsPerMm = 1.0;
+#endif
+
+/* Clock of each simulated sensor: device time + offset = common time */
+constexpr int32_t kClockOffsetUs[4] = {0, 3300, -7100, 12900};
+
+struct Pose {
+    int16_t x_mm, y_mm, yaw_deg;
+};
+
+constexpr Pose kPoses[4] = {{150, 0, 0}, {0, 150, 90}, {-150, 0, 180}, {0, -150, -90}};
+
+/* Surface seen by simulated sensor s at common time time_us, mm */
+double surface_mm(unsigned s, double time_us)
+{
+    return 1000.0 + 200.0 * s + 300.0 * std::sin(2.0 * kPi * time_us / 2e6 + 1.3 * s);
+}
+
+struct Error {
+    double sum = 0.0;
+    uint64_t points = 0;
+
+    double mean() const { return points ? sum / points : 0.0; }
+};
+
+/* Sensors of the run, read by the acquisition thread only */
+class Sensors {
+public:
+    virtual ~Sensors() = default;
+
+    /* Read the next frame ready into the fusion; false if all sensors ended */
+    virtual bool acquire(VL53L7CX_Fusion &fusion, const std::atomic<bool> &stop) = 0;
+};
+
+class SimulatedSensors : public Sensors {
+public:
+    SimulatedSensors(unsigned nb_sensors, double seconds, double speed)
+        : end_us_(static_cast<uint64_t>(seconds * 1e6)), speed_(speed)
+    {
+        vl53l7cx::SimulatorOptions options;
+        options.i2c_hz = 1000000;
+        for (unsigned s = 0; s < nb_sensors; s++) {
+            options.nvm_seed = s + 1;
+            devices_.emplace_back(new vl53l7cx::SimulatedDevice(options,
+                    [s](uint64_t, uint64_t time_us, uint8_t resolution,
+                            VL53L7CX_ResultsData &results) {
+                        double mm = surface_mm(s, double(time_us) + kClockOffsetUs[s]);
+                        for (unsigned zone = 0; zone < resolution; zone++) {
+                            size_t i = size_t(zone) * VL53L7CX_NB_TARGET_PER_ZONE;
+                            results.nb_target_detected[zone] = 1;
+                            results.target_status[i] = 5;
+                            results.distance_mm[i] = static_cast<int16_t>(
+                                    std::lround(mm * kUnitsPerMm));
+                        }
+                    }));
+        }
+        devs_.reset(new VL53L7CX_Configuration[nb_sensors]());
+    }
+
+    /* Cold init and start of every sensor, each one later than the previous */
+    bool start()
+    {
+        uint8_t status = 0;
+        for (size_t s = 0; s < devices_.size(); s++) {
+            VL53L7CX_Configuration &dev = devs_[s];
+            dev.platform.address = VL53L7CX_DEFAULT_I2C_ADDRESS;
+            devices_[s]->attach(dev);
+            status |= vl53l7cx_init(&dev);
+            status |= vl53l7cx_set_resolution(&dev, VL53L7CX_RESOLUTION_4X4);
+            status |= vl53l7cx_set_ranging_frequency_hz(&dev, kFrequencyHz);
+            (void)VL53L7CX_WaitUs(&dev.platform, static_cast<uint32_t>(s) * 17000U);
+            status |= vl53l7cx_start_ranging(&dev);
+        }
+        uint64_t base = UINT64_MAX;
+        for (const auto &device : devices_) {
+            base = std::min(base, device->time_us());
+        }
+        base_us_ = base;
+        wall_ = std::chrono::steady_clock::now();
+        return status == VL53L7CX_STATUS_OK;
+    }
+
+    bool acquire(VL53L7CX_Fusion &fusion, const std::atomic<bool> &stop) override
+    {
+        while (!stop.load(std::memory_order_relaxed)) {
+            // Sensor behind the others, paced to the wall clock
+            size_t s = 0;
+            for (size_t k = 1; k < devices_.size(); k++) {
+                s = devices_[k]->time_us() < devices_[s]->time_us() ? k : s;
+            }
+            uint64_t elapsed = devices_[s]->time_us() - base_us_;
+            if (elapsed >= end_us_) {
+                return false;
+            }
+            double wall_us = std::chrono::duration<double, std::micro>(
+                    std::chrono::steady_clock::now() - wall_).count() * speed_;
+            if (double(elapsed) > wall_us) {
+                std::this_thread::sleep_for(std::chrono::microseconds(200));
+                continue;
+            }
+
+            VL53L7CX_Configuration &dev = devs_[s];
+            uint8_t ready = 0;
+            uint8_t status = vl53l7cx_check_data_ready(&dev, &ready);
+            if (status == VL53L7CX_STATUS_OK && !ready) {
+                (void)VL53L7CX_WaitUs(&dev.platform, kPollUs);
+                continue;
+            }
+
+            // Timestamp at data ready, before the frame is read
+            uint64_t timestamp_us = devices_[s]->time_us();
+            VL53L7CX_ResultsSlot *p_slot = vl53l7cx_fusion_begin_write(&fusion,
+                    static_cast<uint8_t>(s));
+            if (p_slot == nullptr) {
+                static VL53L7CX_ResultsData dropped;
+                (void)vl53l7cx_get_ranging_data(&dev, &dropped);
+                return true;
+            }
+            if (status == VL53L7CX_STATUS_OK) {
+                status = vl53l7cx_get_ranging_data(&dev, &p_slot->results);
+            }
+            vl53l7cx_fusion_end_write(&fusion, static_cast<uint8_t>(s), timestamp_us,
+                    dev.streamcount, status);
+            return true;
+        }
+        return false;
+    }
+
+    size_t size() const { return devices_.size(); }
+
+private:
+    std::vector<std::unique_ptr<vl53l7cx::SimulatedDevice>> devices_;
+    std::unique_ptr<VL53L7CX_Configuration[]> devs_;
+    uint64_t end_us_;
+    double speed_;
+    uint64_t base_us_ = 0;
+    std::chrono::steady_clock::time_point wall_;
+};
+
+class ReplayedSensors : public Sensors {
+public:
+    bool open(const vl53l7cx::Recording &recording, double speed)
+    {
+        vl53l7cx::ReplayOptions options;
+        options.speed = speed;
+        for (const vl53l7cx::RecordingSensor &sensor : recording.sensors()) {
+            if (devices_.size() == VL53L7CX_FUSION_MAX_SENSORS) {
+                break;
+            }
+            std::unique_ptr<vl53l7cx::ReplayDevice> device(new vl53l7cx::ReplayDevice);
+            if (device->open(recording, sensor.sensor, options)) {
+                devices_.push_back(std::move(device));
+                ids_.push_back(sensor.sensor);
+            }
+        }
+        devs_.reset(new VL53L7CX_Configuration[devices_.size()]());
+        for (size_t s = 0; s < devices_.size(); s++) {
+            devices_[s]->attach(devs_[s]);
+        }
+        return !devices_.empty();
+    }
+
+    bool acquire(VL53L7CX_Fusion &fusion, const std::atomic<bool> &stop) override
+    {
+        while (!stop.load(std::memory_order_relaxed)) {
+            bool finished = true;
+            for (size_t k = 0; k < devices_.size(); k++) {
+                size_t s = (next_ + k) % devices_.size();
+                if (devices_[s]->finished()) {
+                    continue;
+                }
+                finished = false;
+
+                VL53L7CX_Configuration &dev = devs_[s];
+                uint8_t ready = 0;
+                uint8_t status = vl53l7cx_check_data_ready(&dev, &ready);
+                if (status == VL53L7CX_STATUS_OK && !ready) {
+                    continue;
+                }
+                next_ = s + 1;
+                VL53L7CX_ResultsSlot *p_slot = vl53l7cx_fusion_begin_write(&fusion,
+                        static_cast<uint8_t>(s));
+                if (p_slot == nullptr) {
+                    static VL53L7CX_ResultsData dropped;
+                    (void)vl53l7cx_get_ranging_data(&dev, &dropped);
+                    return true;
+                }
+                if (status == VL53L7CX_STATUS_OK) {
+                    status = vl53l7cx_get_ranging_data(&dev, &p_slot->results);
+                }
+                // Board time of the record: the acquisition time of the frame
+                vl53l7cx::FrameView frame;
+                uint64_t timestamp_us = devices_[s]->last_frame(frame) ? frame.timestamp_us() : 0;
+                vl53l7cx_fusion_end_write(&fusion, static_cast<uint8_t>(s), timestamp_us,
+                        dev.streamcount, status);
+                return true;
+            }
+            if (finished) {
+                return false;
+            }
+            std::this_thread::sleep_for(std::chrono::microseconds(kPollUs));
+        }
+        return false;
+    }
+
+    size_t size() const { return devices_.size(); }
+    uint8_t id(size_t s) const { return ids_[s]; }
+
+private:
+    std::vector<std::unique_ptr<vl53l7cx::ReplayDevice>> devices_;
+    std::vector<uint8_t> ids_;
+    std::unique_ptr<VL53L7CX_Configuration[]> devs_;
+    size_t next_ = 0;
+};
+
+} // namespace
+
+int main(int argc, char **argv)
+{
+    const char *path = nullptr;
+    unsigned nb_sensors = 4;
+    double seconds = 5.0;
+    double speed = 2.0;
+    unsigned period_us = 5000;
+
+    for (int i = 1; i < argc; i++) {
+        if (std::strcmp(argv[i], "--sensors") == 0 && i + 1 < argc) {
+            nb_sensors = static_cast<unsigned>(std::atoi(argv[++i]));
+        } else if (std::strcmp(argv[i], "--seconds") == 0 && i + 1 < argc) {
+            seconds = std::atof(argv[++i]);
+        } else if (std::strcmp(argv[i], "--speed") == 0 && i + 1 < argc) {
+            speed = std::atof(argv[++i]);
+        } else if (std::strcmp(argv[i], "--period-us") == 0 && i + 1 < argc) {
+            period_us = static_cast<unsigned>(std::atoi(argv[++i]));
+        } else if (argv[i][0] != '-' && !path) {
+            path = argv[i];
+        } else {
+            path = nullptr;
+            nb_sensors = 0;
+            break;
+        }
+    }
+    if (nb_sensors == 0 || nb_sensors > VL53L7CX_FUSION_MAX_SENSORS || speed <= 0.0
+            || period_us == 0) {
+        std::fprintf(stderr, "Usage: %s [<recording>] [--sensors n] [--seconds s] [--speed x] "
+                "[--period-us us]\n", argv[0]);
+        return 2;
+    }
+
+    static VL53L7CX_Fusion fusion;
+    static VL53L7CX_FusedFrame frame;
+    vl53l7cx::Recording recording;
+    std::unique_ptr<SimulatedSensors> simulated;
+    std::unique_ptr<ReplayedSensors> replayed;
+    Sensors *sensors;
+    uint8_t status;
+
+    if (path) {
+        if (recording.open(path) != vl53l7cx::Recording::Status::kOk) {
+            std::fprintf(stderr, "%s: cannot open recording\n", path);
+            return 1;
+        }
+        replayed.reset(new ReplayedSensors);
+        if (!replayed->open(recording, speed)) {
+            std::fprintf(stderr, "%s: no sensor fits this build (%u targets per zone)\n", path,
+                    VL53L7CX_NB_TARGET_PER_ZONE);
+            return 1;
+        }
+        nb_sensors = static_cast<unsigned>(replayed->size());
+        status = vl53l7cx_fusion_init(&fusion, static_cast<uint8_t>(nb_sensors),
+                VL53L7CX_FUSION_INTERPOLATE);
+        for (unsigned s = 0; s < nb_sensors; s++) {
+            status |= vl53l7cx_fusion_set_sensor(&fusion, static_cast<uint8_t>(s),
+                    recording.resolution(), kPoses[s].x_mm, kPoses[s].y_mm, 100,
+                    kPoses[s].yaw_deg, 0, 0);
+        }
+        std::printf("%s: %u sensors, %ux%u, speed %.1fx\n", path, nb_sensors,
+                recording.resolution() == VL53L7CX_RESOLUTION_4X4 ? 4 : 8,
+                recording.resolution() == VL53L7CX_RESOLUTION_4X4 ? 4 : 8, speed);
+        sensors = replayed.get();
+    } else {
+        simulated.reset(new SimulatedSensors(nb_sensors, seconds, speed));
+        status = vl53l7cx_fusion_init(&fusion, static_cast<uint8_t>(nb_sensors),
+                VL53L7CX_FUSION_INTERPOLATE);
+        for (unsigned s = 0; s < nb_sensors; s++) {
+            status |= vl53l7cx_fusion_set_sensor(&fusion, static_cast<uint8_t>(s),
+                    VL53L7CX_RESOLUTION_4X4, kPoses[s].x_mm, kPoses[s].y_mm, 100,
+                    kPoses[s].yaw_deg, 0, 0);
+            // Timestamps are taken at the first poll after data ready
+            vl53l7cx_fusion_set_timing(&fusion, static_cast<uint8_t>(s), kClockOffsetUs[s],
+                    kPollUs / 2);
+        }
+        if (status == 0 && !simulated->start()) {
+            std::fprintf(stderr, "sensor start failed\n");
+            return 1;
+        }
+        std::printf("%u simulated sensors, 4x4 at %u Hz, %.1f s at %.1fx\n", nb_sensors,
+                kFrequencyHz, seconds, speed);
+        sensors = simulated.get();
+    }
+    if (status != 0) {
+        std::fprintf(stderr, "fusion setup failed\n");
+        return 1;
+    }
+
+    std::atomic<bool> stop(false), done(false);
+    std::thread acquisition([&] {
+        while (sensors->acquire(fusion, stop)) {
+        }
+        done.store(true, std::memory_order_release);
+    });
+
+    // Fusion side
+    Error error[2];
+    uint64_t fused = 0, skew_sum = 0, offset_sum = 0, offsets = 0, interpolated = 0;
+    uint32_t skew_max = 0;
+    int32_t offset_max = 0;
+    double fuse_s = 0.0;
+    for (;;) {
+        bool last = done.load(std::memory_order_acquire);
+        if (vl53l7cx_fusion_collect(&fusion) != 0) {
+            for (uint8_t mode : {VL53L7CX_FUSION_NEAREST, VL53L7CX_FUSION_INTERPOLATE}) {
+                vl53l7cx_fusion_set_mode(&fusion, mode);
+                auto start = std::chrono::steady_clock::now();
+                status = vl53l7cx_fusion_fuse(&fusion, VL53L7CX_FUSION_TIME_LATEST, &frame);
+                fuse_s += std::chrono::duration<double>(std::chrono::steady_clock::now()
+                        - start).count();
+                if (status != 0) {
+                    break;
+                }
+                for (unsigned s = 0; simulated && s < nb_sensors; s++) {
+                    if (frame.used[s] == VL53L7CX_FUSION_UNUSED) {
+                        continue;
+                    }
+                    double truth = surface_mm(s, double(frame.time_us));
+                    for (unsigned zone = 0; zone < 16; zone++) {
+                        unsigned point = s * 64 + zone;
+                        if ((frame.valid_mask[point >> 5] >> (point & 31)) & 1) {
+                            error[mode].sum += std::fabs(frame.distance_mm[point] - truth);
+                            error[mode].points++;
+                        }
+                    }
+                }
+                if (mode == VL53L7CX_FUSION_NEAREST) {
+                    continue;
+                }
+                fused++;
+                skew_sum += frame.skew_us;
+                skew_max = std::max(skew_max, frame.skew_us);
+                for (unsigned s = 0; s < nb_sensors; s++) {
+                    if (frame.used[s] != VL53L7CX_FUSION_UNUSED) {
+                        offset_sum += static_cast<uint64_t>(std::abs(frame.offset_us[s]));
+                        offset_max = std::max(offset_max, std::abs(frame.offset_us[s]));
+                        offsets++;
+                    }
+                    interpolated += frame.used[s] == VL53L7CX_FUSION_USED_INTERPOLATED;
+                }
+            }
+        }
+        if (last) {
+            break;
+        }
+        std::this_thread::sleep_for(std::chrono::microseconds(period_us));
+    }
+    stop.store(true);
+    acquisition.join();
+
+    std::printf("%" PRIu64 " fused frames, %.2f us per fuse, skew mean %.0f us max %" PRIu32
+            " us, |offset| mean %.0f us max %" PRId32 " us, %.1f %% interpolated\n", fused,
+            fused ? fuse_s * 1e6 / (2 * fused) : 0.0, fused ? double(skew_sum) / fused : 0.0,
+            skew_max, offsets ? double(offset_sum) / offsets : 0.0, offset_max,
+            offsets ? 100.0 * interpolated / offsets : 0.0);
+    for (unsigned s = 0; s < nb_sensors; s++) {
+        const VL53L7CX_FusionSensor &sensor = fusion.sensor[s];
+        VL53L7CX_ResultsRingStats stats;
+        vl53l7cx_results_ring_get_stats(&fusion.sensor[s].ring, &stats);
+        std::printf("sensor %u: %" PRIu32 " frames, %" PRIu32 " missed, %" PRIu32
+                " dropped, %" PRIu32 " errors\n", replayed ? replayed->id(s) : s, sensor.frames,
+                sensor.missed, stats.overruns, sensor.errors);
+    }
+
+    bool failed = fused == 0;
+    if (simulated) {
+        bool better = error[VL53L7CX_FUSION_INTERPOLATE].mean()
+                < error[VL53L7CX_FUSION_NEAREST].mean();
+        std::printf("distance error: nearest %.2f mm, interpolated %.2f mm%s\n",
+                error[VL53L7CX_FUSION_NEAREST].mean(), error[VL53L7CX_FUSION_INTERPOLATE].mean(),
+                better ? "" : "  FAILED");
+        failed |= !better;
+    }
+    return failed ? 1 : 0;
+}
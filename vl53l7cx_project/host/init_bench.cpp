@@ -0,0 +1,176 @@
+/**
+ * VL53L7CX Init Copy and Stack Benchmark
+ *
+ * Runs a cold vl53l7cx_init() on the register-level simulator
+ * (vl53l7cx_simulator.hpp) behind a bus that sees every write of the driver,
+ * as handed over by VL53L7CX_WrMulti() / VL53L7CX_WrGather(), and reports:
+ *   - the bytes written, and for the firmware pages (0x09 to 0x0b) the bytes
+ *     read in place from VL53L7CX_FIRMWARE against the bytes copied first;
+ *   - the peak stack of the init, on a thread whose stack is painted with a
+ *     pattern beforehand, less the stack of an empty thread.
+ *
+ * Usage: vl53l7cx_init_bench [--stack-limit bytes]
+ *
+ * The exit status is 1 if the init fails, a firmware byte was copied, or the
+ * peak stack is over the limit (8192 bytes by default, a quarter of the 0x8000
+ * byte chunks the firmware is written in).
+ */
+
+#include <pthread.h>
+#include <cinttypes>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+#include "vl53l7cx_simulator.hpp"
+
+/* The image of the driver (src/vl53l7cx_api.c), not a copy of
+ * vl53l7cx_buffers.h: in C++ its const arrays would be private to this file */
+extern "C" const uint8_t VL53L7CX_FIRMWARE[];
+
+namespace {
+
+/* Firmware download: pages 0x09 and 0x0a, and 0x5000 bytes of page 0x0b */
+const uint32_t kFirmwareSize = 0x15000;
+
+/* Bus between the driver and the device: counts the writes and where their
+ * data comes from */
+struct CountingBus {
+    const VL53L7CX_HostBusOps *p_ops = nullptr;
+    void *p_ctx = nullptr;
+    uint8_t page = 0;
+    uint64_t writes = 0;
+    uint64_t bytes = 0;
+    uint64_t firmware_bytes = 0;    // Written into the firmware pages
+    uint64_t in_place = 0;          // Of which passed from VL53L7CX_FIRMWARE
+
+    static uint8_t read(void *ctx, uint16_t address, uint8_t *values, uint32_t size)
+    {
+        CountingBus &bus = *static_cast<CountingBus *>(ctx);
+        return bus.p_ops->read(bus.p_ctx, address, values, size);
+    }
+
+    static uint8_t write(void *ctx, uint16_t address, const uint8_t *values, uint32_t size)
+    {
+        CountingBus &bus = *static_cast<CountingBus *>(ctx);
+        bus.writes++;
+        bus.bytes += size;
+        if (address == 0x7fff && size == 1) {
+            bus.page = values[0];
+        } else if (bus.page >= 0x09 && bus.page <= 0x0b) {
+            const uint8_t *begin = VL53L7CX_FIRMWARE;
+            const uint8_t *end = begin + kFirmwareSize;
+            bus.firmware_bytes += size;
+            if (values >= begin && values + size <= end) {
+                bus.in_place += size;
+            }
+        }
+        return bus.p_ops->write(bus.p_ctx, address, values, size);
+    }
+
+    static uint64_t time_us(void *ctx)
+    {
+        CountingBus &bus = *static_cast<CountingBus *>(ctx);
+        return bus.p_ops->time_us(bus.p_ctx);
+    }
+
+    static void wait_us(void *ctx, uint32_t time_us)
+    {
+        CountingBus &bus = *static_cast<CountingBus *>(ctx);
+        bus.p_ops->wait_us(bus.p_ctx, time_us);
+    }
+};
+
+struct InitRun {
+    VL53L7CX_Configuration *p_dev;  // NULL: measure the thread alone
+    uint8_t status;
+};
+
+void *run_init(void *p_arg)
+{
+    InitRun &run = *static_cast<InitRun *>(p_arg);
+    if (run.p_dev) {
+        run.status = vl53l7cx_init(run.p_dev);
+    }
+    return nullptr;
+}
+
+/* Stack used by run_init() on a thread: the stack is painted with a pattern,
+ * the bytes overwritten give the peak (thread descriptor included) */
+bool peak_stack(InitRun &run, size_t &peak)
+{
+    const size_t stack_size = 1 << 20;
+    const uint8_t kPattern = 0xcd;
+    std::vector<uint8_t> stack(stack_size, kPattern);
+    pthread_attr_t attr;
+    pthread_t thread;
+
+    pthread_attr_init(&attr);
+    bool started = pthread_attr_setstack(&attr, stack.data(), stack_size) == 0
+            && pthread_create(&thread, &attr, run_init, &run) == 0;
+    if (started) {
+        pthread_join(thread, nullptr);
+    }
+    pthread_attr_destroy(&attr);
+
+    // The stack grows down from the end of the buffer
+    size_t untouched = 0;
+    while (untouched < stack_size && stack[untouched] == kPattern) {
+        untouched++;
+    }
+    peak = stack_size - untouched;
+    return started;
+}
+
+} // namespace
+
+int main(int argc, char **argv)
+{
+    size_t stack_limit = 8192;
+
+    for (int i = 1; i < argc; i++) {
+        if (std::strcmp(argv[i], "--stack-limit") == 0 && i + 1 < argc) {
+            stack_limit = static_cast<size_t>(std::atol(argv[++i]));
+        } else {
+            std::fprintf(stderr, "Usage: %s [--stack-limit bytes]\n", argv[0]);
+            return 2;
+        }
+    }
+
+    vl53l7cx::SimulatedDevice device;
+    static VL53L7CX_Configuration dev;
+    dev.platform.address = VL53L7CX_DEFAULT_I2C_ADDRESS;
+    device.attach(dev);
+
+    static const VL53L7CX_HostBusOps counting_ops = {
+        CountingBus::read, CountingBus::write, CountingBus::time_us, CountingBus::wait_us
+    };
+    CountingBus bus;
+    bus.p_ops = dev.platform.p_bus;
+    bus.p_ctx = dev.platform.p_bus_ctx;
+    dev.platform.p_bus = &counting_ops;
+    dev.platform.p_bus_ctx = &bus;
+
+    // Peak stack of the init, less that of an empty thread
+    InitRun idle = {nullptr, 0}, run = {&dev, 0xff};
+    size_t idle_peak = 0, init_peak = 0;
+    if (!peak_stack(idle, idle_peak) || !peak_stack(run, init_peak)) {
+        std::fprintf(stderr, "Cannot start the init thread\n");
+        return 1;
+    }
+    size_t peak = init_peak - idle_peak;
+
+    uint64_t copied = bus.firmware_bytes - bus.in_place;
+    std::printf("init %s, %" PRIu64 " writes of %" PRIu64 " bytes\n",
+            run.status == VL53L7CX_STATUS_OK && device.running() ? "ok" : "FAILED",
+            bus.writes, bus.bytes);
+    std::printf("firmware: %" PRIu64 " bytes, %" PRIu64 " in place, %" PRIu64 " copied\n",
+            bus.firmware_bytes, bus.in_place, copied);
+    std::printf("peak stack %zu bytes (limit %zu), including the simulator\n", peak,
+            stack_limit);
+
+    bool ok = run.status == VL53L7CX_STATUS_OK && device.running()
+            && bus.firmware_bytes == kFirmwareSize && copied == 0
+            && peak <= stack_limit;
+    return ok ? 0 : 1;
+}
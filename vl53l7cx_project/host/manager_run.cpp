@@ -0,0 +1,355 @@
+/**
+ * VL53L7CX Multi-Sensor Manager Run
+ *
+ * Drives --sensors simulated devices (vl53l7cx_simulator.hpp) through the
+ * manager (vl53l7cx_manager.h), as on a board: the devices share one I2C bus
+ * and one clock, all answer at the default address after power on, and each
+ * has an LPn pin. The shared bus routes every access to the devices whose
+ * LPn is high and whose I2C address is the one of the configuration, and
+ * moves a device to a new address when the driver writes register 0x4 of
+ * page 0. The run then checks:
+ *   - address assignment: every sensor boots, answers at its own address
+ *     only, and no access reached two devices at once;
+ *   - staggered start: the first frames of consecutive sensors are period / N
+ *     apart;
+ *   - fairness: with service every --poll-us, every sensor gets the same
+ *     number of frames and none is overwritten; when the host is late (service
+ *     once per period, all sensors ready), the frame counts stay equal;
+ *   - statistics: the frame rate of each sensor is the ranging frequency, and
+ *     its bus time is the transfer time measured by its device.
+ *
+ * Usage: vl53l7cx_manager [--sensors n] [--freq hz] [--seconds s]
+ *        [--i2c-hz hz] [--poll-us us]
+ *
+ * The exit status is 1 if a check fails.
+ */
+
+#include <algorithm>
+#include <cinttypes>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <vector>
+#include "vl53l7cx_simulator.hpp"
+#include "vl53l7cx_check.hpp"
+
+extern "C" {
+#include "vl53l7cx_manager.h"
+}
+
+namespace {
+
+using vl53l7cx::check;
+
+constexpr uint16_t kDefaultAddress = VL53L7CX_DEFAULT_I2C_ADDRESS >> 1;
+
+/* I2C bus shared by the devices, on one clock */
+class SharedBus {
+public:
+    explicit SharedBus(const vl53l7cx::SimulatorOptions &options, unsigned nb_devices)
+    {
+        for (unsigned i = 0; i < nb_devices; i++) {
+            Device device;
+            device.sim.reset(new vl53l7cx::SimulatedDevice(options));
+            // Operations of the device, reached through the shared bus
+            static VL53L7CX_Configuration scratch;
+            device.sim->attach(scratch);
+            device.p_ops = scratch.platform.p_bus;
+            device.p_ctx = scratch.platform.p_bus_ctx;
+            devices_.push_back(std::move(device));
+        }
+        ports_.resize(nb_devices);
+    }
+
+    /* Bind the configuration of sensor i: its accesses go to the devices at
+     * dev.platform.address */
+    void attach(unsigned i, VL53L7CX_Configuration &dev)
+    {
+        static const VL53L7CX_HostBusOps kOps = {bus_read, bus_write, bus_time_us, bus_wait_us};
+
+        ports_[i].p_bus = this;
+        ports_[i].p_platform = &dev.platform;
+        dev.platform.p_bus = &kOps;
+        dev.platform.p_bus_ctx = &ports_[i];
+        (void)VL53L7CX_AsyncInit(&dev.platform);
+    }
+
+    vl53l7cx::SimulatedDevice &device(unsigned i) { return *devices_[i].sim; }
+    uint16_t address(unsigned i) const { return devices_[i].address; }
+    uint64_t time_us() const { return now_us_; }
+    uint64_t collisions() const { return collisions_; }
+    uint64_t nacks() const { return nacks_; }
+
+    /* Manager operations */
+    static void set_lpn(void *p_ctx, uint8_t sensor, uint8_t level)
+    {
+        static_cast<SharedBus *>(p_ctx)->devices_[sensor].lpn = level != 0;
+    }
+
+    static void wait_ms(void *p_ctx, uint32_t time_ms)
+    {
+        static_cast<SharedBus *>(p_ctx)->now_us_ += uint64_t(time_ms) * 1000U;
+    }
+
+    static uint64_t manager_time_us(void *p_ctx)
+    {
+        return static_cast<SharedBus *>(p_ctx)->now_us_;
+    }
+
+    /* Access of a configuration, whatever its address: false if no device answers */
+    bool probe(const VL53L7CX_Platform &platform)
+    {
+        return !route(platform.address).empty();
+    }
+
+private:
+    struct Device {
+        std::unique_ptr<vl53l7cx::SimulatedDevice> sim;
+        const VL53L7CX_HostBusOps *p_ops = nullptr;
+        void *p_ctx = nullptr;
+        uint16_t address = kDefaultAddress;
+        uint8_t page = 0;
+        bool lpn = true;        // Powered on with LPn pulled up
+    };
+
+    struct Port {
+        SharedBus *p_bus = nullptr;
+        VL53L7CX_Platform *p_platform = nullptr;
+    };
+
+    std::vector<Device *> route(uint16_t address)
+    {
+        std::vector<Device *> targets;
+        for (Device &device : devices_) {
+            if (device.lpn && device.address == address) {
+                targets.push_back(&device);
+            }
+        }
+        return targets;
+    }
+
+    /* Bring a device to the bus clock before an access */
+    void sync(Device &device)
+    {
+        uint64_t device_us = device.p_ops->time_us(device.p_ctx);
+        while (device_us < now_us_) {
+            uint64_t step = std::min<uint64_t>(now_us_ - device_us, 1000000U);
+            device.p_ops->wait_us(device.p_ctx, static_cast<uint32_t>(step));
+            device_us = device.p_ops->time_us(device.p_ctx);
+        }
+    }
+
+    static uint8_t bus_read(void *p_ctx, uint16_t address, uint8_t *p_values, uint32_t size)
+    {
+        Port &port = *static_cast<Port *>(p_ctx);
+        SharedBus &bus = *port.p_bus;
+        std::vector<Device *> targets = bus.route(port.p_platform->address);
+        if (targets.empty()) {
+            bus.nacks_++;
+            return 255;
+        }
+        bus.collisions_ += targets.size() > 1;
+        Device &device = *targets[0];
+        bus.sync(device);
+        uint8_t status = device.p_ops->read(device.p_ctx, address, p_values, size);
+        bus.now_us_ = std::max(bus.now_us_, device.p_ops->time_us(device.p_ctx));
+        return status;
+    }
+
+    static uint8_t bus_write(void *p_ctx, uint16_t address, const uint8_t *p_values,
+            uint32_t size)
+    {
+        Port &port = *static_cast<Port *>(p_ctx);
+        SharedBus &bus = *port.p_bus;
+        std::vector<Device *> targets = bus.route(port.p_platform->address);
+        if (targets.empty()) {
+            bus.nacks_++;
+            return 255;
+        }
+        bus.collisions_ += targets.size() > 1;
+        uint8_t status = 0;
+        for (Device *p_device : targets) {
+            Device &device = *p_device;
+            bus.sync(device);
+            status |= device.p_ops->write(device.p_ctx, address, p_values, size);
+            bus.now_us_ = std::max(bus.now_us_, device.p_ops->time_us(device.p_ctx));
+            if (address == 0x7fff) {
+                device.page = p_values[0];
+            } else if (device.page == 0x00 && address <= 0x4 && address + size > 0x4) {
+                device.address = p_values[0x4 - address];   // I2C address register
+            }
+        }
+        return status;
+    }
+
+    static uint64_t bus_time_us(void *p_ctx)
+    {
+        return static_cast<Port *>(p_ctx)->p_bus->now_us_;
+    }
+
+    static void bus_wait_us(void *p_ctx, uint32_t time_us)
+    {
+        static_cast<Port *>(p_ctx)->p_bus->now_us_ += time_us;
+    }
+
+    std::vector<Device> devices_;
+    std::vector<Port> ports_;
+    uint64_t now_us_ = 0;
+    uint64_t collisions_ = 0;
+    uint64_t nacks_ = 0;
+};
+
+struct Frames {
+    std::vector<uint64_t> first_us;
+    std::vector<uint32_t> count;
+};
+
+void on_frame(uint8_t sensor, VL53L7CX_Configuration *, VL53L7CX_ResultsData *,
+        uint64_t timestamp_us, void *p_user)
+{
+    Frames &frames = *static_cast<Frames *>(p_user);
+    if (frames.count[sensor]++ == 0) {
+        frames.first_us[sensor] = timestamp_us;
+    }
+}
+
+} // namespace
+
+int main(int argc, char **argv)
+{
+    unsigned nb_sensors = 4;
+    unsigned frequency_hz = 15;
+    double seconds = 4.0;
+    uint32_t poll_us = 1000;
+    vl53l7cx::SimulatorOptions options;
+    options.i2c_hz = 1000000;
+
+    for (int i = 1; i < argc; i++) {
+        if (std::strcmp(argv[i], "--sensors") == 0 && i + 1 < argc) {
+            nb_sensors = static_cast<unsigned>(std::atoi(argv[++i]));
+        } else if (std::strcmp(argv[i], "--freq") == 0 && i + 1 < argc) {
+            frequency_hz = static_cast<unsigned>(std::atoi(argv[++i]));
+        } else if (std::strcmp(argv[i], "--seconds") == 0 && i + 1 < argc) {
+            seconds = std::atof(argv[++i]);
+        } else if (std::strcmp(argv[i], "--i2c-hz") == 0 && i + 1 < argc) {
+            options.i2c_hz = static_cast<uint32_t>(std::atol(argv[++i]));
+        } else if (std::strcmp(argv[i], "--poll-us") == 0 && i + 1 < argc) {
+            poll_us = static_cast<uint32_t>(std::atol(argv[++i]));
+        } else {
+            nb_sensors = 0;
+            break;
+        }
+    }
+    if (nb_sensors == 0 || nb_sensors > VL53L7CX_MANAGER_MAX_SENSORS || frequency_hz == 0
+            || frequency_hz > 60 || seconds <= 0.0 || poll_us == 0) {
+        std::fprintf(stderr, "Usage: %s [--sensors n] [--freq hz] [--seconds s] [--i2c-hz hz] "
+                "[--poll-us us]\n", argv[0]);
+        return 2;
+    }
+
+    SharedBus bus(options, nb_sensors);
+    static VL53L7CX_Configuration devs[VL53L7CX_MANAGER_MAX_SENSORS];
+    static VL53L7CX_ResultsData results[VL53L7CX_MANAGER_MAX_SENSORS];
+    static const VL53L7CX_ManagerOps kOps = {SharedBus::set_lpn, SharedBus::wait_ms,
+            SharedBus::manager_time_us, nullptr};
+    static VL53L7CX_Manager manager;
+
+    uint8_t status = vl53l7cx_manager_init(&manager, &kOps, &bus);
+    for (unsigned i = 0; i < nb_sensors; i++) {
+        bus.attach(i, devs[i]);
+        status |= vl53l7cx_manager_add(&manager, &devs[i], &results[i],
+                static_cast<uint16_t>(0x30 + i));
+    }
+    std::printf("%u sensors on one bus at %u kHz, %u Hz, service every %u us\n", nb_sensors,
+            options.i2c_hz / 1000, frequency_hz, poll_us);
+    bool ok = true;
+
+    // Address assignment
+    status |= vl53l7cx_manager_boot(&manager);
+    bool addressed = status == 0 && bus.collisions() == 0;
+    for (unsigned i = 0; i < nb_sensors; i++) {
+        uint8_t is_alive = 0;
+        addressed &= manager.sensors[i].state == VL53L7CX_SENSOR_READY
+                && bus.address(i) == 0x30 + i && devs[i].platform.address == 0x30 + i
+                && vl53l7cx_is_alive(&devs[i], &is_alive) == VL53L7CX_STATUS_OK && is_alive;
+    }
+    VL53L7CX_Platform default_address = {};
+    default_address.address = kDefaultAddress;
+    addressed &= !bus.probe(default_address);
+    std::printf("boot: %.1f ms, %" PRIu64 " collisions, %" PRIu64 " accesses not answered\n",
+            bus.time_us() / 1e3, bus.collisions(), bus.nacks());
+    ok &= check("addresses", addressed);
+    if (!addressed) {
+        return 1;
+    }
+
+    // Staggered start, then service every poll_us
+    status = vl53l7cx_manager_start(&manager, static_cast<uint8_t>(frequency_hz));
+    for (unsigned i = 0; i < nb_sensors; i++) {
+        bus.device(i).reset_stats();
+    }
+    Frames frames;
+    frames.first_us.assign(nb_sensors, 0);
+    frames.count.assign(nb_sensors, 0);
+    uint64_t end_us = bus.time_us() + static_cast<uint64_t>(seconds * 1e6);
+    while (status == 0 && bus.time_us() < end_us) {
+        if (vl53l7cx_manager_service(&manager, on_frame, &frames) == 0) {
+            (void)VL53L7CX_WaitUs(&devs[0].platform, poll_us);     // Bus clock
+        }
+    }
+
+    const double period_us = 1e6 / frequency_hz;
+    const double stagger_us = period_us / nb_sensors;
+    bool staggered = status == 0;
+    for (unsigned i = 1; i < nb_sensors; i++) {
+        double gap = double(frames.first_us[i]) - double(frames.first_us[i - 1]);
+        std::printf("  sensor %u first frame %+.2f ms after sensor %u (period / N = %.2f ms)\n",
+                i, gap / 1e3, i - 1, stagger_us / 1e3);
+        staggered &= std::fabs(gap - stagger_us) < poll_us + 0.1 * stagger_us;
+    }
+    ok &= check("stagger", staggered);
+
+    bool fair = true, rates = true;
+    uint32_t min_frames = UINT32_MAX, max_frames = 0;
+    for (unsigned i = 0; i < nb_sensors; i++) {
+        VL53L7CX_ManagerStats stats;
+        (void)vl53l7cx_manager_get_stats(&manager, static_cast<uint8_t>(i), &stats);
+        const vl53l7cx::SimulatorStats &device = bus.device(i).stats();
+        double rate_hz = stats.frame_rate_mhz / 1e3;
+        double device_permille = 1000.0 * device.bus_us / (bus.time_us() - manager.start_us);
+        std::printf("  sensor %u: %" PRIu32 " frames, %" PRIu32 " errors, %.3f Hz, bus %" PRIu32
+                " permille (device %.1f), %" PRIu64 " overwritten\n", i, stats.nb_frames,
+                stats.nb_errors, rate_hz, stats.bus_permille, device_permille,
+                device.overwritten);
+        min_frames = std::min(min_frames, stats.nb_frames);
+        max_frames = std::max(max_frames, stats.nb_frames);
+        fair &= stats.nb_errors == 0 && device.overwritten == 0;
+        rates &= std::fabs(rate_hz - frequency_hz) < 0.02 * frequency_hz
+                && std::fabs(stats.bus_permille - device_permille) <= 0.1 * device_permille + 1.0;
+    }
+    fair &= max_frames - min_frames <= 1 && min_frames > 0;
+    std::printf("  bus %" PRIu32 " permille for all sensors\n",
+            vl53l7cx_manager_get_bus_permille(&manager));
+
+    // Late host: one service per period, every sensor ready at each service
+    std::vector<uint32_t> before = frames.count;
+    for (unsigned k = 0; k < 10 && fair; k++) {
+        (void)VL53L7CX_WaitUs(&devs[0].platform, static_cast<uint32_t>(period_us));
+        (void)vl53l7cx_manager_service(&manager, on_frame, &frames);
+    }
+    uint32_t late_min = UINT32_MAX, late_max = 0;
+    for (unsigned i = 0; i < nb_sensors; i++) {
+        late_min = std::min(late_min, frames.count[i] - before[i]);
+        late_max = std::max(late_max, frames.count[i] - before[i]);
+    }
+    std::printf("  late host: %" PRIu32 " to %" PRIu32 " frames per sensor in 10 services\n",
+            late_min, late_max);
+    fair &= late_max - late_min <= 1 && late_min >= 9;
+    ok &= check("fairness", fair);
+    ok &= check("stats", rates);
+
+    ok &= check("stop", vl53l7cx_manager_stop(&manager) == 0);
+    return ok ? 0 : 1;
+}
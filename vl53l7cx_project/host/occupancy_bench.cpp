@@ -0,0 +1,223 @@
+/**
+ * VL53L7CX Occupancy Grid Benchmark
+ *
+ * Four sensors on a robot (front, left, back and right, 150 mm from the
+ * centre, 100 mm above the floor) see the synthetic scene of the simulator
+ * (a wall at about 1.5 m and an object crossing the field of view), each with
+ * its own phase and distance noise, at 60 Hz in 4x4. The distances of the
+ * scene are taken as horizontal ones, so the wall and the object are vertical,
+ * and the lower zones see the floor first. Their frames are
+ * accumulated into a Cartesian grid and a polar grid, incrementally (zones
+ * unchanged and saturated are skipped) and with every zone applied. For each
+ * grid and mode it reports:
+ *   - the time per update and the CPU load of 4 sensors at 60 Hz,
+ *   - the zones applied and skipped, and the cells updated per frame,
+ *   - the hits of the last frames that are occupied (within half a cell),
+ *     and the cells halfway along their rays that are free,
+ *   - the cells whose state differs between the incremental and full modes.
+ *
+ * Usage: vl53l7cx_occupancy_bench [--seconds s] [--noise mm] [--resolution 4|8]
+ *
+ * The exit status is 1 if fewer than 95 % of the hit cells are occupied or of
+ * the halfway cells are free, or if the incremental and full states differ.
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <vector>
+
+#include "vl53l7cx_simulator.hpp"
+
+extern "C" {
+#include "vl53l7cx_occupancy.h"
+#include "vl53l7cx_pointcloud.h"
+}
+
+namespace {
+
+constexpr unsigned kSensors = 4;
+constexpr unsigned kFrequencyHz = 60;
+constexpr int16_t kHeightMm = 100;
+
+#ifdef VL53L7CX_USE_RAW_FORMAT
+constexpr double kUnitsPerMm = 4.0;
+#else
+constexpr double kUnitsPerMm = 1.0;
+#endif
+
+struct Pose {
+    int16_t x_mm, y_mm, yaw_deg;
+};
+
+constexpr Pose kPoses[kSensors] = {{150, 0, 0}, {0, 150, 90}, {-150, 0, 180}, {0, -150, -90}};
+
+struct Check {
+    unsigned hits = 0, occupied = 0, rays = 0, free = 0;
+};
+
+/* Hit cells of the last frame of each sensor, and cells halfway along their rays */
+Check check_grid(const VL53L7CX_OccupancyGrid &grid,
+        const std::vector<const VL53L7CX_ResultsData *> &last)
+{
+    Check check;
+    for (unsigned s = 0; s < kSensors; s++) {
+        const VL53L7CX_OccupancySensor &sensor = grid.sensor[s];
+        for (int zone = 0; zone < sensor.resolution; zone++) {
+            size_t i = size_t(zone) * VL53L7CX_NB_TARGET_PER_ZONE;
+            double range = last[s]->distance_mm[i] / kUnitsPerMm;
+            double up = sensor.height_mm + range * sensor.ray_up[zone] / 32768.0;
+            if (last[s]->nb_target_detected[zone] == 0 || last[s]->target_status[i] != 5
+                    || up < grid.min_height_mm || up > grid.max_height_mm) {
+                continue;
+            }
+            double x = sensor.x_mm + range * sensor.ray_x[zone] / 32768.0;
+            double y = sensor.y_mm + range * sensor.ray_y[zone] / 32768.0;
+            uint16_t hit = vl53l7cx_occupancy_cell(&grid, std::lround(x), std::lround(y));
+            uint16_t half = vl53l7cx_occupancy_cell(&grid, std::lround((x + sensor.x_mm) / 2),
+                    std::lround((y + sensor.y_mm) / 2));
+            if (hit != VL53L7CX_OCCUPANCY_NO_CELL) {
+                // Occupied within half a cell along the ray: with noise, the
+                // hits of a zone spread over the cells around a boundary
+                double step = 0.5 * grid.cell_mm / range;
+                bool occupied = false;
+                for (double k : {0.0, -step, step}) {
+                    occupied |= vl53l7cx_occupancy_state(&grid, vl53l7cx_occupancy_cell(&grid,
+                            std::lround(x + k * (x - sensor.x_mm)),
+                            std::lround(y + k * (y - sensor.y_mm))))
+                            == VL53L7CX_OCCUPANCY_OCCUPIED;
+                }
+                check.hits++;
+                check.occupied += occupied;
+            }
+            if (half != VL53L7CX_OCCUPANCY_NO_CELL && half != hit) {
+                check.rays++;
+                check.free += vl53l7cx_occupancy_state(&grid, half) == VL53L7CX_OCCUPANCY_FREE;
+            }
+        }
+    }
+    return check;
+}
+
+} // namespace
+
+int main(int argc, char **argv)
+{
+    double seconds = 10.0;
+    double noise_mm = 3.0;
+    uint8_t resolution = VL53L7CX_RESOLUTION_4X4;
+
+    for (int i = 1; i < argc; i++) {
+        if (std::strcmp(argv[i], "--seconds") == 0 && i + 1 < argc) {
+            seconds = std::atof(argv[++i]);
+        } else if (std::strcmp(argv[i], "--noise") == 0 && i + 1 < argc) {
+            noise_mm = std::atof(argv[++i]);
+        } else if (std::strcmp(argv[i], "--resolution") == 0 && i + 1 < argc) {
+            resolution = std::atoi(argv[++i]) == 8 ? VL53L7CX_RESOLUTION_8X8
+                    : VL53L7CX_RESOLUTION_4X4;
+        } else {
+            std::fprintf(stderr, "Usage: %s [--seconds s] [--noise mm] [--resolution 4|8]\n",
+                    argv[0]);
+            return 2;
+        }
+    }
+    unsigned nb_frames = static_cast<unsigned>(seconds * kFrequencyHz);
+    if (nb_frames == 0) {
+        std::fprintf(stderr, "--seconds must give at least one frame\n");
+        return 2;
+    }
+
+    // Frames of every sensor, in acquisition order
+    const int16_t *rays = vl53l7cx_pointcloud_rays(resolution);
+    std::vector<VL53L7CX_ResultsData> frames(size_t(nb_frames) * kSensors);
+    std::mt19937 rng(1);
+    std::normal_distribution<double> noise(0.0, noise_mm * kUnitsPerMm);
+    for (unsigned f = 0; f < nb_frames; f++) {
+        for (unsigned s = 0; s < kSensors; s++) {
+            VL53L7CX_ResultsData &frame = frames[size_t(f) * kSensors + s];
+            std::memset(&frame, 0, sizeof(frame));
+            vl53l7cx::synthetic_scene(f, (uint64_t(f) * 1000000ULL) / kFrequencyHz
+                    + s * 1000000ULL, resolution, frame);
+            for (int zone = 0; zone < resolution; zone++) {
+                size_t i = size_t(zone) * VL53L7CX_NB_TARGET_PER_ZONE;
+                double right = rays[zone], down = rays[resolution + zone];
+                double forward = rays[2 * resolution + zone];
+                double range = frame.distance_mm[i] * 32768.0 / std::hypot(right, forward);
+                if (down > 0.0) {
+                    range = std::min(range, kHeightMm * kUnitsPerMm * 32768.0 / down);
+                }
+                frame.distance_mm[i] = static_cast<int16_t>(std::lround(range + noise(rng)));
+            }
+        }
+    }
+    std::vector<const VL53L7CX_ResultsData *> last(kSensors);
+    for (unsigned s = 0; s < kSensors; s++) {
+        last[s] = &frames[size_t(nb_frames - 1) * kSensors + s];
+    }
+
+    std::printf("%u sensors x %u Hz x %ux%u, %u frames each, noise %.1f mm, grid %zu bytes\n",
+            kSensors, kFrequencyHz, resolution == VL53L7CX_RESOLUTION_4X4 ? 4 : 8,
+            resolution == VL53L7CX_RESOLUTION_4X4 ? 4 : 8, nb_frames, noise_mm,
+            sizeof(VL53L7CX_OccupancyGrid));
+
+    static VL53L7CX_OccupancyGrid grids[2];
+    bool failed = false;
+    for (uint8_t type : {VL53L7CX_OCCUPANCY_CARTESIAN, VL53L7CX_OCCUPANCY_POLAR}) {
+        for (uint8_t incremental : {1, 0}) {
+            VL53L7CX_OccupancyGrid &grid = grids[incremental];
+            uint8_t status = (type == VL53L7CX_OCCUPANCY_CARTESIAN)
+                    ? vl53l7cx_occupancy_init(&grid, type, 128, 128, 50, 0, 0)
+                    : vl53l7cx_occupancy_init(&grid, type, 180, 80, 40, 0, 0);
+            vl53l7cx_occupancy_set_height_band(&grid, 30, 1500);
+            vl53l7cx_occupancy_set_incremental(&grid, incremental);
+            for (unsigned s = 0; s < kSensors; s++) {
+                status |= vl53l7cx_occupancy_set_sensor(&grid, static_cast<uint8_t>(s),
+                        resolution, kPoses[s].x_mm, kPoses[s].y_mm, kHeightMm, kPoses[s].yaw_deg);
+            }
+            if (status != 0) {
+                std::fprintf(stderr, "grid setup failed\n");
+                return 1;
+            }
+
+            auto start = std::chrono::steady_clock::now();
+            for (size_t i = 0; i < frames.size(); i++) {
+                status |= vl53l7cx_occupancy_update(&grid, static_cast<uint8_t>(i % kSensors),
+                        &frames[i]);
+            }
+            double update_s = std::chrono::duration<double>(std::chrono::steady_clock::now()
+                    - start).count() / frames.size();
+            if (status != 0) {
+                std::fprintf(stderr, "update failed\n");
+                return 1;
+            }
+
+            Check check = check_grid(grid, last);
+            bool grid_failed = check.occupied < 0.95 * check.hits || check.free < 0.95 * check.rays;
+            uint32_t zones = grid.zones_applied + grid.zones_skipped;
+            std::printf("%-9s %-11s %6.2f us/update (%.3f %% CPU)  zones applied %5.1f %%  "
+                    "%6.1f cells/update  occupied %u/%u  free %u/%u%s\n",
+                    type == VL53L7CX_OCCUPANCY_CARTESIAN ? "cartesian" : "polar",
+                    incremental ? "incremental" : "full", update_s * 1e6,
+                    update_s * kSensors * kFrequencyHz * 100.0,
+                    zones ? 100.0 * grid.zones_applied / zones : 0.0,
+                    double(grid.cells_updated) / frames.size(), check.occupied, check.hits,
+                    check.free, check.rays, grid_failed ? "  FAILED" : "");
+            failed |= grid_failed;
+        }
+
+        unsigned cells = unsigned(grids[0].width) * grids[0].height, differ = 0;
+        for (unsigned c = 0; c < cells; c++) {
+            differ += vl53l7cx_occupancy_state(&grids[0], static_cast<uint16_t>(c))
+                    != vl53l7cx_occupancy_state(&grids[1], static_cast<uint16_t>(c));
+        }
+        std::printf("%-9s incremental and full states differ in %u of %u cells%s\n",
+                type == VL53L7CX_OCCUPANCY_CARTESIAN ? "cartesian" : "polar", differ, cells,
+                differ ? "  FAILED" : "");
+        failed |= differ != 0;
+    }
+    return failed ? 1 : 0;
+}
@@ -0,0 +1,488 @@
+/**
+ * Host Platform Layer Implementation for VL53L7CX Driver
+ *
+ * Register accesses, waits and time are forwarded to the simulated bus of the
+ * platform structure (see platform/platform_pico.h). Asynchronous transfers
+ * run on the same engine as on the Pico 2, the bus completing them at once or,
+ * with async_delay_us set, after that delay on the device clock.
+ */
+
+#include "platform_pico.h"
+
+/**
+ * @brief Read a single byte from VL53L7CX sensor
+ * @param p_platform: Pointer to platform structure
+ * @param RegisterAdress: Register address to read from
+ * @param p_value: Pointer to store the read value
+ * @return 0 if OK, non-zero if error
+ */
+uint8_t VL53L7CX_RdByte(
+        VL53L7CX_Platform *p_platform,
+        uint16_t RegisterAdress,
+        uint8_t *p_value)
+{
+    return VL53L7CX_RdMulti(p_platform, RegisterAdress, p_value, 1);
+}
+
+/**
+ * @brief Write a single byte to VL53L7CX sensor
+ * @param p_platform: Pointer to platform structure
+ * @param RegisterAdress: Register address to write to
+ * @param value: Value to write
+ * @return 0 if OK, non-zero if error
+ */
+uint8_t VL53L7CX_WrByte(
+        VL53L7CX_Platform *p_platform,
+        uint16_t RegisterAdress,
+        uint8_t value)
+{
+    return VL53L7CX_WrMulti(p_platform, RegisterAdress, &value, 1);
+}
+
+/**
+ * @brief Write a list of buffers to VL53L7CX sensor as a single I2C transaction
+ * @param p_platform: Pointer to platform structure
+ * @param p_segments: Segments to send, in order: the transaction starts with
+ * the 16-bit register address (big-endian)
+ * @param nb_segments: Number of segments
+ * @return 0 if OK, non-zero if error
+ *
+ * The data of each segment is handed to the simulated bus in place, as one
+ * access at its register address (the sensor increments the address during a
+ * transaction): nothing is copied.
+ */
+uint8_t VL53L7CX_WrGather(
+        VL53L7CX_Platform *p_platform,
+        const VL53L7CX_WrSegment *p_segments,
+        uint8_t nb_segments)
+{
+    uint8_t header[2];
+    uint32_t nb_header = 0, offset, payload = 0;
+    uint16_t address = 0;
+    uint8_t status = 0;
+    uint8_t i;
+
+    if (!p_platform || !p_platform->p_bus || !p_segments || nb_segments == 0) {
+        return 255; // Error: invalid parameters
+    }
+
+    for (i = 0; i < nb_segments; i++) {
+        if (!p_segments[i].data || p_segments[i].size == 0) {
+            return 255; // Error: empty segment
+        }
+    }
+
+    for (i = 0; i < nb_segments && status == 0; i++) {
+        offset = 0;
+        while (nb_header < 2 && offset < p_segments[i].size) {
+            header[nb_header++] = p_segments[i].data[offset++];
+            if (nb_header == 2) {
+                address = (uint16_t)((header[0] << 8) | header[1]);
+            }
+        }
+        if (offset < p_segments[i].size) {
+            status = p_platform->p_bus->write(p_platform->p_bus_ctx, address,
+                    &p_segments[i].data[offset], p_segments[i].size - offset);
+            address = (uint16_t)(address + (p_segments[i].size - offset));
+            payload += p_segments[i].size - offset;
+        }
+    }
+
+    if (payload == 0) {
+        return 255; // Error: no data after the register address
+    }
+
+    return status;
+}
+
+/**
+ * @brief Write multiple bytes to VL53L7CX sensor
+ * @param p_platform: Pointer to platform structure
+ * @param RegisterAdress: Register address to write to
+ * @param p_values: Pointer to data to write
+ * @param size: Number of bytes to write
+ * @return 0 if OK, non-zero if error
+ */
+uint8_t VL53L7CX_WrMulti(
+        VL53L7CX_Platform *p_platform,
+        uint16_t RegisterAdress,
+        uint8_t *p_values,
+        uint32_t size)
+{
+    if (!p_platform || !p_platform->p_bus || !p_values || size == 0) {
+        return 255; // Error: invalid parameters
+    }
+
+    // Register address (16-bit, big-endian) followed by the caller's buffer,
+    // as on the Pico 2
+    uint8_t reg_addr[2] = {(RegisterAdress >> 8) & 0xFF, RegisterAdress & 0xFF};
+    VL53L7CX_WrSegment segments[2] = {
+        {reg_addr, 2},
+        {p_values, size}
+    };
+
+    return VL53L7CX_WrGather(p_platform, segments, 2);
+}
+
+/**
+ * @brief Read multiple bytes from VL53L7CX sensor
+ * @param p_platform: Pointer to platform structure
+ * @param RegisterAdress: Register address to read from
+ * @param p_values: Pointer to store the read values
+ * @param size: Number of bytes to read
+ * @return 0 if OK, non-zero if error
+ */
+uint8_t VL53L7CX_RdMulti(
+        VL53L7CX_Platform *p_platform,
+        uint16_t RegisterAdress,
+        uint8_t *p_values,
+        uint32_t size)
+{
+    if (!p_platform || !p_platform->p_bus || !p_values || size == 0) {
+        return 255; // Error: invalid parameters
+    }
+
+    return p_platform->p_bus->read(p_platform->p_bus_ctx, RegisterAdress, p_values, size);
+}
+
+/**
+ * @brief Run a transfer on the simulated bus
+ * @param p_platform: Pointer to platform structure
+ * @param p_xfer: Transfer
+ * @return 0 if OK, non-zero if the device refused the access
+ */
+static uint8_t _vl53l7cx_host_transfer(
+        VL53L7CX_Platform *p_platform,
+        VL53L7CX_AsyncXfer *p_xfer)
+{
+    if (p_xfer->direction == VL53L7CX_ASYNC_READ) {
+        return VL53L7CX_RdMulti(p_platform, p_xfer->register_address, p_xfer->p_data, p_xfer->size);
+    }
+    return VL53L7CX_WrMulti(p_platform, p_xfer->register_address, p_xfer->p_data, p_xfer->size);
+}
+
+/**
+ * @brief Async bus operation: with no delay, run the whole transfer at
+ * submission. Delayed transfers run when they are due (see poll).
+ * @param p_ctx: Platform structure
+ * @param p_xfer: Transfer
+ * @return 0 if OK, non-zero if the device refused the access
+ */
+static uint8_t _vl53l7cx_host_start(
+        void *p_ctx,
+        VL53L7CX_AsyncXfer *p_xfer)
+{
+    VL53L7CX_Platform *p_platform = (VL53L7CX_Platform *)p_ctx;
+
+    if (p_platform->async_delay_us == 0) {
+        return _vl53l7cx_host_transfer(p_platform, p_xfer);
+    }
+    return 0;
+}
+
+/**
+ * @brief Async bus operation: a delayed transfer is busy for async_delay_us
+ * of the device clock after its submission, then runs. An aborted transfer
+ * never reaches the device, so there is no abort operation.
+ * @param p_ctx: Platform structure
+ * @param p_xfer: Transfer
+ * @return VL53L7CX_ASYNC_BUSY, VL53L7CX_ASYNC_DONE or VL53L7CX_ASYNC_ERROR
+ */
+static uint8_t _vl53l7cx_host_poll(
+        void *p_ctx,
+        VL53L7CX_AsyncXfer *p_xfer)
+{
+    VL53L7CX_Platform *p_platform = (VL53L7CX_Platform *)p_ctx;
+
+    if (p_platform->async_delay_us == 0) {
+        return VL53L7CX_ASYNC_DONE;
+    }
+
+    if ((p_platform->p_bus->time_us(p_platform->p_bus_ctx) - p_xfer->submit_time_us)
+            < p_platform->async_delay_us) {
+        return VL53L7CX_ASYNC_BUSY;
+    }
+
+    if (_vl53l7cx_host_transfer(p_platform, p_xfer) != 0) {
+        return VL53L7CX_ASYNC_ERROR;
+    }
+    return VL53L7CX_ASYNC_DONE;
+}
+
+static uint64_t _vl53l7cx_host_time_us(
+        void *p_ctx)
+{
+    VL53L7CX_Platform *p_platform = (VL53L7CX_Platform *)p_ctx;
+
+    return p_platform->p_bus->time_us(p_platform->p_bus_ctx);
+}
+
+/**
+ * @brief Async bus operation: called while waiting for a transfer, lets the
+ * device clock run by steps of VL53L7CX_HOST_ASYNC_STEP_US
+ * @param p_ctx: Platform structure
+ */
+static void _vl53l7cx_host_idle(
+        void *p_ctx)
+{
+    VL53L7CX_Platform *p_platform = (VL53L7CX_Platform *)p_ctx;
+
+    p_platform->p_bus->wait_us(p_platform->p_bus_ctx, VL53L7CX_HOST_ASYNC_STEP_US);
+}
+
+static const VL53L7CX_AsyncBusOps vl53l7cx_host_async_ops = {
+    _vl53l7cx_host_start,
+    _vl53l7cx_host_poll,
+    NULL,
+    _vl53l7cx_host_time_us,
+    _vl53l7cx_host_idle
+};
+
+/**
+ * @brief Set up asynchronous transfers. Must be called once, after the bus of
+ * the platform structure is set.
+ * @param p_platform: Pointer to platform structure
+ * @return 0 if OK, non-zero if error
+ */
+uint8_t VL53L7CX_AsyncInit(
+        VL53L7CX_Platform *p_platform)
+{
+    if (!p_platform || !p_platform->p_bus) {
+        return 255; // Error: invalid parameters
+    }
+
+    p_platform->async_xfer.state = VL53L7CX_ASYNC_IDLE;
+    vl53l7cx_async_init(&p_platform->async, &vl53l7cx_host_async_ops, p_platform);
+
+    return 0;
+}
+
+/**
+ * @brief Submit a transfer on the platform async engine
+ * @param p_platform: Pointer to platform structure
+ * @param direction: VL53L7CX_ASYNC_READ or VL53L7CX_ASYNC_WRITE
+ * @param RegisterAdress: Register address
+ * @param p_values: Data buffer
+ * @param size: Number of bytes
+ * @param callback: Optional completion callback
+ * @param p_user: Passed back to the callback
+ * @return 0 if OK, non-zero if error
+ */
+static uint8_t _vl53l7cx_submit_async(
+        VL53L7CX_Platform *p_platform,
+        uint8_t direction,
+        uint16_t RegisterAdress,
+        uint8_t *p_values,
+        uint32_t size,
+        VL53L7CX_AsyncCallback callback,
+        void *p_user)
+{
+    VL53L7CX_AsyncXfer *p_xfer;
+
+    if (!p_platform) {
+        return 255; // Error: invalid parameters
+    }
+
+    // The transfer in flight uses async_xfer: leave it untouched
+    if (vl53l7cx_async_is_busy(&p_platform->async)) {
+        return 255; // Error: a transfer is already in flight
+    }
+
+    p_xfer = &p_platform->async_xfer;
+    p_xfer->direction = direction;
+    p_xfer->register_address = RegisterAdress;
+    p_xfer->p_data = p_values;
+    p_xfer->size = size;
+    p_xfer->callback = callback;
+    p_xfer->p_user = p_user;
+
+    return vl53l7cx_async_submit(&p_platform->async, p_xfer);
+}
+
+uint8_t VL53L7CX_RdMultiAsync(
+        VL53L7CX_Platform *p_platform,
+        uint16_t RegisterAdress,
+        uint8_t *p_values,
+        uint32_t size,
+        VL53L7CX_AsyncCallback callback,
+        void *p_user)
+{
+    return _vl53l7cx_submit_async(p_platform, VL53L7CX_ASYNC_READ,
+            RegisterAdress, p_values, size, callback, p_user);
+}
+
+uint8_t VL53L7CX_WrMultiAsync(
+        VL53L7CX_Platform *p_platform,
+        uint16_t RegisterAdress,
+        uint8_t *p_values,
+        uint32_t size,
+        VL53L7CX_AsyncCallback callback,
+        void *p_user)
+{
+    return _vl53l7cx_submit_async(p_platform, VL53L7CX_ASYNC_WRITE,
+            RegisterAdress, p_values, size, callback, p_user);
+}
+
+uint8_t VL53L7CX_PollAsync(
+        VL53L7CX_Platform *p_platform)
+{
+    return vl53l7cx_async_poll(&p_platform->async);
+}
+
+uint8_t VL53L7CX_WaitAsync(
+        VL53L7CX_Platform *p_platform,
+        uint32_t TimeMs)
+{
+    return vl53l7cx_async_wait(&p_platform->async, TimeMs * 1000U);
+}
+
+/**
+ * @brief Reset the VL53L7CX sensor (the device is reset by its owner)
+ * @param p_platform: Pointer to platform structure
+ * @return 0 if OK, non-zero if error
+ */
+uint8_t VL53L7CX_Reset_Sensor(
+        VL53L7CX_Platform *p_platform)
+{
+    if (!p_platform) {
+        return 255; // Error: invalid parameters
+    }
+
+    return VL53L7CX_WaitMs(p_platform, 100);
+}
+
+/**
+ * @brief Swap buffer bytes (for endianness conversion)
+ * @param buffer: Pointer to buffer
+ * @param size: Size of buffer
+ */
+void VL53L7CX_SwapBuffer(
+        uint8_t 		*buffer,
+        uint16_t 	 	 size)
+{
+    uint32_t i, tmp;
+
+    for(i = 0; i < size; i = i + 4)
+    {
+        memcpy(&tmp, &(buffer[i]), 4);
+        tmp = __builtin_bswap32(tmp);
+        memcpy(&(buffer[i]), &tmp, 4);
+    }
+}
+
+/**
+ * @brief Wait for specified number of milliseconds (device clock)
+ * @param p_platform: Pointer to platform structure
+ * @param TimeMs: Time to wait in milliseconds
+ * @return 0 if OK, non-zero if error
+ */
+uint8_t VL53L7CX_WaitMs(
+        VL53L7CX_Platform *p_platform,
+        uint32_t TimeMs)
+{
+    return VL53L7CX_WaitUs(p_platform, TimeMs * 1000U);
+}
+
+/**
+ * @brief Wait for specified number of microseconds (device clock)
+ * @param p_platform: Pointer to platform structure
+ * @param TimeUs: Time to wait in microseconds
+ * @return 0 if OK, non-zero if error
+ */
+uint8_t VL53L7CX_WaitUs(
+        VL53L7CX_Platform *p_platform,
+        uint32_t TimeUs)
+{
+    if (!p_platform || !p_platform->p_bus) {
+        return 255; // Error: invalid parameters
+    }
+
+    p_platform->p_bus->wait_us(p_platform->p_bus_ctx, TimeUs);
+    return 0;
+}
+
+/**
+ * @brief Get a free-running time (device clock)
+ * @param p_platform: Pointer to platform structure
+ * @return Time in microseconds, wrapping at 2^32
+ */
+uint32_t VL53L7CX_GetTimeUs(
+        VL53L7CX_Platform *p_platform)
+{
+    return (uint32_t)p_platform->p_bus->time_us(p_platform->p_bus_ctx);
+}
+
+#define VL53L7CX_RETAINED_ENTRIES       4U
+
+/* One value per sensor (device and address), for the life of the process:
+ * a simulated host reset is a new configuration structure on the same device */
+static struct
+{
+    const void         *p_device;
+    uint16_t           address;
+    uint32_t           value;
+} vl53l7cx_retained[VL53L7CX_RETAINED_ENTRIES];
+
+static uint8_t _vl53l7cx_retained_find(VL53L7CX_Platform *p_platform)
+{
+    uint8_t i;
+
+    for (i = 0; i < VL53L7CX_RETAINED_ENTRIES; i++) {
+        if (vl53l7cx_retained[i].p_device == p_platform->p_bus_ctx
+                && vl53l7cx_retained[i].address == p_platform->address) {
+            break;
+        }
+    }
+
+    return i;
+}
+
+/**
+ * @brief Read the value kept for this sensor across host resets
+ * @param p_platform: Pointer to platform structure
+ * @param p_value: Pointer to store the value
+ * @return 0 if OK, non-zero if no value is kept for this sensor
+ */
+uint8_t VL53L7CX_RdRetained(
+        VL53L7CX_Platform *p_platform,
+        uint32_t *p_value)
+{
+    uint8_t i = _vl53l7cx_retained_find(p_platform);
+
+    if (i >= VL53L7CX_RETAINED_ENTRIES || vl53l7cx_retained[i].value == 0) {
+        return 255; // Error: nothing kept
+    }
+
+    *p_value = vl53l7cx_retained[i].value;
+    return 0;
+}
+
+/**
+ * @brief Keep a value for this sensor across host resets (0 drops it)
+ * @param p_platform: Pointer to platform structure
+ * @param value: Value to keep
+ * @return 0 if OK, non-zero if every entry is used by other sensors
+ */
+uint8_t VL53L7CX_WrRetained(
+        VL53L7CX_Platform *p_platform,
+        uint32_t value)
+{
+    uint8_t i = _vl53l7cx_retained_find(p_platform);
+
+    if (i >= VL53L7CX_RETAINED_ENTRIES) {
+        // New sensor: take a free entry
+        for (i = 0; i < VL53L7CX_RETAINED_ENTRIES; i++) {
+            if (vl53l7cx_retained[i].value == 0) {
+                break;
+            }
+        }
+        if (i >= VL53L7CX_RETAINED_ENTRIES) {
+            return 255; // Error: no free entry
+        }
+        vl53l7cx_retained[i].p_device = p_platform->p_bus_ctx;
+        vl53l7cx_retained[i].address = p_platform->address;
+    }
+
+    vl53l7cx_retained[i].value = value;
+    return 0;
+}
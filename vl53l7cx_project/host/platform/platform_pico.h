@@ -0,0 +1,144 @@
+/**
+ * Host Platform Layer for VL53L7CX Driver
+ *
+ * Host (Linux) port of platform_pico.h, with the same name so that the ULD
+ * sources (vl53l7cx_api.h includes "platform_pico.h") and the driver modules
+ * build unchanged on a host machine: this directory must come before the
+ * project root in the include path.
+ *
+ * There is no I2C bus: register accesses go through a table of operations
+ * set in the platform structure, served by a simulated device (a recording
+ * replayed by host/vl53l7cx_replay.hpp for instance). Waits and time go
+ * through the same table, so a device can run on its own clock.
+ */
+
+#ifndef _PLATFORM_PICO_H_
+#define _PLATFORM_PICO_H_
+
+#include <stdint.h>
+#include <string.h>
+#include "vl53l7cx_async.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Simulated bus operations. read() and write() serve one register
+ * access (16-bit address, then size data bytes) and return 0 if OK.
+ * time_us() is the clock of the device, wait_us() lets time_us microseconds of
+ * this clock elapse.
+ */
+
+typedef struct
+{
+    uint8_t  (*read)(void *p_ctx, uint16_t address, uint8_t *p_values, uint32_t size);
+    uint8_t  (*write)(void *p_ctx, uint16_t address, const uint8_t *p_values, uint32_t size);
+    uint64_t (*time_us)(void *p_ctx);
+    void     (*wait_us)(void *p_ctx, uint32_t time_us);
+} VL53L7CX_HostBusOps;
+
+/**
+ * @brief Structure VL53L7CX_Platform needs to be filled by the customer,
+ * depending on his platform. At least, it contains the VL53L7CX I2C address.
+ * Some additional fields can be added, as descriptors, or platform
+ * dependencies. Anything added into this structure is visible into the platform
+ * layer.
+ */
+
+typedef struct
+{
+    /* To be filled with customer's platform. At least an I2C address/descriptor
+     * needs to be added */
+    /* Example for most standard platform : I2C address of sensor */
+    uint16_t  			address;
+
+    /* Host specific fields: simulated device behind the bus */
+    const VL53L7CX_HostBusOps *p_bus;
+    void               *p_bus_ctx;
+
+    /* Asynchronous transfers, set up by VL53L7CX_AsyncInit() */
+    VL53L7CX_AsyncEngine async;        /* Transfer state machine */
+    VL53L7CX_AsyncXfer async_xfer;     /* Transfer used by the *Async functions */
+    uint32_t async_delay_us;           /* Completion delay, 0 for at once */
+
+} VL53L7CX_Platform;
+
+/**
+ * @brief One contiguous piece of an I2C write built with VL53L7CX_WrGather().
+ */
+
+typedef struct
+{
+    const uint8_t      *data;           /* Bytes to send */
+    uint32_t           size;            /* Number of bytes */
+} VL53L7CX_WrSegment;
+
+/*
+ * @brief The macro below is used to define the number of target per zone sent
+ * through I2C. This value can be changed by user, in order to tune I2C
+ * transaction, and also the total memory size (a lower number of target per
+ * zone means a lower RAM). The value must be between 1 and 4. On the host it
+ * can be given on the command line, to test multi-target builds.
+ */
+
+#ifndef VL53L7CX_NB_TARGET_PER_ZONE
+#define 	VL53L7CX_NB_TARGET_PER_ZONE		1U
+#endif
+
+/*
+ * @brief The macro below can be used to avoid data conversion into the driver.
+ * By default there is a conversion between firmware and user data. Using this macro
+ * allows to use the firmware format instead of user format. The firmware format allows
+ * an increased precision. Keep it as in platform_pico.h: recordings hold the
+ * results in the format of the firmware build.
+ */
+
+#define 	VL53L7CX_USE_RAW_FORMAT
+
+/*
+ * @brief Shadow copy of the DCI blocks, as in platform_pico.h.
+ */
+
+#define 	VL53L7CX_USE_DCI_CACHE
+
+/*
+ * @brief Step of the device clock while waiting for a delayed asynchronous
+ * transfer (async_delay_us), the resolution of the wait timeouts.
+ */
+
+#ifndef VL53L7CX_HOST_ASYNC_STEP_US
+#define 	VL53L7CX_HOST_ASYNC_STEP_US		100U
+#endif
+
+/*
+ * @brief VL53L7CX_SHARED_TEMP_BUFFER, VL53L7CX_CONST_CALIBRATION and the
+ * VL53L7CX_DISABLE_* outputs can be given on the command line.
+ * VL53L7CX_COMPRESSED_FIRMWARE is only given to vl53l7cx_uld_lz (see
+ * CMakeLists.txt), the driver of vl53l7cx_firmware_bench.
+ */
+
+/* Platform function declarations */
+uint8_t VL53L7CX_RdByte(VL53L7CX_Platform *p_platform, uint16_t RegisterAdress, uint8_t *p_value);
+uint8_t VL53L7CX_WrByte(VL53L7CX_Platform *p_platform, uint16_t RegisterAdress, uint8_t value);
+uint8_t VL53L7CX_WrMulti(VL53L7CX_Platform *p_platform, uint16_t RegisterAdress, uint8_t *p_values, uint32_t size);
+uint8_t VL53L7CX_RdMulti(VL53L7CX_Platform *p_platform, uint16_t RegisterAdress, uint8_t *p_values, uint32_t size);
+uint8_t VL53L7CX_WrGather(VL53L7CX_Platform *p_platform, const VL53L7CX_WrSegment *p_segments, uint8_t nb_segments);
+uint8_t VL53L7CX_AsyncInit(VL53L7CX_Platform *p_platform);
+uint8_t VL53L7CX_RdMultiAsync(VL53L7CX_Platform *p_platform, uint16_t RegisterAdress, uint8_t *p_values, uint32_t size, VL53L7CX_AsyncCallback callback, void *p_user);
+uint8_t VL53L7CX_WrMultiAsync(VL53L7CX_Platform *p_platform, uint16_t RegisterAdress, uint8_t *p_values, uint32_t size, VL53L7CX_AsyncCallback callback, void *p_user);
+uint8_t VL53L7CX_PollAsync(VL53L7CX_Platform *p_platform);
+uint8_t VL53L7CX_WaitAsync(VL53L7CX_Platform *p_platform, uint32_t TimeMs);
+uint8_t VL53L7CX_Reset_Sensor(VL53L7CX_Platform *p_platform);
+void VL53L7CX_SwapBuffer(uint8_t *buffer, uint16_t size);
+uint8_t VL53L7CX_WaitMs(VL53L7CX_Platform *p_platform, uint32_t TimeMs);
+uint8_t VL53L7CX_WaitUs(VL53L7CX_Platform *p_platform, uint32_t TimeUs);
+uint32_t VL53L7CX_GetTimeUs(VL53L7CX_Platform *p_platform);
+uint8_t VL53L7CX_RdRetained(VL53L7CX_Platform *p_platform, uint32_t *p_value);
+uint8_t VL53L7CX_WrRetained(VL53L7CX_Platform *p_platform, uint32_t value);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _PLATFORM_PICO_H_ */
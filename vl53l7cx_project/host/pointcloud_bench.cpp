@@ -0,0 +1,165 @@
+/**
+ * VL53L7CX Point Cloud Benchmark
+ *
+ * Projects frames of the synthetic scene of the simulator (a tilted wall and
+ * an object crossing the field of view) with vl53l7cx_pointcloud_project(),
+ * and with a reference which does the trigonometry per zone per frame in
+ * double precision, as a consumer without the tables would. For 4x4 and 8x8
+ * it reports the time per frame of both, the points per second of the
+ * projection, and its largest difference from the reference.
+ *
+ * Usage: vl53l7cx_pointcloud_bench [--frames n] [--iterations n]
+ *
+ * The exit status is 1 if a coordinate differs from the reference by more
+ * than 1 mm or a point does not have the validity of the reference.
+ */
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+#include "vl53l7cx_simulator.hpp"
+
+extern "C" {
+#include "vl53l7cx_pointcloud.h"
+#include "vl53l7cx_pointcloud_lut.h"
+}
+
+namespace {
+
+#ifdef VL53L7CX_USE_RAW_FORMAT
+constexpr double kDistanceScale = 0.25;
+#else
+constexpr double kDistanceScale = 1.0;
+#endif
+
+struct Reference {
+    double x[VL53L7CX_POINTCLOUD_MAX_POINTS];
+    double y[VL53L7CX_POINTCLOUD_MAX_POINTS];
+    double z[VL53L7CX_POINTCLOUD_MAX_POINTS];
+    bool valid[VL53L7CX_POINTCLOUD_MAX_POINTS];
+};
+
+/* Trigonometry per zone, as a consumer without tables does it */
+void project_reference(const VL53L7CX_ResultsData &results, uint8_t resolution, Reference &out)
+{
+    const int width = (resolution == VL53L7CX_RESOLUTION_4X4) ? 4 : 8;
+    const double pi = std::acos(-1.0);
+    for (int zone = 0; zone < resolution; zone++) {
+        double u = std::tan(VL53L7CX_POINTCLOUD_FOV_X_DEG * pi / 360.0)
+                * ((2.0 * (zone % width) + 1.0) / width - 1.0);
+        double v = std::tan(VL53L7CX_POINTCLOUD_FOV_Y_DEG * pi / 360.0)
+                * ((2.0 * (zone / width) + 1.0) / width - 1.0);
+        double norm = std::sqrt(u * u + v * v + 1.0);
+        for (uint32_t target = 0; target < VL53L7CX_NB_TARGET_PER_ZONE; target++) {
+            size_t i = zone * VL53L7CX_NB_TARGET_PER_ZONE + target;
+            double d = results.distance_mm[i] * kDistanceScale / norm;
+            uint8_t status = results.target_status[i];
+            out.valid[i] = target < results.nb_target_detected[zone]
+                    && status < 32 && (VL53L7CX_POINTCLOUD_DEFAULT_STATUS_MASK >> status) & 1U;
+            out.x[i] = out.valid[i] ? d * u : 0.0;
+            out.y[i] = out.valid[i] ? d * v : 0.0;
+            out.z[i] = out.valid[i] ? d : 0.0;
+        }
+    }
+}
+
+double seconds_since(std::chrono::steady_clock::time_point start)
+{
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+} // namespace
+
+int main(int argc, char **argv)
+{
+    unsigned nb_frames = 256;
+    unsigned iterations = 200;
+
+    for (int i = 1; i < argc; i++) {
+        if (std::strcmp(argv[i], "--frames") == 0 && i + 1 < argc) {
+            nb_frames = static_cast<unsigned>(std::atoi(argv[++i]));
+        } else if (std::strcmp(argv[i], "--iterations") == 0 && i + 1 < argc) {
+            iterations = static_cast<unsigned>(std::atoi(argv[++i]));
+        } else {
+            std::fprintf(stderr, "Usage: %s [--frames n] [--iterations n]\n", argv[0]);
+            return 2;
+        }
+    }
+    if (nb_frames == 0 || iterations == 0) {
+        std::fprintf(stderr, "--frames and --iterations must be positive\n");
+        return 2;
+    }
+
+    bool failed = false;
+    std::printf("FoV %.1f x %.1f deg, %u target(s) per zone, %u frames x %u iterations\n",
+            VL53L7CX_POINTCLOUD_FOV_X_DEG, VL53L7CX_POINTCLOUD_FOV_Y_DEG,
+            unsigned(VL53L7CX_NB_TARGET_PER_ZONE), nb_frames, iterations);
+
+    for (uint8_t resolution : {VL53L7CX_RESOLUTION_4X4, VL53L7CX_RESOLUTION_8X8}) {
+        std::vector<VL53L7CX_ResultsData> frames(nb_frames);
+        for (unsigned f = 0; f < nb_frames; f++) {
+            std::memset(&frames[f], 0, sizeof(frames[f]));
+            // 4 s sweep of the object over the frames
+            vl53l7cx::synthetic_scene(f, uint64_t(f) * 4000000ULL / nb_frames, resolution, frames[f]);
+        }
+
+        // Accuracy and validity against the reference
+        static VL53L7CX_PointCloud cloud;
+        static Reference reference;
+        double max_error = 0.0;
+        unsigned mask_errors = 0;
+        unsigned long valid_points = 0;
+        for (const VL53L7CX_ResultsData &frame : frames) {
+            if (vl53l7cx_pointcloud_project(&frame, resolution,
+                    VL53L7CX_POINTCLOUD_DEFAULT_STATUS_MASK, &cloud) != 0) {
+                failed = true;
+                break;
+            }
+            project_reference(frame, resolution, reference);
+            for (uint16_t i = 0; i < cloud.nb_points; i++) {
+                bool valid = (cloud.valid_mask[i / 32] >> (i % 32)) & 1U;
+                mask_errors += valid != reference.valid[i] ? 1 : 0;
+                max_error = std::fmax(max_error, std::fabs(cloud.x_mm[i] - reference.x[i]));
+                max_error = std::fmax(max_error, std::fabs(cloud.y_mm[i] - reference.y[i]));
+                max_error = std::fmax(max_error, std::fabs(cloud.z_mm[i] - reference.z[i]));
+            }
+            valid_points += cloud.nb_valid;
+        }
+
+        // Throughput
+        volatile int32_t sink = 0;
+        auto start = std::chrono::steady_clock::now();
+        for (unsigned it = 0; it < iterations; it++) {
+            for (const VL53L7CX_ResultsData &frame : frames) {
+                (void)vl53l7cx_pointcloud_project(&frame, resolution,
+                        VL53L7CX_POINTCLOUD_DEFAULT_STATUS_MASK, &cloud);
+                sink = sink + cloud.x_mm[it % cloud.nb_points];
+            }
+        }
+        double table_s = seconds_since(start);
+
+        start = std::chrono::steady_clock::now();
+        for (unsigned it = 0; it < iterations; it++) {
+            for (const VL53L7CX_ResultsData &frame : frames) {
+                project_reference(frame, resolution, reference);
+                sink = sink + static_cast<int32_t>(reference.x[it % cloud.nb_points]);
+            }
+        }
+        double trig_s = seconds_since(start);
+
+        double calls = double(iterations) * nb_frames;
+        std::printf("%ux%u  %4u points  %7.1f ns/frame (%6.1f M points/s)  trig %7.1f ns/frame "
+                "(x%.1f)  max error %.2f mm, %lu valid, %u mask errors%s\n",
+                resolution == VL53L7CX_RESOLUTION_4X4 ? 4 : 8,
+                resolution == VL53L7CX_RESOLUTION_4X4 ? 4 : 8, cloud.nb_points,
+                table_s * 1e9 / calls, calls * cloud.nb_points / table_s / 1e6,
+                trig_s * 1e9 / calls, trig_s / table_s, max_error, valid_points, mask_errors,
+                (max_error > 1.0 || mask_errors) ? "  FAILED" : "");
+        failed |= max_error > 1.0 || mask_errors != 0;
+    }
+    return failed ? 1 : 0;
+}
@@ -0,0 +1,225 @@
+/**
+ * VL53L7CX Answer Polling on the Simulated Device
+ *
+ * Reads a DCI block on the register-level simulator (vl53l7cx_simulator.hpp)
+ * with several polling policies and command latencies, and checks the poll
+ * statistics of the driver (vl53l7cx_get_poll_stats()):
+ *   - the polls and the wait of each answer are those of the policy (immediate
+ *     retries, then waits doubled up to max_wait_us) for the latency of the
+ *     command and the time of each status read on the bus;
+ *   - a policy whose timeout is shorter than the latency gives a timeout
+ *     error after timeout_us of waits;
+ *   - the cumulated statistics match the status reads, waits and commands
+ *     seen by the device.
+ * It also checks that a policy set before vl53l7cx_init() or
+ * vl53l7cx_init_warm() is kept, and that a configuration never given one gets
+ * the default policy.
+ *
+ * Usage: vl53l7cx_poll
+ *
+ * The exit status is 1 if a check fails.
+ */
+
+#include <cinttypes>
+#include <cstdio>
+#include <cstring>
+#include "vl53l7cx_simulator.hpp"
+#include "vl53l7cx_check.hpp"
+
+namespace {
+
+using vl53l7cx::check;
+
+const uint32_t kI2cHz = 1000000;
+const unsigned kReads = 3;          // DCI reads per case
+
+const VL53L7CX_PollPolicy kDefault = {
+    VL53L7CX_POLL_DEFAULT_IMMEDIATE_RETRIES, VL53L7CX_POLL_DEFAULT_INITIAL_WAIT_US,
+    VL53L7CX_POLL_DEFAULT_MAX_WAIT_US, VL53L7CX_POLL_DEFAULT_TIMEOUT_US,
+};
+
+struct Case {
+    const char *name;
+    VL53L7CX_PollPolicy policy;
+    bool before_init;               // Set before vl53l7cx_init(), else after
+    uint32_t command_us;            // Answer latency of the device
+};
+
+struct Answer {
+    uint32_t polls = 0;
+    uint32_t wait_us = 0;
+    bool timeout = false;
+};
+
+/* Time of a 4-byte status read, as counted by SimulatedDevice::transfer() */
+uint64_t status_read_ns()
+{
+    return ((4ULL + 4ULL) * 9 + 2) * 1000000000ULL / kI2cHz;
+}
+
+/* Polls and waits of the driver loop for an answer latency_us after the
+ * command: a status read sees the answer once it is ready at its end */
+Answer expected(const VL53L7CX_PollPolicy &policy, uint32_t latency_us)
+{
+    Answer answer;
+    uint64_t now_ns = 0;
+    uint32_t wait_us = 0;
+    for (;;) {
+        if (answer.polls > policy.nb_immediate_retries) {
+            if (answer.wait_us >= policy.timeout_us) {
+                answer.timeout = true;
+                return answer;
+            }
+            if (wait_us == 0) {
+                wait_us = policy.initial_wait_us;
+            } else if (wait_us < policy.max_wait_us / 2) {
+                wait_us *= 2;
+            } else {
+                wait_us = policy.max_wait_us;
+            }
+            now_ns += wait_us * 1000ULL;
+            answer.wait_us += wait_us;
+        }
+        now_ns += status_read_ns();
+        answer.polls++;
+        if (now_ns >= latency_us * 1000ULL) {
+            return answer;
+        }
+    }
+}
+
+bool same_policy(const VL53L7CX_PollPolicy &a, const VL53L7CX_PollPolicy &b)
+{
+    return a.nb_immediate_retries == b.nb_immediate_retries
+            && a.initial_wait_us == b.initial_wait_us && a.max_wait_us == b.max_wait_us
+            && a.timeout_us == b.timeout_us;
+}
+
+bool run(const Case &c)
+{
+    vl53l7cx::SimulatorOptions options;
+    options.i2c_hz = kI2cHz;
+    options.command_us = c.command_us;
+    vl53l7cx::SimulatedDevice device(options);
+    static VL53L7CX_Configuration dev;
+    std::memset(&dev, 0, sizeof(dev));
+    dev.platform.address = VL53L7CX_DEFAULT_I2C_ADDRESS;
+    device.attach(dev);
+
+    uint8_t status = VL53L7CX_STATUS_OK;
+    if (c.before_init) {
+        status |= vl53l7cx_set_poll_policy(&dev, &c.policy);
+    }
+    status |= vl53l7cx_init(&dev);
+    if (!c.before_init) {
+        status |= vl53l7cx_set_poll_policy(&dev, &c.policy);
+    }
+    VL53L7CX_PollPolicy policy;
+    (void)vl53l7cx_get_poll_policy(&dev, &policy);
+    bool kept = status == VL53L7CX_STATUS_OK && same_policy(policy, c.policy);
+
+    Answer model = expected(c.policy, c.command_us);
+    unsigned reads = model.timeout ? 1 : kReads;
+    unsigned wrong = 0;
+    uint8_t data[4];
+    status = VL53L7CX_STATUS_OK;
+    device.reset_stats();
+    (void)vl53l7cx_reset_poll_stats(&dev);
+    for (unsigned i = 0; i < reads; i++) {
+        status |= vl53l7cx_dci_read_data(&dev, data, VL53L7CX_DCI_FREQ_HZ,
+                static_cast<uint16_t>(sizeof(data)));
+        VL53L7CX_PollStats stats;
+        (void)vl53l7cx_get_poll_stats(&dev, &stats);
+        wrong += stats.last_nb_polls != model.polls || stats.last_wait_us != model.wait_us;
+    }
+    VL53L7CX_PollStats stats;
+    (void)vl53l7cx_get_poll_stats(&dev, &stats);
+    const vl53l7cx::SimulatorStats &sim = device.stats();
+
+    std::printf("  %" PRIu32 " us answers: %" PRIu32 " polls, %" PRIu32 " us waited per read"
+            " (expected %" PRIu32 ", %" PRIu32 " us%s); device: %" PRIu64 " status reads, %"
+            PRIu64 " us waited\n", c.command_us, stats.last_nb_polls, stats.last_wait_us,
+            model.polls, model.wait_us, model.timeout ? ", timeout" : "", sim.status_polls,
+            sim.wait_us);
+    bool answered = model.timeout ? status == VL53L7CX_STATUS_TIMEOUT_ERROR
+            : status == VL53L7CX_STATUS_OK && sim.commands == reads;
+    return check(c.name, kept && answered && wrong == 0 && stats.nb_calls == reads
+            && stats.total_nb_polls == sim.status_polls && stats.total_wait_us == sim.wait_us
+            && stats.max_nb_polls == model.polls && stats.max_wait_us == model.wait_us);
+}
+
+/* Policies across init: a fresh configuration (host reset) keeps a policy set
+ * before vl53l7cx_init_warm(), and gets the default one otherwise */
+bool run_warm()
+{
+    const VL53L7CX_PollPolicy custom = {0, 250, 2000, 500000};
+    vl53l7cx::SimulatedDevice device;
+    static VL53L7CX_Configuration dev;
+    VL53L7CX_InitReport report;
+    VL53L7CX_PollPolicy policy;
+    bool ok = true;
+
+    std::memset(&dev, 0, sizeof(dev));
+    dev.platform.address = VL53L7CX_DEFAULT_I2C_ADDRESS;
+    device.attach(dev);
+    ok &= vl53l7cx_init(&dev) == VL53L7CX_STATUS_OK;
+    (void)vl53l7cx_get_poll_policy(&dev, &policy);
+    ok &= same_policy(policy, kDefault);
+
+    std::memset(&dev, 0, sizeof(dev));
+    dev.platform.address = VL53L7CX_DEFAULT_I2C_ADDRESS;
+    device.attach(dev);
+    ok &= vl53l7cx_set_poll_policy(&dev, &custom) == VL53L7CX_STATUS_OK;
+    ok &= vl53l7cx_init_warm(&dev) == VL53L7CX_STATUS_OK;
+    (void)vl53l7cx_get_init_report(&dev, &report);
+    (void)vl53l7cx_get_poll_policy(&dev, &policy);
+    ok &= report.path == VL53L7CX_INIT_WARM && same_policy(policy, custom);
+
+    std::memset(&dev, 0, sizeof(dev));
+    dev.platform.address = VL53L7CX_DEFAULT_I2C_ADDRESS;
+    device.attach(dev);
+    ok &= vl53l7cx_init_warm(&dev) == VL53L7CX_STATUS_OK;
+    (void)vl53l7cx_get_init_report(&dev, &report);
+    (void)vl53l7cx_get_poll_policy(&dev, &policy);
+    ok &= report.path == VL53L7CX_INIT_WARM && same_policy(policy, kDefault);
+
+    // Cold fallback: the policy is still kept
+    device.power_cycle();
+    std::memset(&dev, 0, sizeof(dev));
+    dev.platform.address = VL53L7CX_DEFAULT_I2C_ADDRESS;
+    device.attach(dev);
+    ok &= vl53l7cx_set_poll_policy(&dev, &custom) == VL53L7CX_STATUS_OK;
+    ok &= vl53l7cx_init_warm(&dev) == VL53L7CX_STATUS_OK;
+    (void)vl53l7cx_get_init_report(&dev, &report);
+    (void)vl53l7cx_get_poll_policy(&dev, &policy);
+    ok &= report.path == VL53L7CX_INIT_COLD && same_policy(policy, custom);
+
+    return check("init", ok);
+}
+
+} // namespace
+
+int main(int argc, char **argv)
+{
+    if (argc > 1) {
+        std::fprintf(stderr, "Usage: %s\n", argv[0]);
+        return 2;
+    }
+
+    const Case cases[] = {
+        {"default", kDefault, false, 300},
+        {"back-off", kDefault, false, 5000},
+        {"fixed", {0, 1000, 1000, 2000000}, true, 5000},
+        {"retries", {4, 50, 3200, 2000000}, true, 2000},
+        {"timeout", {0, 100, 400, 2000}, false, 5000},
+    };
+
+    std::printf("I2C at %" PRIu32 " kHz, status reads of %" PRIu64 " ns\n", kI2cHz / 1000,
+            status_read_ns());
+    bool ok = true;
+    for (const Case &c : cases) {
+        ok &= run(c);
+    }
+    ok &= run_warm();
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,80 @@
+/**
+ * VL53L7CX Frame Reader Benchmark
+ *
+ * Parses a captured stream (see vl53l7cx_stream_dump --save) and reports the
+ * frames parsed per second:
+ *   decoder  StreamDecoder alone, on the capture in memory
+ *   reader   FrameReader: file read by the reader thread, frames expanded into
+ *            the ring and taken by this thread, as a binding does
+ *
+ * Usage: vl53l7cx_reader_bench <capture.bin> [repeat]
+ */
+
+#include <chrono>
+#include <cinttypes>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iterator>
+#include <vector>
+#include "vl53l7cx_reader.hpp"
+
+static void report(const char *name, uint64_t frames, uint64_t bytes, double seconds)
+{
+    std::printf("%-8s %9" PRIu64 " frames %8.3f s %12.0f frames/s %9.1f MB/s\n", name, frames,
+            seconds, frames / seconds, bytes / seconds / 1e6);
+}
+
+int main(int argc, char **argv)
+{
+    if (argc < 2) {
+        std::fprintf(stderr, "Usage: %s <capture.bin> [repeat]\n", argv[0]);
+        return 2;
+    }
+    int repeat = (argc >= 3) ? std::atoi(argv[2]) : 10;
+
+    std::ifstream file(argv[1], std::ios::binary);
+    if (!file) {
+        std::perror(argv[1]);
+        return 1;
+    }
+    std::vector<uint8_t> data((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+
+    // Decoder only: a new decoder per pass, so every pass starts unsynced
+    uint64_t frames = 0;
+    uint64_t checksum = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (int r = 0; r < repeat; r++) {
+        vl53l7cx::StreamDecoder decoder;
+        decoder.feed(data.data(), data.size(), [&](const vl53l7cx::FrameView &frame) {
+            checksum += frame.sequence();
+        });
+        frames += decoder.stats().frames;
+    }
+    report("decoder", frames, data.size() * static_cast<uint64_t>(repeat),
+            std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count());
+
+    // Reader thread and ring, frames taken in batches
+    std::vector<vl53l7cx::ReaderFrame> batch(64);
+    frames = 0;
+    start = std::chrono::steady_clock::now();
+    for (int r = 0; r < repeat; r++) {
+        vl53l7cx::FrameReader reader(batch.size());
+        if (!reader.open(argv[1])) {
+            std::perror(argv[1]);
+            return 1;
+        }
+        int nb_frames;
+        while ((nb_frames = reader.read(batch.data(), batch.size(), -1)) > 0) {
+            for (int i = 0; i < nb_frames; i++) {
+                checksum += batch[i].sequence;
+            }
+            frames += static_cast<uint64_t>(nb_frames);
+        }
+    }
+    report("reader", frames, data.size() * static_cast<uint64_t>(repeat),
+            std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count());
+
+    std::printf("(checksum %" PRIu64 ")\n", checksum);
+    return 0;
+}
@@ -0,0 +1,106 @@
+/**
+ * VL53L7CX Recording Capture
+ *
+ * Reads binary frames (vl53l7cx_stream.h) from the Pico 2 USB serial port, or
+ * from a captured stream, and writes them into a recording
+ * (vl53l7cx_recording.h). The layout of the recording is the one of the first
+ * frame; frames of another layout are skipped. Ctrl-C ends the recording
+ * (index and trailer written).
+ *
+ * Usage: vl53l7cx_record <device|stream.bin> <recording> [--frames N]
+ */
+
+#include <cinttypes>
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
+#include <termios.h>
+#include <unistd.h>
+#include "vl53l7cx_recording.hpp"
+
+static volatile std::sig_atomic_t stop_requested = 0;
+
+static void on_signal(int)
+{
+    stop_requested = 1;
+}
+
+int main(int argc, char **argv)
+{
+    const char *paths[2] = {nullptr, nullptr};
+    size_t nb_paths = 0;
+    uint64_t max_frames = UINT64_MAX;
+
+    for (int i = 1; i < argc; i++) {
+        if (std::strcmp(argv[i], "--frames") == 0 && i + 1 < argc) {
+            max_frames = std::strtoull(argv[++i], nullptr, 10);
+        } else if (nb_paths < 2) {
+            paths[nb_paths++] = argv[i];
+        }
+    }
+    if (nb_paths != 2) {
+        std::fprintf(stderr, "Usage: %s <device|stream.bin> <recording> [--frames N]\n", argv[0]);
+        return 2;
+    }
+
+    int fd = open(paths[0], O_RDONLY | O_NOCTTY);
+    if (fd < 0) {
+        std::perror(paths[0]);
+        return 1;
+    }
+
+    // Serial port: raw mode, so no byte of a frame is translated or eaten
+    struct termios tio;
+    if (isatty(fd) && tcgetattr(fd, &tio) == 0) {
+        cfmakeraw(&tio);
+        tcsetattr(fd, TCSANOW, &tio);
+    }
+
+    std::signal(SIGINT, on_signal);
+
+    vl53l7cx::StreamDecoder decoder;
+    vl53l7cx::RecordingWriter writer;
+    bool opened = false;
+    bool failed = false;
+    uint64_t skipped = 0;
+    uint8_t chunk[4096];
+
+    while (!stop_requested && !failed && writer.size() < max_frames) {
+        ssize_t nb_read = read(fd, chunk, sizeof(chunk));
+        if (nb_read <= 0) {
+            break;      // End of file, device unplugged or interrupted
+        }
+
+        decoder.feed(chunk, static_cast<size_t>(nb_read), [&](const vl53l7cx::FrameView &frame) {
+            if (failed || writer.size() >= max_frames) {
+                return;
+            }
+            if (!opened) {
+                // No sensor block: the stream does not carry the configuration
+                if (!writer.open(paths[1], frame.resolution(), frame.nb_targets(),
+                        frame.field_mask(), {}, frame.timestamp_us())) {
+                    std::perror(paths[1]);
+                    failed = true;
+                    return;
+                }
+                opened = true;
+            }
+            if (!writer.append(frame)) {
+                skipped++;
+            }
+        });
+    }
+    close(fd);
+
+    if (opened && !writer.close()) {
+        std::perror(paths[1]);
+        failed = true;
+    }
+    const vl53l7cx::StreamStats &stats = decoder.stats();
+    std::fprintf(stderr, "%zu frames recorded, %" PRIu64 " skipped, %" PRIu64 " lost, %"
+            PRIu64 " bad CRC\n", writer.size(), skipped, stats.lost, stats.bad_crc);
+
+    return failed ? 1 : 0;
+}
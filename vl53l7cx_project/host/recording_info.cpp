@@ -0,0 +1,155 @@
+/**
+ * VL53L7CX Recording Info
+ *
+ * Prints the header of a recording (vl53l7cx_recording.h) and seeks in it.
+ *
+ * Usage: vl53l7cx_recording_info <recording> [--verify] [--at <s>] [--frame <n>] [--bench]
+ *   --verify  check the CRC of every record
+ *   --at      print the first frame at or after s seconds from the start
+ *   --frame   print frame n
+ *   --bench   time random frame accesses and timestamp lookups
+ */
+
+#include <chrono>
+#include <cinttypes>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include "vl53l7cx_recording.hpp"
+
+static void print_frame(const vl53l7cx::Recording &recording, size_t i)
+{
+    vl53l7cx::FrameView frame;
+    if (!recording.frame(i, frame)) {
+        std::printf("frame %zu: corrupted or out of range\n", i);
+        return;
+    }
+    std::printf("frame %zu: sensor %u t=%" PRIu64 " us (+%.3f s), %d degC\n", i, frame.sensor(),
+            frame.timestamp_us(), (frame.timestamp_us() - recording.start_time_us()) / 1e6,
+            frame.silicon_temp_degc());
+
+    const auto &distance = frame.distance_mm();
+    if (distance.empty()) {
+        return;
+    }
+    size_t width = (frame.resolution() == 64) ? 8 : 4;
+    for (size_t row = 0; row < width; row++) {
+        std::printf("  ");
+        for (size_t col = 0; col < width; col++) {
+            std::printf("%5d", distance[(row * width + col) * frame.nb_targets()]);
+        }
+        std::printf("\n");
+    }
+}
+
+static void bench(const vl53l7cx::Recording &recording)
+{
+    constexpr size_t kLookups = 1000000;
+    std::mt19937_64 random(1);
+    uint64_t first = recording.timestamp_us(0);
+    uint64_t span = recording.timestamp_us(recording.size() - 1) - first + 1;
+    uint64_t checksum = 0;
+
+    auto start = std::chrono::steady_clock::now();
+    for (size_t k = 0; k < kLookups; k++) {
+        vl53l7cx::FrameView frame;
+        if (recording.frame(random() % recording.size(), frame)) {
+            checksum += frame.distance_mm().empty() ? 0 : frame.distance_mm()[0];
+        }
+    }
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    std::printf("random frames  %.0f /s (%.0f ns each)\n", kLookups / seconds, seconds / kLookups * 1e9);
+
+    start = std::chrono::steady_clock::now();
+    for (size_t k = 0; k < kLookups; k++) {
+        checksum += recording.find(first + random() % span);
+    }
+    seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    std::printf("time lookups   %.0f /s (%.0f ns each)\n", kLookups / seconds, seconds / kLookups * 1e9);
+    std::printf("(checksum %" PRIu64 ")\n", checksum);
+}
+
+int main(int argc, char **argv)
+{
+    const char *path = nullptr;
+    bool verify = false;
+    bool run_bench = false;
+    double at_s = -1.0;
+    long frame_number = -1;
+
+    for (int i = 1; i < argc; i++) {
+        if (std::strcmp(argv[i], "--verify") == 0) {
+            verify = true;
+        } else if (std::strcmp(argv[i], "--bench") == 0) {
+            run_bench = true;
+        } else if (std::strcmp(argv[i], "--at") == 0 && i + 1 < argc) {
+            at_s = std::atof(argv[++i]);
+        } else if (std::strcmp(argv[i], "--frame") == 0 && i + 1 < argc) {
+            frame_number = std::atol(argv[++i]);
+        } else {
+            path = argv[i];
+        }
+    }
+    if (!path) {
+        std::fprintf(stderr, "Usage: %s <recording> [--verify] [--at <s>] [--frame <n>] [--bench]\n",
+                argv[0]);
+        return 2;
+    }
+
+    vl53l7cx::Recording recording;
+    switch (recording.open(path)) {
+    case vl53l7cx::Recording::Status::kOk:
+        break;
+    case vl53l7cx::Recording::Status::kIoError:
+        std::perror(path);
+        return 1;
+    case vl53l7cx::Recording::Status::kBadVersion:
+        std::fprintf(stderr, "%s: unsupported recording version\n", path);
+        return 1;
+    default:
+        std::fprintf(stderr, "%s: not a recording, or corrupted header\n", path);
+        return 1;
+    }
+
+    std::printf("%s: %zu frames%s, %u zones, %u targets, fields 0x%04x, %zu bytes per frame\n", path,
+            recording.size(), recording.complete() ? "" : " (not ended, recovered)",
+            recording.resolution(), recording.nb_targets(), recording.field_mask(),
+            recording.record_size());
+    if (recording.size() > 0) {
+        std::printf("duration %.3f s\n",
+                (recording.timestamp_us(recording.size() - 1) - recording.timestamp_us(0)) / 1e6);
+    }
+    for (const vl53l7cx::RecordingSensor &sensor : recording.sensors()) {
+        std::printf("sensor %u: I2C 0x%02x, mode %u, %u Hz, %" PRIu32 " ms, order %u, sharpener %u%%, %s\n",
+                sensor.sensor, sensor.i2c_address, sensor.ranging_mode, sensor.frequency_hz,
+                sensor.integration_time_ms, sensor.target_order, sensor.sharpener_percent,
+                sensor.calibration ? "calibrated" : "no calibration");
+    }
+
+    int status = 0;
+    if (verify) {
+        size_t bad = 0;
+        for (size_t i = 0; i < recording.size(); i++) {
+            vl53l7cx::FrameView frame;
+            if (!recording.frame(i, frame)) {
+                std::printf("frame %zu: corrupted\n", i);
+                bad++;
+            }
+        }
+        std::printf("%zu corrupted frames\n", bad);
+        status = (bad == 0) ? 0 : 1;
+    }
+    if (at_s >= 0.0 && recording.size() > 0) {
+        print_frame(recording, recording.find(recording.start_time_us()
+                + static_cast<uint64_t>(at_s * 1e6)));
+    }
+    if (frame_number >= 0) {
+        print_frame(recording, static_cast<size_t>(frame_number));
+    }
+    if (run_bench && recording.size() > 0) {
+        bench(recording);
+    }
+
+    return status;
+}
@@ -0,0 +1,214 @@
+/**
+ * VL53L7CX Recording Replay
+ *
+ * Replays the frames of a recording (vl53l7cx_recording.h) through the
+ * unchanged driver on a host machine (see vl53l7cx_replay.hpp), as the
+ * firmware reads them: vl53l7cx_check_data_ready(), then
+ * vl53l7cx_get_ranging_data() or the asynchronous read. Each frame decoded by
+ * the driver is compared with its record, and can be written into a new
+ * recording by the firmware recorder (vl53l7cx_recording.c).
+ *
+ * Usage: vl53l7cx_replay <recording> [--sensor n] [--pacing realtime|fixed|fastest]
+ *        [--speed x] [--rate hz] [--corrupt-every n] [--async] [--out <recording>]
+ *   --pacing         frame release (default realtime)
+ *   --speed          device clock speed, real time = 1 (default 1)
+ *   --rate           frame rate of the fixed pacing (default 15)
+ *   --corrupt-every  serve every nth frame with a wrong footer id
+ *   --async          read frames with vl53l7cx_start/finish_ranging_data_read()
+ *   --out            record the decoded frames
+ *
+ * The exit status is 1 if a frame decoded without error differs from its
+ * record, or if a corrupted frame was not reported by the driver.
+ */
+
+#include <chrono>
+#include <cinttypes>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include "vl53l7cx_replay.hpp"
+
+extern "C" {
+#include "vl53l7cx_recording.h"
+}
+
+/* Fields of the mask which differ between a record and decoded results */
+static uint16_t compare(const vl53l7cx::FrameView &frame, const VL53L7CX_ResultsData &results)
+{
+    VL53L7CX_ResultsData expected;
+    std::memcpy(&expected, &results, sizeof(expected));
+    vl53l7cx::results_from_frame(frame, expected);
+
+    size_t zones = frame.resolution();
+    size_t targets = zones * VL53L7CX_NB_TARGET_PER_ZONE;
+    uint16_t diff = 0;
+    auto check = [&](uint16_t field, const void *a, const void *b, size_t size) {
+        if ((frame.field_mask() & field) && std::memcmp(a, b, size) != 0) {
+            diff |= field;
+        }
+    };
+
+    check(VL53L7CX_OUTPUT_AMBIENT_PER_SPAD, expected.ambient_per_spad, results.ambient_per_spad,
+            zones * 4);
+    check(VL53L7CX_OUTPUT_NB_SPADS_ENABLED, expected.nb_spads_enabled, results.nb_spads_enabled,
+            zones * 4);
+    check(VL53L7CX_OUTPUT_NB_TARGET_DETECTED, expected.nb_target_detected,
+            results.nb_target_detected, zones);
+    check(VL53L7CX_OUTPUT_SIGNAL_PER_SPAD, expected.signal_per_spad, results.signal_per_spad,
+            targets * 4);
+    check(VL53L7CX_OUTPUT_RANGE_SIGMA_MM, expected.range_sigma_mm, results.range_sigma_mm,
+            targets * 2);
+    check(VL53L7CX_OUTPUT_DISTANCE_MM, expected.distance_mm, results.distance_mm, targets * 2);
+    check(VL53L7CX_OUTPUT_REFLECTANCE_PERCENT, expected.reflectance, results.reflectance, targets);
+    check(VL53L7CX_OUTPUT_TARGET_STATUS, expected.target_status, results.target_status, targets);
+    check(VL53L7CX_OUTPUT_MOTION_INDICATOR, &expected.motion_indicator, &results.motion_indicator,
+            sizeof(expected.motion_indicator));
+    if (expected.silicon_temp_degc != results.silicon_temp_degc) {
+        diff |= VL53L7CX_OUTPUT_MANDATORY;
+    }
+    return diff;
+}
+
+int main(int argc, char **argv)
+{
+    const char *path = nullptr;
+    const char *out_path = nullptr;
+    unsigned sensor = 0;
+    bool async = false;
+    vl53l7cx::ReplayOptions options;
+
+    for (int i = 1; i < argc; i++) {
+        if (std::strcmp(argv[i], "--sensor") == 0 && i + 1 < argc) {
+            sensor = static_cast<unsigned>(std::atoi(argv[++i]));
+        } else if (std::strcmp(argv[i], "--pacing") == 0 && i + 1 < argc) {
+            const char *pacing = argv[++i];
+            options.pacing = std::strcmp(pacing, "fastest") == 0 ? vl53l7cx::Pacing::kFastest
+                    : std::strcmp(pacing, "fixed") == 0 ? vl53l7cx::Pacing::kFixedRate
+                    : vl53l7cx::Pacing::kRealTime;
+        } else if (std::strcmp(argv[i], "--speed") == 0 && i + 1 < argc) {
+            options.speed = std::atof(argv[++i]);
+        } else if (std::strcmp(argv[i], "--rate") == 0 && i + 1 < argc) {
+            options.rate_hz = std::atof(argv[++i]);
+        } else if (std::strcmp(argv[i], "--corrupt-every") == 0 && i + 1 < argc) {
+            options.corrupt_every = static_cast<uint32_t>(std::atoi(argv[++i]));
+        } else if (std::strcmp(argv[i], "--async") == 0) {
+            async = true;
+        } else if (std::strcmp(argv[i], "--out") == 0 && i + 1 < argc) {
+            out_path = argv[++i];
+        } else {
+            path = argv[i];
+        }
+    }
+    if (!path) {
+        std::fprintf(stderr, "Usage: %s <recording> [--sensor n] [--pacing realtime|fixed|fastest] "
+                "[--speed x] [--rate hz] [--corrupt-every n] [--async] [--out <recording>]\n",
+                argv[0]);
+        return 2;
+    }
+
+    vl53l7cx::Recording recording;
+    if (recording.open(path) != vl53l7cx::Recording::Status::kOk) {
+        std::fprintf(stderr, "%s: cannot open recording\n", path);
+        return 1;
+    }
+    vl53l7cx::ReplayDevice device;
+    if (!device.open(recording, static_cast<uint8_t>(sensor), options)) {
+        std::fprintf(stderr, "%s: no frame of sensor %u, or %u targets per zone (build: %u)\n",
+                path, sensor, recording.nb_targets(), VL53L7CX_NB_TARGET_PER_ZONE);
+        return 1;
+    }
+
+    static VL53L7CX_Configuration dev;
+    static VL53L7CX_ResultsData results;
+    static VL53L7CX_Recording out;
+    static VL53L7CX_CalRecord calibration;
+    if (out_path) {
+        // Sensor block of the source, if any
+        VL53L7CX_RecordingSensor out_sensor = {};
+        out_sensor.sensor = static_cast<uint8_t>(sensor);
+        for (const vl53l7cx::RecordingSensor &source : recording.sensors()) {
+            if (source.sensor != sensor) {
+                continue;
+            }
+            out_sensor.ranging_mode = source.ranging_mode;
+            out_sensor.frequency_hz = source.frequency_hz;
+            out_sensor.target_order = source.target_order;
+            out_sensor.sharpener_percent = source.sharpener_percent;
+            out_sensor.i2c_address = source.i2c_address;
+            out_sensor.integration_time_ms = source.integration_time_ms;
+            if (source.calibration) {
+                std::memcpy(&calibration, source.calibration, sizeof(calibration));
+                out_sensor.p_calibration = &calibration;
+            }
+        }
+        if (vl53l7cx_recording_init_file(&out, out_path)
+                || vl53l7cx_recording_begin(&out, recording.resolution(), recording.field_mask(),
+                        &out_sensor, 1, recording.start_time_us())) {
+            std::perror(out_path);
+            return 1;
+        }
+    }
+    device.attach(dev);
+
+    uint64_t decoded = 0, reported_corrupted = 0, mismatches = 0, errors = 0;
+    auto start = std::chrono::steady_clock::now();
+    while (!device.finished()) {
+        uint8_t ready = 0;
+        if (vl53l7cx_check_data_ready(&dev, &ready) != VL53L7CX_STATUS_OK) {
+            errors++;
+        }
+        if (!ready) {
+            (void)VL53L7CX_WaitUs(&dev.platform, 1000);
+            continue;
+        }
+
+        uint8_t status;
+        if (async) {
+            status = vl53l7cx_start_ranging_data_read(&dev);
+            status |= vl53l7cx_finish_ranging_data_read(&dev, &results, 100);
+        } else {
+            status = vl53l7cx_get_ranging_data(&dev, &results);
+        }
+        if (status == VL53L7CX_STATUS_CORRUPTED_FRAME) {
+            reported_corrupted++;
+            continue;
+        }
+        if (status != VL53L7CX_STATUS_OK) {
+            errors++;
+            continue;
+        }
+
+        decoded++;
+        vl53l7cx::FrameView frame;
+        uint16_t diff = device.last_frame(frame) ? compare(frame, results) : 0xFFFF;
+        if (diff != 0) {
+            if (mismatches++ < 10) {
+                std::printf("frame %" PRIu64 ": fields 0x%04x differ\n", decoded, diff);
+            }
+        }
+        if (out_path && vl53l7cx_recording_add(&out, static_cast<uint8_t>(sensor), &dev, &results,
+                    recording.start_time_us() + device.time_us())) {
+            std::perror(out_path);
+            return 1;
+        }
+    }
+    double wall_s = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    double device_s = device.time_us() / 1e6;
+
+    if (out_path && vl53l7cx_recording_end(&out)) {
+        std::perror(out_path);
+        return 1;
+    }
+
+    const vl53l7cx::ReplayStats &stats = device.stats();
+    std::printf("%zu frames of sensor %u, %" PRIu64 " read, %" PRIu64 " overwritten\n",
+            device.size(), sensor, stats.frames, stats.overwritten);
+    std::printf("decoded %" PRIu64 ", mismatches %" PRIu64 ", corrupted %" PRIu64 " (%" PRIu64
+            " injected), errors %" PRIu64 ", %" PRIu64 " status polls\n", decoded, mismatches,
+            reported_corrupted, stats.corrupted, errors, stats.status_reads);
+    std::printf("%.3f s of sensor time in %.3f s: %.1fx real time, %.0f frames/s, %.2f us per frame\n",
+            device_s, wall_s, wall_s > 0 ? device_s / wall_s : 0.0, wall_s > 0 ? stats.frames / wall_s : 0.0,
+            stats.frames ? wall_s * 1e6 / stats.frames : 0.0);
+
+    return (mismatches == 0 && reported_corrupted == stats.corrupted) ? 0 : 1;
+}
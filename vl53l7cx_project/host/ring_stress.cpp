@@ -0,0 +1,233 @@
+/**
+ * VL53L7CX Results Ring Stress Test
+ *
+ * Runs the two sides of the results ring (vl53l7cx_results_ring.h) on two
+ * threads, as on the two RP2350 cores. The producer numbers each frame it
+ * tries to write (timestamp_us) and each frame it publishes (sequence, as
+ * main_multicore.c does), and fills the whole results structure with a byte
+ * pattern of the frame; the consumer checks every slot it reads:
+ *   full       one thread: VL53L7CX_RESULTS_RING_SIZE writes succeed, the next
+ *              ones fail and are counted as overruns, the slots are then read
+ *              in order
+ *   lossless   the producer waits while the ring is full: every frame is read
+ *              once, in order and whole, and no overrun is counted
+ *   overrun    the producer never waits and the consumer is slower: published
+ *              frames are read once, in order and whole, and the frames missing
+ *              from the consumer's view are exactly the overruns counted
+ *
+ * Usage: vl53l7cx_ring [--frames n]
+ *
+ * The exit status is 1 if a check fails. Build with
+ * -DCMAKE_C_FLAGS=-fsanitize=thread -DCMAKE_CXX_FLAGS=-fsanitize=thread to
+ * check the ring for data races as well.
+ */
+
+#include <atomic>
+#include <chrono>
+#include <cinttypes>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <thread>
+#include "vl53l7cx_check.hpp"
+
+extern "C" {
+#include "vl53l7cx_results_ring.h"
+}
+
+namespace {
+
+using vl53l7cx::check;
+
+/* Producer side of a slot: the byte pattern of the attempt */
+void fill(VL53L7CX_ResultsSlot &slot, uint32_t attempt, uint32_t sequence)
+{
+    std::memset(&slot.results, static_cast<uint8_t>(attempt), sizeof(slot.results));
+    slot.timestamp_us = attempt;
+    slot.sequence = sequence;
+    slot.status = static_cast<uint8_t>(attempt >> 8);
+    slot.streamcount = static_cast<uint8_t>(attempt);
+}
+
+/* Consumer side: the slot holds one attempt only */
+bool whole(const VL53L7CX_ResultsSlot &slot)
+{
+    uint32_t attempt = static_cast<uint32_t>(slot.timestamp_us);
+    const uint8_t *bytes = reinterpret_cast<const uint8_t *>(&slot.results);
+    uint8_t pattern = static_cast<uint8_t>(attempt);
+    for (size_t i = 0; i < sizeof(slot.results); i++) {
+        if (bytes[i] != pattern) {
+            return false;
+        }
+    }
+    return slot.status == static_cast<uint8_t>(attempt >> 8) && slot.streamcount == pattern;
+}
+
+struct Consumed {
+    uint32_t frames = 0;
+    uint32_t out_of_order = 0;      // Sequence not the next one
+    uint32_t torn = 0;
+    uint32_t missing = 0;           // Attempts skipped between two frames
+    uint32_t next_attempt = 0;
+};
+
+/* Busy work standing for the acquisition or the use of a frame */
+void spin(unsigned loops)
+{
+    for (volatile unsigned i = 0; i < loops; i = i + 1) {
+    }
+}
+
+/* Read up to nb_frames published frames in all; delay_loops of busy work per
+ * frame */
+void consume(VL53L7CX_ResultsRing &ring, uint32_t nb_frames, unsigned delay_loops,
+        Consumed &consumed)
+{
+    while (consumed.frames < nb_frames) {
+        VL53L7CX_ResultsSlot *p_slot = vl53l7cx_results_ring_begin_read(&ring);
+        if (!p_slot) {
+            std::this_thread::yield();
+            continue;
+        }
+        uint32_t attempt = static_cast<uint32_t>(p_slot->timestamp_us);
+        consumed.out_of_order += p_slot->sequence != consumed.frames ? 1 : 0;
+        consumed.torn += whole(*p_slot) ? 0 : 1;
+        if (attempt >= consumed.next_attempt) {
+            consumed.missing += attempt - consumed.next_attempt;
+        } else {
+            consumed.out_of_order++;
+        }
+        consumed.next_attempt = attempt + 1;
+        spin(delay_loops);
+        vl53l7cx_results_ring_end_read(&ring);
+        consumed.frames++;
+    }
+}
+
+VL53L7CX_ResultsRing ring;
+
+/* Full: one thread, fixed number of failed writes */
+bool run_full()
+{
+    const uint32_t extra = 3;
+    vl53l7cx_results_ring_init(&ring);
+    uint32_t written = 0, refused = 0;
+    for (uint32_t attempt = 0; attempt < VL53L7CX_RESULTS_RING_SIZE + extra; attempt++) {
+        VL53L7CX_ResultsSlot *p_slot = vl53l7cx_results_ring_begin_write(&ring);
+        if (!p_slot) {
+            refused++;
+            continue;
+        }
+        fill(*p_slot, attempt, written++);
+        vl53l7cx_results_ring_end_write(&ring);
+    }
+    uint32_t count = vl53l7cx_results_ring_count(&ring);
+
+    Consumed consumed;
+    consume(ring, written, 0, consumed);
+    VL53L7CX_ResultsRingStats stats;
+    vl53l7cx_results_ring_get_stats(&ring, &stats);
+    return check("full", written == VL53L7CX_RESULTS_RING_SIZE && refused == extra
+            && count == VL53L7CX_RESULTS_RING_SIZE && stats.overruns == extra
+            && consumed.out_of_order == 0 && consumed.torn == 0 && consumed.missing == 0
+            && vl53l7cx_results_ring_begin_read(&ring) == nullptr
+            && vl53l7cx_results_ring_count(&ring) == 0);
+}
+
+/* Two threads: nb_attempts frames offered by the producer, which waits for a
+ * free slot when wait is set; busy work of each side per frame */
+bool run_threads(const char *name, uint32_t nb_attempts, bool wait, unsigned producer_loops,
+        unsigned consumer_loops)
+{
+    vl53l7cx_results_ring_init(&ring);
+    std::atomic<uint32_t> published(0);
+    std::atomic<bool> done(false);
+    uint32_t refused = 0;
+
+    auto start = std::chrono::steady_clock::now();
+    std::thread producer([&] {
+        uint32_t sequence = 0;
+        for (uint32_t attempt = 0; attempt < nb_attempts; attempt++) {
+            VL53L7CX_ResultsSlot *p_slot = nullptr;
+            spin(producer_loops);
+            while (wait && vl53l7cx_results_ring_count(&ring) >= VL53L7CX_RESULTS_RING_SIZE) {
+                std::this_thread::yield();
+            }
+            p_slot = vl53l7cx_results_ring_begin_write(&ring);
+            if (!p_slot) {
+                refused++;
+                continue;
+            }
+            fill(*p_slot, attempt, sequence++);
+            vl53l7cx_results_ring_end_write(&ring);
+        }
+        published.store(sequence);
+        done.store(true);
+    });
+
+    // Read until the producer is done and every published frame was read
+    Consumed consumed;
+    for (;;) {
+        bool finished = done.load();
+        uint32_t available = vl53l7cx_results_ring_count(&ring);
+        if (finished && consumed.frames >= published.load()) {
+            break;
+        }
+        if (available == 0) {
+            std::this_thread::yield();
+            continue;
+        }
+        consume(ring, consumed.frames + available, consumer_loops, consumed);
+    }
+    producer.join();
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start)
+            .count();
+
+    VL53L7CX_ResultsRingStats stats;
+    vl53l7cx_results_ring_get_stats(&ring, &stats);
+    // Attempts after the last frame read are not seen by the consumer
+    uint32_t unseen = nb_attempts - consumed.next_attempt;
+
+    std::printf("  %" PRIu32 " frames offered, %" PRIu32 " read, %" PRIu32 " overruns, %"
+            PRIu32 " missing, %u out of order, %u torn, %.2f Mframes/s\n", nb_attempts,
+            consumed.frames, stats.overruns, consumed.missing + unseen, consumed.out_of_order,
+            consumed.torn, seconds > 0 ? nb_attempts / seconds / 1e6 : 0.0);
+
+    bool ok = consumed.out_of_order == 0 && consumed.torn == 0
+            && stats.published == published.load() && stats.consumed == stats.published
+            && stats.overruns == refused && stats.published + stats.overruns == nb_attempts
+            && consumed.missing + unseen == stats.overruns;
+    if (wait) {
+        ok &= stats.overruns == 0 && consumed.frames == nb_attempts;
+    } else {
+        ok &= stats.overruns > 0 && consumed.frames > 0;
+    }
+    return check(name, ok);
+}
+
+} // namespace
+
+int main(int argc, char **argv)
+{
+    uint32_t nb_frames = 1000000;
+
+    for (int i = 1; i < argc; i++) {
+        if (std::strcmp(argv[i], "--frames") == 0 && i + 1 < argc) {
+            nb_frames = static_cast<uint32_t>(std::atol(argv[++i]));
+        } else {
+            std::fprintf(stderr, "Usage: %s [--frames n]\n", argv[0]);
+            return 2;
+        }
+    }
+    if (nb_frames == 0) {
+        std::fprintf(stderr, "The number of frames must not be 0\n");
+        return 2;
+    }
+
+    std::printf("%u slots of %zu bytes\n", VL53L7CX_RESULTS_RING_SIZE,
+            sizeof(VL53L7CX_ResultsSlot));
+    bool ok = run_full();
+    ok &= run_threads("lossless", nb_frames, true, 0, 0);
+    ok &= run_threads("overrun", nb_frames, false, 100, 150);
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,242 @@
+/**
+ * VL53L7CX Driver Benchmark on the Simulated Device
+ *
+ * Runs the driver (src/vl53l7cx_api.c) against the register-level simulator
+ * (vl53l7cx_simulator.hpp) and reports, for each step, the time on the device
+ * clock (I2C transfers at --i2c-hz and waits of the driver), the bus traffic
+ * and the host time:
+ *   cold init     vl53l7cx_init(): reboot, firmware download, configuration
+ *   dci read      vl53l7cx_get_ranging_frequency_hz()
+ *   dci write     vl53l7cx_set_ranging_frequency_hz()
+ *   dci cache     vl53l7cx_set_sharpener_percent() on the shadow cache: one
+ *                 miss, then hits; the block on the sensor must match
+ *   dci uncached  the same, with the cache invalidated before each call
+ *   resolution    vl53l7cx_set_resolution()
+ *   start         vl53l7cx_start_ranging()
+ *   frames        vl53l7cx_check_data_ready() every --poll-us, then
+ *                 vl53l7cx_get_ranging_data(); each frame is checked against
+ *                 the scene
+ *   stop          vl53l7cx_stop_ranging()
+ *   warm init     vl53l7cx_init_warm() on a new configuration (host reset)
+ *   power cycle   vl53l7cx_init_warm() after a power cycle (cold init)
+ *
+ * Usage: vl53l7cx_sim_bench [--i2c-hz hz] [--resolution 4|8] [--freq hz]
+ *        [--frames n] [--poll-us us]
+ *
+ * The exit status is 1 if a step fails, a frame differs from the scene, or the
+ * cache counters or the cached block are wrong.
+ */
+
+#include <chrono>
+#include <cinttypes>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+#include "vl53l7cx_simulator.hpp"
+#include "vl53l7cx_check.hpp"
+
+namespace {
+
+using vl53l7cx::compare;
+
+struct Step {
+    vl53l7cx::SimulatedDevice &device;
+    std::chrono::steady_clock::time_point wall;
+    uint64_t device_us;
+    vl53l7cx::SimulatorStats stats;
+
+    explicit Step(vl53l7cx::SimulatedDevice &d)
+        : device(d), wall(std::chrono::steady_clock::now()), device_us(d.time_us()),
+          stats(d.stats())
+    {
+    }
+
+    /* Time and traffic since the step began, per call */
+    void report(const char *name, uint8_t status, unsigned calls = 1) const
+    {
+        double wall_us = std::chrono::duration<double, std::micro>(
+                std::chrono::steady_clock::now() - wall).count();
+        const vl53l7cx::SimulatorStats &now = device.stats();
+        std::printf("%-12s %10.1f us %9.1f us bus %9" PRIu64 " bytes %4" PRIu64
+                " cmds %5" PRIu64 " polls %9.2f us host%s\n", name,
+                double(device.time_us() - device_us) / calls,
+                double(now.bus_us - stats.bus_us) / calls,
+                (now.bytes_read + now.bytes_written - stats.bytes_read - stats.bytes_written) / calls,
+                (now.commands - stats.commands) / calls,
+                (now.status_polls - stats.status_polls) / calls, wall_us / calls,
+                status ? "  FAILED" : "");
+    }
+};
+
+} // namespace
+
+int main(int argc, char **argv)
+{
+    vl53l7cx::SimulatorOptions options;
+    uint8_t resolution = VL53L7CX_RESOLUTION_8X8;
+    unsigned frequency_hz = 15;
+    unsigned nb_frames = 100;
+    uint32_t poll_us = 1000;
+
+    for (int i = 1; i < argc; i++) {
+        if (std::strcmp(argv[i], "--i2c-hz") == 0 && i + 1 < argc) {
+            options.i2c_hz = static_cast<uint32_t>(std::atol(argv[++i]));
+        } else if (std::strcmp(argv[i], "--resolution") == 0 && i + 1 < argc) {
+            resolution = std::atoi(argv[++i]) == 4 ? VL53L7CX_RESOLUTION_4X4
+                    : VL53L7CX_RESOLUTION_8X8;
+        } else if (std::strcmp(argv[i], "--freq") == 0 && i + 1 < argc) {
+            frequency_hz = static_cast<unsigned>(std::atoi(argv[++i]));
+        } else if (std::strcmp(argv[i], "--frames") == 0 && i + 1 < argc) {
+            nb_frames = static_cast<unsigned>(std::atoi(argv[++i]));
+        } else if (std::strcmp(argv[i], "--poll-us") == 0 && i + 1 < argc) {
+            poll_us = static_cast<uint32_t>(std::atol(argv[++i]));
+        } else {
+            std::fprintf(stderr, "Usage: %s [--i2c-hz hz] [--resolution 4|8] [--freq hz] "
+                    "[--frames n] [--poll-us us]\n", argv[0]);
+            return 2;
+        }
+    }
+
+    vl53l7cx::SimulatedDevice device(options);
+    static VL53L7CX_Configuration dev;
+    static VL53L7CX_ResultsData results, expected;
+    dev.platform.address = VL53L7CX_DEFAULT_I2C_ADDRESS;
+    device.attach(dev);
+    bool failed = false;
+
+    std::printf("I2C at %u kHz, %ux%u, %u Hz\n", options.i2c_hz / 1000,
+            resolution == VL53L7CX_RESOLUTION_4X4 ? 4 : 8,
+            resolution == VL53L7CX_RESOLUTION_4X4 ? 4 : 8, frequency_hz);
+
+    Step cold(device);
+    uint8_t status = vl53l7cx_init(&dev);
+    cold.report("cold init", status);
+    failed |= status != VL53L7CX_STATUS_OK;
+
+    const unsigned kCalls = 100;
+    uint8_t value = 0;
+    Step read(device);
+    status = 0;
+    for (unsigned i = 0; i < kCalls; i++) {
+        status |= vl53l7cx_get_ranging_frequency_hz(&dev, &value);
+    }
+    read.report("dci read", status, kCalls);
+    failed |= status != VL53L7CX_STATUS_OK;
+
+    Step write(device);
+    status = 0;
+    for (unsigned i = 0; i < kCalls; i++) {
+        status |= vl53l7cx_set_ranging_frequency_hz(&dev, static_cast<uint8_t>(frequency_hz));
+    }
+    write.report("dci write", status, kCalls);
+    failed |= status != VL53L7CX_STATUS_OK;
+
+    // Shadow cache: replaces of a cached block skip the read of the block
+    uint32_t hits = 0, misses = 0, hits_after = 0, misses_after = 0;
+    std::vector<uint8_t> block;
+    status = vl53l7cx_dci_cache_invalidate(&dev);
+    status |= vl53l7cx_get_dci_cache_stats(&dev, &hits, &misses);
+    Step cached(device);
+    for (unsigned i = 0; i < kCalls; i++) {
+        status |= vl53l7cx_set_sharpener_percent(&dev, static_cast<uint8_t>(i % 100));
+    }
+    cached.report("dci cache", status, kCalls);
+    status |= vl53l7cx_get_dci_cache_stats(&dev, &hits_after, &misses_after);
+    bool coherent = device.dci_block(VL53L7CX_DCI_SHARPENER, block) && block.size() > 0xD
+            && block[0xD] == static_cast<uint8_t>(((kCalls - 1) % 100) * 255 / 100);
+    bool counted = misses_after - misses == 1 && hits_after - hits == kCalls - 1;
+
+    Step uncached(device);
+    for (unsigned i = 0; i < kCalls; i++) {
+        status |= vl53l7cx_dci_cache_invalidate(&dev);
+        status |= vl53l7cx_set_sharpener_percent(&dev, static_cast<uint8_t>(i % 100));
+    }
+    uncached.report("dci uncached", status, kCalls);
+    std::printf("  cached: %" PRIu32 " hits, %" PRIu32 " misses, sensor block %s\n",
+            hits_after - hits, misses_after - misses, coherent ? "matches" : "DIFFERS");
+    status |= vl53l7cx_get_dci_cache_stats(&dev, &hits, &misses);
+    counted &= misses - misses_after == kCalls && hits == hits_after;
+    std::printf("  uncached: %" PRIu32 " hits, %" PRIu32 " misses\n", hits - hits_after,
+            misses - misses_after);
+    failed |= status != VL53L7CX_STATUS_OK || !coherent || !counted;
+
+    Step set_resolution(device);
+    status = vl53l7cx_set_resolution(&dev, resolution);
+    set_resolution.report("resolution", status);
+    failed |= status != VL53L7CX_STATUS_OK;
+
+    Step start(device);
+    status = vl53l7cx_start_ranging(&dev);
+    start.report("start", status);
+    failed |= status != VL53L7CX_STATUS_OK;
+
+    device.reset_stats();
+    Step frames(device);
+    uint64_t start_us = device.time_us(), first_frame_us = 0;
+    unsigned decoded = 0, mismatches = 0;
+    status = 0;
+    while (!failed && decoded < nb_frames) {
+        uint8_t ready = 0;
+        status |= vl53l7cx_check_data_ready(&dev, &ready);
+        if (!ready) {
+            (void)VL53L7CX_WaitUs(&dev.platform, poll_us);
+            if (device.time_us() - start_us > 10000000ULL + nb_frames * 1000000ULL) {
+                status |= VL53L7CX_STATUS_TIMEOUT_ERROR;
+                break;
+            }
+            continue;
+        }
+        status |= vl53l7cx_get_ranging_data(&dev, &results);
+        if (decoded++ == 0) {
+            first_frame_us = device.time_us() - start_us;
+        }
+        if (!device.last_frame(expected) || compare(expected, results, device.resolution())) {
+            mismatches++;
+        }
+    }
+    frames.report("frames", status, decoded ? decoded : 1);
+    failed |= status != VL53L7CX_STATUS_OK || mismatches != 0;
+
+    const vl53l7cx::SimulatorStats &stats = device.stats();
+    std::printf("  %u frames of %u bytes, %u mismatches, first after %.1f ms, "
+            "latency %.1f us (max %" PRIu64 " us), %" PRIu64 " overwritten\n", decoded,
+            device.frame_size(), mismatches, first_frame_us / 1e3,
+            stats.frames_read ? double(stats.frame_latency_us) / stats.frames_read : 0.0,
+            stats.max_frame_latency_us, stats.overwritten);
+
+    Step stop(device);
+    status = vl53l7cx_stop_ranging(&dev);
+    stop.report("stop", status);
+    failed |= status != VL53L7CX_STATUS_OK || device.ranging();
+
+    // Host reset: a new configuration structure on the running sensor
+    static VL53L7CX_Configuration warm_dev;
+    VL53L7CX_InitReport report;
+    warm_dev.platform.address = VL53L7CX_DEFAULT_I2C_ADDRESS;
+    device.attach(warm_dev);
+    Step warm(device);
+    status = vl53l7cx_init_warm(&warm_dev);
+    warm.report("warm init", status);
+    (void)vl53l7cx_get_init_report(&warm_dev, &report);
+    failed |= status != VL53L7CX_STATUS_OK || report.path != VL53L7CX_INIT_WARM;
+
+    // Power cycle: no firmware, the warm init falls back to a cold one
+    static VL53L7CX_Configuration cold_dev;
+    cold_dev.platform.address = VL53L7CX_DEFAULT_I2C_ADDRESS;
+    device.attach(cold_dev);
+    device.power_cycle();
+    Step power(device);
+    status = vl53l7cx_init_warm(&cold_dev);
+    power.report("power cycle", status);
+    (void)vl53l7cx_get_init_report(&cold_dev, &report);
+    std::printf("  path %s, warm reject %u\n",
+            report.path == VL53L7CX_INIT_WARM ? "warm" : "cold", report.warm_reject);
+    failed |= status != VL53L7CX_STATUS_OK || report.path != VL53L7CX_INIT_COLD;
+
+    if (device.stats().command_errors) {
+        std::printf("%" PRIu64 " commands rejected by the device\n", device.stats().command_errors);
+        failed = true;
+    }
+    return failed ? 1 : 0;
+}
@@ -0,0 +1,229 @@
+/**
+ * VL53L7CX Delta Coding Benchmark
+ *
+ * Replays the distances of a captured stream (or of a synthetic scene) through
+ * the firmware delta coder (vl53l7cx_delta.c, built as is), for several
+ * keyframe intervals, and reports the size on the wire and the coding time.
+ * Every coded frame is decoded again by the host decoder and compared.
+ *
+ * Usage: vl53l7cx_stream_bench <capture.bin>
+ *        vl53l7cx_stream_bench --synthetic [nb_frames]
+ *
+ * A capture is the raw byte stream of the Pico (see vl53l7cx_stream_dump
+ * --save). Times are host times: the coder is a byte loop with no division or
+ * table, so relative costs carry over to the Cortex-M33, absolute ones do not.
+ * The exit status is 1 if a decoded frame differs from the one coded.
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <cinttypes>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <map>
+#include <random>
+#include <vector>
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define HAVE_RDTSC 1
+#endif
+#include "vl53l7cx_stream.hpp"
+extern "C" {
+#include "vl53l7cx_delta.h"
+}
+
+/* Calls per coded frame, for timing */
+constexpr int kRepeat = 100;
+
+using Frame = std::vector<int16_t>;
+
+/* Frames of each sensor, in order */
+using Sequences = std::map<uint8_t, std::vector<Frame>>;
+
+static bool load_capture(const char *path, Sequences &sequences)
+{
+    std::ifstream file(path, std::ios::binary);
+    if (!file) {
+        std::perror(path);
+        return false;
+    }
+    std::vector<uint8_t> data((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+
+    vl53l7cx::StreamDecoder decoder;
+    decoder.feed(data.data(), data.size(), [&](const vl53l7cx::FrameView &frame) {
+        const auto &distance = frame.distance_mm();
+        if (!distance.empty()) {
+            Frame values(distance.size());
+            distance.copy_to(values.data());
+            sequences[frame.sensor()].push_back(std::move(values));
+        }
+    });
+
+    const auto &stats = decoder.stats();
+    std::printf("Capture: %" PRIu64 " frames, %" PRIu64 " lost, %" PRIu64 " bad CRC\n",
+            stats.frames, stats.lost, stats.bad_crc);
+    return true;
+}
+
+/*
+ * Static scene: a wall at 1.5 m seen by an 8x8 sensor, zone noise of 2 mm
+ * (sigma), a few zones flickering between valid and invalid, and an object
+ * crossing the field of view for one second out of five.
+ */
+static void make_synthetic(size_t nb_frames, Sequences &sequences)
+{
+    std::mt19937 rng(53);
+    std::normal_distribution<double> noise(0.0, 2.0);
+    std::uniform_real_distribution<double> uniform(0.0, 1.0);
+
+    for (size_t f = 0; f < nb_frames; f++) {
+        Frame values(64);
+        double t = static_cast<double>(f % 75) / 15.0;     // 15 Hz, 5 s cycle
+        for (int zone = 0; zone < 64; zone++) {
+            int row = zone / 8;
+            int col = zone % 8;
+            double distance = 1500.0 + 25.0 * std::hypot(row - 3.5, col - 3.5);
+            if (t < 1.0 && std::abs(col - t * 8.0) < 1.5 && row > 1 && row < 6) {
+                distance = 450.0;
+            }
+            if (zone % 19 == 7 && uniform(rng) < 0.2) {
+                distance = 0.0;     // Invalid zone
+            }
+            values[zone] = static_cast<int16_t>(std::lround(distance + noise(rng)));
+        }
+        sequences[0].push_back(std::move(values));
+    }
+}
+
+/* Packet of a frame with distances and status, framed (vl53l7cx_stream.h) */
+static double frame_bytes(double distance_bytes, size_t count)
+{
+    double packet = 20.0 + distance_bytes + static_cast<double>(count) + 4.0;
+    return packet + std::ceil(packet / 254.0) + 2.0;
+}
+
+/* Returns false if a decoded frame differs */
+static bool run(const Sequences &sequences, unsigned keyframe_interval)
+{
+    std::vector<uint8_t> tokens;
+    size_t nb_frames = 0;
+    size_t nb_values = 0;
+    size_t raw_bytes = 0;
+    size_t coded_bytes = 0;
+    size_t nb_coded = 0;
+    size_t mismatches = 0;
+    std::chrono::nanoseconds elapsed(0);
+    uint64_t cycles = 0;
+
+    for (const auto &entry : sequences) {
+        const std::vector<Frame> &frames = entry.second;
+        Frame reference;
+        unsigned frames_since_key = keyframe_interval;
+
+        for (const Frame &values : frames) {
+            uint32_t count = static_cast<uint32_t>(values.size());
+            uint32_t size = 0;
+            bool keyframe = frames_since_key >= keyframe_interval
+                    || reference.size() != values.size();
+
+            if (!keyframe) {
+                // Repeated, so the clock reads do not weigh on a sub-us call
+                tokens.resize(2 * count);
+#ifdef HAVE_RDTSC
+                uint64_t c0 = __rdtsc();
+#endif
+                auto t0 = std::chrono::steady_clock::now();
+                for (int r = 0; r < kRepeat; r++) {
+                    size = vl53l7cx_delta_encode(values.data(), reference.data(), count,
+                            tokens.data(), 2 * count);
+                }
+                elapsed += std::chrono::steady_clock::now() - t0;
+#ifdef HAVE_RDTSC
+                cycles += __rdtsc() - c0;
+#endif
+                nb_coded++;
+
+                // Check with the host decoder, on the little-endian reference
+                std::vector<uint8_t> decoded(2 * count);
+                for (uint32_t i = 0; i < count; i++) {
+                    decoded[2 * i] = static_cast<uint8_t>(reference[i]);
+                    decoded[2 * i + 1] = static_cast<uint8_t>(static_cast<uint16_t>(reference[i]) >> 8);
+                }
+                if (size != 0) {
+                    vl53l7cx::delta_decode(tokens.data(), size, decoded.data(), count);
+                    vl53l7cx::ArrayView<int16_t> view(decoded.data(), count);
+                    for (uint32_t i = 0; i < count; i++) {
+                        mismatches += (view[i] != values[i]);
+                    }
+                }
+            }
+
+            // Keyframe, or delta larger than raw: raw distances, which restart
+            // the interval as in vl53l7cx_stream_send()
+            frames_since_key = (size != 0) ? frames_since_key + 1 : 1;
+            coded_bytes += (size != 0) ? size : 2 * count;
+            raw_bytes += 2 * count;
+            nb_values += count;
+            nb_frames++;
+            reference = values;
+        }
+    }
+
+    if (nb_frames == 0) {
+        return true;
+    }
+    size_t count = nb_values / nb_frames;
+    double raw = static_cast<double>(raw_bytes) / nb_frames;
+    double coded = static_cast<double>(coded_bytes) / nb_frames;
+    double frame = frame_bytes(coded, count);
+
+    std::printf("%8u %9.1f %9.1f %6.2fx %8.1f %8.1f", keyframe_interval, raw, coded, raw / coded,
+            frame, 92160.0 / (frame * 15.0));
+    if (nb_coded != 0) {
+        double nb_calls = static_cast<double>(nb_coded) * kRepeat;
+        std::printf(" %9.1f", static_cast<double>(elapsed.count()) / nb_calls);
+#ifdef HAVE_RDTSC
+        std::printf(" %9.1f", static_cast<double>(cycles) / nb_calls);
+#endif
+    }
+    std::printf("%s\n", mismatches ? "  DECODE MISMATCH" : "");
+    return mismatches == 0;
+}
+
+int main(int argc, char **argv)
+{
+    Sequences sequences;
+
+    if (argc >= 2 && std::strcmp(argv[1], "--synthetic") == 0) {
+        size_t nb_frames = (argc >= 3) ? std::strtoul(argv[2], nullptr, 10) : 900;
+        make_synthetic(nb_frames, sequences);
+        std::printf("Synthetic static scene: %zu frames, 8x8\n", nb_frames);
+    } else if (argc == 2) {
+        if (!load_capture(argv[1], sequences)) {
+            return 1;
+        }
+    } else {
+        std::fprintf(stderr, "Usage: %s <capture.bin> | --synthetic [nb_frames]\n", argv[0]);
+        return 2;
+    }
+
+    // Distances only; "frame" adds header, status, CRC and framing. Sensors:
+    // how many 15 Hz streams fit on a 921600 baud UART
+    std::printf("\n%8s %9s %9s %7s %8s %8s %9s%s\n", "keyframe", "raw B", "coded B", "ratio",
+            "frame B", "sensors", "ns/frame",
+#ifdef HAVE_RDTSC
+            "    cycles"
+#else
+            ""
+#endif
+            );
+    bool ok = true;
+    for (unsigned keyframe_interval : {1u, 8u, 15u, 30u, 60u}) {
+        ok &= run(sequences, keyframe_interval);
+    }
+
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,142 @@
+/**
+ * VL53L7CX Binary Stream Dump
+ *
+ * Reads binary frames (vl53l7cx_stream.h) from the Pico 2 USB serial port, or
+ * from a file holding a captured stream, and prints them.
+ *
+ * Usage: vl53l7cx_stream_dump <device|file> [--grid] [--quiet] [--save <file>]
+ *   --grid   print the distance grid of each frame (first target)
+ *   --quiet  only print statistics, once per second
+ *   --save   also write the bytes received to a capture file (replayed by
+ *            this tool or by vl53l7cx_stream_bench)
+ */
+
+#include <cinttypes>
+#include <csignal>
+#include <cstdio>
+#include <cstring>
+#include <chrono>
+#include <fcntl.h>
+#include <termios.h>
+#include <unistd.h>
+#include "vl53l7cx_stream.hpp"
+
+static volatile std::sig_atomic_t stop_requested = 0;
+
+static void on_signal(int)
+{
+    stop_requested = 1;
+}
+
+static void print_frame(const vl53l7cx::FrameView &frame, bool grid)
+{
+    std::printf("#%" PRIu32 " sensor %u t=%" PRIu64 " us, %u zones, fields 0x%04x, %d degC, %zu bytes\n",
+            frame.sequence(), frame.sensor(), frame.timestamp_us(), frame.resolution(),
+            frame.field_mask(), frame.silicon_temp_degc(), frame.packet_size());
+
+    const auto &distance = frame.distance_mm();
+    if (!grid || distance.empty()) {
+        return;
+    }
+    size_t width = (frame.resolution() == 64) ? 8 : 4;
+    for (size_t row = 0; row < width; row++) {
+        std::printf("  ");
+        for (size_t col = 0; col < width; col++) {
+            std::printf("%5d", distance[(row * width + col) * frame.nb_targets()]);
+        }
+        std::printf("\n");
+    }
+}
+
+static void print_stats(const vl53l7cx::StreamStats &stats, double seconds)
+{
+    std::fprintf(stderr, "%" PRIu64 " frames (%.1f/s, %.1f KB/s), %" PRIu64 " lost, %"
+            PRIu64 " bad CRC, %" PRIu64 " bad frames\n",
+            stats.frames, stats.frames / seconds, stats.bytes / seconds / 1024.0,
+            stats.lost, stats.bad_crc, stats.bad_frames);
+}
+
+int main(int argc, char **argv)
+{
+    const char *path = nullptr;
+    const char *save_path = nullptr;
+    bool grid = false;
+    bool quiet = false;
+
+    for (int i = 1; i < argc; i++) {
+        if (std::strcmp(argv[i], "--grid") == 0) {
+            grid = true;
+        } else if (std::strcmp(argv[i], "--quiet") == 0) {
+            quiet = true;
+        } else if (std::strcmp(argv[i], "--save") == 0 && i + 1 < argc) {
+            save_path = argv[++i];
+        } else {
+            path = argv[i];
+        }
+    }
+    if (!path) {
+        std::fprintf(stderr, "Usage: %s <device|file> [--grid] [--quiet] [--save <file>]\n", argv[0]);
+        return 2;
+    }
+
+    int fd = open(path, O_RDONLY | O_NOCTTY);
+    if (fd < 0) {
+        std::perror(path);
+        return 1;
+    }
+
+    // Serial port: raw mode, so no byte of a frame is translated or eaten
+    struct termios tio;
+    if (isatty(fd) && tcgetattr(fd, &tio) == 0) {
+        cfmakeraw(&tio);
+        tcsetattr(fd, TCSANOW, &tio);
+    }
+
+    std::FILE *save = nullptr;
+    if (save_path) {
+        save = std::fopen(save_path, "wb");
+        if (!save) {
+            std::perror(save_path);
+            close(fd);
+            return 1;
+        }
+    }
+
+    std::signal(SIGINT, on_signal);
+
+    vl53l7cx::StreamDecoder decoder;
+    auto start = std::chrono::steady_clock::now();
+    auto last_report = start;
+    uint8_t chunk[4096];
+
+    while (!stop_requested) {
+        ssize_t nb_read = read(fd, chunk, sizeof(chunk));
+        if (nb_read <= 0) {
+            break;      // End of file, device unplugged or interrupted
+        }
+        if (save) {
+            std::fwrite(chunk, 1, static_cast<size_t>(nb_read), save);
+        }
+
+        decoder.feed(chunk, static_cast<size_t>(nb_read), [&](const vl53l7cx::FrameView &frame) {
+            if (!quiet) {
+                print_frame(frame, grid);
+            }
+        });
+
+        auto now = std::chrono::steady_clock::now();
+        if (quiet && now - last_report >= std::chrono::seconds(1)) {
+            print_stats(decoder.stats(), std::chrono::duration<double>(now - start).count());
+            last_report = now;
+        }
+    }
+
+    close(fd);
+    if (save) {
+        std::fclose(save);
+    }
+    print_stats(decoder.stats(),
+            std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count());
+
+    return 0;
+}
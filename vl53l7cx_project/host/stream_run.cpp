@@ -0,0 +1,368 @@
+/**
+ * VL53L7CX Binary Stream Round Trip
+ *
+ * Sends random frames of several sensors through the firmware encoder
+ * (vl53l7cx_stream.c, with vl53l7cx_stream_send() and delta coding, and with
+ * vl53l7cx_stream_encode()), with random resolutions, field masks and
+ * distances that mostly move by a few mm. Text lines are mixed into the byte
+ * stream, and some frames are corrupted (one byte changed) or cut short. The
+ * stream is fed to the host decoder (vl53l7cx_stream.hpp) in chunks of random
+ * size, and it checks:
+ *   round trip  every frame sent whole is decoded once, with every header
+ *               field and every array equal to what was sent (distances of
+ *               delta frames included); fields not sent are empty
+ *   dropped     each text line, corrupted frame and cut frame is dropped and
+ *               counted (bad CRC or bad frame), and the frames missing from
+ *               each sensor after its first whole frame are counted as lost
+ *   reference   delta frames after a lost frame have no distances until the
+ *               next keyframe, and are counted
+ *
+ * Usage: vl53l7cx_stream [--frames n] [--seed s]
+ *
+ * The exit status is 1 if a check fails.
+ */
+
+#include <algorithm>
+#include <cinttypes>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <map>
+#include <random>
+#include <utility>
+#include <vector>
+#include "vl53l7cx_stream.hpp"
+#include "vl53l7cx_check.hpp"
+
+extern "C" {
+#include "vl53l7cx_stream.h"
+}
+
+namespace {
+
+using vl53l7cx::check;
+
+const unsigned kSensors = 4;            // The last one goes through vl53l7cx_stream_encode()
+const uint8_t kKeyframeIntervals[kSensors] = {0, 4, 30, 0};
+const unsigned kTextPercent = 5;
+const unsigned kCorruptPercent = 3;
+const unsigned kCutPercent = 2;
+
+/* Field mask bits a frame may have */
+const uint16_t kFields[] = {
+    VL53L7CX_OUTPUT_AMBIENT_PER_SPAD, VL53L7CX_OUTPUT_NB_SPADS_ENABLED,
+    VL53L7CX_OUTPUT_NB_TARGET_DETECTED, VL53L7CX_OUTPUT_SIGNAL_PER_SPAD,
+    VL53L7CX_OUTPUT_RANGE_SIGMA_MM, VL53L7CX_OUTPUT_DISTANCE_MM,
+    VL53L7CX_OUTPUT_REFLECTANCE_PERCENT, VL53L7CX_OUTPUT_TARGET_STATUS,
+    VL53L7CX_OUTPUT_MOTION_INDICATOR,
+};
+
+/* A frame as sent */
+struct Sent {
+    uint8_t resolution;
+    uint16_t mask;                      // Without VL53L7CX_STREAM_DELTA
+    uint8_t stream_count;
+    uint64_t timestamp_us;
+    bool distances;                     // Decoded with distances
+    VL53L7CX_ResultsData results;
+};
+
+/* Per sensor state of the sender */
+struct Sensor {
+    VL53L7CX_Stream stream;
+    VL53L7CX_Configuration dev;
+    uint8_t resolution = VL53L7CX_RESOLUTION_8X8;
+    uint16_t mask = 0;
+    VL53L7CX_ResultsData results;
+    bool has_previous = false;          // results holds the last frame, with distances
+    uint32_t sequence = 0;              // Encode path
+    // Receiver model
+    bool reference = false;             // The decoder holds the distances of the last frame
+    bool received = false;              // A whole frame was received
+    uint32_t damaged = 0;               // Frames damaged since the last whole one
+};
+
+/* Byte sink of vl53l7cx_stream_send(): the last frame */
+uint8_t capture(void *p_ctx, const uint8_t *p_data, uint32_t size)
+{
+    std::vector<uint8_t> *frame = static_cast<std::vector<uint8_t> *>(p_ctx);
+    frame->assign(p_data, p_data + size);
+    return 0;
+}
+
+const VL53L7CX_StreamOps kCaptureOps = {capture};
+
+template <typename T>
+void randomize(T *values, size_t count, std::mt19937 &rng)
+{
+    for (size_t i = 0; i < count; i++) {
+        values[i] = static_cast<T>(rng());
+    }
+}
+
+/* New results: distances move by a few mm (some jump, most do not move) */
+void next_results(VL53L7CX_ResultsData &results, bool keep_distances, std::mt19937 &rng)
+{
+    std::vector<int16_t> distances(results.distance_mm,
+            results.distance_mm + sizeof(results.distance_mm) / sizeof(int16_t));
+    randomize(reinterpret_cast<uint8_t *>(&results), sizeof(results), rng);
+    for (size_t i = 0; i < distances.size(); i++) {
+        unsigned draw = rng() % 100;
+        if (!keep_distances || draw < 3) {
+            results.distance_mm[i] = static_cast<int16_t>(rng());
+        } else if (draw < 60) {
+            results.distance_mm[i] = distances[i];
+        } else {
+            results.distance_mm[i] = static_cast<int16_t>(distances[i] + int(rng() % 41) - 20);
+        }
+    }
+}
+
+/* Whether a frame went out delta coded */
+bool is_delta(const std::vector<uint8_t> &frame)
+{
+    std::vector<uint8_t> packet(frame.begin() + 1, frame.end() - 1);
+    size_t size = vl53l7cx::cobs_decode_in_place(packet.data(), packet.size());
+    vl53l7cx::FrameView view;
+    return view.parse(packet.data(), size) == vl53l7cx::FrameView::Status::kOk && view.is_delta();
+}
+
+template <typename T, typename U>
+bool same(const vl53l7cx::ArrayView<T> &view, bool sent, const U *values, size_t count)
+{
+    if (!sent) {
+        return view.empty();
+    }
+    if (view.size() != count) {
+        return false;
+    }
+    for (size_t i = 0; i < count; i++) {
+        if (view[i] != static_cast<T>(values[i])) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/* Every field of a decoded frame against the frame sent */
+bool compare(const vl53l7cx::FrameView &frame, uint8_t sensor, uint32_t sequence,
+        const Sent &sent)
+{
+    const VL53L7CX_ResultsData &r = sent.results;
+    size_t zones = sent.resolution;
+    size_t targets = zones * VL53L7CX_NB_TARGET_PER_ZONE;
+    uint16_t mask = sent.mask;
+    bool ok = frame.sensor() == sensor && frame.sequence() == sequence
+            && frame.resolution() == sent.resolution
+            && frame.nb_targets() == VL53L7CX_NB_TARGET_PER_ZONE
+            && (frame.field_mask() & ~VL53L7CX_STREAM_DELTA) == mask
+            && frame.stream_count() == sent.stream_count
+            && frame.silicon_temp_degc() == r.silicon_temp_degc
+            && frame.timestamp_us() == sent.timestamp_us;
+
+    ok &= same(frame.ambient_per_spad(), mask & VL53L7CX_OUTPUT_AMBIENT_PER_SPAD,
+            r.ambient_per_spad, zones);
+    ok &= same(frame.nb_spads_enabled(), mask & VL53L7CX_OUTPUT_NB_SPADS_ENABLED,
+            r.nb_spads_enabled, zones);
+    ok &= same(frame.nb_target_detected(), mask & VL53L7CX_OUTPUT_NB_TARGET_DETECTED,
+            r.nb_target_detected, zones);
+    ok &= same(frame.signal_per_spad(), mask & VL53L7CX_OUTPUT_SIGNAL_PER_SPAD,
+            r.signal_per_spad, targets);
+    ok &= same(frame.range_sigma_mm(), mask & VL53L7CX_OUTPUT_RANGE_SIGMA_MM,
+            r.range_sigma_mm, targets);
+    ok &= same(frame.distance_mm(), sent.distances, r.distance_mm, targets);
+    ok &= same(frame.reflectance(), mask & VL53L7CX_OUTPUT_REFLECTANCE_PERCENT,
+            r.reflectance, targets);
+    ok &= same(frame.target_status(), mask & VL53L7CX_OUTPUT_TARGET_STATUS,
+            r.target_status, targets);
+
+    const vl53l7cx::MotionView &motion = frame.motion_indicator();
+    if (mask & VL53L7CX_OUTPUT_MOTION_INDICATOR) {
+        ok &= motion.global_indicator_1 == r.motion_indicator.global_indicator_1
+                && motion.global_indicator_2 == r.motion_indicator.global_indicator_2
+                && motion.status == r.motion_indicator.status
+                && motion.nb_of_detected_aggregates
+                        == r.motion_indicator.nb_of_detected_aggregates
+                && motion.nb_of_aggregates == r.motion_indicator.nb_of_aggregates
+                && same(motion.motion, true, r.motion_indicator.motion, 32);
+    } else {
+        ok &= motion.motion.empty();
+    }
+    return ok;
+}
+
+} // namespace
+
+int main(int argc, char **argv)
+{
+    unsigned nb_frames = 2000;
+    uint32_t seed = 15;
+
+    for (int i = 1; i < argc; i++) {
+        if (std::strcmp(argv[i], "--frames") == 0 && i + 1 < argc) {
+            nb_frames = static_cast<unsigned>(std::atoi(argv[++i]));
+        } else if (std::strcmp(argv[i], "--seed") == 0 && i + 1 < argc) {
+            seed = static_cast<uint32_t>(std::atol(argv[++i]));
+        } else {
+            std::fprintf(stderr, "Usage: %s [--frames n] [--seed s]\n", argv[0]);
+            return 2;
+        }
+    }
+
+    std::mt19937 rng(seed);
+    static Sensor sensors[kSensors];
+    std::vector<uint8_t> frame, wire;
+    std::map<std::pair<uint8_t, uint32_t>, Sent> whole;     // By sensor and sequence
+    uint64_t texts = 0, corrupted = 0, cut = 0, deltas = 0;
+    uint64_t expected_lost = 0, expected_no_reference = 0;
+    bool ok = true;
+
+    for (unsigned s = 0; s < kSensors; s++) {
+        ok &= vl53l7cx_stream_init(&sensors[s].stream, &kCaptureOps, &frame,
+                static_cast<uint8_t>(s)) == 0;
+        ok &= vl53l7cx_stream_set_delta(&sensors[s].stream, kKeyframeIntervals[s]) == 0;
+    }
+
+    for (unsigned f = 0; f < nb_frames && ok; f++) {
+        uint8_t s = static_cast<uint8_t>(rng() % kSensors);
+        Sensor &sensor = sensors[s];
+
+        // Layout changes now and then, which restarts delta coding
+        if (f < kSensors || rng() % 50 == 0) {
+            sensor.resolution = rng() % 2 ? VL53L7CX_RESOLUTION_8X8 : VL53L7CX_RESOLUTION_4X4;
+            sensor.mask = VL53L7CX_OUTPUT_DISTANCE_MM;
+            for (uint16_t field : kFields) {
+                sensor.mask |= (rng() % 2) ? field : 0;
+            }
+            if (rng() % 8 == 0) {
+                sensor.mask &= ~VL53L7CX_OUTPUT_DISTANCE_MM;
+            }
+            sensor.has_previous = false;
+        }
+
+        Sent sent;
+        next_results(sensor.results, sensor.has_previous, rng);
+        sent.resolution = sensor.resolution;
+        sent.mask = sensor.mask;
+        sent.stream_count = static_cast<uint8_t>(rng());
+        sent.timestamp_us = (uint64_t(rng()) << 32) | rng();
+        sent.results = sensor.results;
+
+        uint32_t sequence;
+        if (s < kSensors - 1) {
+            sequence = sensor.stream.sequence;
+            sensor.dev.output_mask = sent.mask | VL53L7CX_OUTPUT_MANDATORY;
+            sensor.dev.streamcount = sent.stream_count;
+            ok &= vl53l7cx_stream_send(&sensor.stream, &sensor.dev, &sent.results,
+                    sent.resolution, sent.timestamp_us) == 0;
+        } else {
+            VL53L7CX_StreamHeader header;
+            static VL53L7CX_ResultsData previous;
+            uint32_t size = 0;
+            header.sensor = s;
+            header.resolution = sent.resolution;
+            header.field_mask = sent.mask;
+            header.stream_count = sent.stream_count;
+            header.sequence = sequence = sensor.sequence++;
+            header.timestamp_us = sent.timestamp_us;
+            header.p_distance_ref = sensor.has_previous ? previous.distance_mm : NULL;
+            frame.resize(VL53L7CX_STREAM_MAX_FRAME_SIZE);
+            ok &= vl53l7cx_stream_encode(&header, &sent.results, frame.data(),
+                    static_cast<uint32_t>(frame.size()), &size, NULL) == 0;
+            frame.resize(size);
+            previous = sent.results;
+        }
+        sensor.has_previous = (sensor.mask & VL53L7CX_OUTPUT_DISTANCE_MM) != 0;
+        bool delta = is_delta(frame);
+        deltas += delta ? 1 : 0;
+
+        // Damage: one byte changed (never to a delimiter), or the end cut off
+        unsigned draw = rng() % 100;
+        if (draw < kCorruptPercent) {
+            size_t pos = 1 + rng() % (frame.size() - 2);
+            uint8_t change = static_cast<uint8_t>(1 + rng() % 255);
+            if ((frame[pos] ^ change) == 0) {
+                change ^= 0x01;
+            }
+            frame[pos] ^= change;
+            corrupted++;
+        } else if (draw < kCorruptPercent + kCutPercent) {
+            frame.resize(4 + rng() % (frame.size() - 5));
+            cut++;
+        }
+        wire.insert(wire.end(), frame.begin(), frame.end());
+
+        // Receiver model: lost frames and delta frames without reference
+        if (draw < kCorruptPercent + kCutPercent) {
+            sensor.damaged++;
+            sensor.reference = false;
+        } else {
+            // Frames damaged before the first whole one are not seen as lost
+            expected_lost += sensor.received ? sensor.damaged : 0;
+            sensor.received = true;
+            sensor.damaged = 0;
+            if (delta) {
+                sent.distances = sensor.reference;
+                expected_no_reference += sensor.reference ? 0 : 1;
+            } else {
+                sent.distances = (sent.mask & VL53L7CX_OUTPUT_DISTANCE_MM) != 0;
+                sensor.reference = sent.distances;
+            }
+            whole[std::make_pair(s, sequence)] = sent;
+        }
+
+        // Text between two frames (a cut frame would run into it)
+        bool whole_frame = frame.back() == 0x00;
+        if (whole_frame && f + 1 < nb_frames && rng() % 100 < kTextPercent) {
+            char line[64];
+            int size = std::snprintf(line, sizeof(line), "core1: frame %u, %u us\r\n", f,
+                    static_cast<unsigned>(rng() % 100000));
+            wire.insert(wire.end(), line, line + size);
+            texts++;
+        }
+    }
+    if (!ok) {
+        std::printf("encode FAILED\n");
+        return 1;
+    }
+    wire.push_back(0x00);               // Ends a last frame cut short
+
+    // Decode, in chunks of random size
+    vl53l7cx::StreamDecoder decoder;
+    uint64_t decoded = 0, unexpected = 0, mismatches = 0;
+    auto handler = [&](const vl53l7cx::FrameView &view) {
+        decoded++;
+        auto it = whole.find(std::make_pair(view.sensor(), view.sequence()));
+        if (it == whole.end()) {
+            unexpected++;
+            return;
+        }
+        mismatches += compare(view, view.sensor(), view.sequence(), it->second) ? 0 : 1;
+        whole.erase(it);
+    };
+    size_t pos = 0;
+    while (pos < wire.size()) {
+        size_t chunk = std::min<size_t>(1 + rng() % 700, wire.size() - pos);
+        decoder.feed(&wire[pos], chunk, handler);
+        pos += chunk;
+    }
+    const vl53l7cx::StreamStats &stats = decoder.stats();
+
+    std::printf("%u frames (%" PRIu64 " delta coded), %zu bytes with %" PRIu64 " text lines, %"
+            PRIu64 " corrupted and %" PRIu64 " cut frames\n", nb_frames, deltas, wire.size(),
+            texts, corrupted, cut);
+    std::printf("  decoded %" PRIu64 ", %" PRIu64 " mismatches, %" PRIu64 " unexpected, %zu"
+            " missing\n", decoded, mismatches, unexpected, whole.size());
+    std::printf("  dropped %" PRIu64 " bad CRC + %" PRIu64 " bad frames (expected %" PRIu64
+            "), %" PRIu64 " lost (expected %" PRIu64 "), %" PRIu64 " without reference"
+            " (expected %" PRIu64 ")\n", stats.bad_crc, stats.bad_frames,
+            texts + corrupted + cut, stats.lost, expected_lost, stats.no_reference,
+            expected_no_reference);
+
+    ok &= check("round trip", mismatches == 0 && unexpected == 0 && whole.empty()
+            && decoded == stats.frames && deltas > 0);
+    ok &= check("dropped", stats.bad_crc + stats.bad_frames == texts + corrupted + cut
+            && stats.lost == expected_lost && texts > 0 && corrupted + cut > 0);
+    ok &= check("reference", stats.no_reference == expected_no_reference);
+    return ok ? 0 : 1;
+}
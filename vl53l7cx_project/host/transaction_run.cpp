@@ -0,0 +1,233 @@
+/**
+ * VL53L7CX Configuration Transactions on the Simulated Device
+ *
+ * Applies the same configuration to two register-level simulators
+ * (vl53l7cx_simulator.hpp): one with the vl53l7cx_set_*() setters, one with a
+ * transaction (vl53l7cx_transaction_*() then vl53l7cx_transaction_commit()),
+ * after another configuration with the DCI cache warm, then with the cache
+ * invalidated. It reports the bus traffic of both and checks that:
+ *   - the report of a dry run gives the firmware commands, DCI reads and the
+ *     I2C transactions and bytes (register address included) of the commit
+ *     as seen by the device, one status poll counted per command;
+ *   - the report of the commit matches the device, status polls included;
+ *   - the DCI blocks of both devices are the same afterwards, and the getters
+ *     read the values set.
+ *
+ * Usage: vl53l7cx_transaction
+ *
+ * The exit status is 1 if a check fails.
+ */
+
+#include <cinttypes>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+#include "vl53l7cx_simulator.hpp"
+
+namespace {
+
+/* Configuration applied by both paths */
+const uint8_t kResolution = VL53L7CX_RESOLUTION_8X8;
+const uint8_t kFrequencyHz = 10;
+const uint32_t kIntegrationMs = 20;
+const uint8_t kSharpenerPercent = 20;    // Exact in the 0..255 scale of the block
+const uint8_t kTargetOrder = VL53L7CX_TARGET_ORDER_STRONGEST;
+const uint8_t kRangingMode = VL53L7CX_RANGING_MODE_AUTONOMOUS;
+
+/* Blocks written by the configuration */
+const uint16_t kBlocks[] = {
+    VL53L7CX_DCI_DSS_CONFIG, VL53L7CX_DCI_ZONE_CONFIG, VL53L7CX_DCI_FREQ_HZ,
+    VL53L7CX_DCI_INT_TIME, VL53L7CX_DCI_SHARPENER, VL53L7CX_DCI_TARGET_ORDER,
+    VL53L7CX_DCI_RANGING_MODE, VL53L7CX_DCI_SINGLE_RANGE,
+};
+
+/* Bus traffic between two snapshots, in the units of the report */
+struct Traffic {
+    uint64_t commands;
+    uint64_t polls;
+    uint64_t transactions;
+    uint64_t bytes;                 // Register address included
+    uint64_t writes;
+    uint64_t reads;
+
+    Traffic(const vl53l7cx::SimulatorStats &before, const vl53l7cx::SimulatorStats &after)
+        : commands(after.commands - before.commands),
+          polls(after.status_polls - before.status_polls),
+          transactions(after.reads + after.writes - before.reads - before.writes),
+          bytes(after.bytes_read + after.bytes_written - before.bytes_read
+                  - before.bytes_written + 2 * transactions),
+          writes(after.writes - before.writes), reads(after.reads - before.reads)
+    {
+    }
+};
+
+struct Sensor {
+    vl53l7cx::SimulatedDevice device;
+    VL53L7CX_Configuration dev;
+
+    bool init()
+    {
+        std::memset(&dev, 0, sizeof(dev));
+        dev.platform.address = VL53L7CX_DEFAULT_I2C_ADDRESS;
+        device.attach(dev);
+        return vl53l7cx_init(&dev) == VL53L7CX_STATUS_OK;
+    }
+};
+
+uint8_t set_unbatched(VL53L7CX_Configuration &dev)
+{
+    uint8_t status = vl53l7cx_set_resolution(&dev, kResolution);
+    status |= vl53l7cx_set_ranging_frequency_hz(&dev, kFrequencyHz);
+    status |= vl53l7cx_set_integration_time_ms(&dev, kIntegrationMs);
+    status |= vl53l7cx_set_sharpener_percent(&dev, kSharpenerPercent);
+    status |= vl53l7cx_set_target_order(&dev, kTargetOrder);
+    status |= vl53l7cx_set_ranging_mode(&dev, kRangingMode);
+    return status;
+}
+
+/* Another configuration, whose blocks the cache then holds */
+uint8_t warm_up(VL53L7CX_Configuration &dev)
+{
+    uint8_t status = vl53l7cx_set_ranging_frequency_hz(&dev, 5);
+    status |= vl53l7cx_set_integration_time_ms(&dev, 10);
+    status |= vl53l7cx_set_sharpener_percent(&dev, 0);
+    status |= vl53l7cx_set_target_order(&dev, VL53L7CX_TARGET_ORDER_CLOSEST);
+    status |= vl53l7cx_set_ranging_mode(&dev, VL53L7CX_RANGING_MODE_CONTINUOUS);
+    return status;
+}
+
+uint8_t stage(VL53L7CX_Transaction &txn)
+{
+    uint8_t status = vl53l7cx_transaction_init(&txn);
+    status |= vl53l7cx_transaction_set_resolution(&txn, kResolution);
+    status |= vl53l7cx_transaction_set_ranging_frequency_hz(&txn, kFrequencyHz);
+    status |= vl53l7cx_transaction_set_integration_time_ms(&txn, kIntegrationMs);
+    status |= vl53l7cx_transaction_set_sharpener_percent(&txn, kSharpenerPercent);
+    status |= vl53l7cx_transaction_set_target_order(&txn, kTargetOrder);
+    status |= vl53l7cx_transaction_set_ranging_mode(&txn, kRangingMode);
+    return status;
+}
+
+/* The values read back by the getters are the ones set */
+bool read_back(VL53L7CX_Configuration &dev)
+{
+    uint8_t resolution = 0, frequency_hz = 0, sharpener = 0, order = 0, mode = 0;
+    uint32_t integration_ms = 0;
+    uint8_t status = vl53l7cx_get_resolution(&dev, &resolution);
+    status |= vl53l7cx_get_ranging_frequency_hz(&dev, &frequency_hz);
+    status |= vl53l7cx_get_integration_time_ms(&dev, &integration_ms);
+    status |= vl53l7cx_get_sharpener_percent(&dev, &sharpener);
+    status |= vl53l7cx_get_target_order(&dev, &order);
+    status |= vl53l7cx_get_ranging_mode(&dev, &mode);
+    return status == VL53L7CX_STATUS_OK && resolution == kResolution
+            && frequency_hz == kFrequencyHz && integration_ms == kIntegrationMs
+            && sharpener == kSharpenerPercent && order == kTargetOrder && mode == kRangingMode;
+}
+
+void print_report(const char *name, const VL53L7CX_TransactionReport &report)
+{
+    std::printf("  %-8s %2" PRIu32 " cmds %2" PRIu32 " dci reads %3" PRIu32
+            " i2c transactions %5" PRIu32 " bytes\n", name, report.nb_ui_cmds,
+            report.nb_dci_reads, report.nb_i2c_transactions, report.nb_i2c_bytes);
+}
+
+void print_traffic(const char *name, const Traffic &traffic)
+{
+    std::printf("  %-8s %2" PRIu64 " cmds %2" PRIu64 " polls     %3" PRIu64
+            " i2c transactions %5" PRIu64 " bytes (%" PRIu64 " writes, %" PRIu64 " reads)\n",
+            name, traffic.commands, traffic.polls, traffic.transactions, traffic.bytes,
+            traffic.writes, traffic.reads);
+}
+
+bool run(bool cold_cache)
+{
+    static Sensor unbatched, batched;
+    if (!unbatched.init() || !batched.init()
+            || warm_up(unbatched.dev) != VL53L7CX_STATUS_OK
+            || warm_up(batched.dev) != VL53L7CX_STATUS_OK) {
+        std::printf("init FAILED\n");
+        return false;
+    }
+    if (cold_cache) {
+        (void)vl53l7cx_dci_cache_invalidate(&unbatched.dev);
+        (void)vl53l7cx_dci_cache_invalidate(&batched.dev);
+    }
+    uint32_t hits = 0, misses = 0;
+    (void)vl53l7cx_get_dci_cache_stats(&batched.dev, &hits, &misses);
+    std::printf("%s cache\n", cold_cache ? "cold" : "warm");
+    bool ok = true;
+
+    vl53l7cx::SimulatorStats before = unbatched.device.stats();
+    uint8_t status = set_unbatched(unbatched.dev);
+    Traffic setters(before, unbatched.device.stats());
+    print_traffic("setters", setters);
+    ok &= status == VL53L7CX_STATUS_OK;
+
+    // Dry run: nothing reaches the device
+    VL53L7CX_Transaction txn;
+    VL53L7CX_TransactionReport dry, real;
+    status = stage(txn);
+    before = batched.device.stats();
+    status |= vl53l7cx_transaction_commit(&batched.dev, &txn, 1, &dry);
+    Traffic none(before, batched.device.stats());
+    ok &= status == VL53L7CX_STATUS_OK && none.transactions == 0;
+
+    before = batched.device.stats();
+    status = vl53l7cx_transaction_commit(&batched.dev, &txn, 0, &real);
+    Traffic commit(before, batched.device.stats());
+    print_report("dry run", dry);
+    print_report("commit", real);
+    print_traffic("device", commit);
+    ok &= status == VL53L7CX_STATUS_OK;
+    uint32_t hits_after = 0, misses_after = 0;
+    (void)vl53l7cx_get_dci_cache_stats(&batched.dev, &hits_after, &misses_after);
+    std::printf("  cache    %" PRIu32 " hits %" PRIu32 " misses\n", hits_after - hits,
+            misses_after - misses);
+
+    // The dry run counts one status poll per command: the rest must match
+    bool dry_matches = dry.nb_ui_cmds == commit.commands
+            && dry.nb_i2c_transactions - dry.nb_ui_cmds == commit.transactions - commit.polls
+            && dry.nb_i2c_bytes - 6 * dry.nb_ui_cmds == commit.bytes - 6 * commit.polls
+            && dry.nb_dci_reads == real.nb_dci_reads;
+    bool real_matches = real.nb_ui_cmds == commit.commands
+            && real.nb_i2c_transactions == commit.transactions
+            && real.nb_i2c_bytes == commit.bytes;
+    ok &= dry_matches && real_matches;
+    std::printf("  dry run report %s, commit report %s, %" PRIu64 " writes instead of %"
+            PRIu64 "\n", dry_matches ? "matches" : "DIFFERS",
+            real_matches ? "matches" : "DIFFERS", commit.writes, setters.writes);
+
+    // Same DCI state as the setters
+    unsigned differ = 0;
+    for (uint16_t index : kBlocks) {
+        std::vector<uint8_t> a, b;
+        if (!unbatched.device.dci_block(index, a) || !batched.device.dci_block(index, b)
+                || a != b) {
+            std::printf("  block 0x%04x DIFFERS\n", index);
+            differ++;
+        }
+    }
+    bool values = read_back(unbatched.dev) && read_back(batched.dev);
+    std::printf("  %zu blocks, %u differ, values read back %s\n",
+            sizeof(kBlocks) / sizeof(kBlocks[0]), differ, values ? "ok" : "WRONG");
+    ok &= differ == 0 && values && commit.writes < setters.writes;
+
+    ok &= batched.device.stats().command_errors == 0
+            && unbatched.device.stats().command_errors == 0;
+    return ok;
+}
+
+} // namespace
+
+int main(int argc, char **argv)
+{
+    if (argc > 1) {
+        std::fprintf(stderr, "Usage: %s\n", argv[0]);
+        return 2;
+    }
+
+    bool ok = run(false);
+    ok &= run(true);
+    std::printf("%s\n", ok ? "ok" : "FAILED");
+    return ok ? 0 : 1;
+}
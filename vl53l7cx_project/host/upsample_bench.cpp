@@ -0,0 +1,244 @@
+/**
+ * VL53L7CX Depth Image Upsampling Benchmark
+ *
+ * Upsamples frames of the synthetic scene of the simulator (a tilted wall and
+ * an object crossing the field of view, with some zones reported invalid)
+ * into images of several sizes, in both modes, with the vector path
+ * (vl53l7cx_upsample_run(): AVX2, SSE2 or NEON as compiled) and the integer
+ * path of the MCU (vl53l7cx_upsample_run_fixed()). For each size and mode it
+ * reports:
+ *   - the time per frame and the output pixels per second of each path,
+ *   - the largest difference of each path from a double precision reference,
+ *   - the flying pixels: pixels further than 8 % from every valid zone around
+ *     them, placed between a foreground object and the background.
+ *
+ * Usage: vl53l7cx_upsample_bench [--resolution 4|8] [--frames n]
+ *        [--size WxH]...
+ *
+ * The exit status is 1 if a path differs from the reference by more than 1
+ * distance unit.
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <utility>
+#include <vector>
+
+#include "vl53l7cx_simulator.hpp"
+
+extern "C" {
+#include "vl53l7cx_upsample.h"
+}
+
+namespace {
+
+#ifdef VL53L7CX_USE_RAW_FORMAT
+constexpr double kSigmaToUnits = 1.0 / 32.0;   // 1/128 mm to 1/4 mm
+#else
+constexpr double kSigmaToUnits = 1.0;
+#endif
+
+bool zone_valid(const VL53L7CX_ResultsData &results, int zone)
+{
+    size_t i = size_t(zone) * VL53L7CX_NB_TARGET_PER_ZONE;
+    return results.nb_target_detected[zone] > 0 && results.target_status[i] < 32
+            && ((VL53L7CX_UPSAMPLE_DEFAULT_STATUS_MASK >> results.target_status[i]) & 1U);
+}
+
+/* Same interpolation in double precision, from the layout of the upsampler */
+void upsample_reference(const VL53L7CX_Upsampler &up, const VL53L7CX_ResultsData &results,
+        std::vector<int16_t> &image)
+{
+    const int n = up.resolution == VL53L7CX_RESOLUTION_4X4 ? 4 : 8;
+    const bool edges = up.mode == VL53L7CX_UPSAMPLE_EDGE_AWARE;
+    double confidence[64], edge[64];
+    double sigma_min = 65535.0;
+
+    for (int z = 0; z < up.resolution; z++) {
+        if (zone_valid(results, z)) {
+            sigma_min = std::min<double>(sigma_min,
+                    results.range_sigma_mm[z * VL53L7CX_NB_TARGET_PER_ZONE]);
+        }
+    }
+    for (int z = 0; z < up.resolution; z++) {
+        size_t i = size_t(z) * VL53L7CX_NB_TARGET_PER_ZONE;
+        double sigma = results.range_sigma_mm[i];
+        bool valid = zone_valid(results, z);
+        confidence[z] = !valid ? 0.0 : !edges ? 1.0
+                : std::max(std::floor(std::pow(std::floor(256.0 * sigma_min / sigma), 2) / 256.0),
+                        1.0) / 256.0;
+        edge[z] = std::max(std::floor(results.distance_mm[i] * up.edge_ratio_q8 / 256.0),
+                std::floor(sigma * up.edge_sigma * kSigmaToUnits));
+    }
+
+    image.assign(size_t(up.width) * up.height, 0);
+    for (int row = 0; row < up.height; row++) {
+        double fy = up.row_wy[row] / 256.0;
+        int y[2] = {up.row_y0[row], up.row_y1[row]};
+        for (int col = 0; col < up.width; col++) {
+            double fx = up.col_wx[col] / 256.0;
+            int x[2] = {up.col_x0[col], up.col_x1[col]};
+            int ref = y[up.row_wy[row] < 128 ? 0 : 1] * n + x[up.col_wx[col] < 128 ? 0 : 1];
+            double dref = results.distance_mm[ref * VL53L7CX_NB_TARGET_PER_ZONE];
+            double num = 0.0, den = 0.0;
+            for (int k = 0; k < 4; k++) {
+                int z = y[k / 2] * n + x[k % 2];
+                double d = results.distance_mm[z * VL53L7CX_NB_TARGET_PER_ZONE];
+                double w = (k % 2 ? fx : 1.0 - fx) * (k / 2 ? fy : 1.0 - fy) * confidence[z];
+                if (edges && confidence[ref] > 0.0 && std::fabs(d - dref) > edge[ref]) {
+                    w = 0.0;
+                }
+                num += w * d;
+                den += w;
+            }
+            image[size_t(row) * up.width + col] = den > 0.0
+                    ? static_cast<int16_t>(std::lround(num / den)) : 0;
+        }
+    }
+}
+
+int max_difference(const std::vector<int16_t> &a, const std::vector<int16_t> &b)
+{
+    int diff = 0;
+    for (size_t i = 0; i < a.size(); i++) {
+        diff = std::max(diff, std::abs(a[i] - b[i]));
+    }
+    return diff;
+}
+
+/* Pixels further than 8 % from every valid zone around them */
+unsigned flying_pixels(const VL53L7CX_Upsampler &up, const VL53L7CX_ResultsData &results,
+        const std::vector<int16_t> &image)
+{
+    const int n = up.resolution == VL53L7CX_RESOLUTION_4X4 ? 4 : 8;
+    unsigned flying = 0;
+    for (int row = 0; row < up.height; row++) {
+        for (int col = 0; col < up.width; col++) {
+            double p = image[size_t(row) * up.width + col];
+            double nearest = 1e9;
+            for (int k = 0; k < 4; k++) {
+                int z = (k / 2 ? up.row_y1[row] : up.row_y0[row]) * n
+                        + (k % 2 ? up.col_x1[col] : up.col_x0[col]);
+                if (zone_valid(results, z)) {
+                    nearest = std::min(nearest,
+                            std::fabs(p - results.distance_mm[z * VL53L7CX_NB_TARGET_PER_ZONE]));
+                }
+            }
+            flying += (p > 0.0 && nearest > 0.08 * p) ? 1 : 0;
+        }
+    }
+    return flying;
+}
+
+template <typename Run>
+double time_frames(Run run, const std::vector<VL53L7CX_ResultsData> &frames, unsigned iterations)
+{
+    auto start = std::chrono::steady_clock::now();
+    for (unsigned it = 0; it < iterations; it++) {
+        for (const VL53L7CX_ResultsData &frame : frames) {
+            run(frame);
+        }
+    }
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count()
+            / (double(iterations) * frames.size());
+}
+
+} // namespace
+
+int main(int argc, char **argv)
+{
+    uint8_t resolution = VL53L7CX_RESOLUTION_8X8;
+    unsigned nb_frames = 60;
+    std::vector<std::pair<unsigned, unsigned>> sizes;
+
+    for (int i = 1; i < argc; i++) {
+        unsigned w = 0, h = 0;
+        if (std::strcmp(argv[i], "--resolution") == 0 && i + 1 < argc) {
+            resolution = std::atoi(argv[++i]) == 4 ? VL53L7CX_RESOLUTION_4X4
+                    : VL53L7CX_RESOLUTION_8X8;
+        } else if (std::strcmp(argv[i], "--frames") == 0 && i + 1 < argc) {
+            nb_frames = static_cast<unsigned>(std::atoi(argv[++i]));
+        } else if (std::strcmp(argv[i], "--size") == 0 && i + 1 < argc
+                && std::sscanf(argv[++i], "%ux%u", &w, &h) == 2) {
+            sizes.emplace_back(w, h);
+        } else {
+            std::fprintf(stderr, "Usage: %s [--resolution 4|8] [--frames n] [--size WxH]...\n",
+                    argv[0]);
+            return 2;
+        }
+    }
+    if (sizes.empty()) {
+        sizes = {{16, 16}, {32, 32}, {64, 64}, {40, 30}};
+    }
+    if (nb_frames == 0) {
+        std::fprintf(stderr, "--frames must be positive\n");
+        return 2;
+    }
+
+    // Frames over the 4 s sweep of the object, 3 % of zones invalid
+    std::vector<VL53L7CX_ResultsData> frames(nb_frames);
+    std::mt19937 rng(1);
+    std::uniform_real_distribution<double> uniform(0.0, 1.0);
+    for (unsigned f = 0; f < nb_frames; f++) {
+        std::memset(&frames[f], 0, sizeof(frames[f]));
+        vl53l7cx::synthetic_scene(f, uint64_t(f) * 4000000ULL / nb_frames, resolution, frames[f]);
+        for (int z = 0; z < resolution; z++) {
+            if (uniform(rng) < 0.03) {
+                frames[f].target_status[z * VL53L7CX_NB_TARGET_PER_ZONE] = 255;
+            }
+        }
+    }
+
+    const int n = resolution == VL53L7CX_RESOLUTION_4X4 ? 4 : 8;
+    std::printf("%ux%u zones, %u frames, vector path: %s\n", n, n, nb_frames,
+            vl53l7cx_upsample_path());
+
+    bool failed = false;
+    for (const auto &size : sizes) {
+        for (uint8_t mode : {VL53L7CX_UPSAMPLE_BILINEAR, VL53L7CX_UPSAMPLE_EDGE_AWARE}) {
+            static VL53L7CX_Upsampler up;
+            if (vl53l7cx_upsample_init(&up, resolution, static_cast<uint16_t>(size.first),
+                    static_cast<uint16_t>(size.second), mode) != 0) {
+                std::fprintf(stderr, "%ux%u: invalid size (largest %u)\n", size.first,
+                        size.second, unsigned(VL53L7CX_UPSAMPLE_MAX_SIZE));
+                return 2;
+            }
+
+            size_t pixels = size_t(up.width) * up.height;
+            std::vector<int16_t> vector(pixels), fixed(pixels), reference;
+            int vector_diff = 0, fixed_diff = 0;
+            unsigned long flying = 0;
+            for (const VL53L7CX_ResultsData &frame : frames) {
+                vl53l7cx_upsample_run(&up, &frame, vector.data());
+                vl53l7cx_upsample_run_fixed(&up, &frame, fixed.data());
+                upsample_reference(up, frame, reference);
+                vector_diff = std::max(vector_diff, max_difference(vector, reference));
+                fixed_diff = std::max(fixed_diff, max_difference(fixed, reference));
+                flying += flying_pixels(up, frame, fixed);
+            }
+
+            unsigned iterations = std::max(1u, unsigned(2000000 / (pixels * nb_frames)));
+            double vector_s = time_frames([&](const VL53L7CX_ResultsData &frame) {
+                vl53l7cx_upsample_run(&up, &frame, vector.data());
+            }, frames, iterations);
+            double fixed_s = time_frames([&](const VL53L7CX_ResultsData &frame) {
+                vl53l7cx_upsample_run_fixed(&up, &frame, fixed.data());
+            }, frames, iterations);
+
+            bool size_failed = vector_diff > 1 || fixed_diff > 1;
+            std::printf("%3ux%-3u %-10s vector %8.2f us (%6.1f Mpx/s, diff %d)  fixed %8.2f us "
+                    "(%6.1f Mpx/s, diff %d)  %5.2f flying/frame%s\n", up.width, up.height,
+                    mode == VL53L7CX_UPSAMPLE_BILINEAR ? "bilinear" : "edge-aware",
+                    vector_s * 1e6, pixels / vector_s / 1e6, vector_diff, fixed_s * 1e6,
+                    pixels / fixed_s / 1e6, fixed_diff, double(flying) / nb_frames,
+                    size_failed ? "  FAILED" : "");
+            failed |= size_failed;
+        }
+    }
+    return failed ? 1 : 0;
+}
@@ -0,0 +1,45 @@
+/**
+ * Checks of the VL53L7CX Host Runs (host side)
+ *
+ * Shared by the *_run tools, which print one line per check and exit with 1
+ * if one fails (registered with CTest, see CMakeLists.txt):
+ * - check() prints the name of a check and its result;
+ * - compare() counts the zones of decoded results which differ from the ones
+ *   the simulated device produced (SimulatedDevice::last_frame()).
+ */
+
+#ifndef VL53L7CX_CHECK_HPP_
+#define VL53L7CX_CHECK_HPP_
+
+#include <cstdint>
+#include <cstdio>
+
+extern "C" {
+#include "vl53l7cx_api.h"
+}
+
+namespace vl53l7cx {
+
+/* Print "name ok" or "name FAILED"; returns ok */
+inline bool check(const char *name, bool ok)
+{
+    std::printf("%-11s %s\n", name, ok ? "ok" : "FAILED");
+    return ok;
+}
+
+/* Targets whose distance, status or sigma differ, out of resolution zones */
+inline unsigned compare(const VL53L7CX_ResultsData &expected,
+        const VL53L7CX_ResultsData &results, uint8_t resolution)
+{
+    unsigned diff = 0;
+    for (uint32_t i = 0; i < resolution * VL53L7CX_NB_TARGET_PER_ZONE; i++) {
+        diff += (expected.distance_mm[i] != results.distance_mm[i]
+                || expected.target_status[i] != results.target_status[i]
+                || expected.range_sigma_mm[i] != results.range_sigma_mm[i]) ? 1 : 0;
+    }
+    return diff;
+}
+
+} // namespace vl53l7cx
+
+#endif /* VL53L7CX_CHECK_HPP_ */
@@ -0,0 +1,278 @@
+/**
+ * Threaded Frame Reader for VL53L7CX (host side)
+ *
+ * See vl53l7cx_reader.hpp and vl53l7cx_reader.h.
+ */
+
+#include "vl53l7cx_reader.hpp"
+
+#include <cerrno>
+#include <chrono>
+#include <new>
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/stat.h>
+#include <termios.h>
+#include <unistd.h>
+
+namespace vl53l7cx {
+
+void copy_frame(const FrameView &view, ReaderFrame &frame)
+{
+    uint16_t mask = view.field_mask() & ~kDistanceDelta;
+    if (view.distance_mm().empty()) {
+        mask &= ~kDistanceMm;   // Delta frame without reference
+    }
+
+    frame.timestamp_us = view.timestamp_us();
+    frame.sequence = view.sequence();
+    frame.field_mask = mask;
+    frame.sensor = view.sensor();
+    frame.resolution = view.resolution();
+    frame.nb_targets = view.nb_targets();
+    frame.stream_count = view.stream_count();
+    frame.silicon_temp_degc = view.silicon_temp_degc();
+
+    // FrameView::parse() bounds zones to 64 and targets to 4: arrays fit
+    view.ambient_per_spad().copy_to(frame.ambient_per_spad);
+    view.nb_spads_enabled().copy_to(frame.nb_spads_enabled);
+    view.nb_target_detected().copy_to(frame.nb_target_detected);
+    view.signal_per_spad().copy_to(frame.signal_per_spad);
+    view.range_sigma_mm().copy_to(frame.range_sigma_mm);
+    view.distance_mm().copy_to(frame.distance_mm);
+    view.reflectance().copy_to(frame.reflectance);
+    view.target_status().copy_to(frame.target_status);
+
+    const MotionView &motion = view.motion_indicator();
+    frame.motion_global_indicator_1 = motion.global_indicator_1;
+    frame.motion_global_indicator_2 = motion.global_indicator_2;
+    frame.motion_status = motion.status;
+    frame.motion_nb_of_detected_aggregates = motion.nb_of_detected_aggregates;
+    frame.motion_nb_of_aggregates = motion.nb_of_aggregates;
+    motion.motion.copy_to(frame.motion);
+}
+
+FrameReader::FrameReader(size_t capacity) : ring_(capacity ? capacity : 64)
+{
+}
+
+FrameReader::~FrameReader()
+{
+    close();
+}
+
+bool FrameReader::open(const char *path)
+{
+    close();
+
+    int fd = ::open(path, O_RDONLY | O_NOCTTY);
+    if (fd < 0) {
+        return false;
+    }
+
+    // Serial port: raw mode, so no byte of a frame is translated or eaten
+    struct stat info;
+    struct termios tio;
+    if (isatty(fd) && tcgetattr(fd, &tio) == 0) {
+        cfmakeraw(&tio);
+        tcsetattr(fd, TCSANOW, &tio);
+    }
+
+    fd_ = fd;
+    live_ = !(fstat(fd, &info) == 0 && S_ISREG(info.st_mode));
+    head_ = 0;
+    count_ = 0;
+    ended_ = false;
+    overruns_ = 0;
+    decoder_ = StreamDecoder();
+    decoder_stats_ = StreamStats();
+    stop_ = false;
+    thread_ = std::thread(&FrameReader::run, this);
+    return true;
+}
+
+void FrameReader::close()
+{
+    if (thread_.joinable()) {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            stop_ = true;
+        }
+        writable_.notify_all();
+        thread_.join();
+    }
+    if (fd_ >= 0) {
+        ::close(fd_);
+        fd_ = -1;
+    }
+}
+
+void FrameReader::run()
+{
+    uint8_t chunk[4096];
+    const StreamDecoder::Handler handler = [this](const FrameView &view) { push(view); };
+
+    while (!stop_) {
+        // A serial port is polled, so close() does not wait for the next byte
+        if (live_) {
+            struct pollfd pfd = {fd_, POLLIN, 0};
+            int ready = poll(&pfd, 1, 100);
+            if (ready == 0 || (ready < 0 && errno == EINTR)) {
+                continue;
+            }
+            if (ready < 0) {
+                break;
+            }
+        }
+
+        ssize_t nb_read = ::read(fd_, chunk, sizeof(chunk));
+        if (nb_read < 0 && errno == EINTR) {
+            continue;
+        }
+        if (nb_read <= 0) {
+            break;      // End of file, device unplugged or read error
+        }
+        decoder_.feed(chunk, static_cast<size_t>(nb_read), handler);
+
+        std::lock_guard<std::mutex> lock(mutex_);
+        decoder_stats_ = decoder_.stats();
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        decoder_stats_ = decoder_.stats();
+        ended_ = true;
+    }
+    readable_.notify_all();
+}
+
+void FrameReader::push(const FrameView &view)
+{
+    std::unique_lock<std::mutex> lock(mutex_);
+
+    if (count_ == ring_.size()) {
+        if (live_) {
+            head_ = (head_ + 1) % ring_.size();     // Drop the oldest frame
+            count_--;
+            overruns_++;
+        } else {
+            writable_.wait(lock, [this] { return count_ < ring_.size() || stop_; });
+            if (stop_) {
+                return;
+            }
+        }
+    }
+
+    copy_frame(view, ring_[(head_ + count_) % ring_.size()]);
+    count_++;
+    decoder_stats_ = decoder_.stats();
+    lock.unlock();
+    readable_.notify_one();
+}
+
+int FrameReader::read(ReaderFrame *frames, size_t max_frames, int timeout_ms)
+{
+    std::unique_lock<std::mutex> lock(mutex_);
+    auto ready = [this] { return count_ > 0 || ended_; };
+
+    if (timeout_ms < 0) {
+        readable_.wait(lock, ready);
+    } else if (timeout_ms > 0) {
+        readable_.wait_for(lock, std::chrono::milliseconds(timeout_ms), ready);
+    }
+    if (count_ == 0) {
+        return ended_ ? -1 : 0;
+    }
+
+    size_t nb_frames = (max_frames < count_) ? max_frames : count_;
+    for (size_t i = 0; i < nb_frames; i++) {
+        frames[i] = ring_[(head_ + i) % ring_.size()];
+    }
+    head_ = (head_ + nb_frames) % ring_.size();
+    count_ -= nb_frames;
+    lock.unlock();
+    writable_.notify_one();
+
+    return static_cast<int>(nb_frames);
+}
+
+int FrameReader::latest(ReaderFrame &frame)
+{
+    std::unique_lock<std::mutex> lock(mutex_);
+
+    if (count_ == 0) {
+        return ended_ ? -1 : 0;
+    }
+    frame = ring_[(head_ + count_ - 1) % ring_.size()];
+    head_ = (head_ + count_) % ring_.size();
+    count_ = 0;
+    lock.unlock();
+    writable_.notify_one();
+
+    return 1;
+}
+
+ReaderStats FrameReader::stats() const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    ReaderStats stats = {};
+
+    stats.frames = decoder_stats_.frames;
+    stats.bad_crc = decoder_stats_.bad_crc;
+    stats.bad_frames = decoder_stats_.bad_frames;
+    stats.lost = decoder_stats_.lost;
+    stats.no_reference = decoder_stats_.no_reference;
+    stats.bytes = decoder_stats_.bytes;
+    stats.nb_overruns = overruns_;
+    stats.nb_queued = static_cast<uint32_t>(count_);
+    stats.ended = ended_ ? 1 : 0;
+    return stats;
+}
+
+} // namespace vl53l7cx
+
+/* C interface: the opaque handle is the C++ reader */
+
+struct VL53L7CX_Reader {
+    explicit VL53L7CX_Reader(size_t capacity) : reader(capacity) {}
+    vl53l7cx::FrameReader reader;
+};
+
+extern "C" VL53L7CX_Reader *vl53l7cx_reader_open(const char *path, uint32_t nb_frames)
+{
+    VL53L7CX_Reader *p_reader;
+    try {
+        p_reader = new VL53L7CX_Reader(nb_frames);
+    } catch (const std::bad_alloc &) {
+        errno = ENOMEM;
+        return nullptr;
+    }
+    if (!p_reader->reader.open(path)) {
+        int error = errno;
+        delete p_reader;
+        errno = error;
+        return nullptr;
+    }
+    return p_reader;
+}
+
+extern "C" int32_t vl53l7cx_reader_read(VL53L7CX_Reader *p_reader,
+        VL53L7CX_ReaderFrame *p_frames, uint32_t max_frames, int32_t timeout_ms)
+{
+    return p_reader->reader.read(p_frames, max_frames, timeout_ms);
+}
+
+extern "C" int32_t vl53l7cx_reader_latest(VL53L7CX_Reader *p_reader, VL53L7CX_ReaderFrame *p_frame)
+{
+    return p_reader->reader.latest(*p_frame);
+}
+
+extern "C" void vl53l7cx_reader_get_stats(VL53L7CX_Reader *p_reader, VL53L7CX_ReaderStats *p_stats)
+{
+    *p_stats = p_reader->reader.stats();
+}
+
+extern "C" void vl53l7cx_reader_close(VL53L7CX_Reader *p_reader)
+{
+    delete p_reader;
+}
@@ -0,0 +1,126 @@
+/**
+ * Threaded Frame Reader for VL53L7CX (host side, C interface)
+ *
+ * Reads the binary stream (vl53l7cx_stream.h) from the Pico 2 USB serial port,
+ * or from a capture file, on its own thread, and keeps the decoded frames in a
+ * ring of fixed size frames: no allocation per frame, and the consumer (a GUI
+ * refreshing at 10 Hz, a script) does not have to keep up with the sensor.
+ *
+ * A serial port is read live: when the ring is full the oldest frame is
+ * dropped (counted in nb_overruns). A capture file is replayed as fast as the
+ * consumer reads it, without loss.
+ *
+ * This interface only uses C types, for bindings (vl53l7cx_reader.py loads
+ * libvl53l7cx_reader with ctypes). The C++ class is in vl53l7cx_reader.hpp.
+ */
+
+#ifndef VL53L7CX_READER_H_
+#define VL53L7CX_READER_H_
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Largest frame: 8x8 zones, 4 targets per zone.
+ */
+
+#define VL53L7CX_READER_MAX_ZONES       64U
+#define VL53L7CX_READER_MAX_TARGETS     4U
+
+/**
+ * @brief Decoded frame. Arrays are only valid for the fields of field_mask
+ * (VL53L7CX_OUTPUT_* bits), for resolution zones and nb_targets targets per
+ * zone (index zone * nb_targets + target). Delta coding is resolved: a frame
+ * whose distances could not be decoded (frame lost before it) comes without
+ * VL53L7CX_OUTPUT_DISTANCE_MM.
+ */
+
+typedef struct
+{
+    uint64_t timestamp_us;
+    uint32_t sequence;
+    uint16_t field_mask;
+    uint8_t  sensor;
+    uint8_t  resolution;
+    uint8_t  nb_targets;
+    uint8_t  stream_count;
+    int8_t   silicon_temp_degc;
+    uint8_t  motion_status;
+    uint32_t ambient_per_spad[VL53L7CX_READER_MAX_ZONES];
+    uint32_t nb_spads_enabled[VL53L7CX_READER_MAX_ZONES];
+    uint32_t signal_per_spad[VL53L7CX_READER_MAX_ZONES * VL53L7CX_READER_MAX_TARGETS];
+    int16_t  distance_mm[VL53L7CX_READER_MAX_ZONES * VL53L7CX_READER_MAX_TARGETS];
+    uint16_t range_sigma_mm[VL53L7CX_READER_MAX_ZONES * VL53L7CX_READER_MAX_TARGETS];
+    uint8_t  nb_target_detected[VL53L7CX_READER_MAX_ZONES];
+    uint8_t  reflectance[VL53L7CX_READER_MAX_ZONES * VL53L7CX_READER_MAX_TARGETS];
+    uint8_t  target_status[VL53L7CX_READER_MAX_ZONES * VL53L7CX_READER_MAX_TARGETS];
+    uint32_t motion_global_indicator_1;
+    uint32_t motion_global_indicator_2;
+    uint8_t  motion_nb_of_detected_aggregates;
+    uint8_t  motion_nb_of_aggregates;
+    uint8_t  motion_spare[2];
+    uint32_t motion[32];
+} VL53L7CX_ReaderFrame;
+
+/**
+ * @brief Reader statistics (decoder counters, see StreamStats).
+ */
+
+typedef struct
+{
+    uint64_t frames;            /* Valid frames decoded */
+    uint64_t bad_crc;
+    uint64_t bad_frames;
+    uint64_t lost;              /* Sequence gaps (sent, never received) */
+    uint64_t no_reference;
+    uint64_t bytes;
+    uint64_t nb_overruns;       /* Frames dropped: ring full (serial port only) */
+    uint32_t nb_queued;         /* Frames waiting in the ring */
+    uint32_t ended;             /* End of file, device unplugged or read error */
+} VL53L7CX_ReaderStats;
+
+typedef struct VL53L7CX_Reader VL53L7CX_Reader;
+
+/**
+ * @brief Open a serial port or a capture file and start the reader thread
+ * @param path: Device (e.g. /dev/ttyACM0) or capture file
+ * @param nb_frames: Ring capacity, in frames (0: default of 64)
+ * @return Reader, NULL if the path cannot be opened (errno set)
+ */
+VL53L7CX_Reader *vl53l7cx_reader_open(const char *path, uint32_t nb_frames);
+
+/**
+ * @brief Take the oldest frames of the ring
+ * @param p_reader: Reader
+ * @param p_frames: Output frames
+ * @param max_frames: Capacity of p_frames
+ * @param timeout_ms: Wait for the first frame (0: no wait, negative: forever)
+ * @return Number of frames taken, -1 if the stream ended and the ring is empty
+ */
+int32_t vl53l7cx_reader_read(VL53L7CX_Reader *p_reader, VL53L7CX_ReaderFrame *p_frames,
+        uint32_t max_frames, int32_t timeout_ms);
+
+/**
+ * @brief Take the newest frame and drop the older ones (display refresh)
+ * @param p_reader: Reader
+ * @param p_frame: Output frame
+ * @return 1 if a frame was taken, 0 if none is waiting, -1 if the stream
+ * ended and the ring is empty
+ */
+int32_t vl53l7cx_reader_latest(VL53L7CX_Reader *p_reader, VL53L7CX_ReaderFrame *p_frame);
+
+void vl53l7cx_reader_get_stats(VL53L7CX_Reader *p_reader, VL53L7CX_ReaderStats *p_stats);
+
+/**
+ * @brief Stop the reader thread, close the path and free the reader
+ */
+void vl53l7cx_reader_close(VL53L7CX_Reader *p_reader);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* VL53L7CX_READER_H_ */
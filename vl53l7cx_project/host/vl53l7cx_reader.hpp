@@ -0,0 +1,72 @@
+/**
+ * Threaded Frame Reader for VL53L7CX (host side)
+ *
+ * A thread reads the serial port (or a capture file) and feeds a
+ * StreamDecoder; each frame is expanded into a fixed size VL53L7CX_ReaderFrame
+ * in a ring allocated once. The C interface (vl53l7cx_reader.h) wraps this
+ * class for bindings.
+ */
+
+#ifndef VL53L7CX_READER_HPP_
+#define VL53L7CX_READER_HPP_
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "vl53l7cx_reader.h"
+#include "vl53l7cx_stream.hpp"
+
+namespace vl53l7cx {
+
+using ReaderFrame = VL53L7CX_ReaderFrame;
+using ReaderStats = VL53L7CX_ReaderStats;
+
+/* Expand a frame view into a reader frame (fields not in the mask are left as is) */
+void copy_frame(const FrameView &view, ReaderFrame &frame);
+
+class FrameReader {
+public:
+    explicit FrameReader(size_t capacity = 64);
+    ~FrameReader();
+
+    FrameReader(const FrameReader &) = delete;
+    FrameReader &operator=(const FrameReader &) = delete;
+
+    /* Open a device or capture file and start the thread; false with errno set */
+    bool open(const char *path);
+    void close();
+
+    /* See vl53l7cx_reader_read() and vl53l7cx_reader_latest() */
+    int read(ReaderFrame *frames, size_t max_frames, int timeout_ms);
+    int latest(ReaderFrame &frame);
+
+    ReaderStats stats() const;
+
+private:
+    void run();
+    void push(const FrameView &view);
+
+    std::vector<ReaderFrame> ring_;
+    size_t head_ = 0;               // Oldest frame
+    size_t count_ = 0;
+    bool live_ = false;             // Serial port: drop the oldest frame when full
+    bool ended_ = false;
+    uint64_t overruns_ = 0;
+    StreamStats decoder_stats_;     // Copy of the decoder counters, for stats()
+
+    int fd_ = -1;
+    std::atomic<bool> stop_{false};
+    std::thread thread_;
+    mutable std::mutex mutex_;
+    std::condition_variable readable_;
+    std::condition_variable writable_;
+    StreamDecoder decoder_;
+};
+
+} // namespace vl53l7cx
+
+#endif // VL53L7CX_READER_HPP_
@@ -0,0 +1,387 @@
+/**
+ * Session Recordings for VL53L7CX (host side)
+ *
+ * See vl53l7cx_recording.hpp.
+ */
+
+#include "vl53l7cx_recording.hpp"
+
+#include <algorithm>
+#include <cerrno>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace vl53l7cx {
+
+static void put_le(std::vector<uint8_t> &out, uint64_t value, size_t size)
+{
+    for (size_t b = 0; b < size; b++) {
+        out.push_back(static_cast<uint8_t>(value >> (8 * b)));
+    }
+}
+
+size_t packet_size(uint8_t resolution, uint8_t nb_targets, uint16_t field_mask)
+{
+    size_t zones = resolution;
+    size_t targets = zones * nb_targets;
+    size_t size = kStreamHeaderSize + kStreamCrcSize;
+
+    size += (field_mask & kAmbientPerSpad) ? 4 * zones : 0;
+    size += (field_mask & kNbSpadsEnabled) ? 4 * zones : 0;
+    size += (field_mask & kNbTargetDetected) ? zones : 0;
+    size += (field_mask & kSignalPerSpad) ? 4 * targets : 0;
+    size += (field_mask & kRangeSigmaMm) ? 2 * targets : 0;
+    size += (field_mask & kDistanceMm) ? 2 * targets : 0;
+    size += (field_mask & kReflectancePercent) ? targets : 0;
+    size += (field_mask & kTargetStatus) ? targets : 0;
+    size += (field_mask & kMotionIndicator) ? kStreamMotionSize : 0;
+    return size;
+}
+
+Recording::~Recording()
+{
+    close();
+}
+
+Recording::Status Recording::open(const char *path)
+{
+    close();
+
+    int fd = ::open(path, O_RDONLY);
+    if (fd < 0) {
+        return Status::kIoError;
+    }
+    struct stat info;
+    if (fstat(fd, &info) != 0) {
+        int error = errno;
+        ::close(fd);
+        errno = error;
+        return Status::kIoError;
+    }
+    file_size_ = static_cast<size_t>(info.st_size);
+    if (file_size_ < kRecordingHeaderSize + 4) {
+        ::close(fd);
+        file_size_ = 0;
+        return Status::kBadHeader;
+    }
+
+    // The mapping stays valid once the descriptor is closed
+    void *data = mmap(nullptr, file_size_, PROT_READ, MAP_SHARED, fd, 0);
+    int error = errno;
+    ::close(fd);
+    if (data == MAP_FAILED) {
+        file_size_ = 0;
+        errno = error;
+        return Status::kIoError;
+    }
+    data_ = static_cast<const uint8_t *>(data);
+
+    // Header
+    header_size_ = ArrayView<uint32_t>(&data_[12], 1)[0];
+    record_size_ = ArrayView<uint32_t>(&data_[16], 1)[0];
+    size_t nb_sensors = data_[10];
+    if (ArrayView<uint32_t>(&data_[0], 1)[0] != kRecordingMagic) {
+        close();
+        return Status::kBadHeader;
+    }
+    if (ArrayView<uint16_t>(&data_[4], 1)[0] != kRecordingVersion) {
+        close();
+        return Status::kBadVersion;
+    }
+    if (header_size_ != kRecordingHeaderSize + nb_sensors * kRecordingSensorSize + 4
+            || header_size_ > file_size_
+            || ArrayView<uint32_t>(&data_[header_size_ - 4], 1)[0] != crc32(data_, header_size_ - 4)) {
+        close();
+        return Status::kBadHeader;
+    }
+    if (nb_targets() == 0 || nb_targets() > kStreamMaxTargets
+            || (resolution() != 16 && resolution() != 64)
+            || record_size_ != packet_size(resolution(), nb_targets(), field_mask())) {
+        close();
+        return Status::kBadSize;
+    }
+
+    for (size_t s = 0; s < nb_sensors; s++) {
+        const uint8_t *block = &data_[kRecordingHeaderSize + s * kRecordingSensorSize];
+        RecordingSensor sensor;
+        sensor.sensor = block[0];
+        sensor.ranging_mode = block[1];
+        sensor.frequency_hz = block[2];
+        sensor.target_order = block[3];
+        sensor.sharpener_percent = block[4];
+        sensor.i2c_address = ArrayView<uint16_t>(&block[6], 1)[0];
+        sensor.integration_time_ms = ArrayView<uint32_t>(&block[8], 1)[0];
+        if (ArrayView<uint16_t>(&block[12], 1)[0] == kRecordingCalibrationSize) {
+            sensor.calibration = &block[16];
+        }
+        sensors_.push_back(sensor);
+    }
+
+    // Ended recording: trust the trailer. Cut one: count the records from
+    // the file size, and drop a torn last record.
+    if (!read_trailer()) {
+        nb_records_ = (file_size_ - header_size_) / record_size_;
+        while (nb_records_ > 0 && !valid(nb_records_ - 1)) {
+            nb_records_--;
+        }
+    }
+
+    return Status::kOk;
+}
+
+bool Recording::read_trailer()
+{
+    if (file_size_ < header_size_ + kRecordingTrailerSize) {
+        return false;
+    }
+
+    const uint8_t *trailer = data_ + file_size_ - kRecordingTrailerSize;
+    size_t nb_records = ArrayView<uint32_t>(&trailer[4], 1)[0];
+    size_t stride = ArrayView<uint32_t>(&trailer[8], 1)[0];
+    size_t nb_entries = ArrayView<uint32_t>(&trailer[12], 1)[0];
+    if (ArrayView<uint32_t>(&trailer[0], 1)[0] != kRecordingIndexMagic || stride == 0) {
+        return false;
+    }
+
+    // Sizes first, so the CRC is never computed past the mapping
+    size_t index_size = nb_entries * 8;
+    if (header_size_ + nb_records * record_size_ + index_size + kRecordingTrailerSize != file_size_) {
+        return false;
+    }
+    const uint8_t *index = trailer - index_size;
+    if (ArrayView<uint32_t>(&trailer[20], 1)[0] != crc32(index, index_size + kRecordingTrailerSize - 4)) {
+        return false;
+    }
+
+    nb_records_ = nb_records;
+    index_ = index;
+    nb_entries_ = nb_entries;
+    stride_ = stride;
+    complete_ = true;
+    return true;
+}
+
+void Recording::close()
+{
+    if (data_) {
+        munmap(const_cast<uint8_t *>(data_), file_size_);
+    }
+    data_ = nullptr;
+    file_size_ = 0;
+    header_size_ = 0;
+    record_size_ = 0;
+    nb_records_ = 0;
+    complete_ = false;
+    index_ = nullptr;
+    nb_entries_ = 0;
+    stride_ = 0;
+    sensors_.clear();
+}
+
+bool Recording::valid(size_t i) const
+{
+    FrameView view;
+    return frame(i, view);
+}
+
+bool Recording::frame(size_t i, FrameView &frame) const
+{
+    return i < nb_records_
+            && frame.parse(record(i), record_size_) == FrameView::Status::kOk
+            && frame.sequence() == i;
+}
+
+size_t Recording::find(uint64_t timestamp_us) const
+{
+    size_t low = 0;
+    size_t high = nb_records_;
+
+    // The index narrows the search to one stride
+    if (index_) {
+        ArrayView<uint64_t> index(index_, nb_entries_);
+        size_t first = 0;
+        size_t last = nb_entries_;
+        while (first < last) {
+            size_t middle = first + (last - first) / 2;
+            if (index[middle] < timestamp_us) {
+                first = middle + 1;
+            } else {
+                last = middle;
+            }
+        }
+        if (first > 0) {
+            low = (first - 1) * stride_;
+        }
+        if (first < nb_entries_) {
+            high = std::min(high, first * stride_);
+        }
+    }
+
+    while (low < high) {
+        size_t middle = low + (high - low) / 2;
+        if (this->timestamp_us(middle) < timestamp_us) {
+            low = middle + 1;
+        } else {
+            high = middle;
+        }
+    }
+    return low;
+}
+
+RecordingWriter::~RecordingWriter()
+{
+    close();
+}
+
+bool RecordingWriter::open(const char *path, uint8_t resolution, uint8_t nb_targets,
+        uint16_t field_mask, const std::vector<RecordingSensor> &sensors, uint64_t start_time_us)
+{
+    close();
+
+    if ((resolution != 16 && resolution != 64) || nb_targets == 0
+            || nb_targets > kStreamMaxTargets || sensors.size() > 255) {
+        errno = EINVAL;
+        return false;
+    }
+    file_ = std::fopen(path, "wb");
+    if (!file_) {
+        return false;
+    }
+
+    failed_ = false;
+    resolution_ = resolution;
+    nb_targets_ = nb_targets;
+    field_mask_ = field_mask & ~kDistanceDelta;
+    record_size_ = packet_size(resolution, nb_targets, field_mask_);
+    index_.clear();
+
+    std::vector<uint8_t> header;
+    put_le(header, kRecordingMagic, 4);
+    put_le(header, kRecordingVersion, 2);
+    put_le(header, resolution, 1);
+    put_le(header, nb_targets, 1);
+    put_le(header, field_mask_, 2);
+    put_le(header, sensors.size(), 1);
+    put_le(header, 0, 1);
+    put_le(header, kRecordingHeaderSize + sensors.size() * kRecordingSensorSize + 4, 4);
+    put_le(header, record_size_, 4);
+    put_le(header, 0, 4);
+    put_le(header, start_time_us, 8);
+    for (const RecordingSensor &sensor : sensors) {
+        put_le(header, sensor.sensor, 1);
+        put_le(header, sensor.ranging_mode, 1);
+        put_le(header, sensor.frequency_hz, 1);
+        put_le(header, sensor.target_order, 1);
+        put_le(header, sensor.sharpener_percent, 1);
+        put_le(header, 0, 1);
+        put_le(header, sensor.i2c_address, 2);
+        put_le(header, sensor.integration_time_ms, 4);
+        put_le(header, sensor.calibration ? kRecordingCalibrationSize : 0, 2);
+        put_le(header, 0, 2);
+        if (sensor.calibration) {
+            header.insert(header.end(), sensor.calibration, sensor.calibration + kRecordingCalibrationSize);
+        } else {
+            header.resize(header.size() + kRecordingCalibrationSize, 0);
+        }
+    }
+    put_le(header, crc32(header.data(), header.size()), 4);
+
+    return write(header.data(), header.size());
+}
+
+bool RecordingWriter::write(const uint8_t *data, size_t size)
+{
+    if (!file_ || failed_) {
+        return false;
+    }
+    // Stop at the first error: a partial write would shift the next records
+    if (std::fwrite(data, 1, size, file_) != size) {
+        failed_ = true;
+        return false;
+    }
+    return true;
+}
+
+bool RecordingWriter::append(const FrameView &frame)
+{
+    uint16_t mask = frame.field_mask() & ~kDistanceDelta;
+    if (frame.resolution() != resolution_ || frame.nb_targets() != nb_targets_
+            || mask != field_mask_ || (frame.has(kDistanceMm) && frame.distance_mm().empty())) {
+        return false;   // Other layout, or delta distances without reference
+    }
+
+    // Stream header, with the mask of the recording and the record number
+    record_.assign(frame.packet(), frame.packet() + kStreamHeaderSize);
+    record_[4] = static_cast<uint8_t>(mask);
+    record_[5] = static_cast<uint8_t>(mask >> 8);
+    for (size_t b = 0; b < 4; b++) {
+        record_[8 + b] = static_cast<uint8_t>(index_.size() >> (8 * b));
+    }
+
+    // Fields: every view points to little-endian bytes (in the packet, or in
+    // the decoder reference for delta distances)
+    auto append_view = [this](const uint8_t *data, size_t size) {
+        if (data) {
+            record_.insert(record_.end(), data, data + size);
+        }
+    };
+    append_view(frame.ambient_per_spad().data(), frame.ambient_per_spad().size() * 4);
+    append_view(frame.nb_spads_enabled().data(), frame.nb_spads_enabled().size() * 4);
+    append_view(frame.nb_target_detected().data(), frame.nb_target_detected().size());
+    append_view(frame.signal_per_spad().data(), frame.signal_per_spad().size() * 4);
+    append_view(frame.range_sigma_mm().data(), frame.range_sigma_mm().size() * 2);
+    append_view(frame.distance_mm().data(), frame.distance_mm().size() * 2);
+    append_view(frame.reflectance().data(), frame.reflectance().size());
+    append_view(frame.target_status().data(), frame.target_status().size());
+    if (frame.has(kMotionIndicator)) {
+        // Motion block: 12 bytes of indicators before the motion array
+        append_view(frame.motion_indicator().motion.data() - 12, kStreamMotionSize);
+    }
+    put_le(record_, crc32(record_.data(), record_.size()), 4);
+    if (record_.size() != record_size_) {
+        return false;
+    }
+
+    if (!write(record_.data(), record_.size())) {
+        return false;
+    }
+    index_.push_back(frame.timestamp_us());
+
+    // Durable every 64 records, as the firmware writer
+    if (index_.size() % 64 == 0 && (std::fflush(file_) != 0 || fsync(fileno(file_)) != 0)) {
+        failed_ = true;
+        return false;
+    }
+    return true;
+}
+
+bool RecordingWriter::close()
+{
+    if (!file_) {
+        return true;
+    }
+
+    // A failed recording is closed without index: readers recover it
+    bool ok = !failed_;
+    if (ok) {
+        std::vector<uint8_t> trailer;
+        for (uint64_t timestamp_us : index_) {
+            put_le(trailer, timestamp_us, 8);
+        }
+        put_le(trailer, kRecordingIndexMagic, 4);
+        put_le(trailer, index_.size(), 4);
+        put_le(trailer, 1, 4);
+        put_le(trailer, index_.size(), 4);
+        put_le(trailer, 0, 4);
+        put_le(trailer, crc32(trailer.data(), trailer.size()), 4);
+        ok = write(trailer.data(), trailer.size())
+                && std::fflush(file_) == 0 && fsync(fileno(file_)) == 0;
+    }
+    ok = (std::fclose(file_) == 0) && ok;
+    file_ = nullptr;
+    return ok;
+}
+
+} // namespace vl53l7cx
@@ -0,0 +1,142 @@
+/**
+ * Session Recordings for VL53L7CX (host side)
+ *
+ * Reader and writer of the recording files of vl53l7cx_recording.h. A
+ * Recording maps the file: frame n is at a computed offset and is parsed in
+ * place by a FrameView, so a session of any length is opened in constant time
+ * and only the pages read are loaded. A RecordingWriter turns stream frames
+ * (vl53l7cx_stream.hpp) into a recording.
+ */
+
+#ifndef VL53L7CX_RECORDING_HPP_
+#define VL53L7CX_RECORDING_HPP_
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <vector>
+#include "vl53l7cx_stream.hpp"
+
+namespace vl53l7cx {
+
+/* Must match vl53l7cx_recording.h */
+constexpr uint32_t kRecordingMagic = 0x52374C56;       // "VL7R"
+constexpr uint32_t kRecordingIndexMagic = 0x49374C56;  // "VL7I"
+constexpr uint16_t kRecordingVersion = 1;
+constexpr size_t kRecordingHeaderSize = 32;
+constexpr size_t kRecordingCalibrationSize = 1284;
+constexpr size_t kRecordingSensorSize = 16 + kRecordingCalibrationSize;
+constexpr size_t kRecordingTrailerSize = 24;
+
+/**
+ * Sensor block of the header.
+ */
+struct RecordingSensor {
+    uint8_t sensor = 0;
+    uint8_t ranging_mode = 0;
+    uint8_t frequency_hz = 0;
+    uint8_t target_order = 0;
+    uint8_t sharpener_percent = 0;
+    uint16_t i2c_address = 0;
+    uint32_t integration_time_ms = 0;
+    const uint8_t *calibration = nullptr;  // VL53L7CX_CalRecord bytes, nullptr if none
+};
+
+/**
+ * Read-only mapped recording.
+ */
+class Recording {
+public:
+    enum class Status { kOk, kIoError, kBadHeader, kBadVersion, kBadSize };
+
+    Recording() = default;
+    ~Recording();
+
+    Recording(const Recording &) = delete;
+    Recording &operator=(const Recording &) = delete;
+
+    /* Map a recording; kIoError with errno set */
+    Status open(const char *path);
+    void close();
+
+    size_t size() const { return nb_records_; }
+    bool complete() const { return complete_; }     // Trailer found (recording ended)
+    uint8_t resolution() const { return data_[6]; }
+    uint8_t nb_targets() const { return data_[7]; }
+    uint16_t field_mask() const { return ArrayView<uint16_t>(&data_[8], 1)[0]; }
+    size_t record_size() const { return record_size_; }
+    uint64_t start_time_us() const { return ArrayView<uint64_t>(&data_[24], 1)[0]; }
+    const std::vector<RecordingSensor> &sensors() const { return sensors_; }
+
+    /* Record i, parsed in place (O(1)); false if it is corrupted */
+    bool frame(size_t i, FrameView &frame) const;
+
+    /* Header fields of record i, not checked (no CRC computed) */
+    uint64_t timestamp_us(size_t i) const { return ArrayView<uint64_t>(record(i) + 12, 1)[0]; }
+    uint8_t sensor(size_t i) const { return record(i)[1]; }
+
+    /* First record at or after timestamp_us, size() if none. Records are
+     * expected in time order (as added by the writers). */
+    size_t find(uint64_t timestamp_us) const;
+
+private:
+    const uint8_t *record(size_t i) const { return data_ + header_size_ + i * record_size_; }
+    bool valid(size_t i) const;
+    bool read_trailer();
+
+    const uint8_t *data_ = nullptr;
+    size_t file_size_ = 0;
+    size_t header_size_ = 0;
+    size_t record_size_ = 0;
+    size_t nb_records_ = 0;
+    bool complete_ = false;
+    const uint8_t *index_ = nullptr;    // Timestamps of records 0, stride, 2 x stride...
+    size_t nb_entries_ = 0;
+    size_t stride_ = 0;
+    std::vector<RecordingSensor> sensors_;
+};
+
+/**
+ * Writes stream frames into a recording. The index is complete (stride 1).
+ */
+class RecordingWriter {
+public:
+    RecordingWriter() = default;
+    ~RecordingWriter();
+
+    RecordingWriter(const RecordingWriter &) = delete;
+    RecordingWriter &operator=(const RecordingWriter &) = delete;
+
+    /* Create the file and write the header; false with errno set */
+    bool open(const char *path, uint8_t resolution, uint8_t nb_targets, uint16_t field_mask,
+            const std::vector<RecordingSensor> &sensors, uint64_t start_time_us);
+
+    /* Append a frame, which must carry exactly the fields of the recording
+     * (delta coded distances are written decoded); false if it does not fit
+     * the recording or on write error */
+    bool append(const FrameView &frame);
+
+    /* Write the index and trailer, and close; false on write error */
+    bool close();
+
+    size_t size() const { return index_.size(); }
+
+private:
+    bool write(const uint8_t *data, size_t size);
+
+    std::FILE *file_ = nullptr;
+    bool failed_ = false;
+    uint8_t resolution_ = 0;
+    uint8_t nb_targets_ = 0;
+    uint16_t field_mask_ = 0;
+    size_t record_size_ = 0;
+    std::vector<uint8_t> record_;
+    std::vector<uint64_t> index_;
+};
+
+/* Size of a packet without delta coding (vl53l7cx_stream_packet_size()) */
+size_t packet_size(uint8_t resolution, uint8_t nb_targets, uint16_t field_mask);
+
+} // namespace vl53l7cx
+
+#endif // VL53L7CX_RECORDING_HPP_
@@ -0,0 +1,387 @@
+/**
+ * Recording Replay for VL53L7CX (host side)
+ *
+ * See vl53l7cx_replay.hpp.
+ */
+
+#include "vl53l7cx_replay.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <thread>
+
+namespace vl53l7cx {
+
+/* Output blocks, in the order of the output list sent by the driver
+ * (_vl53l7cx_build_output_list()): bit i of the enables is block i */
+static const uint32_t kOutputBlocks[VL53L7CX_NB_OUTPUT_BH] = {
+    VL53L7CX_START_BH,
+    VL53L7CX_METADATA_BH,
+    VL53L7CX_COMMONDATA_BH,
+    VL53L7CX_AMBIENT_RATE_BH,
+    VL53L7CX_SPAD_COUNT_BH,
+    VL53L7CX_NB_TARGET_DETECTED_BH,
+    VL53L7CX_SIGNAL_RATE_BH,
+    VL53L7CX_RANGE_SIGMA_MM_BH,
+    VL53L7CX_DISTANCE_BH,
+    VL53L7CX_REFLECTANCE_BH,
+    VL53L7CX_TARGET_STATUS_BH,
+    VL53L7CX_MOTION_DETECT_BH,
+};
+
+/* Block header of block i for a resolution, and the size of its data; false
+ * if the block is not enabled */
+static bool output_block(size_t i, uint8_t resolution, uint32_t output_mask,
+        union Block_header &bh, uint32_t &data_size)
+{
+    uint32_t enables = VL53L7CX_OUTPUT_MANDATORY | (output_mask & VL53L7CX_OUTPUT_AVAILABLE);
+    if ((enables & (1U << i)) == 0) {
+        return false;
+    }
+
+    bh.bytes = kOutputBlocks[i];
+    if (bh.type >= 0x1 && bh.type < 0xd) {
+        if (bh.idx >= 0x54d0 && bh.idx < 0x54d0 + 960) {
+            bh.size = resolution;
+        } else {
+            bh.size = resolution * VL53L7CX_NB_TARGET_PER_ZONE;
+        }
+        data_size = bh.type * bh.size;
+    } else {
+        data_size = bh.size;
+    }
+    return true;
+}
+
+uint32_t ranging_frame_size(uint8_t resolution, uint32_t output_mask)
+{
+    uint32_t size = 24;
+
+    for (size_t i = 0; i < VL53L7CX_NB_OUTPUT_BH; i++) {
+        union Block_header bh;
+        uint32_t data_size;
+        if (output_block(i, resolution, output_mask, bh, data_size)) {
+            size += 4 + data_size;
+        }
+    }
+    return size;
+}
+
+/* Source of the data of a block in the results, nullptr if none */
+static const void *block_data(const VL53L7CX_ResultsData &results, uint16_t idx)
+{
+    switch (idx) {
+#ifndef VL53L7CX_DISABLE_AMBIENT_PER_SPAD
+    case VL53L7CX_AMBIENT_RATE_IDX:
+        return results.ambient_per_spad;
+#endif
+#ifndef VL53L7CX_DISABLE_NB_SPADS_ENABLED
+    case VL53L7CX_SPAD_COUNT_IDX:
+        return results.nb_spads_enabled;
+#endif
+#ifndef VL53L7CX_DISABLE_NB_TARGET_DETECTED
+    case VL53L7CX_NB_TARGET_DETECTED_IDX:
+        return results.nb_target_detected;
+#endif
+#ifndef VL53L7CX_DISABLE_SIGNAL_PER_SPAD
+    case VL53L7CX_SIGNAL_RATE_IDX:
+        return results.signal_per_spad;
+#endif
+#ifndef VL53L7CX_DISABLE_RANGE_SIGMA_MM
+    case VL53L7CX_RANGE_SIGMA_MM_IDX:
+        return results.range_sigma_mm;
+#endif
+#ifndef VL53L7CX_DISABLE_DISTANCE_MM
+    case VL53L7CX_DISTANCE_IDX:
+        return results.distance_mm;
+#endif
+#ifndef VL53L7CX_DISABLE_REFLECTANCE_PERCENT
+    case VL53L7CX_REFLECTANCE_EST_PC_IDX:
+        return results.reflectance;
+#endif
+#ifndef VL53L7CX_DISABLE_TARGET_STATUS
+    case VL53L7CX_TARGET_STATUS_IDX:
+        return results.target_status;
+#endif
+#ifndef VL53L7CX_DISABLE_MOTION_INDICATOR
+    case VL53L7CX_MOTION_DETEC_IDX:
+        return &results.motion_indicator;
+#endif
+    default:
+        return nullptr;
+    }
+}
+
+uint32_t encode_ranging_frame(const VL53L7CX_ResultsData &results, uint8_t resolution,
+        uint32_t output_mask, uint8_t stream_count, uint16_t header_id, uint16_t footer_id,
+        uint8_t *frame, uint32_t capacity)
+{
+    uint32_t size = ranging_frame_size(resolution, output_mask);
+    if (size > capacity) {
+        return 0;
+    }
+
+    // Built in host order (as after VL53L7CX_SwapBuffer()), then swapped:
+    // every block is a whole number of 32-bit words
+    std::memset(frame, 0, size);
+    frame[0x8] = static_cast<uint8_t>(header_id >> 8);
+    frame[0x9] = static_cast<uint8_t>(header_id);
+
+    uint32_t pos = 16;
+    for (size_t i = 0; i < VL53L7CX_NB_OUTPUT_BH; i++) {
+        union Block_header bh;
+        uint32_t data_size;
+        if (!output_block(i, resolution, output_mask, bh, data_size)) {
+            continue;
+        }
+        std::memcpy(&frame[pos], &bh.bytes, 4);
+        if (bh.idx == VL53L7CX_METADATA_IDX) {
+            frame[pos + 12] = static_cast<uint8_t>(results.silicon_temp_degc);
+        } else if (const void *data = block_data(results, bh.idx)) {
+            std::memcpy(&frame[pos + 4], data, data_size);
+        }
+        pos += 4 + data_size;
+    }
+
+    frame[size - 4] = static_cast<uint8_t>(footer_id >> 8);
+    frame[size - 3] = static_cast<uint8_t>(footer_id);
+    VL53L7CX_SwapBuffer(frame, static_cast<uint16_t>(size));
+
+    // UI status word, read as is by vl53l7cx_check_data_ready()
+    frame[0] = stream_count;
+    frame[1] = 0x05;
+    frame[2] = 0x05;
+    frame[3] = 0x10;
+    return size;
+}
+
+bool results_from_frame(const FrameView &frame, VL53L7CX_ResultsData &results)
+{
+    if (frame.nb_targets() != VL53L7CX_NB_TARGET_PER_ZONE || frame.resolution() > 64) {
+        return false;
+    }
+
+    results.silicon_temp_degc = frame.silicon_temp_degc();
+#ifndef VL53L7CX_DISABLE_AMBIENT_PER_SPAD
+    frame.ambient_per_spad().copy_to(results.ambient_per_spad);
+#endif
+#ifndef VL53L7CX_DISABLE_NB_SPADS_ENABLED
+    frame.nb_spads_enabled().copy_to(results.nb_spads_enabled);
+#endif
+#ifndef VL53L7CX_DISABLE_NB_TARGET_DETECTED
+    frame.nb_target_detected().copy_to(results.nb_target_detected);
+#endif
+#ifndef VL53L7CX_DISABLE_SIGNAL_PER_SPAD
+    frame.signal_per_spad().copy_to(results.signal_per_spad);
+#endif
+#ifndef VL53L7CX_DISABLE_RANGE_SIGMA_MM
+    frame.range_sigma_mm().copy_to(results.range_sigma_mm);
+#endif
+#ifndef VL53L7CX_DISABLE_DISTANCE_MM
+    frame.distance_mm().copy_to(results.distance_mm);
+#endif
+#ifndef VL53L7CX_DISABLE_REFLECTANCE_PERCENT
+    frame.reflectance().copy_to(results.reflectance);
+#endif
+#ifndef VL53L7CX_DISABLE_TARGET_STATUS
+    frame.target_status().copy_to(results.target_status);
+#endif
+#ifndef VL53L7CX_DISABLE_MOTION_INDICATOR
+    const MotionView &motion = frame.motion_indicator();
+    results.motion_indicator.global_indicator_1 = motion.global_indicator_1;
+    results.motion_indicator.global_indicator_2 = motion.global_indicator_2;
+    results.motion_indicator.status = motion.status;
+    results.motion_indicator.nb_of_detected_aggregates = motion.nb_of_detected_aggregates;
+    results.motion_indicator.nb_of_aggregates = motion.nb_of_aggregates;
+    motion.motion.copy_to(results.motion_indicator.motion);
+#endif
+    return true;
+}
+
+bool ReplayDevice::open(const Recording &recording, uint8_t sensor, const ReplayOptions &options)
+{
+    if (recording.nb_targets() != VL53L7CX_NB_TARGET_PER_ZONE
+            || (recording.resolution() != VL53L7CX_RESOLUTION_4X4
+                && recording.resolution() != VL53L7CX_RESOLUTION_8X8)
+            || options.speed <= 0.0 || (options.pacing == Pacing::kFixedRate && options.rate_hz <= 0.0)) {
+        return false;
+    }
+
+    records_.clear();
+    for (size_t i = 0; i < recording.size(); i++) {
+        if (recording.sensor(i) == sensor) {
+            records_.push_back(i);
+        }
+    }
+    if (records_.empty()) {
+        return false;
+    }
+
+    recording_ = &recording;
+    options_ = options;
+    resolution_ = recording.resolution();
+    output_mask_ = recording.field_mask() & VL53L7CX_OUTPUT_AVAILABLE;
+    frame_size_ = ranging_frame_size(resolution_, output_mask_);
+    frame_.assign(frame_size_, 0);
+    frame_[0] = 255;    // No frame yet
+    current_ = SIZE_MAX;
+    current_read_ = false;
+    last_read_ = SIZE_MAX;
+    produced_ = 0;
+    stats_ = ReplayStats();
+    return true;
+}
+
+void ReplayDevice::attach(VL53L7CX_Configuration &dev)
+{
+    static const VL53L7CX_HostBusOps kOps = {
+        bus_read,
+        bus_write,
+        bus_time_us,
+        bus_wait_us,
+    };
+
+    dev.platform.p_bus = &kOps;
+    dev.platform.p_bus_ctx = this;
+    (void)VL53L7CX_AsyncInit(&dev.platform);
+    dev.streamcount = 255;
+    dev.output_mask = output_mask_;
+    dev.data_read_size = frame_size_;
+
+    start_ = std::chrono::steady_clock::now();
+    virtual_us_ = 0;
+}
+
+bool ReplayDevice::last_frame(FrameView &frame) const
+{
+    return last_read_ != SIZE_MAX && recording_->frame(records_[last_read_], frame);
+}
+
+uint64_t ReplayDevice::time_us()
+{
+    if (options_.pacing == Pacing::kFastest) {
+        return virtual_us_;
+    }
+    double elapsed = std::chrono::duration<double, std::micro>(
+            std::chrono::steady_clock::now() - start_).count();
+    return static_cast<uint64_t>(elapsed * options_.speed);
+}
+
+uint64_t ReplayDevice::due_us(size_t i) const
+{
+    if (options_.pacing == Pacing::kFixedRate) {
+        return static_cast<uint64_t>(i * 1e6 / options_.rate_hz);
+    }
+    return recording_->timestamp_us(records_[i]) - recording_->timestamp_us(records_[0]);
+}
+
+void ReplayDevice::update()
+{
+    size_t next = (current_ == SIZE_MAX) ? 0 : current_ + 1;
+    if (next >= records_.size()) {
+        return;
+    }
+
+    if (options_.pacing == Pacing::kFastest) {
+        if (current_ == SIZE_MAX || current_read_) {
+            virtual_us_ = std::max(virtual_us_, due_us(next));
+            produce(next);
+        }
+        return;
+    }
+
+    // Latest frame due: the ones before it were never read
+    uint64_t now = time_us();
+    if (due_us(next) > now) {
+        return;
+    }
+    while (next + 1 < records_.size() && due_us(next + 1) <= now) {
+        next++;
+    }
+    produce(next);
+}
+
+void ReplayDevice::produce(size_t i)
+{
+    size_t previous = (current_ == SIZE_MAX) ? 0 : current_ + 1;
+    stats_.overwritten += i - previous;
+    if (current_ != SIZE_MAX && !current_read_) {
+        stats_.overwritten++;
+    }
+    // The sensor counts the frames it ranged, also those never read
+    produced_ += i - previous + 1;
+
+    FrameView frame;
+    bool valid = recording_->frame(records_[i], frame) && results_from_frame(frame, results_);
+    if (!valid) {
+        std::memset(&results_, 0, sizeof(results_));
+    }
+
+    uint16_t header_id = static_cast<uint16_t>(produced_);
+    uint16_t footer_id = header_id;
+    if (!valid || (options_.corrupt_every != 0 && produced_ % options_.corrupt_every == 0)) {
+        footer_id = static_cast<uint16_t>(~header_id);
+    }
+    uint8_t stream_count = static_cast<uint8_t>((produced_ - 1) % 255);
+    encode_ranging_frame(results_, resolution_, output_mask_, stream_count, header_id, footer_id,
+            frame_.data(), frame_size_);
+
+    current_ = i;
+    current_read_ = false;
+    current_corrupted_ = footer_id != header_id;
+}
+
+uint8_t ReplayDevice::bus_read(void *ctx, uint16_t address, uint8_t *values, uint32_t size)
+{
+    ReplayDevice &device = *static_cast<ReplayDevice *>(ctx);
+
+    if (address != 0x0) {
+        device.stats_.other_accesses++;
+        std::memset(values, 0, size);
+        return 0;
+    }
+
+    device.update();
+    uint32_t copied = std::min(size, device.frame_size_);
+    std::memcpy(values, device.frame_.data(), copied);
+    std::memset(values + copied, 0, size - copied);
+    device.stats_.bytes += size;
+
+    if (size < device.frame_size_) {
+        device.stats_.status_reads++;
+    } else if (device.current_ != SIZE_MAX && !device.current_read_) {
+        device.current_read_ = true;
+        device.last_read_ = device.current_;
+        device.stats_.frames++;
+        device.stats_.corrupted += device.current_corrupted_ ? 1 : 0;
+    }
+    return 0;
+}
+
+uint8_t ReplayDevice::bus_write(void *ctx, uint16_t address, const uint8_t *values, uint32_t size)
+{
+    (void)address;
+    (void)values;
+    (void)size;
+    static_cast<ReplayDevice *>(ctx)->stats_.other_accesses++;
+    return 0;
+}
+
+uint64_t ReplayDevice::bus_time_us(void *ctx)
+{
+    return static_cast<ReplayDevice *>(ctx)->time_us();
+}
+
+void ReplayDevice::bus_wait_us(void *ctx, uint32_t time_us)
+{
+    ReplayDevice &device = *static_cast<ReplayDevice *>(ctx);
+
+    if (device.options_.pacing == Pacing::kFastest) {
+        device.virtual_us_ += time_us;
+        return;
+    }
+    std::this_thread::sleep_for(std::chrono::duration<double, std::micro>(
+            time_us / device.options_.speed));
+}
+
+} // namespace vl53l7cx
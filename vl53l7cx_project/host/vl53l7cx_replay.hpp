@@ -0,0 +1,134 @@
+/**
+ * Recording Replay for VL53L7CX (host side)
+ *
+ * A ReplayDevice is a simulated sensor behind the host platform layer
+ * (platform/platform_pico.h) which serves the frames of a recording
+ * (vl53l7cx_recording.hpp): each record is turned back into the raw frame the
+ * driver reads at address 0x0, in firmware byte order, with its stream count
+ * and header/footer ids. The unchanged driver (vl53l7cx_check_data_ready(),
+ * vl53l7cx_get_ranging_data(), the asynchronous read) and the code behind it
+ * then run on a host machine, faster than real time.
+ *
+ * Frames are released by a pacing mode:
+ * - kRealTime: at their recorded times, on a clock running speed times faster
+ *   than the wall clock; frames the driver did not read in time are replaced
+ *   by the next one, as on the sensor;
+ * - kFixedRate: every 1 / rate_hz s of the same clock;
+ * - kFastest: the next frame is ready as soon as the previous one was read,
+ *   and the device clock jumps to its recorded time (waits do not sleep).
+ *
+ * Only the ranging data is served: the driver configuration is set by
+ * attach() as after vl53l7cx_start_ranging(); other registers read as 0 and
+ * writes are ignored.
+ */
+
+#ifndef VL53L7CX_REPLAY_HPP_
+#define VL53L7CX_REPLAY_HPP_
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "vl53l7cx_recording.hpp"
+
+extern "C" {
+#include "vl53l7cx_api.h"
+}
+
+namespace vl53l7cx {
+
+/* Size of the raw frame of a resolution and output mask (data_read_size of
+ * the driver) */
+uint32_t ranging_frame_size(uint8_t resolution, uint32_t output_mask);
+
+/*
+ * Build the raw frame of results (16 or 64 zones, VL53L7CX_OUTPUT_* mask) as
+ * read at address 0x0: firmware byte order, stream count in byte 0, header
+ * and footer ids (equal in a valid frame). Returns the frame size, 0 if it
+ * does not fit.
+ */
+uint32_t encode_ranging_frame(const VL53L7CX_ResultsData &results, uint8_t resolution,
+        uint32_t output_mask, uint8_t stream_count, uint16_t header_id, uint16_t footer_id,
+        uint8_t *frame, uint32_t capacity);
+
+/* Copy the fields of a record into driver results; false if the record does
+ * not fit this build (targets per zone) */
+bool results_from_frame(const FrameView &frame, VL53L7CX_ResultsData &results);
+
+enum class Pacing { kRealTime, kFixedRate, kFastest };
+
+struct ReplayOptions {
+    Pacing pacing = Pacing::kRealTime;
+    double speed = 1.0;             // Device clock / wall clock (kRealTime, kFixedRate)
+    double rate_hz = 15.0;          // kFixedRate
+    uint32_t corrupt_every = 0;     // Footer id of every Nth frame wrong, 0: never
+};
+
+struct ReplayStats {
+    uint64_t frames = 0;            // Frames read by the driver
+    uint64_t overwritten = 0;       // Frames replaced before being read
+    uint64_t corrupted = 0;         // Frames read with a wrong footer id
+    uint64_t status_reads = 0;      // Short reads at 0x0 (data ready polls)
+    uint64_t other_accesses = 0;    // Accesses outside the ranging data
+    uint64_t bytes = 0;             // Bytes read at 0x0
+};
+
+class ReplayDevice {
+public:
+    ReplayDevice() = default;
+
+    ReplayDevice(const ReplayDevice &) = delete;
+    ReplayDevice &operator=(const ReplayDevice &) = delete;
+
+    /* Replay the frames of one sensor; false if it has none or the recording
+     * does not fit this build. The recording must outlive the device. */
+    bool open(const Recording &recording, uint8_t sensor, const ReplayOptions &options);
+
+    /* Bind a driver configuration, as after vl53l7cx_start_ranging(), and
+     * start the device clock */
+    void attach(VL53L7CX_Configuration &dev);
+
+    size_t size() const { return records_.size(); }
+    bool finished() const { return current_ + 1 == records_.size() && current_read_; }
+
+    /* Record of the frame read last, for regression checks; false if none or
+     * if the record is corrupted */
+    bool last_frame(FrameView &frame) const;
+
+    /* Device clock (us since attach()) */
+    uint64_t time_us();
+
+    const ReplayStats &stats() const { return stats_; }
+
+private:
+    static uint8_t bus_read(void *ctx, uint16_t address, uint8_t *values, uint32_t size);
+    static uint8_t bus_write(void *ctx, uint16_t address, const uint8_t *values, uint32_t size);
+    static uint64_t bus_time_us(void *ctx);
+    static void bus_wait_us(void *ctx, uint32_t time_us);
+
+    uint64_t due_us(size_t i) const;
+    void update();
+    void produce(size_t i);
+
+    const Recording *recording_ = nullptr;
+    ReplayOptions options_;
+    std::vector<size_t> records_;   // Records of the sensor
+    uint8_t resolution_ = 0;
+    uint32_t output_mask_ = 0;
+    uint32_t frame_size_ = 0;
+
+    std::chrono::steady_clock::time_point start_;
+    uint64_t virtual_us_ = 0;       // kFastest clock
+    size_t current_ = SIZE_MAX;     // Frame in frame_, SIZE_MAX before the first
+    bool current_read_ = false;
+    bool current_corrupted_ = false;
+    size_t last_read_ = SIZE_MAX;
+    uint64_t produced_ = 0;         // Frames produced (stream count, ids)
+    std::vector<uint8_t> frame_;
+    VL53L7CX_ResultsData results_{};
+    ReplayStats stats_;
+};
+
+} // namespace vl53l7cx
+
+#endif // VL53L7CX_REPLAY_HPP_
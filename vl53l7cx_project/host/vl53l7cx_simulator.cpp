@@ -0,0 +1,610 @@
+/**
+ * Register-level Simulator for VL53L7CX (host side)
+ *
+ * See vl53l7cx_simulator.hpp.
+ */
+
+#include "vl53l7cx_simulator.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include "vl53l7cx_replay.hpp"
+
+namespace vl53l7cx {
+
+static const uint32_t kPageSize = 0x8000;
+static const uint32_t kFirmwareSize = 0x15000;  // Downloaded into pages 0x09 to 0x0b
+static const uint16_t kCommandWord = 0x2ffc;    // Kind, operation, list size
+static const uint32_t kEndOfList = 0x0000000f;
+static const uint16_t kRangingInfoIdx = 0x5440; // Frame size, read after start
+static const uint8_t kBootError = 0x66;         // 0x07 when the MCU can't boot
+static const uint8_t kMcuStopped = 0x84;        // 0x07 when the MCU is stopped
+
+/* Data size of a block header (type 1 to 0xc: arrays of type-byte elements) */
+static uint32_t block_data_size(uint32_t header)
+{
+    uint32_t type = header & 0xf;
+    uint32_t size = (header >> 4) & 0xfff;
+    return (type >= 0x1 && type < 0xd) ? type * size : size;
+}
+
+static uint32_t load_be32(const uint8_t *p)
+{
+    return (static_cast<uint32_t>(p[0]) << 24) | (static_cast<uint32_t>(p[1]) << 16)
+            | (static_cast<uint32_t>(p[2]) << 8) | p[3];
+}
+
+static void store_be32(uint8_t *p, uint32_t value)
+{
+    p[0] = static_cast<uint8_t>(value >> 24);
+    p[1] = static_cast<uint8_t>(value >> 16);
+    p[2] = static_cast<uint8_t>(value >> 8);
+    p[3] = static_cast<uint8_t>(value);
+}
+
+void synthetic_scene(uint64_t frame, uint64_t time_us, uint8_t resolution,
+        VL53L7CX_ResultsData &results)
+{
+    (void)frame;
+    const int width = (resolution == VL53L7CX_RESOLUTION_4X4) ? 4 : 8;
+    const double t = time_us / 1e6;
+    // Column of the object, from -1 to width + 1
+    const double object = std::fmod(t / 4.0, 1.0) * (width + 2) - 1.0;
+
+    results.silicon_temp_degc = 32;
+    for (int zone = 0; zone < resolution; zone++) {
+        int column = zone % width;
+        double wall_mm = 1500.0 + 320.0 * (column - width / 2) / width;
+        bool near = std::fabs(column - object) < 1.0;
+        uint8_t nb_targets = 1;
+#if VL53L7CX_NB_TARGET_PER_ZONE > 1
+        nb_targets = near ? 2 : 1;
+#endif
+#ifndef VL53L7CX_DISABLE_AMBIENT_PER_SPAD
+        results.ambient_per_spad[zone] = 2 * 2048;
+#endif
+#ifndef VL53L7CX_DISABLE_NB_SPADS_ENABLED
+        results.nb_spads_enabled[zone] = 12288;
+#endif
+#ifndef VL53L7CX_DISABLE_NB_TARGET_DETECTED
+        results.nb_target_detected[zone] = nb_targets;
+#endif
+
+        for (uint32_t target = 0; target < VL53L7CX_NB_TARGET_PER_ZONE; target++) {
+            [[maybe_unused]] size_t i = zone * VL53L7CX_NB_TARGET_PER_ZONE + target;
+            bool valid = target < nb_targets;
+            [[maybe_unused]] double mm = valid ? ((near && target == 0) ? 600.0 : wall_mm) : 0.0;
+#ifndef VL53L7CX_DISABLE_SIGNAL_PER_SPAD
+            results.signal_per_spad[i] = valid
+                    ? static_cast<uint32_t>(2048 * 4e9 / (mm * mm)) / 1000 : 0;
+#endif
+#ifndef VL53L7CX_DISABLE_RANGE_SIGMA_MM
+            results.range_sigma_mm[i] = valid ? static_cast<uint16_t>((2.0 + mm / 500.0) * 128) : 0;
+#endif
+#ifndef VL53L7CX_DISABLE_DISTANCE_MM
+            results.distance_mm[i] = static_cast<int16_t>(mm * 4);
+#endif
+#ifndef VL53L7CX_DISABLE_REFLECTANCE_PERCENT
+            results.reflectance[i] = valid ? 100 : 0;
+#endif
+#ifndef VL53L7CX_DISABLE_TARGET_STATUS
+            results.target_status[i] = valid ? 5 : 0;
+#endif
+        }
+    }
+}
+
+SimulatedDevice::SimulatedDevice(const SimulatorOptions &options, Scene scene)
+    : options_(options), scene_(std::move(scene))
+{
+    if (options_.i2c_hz == 0) {
+        options_.i2c_hz = 400000;
+    }
+    power_cycle();
+}
+
+void SimulatedDevice::attach(VL53L7CX_Configuration &dev)
+{
+    static const VL53L7CX_HostBusOps kOps = {
+        bus_read,
+        bus_write,
+        bus_time_us,
+        bus_wait_us,
+    };
+
+    dev.platform.p_bus = &kOps;
+    dev.platform.p_bus_ctx = this;
+    (void)VL53L7CX_AsyncInit(&dev.platform);
+}
+
+void SimulatedDevice::power_cycle()
+{
+    for (std::vector<uint8_t> &page : pages_) {
+        page.assign(kPageSize, 0);
+    }
+    firmware_.assign(3 * kPageSize, 0);
+    nvm_.clear();
+    page_ = 0;
+    reboot();
+    mcu_ready_ns_ = now_ns_;    // The ROM runs from power on
+    pages_[0][0x09] = 0x04;
+}
+
+bool SimulatedDevice::running() const
+{
+    return mcu_ == Mcu::kRunning || (mcu_ == Mcu::kBooting && now_ns_ >= mcu_ready_ns_);
+}
+
+uint64_t SimulatedDevice::frame_ready_us(uint64_t frame) const
+{
+    if (!ranging_) {
+        return UINT64_MAX;
+    }
+    return (ranging_start_ns_ + (frame + 1) * period_ns_ + 999) / 1000;
+}
+
+bool SimulatedDevice::dci_block(uint16_t index, std::vector<uint8_t> &data) const
+{
+    auto it = dci_.find(index);
+    if (it == dci_.end()) {
+        return false;
+    }
+    data = it->second;
+    data.resize((data.size() + 3) & ~size_t(3), 0);
+    VL53L7CX_SwapBuffer(data.data(), static_cast<uint16_t>(data.size()));
+    data.resize(it->second.size());
+    return true;
+}
+
+void SimulatedDevice::reset_stats()
+{
+    stats_ = SimulatorStats();
+    bus_ns_ = 0;
+}
+
+bool SimulatedDevice::last_frame(VL53L7CX_ResultsData &results) const
+{
+    if (!has_read_) {
+        return false;
+    }
+    results = read_results_;
+    return true;
+}
+
+/* Reboot sequence (0x0a = 0x01): the ROM restarts, the firmware and its
+ * configuration are lost */
+void SimulatedDevice::reboot()
+{
+    mcu_ = Mcu::kRom;
+    mcu_ready_ns_ = now_ns_ + options_.rom_boot_us * 1000ULL;
+    fw_access_ns_ = UINT64_MAX;
+    firmware_written_ = 0;
+    dci_.clear();
+    awake_ = true;
+    awake_next_ = true;
+    stop_ns_ = UINT64_MAX;
+    command_ = Command();
+    ranging_ = false;
+    pages_[0][0x07] = 0;
+}
+
+/* Time on the bus: address byte, 16-bit register and data (and the address
+ * again for a read), 9 clocks per byte */
+void SimulatedDevice::transfer(uint32_t size, bool read)
+{
+    uint64_t bits = (static_cast<uint64_t>(size) + (read ? 4 : 3)) * 9 + 2;
+    uint64_t ns = bits * 1000000000ULL / options_.i2c_hz;
+
+    now_ns_ += ns;
+    bus_ns_ += ns;
+    stats_.bus_us = bus_ns_ / 1000;
+    if (read) {
+        stats_.reads++;
+        stats_.bytes_read += size;
+    } else {
+        stats_.writes++;
+        stats_.bytes_written += size;
+    }
+}
+
+/* Apply the events due at the current time */
+void SimulatedDevice::update()
+{
+    if (mcu_ == Mcu::kBooting && now_ns_ >= mcu_ready_ns_) {
+        mcu_ = Mcu::kRunning;
+    }
+    if (awake_ != awake_next_ && now_ns_ >= power_mode_ns_) {
+        awake_ = awake_next_;
+    }
+    if (now_ns_ >= stop_ns_) {
+        pages_[0][0x07] = kMcuStopped;
+        ranging_ = false;
+    }
+    if (command_.pending && now_ns_ >= command_.due_ns) {
+        command_.pending = false;
+        execute_command();
+    }
+
+    if (ranging_) {
+        uint64_t due = (now_ns_ - ranging_start_ns_) / period_ns_;
+        if (due > produced_) {
+            // Only the latest frame is built, the others are lost
+            stats_.overwritten += due - produced_ - 1 + (current_read_ ? 0 : 1);
+            stats_.frames += due - produced_;
+            produced_ = due;
+            produce(due - 1);
+        }
+    }
+}
+
+uint8_t SimulatedDevice::go2_status0() const
+{
+    switch (mcu_) {
+    case Mcu::kRom:
+        if (now_ns_ >= stop_ns_) {
+            return 0x80;
+        }
+        return now_ns_ >= mcu_ready_ns_ ? 0x01 : 0x00;
+    case Mcu::kBooting:
+    case Mcu::kRunning:
+        if (!running()) {
+            return 0x00;
+        }
+        if (now_ns_ >= stop_ns_) {
+            return 0x80;
+        }
+        return awake_ ? 0x01 : 0x00;
+    case Mcu::kFailed:
+        return 0x80;
+    default:
+        return 0x00;
+    }
+}
+
+/* Side effects of the registers of page 0x00 */
+void SimulatedDevice::write_register(uint16_t address, uint8_t value)
+{
+    switch (address) {
+    case 0x09:
+        // Power mode: 0x02 sleep, 0x04 wake up, 0x05 wake up (ranging)
+        awake_next_ = value != 0x02;
+        power_mode_ns_ = now_ns_ + options_.power_mode_us * 1000ULL;
+        break;
+    case 0x0a:
+        if (value == 0x01) {
+            reboot();
+        }
+        break;
+    case 0x0b:
+        if (value == 0x00) {
+            mcu_ = Mcu::kReset;
+            ranging_ = false;
+        } else if (value == 0x01 && mcu_ == Mcu::kReset) {
+            if (firmware_written_ >= kFirmwareSize) {
+                mcu_ = Mcu::kBooting;
+                mcu_ready_ns_ = now_ns_ + options_.mcu_boot_us * 1000ULL;
+            } else {
+                mcu_ = Mcu::kFailed;
+                pages_[0][0x07] = kBootError;
+            }
+        }
+        break;
+    case 0x14:
+        if (value == 0x01 && pages_[0][0x15] == 0x16) {
+            stop_ns_ = now_ns_ + options_.mcu_stop_us * 1000ULL;
+        } else if (value == 0x00) {
+            stop_ns_ = UINT64_MAX;
+            pages_[0][0x07] = 0;
+        }
+        break;
+    default:
+        break;
+    }
+}
+
+uint8_t SimulatedDevice::bus_read(void *ctx, uint16_t address, uint8_t *values, uint32_t size)
+{
+    SimulatedDevice &device = *static_cast<SimulatedDevice *>(ctx);
+
+    device.transfer(size, true);
+    device.update();
+
+    uint32_t end = std::min<uint32_t>(address + size, kPageSize);
+    uint32_t count = end > address ? end - address : 0;
+    std::memset(values, 0, size);
+    if (device.page_ <= 0x02) {
+        std::memcpy(values, &device.pages_[device.page_][address], count);
+    } else if (device.page_ >= 0x09 && device.page_ <= 0x0b) {
+        std::memcpy(values, &device.firmware_[(device.page_ - 0x09) * kPageSize + address], count);
+    }
+
+    // Registers computed at read time
+    auto patch = [&](uint16_t reg, uint8_t value) {
+        if (reg >= address && reg < end) {
+            values[reg - address] = value;
+        }
+    };
+    if (device.page_ == 0x00) {
+        patch(0x00, 0xf0);      // Device id
+        patch(0x01, 0x02);      // Revision id
+        patch(0x06, device.go2_status0());
+    } else if (device.page_ == 0x01) {
+        patch(0x21, device.now_ns_ >= device.fw_access_ns_ ? 0x10 : 0x00);
+    } else if (device.page_ == 0x02) {
+        if (address == VL53L7CX_UI_CMD_STATUS) {
+            device.stats_.status_polls++;
+        }
+        if (address == 0x0 && device.ranging_ && device.produced_ > 0 && !device.current_read_
+                && size >= device.frame_size_) {
+            uint64_t latency_us = (device.now_ns_ - device.current_ready_ns_) / 1000;
+            device.current_read_ = true;
+            device.read_results_ = device.results_;
+            device.has_read_ = true;
+            device.stats_.frames_read++;
+            device.stats_.frame_latency_us += latency_us;
+            device.stats_.max_frame_latency_us =
+                    std::max(device.stats_.max_frame_latency_us, latency_us);
+        }
+    }
+    patch(0x7fff, device.page_);
+    return 0;
+}
+
+uint8_t SimulatedDevice::bus_write(void *ctx, uint16_t address, const uint8_t *values, uint32_t size)
+{
+    SimulatedDevice &device = *static_cast<SimulatedDevice *>(ctx);
+
+    device.transfer(size, false);
+    device.update();
+
+    if (address == 0x7fff) {
+        device.page_ = values[0];
+        return 0;
+    }
+
+    uint32_t end = std::min<uint32_t>(address + size, kPageSize);
+    uint32_t count = end > address ? end - address : 0;
+    if (device.page_ <= 0x01) {
+        for (uint32_t i = 0; i < count; i++) {
+            device.pages_[device.page_][address + i] = values[i];
+            if (device.page_ == 0x00) {
+                device.write_register(static_cast<uint16_t>(address + i), values[i]);
+            }
+        }
+    } else if (device.page_ == 0x02) {
+        std::memcpy(&device.pages_[2][address], values, count);
+        if (address <= 0x03 && end > 0x03 && values[0x03 - address] == 0x0d) {
+            // Firmware access request, answered at 0x21 of page 0x01
+            device.fw_access_ns_ = device.now_ns_ + device.options_.fw_access_us * 1000ULL;
+        }
+        if (end > VL53L7CX_UI_CMD_END && device.running() && device.awake_
+                && device.now_ns_ < device.stop_ns_) {
+            // Command word written: busy until answered
+            const uint8_t *word = &device.pages_[2][kCommandWord];
+            uint32_t latency_us = word[1] == 0x03 ? device.options_.start_us
+                    : (word[1] == 0x02 && word[0] == 0x02) ? device.options_.nvm_read_us
+                    : device.options_.command_us;
+            std::memset(&device.pages_[2][VL53L7CX_UI_CMD_STATUS], 0, 4);
+            device.command_.pending = true;
+            device.command_.due_ns = device.now_ns_ + latency_us * 1000ULL;
+        }
+    } else if (device.page_ >= 0x09 && device.page_ <= 0x0b) {
+        std::memcpy(&device.firmware_[(device.page_ - 0x09) * kPageSize + address], values, count);
+        device.firmware_written_ += count;
+        device.stats_.firmware_bytes += count;
+    }
+    return 0;
+}
+
+uint64_t SimulatedDevice::bus_time_us(void *ctx)
+{
+    return static_cast<SimulatedDevice *>(ctx)->time_us();
+}
+
+void SimulatedDevice::bus_wait_us(void *ctx, uint32_t time_us)
+{
+    SimulatedDevice &device = *static_cast<SimulatedDevice *>(ctx);
+
+    device.now_ns_ += time_us * 1000ULL;
+    device.stats_.wait_us += time_us;
+}
+
+/* Answer the command closed by the command word: status {kind, 0x03 (done),
+ * error, 0} */
+void SimulatedDevice::execute_command()
+{
+    uint8_t *ui = pages_[2].data();
+    uint8_t kind = ui[kCommandWord];
+    uint8_t operation = ui[kCommandWord + 1];
+    uint32_t list_size = (static_cast<uint32_t>(ui[kCommandWord + 2]) << 8) | ui[kCommandWord + 3];
+    bool ok = list_size <= kCommandWord - VL53L7CX_UI_CMD_START;
+
+    if (ok) {
+        uint32_t start = kCommandWord - list_size;
+        switch (operation) {
+        case 0x01:
+            ok = write_blocks(start, kCommandWord);
+            break;
+        case 0x02:
+            ok = read_blocks(start, kCommandWord, kind == 0x02);
+            break;
+        case 0x03:
+            ok = start_ranging();
+            break;
+        default:
+            ok = false;
+            break;
+        }
+    }
+
+    ui[VL53L7CX_UI_CMD_STATUS] = kind;
+    ui[VL53L7CX_UI_CMD_STATUS + 1] = 0x03;
+    ui[VL53L7CX_UI_CMD_STATUS + 2] = ok ? 0x00 : 0x7f;
+    ui[VL53L7CX_UI_CMD_STATUS + 3] = 0x00;
+    stats_.commands++;
+    stats_.command_errors += ok ? 0 : 1;
+}
+
+/* Store the blocks of a list (header, data in firmware order), closed by the
+ * end of list marker */
+bool SimulatedDevice::write_blocks(uint32_t start, uint32_t end)
+{
+    const uint8_t *ui = pages_[2].data();
+    uint32_t pos = start;
+
+    while (pos + 4 <= end) {
+        uint32_t header = load_be32(&ui[pos]);
+        if (header == kEndOfList) {
+            return pos + 4 == end;
+        }
+        uint32_t data_size = block_data_size(header);
+        if (pos + 4 + data_size > end) {
+            return false;
+        }
+        dci_[static_cast<uint16_t>(header >> 16)].assign(&ui[pos + 4], &ui[pos + 4 + data_size]);
+        stats_.dci_writes++;
+        pos += 4 + data_size;
+    }
+    return false;
+}
+
+/* Answer the blocks of a list (headers only) at UI_CMD_START: header and data
+ * of each block, the end of list marker and the command word */
+bool SimulatedDevice::read_blocks(uint32_t start, uint32_t end, bool nvm)
+{
+    uint8_t *ui = pages_[2].data();
+    std::vector<uint32_t> headers;
+    uint32_t pos = start;
+
+    while (pos + 4 <= end && load_be32(&ui[pos]) != kEndOfList) {
+        headers.push_back(load_be32(&ui[pos]));
+        pos += 4;
+    }
+    if (pos + 4 != end) {
+        return false;
+    }
+
+    uint8_t word[4];
+    std::memcpy(word, &ui[kCommandWord], sizeof(word));
+    uint32_t out = VL53L7CX_UI_CMD_START;
+    for (uint32_t header : headers) {
+        uint32_t data_size = block_data_size(header);
+        if (out + 4 + data_size + 8 > VL53L7CX_UI_CMD_END + 1U) {
+            return false;
+        }
+        store_be32(&ui[out], header);
+        std::memset(&ui[out + 4], 0, data_size);
+        uint16_t index = static_cast<uint16_t>(header >> 16);
+        if (nvm) {
+            const std::vector<uint8_t> &data = nvm_block(index, data_size);
+            std::memcpy(&ui[out + 4], data.data(), data_size);
+        } else {
+            // Blocks never written read as 0
+            auto it = dci_.find(index);
+            if (it != dci_.end()) {
+                std::memcpy(&ui[out + 4], it->second.data(),
+                        std::min<size_t>(data_size, it->second.size()));
+            }
+        }
+        stats_.dci_reads++;
+        out += 4 + data_size;
+    }
+    store_be32(&ui[out], kEndOfList);
+    std::memcpy(&ui[out + 4], word, sizeof(word));
+    return true;
+}
+
+/* Host order word of a DCI block (0 if not written) */
+uint32_t SimulatedDevice::host_word(uint16_t index, size_t word) const
+{
+    auto it = dci_.find(index);
+    if (it == dci_.end() || it->second.size() < (word + 1) * 4) {
+        return 0;
+    }
+    return load_be32(&it->second[word * 4]);
+}
+
+/* Start command: frame layout from the zone configuration, output list and
+ * enables written by the driver, as the firmware computes it */
+bool SimulatedDevice::start_ranging()
+{
+    uint32_t zones = host_word(VL53L7CX_DCI_ZONE_CONFIG, 0);
+    uint8_t resolution = static_cast<uint8_t>((zones & 0xff) * ((zones >> 8) & 0xff));
+    uint32_t enables = host_word(VL53L7CX_DCI_OUTPUT_ENABLES, 0);
+    uint32_t frequency_hz = (host_word(VL53L7CX_DCI_FREQ_HZ, 0) >> 8) & 0xff;
+    if ((resolution != VL53L7CX_RESOLUTION_4X4 && resolution != VL53L7CX_RESOLUTION_8X8)
+            || frequency_hz == 0) {
+        return false;
+    }
+
+    uint32_t size = 24;
+    for (size_t i = 0; i < VL53L7CX_NB_OUTPUT_BH; i++) {
+        uint32_t header = host_word(VL53L7CX_DCI_OUTPUT_LIST, i);
+        if (header == 0 || (enables & (1U << i)) == 0) {
+            continue;
+        }
+        uint32_t type = header & 0xf;
+        uint32_t idx = header >> 16;
+        if (type >= 0x1 && type < 0xd) {
+            uint32_t count = (idx >= 0x54d0 && idx < 0x54d0 + 960) ? resolution
+                    : resolution * VL53L7CX_NB_TARGET_PER_ZONE;
+            size += type * count;
+        } else {
+            size += (header >> 4) & 0xfff;
+        }
+        size += 4;
+    }
+
+    // Frames are built from the block list of this driver build
+    uint32_t output_mask = enables & VL53L7CX_OUTPUT_AVAILABLE;
+    if (size != ranging_frame_size(resolution, output_mask)) {
+        return false;
+    }
+
+    std::vector<uint8_t> &info = dci_[kRangingInfoIdx];
+    info.assign(12, 0);
+    store_be32(&info[8], size);
+
+    resolution_ = resolution;
+    output_mask_ = output_mask;
+    frame_size_ = size;
+    period_ns_ = 1000000000ULL / frequency_hz;
+    ranging_start_ns_ = now_ns_;
+    produced_ = 0;
+    current_read_ = true;
+    std::memset(pages_[2].data(), 0, size);     // No frame yet
+    ranging_ = true;
+    return true;
+}
+
+void SimulatedDevice::produce(uint64_t frame)
+{
+    current_ready_ns_ = ranging_start_ns_ + (frame + 1) * period_ns_;
+    std::memset(&results_, 0, sizeof(results_));
+    scene_(frame, current_ready_ns_ / 1000, resolution_, results_);
+
+    uint16_t id = static_cast<uint16_t>(frame + 1);
+    encode_ranging_frame(results_, resolution_, output_mask_, static_cast<uint8_t>(frame % 255),
+            id, id, pages_[2].data(), frame_size_);
+    current_read_ = false;
+}
+
+/* NVM content of this sensor: pseudo-random, fixed by nvm_seed */
+const std::vector<uint8_t> &SimulatedDevice::nvm_block(uint16_t index, uint32_t size)
+{
+    std::vector<uint8_t> &data = nvm_[index];
+    if (data.size() != size) {
+        uint32_t x = (options_.nvm_seed * 0x9e3779b1U) ^ (static_cast<uint32_t>(index) << 8) ^ 1U;
+        data.resize(size);
+        for (uint8_t &byte : data) {
+            x ^= x << 13;
+            x ^= x >> 17;
+            x ^= x << 5;
+            byte = static_cast<uint8_t>(x);
+        }
+    }
+    return data;
+}
+
+} // namespace vl53l7cx
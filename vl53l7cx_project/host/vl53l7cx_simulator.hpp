@@ -0,0 +1,190 @@
+/**
+ * Register-level Simulator for VL53L7CX (host side)
+ *
+ * A SimulatedDevice is a model of the sensor register map behind the host
+ * platform layer (platform/platform_pico.h), complete enough for the
+ * unchanged driver to run vl53l7cx_init(), vl53l7cx_init_warm(), the DCI
+ * accessors, vl53l7cx_start_ranging() / vl53l7cx_stop_ranging() and read
+ * frames, with no sensor:
+ * - pages selected by 0x7fff: registers (0x00), boot handshake (0x01), user
+ *   interface and ranging data (0x02), firmware RAM (0x09 to 0x0b);
+ * - boot: the ROM answers at 0x06 after the reboot sequence, firmware access
+ *   at 0x21 once requested, and the MCU boots (0x06 bit 0) only if the whole
+ *   firmware was downloaded, else reports an error (0x06 bit 7, code at 0x07);
+ * - UI commands: a block list written to end at UI_CMD_END, closed by the
+ *   command word at 0x2ffc (kind, operation, list size). Writes store the
+ *   blocks (DCI, configuration, offsets, Xtalk), reads answer the blocks at
+ *   UI_CMD_START (DCI, or NVM with kind 2), start begins ranging; the status
+ *   at UI_CMD_STATUS is busy until the answer, 0x7f in byte 2 on a bad list;
+ * - ranging: frames of the configured resolution and outputs are produced at
+ *   the DCI ranging frequency, from a scene, and replace unread ones;
+ * - power modes (0x09) and MCU stop (0x14, 0x15).
+ *
+ * Time is virtual: it advances by the I2C transfer time of each access (at
+ * i2c_hz) and by the waits of the driver, so init and ranging latencies are
+ * measured on the device clock, deterministically and faster than real time.
+ * Device latencies (boot, command answers, ...) are estimates, set by
+ * SimulatorOptions.
+ */
+
+#ifndef VL53L7CX_SIMULATOR_HPP_
+#define VL53L7CX_SIMULATOR_HPP_
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <vector>
+
+extern "C" {
+#include "vl53l7cx_api.h"
+}
+
+namespace vl53l7cx {
+
+/* Fill the results of frame (0 for the first frame after start) at time_us,
+ * in firmware units (VL53L7CX_USE_RAW_FORMAT) */
+using Scene = std::function<void(uint64_t frame, uint64_t time_us, uint8_t resolution,
+        VL53L7CX_ResultsData &results)>;
+
+/* Default scene: a wall at 1.5 m, tilted, and an object crossing the field of
+ * view in 4 s */
+void synthetic_scene(uint64_t frame, uint64_t time_us, uint8_t resolution,
+        VL53L7CX_ResultsData &results);
+
+struct SimulatorOptions {
+    uint32_t i2c_hz = 400000;       // Bus clock (bits of 9 clocks per byte)
+    uint32_t rom_boot_us = 2000;    // ROM answer at 0x06 after the reboot sequence
+    uint32_t fw_access_us = 100;    // Firmware access answer at 0x21
+    uint32_t mcu_boot_us = 10000;   // Firmware boot after the MCU reset
+    uint32_t command_us = 300;      // UI command answer
+    uint32_t nvm_read_us = 2000;    // NVM read command answer
+    uint32_t start_us = 3000;       // Start command answer
+    uint32_t mcu_stop_us = 1000;    // MCU stop (0x14) acknowledge
+    uint32_t power_mode_us = 500;   // Sleep or wake up (0x09)
+    uint32_t nvm_seed = 1;          // NVM content (calibration) of this sensor
+};
+
+struct SimulatorStats {
+    uint64_t reads = 0;             // Register accesses
+    uint64_t writes = 0;
+    uint64_t bytes_read = 0;
+    uint64_t bytes_written = 0;
+    uint64_t bus_us = 0;            // Time spent transferring
+    uint64_t wait_us = 0;           // Time waited by the driver
+    uint64_t status_polls = 0;      // Reads of UI_CMD_STATUS
+    uint64_t commands = 0;          // UI commands answered
+    uint64_t command_errors = 0;    // Bad lists, unknown commands
+    uint64_t dci_writes = 0;        // Blocks written
+    uint64_t dci_reads = 0;         // Blocks read (DCI and NVM)
+    uint64_t firmware_bytes = 0;    // Written into the firmware pages
+    uint64_t frames = 0;            // Frames produced
+    uint64_t frames_read = 0;
+    uint64_t overwritten = 0;       // Frames replaced before being read
+    uint64_t frame_latency_us = 0;  // Sum, frame ready to frame read
+    uint64_t max_frame_latency_us = 0;
+};
+
+class SimulatedDevice {
+public:
+    explicit SimulatedDevice(const SimulatorOptions &options = SimulatorOptions(),
+            Scene scene = synthetic_scene);
+
+    SimulatedDevice(const SimulatedDevice &) = delete;
+    SimulatedDevice &operator=(const SimulatedDevice &) = delete;
+
+    /* Bind a driver configuration (a fresh one simulates a host reset: the
+     * device keeps its state) */
+    void attach(VL53L7CX_Configuration &dev);
+
+    /* Power the sensor off and on: firmware and configuration are lost */
+    void power_cycle();
+
+    uint64_t time_us() const { return now_ns_ / 1000; }
+    bool running() const;           // Firmware running
+    bool ranging() const { return ranging_; }
+    uint8_t resolution() const { return resolution_; }
+    uint32_t frame_size() const { return frame_size_; }
+
+    /* Time at which frame (0 for the first after start) is ready, on the
+     * device clock; UINT64_MAX if not ranging */
+    uint64_t frame_ready_us(uint64_t frame) const;
+
+    /* Firmware RAM, pages 0x09 to 0x0b, as downloaded */
+    const std::vector<uint8_t> &firmware() const { return firmware_; }
+
+    /* Content of a DCI block in host order; false if never written */
+    bool dci_block(uint16_t index, std::vector<uint8_t> &data) const;
+
+    /* Results of the frame read last; false if none */
+    bool last_frame(VL53L7CX_ResultsData &results) const;
+
+    const SimulatorStats &stats() const { return stats_; }
+    void reset_stats();
+
+private:
+    enum class Mcu { kRom, kReset, kBooting, kRunning, kFailed };
+
+    struct Command {
+        bool pending = false;
+        uint64_t due_ns = 0;
+    };
+
+    static uint8_t bus_read(void *ctx, uint16_t address, uint8_t *values, uint32_t size);
+    static uint8_t bus_write(void *ctx, uint16_t address, const uint8_t *values, uint32_t size);
+    static uint64_t bus_time_us(void *ctx);
+    static void bus_wait_us(void *ctx, uint32_t time_us);
+
+    void transfer(uint32_t size, bool read);
+    void update();
+    uint8_t go2_status0() const;
+    void write_register(uint16_t address, uint8_t value);
+    void reboot();
+    void execute_command();
+    bool write_blocks(uint32_t start, uint32_t end);
+    bool read_blocks(uint32_t start, uint32_t end, bool nvm);
+    bool start_ranging();
+    void produce(uint64_t frame);
+    const std::vector<uint8_t> &nvm_block(uint16_t index, uint32_t size);
+    uint32_t host_word(uint16_t index, size_t word) const;
+
+    SimulatorOptions options_;
+    Scene scene_;
+
+    uint64_t now_ns_ = 0;
+    uint8_t page_ = 0;
+    std::vector<uint8_t> pages_[3];             // Pages 0x00 to 0x02
+    std::vector<uint8_t> firmware_;             // Pages 0x09 to 0x0b
+    uint32_t firmware_written_ = 0;             // Since the last reboot
+    std::map<uint16_t, std::vector<uint8_t>> dci_;  // Firmware order
+    std::map<uint16_t, std::vector<uint8_t>> nvm_;
+
+    Mcu mcu_ = Mcu::kRom;
+    uint64_t mcu_ready_ns_ = 0;                 // kRom answer, kBooting end
+    uint64_t fw_access_ns_ = UINT64_MAX;        // 0x21 answer
+    bool awake_ = true;
+    uint64_t power_mode_ns_ = 0;                // Pending awake_ change
+    bool awake_next_ = true;
+    uint64_t stop_ns_ = UINT64_MAX;             // MCU stopped (0x14)
+    Command command_;
+
+    bool ranging_ = false;
+    uint64_t ranging_start_ns_ = 0;
+    uint64_t period_ns_ = 0;
+    uint8_t resolution_ = 0;
+    uint32_t output_mask_ = 0;
+    uint32_t frame_size_ = 0;
+    uint64_t produced_ = 0;                     // Frames produced since start
+    uint64_t current_ready_ns_ = 0;
+    bool current_read_ = true;
+    VL53L7CX_ResultsData results_{};
+    VL53L7CX_ResultsData read_results_{};
+    bool has_read_ = false;
+
+    SimulatorStats stats_;
+    uint64_t bus_ns_ = 0;
+};
+
+} // namespace vl53l7cx
+
+#endif // VL53L7CX_SIMULATOR_HPP_
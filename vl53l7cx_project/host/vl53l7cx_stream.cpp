@@ -0,0 +1,295 @@
+/**
+ * Binary Frame Stream Decoder for VL53L7CX (host side)
+ *
+ * See vl53l7cx_stream.hpp.
+ */
+
+#include "vl53l7cx_stream.hpp"
+
+#include <algorithm>
+#include <cstring>
+
+namespace vl53l7cx {
+
+size_t cobs_decode_in_place(uint8_t *data, size_t size)
+{
+    size_t in = 0;
+    size_t out = 0;
+
+    // Decoded data is never longer than encoded data: write behind the reader
+    while (in < size) {
+        uint8_t code = data[in++];
+        if (code == 0 || in + code - 1 > size) {
+            return 0;   // Zero inside a frame, or block past the end
+        }
+        for (uint8_t i = 1; i < code; i++) {
+            data[out++] = data[in++];
+        }
+        if (code != 0xFF && in < size) {
+            data[out++] = 0;
+        }
+    }
+
+    return out;
+}
+
+size_t delta_decode(const uint8_t *tokens, size_t size, uint8_t *values, size_t count)
+{
+    size_t i = 0;
+    size_t pos = 0;
+
+    while (i < count) {
+        if (pos >= size) {
+            return 0;
+        }
+        uint8_t token = tokens[pos++];
+
+        if (token & 0x80) {
+            i += (token & 0x7F) + 1u;   // Unchanged values
+            if (i > count) {
+                return 0;
+            }
+            continue;
+        }
+
+        uint16_t value;
+        if (token == 0) {
+            if (pos + 2 > size) {
+                return 0;
+            }
+            value = static_cast<uint16_t>(tokens[pos] | (tokens[pos + 1] << 8));
+            pos += 2;
+        } else {
+            uint32_t zz = token;
+            if (token & 0x40) {
+                if (pos >= size) {
+                    return 0;
+                }
+                zz = ((token & 0x3Fu) << 8) | tokens[pos++];
+            }
+            int32_t delta = (zz & 1) ? -static_cast<int32_t>((zz + 1) >> 1)
+                                     : static_cast<int32_t>(zz >> 1);
+            uint16_t previous = values
+                    ? static_cast<uint16_t>(values[2 * i] | (values[2 * i + 1] << 8)) : 0;
+            value = static_cast<uint16_t>(previous + delta);
+        }
+        if (values) {
+            values[2 * i] = static_cast<uint8_t>(value);
+            values[2 * i + 1] = static_cast<uint8_t>(value >> 8);
+        }
+        i++;
+    }
+
+    return pos;
+}
+
+uint32_t crc32(const uint8_t *data, size_t size)
+{
+    static uint32_t table[256];
+    static bool ready = false;
+
+    if (!ready) {
+        for (uint32_t n = 0; n < 256; n++) {
+            uint32_t c = n;
+            for (int bit = 0; bit < 8; bit++) {
+                c = (c >> 1) ^ (0xEDB88320U & (0U - (c & 1U)));
+            }
+            table[n] = c;
+        }
+        ready = true;
+    }
+
+    uint32_t crc = 0xFFFFFFFFU;
+    for (size_t i = 0; i < size; i++) {
+        crc = (crc >> 8) ^ table[(crc ^ data[i]) & 0xFFU];
+    }
+    return ~crc;
+}
+
+FrameView::Status FrameView::parse(const uint8_t *packet, size_t size)
+{
+    *this = FrameView();
+    if (size < kStreamHeaderSize + kStreamCrcSize) {
+        return Status::kTooShort;
+    }
+
+    size_t payload = size - kStreamCrcSize;
+    if (ArrayView<uint32_t>(&packet[payload], 1)[0] != crc32(packet, payload)) {
+        return Status::kBadCrc;
+    }
+
+    packet_ = packet;
+    size_ = size;
+    if (packet[0] != kStreamVersion) {
+        return Status::kBadVersion;
+    }
+
+    size_t zones = resolution();
+    size_t targets = zones * nb_targets();
+    if ((zones != 16 && zones != 64) || nb_targets() == 0 || nb_targets() > kStreamMaxTargets) {
+        return Status::kBadLayout;
+    }
+
+    // Fields follow the header by increasing bit; every size is checked
+    // before a view is made
+    uint16_t mask = field_mask();
+    size_t pos = kStreamHeaderSize;
+    bool fits = true;
+    auto take = [&](Field field, size_t bytes) -> const uint8_t * {
+        if (!(mask & field) || !fits) {
+            return nullptr;
+        }
+        if (pos + bytes > payload) {
+            fits = false;
+            return nullptr;
+        }
+        const uint8_t *p = &packet[pos];
+        pos += bytes;
+        return p;
+    };
+
+    if (const uint8_t *p = take(kAmbientPerSpad, zones * 4)) {
+        ambient_per_spad_ = ArrayView<uint32_t>(p, zones);
+    }
+    if (const uint8_t *p = take(kNbSpadsEnabled, zones * 4)) {
+        nb_spads_enabled_ = ArrayView<uint32_t>(p, zones);
+    }
+    if (const uint8_t *p = take(kNbTargetDetected, zones)) {
+        nb_target_detected_ = ArrayView<uint8_t>(p, zones);
+    }
+    if (const uint8_t *p = take(kSignalPerSpad, targets * 4)) {
+        signal_per_spad_ = ArrayView<uint32_t>(p, targets);
+    }
+    if (const uint8_t *p = take(kRangeSigmaMm, targets * 2)) {
+        range_sigma_mm_ = ArrayView<uint16_t>(p, targets);
+    }
+    if (mask & kDistanceDelta) {
+        // Token size is only known by walking the tokens
+        size_t delta_size = fits ? delta_decode(&packet[pos], payload - pos, nullptr, targets) : 0;
+        if (!(mask & kDistanceMm) || delta_size == 0) {
+            return Status::kBadLayout;
+        }
+        distance_delta_ = ArrayView<uint8_t>(&packet[pos], delta_size);
+        pos += delta_size;
+    } else if (const uint8_t *p = take(kDistanceMm, targets * 2)) {
+        distance_mm_ = ArrayView<int16_t>(p, targets);
+    }
+    if (const uint8_t *p = take(kReflectancePercent, targets)) {
+        reflectance_ = ArrayView<uint8_t>(p, targets);
+    }
+    if (const uint8_t *p = take(kTargetStatus, targets)) {
+        target_status_ = ArrayView<uint8_t>(p, targets);
+    }
+    if (const uint8_t *p = take(kMotionIndicator, kStreamMotionSize)) {
+        motion_.global_indicator_1 = ArrayView<uint32_t>(p, 1)[0];
+        motion_.global_indicator_2 = ArrayView<uint32_t>(p + 4, 1)[0];
+        motion_.status = p[8];
+        motion_.nb_of_detected_aggregates = p[9];
+        motion_.nb_of_aggregates = p[10];
+        motion_.motion = ArrayView<uint32_t>(p + 12, 32);
+    }
+
+    if (!fits || pos != payload) {
+        return Status::kBadLayout;
+    }
+
+    return Status::kOk;
+}
+
+StreamDecoder::StreamDecoder(size_t max_frame) : max_frame_(max_frame)
+{
+    buffer_.reserve(max_frame);
+}
+
+void StreamDecoder::feed(const uint8_t *data, size_t size, const Handler &handler)
+{
+    stats_.bytes += size;
+
+    // Whole runs up to the next delimiter, into the reserved buffer
+    while (size > 0) {
+        const uint8_t *delimiter = static_cast<const uint8_t *>(std::memchr(data, 0, size));
+        size_t length = delimiter ? static_cast<size_t>(delimiter - data) : size;
+        size_t room = max_frame_ - buffer_.size();
+        if (length > room) {
+            overflow_ = true;
+        }
+        buffer_.insert(buffer_.end(), data, data + std::min(length, room));
+        if (!delimiter) {
+            break;
+        }
+        end_frame(handler);
+        data += length + 1;
+        size -= length + 1;
+    }
+}
+
+void StreamDecoder::update_distance(FrameView &frame)
+{
+    std::vector<uint8_t> &reference = reference_[frame.sensor()];
+    size_t size = static_cast<size_t>(frame.resolution()) * frame.nb_targets() * 2;
+
+    if (frame.is_delta()) {
+        const ArrayView<uint8_t> &tokens = frame.distance_delta();
+        if (reference.size() != size) {
+            reference.clear();
+            stats_.no_reference++;
+            return;     // Distances unknown until the next keyframe
+        }
+        delta_decode(tokens.data(), tokens.size(), reference.data(), size / 2);
+        frame.set_distance_mm(ArrayView<int16_t>(reference.data(), size / 2));
+    } else if (frame.has(kDistanceMm)) {
+        const ArrayView<int16_t> &distance = frame.distance_mm();
+        reference.assign(distance.data(), distance.data() + size);
+    } else {
+        reference.clear();
+    }
+}
+
+void StreamDecoder::end_frame(const Handler &handler)
+{
+    bool synced = synced_;
+    bool overflow = overflow_;
+
+    // Bytes before the first delimiter belong to a frame joined mid-way
+    synced_ = true;
+    overflow_ = false;
+    if (!synced || buffer_.empty()) {
+        buffer_.clear();
+        return;
+    }
+    if (overflow) {
+        stats_.bad_frames++;
+        buffer_.clear();
+        return;
+    }
+
+    FrameView frame;
+    size_t packet_size = cobs_decode_in_place(buffer_.data(), buffer_.size());
+    FrameView::Status status = (packet_size == 0)
+            ? FrameView::Status::kTooShort
+            : frame.parse(buffer_.data(), packet_size);
+
+    if (status == FrameView::Status::kOk) {
+        uint8_t sensor = frame.sensor();
+        uint32_t gap = frame.sequence() - next_sequence_[sensor];
+        if (has_sequence_[sensor] && gap < 0x80000000U) {
+            stats_.lost += gap;     // A step back is a sender restart, not a loss
+        }
+        if (!has_sequence_[sensor] || gap != 0) {
+            reference_[sensor].clear();     // Reference of the next delta lost
+        }
+        has_sequence_[sensor] = true;
+        next_sequence_[sensor] = frame.sequence() + 1;
+        update_distance(frame);
+        stats_.frames++;
+        handler(frame);
+    } else if (status == FrameView::Status::kBadCrc) {
+        stats_.bad_crc++;
+    } else {
+        stats_.bad_frames++;
+    }
+
+    buffer_.clear();
+}
+
+} // namespace vl53l7cx
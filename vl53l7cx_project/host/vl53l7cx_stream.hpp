@@ -0,0 +1,208 @@
+/**
+ * Binary Frame Stream Decoder for VL53L7CX (host side)
+ *
+ * Reference decoder of the packets sent by vl53l7cx_stream.c (see the packet
+ * layout in vl53l7cx_stream.h). Frames are COBS decoded in place in the
+ * receive buffer, and a FrameView gives typed access to the packet fields
+ * without copying them: a view is only valid until the next call to feed().
+ * Delta coded distances are applied to a per-sensor reference, which the view
+ * then points to.
+ */
+
+#ifndef VL53L7CX_STREAM_HPP_
+#define VL53L7CX_STREAM_HPP_
+
+#include <cstddef>
+#include <cstdint>
+#include <array>
+#include <functional>
+#include <vector>
+
+namespace vl53l7cx {
+
+/* Must match vl53l7cx_stream.h */
+constexpr uint8_t kStreamVersion = 2;
+constexpr size_t kStreamHeaderSize = 20;
+constexpr size_t kStreamCrcSize = 4;
+constexpr size_t kStreamMotionSize = 140;
+constexpr size_t kStreamMaxTargets = 4;         // VL53L7CX_NB_TARGET_PER_ZONE range
+
+/* Field mask bits (VL53L7CX_OUTPUT_* in vl53l7cx_api.h) */
+enum Field : uint16_t {
+    kAmbientPerSpad = 0x0008,
+    kNbSpadsEnabled = 0x0010,
+    kNbTargetDetected = 0x0020,
+    kSignalPerSpad = 0x0040,
+    kRangeSigmaMm = 0x0080,
+    kDistanceMm = 0x0100,
+    kReflectancePercent = 0x0200,
+    kTargetStatus = 0x0400,
+    kMotionIndicator = 0x0800,
+    kDistanceDelta = 0x1000,        // DISTANCE_MM holds delta tokens
+};
+
+/**
+ * Little-endian array inside a packet. Elements are assembled byte by byte:
+ * the packet gives no alignment guarantee, and the host may be big-endian.
+ */
+template <typename T>
+class ArrayView {
+public:
+    ArrayView() = default;
+    ArrayView(const uint8_t *data, size_t size) : data_(data), size_(size) {}
+
+    size_t size() const { return size_; }
+    bool empty() const { return size_ == 0; }
+    const uint8_t *data() const { return data_; }
+
+    T operator[](size_t i) const
+    {
+        const uint8_t *p = data_ + i * sizeof(T);
+        uint64_t raw = 0;
+        for (size_t b = sizeof(T); b-- > 0;) {
+            raw = (raw << 8) | p[b];
+        }
+        return static_cast<T>(raw);
+    }
+
+    /* Copy into a host array of size() elements */
+    void copy_to(T *out) const
+    {
+        for (size_t i = 0; i < size_; i++) {
+            out[i] = (*this)[i];
+        }
+    }
+
+private:
+    const uint8_t *data_ = nullptr;
+    size_t size_ = 0;
+};
+
+/**
+ * Motion indicator block (VL53L7CX_OUTPUT_MOTION_INDICATOR).
+ */
+struct MotionView {
+    uint32_t global_indicator_1 = 0;
+    uint32_t global_indicator_2 = 0;
+    uint8_t status = 0;
+    uint8_t nb_of_detected_aggregates = 0;
+    uint8_t nb_of_aggregates = 0;
+    ArrayView<uint32_t> motion;     // 32 values
+};
+
+/**
+ * One decoded packet.
+ */
+class FrameView {
+public:
+    enum class Status { kOk, kTooShort, kBadCrc, kBadVersion, kBadLayout };
+
+    /* Parse a packet (COBS decoded, delimiter removed) */
+    Status parse(const uint8_t *packet, size_t size);
+
+    uint8_t sensor() const { return packet_[1]; }
+    uint8_t resolution() const { return packet_[2]; }
+    uint8_t nb_targets() const { return packet_[3]; }
+    uint16_t field_mask() const { return ArrayView<uint16_t>(&packet_[4], 1)[0]; }
+    uint8_t stream_count() const { return packet_[6]; }
+    int8_t silicon_temp_degc() const { return static_cast<int8_t>(packet_[7]); }
+    uint32_t sequence() const { return ArrayView<uint32_t>(&packet_[8], 1)[0]; }
+    uint64_t timestamp_us() const { return ArrayView<uint64_t>(&packet_[12], 1)[0]; }
+    bool has(Field field) const { return (field_mask() & field) != 0; }
+
+    /* Per zone */
+    const ArrayView<uint32_t> &ambient_per_spad() const { return ambient_per_spad_; }
+    const ArrayView<uint32_t> &nb_spads_enabled() const { return nb_spads_enabled_; }
+    const ArrayView<uint8_t> &nb_target_detected() const { return nb_target_detected_; }
+
+    /* Per zone and target (zone * nb_targets() + target) */
+    const ArrayView<uint32_t> &signal_per_spad() const { return signal_per_spad_; }
+    const ArrayView<uint16_t> &range_sigma_mm() const { return range_sigma_mm_; }
+    const ArrayView<int16_t> &distance_mm() const { return distance_mm_; }
+    const ArrayView<uint8_t> &reflectance() const { return reflectance_; }
+    const ArrayView<uint8_t> &target_status() const { return target_status_; }
+
+    const MotionView &motion_indicator() const { return motion_; }
+
+    /* Delta tokens of a delta frame (distance_mm() is set by StreamDecoder) */
+    bool is_delta() const { return has(kDistanceDelta); }
+    const ArrayView<uint8_t> &distance_delta() const { return distance_delta_; }
+    void set_distance_mm(const ArrayView<int16_t> &distance) { distance_mm_ = distance; }
+
+    const uint8_t *packet() const { return packet_; }
+    size_t packet_size() const { return size_; }
+
+private:
+    const uint8_t *packet_ = nullptr;
+    size_t size_ = 0;
+    ArrayView<uint32_t> ambient_per_spad_;
+    ArrayView<uint32_t> nb_spads_enabled_;
+    ArrayView<uint8_t> nb_target_detected_;
+    ArrayView<uint32_t> signal_per_spad_;
+    ArrayView<uint16_t> range_sigma_mm_;
+    ArrayView<int16_t> distance_mm_;
+    ArrayView<uint8_t> distance_delta_;
+    ArrayView<uint8_t> reflectance_;
+    ArrayView<uint8_t> target_status_;
+    MotionView motion_;
+};
+
+/**
+ * Decoder statistics.
+ */
+struct StreamStats {
+    uint64_t frames = 0;            // Valid packets
+    uint64_t bad_crc = 0;           // Packets dropped: CRC mismatch
+    uint64_t bad_frames = 0;        // Packets dropped: framing, version or layout
+    uint64_t lost = 0;              // Gaps in the sequence of a sensor
+    uint64_t no_reference = 0;      // Delta frames without reference (distances dropped)
+    uint64_t bytes = 0;             // Bytes fed
+};
+
+/**
+ * Splits a byte stream into frames on the 0x00 delimiter, and parses each one.
+ * Bytes received before the first delimiter (joined mid-frame) and text lines
+ * mixed into the stream end up in dropped frames.
+ */
+class StreamDecoder {
+public:
+    using Handler = std::function<void(const FrameView &)>;
+
+    /* max_frame: larger frames are dropped (garbage without delimiter) */
+    explicit StreamDecoder(size_t max_frame = 4096);
+
+    /* Feed received bytes: handler is called for each valid frame */
+    void feed(const uint8_t *data, size_t size, const Handler &handler);
+
+    const StreamStats &stats() const { return stats_; }
+
+private:
+    void end_frame(const Handler &handler);
+    void update_distance(FrameView &frame);
+
+    std::vector<uint8_t> buffer_;
+    size_t max_frame_;
+    bool overflow_ = false;
+    bool synced_ = false;
+    std::array<uint32_t, 256> next_sequence_{};    // Per sensor index
+    std::array<bool, 256> has_sequence_{};
+    std::array<std::vector<uint8_t>, 256> reference_;  // Last distances (LE), empty if none
+    StreamStats stats_;
+};
+
+/*
+ * Apply delta tokens (vl53l7cx_delta.h) to count little-endian int16 values;
+ * with values == nullptr only checks them. Returns the token size, 0 if the
+ * tokens are invalid.
+ */
+size_t delta_decode(const uint8_t *tokens, size_t size, uint8_t *values, size_t count);
+
+/* COBS decode in place; returns the decoded size, 0 if the frame is invalid */
+size_t cobs_decode_in_place(uint8_t *data, size_t size);
+
+/* CRC-32 (IEEE 802.3), as computed by vl53l7cx_stream.c */
+uint32_t crc32(const uint8_t *data, size_t size);
+
+} // namespace vl53l7cx
+
+#endif // VL53L7CX_STREAM_HPP_
@@ -143,10 +143,82 @@
 #endif
 
 
+/**
+ * @brief Macros VL53L7CX_OUTPUT_* select, at runtime, the blocks sent by the
+ * sensor for each frame (see vl53l7cx_set_output_mask()). Each value is the
+ * bit of the block into the firmware output enables. Meta and common data
+ * (VL53L7CX_OUTPUT_MANDATORY) are always sent. An output disabled at compile
+ * time with a VL53L7CX_DISABLE_* macro is not part of
+ * VL53L7CX_OUTPUT_AVAILABLE, and can't be selected.
+ */
+
+#define VL53L7CX_OUTPUT_MANDATORY		((uint32_t)0x00000007U)
+#define VL53L7CX_OUTPUT_AMBIENT_PER_SPAD	((uint32_t)0x00000008U)
+#define VL53L7CX_OUTPUT_NB_SPADS_ENABLED	((uint32_t)0x00000010U)
+#define VL53L7CX_OUTPUT_NB_TARGET_DETECTED	((uint32_t)0x00000020U)
+#define VL53L7CX_OUTPUT_SIGNAL_PER_SPAD		((uint32_t)0x00000040U)
+#define VL53L7CX_OUTPUT_RANGE_SIGMA_MM		((uint32_t)0x00000080U)
+#define VL53L7CX_OUTPUT_DISTANCE_MM		((uint32_t)0x00000100U)
+#define VL53L7CX_OUTPUT_REFLECTANCE_PERCENT	((uint32_t)0x00000200U)
+#define VL53L7CX_OUTPUT_TARGET_STATUS		((uint32_t)0x00000400U)
+#define VL53L7CX_OUTPUT_MOTION_INDICATOR	((uint32_t)0x00000800U)
+
+#ifndef VL53L7CX_DISABLE_AMBIENT_PER_SPAD
+#define VL53L7CX_OUT_AMB	VL53L7CX_OUTPUT_AMBIENT_PER_SPAD
+#else
+#define VL53L7CX_OUT_AMB	0U
+#endif
+#ifndef VL53L7CX_DISABLE_NB_SPADS_ENABLED
+#define VL53L7CX_OUT_SPAD	VL53L7CX_OUTPUT_NB_SPADS_ENABLED
+#else
+#define VL53L7CX_OUT_SPAD	0U
+#endif
+#ifndef VL53L7CX_DISABLE_NB_TARGET_DETECTED
+#define VL53L7CX_OUT_NTAR	VL53L7CX_OUTPUT_NB_TARGET_DETECTED
+#else
+#define VL53L7CX_OUT_NTAR	0U
+#endif
+#ifndef VL53L7CX_DISABLE_SIGNAL_PER_SPAD
+#define VL53L7CX_OUT_SPS	VL53L7CX_OUTPUT_SIGNAL_PER_SPAD
+#else
+#define VL53L7CX_OUT_SPS	0U
+#endif
+#ifndef VL53L7CX_DISABLE_RANGE_SIGMA_MM
+#define VL53L7CX_OUT_SIGR	VL53L7CX_OUTPUT_RANGE_SIGMA_MM
+#else
+#define VL53L7CX_OUT_SIGR	0U
+#endif
+#ifndef VL53L7CX_DISABLE_DISTANCE_MM
+#define VL53L7CX_OUT_DIST	VL53L7CX_OUTPUT_DISTANCE_MM
+#else
+#define VL53L7CX_OUT_DIST	0U
+#endif
+#ifndef VL53L7CX_DISABLE_REFLECTANCE_PERCENT
+#define VL53L7CX_OUT_RFLEST	VL53L7CX_OUTPUT_REFLECTANCE_PERCENT
+#else
+#define VL53L7CX_OUT_RFLEST	0U
+#endif
+#ifndef VL53L7CX_DISABLE_TARGET_STATUS
+#define VL53L7CX_OUT_STA	VL53L7CX_OUTPUT_TARGET_STATUS
+#else
+#define VL53L7CX_OUT_STA	0U
+#endif
+#ifndef VL53L7CX_DISABLE_MOTION_INDICATOR
+#define VL53L7CX_OUT_MOT	VL53L7CX_OUTPUT_MOTION_INDICATOR
+#else
+#define VL53L7CX_OUT_MOT	0U
+#endif
+
+#define VL53L7CX_OUTPUT_AVAILABLE ((uint32_t)(VL53L7CX_OUT_AMB | VL53L7CX_OUT_SPAD \
+	| VL53L7CX_OUT_NTAR | VL53L7CX_OUT_SPS | VL53L7CX_OUT_SIGR | VL53L7CX_OUT_DIST \
+	| VL53L7CX_OUT_RFLEST | VL53L7CX_OUT_STA | VL53L7CX_OUT_MOT))
+
 /**
  * @brief Inner Macro for API. Not for user, only for development.
  */
 
+#define VL53L7CX_NB_OUTPUT_BH			((uint16_t)12U)
+
 #define VL53L7CX_NVM_DATA_SIZE			((uint16_t)492U)
 #define VL53L7CX_CONFIGURATION_SIZE		((uint16_t)972U)
 #define VL53L7CX_OFFSET_BUFFER_SIZE		((uint16_t)488U)
@@ -256,6 +328,209 @@
 #define VL53L7CX_TEMPORARY_BUFFER_SIZE ((uint32_t) VL53L7CX_MAX_RESULTS_SIZE)
 #endif
 
+#ifdef VL53L7CX_SHARED_TEMP_BUFFER
+
+/**
+ * @brief Structure VL53L7CX_TempArena is a temporary buffer shared by several
+ * sensors (see vl53l7cx_set_temp_arena()). Each API call borrows it for its
+ * whole duration, so calls on sensors sharing an arena must never overlap.
+ * This is the case for sensors on the same I2C bus, driven from one core. An
+ * asynchronous frame read holds the arena from
+ * vl53l7cx_start_ranging_data_read() to vl53l7cx_finish_ranging_data_read().
+ */
+
+typedef struct
+{
+	uint8_t		buffer[VL53L7CX_TEMPORARY_BUFFER_SIZE];
+} VL53L7CX_TempArena;
+
+#endif
+
+
+/**
+ * @brief Default polling policy used when waiting for a firmware answer (see
+ * vl53l7cx_set_poll_policy()). The status is read again immediately, then
+ * after a wait starting at 100us and doubled at each poll, up to 10ms. The
+ * 2s timeout is the one of the original fixed 10ms polling.
+ */
+
+#define VL53L7CX_POLL_DEFAULT_IMMEDIATE_RETRIES	((uint16_t)1U)
+#define VL53L7CX_POLL_DEFAULT_INITIAL_WAIT_US	((uint32_t)100U)
+#define VL53L7CX_POLL_DEFAULT_MAX_WAIT_US	((uint32_t)10000U)
+#define VL53L7CX_POLL_DEFAULT_TIMEOUT_US	((uint32_t)2000000U)
+
+/**
+ * @brief Macro VL53L7CX_POLL_POLICY_SET marks a policy given by
+ * vl53l7cx_set_poll_policy(). Any other value (policy never set) makes
+ * vl53l7cx_init() and vl53l7cx_init_warm() load the default policy.
+ */
+
+#define VL53L7CX_POLL_POLICY_SET		((uint32_t)0x4C4C4F50U)
+
+/**
+ * @brief Structure VL53L7CX_PollPolicy sets how the driver polls the sensor
+ * while waiting for an answer (DCI accesses, init, calibration).
+ */
+
+typedef struct
+{
+	/* Number of polls done without waiting after the first read */
+	uint16_t	nb_immediate_retries;
+	/* First wait between two polls, doubled at each poll */
+	uint32_t	initial_wait_us;
+	/* Maximum wait between two polls */
+	uint32_t	max_wait_us;
+	/* Maximum cumulated wait before returning a timeout */
+	uint32_t	timeout_us;
+} VL53L7CX_PollPolicy;
+
+/**
+ * @brief Structure VL53L7CX_PollStats reports the polls done while waiting
+ * for firmware answers. 'last_*' fields are for the last answer waited, other
+ * fields are cumulated since vl53l7cx_init() or vl53l7cx_reset_poll_stats().
+ */
+
+typedef struct
+{
+	uint32_t	last_nb_polls;
+	uint32_t	last_wait_us;
+	uint32_t	nb_calls;
+	uint32_t	total_nb_polls;
+	uint32_t	total_wait_us;
+	uint32_t	max_nb_polls;
+	uint32_t	max_wait_us;
+} VL53L7CX_PollStats;
+
+/**
+ * @brief Init paths reported by vl53l7cx_get_init_report(). A cold init reboots
+ * the sensor and downloads the firmware, a warm init only reloads the
+ * configuration into the firmware already running.
+ */
+
+#define VL53L7CX_INIT_COLD			((uint8_t) 0U)
+#define VL53L7CX_INIT_WARM			((uint8_t) 1U)
+
+/**
+ * @brief Reasons for which vl53l7cx_init_warm() took the cold path.
+ */
+
+#define VL53L7CX_WARM_ACCEPTED			((uint8_t) 0U)
+#define VL53L7CX_WARM_NOT_REQUESTED		((uint8_t) 1U)
+#define VL53L7CX_WARM_NOT_ALIVE			((uint8_t) 2U)
+#define VL53L7CX_WARM_NO_SIGNATURE		((uint8_t) 3U)
+#define VL53L7CX_WARM_NO_ANSWER			((uint8_t) 4U)
+#define VL53L7CX_WARM_UNEXPECTED_STATE		((uint8_t) 5U)
+#define VL53L7CX_WARM_RELOAD_FAILED		((uint8_t) 6U)
+
+/**
+ * @brief Timeout of the firmware answers waited while probing a sensor for a
+ * warm init. A sensor without firmware never answers, so the probe must give
+ * up much sooner than the default polling policy.
+ */
+
+#define VL53L7CX_WARM_PROBE_TIMEOUT_US		((uint32_t)20000U)
+
+/**
+ * @brief Structure VL53L7CX_InitReport describes the last vl53l7cx_init() or
+ * vl53l7cx_init_warm() call.
+ */
+
+typedef struct
+{
+	/* VL53L7CX_INIT_COLD or VL53L7CX_INIT_WARM */
+	uint8_t		path;
+	/* VL53L7CX_WARM_* reason, VL53L7CX_WARM_ACCEPTED for a warm init */
+	uint8_t		warm_reject;
+	/* Wall-clock time of the whole call, probe and fallback included */
+	uint32_t	duration_us;
+} VL53L7CX_InitReport;
+
+/**
+ * @brief Macro VL53L7CX_TRANSACTION_MAX_BLOCKS is the number of DCI blocks a
+ * configuration transaction can stage, and VL53L7CX_TRANSACTION_DATA_SIZE the
+ * size of their cumulated data. All the setters of this API use 112 bytes.
+ */
+
+#define VL53L7CX_TRANSACTION_MAX_BLOCKS		((uint8_t)10U)
+#define VL53L7CX_TRANSACTION_DATA_SIZE		((uint16_t)128U)
+
+/**
+ * @brief Structure VL53L7CX_TransactionBlock describes a staged DCI block.
+ */
+
+typedef struct
+{
+	uint16_t	index;
+	uint16_t	size;
+	/* Position of block data into the transaction buffer */
+	uint16_t	offset;
+} VL53L7CX_TransactionBlock;
+
+/**
+ * @brief Structure VL53L7CX_Transaction contains configuration changes staged
+ * with vl53l7cx_transaction_*() functions, and sent to the sensor by
+ * vl53l7cx_transaction_commit().
+ */
+
+typedef struct
+{
+	VL53L7CX_TransactionBlock blocks[VL53L7CX_TRANSACTION_MAX_BLOCKS];
+	uint8_t		nb_blocks;
+	uint16_t	data_used;
+	/* Staged data, in host format */
+	uint8_t		data[VL53L7CX_TRANSACTION_DATA_SIZE];
+	/* Set for each staged byte, others are read from the sensor */
+	uint8_t		staged[VL53L7CX_TRANSACTION_DATA_SIZE];
+	/* New resolution, or 0 if unchanged */
+	uint8_t		resolution;
+} VL53L7CX_Transaction;
+
+/**
+ * @brief Structure VL53L7CX_TransactionReport gives the cost of a commit. For
+ * a dry run, one status poll is counted per firmware command.
+ */
+
+typedef struct
+{
+	/* Firmware commands (UI_CMD round trips) */
+	uint32_t	nb_ui_cmds;
+	/* DCI reads needed by partially staged blocks */
+	uint32_t	nb_dci_reads;
+	/* I2C transactions, including status polls */
+	uint32_t	nb_i2c_transactions;
+	/* I2C bytes (register address + data) */
+	uint32_t	nb_i2c_bytes;
+} VL53L7CX_TransactionReport;
+
+#ifdef VL53L7CX_USE_DCI_CACHE
+
+/**
+ * @brief Macro VL53L7CX_DCI_CACHE_ENTRIES is the number of DCI blocks kept by
+ * the shadow cache, and VL53L7CX_DCI_CACHE_BLOCK_SIZE the maximum size of a
+ * cached block. Larger blocks are always read from the sensor.
+ */
+
+#define VL53L7CX_DCI_CACHE_ENTRIES		((uint8_t)8U)
+#define VL53L7CX_DCI_CACHE_BLOCK_SIZE		((uint16_t)40U)
+
+/**
+ * @brief Structure VL53L7CX_DciCache contains the last known content of DCI
+ * blocks, in host format. A size of 0 means that the entry is free.
+ */
+
+typedef struct
+{
+	uint16_t	index[VL53L7CX_DCI_CACHE_ENTRIES];
+	uint16_t	size[VL53L7CX_DCI_CACHE_ENTRIES];
+	uint8_t		data[VL53L7CX_DCI_CACHE_ENTRIES]
+				[VL53L7CX_DCI_CACHE_BLOCK_SIZE];
+	/* Next entry replaced when the cache is full */
+	uint8_t		next;
+	uint32_t	nb_hits;
+	uint32_t	nb_misses;
+} VL53L7CX_DciCache;
+
+#endif
 
 /**
  * @brief Structure VL53L7CX_Configuration contains the sensor configuration.
@@ -274,16 +549,51 @@ typedef struct
 	uint8_t		        *default_configuration;
 	/* Address of default Xtalk buffer */
 	uint8_t		        *default_xtalk;
+#ifndef VL53L7CX_CONST_CALIBRATION
 	/* Offset buffer */
 	uint8_t		        offset_data[VL53L7CX_OFFSET_BUFFER_SIZE];
 	/* Xtalk buffer */
 	uint8_t		        xtalk_data[VL53L7CX_XTALK_BUFFER_SIZE];
+#else
+	/* Xtalk buffer, default one or user's table. Offsets are read from the
+	 * sensor NVM each time they are sent. */
+	const uint8_t	        *xtalk_data;
+#endif
+#ifndef VL53L7CX_SHARED_TEMP_BUFFER
 	/* Temporary buffer used for internal driver processing */
 	uint8_t		        temp_buffer[VL53L7CX_TEMPORARY_BUFFER_SIZE];
+#else
+	/* Temporary buffer borrowed from a shared arena */
+	uint8_t		        *temp_buffer;
+#endif
 	/* Auto-stop flag for stopping the sensor */
 	uint8_t		        is_auto_stop_enabled;
+	/* Outputs selected with vl53l7cx_set_output_mask() */
+	uint32_t	        output_mask;
+	/* Polling policy used while waiting for firmware answers */
+	VL53L7CX_PollPolicy	poll_policy;
+	/* VL53L7CX_POLL_POLICY_SET once the policy is set by the user */
+	uint32_t	        poll_policy_set;
+	/* Polling statistics */
+	VL53L7CX_PollStats	poll_stats;
+	/* Last init path and duration */
+	VL53L7CX_InitReport	init_report;
+#ifdef VL53L7CX_USE_DCI_CACHE
+	/* Shadow copy of DCI blocks */
+	VL53L7CX_DciCache	dci_cache;
+#endif
 } VL53L7CX_Configuration;
 
+/**
+ * @brief Macro VL53L7CX_DEVICE_RAM_SIZE gives the RAM used by each sensor
+ * (configuration structure), without the shared arena if
+ * VL53L7CX_SHARED_TEMP_BUFFER is defined. It depends on the platform
+ * structure, and on the VL53L7CX_SHARED_TEMP_BUFFER, VL53L7CX_CONST_CALIBRATION
+ * and VL53L7CX_USE_DCI_CACHE options.
+ */
+
+#define VL53L7CX_DEVICE_RAM_SIZE ((uint32_t)sizeof(VL53L7CX_Configuration))
+
 
 /**
  * @brief Structure VL53L7CX_ResultsData contains the ranging results of
@@ -387,6 +697,66 @@ uint8_t vl53l7cx_is_alive(
 uint8_t vl53l7cx_init(
 		VL53L7CX_Configuration		*p_dev);
 
+/**
+ * @brief This function initializes the sensor, skipping the firmware download
+ * when the sensor is still running the firmware of this driver (e.g. after a
+ * host reset which did not power the sensor down). The sensor must answer and
+ * carry the signature left by the last successful init, recorded by the
+ * platform in memory kept across host resets, and its firmware must answer
+ * DCI requests. The configuration is then reloaded as by vl53l7cx_init()
+ * (a ranging session is stopped first). In any other case, a cold init is
+ * done. The path taken is given by vl53l7cx_get_init_report().
+ * @param (VL53L7CX_Configuration) *p_dev : VL53L7CX configuration structure.
+ * @return (uint8_t) status : 0 if initialization is OK.
+ */
+
+uint8_t vl53l7cx_init_warm(
+		VL53L7CX_Configuration		*p_dev);
+
+/**
+ * @brief This function gets the path taken and the time spent by the last
+ * vl53l7cx_init() or vl53l7cx_init_warm().
+ * @param (VL53L7CX_Configuration) *p_dev : VL53L7CX configuration structure.
+ * @param (VL53L7CX_InitReport) *p_report : Last init report.
+ * @return (uint8_t) status : 0 if OK.
+ */
+
+uint8_t vl53l7cx_get_init_report(
+		VL53L7CX_Configuration		*p_dev,
+		VL53L7CX_InitReport		*p_report);
+
+/**
+ * @brief This function gets the offset data read from the sensor NVM by
+ * vl53l7cx_init(). These factory data are unique to each sensor. If
+ * VL53L7CX_CONST_CALIBRATION is defined, they are read again from the NVM, so
+ * the sensor must not be ranging.
+ * @param (VL53L7CX_Configuration) *p_dev : VL53L7CX configuration structure.
+ * @param (uint8_t) *p_offset_data : Buffer with a size defined by macro
+ * VL53L7CX_OFFSET_BUFFER_SIZE.
+ * @return (uint8_t) status : 0 if OK.
+ */
+
+uint8_t vl53l7cx_get_caldata_offset(
+		VL53L7CX_Configuration		*p_dev,
+		uint8_t				*p_offset_data);
+
+#ifdef VL53L7CX_SHARED_TEMP_BUFFER
+
+/**
+ * @brief This function attaches a shared temporary buffer to a sensor (see
+ * VL53L7CX_TempArena). It must be called before vl53l7cx_init().
+ * @param (VL53L7CX_Configuration) *p_dev : VL53L7CX configuration structure.
+ * @param (VL53L7CX_TempArena) *p_arena : Arena, shared by sensors which are
+ * never used concurrently.
+ * @return (uint8_t) status : 0 if OK, or 127 if the arena is NULL.
+ */
+
+uint8_t vl53l7cx_set_temp_arena(
+		VL53L7CX_Configuration		*p_dev,
+		VL53L7CX_TempArena		*p_arena);
+
+#endif
+
 /**
  * @brief This function is used to change the I2C address of the sensor. If
  * multiple VL53L5 sensors are connected to the same I2C line, all other LPn
@@ -451,6 +821,98 @@ uint8_t vl53l7cx_start_ranging(
 uint8_t vl53l7cx_stop_ranging(
 		VL53L7CX_Configuration		*p_dev);
 
+/**
+ * @brief This function selects the blocks sent by the sensor for each frame,
+ * using macros VL53L7CX_OUTPUT_*. For example distance and status only for
+ * obstacle avoidance (VL53L7CX_OUTPUT_DISTANCE_MM |
+ * VL53L7CX_OUTPUT_TARGET_STATUS), or VL53L7CX_OUTPUT_AVAILABLE for diagnostics.
+ * The I2C frame size (data_read_size) is recomputed by the next call to
+ * vl53l7cx_start_ranging(); fields of results structure which are not selected
+ * are not updated. vl53l7cx_init() selects all available outputs.
+ * @param (VL53L7CX_Configuration) *p_dev : VL53L7CX configuration structure.
+ * @param (uint32_t) output_mask : Combination of VL53L7CX_OUTPUT_* macros.
+ * @return (uint8_t) status : 0 if OK, or 127 if an output is unknown or has
+ * been disabled at compile time.
+ */
+
+uint8_t vl53l7cx_set_output_mask(
+		VL53L7CX_Configuration		*p_dev,
+		uint32_t			output_mask);
+
+/**
+ * @brief This function gets the outputs selected with
+ * vl53l7cx_set_output_mask().
+ * @param (VL53L7CX_Configuration) *p_dev : VL53L7CX configuration structure.
+ * @param (uint32_t) *p_output_mask : Combination of VL53L7CX_OUTPUT_* macros.
+ * @return (uint8_t) status : 0 if OK.
+ */
+
+uint8_t vl53l7cx_get_output_mask(
+		VL53L7CX_Configuration		*p_dev,
+		uint32_t			*p_output_mask);
+
+/**
+ * @brief This function gets the number of bytes read through I2C for each
+ * frame, for the current resolution and output mask. It can be used to budget
+ * the bus bandwidth (frame size * ranging frequency).
+ * @param (VL53L7CX_Configuration) *p_dev : VL53L7CX configuration structure.
+ * @param (uint32_t) *p_frame_size : Frame size in bytes.
+ * @return (uint8_t) status : 0 if OK.
+ */
+
+uint8_t vl53l7cx_get_frame_size(
+		VL53L7CX_Configuration		*p_dev,
+		uint32_t			*p_frame_size);
+
+/**
+ * @brief This function sets the policy used to poll the sensor while waiting
+ * for a firmware answer. Each DCI access (vl53l7cx_set_resolution(),
+ * vl53l7cx_set_ranging_frequency_hz(), ...) waits for an answer, which is often
+ * given after a few hundred microseconds. The policy can be set before
+ * vl53l7cx_init() or vl53l7cx_init_warm(), which keep it; otherwise they load
+ * the default policy (VL53L7CX_POLL_DEFAULT_* macros).
+ * @param (VL53L7CX_Configuration) *p_dev : VL53L7CX configuration structure.
+ * @param (VL53L7CX_PollPolicy) *p_policy : New policy.
+ * @return (uint8_t) status : 0 if OK, or 127 if a wait is 0, if
+ * max_wait_us is lower than initial_wait_us, or if timeout_us is 0.
+ */
+
+uint8_t vl53l7cx_set_poll_policy(
+		VL53L7CX_Configuration		*p_dev,
+		const VL53L7CX_PollPolicy	*p_policy);
+
+/**
+ * @brief This function gets the current polling policy.
+ * @param (VL53L7CX_Configuration) *p_dev : VL53L7CX configuration structure.
+ * @param (VL53L7CX_PollPolicy) *p_policy : Current policy.
+ * @return (uint8_t) status : 0 if OK.
+ */
+
+uint8_t vl53l7cx_get_poll_policy(
+		VL53L7CX_Configuration		*p_dev,
+		VL53L7CX_PollPolicy		*p_policy);
+
+/**
+ * @brief This function gets the polling statistics: number of polls and wait
+ * time for the last answer, and cumulated values.
+ * @param (VL53L7CX_Configuration) *p_dev : VL53L7CX configuration structure.
+ * @param (VL53L7CX_PollStats) *p_stats : Polling statistics.
+ * @return (uint8_t) status : 0 if OK.
+ */
+
+uint8_t vl53l7cx_get_poll_stats(
+		VL53L7CX_Configuration		*p_dev,
+		VL53L7CX_PollStats		*p_stats);
+
+/**
+ * @brief This function clears the polling statistics.
+ * @param (VL53L7CX_Configuration) *p_dev : VL53L7CX configuration structure.
+ * @return (uint8_t) status : 0 if OK.
+ */
+
+uint8_t vl53l7cx_reset_poll_stats(
+		VL53L7CX_Configuration		*p_dev);
+
 /**
  * @brief This function checks if a new data is ready by polling I2C. If a new
  * data is ready, a flag will be raised.
@@ -476,6 +938,37 @@ uint8_t vl53l7cx_get_ranging_data(
 		VL53L7CX_Configuration		*p_dev,
 		VL53L7CX_ResultsData		*p_results);
 
+/**
+ * @brief This function starts reading the ranging data in the background, using
+ * the platform asynchronous transfers (VL53L7CX_AsyncInit() must have been
+ * called). It returns as soon as the frame read is queued. The temporary
+ * buffer belongs to the transfer until vl53l7cx_finish_ranging_data_read() is
+ * called, so no other API function can be used in between.
+ * @param (VL53L7CX_Configuration) *p_dev : VL53L7CX configuration structure.
+ * @return (uint8_t) status : 0 if the read is started.
+ */
+
+uint8_t vl53l7cx_start_ranging_data_read(
+		VL53L7CX_Configuration		*p_dev);
+
+/**
+ * @brief This function waits for a read started with
+ * vl53l7cx_start_ranging_data_read(), then decodes the frame, as
+ * vl53l7cx_get_ranging_data() does.
+ * @param (VL53L7CX_Configuration) *p_dev : VL53L7CX configuration structure.
+ * @param (VL53L7CX_ResultsData) *p_results : VL53L5 results structure.
+ * @param (uint32_t) timeout_ms : Maximum time to wait for the transfer.
+ * @return (uint8_t) status : 0 data are successfully get,
+ * VL53L7CX_STATUS_TIMEOUT_ERROR if the transfer timed out,
+ * VL53L7CX_STATUS_ERROR if it failed on the bus, or
+ * VL53L7CX_STATUS_INVALID_PARAM if no read was started since the last call.
+ */
+
+uint8_t vl53l7cx_finish_ranging_data_read(
+		VL53L7CX_Configuration		*p_dev,
+		VL53L7CX_ResultsData		*p_results,
+		uint32_t			timeout_ms);
+
 /**
  * @brief This function gets the current resolution (4x4 or 8x8).
  * @param (VL53L7CX_Configuration) *p_dev : VL53L7CX configuration structure.
@@ -738,4 +1231,135 @@ uint8_t vl53l7cx_dci_replace_data(
 		uint16_t			new_data_size,
 		uint16_t			new_data_pos);
 
+/**
+ * @brief This function drops the shadow copy of DCI blocks (see
+ * VL53L7CX_USE_DCI_CACHE). It is called by vl53l7cx_init(), and must be called
+ * if DCI blocks are modified without using this API (raw UI commands, sensor
+ * reset).
+ * @param (VL53L7CX_Configuration) *p_dev : VL53L7CX configuration structure.
+ * @return (uint8_t) status : 0 if OK.
+ */
+
+uint8_t vl53l7cx_dci_cache_invalidate(
+		VL53L7CX_Configuration		*p_dev);
+
+/**
+ * @brief This function gets the DCI cache counters. A hit is a
+ * vl53l7cx_dci_replace_data() (or transaction block) which did not need to read
+ * the sensor, a miss is one which did. Both are 0 if the cache is disabled.
+ * @param (VL53L7CX_Configuration) *p_dev : VL53L7CX configuration structure.
+ * @param (uint32_t) *p_nb_hits : Number of hits since init.
+ * @param (uint32_t) *p_nb_misses : Number of misses since init.
+ * @return (uint8_t) status : 0 if OK.
+ */
+
+uint8_t vl53l7cx_get_dci_cache_stats(
+		VL53L7CX_Configuration		*p_dev,
+		uint32_t			*p_nb_hits,
+		uint32_t			*p_nb_misses);
+
+/**
+ * @brief This function clears a configuration transaction. A transaction groups
+ * several configuration changes, and sends them with the minimum number of
+ * firmware commands: a block partially modified is read once, and all blocks
+ * are written by a single command.
+ * @param (VL53L7CX_Transaction) *p_txn : Transaction to clear.
+ * @return (uint8_t) status : 0 if OK.
+ */
+
+uint8_t vl53l7cx_transaction_init(
+		VL53L7CX_Transaction		*p_txn);
+
+/**
+ * @brief This function stages a full DCI block write (equivalent of
+ * vl53l7cx_dci_write_data()).
+ * @param (VL53L7CX_Transaction) *p_txn : Transaction.
+ * @param (uint8_t) *data : Block data, copied into the transaction.
+ * @param (uint32_t) index : DCI index of the block.
+ * @param (uint16_t) data_size : Block size, multiple of 4 bytes.
+ * @return (uint8_t) status : 0 if OK, or 127 if the transaction is full or if
+ * the block is already staged with another size.
+ */
+
+uint8_t vl53l7cx_transaction_write_data(
+		VL53L7CX_Transaction		*p_txn,
+		uint8_t				*data,
+		uint32_t			index,
+		uint16_t			data_size);
+
+/**
+ * @brief This function stages a partial DCI block write (equivalent of
+ * vl53l7cx_dci_replace_data()). Bytes not staged are read from the sensor
+ * during the commit.
+ * @param (VL53L7CX_Transaction) *p_txn : Transaction.
+ * @param (uint32_t) index : DCI index of the block.
+ * @param (uint16_t) data_size : Block size, multiple of 4 bytes.
+ * @param (uint8_t) *new_data : Contains the new fields.
+ * @param (uint16_t) new_data_size : New data size.
+ * @param (uint16_t) new_data_pos : New data position into the block.
+ * @return (uint8_t) status : 0 if OK, or 127 if the transaction is full or if
+ * the block is already staged with another size.
+ */
+
+uint8_t vl53l7cx_transaction_replace_data(
+		VL53L7CX_Transaction		*p_txn,
+		uint32_t			index,
+		uint16_t			data_size,
+		uint8_t				*new_data,
+		uint16_t			new_data_size,
+		uint16_t			new_data_pos);
+
+/**
+ * @brief These functions stage the same changes as the matching
+ * vl53l7cx_set_*() functions, with the same parameter checks. A resolution
+ * change also sends offset and Xtalk data during the commit.
+ * @param (VL53L7CX_Transaction) *p_txn : Transaction.
+ * @return (uint8_t) status : 0 if OK, or 127 if a parameter is invalid or if
+ * the transaction is full.
+ */
+
+uint8_t vl53l7cx_transaction_set_resolution(
+		VL53L7CX_Transaction		*p_txn,
+		uint8_t				resolution);
+
+uint8_t vl53l7cx_transaction_set_ranging_frequency_hz(
+		VL53L7CX_Transaction		*p_txn,
+		uint8_t				frequency_hz);
+
+uint8_t vl53l7cx_transaction_set_integration_time_ms(
+		VL53L7CX_Transaction		*p_txn,
+		uint32_t			integration_time_ms);
+
+uint8_t vl53l7cx_transaction_set_sharpener_percent(
+		VL53L7CX_Transaction		*p_txn,
+		uint8_t				sharpener_percent);
+
+uint8_t vl53l7cx_transaction_set_target_order(
+		VL53L7CX_Transaction		*p_txn,
+		uint8_t				target_order);
+
+uint8_t vl53l7cx_transaction_set_ranging_mode(
+		VL53L7CX_Transaction		*p_txn,
+		uint8_t				ranging_mode);
+
+/**
+ * @brief This function sends a transaction to the sensor. Partially staged
+ * blocks are read first, then all blocks are written with as few firmware
+ * commands as the command buffer allows (usually one). The sensor must not be
+ * ranging. The transaction is not cleared, and can be committed again.
+ * @param (VL53L7CX_Configuration) *p_dev : VL53L7CX configuration structure.
+ * @param (VL53L7CX_Transaction) *p_txn : Transaction to commit.
+ * @param (uint8_t) dry_run : If not 0, nothing is sent and only the report is
+ * filled.
+ * @param (VL53L7CX_TransactionReport) *p_report : Optional (can be NULL),
+ * number of commands, I2C transactions and bytes of the commit.
+ * @return (uint8_t) status : 0 if OK.
+ */
+
+uint8_t vl53l7cx_transaction_commit(
+		VL53L7CX_Configuration		*p_dev,
+		VL53L7CX_Transaction		*p_txn,
+		uint8_t				dry_run,
+		VL53L7CX_TransactionReport	*p_report);
+
 #endif //VL53L7CX_API_H_
@@ -47,7 +47,8 @@
  * distance is 600mm, and maximum is 3000mm. The target must stay in Full FOV,
  * so short distance are easier for calibration.
  * @return (uint8_t) status : 0 if calibration OK, 127 if an argument has an
- * incorrect value, or 255 is something failed.
+ * incorrect value or if VL53L7CX_CONST_CALIBRATION is defined (no RAM buffer to
+ * keep the result), or 255 is something failed.
  */
 
 uint8_t vl53l7cx_calibrate_xtalk(
@@ -71,7 +72,8 @@ uint8_t vl53l7cx_get_caldata_xtalk(
 
 /**
  * @brief This function sets the Xtalk buffer. This function can be used to
- * override default Xtalk buffer.
+ * override default Xtalk buffer. If VL53L7CX_CONST_CALIBRATION is defined, the
+ * buffer is not copied: it must stay valid (e.g. a const table in flash).
  * @param (VL53L7CX_Configuration) *p_dev : VL53L5 configuration structure.
  * @param (uint8_t) *p_xtalk_data : Buffer with a size defined by
  * macro VL53L7CX_XTALK_SIZE.
@@ -80,7 +82,7 @@ uint8_t vl53l7cx_get_caldata_xtalk(
 
 uint8_t vl53l7cx_set_caldata_xtalk(
 		VL53L7CX_Configuration		*p_dev,
-		uint8_t				*p_xtalk_data);
+		const uint8_t			*p_xtalk_data);
 
 /**
  * @brief This function gets the Xtalk margin. This margin is used to increase
@@ -0,0 +1,288 @@
+/**
+ * VL53L7CX Multicore Example for Pico 2
+ *
+ * Same output as main_st_driver.c, split over the two RP2350 cores: core1 owns
+ * the sensor and fills results slots, core0 prints them. Frames are handed over
+ * through a lock-free ring (vl53l7cx_results_ring.h), so a slow USB print never
+ * delays the next acquisition. Frames arriving while every slot is still held
+ * by core0 are read anyway, so that the next one is not read late, then
+ * dropped: one overrun is counted per frame lost.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+#include "pico/stdlib.h"
+#include "pico/multicore.h"
+#include "hardware/i2c.h"
+#include "hardware/gpio.h"
+#include "vl53l7cx_api.h"
+#include "vl53l7cx_events.h"
+#include "vl53l7cx_results_ring.h"
+
+// I2C Configuration for Pico 2
+#define I2C_PORT i2c0
+#define I2C_SDA_PIN 4
+#define I2C_SCL_PIN 5
+#define I2C_FREQ 400000  // 400 kHz
+
+// Sensor INT pin (active low when a frame is ready). Uncomment only if the pin
+// is wired. Left commented out, core1 polls vl53l7cx_check_data_ready() every
+// 10 ms.
+// #define SENSOR_INT_PIN 6
+
+// LED pin for status indication
+#define LED_PIN 25
+
+// Number of frames printed before stopping
+#define NB_FRAMES 100
+
+/* Shared between cores */
+static VL53L7CX_Configuration Dev;              /* Owned by core1 once launched */
+static VL53L7CX_ResultsRing Ring;               /* core1 produces, core0 consumes */
+static VL53L7CX_ResultsSlot Discard;            /* core1: frame read with the ring full */
+static volatile uint8_t StopRequested;          /* Written by core0 */
+static volatile uint8_t Core1Done;              /* Written by core1 */
+
+/**
+ * @brief Store the frame timestamp into the slot being filled
+ */
+static void store_timestamp(VL53L7CX_Configuration *p_dev,
+        VL53L7CX_ResultsData *p_results, uint64_t timestamp_us, void *p_user)
+{
+    ((VL53L7CX_ResultsSlot *)p_user)->timestamp_us = timestamp_us;
+}
+
+/**
+ * @brief Acquire one frame into a slot
+ * @return VL53L7CX_STATUS_OK if the slot holds a new frame
+ */
+#ifdef SENSOR_INT_PIN
+static uint8_t acquire_frame(VL53L7CX_EventSource *p_source, VL53L7CX_ResultsSlot *p_slot)
+{
+    uint8_t status, isReady = 0;
+
+    status = vl53l7cx_events_acquire(&Dev, p_source, &p_slot->results, 100,
+            store_timestamp, p_slot);
+    if (status == VL53L7CX_STATUS_TIMEOUT_ERROR) {
+        // INT pin silent (not wired?): fall back to a single poll
+        status = vl53l7cx_check_data_ready(&Dev, &isReady);
+        if (isReady) {
+            p_slot->timestamp_us = time_us_64();
+            status |= vl53l7cx_get_ranging_data(&Dev, &p_slot->results);
+        } else {
+            status = VL53L7CX_STATUS_TIMEOUT_ERROR;
+        }
+    }
+
+    return status;
+}
+#else
+static uint8_t acquire_frame(VL53L7CX_ResultsSlot *p_slot)
+{
+    uint8_t status, isReady = 0;
+
+    status = vl53l7cx_check_data_ready(&Dev, &isReady);
+    if (!isReady) {
+        VL53L7CX_WaitMs(&(Dev.platform), 10);
+        return VL53L7CX_STATUS_TIMEOUT_ERROR;
+    }
+
+    p_slot->timestamp_us = time_us_64();
+    status |= vl53l7cx_get_ranging_data(&Dev, &p_slot->results);
+
+    return status;
+}
+#endif
+
+/**
+ * @brief Core1: sensor acquisition loop
+ */
+static void core1_main(void)
+{
+    VL53L7CX_ResultsSlot *p_slot;
+    uint32_t sequence = 0;
+    uint8_t status;
+#ifdef SENSOR_INT_PIN
+    VL53L7CX_EventSource DataReady;     /* Fed by the INT pin interrupt */
+
+    // The GPIO interrupt is enabled on the calling core
+    VL53L7CX_EventSourceInitGpio(&DataReady, SENSOR_INT_PIN);
+#endif
+
+    while (!StopRequested) {
+        // Only core1 fills slots: below the ring size, begin_write succeeds.
+        // With every slot held by core0, the frame goes to the discard slot
+        if (vl53l7cx_results_ring_count(&Ring) < VL53L7CX_RESULTS_RING_SIZE) {
+            p_slot = vl53l7cx_results_ring_begin_write(&Ring);
+        } else {
+            p_slot = &Discard;
+        }
+
+#ifdef SENSOR_INT_PIN
+        status = acquire_frame(&DataReady, p_slot);
+#else
+        status = acquire_frame(p_slot);
+#endif
+        if (status == VL53L7CX_STATUS_TIMEOUT_ERROR) {
+            continue;   // No frame yet, keep the slot
+        }
+
+        if (p_slot == &Discard) {
+            // A frame was read with the ring full: publish it if core0 freed
+            // a slot meanwhile, else it is lost (one overrun counted)
+            p_slot = vl53l7cx_results_ring_begin_write(&Ring);
+            if (!p_slot) {
+                continue;
+            }
+            memcpy(p_slot, &Discard, sizeof(Discard));
+        }
+
+        p_slot->status = status;
+        p_slot->sequence = sequence++;
+        p_slot->streamcount = Dev.streamcount;
+        vl53l7cx_results_ring_end_write(&Ring);
+    }
+
+    vl53l7cx_stop_ranging(&Dev);
+    Core1Done = 1;
+}
+
+/**
+ * @brief Print one frame (8x8 distances and status)
+ */
+static void print_frame(const VL53L7CX_ResultsSlot *p_slot)
+{
+    const VL53L7CX_ResultsData *p_results = &p_slot->results;
+
+    printf("Measurement #%3lu (status %u, t=%llu us):\n",
+            (unsigned long)p_slot->sequence, p_slot->status,
+            (unsigned long long)p_slot->timestamp_us);
+    printf("=== VL53L7CX Zone Distance Data (8x8 grid) ===\n");
+    printf("Zone distances in mm:\n");
+    for (int row = 0; row < 8; row++) {
+        printf("Row %d: ", row);
+        for (int col = 0; col < 8; col++) {
+            int zone = row * 8 + col;
+            printf("%4d ", p_results->distance_mm[VL53L7CX_NB_TARGET_PER_ZONE * zone]);
+        }
+        printf("\n");
+    }
+
+    printf("\nZone status (0=OK, 1=Error):\n");
+    for (int row = 0; row < 8; row++) {
+        printf("Row %d: ", row);
+        for (int col = 0; col < 8; col++) {
+            int zone = row * 8 + col;
+            printf("%4d ", p_results->target_status[VL53L7CX_NB_TARGET_PER_ZONE * zone]);
+        }
+        printf("\n");
+    }
+    printf("===============================================\n\n");
+}
+
+static void blink_forever(uint32_t period_ms)
+{
+    while (true) {
+        gpio_put(LED_PIN, 0);
+        sleep_ms(period_ms);
+        gpio_put(LED_PIN, 1);
+        sleep_ms(period_ms);
+    }
+}
+
+int main() {
+    VL53L7CX_ResultsSlot *p_slot;
+    VL53L7CX_ResultsRingStats stats;
+    uint8_t status, isAlive;
+    uint32_t printed = 0;
+
+    // Initialize stdio for USB output
+    stdio_init_all();
+
+    // Wait for USB serial to be ready
+    sleep_ms(2000);
+
+    // Initialize LED
+    gpio_init(LED_PIN);
+    gpio_set_dir(LED_PIN, GPIO_OUT);
+    gpio_put(LED_PIN, 1);  // Turn on LED to indicate startup
+
+    printf("VL53L7CX Multicore Example for Pico 2\n");
+    printf("=====================================\n");
+
+    // Initialize I2C
+    i2c_init(I2C_PORT, I2C_FREQ);
+    gpio_set_function(I2C_SDA_PIN, GPIO_FUNC_I2C);
+    gpio_set_function(I2C_SCL_PIN, GPIO_FUNC_I2C);
+    gpio_pull_up(I2C_SDA_PIN);
+    gpio_pull_up(I2C_SCL_PIN);
+
+    /* Fill the platform structure with Pico 2 implementation */
+    Dev.platform.address = 0x29;
+    Dev.platform.i2c_instance = I2C_PORT;
+    Dev.platform.sda_pin = I2C_SDA_PIN;
+    Dev.platform.scl_pin = I2C_SCL_PIN;
+
+    /* Sensor set up on core0, before core1 takes it over */
+    status = vl53l7cx_is_alive(&Dev, &isAlive);
+    if (!isAlive || status) {
+        printf("VL53L7CX not detected at requested address 0x%02X\n", VL53L7CX_DEFAULT_I2C_ADDRESS);
+        blink_forever(100);
+    }
+
+    status = vl53l7cx_init(&Dev);
+    if (status) {
+        printf("VL53L7CX ULD Loading failed (status: %d)\n", status);
+        blink_forever(500);
+    }
+
+    status = vl53l7cx_set_resolution(&Dev, VL53L7CX_RESOLUTION_8X8);
+    status |= vl53l7cx_start_ranging(&Dev);
+    if (status) {
+        printf("Failed to start ranging (status: %d)\n", status);
+        blink_forever(500);
+    }
+
+    gpio_put(LED_PIN, 0);
+    printf("Ranging started, acquisition on core1, %u results slots\n\n",
+            VL53L7CX_RESULTS_RING_SIZE);
+
+    /* Hand the sensor over to core1 */
+    vl53l7cx_results_ring_init(&Ring);
+    multicore_launch_core1(core1_main);
+
+    /*********************************/
+    /*     Consumer loop (core0)     */
+    /*********************************/
+
+    while (printed < NB_FRAMES) {
+        p_slot = vl53l7cx_results_ring_begin_read(&Ring);
+        if (!p_slot) {
+            sleep_us(500);
+            continue;
+        }
+
+        print_frame(p_slot);
+        vl53l7cx_results_ring_end_read(&Ring);
+        printed++;
+
+        if ((printed % 10U) == 0U) {
+            vl53l7cx_results_ring_get_stats(&Ring, &stats);
+            printf("Ring: %lu published, %lu consumed, %lu overruns\n\n",
+                    (unsigned long)stats.published,
+                    (unsigned long)stats.consumed,
+                    (unsigned long)stats.overruns);
+        }
+    }
+
+    StopRequested = 1;
+    while (!Core1Done) {
+        sleep_ms(1);
+    }
+
+    printf("End of VL53L7CX multicore demo\n");
+    gpio_put(LED_PIN, 1);
+
+    return 0;
+}
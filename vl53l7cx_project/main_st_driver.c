@@ -12,6 +12,9 @@
 #include "hardware/i2c.h"
 #include "hardware/gpio.h"
 #include "vl53l7cx_api.h"
+#include "vl53l7cx_calstore.h"
+#include "vl53l7cx_events.h"
+#include "vl53l7cx_stream.h"
 
 // I2C Configuration for Pico 2
 #define I2C_PORT i2c0
@@ -19,9 +22,44 @@
 #define I2C_SCL_PIN 5
 #define I2C_FREQ 400000  // 400 kHz
 
+// Sensor INT pin (active low when a frame is ready). Uncomment only if the pin
+// is wired: the reader then sleeps until the interrupt, for at most one frame
+// period before a single vl53l7cx_check_data_ready(). Left commented out, the
+// loop polls vl53l7cx_check_data_ready() every 10 ms.
+// #define SENSOR_INT_PIN 6
+
+// Flash slot holding the calibration of this sensor (see vl53l7cx_calstore.h).
+// Comment out to always use the default Xtalk data.
+#define CALIBRATION_SLOT 0
+
+// Frames sent as binary packets (vl53l7cx_stream.h) at the sensor maximum
+// frequency, with every enabled output. Comment out to print the text grid.
+// #define BINARY_STREAM
+
+// Temporal filter of the distances (vl53l7cx_filter.h), and its time per frame
+// in the text output. Needs the VL53L7CX_TEMPORAL_FILTER CMake option, which
+// builds vl53l7cx_filter.c. Comment out to output the sensor distances.
+// #define TEMPORAL_FILTER VL53L7CX_FILTER_KALMAN
+
+#ifdef TEMPORAL_FILTER
+#include "hardware/clocks.h"
+#include "vl53l7cx_filter.h"
+#endif
+
 // LED pin for status indication
 #define LED_PIN 25
 
+#ifdef BINARY_STREAM
+/**
+ * @brief Keep the frame timestamp (INT pin interrupt time)
+ */
+static void store_timestamp(VL53L7CX_Configuration *p_dev,
+        VL53L7CX_ResultsData *p_results, uint64_t timestamp_us, void *p_user)
+{
+    *(uint64_t *)p_user = timestamp_us;
+}
+#endif
+
 int main() {
     // Initialize stdio for USB output
     stdio_init_all();
@@ -53,6 +91,19 @@ int main() {
     uint8_t 				status, loop, isAlive, isReady, i;
     VL53L7CX_Configuration 	Dev;			/* Sensor configuration */
     VL53L7CX_ResultsData 	Results;		/* Results data from VL53L7CX */
+    VL53L7CX_InitReport 	InitReport;		/* Init path and duration */
+#ifdef SENSOR_INT_PIN
+    VL53L7CX_EventSource 	DataReady;		/* Fed by the INT pin interrupt */
+    uint32_t 				FramePeriodMs = 1000;	/* INT pin timeout, 1 Hz by default */
+#endif
+#ifdef BINARY_STREAM
+    static VL53L7CX_Stream 	Stream;			/* Binary frames on USB */
+    uint64_t 				Timestamp = 0;	/* Frame time (us) */
+#endif
+#ifdef TEMPORAL_FILTER
+    static VL53L7CX_Filter 	Filter;			/* Distance smoothing */
+    uint32_t 				FilterUs = 0;	/* Filter time of the last frame */
+#endif
     
     /*********************************/
     /*      Customer platform        */
@@ -94,9 +145,14 @@ int main() {
     
     printf("VL53L7CX sensor detected!\n");
     
-    /* (Mandatory) Init VL53L7CX sensor */
+    /* (Mandatory) Init VL53L7CX sensor. The firmware download is skipped if
+     * the sensor kept running since the last init (e.g. watchdog reset) */
     printf("Initializing VL53L7CX sensor...\n");
-    status = vl53l7cx_init(&Dev);
+    status = vl53l7cx_init_warm(&Dev);
+    vl53l7cx_get_init_report(&Dev, &InitReport);
+    printf("%s init in %lu us (warm reject reason: %u)\n",
+            (InitReport.path == VL53L7CX_INIT_WARM) ? "Warm" : "Cold",
+            (unsigned long)InitReport.duration_us, InitReport.warm_reject);
     if(status)
     {
         printf("VL53L7CX ULD Loading failed (status: %d)\n", status);
@@ -109,6 +165,22 @@ int main() {
     }
     
     printf("VL53L7CX ULD ready ! (Version : %s)\n", VL53L7CX_API_REVISION);
+
+#ifdef CALIBRATION_SLOT
+    {
+        static VL53L7CX_CalRecord CalRecord;   /* Kept in use by the driver with VL53L7CX_CONST_CALIBRATION */
+        VL53L7CX_CalStore CalStore;
+
+        VL53L7CX_CalStoreInitPico(&CalStore, CALIBRATION_SLOT + 1);
+        status = vl53l7cx_calstore_load(&CalStore, CALIBRATION_SLOT, &CalRecord);
+        if (status == VL53L7CX_CALSTORE_OK) {
+            status = vl53l7cx_calstore_apply(&Dev, &CalRecord);
+        }
+        printf("Calibration slot %d: %s (status %u)\n", CALIBRATION_SLOT,
+                (status == VL53L7CX_CALSTORE_OK) ? "applied" : "not applied, default Xtalk",
+                status);
+    }
+#endif
     
     // Set sensor to 8x8 mode for full resolution
     printf("Setting sensor to 8x8 mode...\n");
@@ -119,6 +191,23 @@ int main() {
         printf("Sensor set to 8x8 mode successfully\n");
     }
     
+#ifdef BINARY_STREAM
+    // Maximum frequency in 8x8 (15 Hz): the binary output keeps up with it
+    status = vl53l7cx_set_ranging_frequency_hz(&Dev, 15);
+    if(status) {
+        printf("Failed to set ranging frequency (status: %d)\n", status);
+    }
+#ifdef SENSOR_INT_PIN
+    FramePeriodMs = (1000 + 14) / 15;
+#endif
+    VL53L7CX_StreamInitPico(&Stream, 0);
+    vl53l7cx_stream_set_delta(&Stream, 15);     // One raw frame per second
+#endif
+    
+#ifdef TEMPORAL_FILTER
+    vl53l7cx_filter_init(&Filter, TEMPORAL_FILTER);
+#endif
+    
     // Turn off LED to indicate successful initialization
     gpio_put(LED_PIN, 0);
     
@@ -142,16 +231,68 @@ int main() {
     printf("Reading distance data from all zones (8x8 grid)...\n");
     printf("Press Ctrl+C to stop\n\n");
     
+#ifdef SENSOR_INT_PIN
+    VL53L7CX_EventSourceInitGpio(&DataReady, SENSOR_INT_PIN);
+#endif
+    
     loop = 0;
     while(loop < 100)  // Read 100 measurements
     {
+#ifdef SENSOR_INT_PIN
+        /* Sleep until the INT pin signals a new frame, then read it. If the
+         * pin stays silent for a frame period, fall back to a single poll. */
+#ifdef BINARY_STREAM
+        status = vl53l7cx_events_acquire(&Dev, &DataReady, &Results, FramePeriodMs,
+                store_timestamp, &Timestamp);
+#else
+        status = vl53l7cx_events_acquire(&Dev, &DataReady, &Results, FramePeriodMs,
+                NULL, NULL);
+#endif
+        isReady = (status == VL53L7CX_STATUS_OK);
+        if(status == VL53L7CX_STATUS_TIMEOUT_ERROR)
+        {
+            status = vl53l7cx_check_data_ready(&Dev, &isReady);
+            if(isReady)
+            {
+#ifdef BINARY_STREAM
+                Timestamp = time_us_64();
+#endif
+                vl53l7cx_get_ranging_data(&Dev, &Results);
+            }
+        }
+#else
         /* Use polling function to know when a new measurement is ready */
         status = vl53l7cx_check_data_ready(&Dev, &isReady);
-        
         if(isReady)
         {
+#ifdef BINARY_STREAM
+            Timestamp = time_us_64();
+#endif
             vl53l7cx_get_ranging_data(&Dev, &Results);
-            
+        }
+#endif
+        
+#ifdef TEMPORAL_FILTER
+        if(isReady)
+        {
+            uint64_t FilterStart = time_us_64();
+            vl53l7cx_filter_apply(&Filter, &Results, VL53L7CX_RESOLUTION_8X8);
+            FilterUs = (uint32_t)(time_us_64() - FilterStart);
+        }
+#endif
+        
+#ifdef BINARY_STREAM
+        if(isReady)
+        {
+            /* Send every enabled output, no delay: toggle the LED per frame */
+            vl53l7cx_stream_send(&Stream, &Dev, &Results,
+                    VL53L7CX_RESOLUTION_8X8, Timestamp);
+            gpio_put(LED_PIN, loop & 1U);
+            loop++;
+        }
+#else
+        if(isReady)
+        {
             /* Print data for all 64 zones (8x8 mode) */
             printf("Measurement #%3u:\n", Dev.streamcount);
             printf("=== VL53L7CX Zone Distance Data (8x8 grid) ===\n");
@@ -175,6 +316,11 @@ int main() {
                 }
                 printf("\n");
             }
+#ifdef TEMPORAL_FILTER
+            printf("\nFilter: %lu us (%lu cycles), %lu restarts\n", (unsigned long)FilterUs,
+                    (unsigned long)(FilterUs * (clock_get_hz(clk_sys) / 1000000U)),
+                    (unsigned long)Filter.restarts);
+#endif
             printf("===============================================\n\n");
             
             // Brief LED flash to indicate successful reading
@@ -184,9 +330,12 @@ int main() {
             
             loop++;
         }
+#endif
         
+#ifndef SENSOR_INT_PIN
         /* Wait a few ms to avoid too high polling */
         VL53L7CX_WaitMs(&(Dev.platform), 10);
+#endif
     }
     
     status = vl53l7cx_stop_ranging(&Dev);
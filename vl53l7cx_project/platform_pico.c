@@ -6,6 +6,17 @@
  */
 
 #include "platform_pico.h"
+#include "hardware/dma.h"
+#include "hardware/flash.h"
+#include "hardware/gpio.h"
+#include "pico/flash.h"
+#include "vl53l7cx_calstore.h"
+#include "vl53l7cx_events.h"
+#include "vl53l7cx_manager.h"
+#include "vl53l7cx_stream.h"
+
+/* Maximum number of sensors whose INT pin feeds an event source */
+#define VL53L7CX_MAX_GPIO_SOURCES       4U
 
 /**
  * @brief Read a single byte from VL53L7CX sensor
@@ -73,6 +84,56 @@ uint8_t VL53L7CX_WrByte(
     return status;
 }
 
+/**
+ * @brief Write a list of buffers to VL53L7CX sensor as a single I2C transaction
+ * @param p_platform: Pointer to platform structure
+ * @param p_segments: Segments to send, in order
+ * @param nb_segments: Number of segments
+ * @return 0 if OK, non-zero if error
+ *
+ * Every segment except the last one is sent in burst mode (no STOP, no
+ * RESTART), so the controller holds the bus while the next segment is queued.
+ * Data is streamed straight from the caller's buffers (RAM or flash), nothing
+ * is copied.
+ */
+uint8_t VL53L7CX_WrGather(
+        VL53L7CX_Platform *p_platform,
+        const VL53L7CX_WrSegment *p_segments,
+        uint8_t nb_segments)
+{
+    uint8_t status = 0;
+    uint8_t i;
+    int result;
+    
+    if (!p_platform || !p_segments || nb_segments == 0) {
+        return 255; // Error: invalid parameters
+    }
+    
+    for (i = 0; i < nb_segments; i++) {
+        if (!p_segments[i].data || p_segments[i].size == 0) {
+            return 255; // Error: empty segment
+        }
+    }
+    
+    // Queue all segments but the last one without releasing the bus
+    for (i = 0; i < (uint8_t)(nb_segments - 1); i++) {
+        result = i2c_write_burst_blocking(p_platform->i2c_instance, p_platform->address,
+                p_segments[i].data, p_segments[i].size);
+        if (result != (int)p_segments[i].size) {
+            return 255; // Error: failed to write
+        }
+    }
+    
+    // Last segment closes the transaction with a STOP
+    result = i2c_write_blocking(p_platform->i2c_instance, p_platform->address,
+            p_segments[i].data, p_segments[i].size, false);
+    if (result != (int)p_segments[i].size) {
+        return 255; // Error: failed to write
+    }
+    
+    return status;
+}
+
 /**
  * @brief Write multiple bytes to VL53L7CX sensor
  * @param p_platform: Pointer to platform structure
@@ -87,25 +148,19 @@ uint8_t VL53L7CX_WrMulti(
         uint8_t *p_values,
         uint32_t size)
 {
-    uint8_t status = 0;
-    
     if (!p_platform || !p_values || size == 0) {
         return 255; // Error: invalid parameters
     }
     
-    // Prepare data buffer (register address + values)
-    uint8_t buffer[size + 2];
-    buffer[0] = (RegisterAdress >> 8) & 0xFF;
-    buffer[1] = RegisterAdress & 0xFF;
-    memcpy(&buffer[2], p_values, size);
-    
-    // Write register address and values
-    int result = i2c_write_blocking(p_platform->i2c_instance, p_platform->address, buffer, size + 2, false);
-    if (result != (int)(size + 2)) {
-        return 255; // Error: failed to write
-    }
+    // Register address (16-bit, big-endian) followed by the caller's buffer.
+    // The payload is not copied: firmware chunks are streamed from flash.
+    uint8_t reg_addr[2] = {(RegisterAdress >> 8) & 0xFF, RegisterAdress & 0xFF};
+    VL53L7CX_WrSegment segments[2] = {
+        {reg_addr, 2},
+        {p_values, size}
+    };
     
-    return status;
+    return VL53L7CX_WrGather(p_platform, segments, 2);
 }
 
 /**
@@ -146,6 +201,443 @@ uint8_t VL53L7CX_RdMulti(
     return status;
 }
 
+/**
+ * @brief Expand the next chunk of an asynchronous write into the bounce buffer
+ * and hand it to the TX DMA channel. The last byte carries the STOP.
+ * @param p_platform: Pointer to platform structure
+ * @param p_xfer: Current transfer
+ */
+static void _vl53l7cx_dma_queue_write(
+        VL53L7CX_Platform *p_platform,
+        VL53L7CX_AsyncXfer *p_xfer)
+{
+    VL53L7CX_PicoDma *p_dma = &p_platform->dma;
+    i2c_hw_t *hw = i2c_get_hw(p_platform->i2c_instance);
+    uint32_t remaining = p_xfer->size - p_dma->tx_queued;
+    uint32_t n = (remaining > VL53L7CX_ASYNC_BOUNCE_SIZE) ? VL53L7CX_ASYNC_BOUNCE_SIZE : remaining;
+    uint32_t i;
+    
+    for (i = 0; i < n; i++) {
+        p_dma->bounce[i] = p_xfer->p_data[p_dma->tx_queued + i];
+    }
+    if (n == remaining) {
+        p_dma->bounce[n - 1] |= I2C_IC_DATA_CMD_STOP_BITS;
+    }
+    p_dma->tx_queued += n;
+    
+    dma_channel_config c = dma_channel_get_default_config(p_dma->dma_tx);
+    channel_config_set_transfer_data_size(&c, DMA_SIZE_16);
+    channel_config_set_read_increment(&c, true);
+    channel_config_set_write_increment(&c, false);
+    channel_config_set_dreq(&c, i2c_get_dreq(p_platform->i2c_instance, true));
+    dma_channel_configure(p_dma->dma_tx, &c, &hw->data_cmd, p_dma->bounce, n, true);
+}
+
+/**
+ * @brief Async bus operation: start a register access on the DMA channels
+ * @param p_ctx: Pointer to platform structure
+ * @param p_xfer: Transfer to start
+ * @return 0 if OK, non-zero if error
+ */
+static uint8_t _vl53l7cx_dma_start(
+        void *p_ctx,
+        VL53L7CX_AsyncXfer *p_xfer)
+{
+    VL53L7CX_Platform *p_platform = (VL53L7CX_Platform *)p_ctx;
+    VL53L7CX_PicoDma *p_dma = &p_platform->dma;
+    i2c_hw_t *hw = i2c_get_hw(p_platform->i2c_instance);
+    
+    // Select target and clear stale completion flags. TAR can only be written
+    // once the block is disabled, which takes effect at the end of a transfer
+    hw->enable = 0;
+    while (hw->enable_status & I2C_IC_ENABLE_STATUS_IC_EN_BITS) {
+        tight_loop_contents();
+    }
+    hw->tar = p_platform->address;
+    hw->enable = 1;
+    (void)hw->clr_stop_det;
+    (void)hw->clr_tx_abrt;
+    hw->dma_cr = I2C_IC_DMA_CR_TDMAE_BITS | I2C_IC_DMA_CR_RDMAE_BITS;
+    
+    // Register address (16-bit, big-endian), no STOP
+    hw->data_cmd = (p_xfer->register_address >> 8) & 0xFF;
+    hw->data_cmd = p_xfer->register_address & 0xFF;
+    
+    p_dma->last_cmd_pending = 0;
+    p_dma->tx_queued = 0;
+    
+    if (p_xfer->direction == VL53L7CX_ASYNC_WRITE) {
+        _vl53l7cx_dma_queue_write(p_platform, p_xfer);
+        return 0;
+    }
+    
+    // RX channel drains every received byte into the caller's buffer
+    dma_channel_config c = dma_channel_get_default_config(p_dma->dma_rx);
+    channel_config_set_transfer_data_size(&c, DMA_SIZE_8);
+    channel_config_set_read_increment(&c, false);
+    channel_config_set_write_increment(&c, true);
+    channel_config_set_dreq(&c, i2c_get_dreq(p_platform->i2c_instance, false));
+    dma_channel_configure(p_dma->dma_rx, &c, p_xfer->p_data, &hw->data_cmd, p_xfer->size, true);
+    
+    // First read command restarts the bus in read direction
+    hw->data_cmd = I2C_IC_DATA_CMD_CMD_BITS | I2C_IC_DATA_CMD_RESTART_BITS
+            | ((p_xfer->size == 1) ? I2C_IC_DATA_CMD_STOP_BITS : 0);
+    
+    if (p_xfer->size == 2) {
+        hw->data_cmd = I2C_IC_DATA_CMD_CMD_BITS | I2C_IC_DATA_CMD_STOP_BITS;
+    } else if (p_xfer->size > 2) {
+        // TX channel repeats the read command, the final one is queued by poll
+        p_dma->read_cmd = I2C_IC_DATA_CMD_CMD_BITS;
+        p_dma->last_cmd_pending = 1;
+        c = dma_channel_get_default_config(p_dma->dma_tx);
+        channel_config_set_transfer_data_size(&c, DMA_SIZE_16);
+        channel_config_set_read_increment(&c, false);
+        channel_config_set_write_increment(&c, false);
+        channel_config_set_dreq(&c, i2c_get_dreq(p_platform->i2c_instance, true));
+        dma_channel_configure(p_dma->dma_tx, &c, &hw->data_cmd, &p_dma->read_cmd,
+                p_xfer->size - 2, true);
+    }
+    
+    return 0;
+}
+
+/**
+ * @brief Async bus operation: stop both DMA channels
+ * @param p_ctx: Pointer to platform structure
+ * @param p_xfer: Current transfer
+ */
+static void _vl53l7cx_dma_abort(
+        void *p_ctx,
+        VL53L7CX_AsyncXfer *p_xfer)
+{
+    VL53L7CX_Platform *p_platform = (VL53L7CX_Platform *)p_ctx;
+    i2c_hw_t *hw = i2c_get_hw(p_platform->i2c_instance);
+    
+    (void)p_xfer;
+    dma_channel_abort(p_platform->dma.dma_tx);
+    dma_channel_abort(p_platform->dma.dma_rx);
+    hw->dma_cr = 0;
+    
+    // Disabling the block flushes the FIFOs. It takes effect once the bus is
+    // idle, re-enabling before that would keep the aborted transfer going
+    hw->enable = 0;
+    while (hw->enable_status & I2C_IC_ENABLE_STATUS_IC_EN_BITS) {
+        tight_loop_contents();
+    }
+    hw->enable = 1;
+}
+
+/**
+ * @brief Async bus operation: advance the current transfer
+ * @param p_ctx: Pointer to platform structure
+ * @param p_xfer: Current transfer
+ * @return VL53L7CX_ASYNC_BUSY, VL53L7CX_ASYNC_DONE or VL53L7CX_ASYNC_ERROR
+ */
+static uint8_t _vl53l7cx_dma_poll(
+        void *p_ctx,
+        VL53L7CX_AsyncXfer *p_xfer)
+{
+    VL53L7CX_Platform *p_platform = (VL53L7CX_Platform *)p_ctx;
+    VL53L7CX_PicoDma *p_dma = &p_platform->dma;
+    i2c_hw_t *hw = i2c_get_hw(p_platform->i2c_instance);
+    
+    if (hw->raw_intr_stat & I2C_IC_RAW_INTR_STAT_TX_ABRT_BITS) {
+        _vl53l7cx_dma_abort(p_ctx, p_xfer);
+        (void)hw->clr_tx_abrt;
+        return VL53L7CX_ASYNC_ERROR; // NACK or arbitration lost
+    }
+    
+    if (dma_channel_is_busy(p_dma->dma_tx)) {
+        return VL53L7CX_ASYNC_BUSY;
+    }
+    
+    if (p_xfer->direction == VL53L7CX_ASYNC_WRITE) {
+        if (p_dma->tx_queued < p_xfer->size) {
+            _vl53l7cx_dma_queue_write(p_platform, p_xfer);
+            return VL53L7CX_ASYNC_BUSY;
+        }
+    } else {
+        if (p_dma->last_cmd_pending) {
+            hw->data_cmd = I2C_IC_DATA_CMD_CMD_BITS | I2C_IC_DATA_CMD_STOP_BITS;
+            p_dma->last_cmd_pending = 0;
+        }
+        if (dma_channel_is_busy(p_dma->dma_rx)) {
+            return VL53L7CX_ASYNC_BUSY;
+        }
+    }
+    
+    if ((hw->raw_intr_stat & I2C_IC_RAW_INTR_STAT_STOP_DET_BITS) == 0) {
+        return VL53L7CX_ASYNC_BUSY;
+    }
+    
+    (void)hw->clr_stop_det;
+    hw->dma_cr = 0;
+    return VL53L7CX_ASYNC_DONE;
+}
+
+/**
+ * @brief Async bus operation: current time
+ * @param p_ctx: Pointer to platform structure
+ * @return Time since boot in microseconds
+ */
+static uint64_t _vl53l7cx_dma_time_us(
+        void *p_ctx)
+{
+    (void)p_ctx;
+    return time_us_64();
+}
+
+/**
+ * @brief Async bus operation: called while waiting for a transfer
+ * @param p_ctx: Pointer to platform structure
+ */
+static void _vl53l7cx_dma_idle(
+        void *p_ctx)
+{
+    (void)p_ctx;
+    tight_loop_contents();
+}
+
+static const VL53L7CX_AsyncBusOps vl53l7cx_dma_ops = {
+    _vl53l7cx_dma_start,
+    _vl53l7cx_dma_poll,
+    _vl53l7cx_dma_abort,
+    _vl53l7cx_dma_time_us,
+    _vl53l7cx_dma_idle
+};
+
+/**
+ * @brief Set up asynchronous transfers (claims two DMA channels). Must be
+ * called once, after the I2C fields of the platform structure are filled.
+ * @param p_platform: Pointer to platform structure
+ * @return 0 if OK, non-zero if error
+ */
+uint8_t VL53L7CX_AsyncInit(
+        VL53L7CX_Platform *p_platform)
+{
+    if (!p_platform) {
+        return 255; // Error: invalid parameters
+    }
+    
+    p_platform->dma.dma_tx = dma_claim_unused_channel(false);
+    p_platform->dma.dma_rx = dma_claim_unused_channel(false);
+    if (p_platform->dma.dma_tx < 0 || p_platform->dma.dma_rx < 0) {
+        if (p_platform->dma.dma_tx >= 0) {
+            dma_channel_unclaim(p_platform->dma.dma_tx);
+        }
+        if (p_platform->dma.dma_rx >= 0) {
+            dma_channel_unclaim(p_platform->dma.dma_rx);
+        }
+        return 255; // Error: no free DMA channel
+    }
+    
+    p_platform->async_xfer.state = VL53L7CX_ASYNC_IDLE;
+    vl53l7cx_async_init(&p_platform->async, &vl53l7cx_dma_ops, p_platform);
+    
+    return 0;
+}
+
+/**
+ * @brief Submit a transfer on the platform async engine
+ * @param p_platform: Pointer to platform structure
+ * @param direction: VL53L7CX_ASYNC_READ or VL53L7CX_ASYNC_WRITE
+ * @param RegisterAdress: Register address
+ * @param p_values: Data buffer, must stay valid until completion
+ * @param size: Number of bytes
+ * @param callback: Optional completion callback
+ * @param p_user: Passed back to the callback
+ * @return 0 if OK, non-zero if error
+ */
+static uint8_t _vl53l7cx_submit_async(
+        VL53L7CX_Platform *p_platform,
+        uint8_t direction,
+        uint16_t RegisterAdress,
+        uint8_t *p_values,
+        uint32_t size,
+        VL53L7CX_AsyncCallback callback,
+        void *p_user)
+{
+    VL53L7CX_AsyncXfer *p_xfer;
+    
+    if (!p_platform) {
+        return 255; // Error: invalid parameters
+    }
+    
+    // The transfer in flight uses async_xfer: leave it untouched
+    if (vl53l7cx_async_is_busy(&p_platform->async)) {
+        return 255; // Error: a transfer is already in flight
+    }
+    
+    p_xfer = &p_platform->async_xfer;
+    p_xfer->direction = direction;
+    p_xfer->register_address = RegisterAdress;
+    p_xfer->p_data = p_values;
+    p_xfer->size = size;
+    p_xfer->callback = callback;
+    p_xfer->p_user = p_user;
+    
+    return vl53l7cx_async_submit(&p_platform->async, p_xfer);
+}
+
+/**
+ * @brief Start reading multiple bytes from VL53L7CX sensor in the background
+ * @param p_platform: Pointer to platform structure
+ * @param RegisterAdress: Register address to read from
+ * @param p_values: Pointer to store the read values
+ * @param size: Number of bytes to read
+ * @param callback: Optional completion callback
+ * @param p_user: Passed back to the callback
+ * @return 0 if the transfer started, non-zero if error
+ */
+uint8_t VL53L7CX_RdMultiAsync(
+        VL53L7CX_Platform *p_platform,
+        uint16_t RegisterAdress,
+        uint8_t *p_values,
+        uint32_t size,
+        VL53L7CX_AsyncCallback callback,
+        void *p_user)
+{
+    return _vl53l7cx_submit_async(p_platform, VL53L7CX_ASYNC_READ,
+            RegisterAdress, p_values, size, callback, p_user);
+}
+
+/**
+ * @brief Start writing multiple bytes to VL53L7CX sensor in the background
+ * @param p_platform: Pointer to platform structure
+ * @param RegisterAdress: Register address to write to
+ * @param p_values: Pointer to data to write
+ * @param size: Number of bytes to write
+ * @param callback: Optional completion callback
+ * @param p_user: Passed back to the callback
+ * @return 0 if the transfer started, non-zero if error
+ */
+uint8_t VL53L7CX_WrMultiAsync(
+        VL53L7CX_Platform *p_platform,
+        uint16_t RegisterAdress,
+        uint8_t *p_values,
+        uint32_t size,
+        VL53L7CX_AsyncCallback callback,
+        void *p_user)
+{
+    return _vl53l7cx_submit_async(p_platform, VL53L7CX_ASYNC_WRITE,
+            RegisterAdress, p_values, size, callback, p_user);
+}
+
+/**
+ * @brief Advance the background transfer (runs the callback on completion)
+ * @param p_platform: Pointer to platform structure
+ * @return Transfer state (VL53L7CX_ASYNC_IDLE if nothing is running)
+ */
+uint8_t VL53L7CX_PollAsync(
+        VL53L7CX_Platform *p_platform)
+{
+    return vl53l7cx_async_poll(&p_platform->async);
+}
+
+/**
+ * @brief Wait for the background transfer to complete
+ * @param p_platform: Pointer to platform structure
+ * @param TimeMs: Timeout in milliseconds
+ * @return 0 if OK, non-zero if the transfer failed or timed out
+ */
+uint8_t VL53L7CX_WaitAsync(
+        VL53L7CX_Platform *p_platform,
+        uint32_t TimeMs)
+{
+    return vl53l7cx_async_wait(&p_platform->async, TimeMs * 1000U);
+}
+
+/* INT pin to event source bindings, used by the shared GPIO interrupt */
+static struct
+{
+    uint8_t            int_pin;
+    VL53L7CX_EventSource *p_source;
+} vl53l7cx_gpio_sources[VL53L7CX_MAX_GPIO_SOURCES];
+static uint8_t vl53l7cx_nb_gpio_sources = 0;
+
+/**
+ * @brief GPIO interrupt handler: INT falling edge means a new frame is ready
+ * @param gpio: GPIO number that triggered the interrupt
+ * @param events: GPIO event mask
+ */
+static void _vl53l7cx_gpio_irq(
+        uint gpio,
+        uint32_t events)
+{
+    uint8_t i;
+    
+    if ((events & GPIO_IRQ_EDGE_FALL) == 0) {
+        return;
+    }
+    
+    for (i = 0; i < vl53l7cx_nb_gpio_sources; i++) {
+        if (vl53l7cx_gpio_sources[i].int_pin == gpio) {
+            (void)vl53l7cx_event_push(&vl53l7cx_gpio_sources[i].p_source->queue,
+                    VL53L7CX_EVENT_DATA_READY, time_us_64());
+        }
+    }
+}
+
+/**
+ * @brief Event source operation: sleep until an interrupt or timeout
+ * @param p_ctx: Unused
+ * @param timeout_us: Maximum time to sleep in microseconds
+ */
+static void _vl53l7cx_gpio_wait(
+        void *p_ctx,
+        uint32_t timeout_us)
+{
+    (void)p_ctx;
+    
+    // Any interrupt (the INT pin one included) wakes the core from WFE
+    (void)best_effort_wfe_or_timeout(make_timeout_time_us(timeout_us));
+}
+
+/**
+ * @brief Event source operation: current time
+ * @param p_ctx: Unused
+ * @return Time since boot in microseconds
+ */
+static uint64_t _vl53l7cx_gpio_time_us(
+        void *p_ctx)
+{
+    (void)p_ctx;
+    return time_us_64();
+}
+
+static const VL53L7CX_EventSourceOps vl53l7cx_gpio_source_ops = {
+    _vl53l7cx_gpio_wait,
+    _vl53l7cx_gpio_time_us
+};
+
+/**
+ * @brief Initialize an event source fed by the sensor INT pin (active low,
+ * open drain). Ranging must be started for the sensor to drive the pin.
+ * @param p_source: Pointer to event source
+ * @param int_pin: GPIO connected to the sensor INT pin
+ * @return 0 if OK, non-zero if error
+ */
+uint8_t VL53L7CX_EventSourceInitGpio(
+        VL53L7CX_EventSource *p_source,
+        uint8_t int_pin)
+{
+    if (!p_source || vl53l7cx_nb_gpio_sources >= VL53L7CX_MAX_GPIO_SOURCES) {
+        return 255; // Error: invalid parameters or too many sources
+    }
+    
+    vl53l7cx_event_source_init(p_source, &vl53l7cx_gpio_source_ops, NULL);
+    vl53l7cx_gpio_sources[vl53l7cx_nb_gpio_sources].int_pin = int_pin;
+    vl53l7cx_gpio_sources[vl53l7cx_nb_gpio_sources].p_source = p_source;
+    vl53l7cx_nb_gpio_sources++;
+    
+    gpio_init(int_pin);
+    gpio_set_dir(int_pin, GPIO_IN);
+    gpio_pull_up(int_pin);
+    gpio_set_irq_enabled_with_callback(int_pin, GPIO_IRQ_EDGE_FALL, true, &_vl53l7cx_gpio_irq);
+    
+    return 0;
+}
+
 /**
  * @brief Reset the VL53L7CX sensor
  * @param p_platform: Pointer to platform structure
@@ -178,15 +670,11 @@ void VL53L7CX_SwapBuffer(
 {
     uint32_t i, tmp;
     
-    /* Example of possible implementation using <string.h> */
+    // Whole 32-bit words, reversed with a single REV instruction each
     for(i = 0; i < size; i = i + 4) 
     {
-        tmp = (
-          buffer[i]<<24)
-        |(buffer[i+1]<<16)
-        |(buffer[i+2]<<8)
-        |(buffer[i+3]);
-        
+        memcpy(&tmp, &(buffer[i]), 4);
+        tmp = __builtin_bswap32(tmp);
         memcpy(&(buffer[i]), &tmp, 4);
     }
 }
@@ -205,3 +693,273 @@ uint8_t VL53L7CX_WaitMs(
     sleep_ms(TimeMs);
     return 0; // Always successful
 }
+
+/**
+ * @brief Wait for specified number of microseconds (driver polling back-off)
+ * @param p_platform: Pointer to platform structure
+ * @param TimeUs: Time to wait in microseconds
+ * @return 0 if OK, non-zero if error
+ */
+uint8_t VL53L7CX_WaitUs(
+        VL53L7CX_Platform *p_platform,
+        uint32_t TimeUs)
+{
+    sleep_us(TimeUs);
+    return 0; // Always successful
+}
+
+/**
+ * @brief Get a free-running time (driver init timing)
+ * @param p_platform: Pointer to platform structure
+ * @return Time in microseconds, wrapping at 2^32
+ */
+uint32_t VL53L7CX_GetTimeUs(
+        VL53L7CX_Platform *p_platform)
+{
+    return (uint32_t)time_us_64();
+}
+
+#define VL53L7CX_RETAINED_ENTRIES       4U
+#define VL53L7CX_RETAINED_MAGIC         0x4C37A55AU
+
+typedef struct
+{
+    uint32_t magic;
+    uint32_t bus;
+    uint32_t address;
+    uint32_t value;
+} VL53L7CX_RetainedEntry;
+
+/* One value per sensor (bus and address), kept across watchdog and software
+ * resets: the section is not cleared by the C runtime. Entries are garbage
+ * after a power-on, hence the magic word. */
+static VL53L7CX_RetainedEntry __uninitialized_ram(vl53l7cx_retained)[VL53L7CX_RETAINED_ENTRIES];
+
+static uint8_t _vl53l7cx_retained_find(VL53L7CX_Platform *p_platform)
+{
+    uint8_t i;
+
+    for (i = 0; i < VL53L7CX_RETAINED_ENTRIES; i++) {
+        if (vl53l7cx_retained[i].magic == VL53L7CX_RETAINED_MAGIC
+                && vl53l7cx_retained[i].bus == (uint32_t)(uintptr_t)p_platform->i2c_instance
+                && vl53l7cx_retained[i].address == p_platform->address) {
+            break;
+        }
+    }
+
+    return i;
+}
+
+/**
+ * @brief Read the value kept for this sensor across host resets
+ * @param p_platform: Pointer to platform structure
+ * @param p_value: Pointer to store the value
+ * @return 0 if OK, non-zero if no value is kept for this sensor
+ */
+uint8_t VL53L7CX_RdRetained(
+        VL53L7CX_Platform *p_platform,
+        uint32_t *p_value)
+{
+    uint8_t i = _vl53l7cx_retained_find(p_platform);
+
+    if (i >= VL53L7CX_RETAINED_ENTRIES || vl53l7cx_retained[i].value == 0) {
+        return 255; // Error: nothing kept
+    }
+
+    *p_value = vl53l7cx_retained[i].value;
+    return 0;
+}
+
+/**
+ * @brief Keep a value for this sensor across host resets (0 drops it)
+ * @param p_platform: Pointer to platform structure
+ * @param value: Value to keep
+ * @return 0 if OK, non-zero if every entry is used by other sensors
+ */
+uint8_t VL53L7CX_WrRetained(
+        VL53L7CX_Platform *p_platform,
+        uint32_t value)
+{
+    uint8_t i = _vl53l7cx_retained_find(p_platform);
+
+    if (i >= VL53L7CX_RETAINED_ENTRIES) {
+        // New sensor: take a free entry
+        for (i = 0; i < VL53L7CX_RETAINED_ENTRIES; i++) {
+            if (vl53l7cx_retained[i].magic != VL53L7CX_RETAINED_MAGIC
+                    || vl53l7cx_retained[i].value == 0) {
+                break;
+            }
+        }
+        if (i >= VL53L7CX_RETAINED_ENTRIES) {
+            return 255; // Error: no free entry
+        }
+        vl53l7cx_retained[i].bus = (uint32_t)(uintptr_t)p_platform->i2c_instance;
+        vl53l7cx_retained[i].address = p_platform->address;
+        vl53l7cx_retained[i].magic = VL53L7CX_RETAINED_MAGIC;
+    }
+
+    vl53l7cx_retained[i].value = value;
+    return 0;
+}
+
+/* LPn pins of the sensors handled by the Pico manager operations */
+static uint8_t vl53l7cx_lpn_pins[VL53L7CX_MANAGER_MAX_SENSORS];
+
+static void _manager_set_lpn(void *p_ctx, uint8_t sensor, uint8_t level)
+{
+    gpio_put(vl53l7cx_lpn_pins[sensor], level);
+}
+
+static void _manager_wait_ms(void *p_ctx, uint32_t time_ms)
+{
+    sleep_ms(time_ms);
+}
+
+static uint64_t _manager_time_us(void *p_ctx)
+{
+    return time_us_64();
+}
+
+/* Data-ready is polled over I2C (data_ready operation left NULL) */
+static const VL53L7CX_ManagerOps vl53l7cx_manager_ops = {
+    .set_lpn = _manager_set_lpn,
+    .wait_ms = _manager_wait_ms,
+    .time_us = _manager_time_us,
+    .data_ready = NULL,
+};
+
+/**
+ * @brief Initialize a multi-sensor manager driving the sensors LPn pins
+ * @param p_mgr: Pointer to manager
+ * @param p_lpn_pins: GPIO connected to the LPn pin of each sensor, in the
+ * order sensors will be added
+ * @param nb_pins: Number of pins
+ * @return 0 if OK, non-zero if error
+ */
+uint8_t VL53L7CX_ManagerInitPico(
+        VL53L7CX_Manager *p_mgr,
+        const uint8_t *p_lpn_pins,
+        uint8_t nb_pins)
+{
+    uint8_t i;
+
+    if (!p_lpn_pins || nb_pins > VL53L7CX_MANAGER_MAX_SENSORS) {
+        return 255; // Error: invalid parameters
+    }
+
+    for (i = 0; i < nb_pins; i++) {
+        vl53l7cx_lpn_pins[i] = p_lpn_pins[i];
+        gpio_init(p_lpn_pins[i]);
+        gpio_set_dir(p_lpn_pins[i], GPIO_OUT);
+        gpio_put(p_lpn_pins[i], 0);     // Sensor I2C disabled until boot
+    }
+
+    return vl53l7cx_manager_init(p_mgr, &vl53l7cx_manager_ops, NULL);
+}
+
+/* Calibration slots: one flash sector each, at the end of the flash */
+#define VL53L7CX_CALSTORE_FLASH_OFFSET(slot) \
+    (PICO_FLASH_SIZE_BYTES - ((uint32_t)(slot) + 1U) * FLASH_SECTOR_SIZE)
+
+typedef struct
+{
+    uint32_t offset;
+    const uint8_t *p_data;
+    uint32_t size;
+} VL53L7CX_CalStoreFlashWrite;
+
+static void _calstore_flash_write(void *p_param)
+{
+    VL53L7CX_CalStoreFlashWrite *p_write = (VL53L7CX_CalStoreFlashWrite *)p_param;
+    uint8_t page[FLASH_PAGE_SIZE];
+    uint32_t done, chunk;
+
+    flash_range_erase(p_write->offset, FLASH_SECTOR_SIZE);
+
+    // Program page by page, the last one padded as erased flash
+    for (done = 0; done < p_write->size; done += FLASH_PAGE_SIZE) {
+        chunk = p_write->size - done;
+        if (chunk > FLASH_PAGE_SIZE) {
+            chunk = FLASH_PAGE_SIZE;
+        }
+        memset(page, 0xFF, sizeof(page));
+        memcpy(page, &p_write->p_data[done], chunk);
+        flash_range_program(p_write->offset + done, page, FLASH_PAGE_SIZE);
+    }
+}
+
+static uint8_t _calstore_read(void *p_ctx, uint8_t slot, uint8_t *p_data, uint32_t size)
+{
+    if (size > FLASH_SECTOR_SIZE) {
+        return 255; // Error: record larger than a sector
+    }
+
+    memcpy(p_data, (const uint8_t *)(uintptr_t)(XIP_BASE + VL53L7CX_CALSTORE_FLASH_OFFSET(slot)), size);
+    return 0;
+}
+
+static uint8_t _calstore_write(void *p_ctx, uint8_t slot, const uint8_t *p_data, uint32_t size)
+{
+    VL53L7CX_CalStoreFlashWrite write = {
+        .offset = VL53L7CX_CALSTORE_FLASH_OFFSET(slot),
+        .p_data = p_data,
+        .size = size,
+    };
+
+    if (size > FLASH_SECTOR_SIZE) {
+        return 255; // Error: record larger than a sector
+    }
+
+    // XIP is stopped during erase/program: the other core (if running) is
+    // paused by the SDK, and interrupts are disabled
+    if (flash_safe_execute(_calstore_flash_write, &write, 100) != PICO_OK) {
+        return 255; // Error: other core could not be paused
+    }
+
+    return 0;
+}
+
+static const VL53L7CX_CalStoreOps vl53l7cx_calstore_flash_ops = {
+    .read = _calstore_read,
+    .write = _calstore_write,
+};
+
+/**
+ * @brief Initialize a calibration store in the last flash sectors (slot 0 in
+ * the last sector, slot 1 in the one before, ...). The program image must not
+ * reach these sectors.
+ * @param p_store: Pointer to store
+ * @param nb_slots: Number of slots
+ * @return 0 if OK, non-zero if error
+ */
+uint8_t VL53L7CX_CalStoreInitPico(
+        VL53L7CX_CalStore *p_store,
+        uint8_t nb_slots)
+{
+    return vl53l7cx_calstore_init(p_store, &vl53l7cx_calstore_flash_ops, NULL, nb_slots);
+}
+
+static uint8_t _stream_write(void *p_ctx, const uint8_t *p_data, uint32_t size)
+{
+    // Sent as is: stdio CR/LF translation would corrupt the frame
+    stdio_put_string((const char *)p_data, (int)size, false, false);
+    return 0;
+}
+
+static const VL53L7CX_StreamOps vl53l7cx_stream_stdio_ops = {
+    .write = _stream_write,
+};
+
+/**
+ * @brief Initialize a binary frame stream on stdio (USB CDC). Text printed on
+ * the same stdio between frames is skipped by the decoder.
+ * @param p_stream: Pointer to stream
+ * @param sensor: Sensor index, sent in each packet
+ * @return 0 if OK, non-zero if error
+ */
+uint8_t VL53L7CX_StreamInitPico(
+        VL53L7CX_Stream *p_stream,
+        uint8_t sensor)
+{
+    return vl53l7cx_stream_init(p_stream, &vl53l7cx_stream_stdio_ops, NULL, sensor);
+}
@@ -12,6 +12,29 @@
 #include <string.h>
 #include "pico/stdlib.h"
 #include "hardware/i2c.h"
+#include "vl53l7cx_async.h"
+
+/**
+ * @brief Size (in bytes) of the bounce buffer used by asynchronous writes.
+ * The I2C data register needs 16-bit command words, so payload bytes are
+ * expanded in chunks of this size while the DMA runs.
+ */
+
+#define VL53L7CX_ASYNC_BOUNCE_SIZE      32U
+
+/**
+ * @brief DMA state used by the asynchronous transfers (see VL53L7CX_AsyncInit).
+ */
+
+typedef struct
+{
+    int                dma_tx;         /* DMA channel feeding IC_DATA_CMD */
+    int                dma_rx;         /* DMA channel draining IC_DATA_CMD */
+    uint8_t            last_cmd_pending; /* Read: final STOP command not queued yet */
+    uint32_t           tx_queued;      /* Write: payload bytes handed to the DMA */
+    uint16_t           read_cmd;       /* Constant read command word */
+    uint16_t           bounce[VL53L7CX_ASYNC_BOUNCE_SIZE];
+} VL53L7CX_PicoDma;
 
 /**
  * @brief Structure VL53L7CX_Platform needs to be filled by the customer,
@@ -33,8 +56,23 @@ typedef struct
     uint8_t            sda_pin;        /* SDA pin number */
     uint8_t            scl_pin;        /* SCL pin number */
 
+    /* Asynchronous transfers, set up by VL53L7CX_AsyncInit() */
+    VL53L7CX_AsyncEngine async;        /* Transfer state machine */
+    VL53L7CX_AsyncXfer async_xfer;     /* Transfer used by the *Async functions */
+    VL53L7CX_PicoDma   dma;            /* DMA backend state */
+
 } VL53L7CX_Platform;
 
+/**
+ * @brief One contiguous piece of an I2C write built with VL53L7CX_WrGather().
+ */
+
+typedef struct
+{
+    const uint8_t      *data;           /* Bytes to send (RAM or flash) */
+    uint32_t           size;            /* Number of bytes */
+} VL53L7CX_WrSegment;
+
 /*
  * @brief The macro below is used to define the number of target per zone sent
  * through I2C. This value can be changed by user, in order to tune I2C
@@ -53,6 +91,48 @@ typedef struct
 
 #define 	VL53L7CX_USE_RAW_FORMAT
 
+/*
+ * @brief The macro below enables a shadow copy of the DCI blocks read or
+ * written by the driver. vl53l7cx_dci_replace_data() then patches the copy
+ * instead of reading the block back from the sensor. It costs about 350 bytes
+ * of RAM per sensor. Comment it out to always read blocks from the sensor.
+ */
+
+#define 	VL53L7CX_USE_DCI_CACHE
+
+/*
+ * @brief The macro below makes the temporary buffer of each sensor a pointer to
+ * a VL53L7CX_TempArena, attached with vl53l7cx_set_temp_arena(). The pointer
+ * is permanent: every API call of the sensor uses the arena, and an
+ * asynchronous frame read holds it from vl53l7cx_start_ranging_data_read() to
+ * vl53l7cx_finish_ranging_data_read(). Sensors sharing one arena must never be
+ * serviced at the same time (same I2C bus, same core, no frame read of one
+ * pending while another is used). Each additional sensor saves
+ * VL53L7CX_TEMPORARY_BUFFER_SIZE bytes of RAM.
+ */
+
+// #define 	VL53L7CX_SHARED_TEMP_BUFFER
+
+/*
+ * @brief The macro below removes the offset and Xtalk buffers from the
+ * configuration structure (about 1.2 KB per sensor). Offsets are read again
+ * from the sensor NVM each time they are sent (init, resolution change), and
+ * Xtalk data is used in place from the default buffer or from the table given
+ * to vl53l7cx_set_caldata_xtalk(), which can be const data in flash. Xtalk
+ * calibration is then not available.
+ */
+
+// #define 	VL53L7CX_CONST_CALIBRATION
+
+/*
+ * @brief The macro below stores the firmware compressed (see
+ * tools/fw_compress.py, run by the build), and decodes it while it is
+ * downloaded, in the temporary buffer. It saves about 5.5 KB of flash. Comment
+ * it out to store the firmware as is.
+ */
+
+#define 	VL53L7CX_COMPRESSED_FIRMWARE
+
 /*
  * @brief All macro below are used to configure the sensor output. User can
  * define some macros if he wants to disable selected output, in order to reduce
@@ -75,9 +155,19 @@ typedef struct
 uint8_t VL53L7CX_RdByte(VL53L7CX_Platform *p_platform, uint16_t RegisterAdress, uint8_t *p_value);
 uint8_t VL53L7CX_WrByte(VL53L7CX_Platform *p_platform, uint16_t RegisterAdress, uint8_t value);
 uint8_t VL53L7CX_WrMulti(VL53L7CX_Platform *p_platform, uint16_t RegisterAdress, uint8_t *p_values, uint32_t size);
+uint8_t VL53L7CX_WrGather(VL53L7CX_Platform *p_platform, const VL53L7CX_WrSegment *p_segments, uint8_t nb_segments);
 uint8_t VL53L7CX_RdMulti(VL53L7CX_Platform *p_platform, uint16_t RegisterAdress, uint8_t *p_values, uint32_t size);
+uint8_t VL53L7CX_AsyncInit(VL53L7CX_Platform *p_platform);
+uint8_t VL53L7CX_RdMultiAsync(VL53L7CX_Platform *p_platform, uint16_t RegisterAdress, uint8_t *p_values, uint32_t size, VL53L7CX_AsyncCallback callback, void *p_user);
+uint8_t VL53L7CX_WrMultiAsync(VL53L7CX_Platform *p_platform, uint16_t RegisterAdress, uint8_t *p_values, uint32_t size, VL53L7CX_AsyncCallback callback, void *p_user);
+uint8_t VL53L7CX_PollAsync(VL53L7CX_Platform *p_platform);
+uint8_t VL53L7CX_WaitAsync(VL53L7CX_Platform *p_platform, uint32_t TimeMs);
 uint8_t VL53L7CX_Reset_Sensor(VL53L7CX_Platform *p_platform);
 void VL53L7CX_SwapBuffer(uint8_t *buffer, uint16_t size);
 uint8_t VL53L7CX_WaitMs(VL53L7CX_Platform *p_platform, uint32_t TimeMs);
+uint8_t VL53L7CX_WaitUs(VL53L7CX_Platform *p_platform, uint32_t TimeUs);
+uint32_t VL53L7CX_GetTimeUs(VL53L7CX_Platform *p_platform);
+uint8_t VL53L7CX_RdRetained(VL53L7CX_Platform *p_platform, uint32_t *p_value);
+uint8_t VL53L7CX_WrRetained(VL53L7CX_Platform *p_platform, uint32_t value);
 
 #endif /* _PLATFORM_PICO_H_ */
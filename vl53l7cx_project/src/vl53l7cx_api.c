@@ -14,6 +14,16 @@
 #include <string.h>
 #include "vl53l7cx_api.h"
 #include "vl53l7cx_buffers.h"
+#ifdef VL53L7CX_COMPRESSED_FIRMWARE
+#include "vl53l7cx_firmware_lz.h"
+
+/* The window is kept in temp_buffer (1024 bytes at least), and must divide the
+ * 0x8000 bytes pages */
+#if ((VL53L7CX_FIRMWARE_LZ_WINDOW & (VL53L7CX_FIRMWARE_LZ_WINDOW - 1U)) != 0U) \
+	|| (VL53L7CX_FIRMWARE_LZ_WINDOW > 1024U)
+#error "VL53L7CX_FIRMWARE_LZ_WINDOW must be a power of 2, up to 1024"
+#endif
+#endif
 
 /**
  * @brief Inner function, not available outside this file. This function is used
@@ -29,29 +39,62 @@ static uint8_t _vl53l7cx_poll_for_answer(
 		uint8_t					expected_value)
 {
 	uint8_t status = VL53L7CX_STATUS_OK;
-	uint8_t timeout = 0;
+	const VL53L7CX_PollPolicy *p_policy = &(p_dev->poll_policy);
+	VL53L7CX_PollStats *p_stats = &(p_dev->poll_stats);
+	uint32_t nb_polls = 0, wait_us = 0, waited_us = 0;
 
 	do {
+		/* Immediate retries first, then exponential back-off */
+		if(nb_polls > (uint32_t)p_policy->nb_immediate_retries)
+		{
+			if(waited_us >= p_policy->timeout_us)
+			{
+				status |= (uint8_t)VL53L7CX_STATUS_TIMEOUT_ERROR;
+				break;
+			}
+
+			if(wait_us == (uint32_t)0)
+			{
+				wait_us = p_policy->initial_wait_us;
+			}
+			else if(wait_us < (p_policy->max_wait_us / (uint32_t)2))
+			{
+				wait_us *= (uint32_t)2;
+			}
+			else
+			{
+				wait_us = p_policy->max_wait_us;
+			}
+			status |= VL53L7CX_WaitUs(&(p_dev->platform), wait_us);
+			waited_us += wait_us;
+		}
+
 		status |= VL53L7CX_RdMulti(&(p_dev->platform), address,
 				p_dev->temp_buffer, size);
-		status |= VL53L7CX_WaitMs(&(p_dev->platform), 10);
+		nb_polls++;
 
-		if(timeout >= (uint8_t)200)	/* 2s timeout */
-		{
-			status |= (uint8_t)VL53L7CX_STATUS_TIMEOUT_ERROR;
-			break;
-		}else if((size >= (uint8_t)4) 
+		if((size >= (uint8_t)4) 
                          && (p_dev->temp_buffer[2] >= (uint8_t)0x7f))
 		{
 			status |= VL53L7CX_MCU_ERROR;
 			break;
 		}
-		else
-		{
-			timeout++;
-		}
 	}while ((p_dev->temp_buffer[pos] & mask) != expected_value);
 
+	p_stats->last_nb_polls = nb_polls;
+	p_stats->last_wait_us = waited_us;
+	p_stats->nb_calls++;
+	p_stats->total_nb_polls += nb_polls;
+	p_stats->total_wait_us += waited_us;
+	if(nb_polls > p_stats->max_nb_polls)
+	{
+		p_stats->max_nb_polls = nb_polls;
+	}
+	if(waited_us > p_stats->max_wait_us)
+	{
+		p_stats->max_wait_us = waited_us;
+	}
+
 	return status;
 }
 
@@ -84,6 +127,143 @@ static uint8_t _vl53l7cx_poll_for_mcu_boot(
    return status;
 }
 
+#ifdef VL53L7CX_USE_DCI_CACHE
+
+/**
+ * @brief Inner function, not available outside this file. This function is used
+ * to find a cached DCI block. It returns the entry number, or
+ * VL53L7CX_DCI_CACHE_ENTRIES if the block is not cached.
+ */
+
+static uint8_t _vl53l7cx_dci_cache_find(
+		VL53L7CX_Configuration		*p_dev,
+		uint32_t			index)
+{
+	uint8_t i;
+
+	for(i = 0; i < VL53L7CX_DCI_CACHE_ENTRIES; i++)
+	{
+		if((p_dev->dci_cache.size[i] != (uint16_t)0)
+			&& (p_dev->dci_cache.index[i] == (uint16_t)index))
+		{
+			break;
+		}
+	}
+
+	return i;
+}
+
+/**
+ * @brief Inner function, not available outside this file. This function is used
+ * to drop a cached DCI block.
+ */
+
+static void _vl53l7cx_dci_cache_drop(
+		VL53L7CX_Configuration		*p_dev,
+		uint32_t			index)
+{
+	uint8_t i = _vl53l7cx_dci_cache_find(p_dev, index);
+
+	if(i < VL53L7CX_DCI_CACHE_ENTRIES)
+	{
+		p_dev->dci_cache.size[i] = 0;
+	}
+}
+
+/**
+ * @brief Inner function, not available outside this file. This function is used
+ * to store the content of a DCI block (host format) into the cache.
+ */
+
+static void _vl53l7cx_dci_cache_store(
+		VL53L7CX_Configuration		*p_dev,
+		const uint8_t			*data,
+		uint32_t			index,
+		uint16_t			data_size)
+{
+	uint8_t i;
+
+	if(data_size > VL53L7CX_DCI_CACHE_BLOCK_SIZE)
+	{
+		_vl53l7cx_dci_cache_drop(p_dev, index);
+		return;
+	}
+
+	/* Same block, else a free entry, else the oldest one */
+	i = _vl53l7cx_dci_cache_find(p_dev, index);
+	if(i >= VL53L7CX_DCI_CACHE_ENTRIES)
+	{
+		for(i = 0; i < VL53L7CX_DCI_CACHE_ENTRIES; i++)
+		{
+			if(p_dev->dci_cache.size[i] == (uint16_t)0)
+			{
+				break;
+			}
+		}
+	}
+	if(i >= VL53L7CX_DCI_CACHE_ENTRIES)
+	{
+		i = p_dev->dci_cache.next;
+		p_dev->dci_cache.next = (uint8_t)((i + (uint8_t)1)
+			% VL53L7CX_DCI_CACHE_ENTRIES);
+	}
+
+	p_dev->dci_cache.index[i] = (uint16_t)index;
+	p_dev->dci_cache.size[i] = data_size;
+	(void)memcpy(p_dev->dci_cache.data[i], data, data_size);
+}
+
+/**
+ * @brief Inner function, not available outside this file. This function is used
+ * to get a DCI block from the cache. It returns 0 if the block was found.
+ */
+
+static uint8_t _vl53l7cx_dci_cache_load(
+		VL53L7CX_Configuration		*p_dev,
+		uint8_t				*data,
+		uint32_t			index,
+		uint16_t			data_size)
+{
+	uint8_t i, status = VL53L7CX_STATUS_OK;
+
+	i = _vl53l7cx_dci_cache_find(p_dev, index);
+	if((i < VL53L7CX_DCI_CACHE_ENTRIES)
+		&& (p_dev->dci_cache.size[i] == data_size))
+	{
+		(void)memcpy(data, p_dev->dci_cache.data[i], data_size);
+		p_dev->dci_cache.nb_hits++;
+	}
+	else
+	{
+		p_dev->dci_cache.nb_misses++;
+		status = VL53L7CX_STATUS_ERROR;
+	}
+
+	return status;
+}
+
+#endif
+
+/**
+ * @brief Inner function, not available outside this file. This function is used
+ * to read the NVM data (offsets) into the temporary buffer.
+ */
+
+static uint8_t _vl53l7cx_read_nvm_data(
+		VL53L7CX_Configuration		*p_dev)
+{
+	uint8_t status = VL53L7CX_STATUS_OK;
+
+	status |= VL53L7CX_WrMulti(&(p_dev->platform), 0x2fd8,
+		(uint8_t*)VL53L7CX_GET_NVM_CMD, sizeof(VL53L7CX_GET_NVM_CMD));
+	status |= _vl53l7cx_poll_for_answer(p_dev, 4, 0,
+		VL53L7CX_UI_CMD_STATUS, 0xff, 2);
+	status |= VL53L7CX_RdMulti(&(p_dev->platform), VL53L7CX_UI_CMD_START,
+		p_dev->temp_buffer, VL53L7CX_NVM_DATA_SIZE);
+
+	return status;
+}
+
 /**
  * @brief Inner function, not available outside this file. This function is used
  * to set the offset data gathered from NVM.
@@ -101,8 +281,13 @@ static uint8_t _vl53l7cx_send_offset_data(
 	int8_t i, j;
 	uint16_t k;
 
+#ifndef VL53L7CX_CONST_CALIBRATION
 	(void)memcpy(p_dev->temp_buffer,
                p_dev->offset_data, VL53L7CX_OFFSET_BUFFER_SIZE);
+#else
+	/* No copy kept in RAM, offsets are read again from NVM */
+	status |= _vl53l7cx_read_nvm_data(p_dev);
+#endif
 
 	/* Data extrapolation is required for 4X4 offset */
 	if(resolution == (uint8_t)VL53L7CX_RESOLUTION_4X4){
@@ -150,6 +335,7 @@ static uint8_t _vl53l7cx_send_offset_data(
 		VL53L7CX_OFFSET_BUFFER_SIZE);
 	status |=_vl53l7cx_poll_for_answer(p_dev, 4, 1,
 		VL53L7CX_UI_CMD_STATUS, 0xff, 0x03);
+	status |= vl53l7cx_dci_cache_invalidate(p_dev);
 
 	return status;
 }
@@ -210,6 +396,7 @@ static uint8_t _vl53l7cx_send_xtalk_data(
 			p_dev->temp_buffer, VL53L7CX_XTALK_BUFFER_SIZE);
 	status |=_vl53l7cx_poll_for_answer(p_dev, 4, 1,
 			VL53L7CX_UI_CMD_STATUS, 0xff, 0x03);
+	status |= vl53l7cx_dci_cache_invalidate(p_dev);
 
 	return status;
 }
@@ -238,16 +425,224 @@ uint8_t vl53l7cx_is_alive(
 	return status;
 }
 
-uint8_t vl53l7cx_init(
-		VL53L7CX_Configuration		*p_dev)
+#ifdef VL53L7CX_SHARED_TEMP_BUFFER
+uint8_t vl53l7cx_set_temp_arena(
+		VL53L7CX_Configuration		*p_dev,
+		VL53L7CX_TempArena		*p_arena)
 {
-	uint8_t tmp, status = VL53L7CX_STATUS_OK;
-	uint8_t pipe_ctrl[] = {VL53L7CX_NB_TARGET_PER_ZONE, 0x00, 0x01, 0x00};
-	uint32_t single_range = 0x01;
+	uint8_t status = VL53L7CX_STATUS_OK;
+
+	if(p_arena == NULL)
+	{
+		status |= VL53L7CX_STATUS_INVALID_PARAM;
+	}
+	else
+	{
+		p_dev->temp_buffer = p_arena->buffer;
+	}
+
+	return status;
+}
+#endif
+
+/**
+ * @brief Inner function, not available outside this file. This function is used
+ * to set the driver fields to their default value.
+ */
 
+static void _vl53l7cx_init_fields(
+		VL53L7CX_Configuration		*p_dev)
+{
 	p_dev->default_xtalk = (uint8_t*)VL53L7CX_DEFAULT_XTALK;
 	p_dev->default_configuration = (uint8_t*)VL53L7CX_DEFAULT_CONFIGURATION;
 	p_dev->is_auto_stop_enabled = (uint8_t)0x0;
+	p_dev->output_mask = VL53L7CX_OUTPUT_AVAILABLE;
+	/* A policy set by the user is kept */
+	if(p_dev->poll_policy_set != VL53L7CX_POLL_POLICY_SET)
+	{
+		p_dev->poll_policy.nb_immediate_retries =
+			VL53L7CX_POLL_DEFAULT_IMMEDIATE_RETRIES;
+		p_dev->poll_policy.initial_wait_us =
+			VL53L7CX_POLL_DEFAULT_INITIAL_WAIT_US;
+		p_dev->poll_policy.max_wait_us = VL53L7CX_POLL_DEFAULT_MAX_WAIT_US;
+		p_dev->poll_policy.timeout_us = VL53L7CX_POLL_DEFAULT_TIMEOUT_US;
+	}
+	(void)memset(&(p_dev->poll_stats), 0, sizeof(p_dev->poll_stats));
+#ifdef VL53L7CX_USE_DCI_CACHE
+	(void)memset(&(p_dev->dci_cache), 0, sizeof(p_dev->dci_cache));
+#endif
+}
+
+#ifdef VL53L7CX_COMPRESSED_FIRMWARE
+
+/**
+ * @brief Inner function, not available outside this file. This function is used
+ * to write the decoded window to the sensor. The firmware is split into pages
+ * of 0x8000 bytes (0x09, 0x0a, 0x0b), and a window never crosses a page.
+ */
+
+static uint8_t _vl53l7cx_flush_firmware_window(
+		VL53L7CX_Configuration		*p_dev,
+		uint32_t			start,
+		uint32_t			size)
+{
+	uint8_t status = VL53L7CX_STATUS_OK;
+
+	if((start & (uint32_t)0x7FFF) == (uint32_t)0)
+	{
+		status |= VL53L7CX_WrByte(&(p_dev->platform), 0x7fff,
+			(uint8_t)(0x09U + (start >> 15)));
+	}
+	status |= VL53L7CX_WrMulti(&(p_dev->platform),
+		(uint16_t)(start & (uint32_t)0x7FFF), p_dev->temp_buffer, size);
+
+	return status;
+}
+
+/**
+ * @brief Inner function, not available outside this file. This function is used
+ * to read the extra length bytes of a sequence (255 continues), with the end of
+ * the stream checked before each byte.
+ */
+
+static uint8_t _vl53l7cx_read_lz_length(
+		const uint8_t			**pp_in,
+		const uint8_t			*p_end,
+		uint32_t			*p_length)
+{
+	uint8_t extra;
+
+	do {
+		if(*pp_in >= p_end)
+		{
+			return VL53L7CX_STATUS_ERROR;
+		}
+		extra = **pp_in;
+		(*pp_in)++;
+		*p_length += extra;
+	} while(extra == (uint8_t)255);
+
+	return VL53L7CX_STATUS_OK;
+}
+
+/**
+ * @brief Inner function, not available outside this file. This function is used
+ * to download the compressed firmware (LZ4 block format). The temporary buffer
+ * holds the back-reference window, and is written to the sensor each time it
+ * is full. Every input byte is checked against the end of the stream and every
+ * sequence against the firmware size, so a bad stream stops the download.
+ */
+
+static uint8_t _vl53l7cx_download_compressed_firmware(
+		VL53L7CX_Configuration		*p_dev)
+{
+	const uint8_t *p_in = VL53L7CX_FIRMWARE_LZ;
+	const uint8_t *p_end = p_in + sizeof(VL53L7CX_FIRMWARE_LZ);
+	const uint32_t mask = VL53L7CX_FIRMWARE_LZ_WINDOW - (uint32_t)1;
+	uint8_t token, status = VL53L7CX_STATUS_OK;
+	uint32_t length, offset, out = 0;
+
+	while((p_in < p_end) && (status == (uint8_t)0))
+	{
+		token = *p_in++;
+
+		/* Literals */
+		length = (uint32_t)token >> 4;
+		if(length == (uint32_t)15)
+		{
+			status |= _vl53l7cx_read_lz_length(&p_in, p_end, &length);
+		}
+		if((status != (uint8_t)0)
+			|| (length > (uint32_t)(p_end - p_in))
+			|| (length > (VL53L7CX_FIRMWARE_SIZE - out)))
+		{
+			status |= VL53L7CX_STATUS_ERROR;
+			break;
+		}
+		while((length > (uint32_t)0) && (status == (uint8_t)0))
+		{
+			p_dev->temp_buffer[out & mask] = *p_in++;
+			out++;
+			length--;
+			if((out & mask) == (uint32_t)0)
+			{
+				status |= _vl53l7cx_flush_firmware_window(p_dev,
+					out - VL53L7CX_FIRMWARE_LZ_WINDOW,
+					VL53L7CX_FIRMWARE_LZ_WINDOW);
+			}
+		}
+
+		/* Last sequence has no match */
+		if((p_in >= p_end) || (status != (uint8_t)0))
+		{
+			break;
+		}
+
+		/* Match, copied from the window */
+		if((uint32_t)(p_end - p_in) < (uint32_t)2)
+		{
+			status |= VL53L7CX_STATUS_ERROR;
+			break;
+		}
+		offset = (uint32_t)p_in[0] | ((uint32_t)p_in[1] << 8);
+		p_in += 2;
+		if((offset == (uint32_t)0) || (offset > VL53L7CX_FIRMWARE_LZ_WINDOW)
+			|| (offset > out))
+		{
+			status |= VL53L7CX_STATUS_ERROR;
+			break;
+		}
+		length = ((uint32_t)token & (uint32_t)0x0F) + (uint32_t)4;
+		if((token & (uint8_t)0x0F) == (uint8_t)0x0F)
+		{
+			status |= _vl53l7cx_read_lz_length(&p_in, p_end, &length);
+		}
+		if((status != (uint8_t)0)
+			|| (length > (VL53L7CX_FIRMWARE_SIZE - out)))
+		{
+			status |= VL53L7CX_STATUS_ERROR;
+			break;
+		}
+		while((length > (uint32_t)0) && (status == (uint8_t)0))
+		{
+			p_dev->temp_buffer[out & mask] =
+				p_dev->temp_buffer[(out - offset) & mask];
+			out++;
+			length--;
+			if((out & mask) == (uint32_t)0)
+			{
+				status |= _vl53l7cx_flush_firmware_window(p_dev,
+					out - VL53L7CX_FIRMWARE_LZ_WINDOW,
+					VL53L7CX_FIRMWARE_LZ_WINDOW);
+			}
+		}
+	}
+
+	if(((out & mask) != (uint32_t)0) && (status == (uint8_t)0))
+	{
+		status |= _vl53l7cx_flush_firmware_window(p_dev, out & ~mask,
+			out & mask);
+	}
+
+	if(out != VL53L7CX_FIRMWARE_SIZE)
+	{
+		status |= VL53L7CX_STATUS_ERROR;
+	}
+
+	return status;
+}
+
+#endif
+
+/**
+ * @brief Inner function, not available outside this file. This function is used
+ * to reboot the sensor and download the firmware.
+ */
+
+static uint8_t _vl53l7cx_boot_firmware(
+		VL53L7CX_Configuration		*p_dev)
+{
+	uint8_t tmp, status = VL53L7CX_STATUS_OK;
 
 	/* SW reboot sequence */
 	status |= VL53L7CX_WrByte(&(p_dev->platform), 0x7fff, 0x00);
@@ -318,6 +713,7 @@ uint8_t vl53l7cx_init(
 	status |= VL53L7CX_WrByte(&(p_dev->platform), 0x20, 0x06);
 
 	/* Download FW into VL53L7CX */
+#ifndef VL53L7CX_COMPRESSED_FIRMWARE
 	status |= VL53L7CX_WrByte(&(p_dev->platform), 0x7fff, 0x09);
 	status |= VL53L7CX_WrMulti(&(p_dev->platform),0,
 		(uint8_t*)&VL53L7CX_FIRMWARE[0],0x8000);
@@ -327,6 +723,9 @@ uint8_t vl53l7cx_init(
 	status |= VL53L7CX_WrByte(&(p_dev->platform), 0x7fff, 0x0b);
 	status |= VL53L7CX_WrMulti(&(p_dev->platform),0,
 		(uint8_t*)&VL53L7CX_FIRMWARE[0x10000],0x5000);
+#else
+	status |= _vl53l7cx_download_compressed_firmware(p_dev);
+#endif
 	status |= VL53L7CX_WrByte(&(p_dev->platform), 0x7fff, 0x01);
 
 	/* Check if FW correctly downloaded */
@@ -357,22 +756,40 @@ uint8_t vl53l7cx_init(
 		goto exit;
 	}
 
+exit:
+	return status;
+}
+
+/**
+ * @brief Inner function, not available outside this file. This function is used
+ * to load the calibration data and the default configuration into the running
+ * firmware.
+ */
+
+static uint8_t _vl53l7cx_load_configuration(
+		VL53L7CX_Configuration		*p_dev)
+{
+	uint8_t tmp, status = VL53L7CX_STATUS_OK;
+	uint8_t pipe_ctrl[] = {VL53L7CX_NB_TARGET_PER_ZONE, 0x00, 0x01, 0x00};
+	uint32_t single_range = 0x01;
+
 	status |= VL53L7CX_WrByte(&(p_dev->platform), 0x7fff, 0x02);
 
+#ifndef VL53L7CX_CONST_CALIBRATION
 	/* Get offset NVM data and store them into the offset buffer */
-	status |= VL53L7CX_WrMulti(&(p_dev->platform), 0x2fd8,
-		(uint8_t*)VL53L7CX_GET_NVM_CMD, sizeof(VL53L7CX_GET_NVM_CMD));
-	status |= _vl53l7cx_poll_for_answer(p_dev, 4, 0,
-		VL53L7CX_UI_CMD_STATUS, 0xff, 2);
-	status |= VL53L7CX_RdMulti(&(p_dev->platform), VL53L7CX_UI_CMD_START,
-		p_dev->temp_buffer, VL53L7CX_NVM_DATA_SIZE);
+	status |= _vl53l7cx_read_nvm_data(p_dev);
 	(void)memcpy(p_dev->offset_data, p_dev->temp_buffer,
 		VL53L7CX_OFFSET_BUFFER_SIZE);
+#endif
 	status |= _vl53l7cx_send_offset_data(p_dev, VL53L7CX_RESOLUTION_4X4);
 
 	/* Set default Xtalk shape. Send Xtalk to sensor */
+#ifndef VL53L7CX_CONST_CALIBRATION
 	(void)memcpy(p_dev->xtalk_data, (uint8_t*)VL53L7CX_DEFAULT_XTALK,
 		VL53L7CX_XTALK_BUFFER_SIZE);
+#else
+	p_dev->xtalk_data = VL53L7CX_DEFAULT_XTALK;
+#endif
 	status |= _vl53l7cx_send_xtalk_data(p_dev, VL53L7CX_RESOLUTION_4X4);
 
 	/* Send default configuration to VL53L7CX firmware */
@@ -381,6 +798,7 @@ uint8_t vl53l7cx_init(
 		sizeof(VL53L7CX_DEFAULT_CONFIGURATION));
 	status |= _vl53l7cx_poll_for_answer(p_dev, 4, 1,
 		VL53L7CX_UI_CMD_STATUS, 0xff, 0x03);
+	status |= vl53l7cx_dci_cache_invalidate(p_dev);
 
 	status |= vl53l7cx_dci_write_data(p_dev, (uint8_t*)&pipe_ctrl,
 		VL53L7CX_DCI_PIPE_CONTROL, (uint16_t)sizeof(pipe_ctrl));
@@ -400,7 +818,210 @@ uint8_t vl53l7cx_init(
 			VL53L7CX_GLARE_FILTER, 40, (uint8_t*)&tmp, 1, 0x26);
 	status |= vl53l7cx_dci_replace_data(p_dev, p_dev->temp_buffer,
 			VL53L7CX_GLARE_FILTER, 40, (uint8_t*)&tmp, 1, 0x25);
-exit:
+
+	return status;
+}
+
+/**
+ * @brief Inner function, not available outside this file. This function is used
+ * to get the signature of the driver firmware (FNV-1a hash), recorded by the
+ * platform after each successful init.
+ */
+
+static uint32_t _vl53l7cx_firmware_signature(void)
+{
+	static uint32_t signature = 0;
+	uint32_t i, hash;
+#ifndef VL53L7CX_COMPRESSED_FIRMWARE
+	const uint8_t *p_image = VL53L7CX_FIRMWARE;
+	const uint32_t image_size = (uint32_t)sizeof(VL53L7CX_FIRMWARE);
+#else
+	/* The compressed image identifies the firmware as well */
+	const uint8_t *p_image = VL53L7CX_FIRMWARE_LZ;
+	const uint32_t image_size = (uint32_t)sizeof(VL53L7CX_FIRMWARE_LZ);
+#endif
+
+	if(signature == (uint32_t)0)
+	{
+		hash = (uint32_t)0x811C9DC5U;
+		for(i = 0; i < image_size; i++)
+		{
+			hash ^= (uint32_t)p_image[i];
+			hash *= (uint32_t)0x01000193U;
+		}
+
+		/* 0 is reserved for 'no signature' */
+		signature = (hash == (uint32_t)0) ? (uint32_t)1 : hash;
+	}
+
+	return signature;
+}
+
+/**
+ * @brief Inner function, not available outside this file. This function is used
+ * to do a full init: reboot, firmware download and configuration. The
+ * signature is only recorded once the sensor is fully configured.
+ */
+
+static uint8_t _vl53l7cx_cold_init(
+		VL53L7CX_Configuration		*p_dev)
+{
+	uint8_t status = VL53L7CX_STATUS_OK;
+
+	(void)VL53L7CX_WrRetained(&(p_dev->platform), 0);
+	status |= _vl53l7cx_boot_firmware(p_dev);
+	if(status == (uint8_t)0)
+	{
+		status |= _vl53l7cx_load_configuration(p_dev);
+	}
+	if(status == (uint8_t)0)
+	{
+		(void)VL53L7CX_WrRetained(&(p_dev->platform),
+			_vl53l7cx_firmware_signature());
+	}
+
+	return status;
+}
+
+uint8_t vl53l7cx_init(
+		VL53L7CX_Configuration		*p_dev)
+{
+	uint8_t status = VL53L7CX_STATUS_OK;
+	uint32_t start_us = VL53L7CX_GetTimeUs(&(p_dev->platform));
+
+	p_dev->init_report.path = VL53L7CX_INIT_COLD;
+	p_dev->init_report.warm_reject = VL53L7CX_WARM_NOT_REQUESTED;
+
+#ifdef VL53L7CX_SHARED_TEMP_BUFFER
+	if(p_dev->temp_buffer == NULL)
+	{
+		/* vl53l7cx_set_temp_arena() not called */
+		status |= VL53L7CX_STATUS_INVALID_PARAM;
+		goto exit;
+	}
+#endif
+
+	_vl53l7cx_init_fields(p_dev);
+	status |= _vl53l7cx_cold_init(p_dev);
+
+#ifdef VL53L7CX_SHARED_TEMP_BUFFER
+exit:
+#endif
+	p_dev->init_report.duration_us =
+		VL53L7CX_GetTimeUs(&(p_dev->platform)) - start_us;
+	return status;
+}
+
+uint8_t vl53l7cx_init_warm(
+		VL53L7CX_Configuration		*p_dev)
+{
+	uint8_t is_alive = 0, reject, status = VL53L7CX_STATUS_OK;
+	uint8_t pipe_ctrl[] = {VL53L7CX_NB_TARGET_PER_ZONE, 0x00, 0x01, 0x00};
+	uint8_t cleared[] = {0x00, 0x00, 0x00, 0x00};
+	uint8_t probe[4];
+	uint32_t signature = 0;
+	uint32_t start_us = VL53L7CX_GetTimeUs(&(p_dev->platform));
+	VL53L7CX_PollPolicy policy;
+
+	p_dev->init_report.path = VL53L7CX_INIT_COLD;
+	p_dev->init_report.warm_reject = VL53L7CX_WARM_NOT_REQUESTED;
+
+#ifdef VL53L7CX_SHARED_TEMP_BUFFER
+	if(p_dev->temp_buffer == NULL)
+	{
+		/* vl53l7cx_set_temp_arena() not called */
+		status |= VL53L7CX_STATUS_INVALID_PARAM;
+		goto exit;
+	}
+#endif
+
+	_vl53l7cx_init_fields(p_dev);
+
+	status |= vl53l7cx_is_alive(p_dev, &is_alive);
+	if((status != (uint8_t)0) || (is_alive == (uint8_t)0))
+	{
+		reject = VL53L7CX_WARM_NOT_ALIVE;
+	}
+	else if((VL53L7CX_RdRetained(&(p_dev->platform), &signature)
+			!= (uint8_t)0)
+		|| (signature != _vl53l7cx_firmware_signature()))
+	{
+		reject = VL53L7CX_WARM_NO_SIGNATURE;
+	}
+	else
+	{
+		/* A sensor without firmware never answers: probe with a short
+		 * timeout, after clearing the answer status so that a stale
+		 * answer can't be taken for a live one */
+		policy = p_dev->poll_policy;
+		p_dev->poll_policy.timeout_us = VL53L7CX_WARM_PROBE_TIMEOUT_US;
+		status |= vl53l7cx_stop_ranging(p_dev);
+		status |= VL53L7CX_WrMulti(&(p_dev->platform),
+			VL53L7CX_UI_CMD_STATUS, cleared, sizeof(cleared));
+		status |= vl53l7cx_dci_read_data(p_dev, probe,
+			VL53L7CX_DCI_PIPE_CONTROL, (uint16_t)sizeof(probe));
+		p_dev->poll_policy = policy;
+
+		if(status != (uint8_t)0)
+		{
+			reject = VL53L7CX_WARM_NO_ANSWER;
+		}
+		else if(memcmp(probe, pipe_ctrl, sizeof(pipe_ctrl)) != 0)
+		{
+			reject = VL53L7CX_WARM_UNEXPECTED_STATE;
+		}
+		else
+		{
+			status |= _vl53l7cx_load_configuration(p_dev);
+			reject = (status == (uint8_t)0) ? VL53L7CX_WARM_ACCEPTED
+				: VL53L7CX_WARM_RELOAD_FAILED;
+		}
+	}
+
+	p_dev->init_report.warm_reject = reject;
+	if(reject == VL53L7CX_WARM_ACCEPTED)
+	{
+		p_dev->init_report.path = VL53L7CX_INIT_WARM;
+	}
+	else
+	{
+		/* Probe errors only select the path */
+		_vl53l7cx_init_fields(p_dev);
+		status = _vl53l7cx_cold_init(p_dev);
+	}
+
+#ifdef VL53L7CX_SHARED_TEMP_BUFFER
+exit:
+#endif
+	p_dev->init_report.duration_us =
+		VL53L7CX_GetTimeUs(&(p_dev->platform)) - start_us;
+	return status;
+}
+
+uint8_t vl53l7cx_get_init_report(
+		VL53L7CX_Configuration		*p_dev,
+		VL53L7CX_InitReport		*p_report)
+{
+	*p_report = p_dev->init_report;
+
+	return VL53L7CX_STATUS_OK;
+}
+
+uint8_t vl53l7cx_get_caldata_offset(
+		VL53L7CX_Configuration		*p_dev,
+		uint8_t				*p_offset_data)
+{
+	uint8_t status = VL53L7CX_STATUS_OK;
+
+#ifndef VL53L7CX_CONST_CALIBRATION
+	(void)memcpy(p_offset_data, p_dev->offset_data,
+		VL53L7CX_OFFSET_BUFFER_SIZE);
+#else
+	status |= _vl53l7cx_read_nvm_data(p_dev);
+	(void)memcpy(p_offset_data, p_dev->temp_buffer,
+		VL53L7CX_OFFSET_BUFFER_SIZE);
+#endif
+
 	return status;
 }
 
@@ -482,30 +1103,23 @@ uint8_t vl53l7cx_set_power_mode(
 	return status;
 }
 
-uint8_t vl53l7cx_start_ranging(
-		VL53L7CX_Configuration		*p_dev)
-{
-	uint8_t resolution, status = VL53L7CX_STATUS_OK;
-	uint16_t tmp;
-	uint32_t i;
-	uint32_t header_config[2] = {0, 0};
+/**
+ * @brief Inner function, not available outside this file. This function is used
+ * to fill the output list and enables for a resolution and an output mask, and
+ * returns the number of bytes the sensor will send per frame.
+ */
 
+static uint32_t _vl53l7cx_build_output_list(
+		uint8_t				resolution,
+		uint32_t			output_mask,
+		uint32_t			*p_output,
+		uint32_t			*p_output_bh_enable)
+{
+	uint32_t i, data_read_size = 0;
 	union Block_header *bh_ptr;
-	uint8_t cmd[] = {0x00, 0x03, 0x00, 0x00};
-
-	status |= vl53l7cx_get_resolution(p_dev, &resolution);
-	p_dev->data_read_size = 0;
-	p_dev->streamcount = 255;
-
-	/* Enable mandatory output (meta and common data) */
-	uint32_t output_bh_enable[] = {
-		0x00000007U,
-		0x00000000U,
-		0x00000000U,
-		0xC0000000U};
 
 	/* Send addresses of possible output */
-	uint32_t output[] ={VL53L7CX_START_BH,
+	const uint32_t output[VL53L7CX_NB_OUTPUT_BH] ={VL53L7CX_START_BH,
 		VL53L7CX_METADATA_BH,
 		VL53L7CX_COMMONDATA_BH,
 		VL53L7CX_AMBIENT_RATE_BH,
@@ -518,46 +1132,26 @@ uint8_t vl53l7cx_start_ranging(
 		VL53L7CX_TARGET_STATUS_BH,
 		VL53L7CX_MOTION_DETECT_BH};
 
-	/* Enable selected outputs in the 'platform.h' file */
-#ifndef VL53L7CX_DISABLE_AMBIENT_PER_SPAD
-	output_bh_enable[0] += (uint32_t)8;
-#endif
-#ifndef VL53L7CX_DISABLE_NB_SPADS_ENABLED
-	output_bh_enable[0] += (uint32_t)16;
-#endif
-#ifndef VL53L7CX_DISABLE_NB_TARGET_DETECTED
-	output_bh_enable[0] += (uint32_t)32;
-#endif
-#ifndef VL53L7CX_DISABLE_SIGNAL_PER_SPAD
-	output_bh_enable[0] += (uint32_t)64;
-#endif
-#ifndef VL53L7CX_DISABLE_RANGE_SIGMA_MM
-	output_bh_enable[0] += (uint32_t)128;
-#endif
-#ifndef VL53L7CX_DISABLE_DISTANCE_MM
-	output_bh_enable[0] += (uint32_t)256;
-#endif
-#ifndef VL53L7CX_DISABLE_REFLECTANCE_PERCENT
-	output_bh_enable[0] += (uint32_t)512;
-#endif
-#ifndef VL53L7CX_DISABLE_TARGET_STATUS
-	output_bh_enable[0] += (uint32_t)1024;
-#endif
-#ifndef VL53L7CX_DISABLE_MOTION_INDICATOR
-	output_bh_enable[0] += (uint32_t)2048;
-#endif
+	(void)memcpy(p_output, output, sizeof(output));
+
+	/* Mandatory output (meta and common data) and selected outputs */
+	p_output_bh_enable[0] = VL53L7CX_OUTPUT_MANDATORY
+		| (output_mask & VL53L7CX_OUTPUT_AVAILABLE);
+	p_output_bh_enable[1] = 0x00000000U;
+	p_output_bh_enable[2] = 0x00000000U;
+	p_output_bh_enable[3] = 0xC0000000U;
 
 	/* Update data size */
-	for (i = 0; i < (uint32_t)(sizeof(output)/sizeof(uint32_t)); i++)
+	for (i = 0; i < (uint32_t)VL53L7CX_NB_OUTPUT_BH; i++)
 	{
-		if ((output[i] == (uint8_t)0) 
-                    || ((output_bh_enable[i/(uint32_t)32]
+		if ((p_output[i] == (uint8_t)0) 
+                    || ((p_output_bh_enable[i/(uint32_t)32]
                          &((uint32_t)1 << (i%(uint32_t)32))) == (uint32_t)0))
 		{
 			continue;
 		}
 
-		bh_ptr = (union Block_header *)&(output[i]);
+		bh_ptr = (union Block_header *)&(p_output[i]);
 		if (((uint8_t)bh_ptr->type >= (uint8_t)0x1) 
                     && ((uint8_t)bh_ptr->type < (uint8_t)0x0d))
 		{
@@ -571,22 +1165,40 @@ uint8_t vl53l7cx_start_ranging(
 				bh_ptr->size = (uint16_t)((uint16_t)resolution
                                   * (uint16_t)VL53L7CX_NB_TARGET_PER_ZONE);
 			}
-			p_dev->data_read_size += bh_ptr->type * bh_ptr->size;
+			data_read_size += bh_ptr->type * bh_ptr->size;
 		}
 		else
 		{
-			p_dev->data_read_size += bh_ptr->size;
+			data_read_size += bh_ptr->size;
 		}
-		p_dev->data_read_size += (uint32_t)4;
+		data_read_size += (uint32_t)4;
 	}
-	p_dev->data_read_size += (uint32_t)24;
+	data_read_size += (uint32_t)24;
+
+	return data_read_size;
+}
+
+uint8_t vl53l7cx_start_ranging(
+		VL53L7CX_Configuration		*p_dev)
+{
+	uint8_t resolution, status = VL53L7CX_STATUS_OK;
+	uint16_t tmp;
+	uint32_t header_config[2] = {0, 0};
+	uint32_t output_bh_enable[4];
+	uint32_t output[VL53L7CX_NB_OUTPUT_BH];
+	uint8_t cmd[] = {0x00, 0x03, 0x00, 0x00};
+
+	status |= vl53l7cx_get_resolution(p_dev, &resolution);
+	p_dev->streamcount = 255;
+	p_dev->data_read_size = _vl53l7cx_build_output_list(resolution,
+			p_dev->output_mask, output, output_bh_enable);
 
 	status |= vl53l7cx_dci_write_data(p_dev,
 			(uint8_t*)&(output), VL53L7CX_DCI_OUTPUT_LIST,
 			(uint16_t)sizeof(output));
 
 	header_config[0] = p_dev->data_read_size;
-	header_config[1] = i + (uint32_t)1;
+	header_config[1] = (uint32_t)VL53L7CX_NB_OUTPUT_BH + (uint32_t)1;
 
 	status |= vl53l7cx_dci_write_data(p_dev,
 			(uint8_t*)&(header_config), VL53L7CX_DCI_OUTPUT_CONFIG,
@@ -673,6 +1285,96 @@ uint8_t vl53l7cx_stop_ranging(
 	return status;
 }
 
+uint8_t vl53l7cx_set_output_mask(
+		VL53L7CX_Configuration		*p_dev,
+		uint32_t			output_mask)
+{
+	uint8_t status = VL53L7CX_STATUS_OK;
+
+	if((output_mask & ~(VL53L7CX_OUTPUT_AVAILABLE
+		| VL53L7CX_OUTPUT_MANDATORY)) != (uint32_t)0)
+	{
+		status |= VL53L7CX_STATUS_INVALID_PARAM;
+	}
+	else
+	{
+		p_dev->output_mask = output_mask & VL53L7CX_OUTPUT_AVAILABLE;
+	}
+
+	return status;
+}
+
+uint8_t vl53l7cx_get_output_mask(
+		VL53L7CX_Configuration		*p_dev,
+		uint32_t			*p_output_mask)
+{
+	*p_output_mask = p_dev->output_mask;
+
+	return VL53L7CX_STATUS_OK;
+}
+
+uint8_t vl53l7cx_get_frame_size(
+		VL53L7CX_Configuration		*p_dev,
+		uint32_t			*p_frame_size)
+{
+	uint8_t resolution, status = VL53L7CX_STATUS_OK;
+	uint32_t output_bh_enable[4];
+	uint32_t output[VL53L7CX_NB_OUTPUT_BH];
+
+	status |= vl53l7cx_get_resolution(p_dev, &resolution);
+	*p_frame_size = _vl53l7cx_build_output_list(resolution,
+			p_dev->output_mask, output, output_bh_enable);
+
+	return status;
+}
+
+uint8_t vl53l7cx_set_poll_policy(
+		VL53L7CX_Configuration		*p_dev,
+		const VL53L7CX_PollPolicy	*p_policy)
+{
+	uint8_t status = VL53L7CX_STATUS_OK;
+
+	if((p_policy->initial_wait_us == (uint32_t)0)
+		|| (p_policy->max_wait_us < p_policy->initial_wait_us)
+		|| (p_policy->timeout_us == (uint32_t)0))
+	{
+		status |= VL53L7CX_STATUS_INVALID_PARAM;
+	}
+	else
+	{
+		p_dev->poll_policy = *p_policy;
+		p_dev->poll_policy_set = VL53L7CX_POLL_POLICY_SET;
+	}
+
+	return status;
+}
+
+uint8_t vl53l7cx_get_poll_policy(
+		VL53L7CX_Configuration		*p_dev,
+		VL53L7CX_PollPolicy		*p_policy)
+{
+	*p_policy = p_dev->poll_policy;
+
+	return VL53L7CX_STATUS_OK;
+}
+
+uint8_t vl53l7cx_get_poll_stats(
+		VL53L7CX_Configuration		*p_dev,
+		VL53L7CX_PollStats		*p_stats)
+{
+	*p_stats = p_dev->poll_stats;
+
+	return VL53L7CX_STATUS_OK;
+}
+
+uint8_t vl53l7cx_reset_poll_stats(
+		VL53L7CX_Configuration		*p_dev)
+{
+	(void)memset(&(p_dev->poll_stats), 0, sizeof(p_dev->poll_stats));
+
+	return VL53L7CX_STATUS_OK;
+}
+
 uint8_t vl53l7cx_check_data_ready(
 		VL53L7CX_Configuration		*p_dev,
 		uint8_t				*p_isReady)
@@ -704,107 +1406,178 @@ uint8_t vl53l7cx_check_data_ready(
 	return status;
 }
 
-uint8_t vl53l7cx_get_ranging_data(
+/**
+ * @brief Inner function, not available outside this file. This function is used
+ * to copy firmware data (big endian 32 bits words) into a user field, swapping
+ * each word on the fly. Words are swapped two at a time (one 64 bits swap,
+ * then the two halves exchanged).
+ */
+
+static void _vl53l7cx_swap_copy(
+		uint8_t				*p_dst,
+		const uint8_t			*p_src,
+		uint32_t			size)
+{
+	uint32_t i, word;
+	uint64_t words;
+
+	for(i = 0; (i + (uint32_t)8) <= size; i += (uint32_t)8)
+	{
+		(void)memcpy(&words, &(p_src[i]), 8);
+		words = __builtin_bswap64(words);
+		words = (words >> 32) | (words << 32);
+		(void)memcpy(&(p_dst[i]), &words, 8);
+	}
+	for(; (i + (uint32_t)4) <= size; i += (uint32_t)4)
+	{
+		(void)memcpy(&word, &(p_src[i]), 4);
+		word = __builtin_bswap32(word);
+		(void)memcpy(&(p_dst[i]), &word, 4);
+	}
+
+	/* Partial last word */
+	if(i < size)
+	{
+		(void)memcpy(&word, &(p_src[i]), 4);
+		word = __builtin_bswap32(word);
+		(void)memcpy(&(p_dst[i]), &word, size - i);
+	}
+}
+
+/**
+ * @brief Inner function, not available outside this file. This function
+ * returns the byte found at position 'pos' of a firmware buffer, as it would be
+ * after VL53L7CX_SwapBuffer().
+ */
+
+static uint8_t _vl53l7cx_swapped_byte(
+		const uint8_t			*p_buffer,
+		uint32_t			pos)
+{
+	return p_buffer[(pos & ~(uint32_t)3) + (uint32_t)3 - (pos & (uint32_t)3)];
+}
+
+/**
+ * @brief Inner function, not available outside this file. This function is used
+ * to decode the frame stored into the temporary buffer (data_read_size bytes
+ * read at address 0x0) into the results structure. The frame is decoded in a
+ * single pass: block headers and fields are byte-swapped while they are
+ * copied, and the temporary buffer is left in firmware order.
+ */
+
+static uint8_t _vl53l7cx_decode_ranging_data(
 		VL53L7CX_Configuration		*p_dev,
 		VL53L7CX_ResultsData		*p_results)
 {
 	uint8_t status = VL53L7CX_STATUS_OK;
 	uint16_t header_id, footer_id;
-	union Block_header *bh_ptr;
-	uint32_t i, j, msize;
-	status |= VL53L7CX_RdMulti(&(p_dev->platform), 0x0,
-			p_dev->temp_buffer, p_dev->data_read_size);
+	union Block_header bh;
+	uint8_t *p_dst;
+	uint32_t i, j, msize, decoded = 0;
+
 	p_dev->streamcount = p_dev->temp_buffer[0];
-	VL53L7CX_SwapBuffer(p_dev->temp_buffer, (uint16_t)p_dev->data_read_size);
 
 	/* Start conversion at position 16 to avoid headers */
 	for (i = (uint32_t)16; i 
              < (uint32_t)p_dev->data_read_size; i+=(uint32_t)4)
 	{
-		bh_ptr = (union Block_header *)&(p_dev->temp_buffer[i]);
-		if ((bh_ptr->type > (uint32_t)0x1) 
-                    && (bh_ptr->type < (uint32_t)0xd))
+		(void)memcpy(&bh.bytes, &(p_dev->temp_buffer[i]), 4);
+		bh.bytes = __builtin_bswap32(bh.bytes);
+		if ((bh.type > (uint32_t)0x1) 
+                    && (bh.type < (uint32_t)0xd))
 		{
-			msize = bh_ptr->type * bh_ptr->size;
+			msize = bh.type * bh.size;
 		}
 		else
 		{
-			msize = bh_ptr->size;
+			msize = bh.size;
 		}
 
-		switch(bh_ptr->idx){
+		p_dst = NULL;
+		switch(bh.idx){
 			case VL53L7CX_METADATA_IDX:
 				p_results->silicon_temp_degc =
-						(int8_t)p_dev->temp_buffer[i + (uint32_t)12];
+					(int8_t)_vl53l7cx_swapped_byte(
+					p_dev->temp_buffer, i + (uint32_t)12);
 				break;
 
 #ifndef VL53L7CX_DISABLE_AMBIENT_PER_SPAD
 			case VL53L7CX_AMBIENT_RATE_IDX:
-				(void)memcpy(p_results->ambient_per_spad,
-				&(p_dev->temp_buffer[i + (uint32_t)4]), msize);
+				p_dst = (uint8_t*)p_results->ambient_per_spad;
+				decoded |= VL53L7CX_OUTPUT_AMBIENT_PER_SPAD;
 				break;
 #endif
 #ifndef VL53L7CX_DISABLE_NB_SPADS_ENABLED
 			case VL53L7CX_SPAD_COUNT_IDX:
-				(void)memcpy(p_results->nb_spads_enabled,
-				&(p_dev->temp_buffer[i + (uint32_t)4]), msize);
+				p_dst = (uint8_t*)p_results->nb_spads_enabled;
+				decoded |= VL53L7CX_OUTPUT_NB_SPADS_ENABLED;
 				break;
 #endif
 #ifndef VL53L7CX_DISABLE_NB_TARGET_DETECTED
 			case VL53L7CX_NB_TARGET_DETECTED_IDX:
-				(void)memcpy(p_results->nb_target_detected,
-				&(p_dev->temp_buffer[i + (uint32_t)4]), msize);
+				p_dst = (uint8_t*)p_results->nb_target_detected;
+				decoded |= VL53L7CX_OUTPUT_NB_TARGET_DETECTED;
 				break;
 #endif
 #ifndef VL53L7CX_DISABLE_SIGNAL_PER_SPAD
 			case VL53L7CX_SIGNAL_RATE_IDX:
-				(void)memcpy(p_results->signal_per_spad,
-				&(p_dev->temp_buffer[i + (uint32_t)4]), msize);
+				p_dst = (uint8_t*)p_results->signal_per_spad;
+				decoded |= VL53L7CX_OUTPUT_SIGNAL_PER_SPAD;
 				break;
 #endif
 #ifndef VL53L7CX_DISABLE_RANGE_SIGMA_MM
 			case VL53L7CX_RANGE_SIGMA_MM_IDX:
-				(void)memcpy(p_results->range_sigma_mm,
-				&(p_dev->temp_buffer[i + (uint32_t)4]), msize);
+				p_dst = (uint8_t*)p_results->range_sigma_mm;
+				decoded |= VL53L7CX_OUTPUT_RANGE_SIGMA_MM;
 				break;
 #endif
 #ifndef VL53L7CX_DISABLE_DISTANCE_MM
 			case VL53L7CX_DISTANCE_IDX:
-				(void)memcpy(p_results->distance_mm,
-				&(p_dev->temp_buffer[i + (uint32_t)4]), msize);
+				p_dst = (uint8_t*)p_results->distance_mm;
+				decoded |= VL53L7CX_OUTPUT_DISTANCE_MM;
 				break;
 #endif
 #ifndef VL53L7CX_DISABLE_REFLECTANCE_PERCENT
 			case VL53L7CX_REFLECTANCE_EST_PC_IDX:
-				(void)memcpy(p_results->reflectance,
-				&(p_dev->temp_buffer[i + (uint32_t)4]), msize);
+				p_dst = (uint8_t*)p_results->reflectance;
+				decoded |= VL53L7CX_OUTPUT_REFLECTANCE_PERCENT;
 				break;
 #endif
 #ifndef VL53L7CX_DISABLE_TARGET_STATUS
 			case VL53L7CX_TARGET_STATUS_IDX:
-				(void)memcpy(p_results->target_status,
-				&(p_dev->temp_buffer[i + (uint32_t)4]), msize);
+				p_dst = (uint8_t*)p_results->target_status;
+				decoded |= VL53L7CX_OUTPUT_TARGET_STATUS;
 				break;
 #endif
 #ifndef VL53L7CX_DISABLE_MOTION_INDICATOR
 			case VL53L7CX_MOTION_DETEC_IDX:
-				(void)memcpy(&p_results->motion_indicator,
-				&(p_dev->temp_buffer[i + (uint32_t)4]), msize);
+				p_dst = (uint8_t*)&p_results->motion_indicator;
+				decoded |= VL53L7CX_OUTPUT_MOTION_INDICATOR;
 				break;
 #endif
 			default:
 				break;
 		}
+
+		if(p_dst != NULL)
+		{
+			_vl53l7cx_swap_copy(p_dst,
+				&(p_dev->temp_buffer[i + (uint32_t)4]), msize);
+		}
 		i += msize;
 	}
 
 #ifndef VL53L7CX_USE_RAW_FORMAT
 
-	/* Convert data into their real format */
+	/* Convert data into their real format. Only blocks received in this
+	 * frame are converted, the others keep their previous value */
 #ifndef VL53L7CX_DISABLE_AMBIENT_PER_SPAD
-	for(i = 0; i < (uint32_t)VL53L7CX_RESOLUTION_8X8; i++)
+	if((decoded & VL53L7CX_OUTPUT_AMBIENT_PER_SPAD) != (uint32_t)0)
 	{
-		p_results->ambient_per_spad[i] /= (uint32_t)2048;
+		for(i = 0; i < (uint32_t)VL53L7CX_RESOLUTION_8X8; i++)
+		{
+			p_results->ambient_per_spad[i] /= (uint32_t)2048;
+		}
 	}
 #endif
 
@@ -812,59 +1585,82 @@ uint8_t vl53l7cx_get_ranging_data(
 			*VL53L7CX_NB_TARGET_PER_ZONE); i++)
 	{
 #ifndef VL53L7CX_DISABLE_DISTANCE_MM
-		p_results->distance_mm[i] /= 4;
-		if(p_results->distance_mm[i] < 0)
+		if((decoded & VL53L7CX_OUTPUT_DISTANCE_MM) != (uint32_t)0)
 		{
-			p_results->distance_mm[i] = 0;
-		}
+			p_results->distance_mm[i] /= 4;
+			if(p_results->distance_mm[i] < 0)
+			{
+				p_results->distance_mm[i] = 0;
+			}
+		}
 #endif
 #ifndef VL53L7CX_DISABLE_REFLECTANCE_PERCENT
-		p_results->reflectance[i] /= (uint8_t)2;
+		if((decoded & VL53L7CX_OUTPUT_REFLECTANCE_PERCENT) != (uint32_t)0)
+		{
+			p_results->reflectance[i] /= (uint8_t)2;
+		}
 #endif
 #ifndef VL53L7CX_DISABLE_RANGE_SIGMA_MM
-		p_results->range_sigma_mm[i] /= (uint16_t)128;
+		if((decoded & VL53L7CX_OUTPUT_RANGE_SIGMA_MM) != (uint32_t)0)
+		{
+			p_results->range_sigma_mm[i] /= (uint16_t)128;
+		}
 #endif
 #ifndef VL53L7CX_DISABLE_SIGNAL_PER_SPAD
-		p_results->signal_per_spad[i] /= (uint32_t)2048;
+		if((decoded & VL53L7CX_OUTPUT_SIGNAL_PER_SPAD) != (uint32_t)0)
+		{
+			p_results->signal_per_spad[i] /= (uint32_t)2048;
+		}
 #endif
 	}
 
 	/* Set target status to 255 if no target is detected for this zone */
-#ifndef VL53L7CX_DISABLE_NB_TARGET_DETECTED
-	for(i = 0; i < (uint32_t)VL53L7CX_RESOLUTION_8X8; i++)
+#if !defined(VL53L7CX_DISABLE_NB_TARGET_DETECTED) \
+	&& !defined(VL53L7CX_DISABLE_TARGET_STATUS)
+	if(((decoded & VL53L7CX_OUTPUT_NB_TARGET_DETECTED) != (uint32_t)0)
+		&& ((decoded & VL53L7CX_OUTPUT_TARGET_STATUS) != (uint32_t)0))
 	{
-		if(p_results->nb_target_detected[i] == (uint8_t)0){
-			for(j = 0; j < (uint32_t)
-				VL53L7CX_NB_TARGET_PER_ZONE; j++)
-			{
-#ifndef VL53L7CX_DISABLE_TARGET_STATUS
-				p_results->target_status
-				[((uint32_t)VL53L7CX_NB_TARGET_PER_ZONE
-					*(uint32_t)i) + j]=(uint8_t)255;
-#endif
+		for(i = 0; i < (uint32_t)VL53L7CX_RESOLUTION_8X8; i++)
+		{
+			if(p_results->nb_target_detected[i] == (uint8_t)0){
+				for(j = 0; j < (uint32_t)
+					VL53L7CX_NB_TARGET_PER_ZONE; j++)
+				{
+					p_results->target_status
+					[((uint32_t)VL53L7CX_NB_TARGET_PER_ZONE
+						*(uint32_t)i) + j]=(uint8_t)255;
+				}
 			}
 		}
 	}
 #endif
 
 #ifndef VL53L7CX_DISABLE_MOTION_INDICATOR
-	for(i = 0; i < (uint32_t)32; i++)
+	if((decoded & VL53L7CX_OUTPUT_MOTION_INDICATOR) != (uint32_t)0)
 	{
-		p_results->motion_indicator.motion[i] /= (uint32_t)65535;
+		for(i = 0; i < (uint32_t)32; i++)
+		{
+			p_results->motion_indicator.motion[i] /= (uint32_t)65535;
+		}
 	}
 #endif
 
+#else
+	(void)j;
+	(void)decoded;
 #endif
 
 	/* Check if footer id and header id are matching. This allows to detect
 	 * corrupted frames */
-	header_id = ((uint16_t)(p_dev->temp_buffer[0x8])<<8) & 0xFF00U;
-	header_id |= ((uint16_t)(p_dev->temp_buffer[0x9])) & 0x00FFU;
-
-	footer_id = ((uint16_t)(p_dev->temp_buffer[p_dev->data_read_size
-		- (uint32_t)4]) << 8) & 0xFF00U;
-	footer_id |= ((uint16_t)(p_dev->temp_buffer[p_dev->data_read_size
-		- (uint32_t)3])) & 0xFFU;
+	header_id = ((uint16_t)_vl53l7cx_swapped_byte(p_dev->temp_buffer,
+		0x8) << 8) & 0xFF00U;
+	header_id |= ((uint16_t)_vl53l7cx_swapped_byte(p_dev->temp_buffer,
+		0x9)) & 0x00FFU;
+
+	footer_id = ((uint16_t)_vl53l7cx_swapped_byte(p_dev->temp_buffer,
+		p_dev->data_read_size - (uint32_t)4) << 8) & 0xFF00U;
+	footer_id |= ((uint16_t)_vl53l7cx_swapped_byte(p_dev->temp_buffer,
+		p_dev->data_read_size - (uint32_t)3)) & 0xFFU;
 	if(header_id != footer_id)
 	{
 		status |= VL53L7CX_STATUS_CORRUPTED_FRAME;
@@ -873,6 +1669,63 @@ uint8_t vl53l7cx_get_ranging_data(
 	return status;
 }
 
+uint8_t vl53l7cx_get_ranging_data(
+		VL53L7CX_Configuration		*p_dev,
+		VL53L7CX_ResultsData		*p_results)
+{
+	uint8_t status = VL53L7CX_STATUS_OK;
+
+	status |= VL53L7CX_RdMulti(&(p_dev->platform), 0x0,
+			p_dev->temp_buffer, p_dev->data_read_size);
+	status |= _vl53l7cx_decode_ranging_data(p_dev, p_results);
+
+	return status;
+}
+
+uint8_t vl53l7cx_start_ranging_data_read(
+		VL53L7CX_Configuration		*p_dev)
+{
+	uint8_t status = VL53L7CX_STATUS_OK;
+
+	status |= VL53L7CX_RdMultiAsync(&(p_dev->platform), 0x0,
+			p_dev->temp_buffer, p_dev->data_read_size, NULL, NULL);
+
+	return status;
+}
+
+uint8_t vl53l7cx_finish_ranging_data_read(
+		VL53L7CX_Configuration		*p_dev,
+		VL53L7CX_ResultsData		*p_results,
+		uint32_t			timeout_ms)
+{
+	uint8_t status = VL53L7CX_STATUS_OK;
+
+	/* The state of the transfer tells how it ended, also when it already
+	 * ended in VL53L7CX_PollAsync() or was never started */
+	(void)VL53L7CX_WaitAsync(&(p_dev->platform), timeout_ms);
+	switch(p_dev->platform.async_xfer.state)
+	{
+		case VL53L7CX_ASYNC_DONE:
+			status |= _vl53l7cx_decode_ranging_data(p_dev, p_results);
+			break;
+		case VL53L7CX_ASYNC_TIMEOUT:
+			status = VL53L7CX_STATUS_TIMEOUT_ERROR;
+			break;
+		case VL53L7CX_ASYNC_ERROR:
+			status = VL53L7CX_STATUS_ERROR;
+			break;
+		default:
+			/* No read started, or its frame already decoded */
+			status = VL53L7CX_STATUS_INVALID_PARAM;
+			break;
+	}
+
+	/* A frame is decoded once */
+	p_dev->platform.async_xfer.state = VL53L7CX_ASYNC_IDLE;
+
+	return status;
+}
+
 uint8_t vl53l7cx_get_resolution(
 		VL53L7CX_Configuration		*p_dev,
 		uint8_t				*p_resolution)
@@ -1251,6 +2104,13 @@ uint8_t vl53l7cx_dci_read_data(
 		for(i = 0 ; i < (int16_t)data_size;i++){
 			data[i] = p_dev->temp_buffer[i + 4];
 		}
+
+#ifdef VL53L7CX_USE_DCI_CACHE
+		if(status == (uint8_t)VL53L7CX_STATUS_OK)
+		{
+			_vl53l7cx_dci_cache_store(p_dev, data, index, data_size);
+		}
+#endif
 	}
 
 	return status;
@@ -1286,6 +2146,11 @@ uint8_t vl53l7cx_dci_write_data(
 		headers[2] = (uint8_t)(((data_size & (uint16_t)0xff0) >> 4));
 		headers[3] = (uint8_t)((data_size & (uint16_t)0xf) << 4);
 
+#ifdef VL53L7CX_USE_DCI_CACHE
+	/* Write-through: data can be the temporary buffer, so copy it now */
+		_vl53l7cx_dci_cache_store(p_dev, data, index, data_size);
+#endif
+
 	/* Copy data from structure to FW format (+4 bytes to add header) */
 		VL53L7CX_SwapBuffer(data, data_size);
 		for(i = (int16_t)data_size - (int16_t)1 ; i >= 0; i--)
@@ -1306,6 +2171,12 @@ uint8_t vl53l7cx_dci_write_data(
 			VL53L7CX_UI_CMD_STATUS, 0xff, 0x03);
 
 		VL53L7CX_SwapBuffer(data, data_size);
+#ifdef VL53L7CX_USE_DCI_CACHE
+		if(status != (uint8_t)VL53L7CX_STATUS_OK)
+		{
+			_vl53l7cx_dci_cache_drop(p_dev, index);
+		}
+#endif
 	}
 
 	return status;
@@ -1322,9 +2193,552 @@ uint8_t vl53l7cx_dci_replace_data(
 {
 	uint8_t status = VL53L7CX_STATUS_OK;
 
+#ifdef VL53L7CX_USE_DCI_CACHE
+	if(_vl53l7cx_dci_cache_load(p_dev, data, index, data_size)
+		!= (uint8_t)VL53L7CX_STATUS_OK)
+	{
+		status |= vl53l7cx_dci_read_data(p_dev, data, index, data_size);
+	}
+#else
 	status |= vl53l7cx_dci_read_data(p_dev, data, index, data_size);
+#endif
 	(void)memcpy(&(data[new_data_pos]), new_data, new_data_size);
 	status |= vl53l7cx_dci_write_data(p_dev, data, index, data_size);
 
 	return status;
 }
+
+uint8_t vl53l7cx_dci_cache_invalidate(
+		VL53L7CX_Configuration		*p_dev)
+{
+#ifdef VL53L7CX_USE_DCI_CACHE
+	(void)memset(p_dev->dci_cache.size, 0,
+		sizeof(p_dev->dci_cache.size));
+	p_dev->dci_cache.next = 0;
+#else
+	(void)p_dev;
+#endif
+
+	return VL53L7CX_STATUS_OK;
+}
+
+uint8_t vl53l7cx_get_dci_cache_stats(
+		VL53L7CX_Configuration		*p_dev,
+		uint32_t			*p_nb_hits,
+		uint32_t			*p_nb_misses)
+{
+#ifdef VL53L7CX_USE_DCI_CACHE
+	*p_nb_hits = p_dev->dci_cache.nb_hits;
+	*p_nb_misses = p_dev->dci_cache.nb_misses;
+#else
+	(void)p_dev;
+	*p_nb_hits = 0;
+	*p_nb_misses = 0;
+#endif
+
+	return VL53L7CX_STATUS_OK;
+}
+
+/**
+ * @brief Inner function, not available outside this file. This function is used
+ * to find a staged block, or to add it to the transaction.
+ */
+
+static uint8_t _vl53l7cx_transaction_block(
+		VL53L7CX_Transaction		*p_txn,
+		uint32_t			index,
+		uint16_t			data_size,
+		VL53L7CX_TransactionBlock	**pp_block)
+{
+	uint8_t i, status = VL53L7CX_STATUS_OK;
+	VL53L7CX_TransactionBlock *p_block = NULL;
+
+	for(i = 0; i < p_txn->nb_blocks; i++)
+	{
+		if(p_txn->blocks[i].index == (uint16_t)index)
+		{
+			p_block = &(p_txn->blocks[i]);
+			break;
+		}
+	}
+
+	if(p_block != NULL)
+	{
+		if(p_block->size != data_size)
+		{
+			status |= VL53L7CX_STATUS_INVALID_PARAM;
+		}
+	}
+	else if((p_txn->nb_blocks >= VL53L7CX_TRANSACTION_MAX_BLOCKS)
+		|| ((data_size & (uint16_t)0x3) != (uint16_t)0)
+		|| ((p_txn->data_used + data_size)
+			> VL53L7CX_TRANSACTION_DATA_SIZE))
+	{
+		status |= VL53L7CX_STATUS_INVALID_PARAM;
+	}
+	else
+	{
+		p_block = &(p_txn->blocks[p_txn->nb_blocks]);
+		p_block->index = (uint16_t)index;
+		p_block->size = data_size;
+		p_block->offset = p_txn->data_used;
+		(void)memset(&(p_txn->staged[p_block->offset]), 0, data_size);
+		p_txn->data_used += data_size;
+		p_txn->nb_blocks++;
+	}
+
+	*pp_block = p_block;
+	return status;
+}
+
+/**
+ * @brief Inner function, not available outside this file. This function is used
+ * to check if some bytes of a staged block must be read from the sensor.
+ */
+
+static uint8_t _vl53l7cx_transaction_needs_read(
+		const VL53L7CX_Transaction	*p_txn,
+		const VL53L7CX_TransactionBlock	*p_block)
+{
+	uint16_t k;
+	uint8_t needs_read = 0;
+
+	for(k = 0; k < p_block->size; k++)
+	{
+		if(p_txn->staged[p_block->offset + k] == (uint8_t)0)
+		{
+			needs_read = 1;
+			break;
+		}
+	}
+
+	return needs_read;
+}
+
+/**
+ * @brief Inner function, not available outside this file. This function is used
+ * to complete a partially staged block with the content read from the sensor.
+ */
+
+static void _vl53l7cx_transaction_merge(
+		VL53L7CX_Transaction		*p_txn,
+		const VL53L7CX_TransactionBlock	*p_block,
+		const uint8_t			*current)
+{
+	uint16_t k;
+
+	for(k = 0; k < p_block->size; k++)
+	{
+		if(p_txn->staged[p_block->offset + k] == (uint8_t)0)
+		{
+			p_txn->data[p_block->offset + k] = current[k];
+		}
+	}
+}
+
+/**
+ * @brief Inner function, not available outside this file. This function is used
+ * to send blocks packed into the temporary buffer, followed by the end of list
+ * and the DCI write command. 'size' is the number of packed bytes.
+ */
+
+static uint8_t _vl53l7cx_transaction_send(
+		VL53L7CX_Configuration		*p_dev,
+		uint16_t			size,
+		uint8_t				dry_run,
+		VL53L7CX_TransactionReport	*p_report)
+{
+	uint8_t status = VL53L7CX_STATUS_OK;
+	uint8_t footer[] = {0x00, 0x00, 0x00, 0x0f, 0x05, 0x01,
+			(uint8_t)((size + (uint16_t)4) >> 8),
+			(uint8_t)((size + (uint16_t)4) & (uint8_t)0xFF)};
+	uint16_t address = (uint16_t)VL53L7CX_UI_CMD_END -
+		(size + (uint16_t)8) + (uint16_t)1;
+
+	if(dry_run == (uint8_t)0)
+	{
+		(void)memcpy(&(p_dev->temp_buffer[size]), footer, sizeof(footer));
+		status |= VL53L7CX_WrMulti(&(p_dev->platform), address,
+			p_dev->temp_buffer, (uint32_t)size + (uint32_t)8);
+		status |= _vl53l7cx_poll_for_answer(p_dev, 4, 1,
+			VL53L7CX_UI_CMD_STATUS, 0xff, 0x03);
+	}
+
+	p_report->nb_ui_cmds++;
+	p_report->nb_i2c_transactions++;
+	p_report->nb_i2c_bytes += (uint32_t)size + (uint32_t)10;
+
+	return status;
+}
+
+uint8_t vl53l7cx_transaction_init(
+		VL53L7CX_Transaction		*p_txn)
+{
+	(void)memset(p_txn, 0, sizeof(VL53L7CX_Transaction));
+
+	return VL53L7CX_STATUS_OK;
+}
+
+uint8_t vl53l7cx_transaction_write_data(
+		VL53L7CX_Transaction		*p_txn,
+		uint8_t				*data,
+		uint32_t			index,
+		uint16_t			data_size)
+{
+	uint8_t status = VL53L7CX_STATUS_OK;
+	VL53L7CX_TransactionBlock *p_block;
+
+	status |= _vl53l7cx_transaction_block(p_txn, index, data_size,
+			&p_block);
+	if(status == (uint8_t)VL53L7CX_STATUS_OK)
+	{
+		(void)memcpy(&(p_txn->data[p_block->offset]), data, data_size);
+		(void)memset(&(p_txn->staged[p_block->offset]), 1, data_size);
+	}
+
+	return status;
+}
+
+uint8_t vl53l7cx_transaction_replace_data(
+		VL53L7CX_Transaction		*p_txn,
+		uint32_t			index,
+		uint16_t			data_size,
+		uint8_t				*new_data,
+		uint16_t			new_data_size,
+		uint16_t			new_data_pos)
+{
+	uint8_t status = VL53L7CX_STATUS_OK;
+	VL53L7CX_TransactionBlock *p_block;
+
+	if((new_data_pos + new_data_size) > data_size)
+	{
+		status |= VL53L7CX_STATUS_INVALID_PARAM;
+	}
+	else
+	{
+		status |= _vl53l7cx_transaction_block(p_txn, index, data_size,
+				&p_block);
+	}
+
+	if(status == (uint8_t)VL53L7CX_STATUS_OK)
+	{
+		(void)memcpy(&(p_txn->data[p_block->offset + new_data_pos]),
+			new_data, new_data_size);
+		(void)memset(&(p_txn->staged[p_block->offset + new_data_pos]),
+			1, new_data_size);
+	}
+
+	return status;
+}
+
+uint8_t vl53l7cx_transaction_set_resolution(
+		VL53L7CX_Transaction		*p_txn,
+		uint8_t				resolution)
+{
+	uint8_t status = VL53L7CX_STATUS_OK;
+	uint8_t dss, dss_mode, zones, zone_size;
+
+	switch(resolution){
+		case VL53L7CX_RESOLUTION_4X4:
+			dss = 64;
+			dss_mode = 4;
+			zones = 4;
+			zone_size = 8;
+			break;
+
+		case VL53L7CX_RESOLUTION_8X8:
+			dss = 16;
+			dss_mode = 1;
+			zones = 8;
+			zone_size = 4;
+			break;
+
+		default:
+			status = VL53L7CX_STATUS_INVALID_PARAM;
+			break;
+	}
+
+	if(status == (uint8_t)VL53L7CX_STATUS_OK)
+	{
+		status |= vl53l7cx_transaction_replace_data(p_txn,
+				VL53L7CX_DCI_DSS_CONFIG, 16, &dss, 1, 0x04);
+		status |= vl53l7cx_transaction_replace_data(p_txn,
+				VL53L7CX_DCI_DSS_CONFIG, 16, &dss, 1, 0x06);
+		status |= vl53l7cx_transaction_replace_data(p_txn,
+				VL53L7CX_DCI_DSS_CONFIG, 16, &dss_mode, 1, 0x09);
+		status |= vl53l7cx_transaction_replace_data(p_txn,
+				VL53L7CX_DCI_ZONE_CONFIG, 8, &zones, 1, 0x00);
+		status |= vl53l7cx_transaction_replace_data(p_txn,
+				VL53L7CX_DCI_ZONE_CONFIG, 8, &zones, 1, 0x01);
+		status |= vl53l7cx_transaction_replace_data(p_txn,
+				VL53L7CX_DCI_ZONE_CONFIG, 8, &zone_size, 1, 0x04);
+		status |= vl53l7cx_transaction_replace_data(p_txn,
+				VL53L7CX_DCI_ZONE_CONFIG, 8, &zone_size, 1, 0x05);
+		p_txn->resolution = resolution;
+	}
+
+	return status;
+}
+
+uint8_t vl53l7cx_transaction_set_ranging_frequency_hz(
+		VL53L7CX_Transaction		*p_txn,
+		uint8_t				frequency_hz)
+{
+	return vl53l7cx_transaction_replace_data(p_txn, VL53L7CX_DCI_FREQ_HZ, 4,
+			(uint8_t*)&frequency_hz, 1, 0x01);
+}
+
+uint8_t vl53l7cx_transaction_set_integration_time_ms(
+		VL53L7CX_Transaction		*p_txn,
+		uint32_t			integration_time_ms)
+{
+	uint8_t status = VL53L7CX_STATUS_OK;
+	uint32_t integration = integration_time_ms;
+
+	/* Integration time must be between 2ms and 1000ms */
+	if((integration < (uint32_t)2)
+           || (integration > (uint32_t)1000))
+	{
+		status |= VL53L7CX_STATUS_INVALID_PARAM;
+	}else
+	{
+		integration *= (uint32_t)1000;
+		status |= vl53l7cx_transaction_replace_data(p_txn,
+				VL53L7CX_DCI_INT_TIME, 20,
+				(uint8_t*)&integration, 4, 0x00);
+	}
+
+	return status;
+}
+
+uint8_t vl53l7cx_transaction_set_sharpener_percent(
+		VL53L7CX_Transaction		*p_txn,
+		uint8_t				sharpener_percent)
+{
+	uint8_t status = VL53L7CX_STATUS_OK;
+	uint8_t sharpener;
+
+	if(sharpener_percent >= (uint8_t)100)
+	{
+		status |= VL53L7CX_STATUS_INVALID_PARAM;
+	}
+	else
+	{
+		sharpener = (sharpener_percent*(uint8_t)255)/(uint8_t)100;
+		status |= vl53l7cx_transaction_replace_data(p_txn,
+				VL53L7CX_DCI_SHARPENER, 16,
+				(uint8_t*)&sharpener, 1, 0xD);
+	}
+
+	return status;
+}
+
+uint8_t vl53l7cx_transaction_set_target_order(
+		VL53L7CX_Transaction		*p_txn,
+		uint8_t				target_order)
+{
+	uint8_t status = VL53L7CX_STATUS_OK;
+
+	if((target_order == (uint8_t)VL53L7CX_TARGET_ORDER_CLOSEST)
+		|| (target_order == (uint8_t)VL53L7CX_TARGET_ORDER_STRONGEST))
+	{
+		status |= vl53l7cx_transaction_replace_data(p_txn,
+				VL53L7CX_DCI_TARGET_ORDER, 4,
+				(uint8_t*)&target_order, 1, 0x0);
+	}else
+	{
+		status |= VL53L7CX_STATUS_INVALID_PARAM;
+	}
+
+	return status;
+}
+
+uint8_t vl53l7cx_transaction_set_ranging_mode(
+		VL53L7CX_Transaction		*p_txn,
+		uint8_t				ranging_mode)
+{
+	uint8_t status = VL53L7CX_STATUS_OK;
+	uint8_t mode[2];
+	uint32_t single_range = 0x00;
+
+	switch(ranging_mode)
+	{
+		case VL53L7CX_RANGING_MODE_CONTINUOUS:
+			mode[0] = 0x1;
+			mode[1] = 0x3;
+			single_range = 0x00;
+			break;
+
+		case VL53L7CX_RANGING_MODE_AUTONOMOUS:
+			mode[0] = 0x3;
+			mode[1] = 0x2;
+			single_range = 0x01;
+			break;
+
+		default:
+			status = VL53L7CX_STATUS_INVALID_PARAM;
+			break;
+	}
+
+	if(status == (uint8_t)VL53L7CX_STATUS_OK)
+	{
+		status |= vl53l7cx_transaction_replace_data(p_txn,
+				VL53L7CX_DCI_RANGING_MODE, 8, &mode[0], 1, 0x01);
+		status |= vl53l7cx_transaction_replace_data(p_txn,
+				VL53L7CX_DCI_RANGING_MODE, 8, &mode[1], 1, 0x03);
+		status |= vl53l7cx_transaction_write_data(p_txn,
+				(uint8_t*)&single_range,
+				VL53L7CX_DCI_SINGLE_RANGE,
+				(uint16_t)sizeof(single_range));
+	}
+
+	return status;
+}
+
+uint8_t vl53l7cx_transaction_commit(
+		VL53L7CX_Configuration		*p_dev,
+		VL53L7CX_Transaction		*p_txn,
+		uint8_t				dry_run,
+		VL53L7CX_TransactionReport	*p_report)
+{
+	uint8_t i, status = VL53L7CX_STATUS_OK;
+	uint16_t size = 0;
+	const VL53L7CX_TransactionBlock *p_block;
+#ifdef VL53L7CX_USE_DCI_CACHE
+	uint8_t entry;
+#endif
+	VL53L7CX_TransactionReport report = {0, 0, 0, 0};
+	uint32_t nb_polls = p_dev->poll_stats.total_nb_polls;
+	const uint16_t max_size = ((uint16_t)VL53L7CX_TEMPORARY_BUFFER_SIZE
+		< (VL53L7CX_UI_CMD_END - VL53L7CX_UI_CMD_START + (uint16_t)1))
+		? (uint16_t)VL53L7CX_TEMPORARY_BUFFER_SIZE
+		: (VL53L7CX_UI_CMD_END - VL53L7CX_UI_CMD_START + (uint16_t)1);
+
+	/* Read blocks which are only partially staged */
+	for(i = 0; i < p_txn->nb_blocks; i++)
+	{
+		p_block = &(p_txn->blocks[i]);
+		if(_vl53l7cx_transaction_needs_read(p_txn, p_block)
+			== (uint8_t)0)
+		{
+			continue;
+		}
+
+#ifdef VL53L7CX_USE_DCI_CACHE
+		if(dry_run != (uint8_t)0)
+		{
+			entry = _vl53l7cx_dci_cache_find(p_dev, p_block->index);
+			if((entry < VL53L7CX_DCI_CACHE_ENTRIES)
+				&& (p_dev->dci_cache.size[entry] == p_block->size))
+			{
+				continue;
+			}
+		}
+		else if(_vl53l7cx_dci_cache_load(p_dev, p_dev->temp_buffer,
+			p_block->index, p_block->size) == (uint8_t)VL53L7CX_STATUS_OK)
+		{
+			_vl53l7cx_transaction_merge(p_txn, p_block,
+				p_dev->temp_buffer);
+			continue;
+		}
+		else
+		{
+			/* Not cached, read below */
+		}
+#endif
+
+		if(dry_run == (uint8_t)0)
+		{
+			status |= vl53l7cx_dci_read_data(p_dev, p_dev->temp_buffer,
+					p_block->index, p_block->size);
+			_vl53l7cx_transaction_merge(p_txn, p_block,
+				p_dev->temp_buffer);
+		}
+
+		/* Read command and data read */
+		report.nb_dci_reads++;
+		report.nb_ui_cmds++;
+		report.nb_i2c_transactions += (uint32_t)2;
+		report.nb_i2c_bytes += (uint32_t)14
+			+ (uint32_t)p_block->size + (uint32_t)14;
+	}
+
+	/* Pack all blocks (header + data) into as few commands as possible */
+	for(i = 0; i < p_txn->nb_blocks; i++)
+	{
+		p_block = &(p_txn->blocks[i]);
+		if((size + (uint16_t)4 + p_block->size + (uint16_t)8) > max_size)
+		{
+			status |= _vl53l7cx_transaction_send(p_dev, size, dry_run,
+					&report);
+			size = 0;
+		}
+
+		if(dry_run == (uint8_t)0)
+		{
+			p_dev->temp_buffer[size] = (uint8_t)(p_block->index >> 8);
+			p_dev->temp_buffer[size + (uint16_t)1] =
+				(uint8_t)(p_block->index & (uint16_t)0xff);
+			p_dev->temp_buffer[size + (uint16_t)2] =
+				(uint8_t)((p_block->size & (uint16_t)0xff0) >> 4);
+			p_dev->temp_buffer[size + (uint16_t)3] =
+				(uint8_t)((p_block->size & (uint16_t)0xf) << 4);
+			(void)memcpy(&(p_dev->temp_buffer[size + (uint16_t)4]),
+				&(p_txn->data[p_block->offset]), p_block->size);
+#ifdef VL53L7CX_USE_DCI_CACHE
+			_vl53l7cx_dci_cache_store(p_dev,
+				&(p_txn->data[p_block->offset]),
+				p_block->index, p_block->size);
+#endif
+			VL53L7CX_SwapBuffer(&(p_dev->temp_buffer[size + (uint16_t)4]),
+				p_block->size);
+		}
+		size += (uint16_t)4 + p_block->size;
+	}
+
+	if(size != (uint16_t)0)
+	{
+		status |= _vl53l7cx_transaction_send(p_dev, size, dry_run, &report);
+	}
+
+#ifdef VL53L7CX_USE_DCI_CACHE
+	if((dry_run == (uint8_t)0) && (status != (uint8_t)VL53L7CX_STATUS_OK))
+	{
+		status |= vl53l7cx_dci_cache_invalidate(p_dev);
+	}
+#endif
+
+	/* A new resolution needs offset and Xtalk data (see set_resolution) */
+	if(p_txn->resolution != (uint8_t)0)
+	{
+		if(dry_run == (uint8_t)0)
+		{
+			status |= _vl53l7cx_send_offset_data(p_dev, p_txn->resolution);
+			status |= _vl53l7cx_send_xtalk_data(p_dev, p_txn->resolution);
+		}
+		report.nb_ui_cmds += (uint32_t)2;
+		report.nb_i2c_transactions += (uint32_t)2;
+		report.nb_i2c_bytes += (uint32_t)VL53L7CX_OFFSET_BUFFER_SIZE
+			+ (uint32_t)VL53L7CX_XTALK_BUFFER_SIZE + (uint32_t)4;
+	}
+
+	/* Status polls (2 bytes address + 4 bytes status), one per command for
+	 * a dry run */
+	if(dry_run == (uint8_t)0)
+	{
+		nb_polls = p_dev->poll_stats.total_nb_polls - nb_polls;
+	}
+	else
+	{
+		nb_polls = report.nb_ui_cmds;
+	}
+	report.nb_i2c_transactions += nb_polls;
+	report.nb_i2c_bytes += nb_polls * (uint32_t)6;
+
+	if(p_report != NULL)
+	{
+		*p_report = report;
+	}
+
+	return status;
+}
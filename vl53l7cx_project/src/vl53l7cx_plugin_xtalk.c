@@ -46,6 +46,8 @@ static uint8_t _vl53l7cx_poll_for_answer(
 	return status;
 }
 
+#ifndef VL53L7CX_CONST_CALIBRATION
+
 /*
  * Inner function, not available outside this file. This function is used to
  * program the output using the macro defined into the 'platform.h' file.
@@ -143,12 +145,15 @@ static uint8_t _vl53l7cx_program_output_config(
 	return status;
 }
 
+#endif
+
 uint8_t vl53l7cx_calibrate_xtalk(
 		VL53L7CX_Configuration		*p_dev,
 		uint16_t			reflectance_percent,
 		uint8_t				nb_samples,
 		uint16_t			distance_mm)
 {
+#ifndef VL53L7CX_CONST_CALIBRATION
 	uint16_t timeout = 0;
 	uint8_t cmd[] = {0x00, 0x03, 0x00, 0x00};
 	uint8_t footer[] = {0x00, 0x00, 0x00, 0x0F, 0x00, 0x01, 0x03, 0x04};
@@ -191,6 +196,7 @@ uint8_t vl53l7cx_calibrate_xtalk(
                        (uint16_t)sizeof(VL53L7CX_CALIBRATE_XTALK));
 		status |= _vl53l7cx_poll_for_answer(p_dev,
 				VL53L7CX_UI_CMD_STATUS, 0x3);
+		status |= vl53l7cx_dci_cache_invalidate(p_dev);
 
 		/* Format input argument */
 		reflectance = reflectance * (uint16_t)16;
@@ -274,6 +280,7 @@ uint8_t vl53l7cx_calibrate_xtalk(
 			p_dev->default_configuration,
 			VL53L7CX_CONFIGURATION_SIZE);
 	status |= _vl53l7cx_poll_for_answer(p_dev,VL53L7CX_UI_CMD_STATUS, 0x03);
+	status |= vl53l7cx_dci_cache_invalidate(p_dev);
 
 	/* Reset initial configuration */
 	status |= vl53l7cx_set_resolution(p_dev, resolution);
@@ -285,6 +292,14 @@ uint8_t vl53l7cx_calibrate_xtalk(
 	status |= vl53l7cx_set_ranging_mode(p_dev, ranging_mode);
 
 	return status;
+#else
+	/* No RAM buffer to store the calibration result */
+	(void)p_dev;
+	(void)reflectance_percent;
+	(void)nb_samples;
+	(void)distance_mm;
+	return VL53L7CX_STATUS_INVALID_PARAM;
+#endif
 }
 
 uint8_t vl53l7cx_get_caldata_xtalk(
@@ -318,12 +333,16 @@ uint8_t vl53l7cx_get_caldata_xtalk(
 
 uint8_t vl53l7cx_set_caldata_xtalk(
 		VL53L7CX_Configuration		*p_dev,
-		uint8_t				*p_xtalk_data)
+		const uint8_t			*p_xtalk_data)
 {
 	uint8_t resolution, status = VL53L7CX_STATUS_OK;
 
 	status |= vl53l7cx_get_resolution(p_dev, &resolution);
+#ifndef VL53L7CX_CONST_CALIBRATION
 	(void)memcpy(p_dev->xtalk_data, p_xtalk_data, VL53L7CX_XTALK_BUFFER_SIZE);
+#else
+	p_dev->xtalk_data = p_xtalk_data;
+#endif
 	status |= vl53l7cx_set_resolution(p_dev, resolution);
 
 	return status;
@@ -0,0 +1,205 @@
+#!/usr/bin/env python3
+"""
+VL53L7CX Firmware Compressor
+============================
+
+Build step: extracts VL53L7CX_FIRMWARE from vl53l7cx_buffers.h and writes it
+compressed into a C header, decoded by vl53l7cx_init() while the firmware is
+downloaded (VL53L7CX_COMPRESSED_FIRMWARE, see platform_pico.h).
+
+Format: LZ4 block format (token, literals, 16-bit little-endian offset, match
+length), with back-references limited to a window of --window bytes. The
+decoder keeps this window in the driver temporary buffer and writes it to the
+sensor each time it is full, so no full-size RAM copy of the firmware is
+needed.
+
+The output is decoded again and compared byte for byte with the original
+before being written; the script fails if they differ.
+
+Usage: fw_compress.py <vl53l7cx_buffers.h> <output.h> [--window 1024]
+"""
+
+import argparse
+import re
+import sys
+import time
+
+MIN_MATCH = 4
+MAX_CHAIN = 256
+
+
+def extract_array(source, name):
+    """Return the bytes of 'const uint8_t <name>[] = {...};' in source"""
+    match = re.search(r'\b' + name + r'\[\]\s*=\s*\{(.*?)\};', source, re.S)
+    if not match:
+        raise ValueError('array %s not found' % name)
+    values = re.findall(r'0[xX][0-9a-fA-F]+|\d+', match.group(1))
+    return bytes(int(v, 0) for v in values)
+
+
+def _write_length(out, length):
+    while length >= 255:
+        out.append(255)
+        length -= 255
+    out.append(length)
+
+
+def compress(data, window):
+    """Greedy LZ4 block compression, offsets limited to window"""
+    out = bytearray()
+    head = {}           # 4-byte prefix -> last position
+    prev = [0] * len(data)
+    anchor = 0
+    pos = 0
+    end = len(data)
+
+    def insert(p):
+        key = data[p:p + MIN_MATCH]
+        prev[p] = head.get(key, -1)
+        head[key] = p
+
+    while pos + MIN_MATCH <= end:
+        best_len = 0
+        best_off = 0
+        candidate = head.get(data[pos:pos + MIN_MATCH], -1)
+        chain = 0
+        while candidate >= 0 and pos - candidate <= window and chain < MAX_CHAIN:
+            length = 0
+            while pos + length < end and data[candidate + length] == data[pos + length]:
+                length += 1
+            if length > best_len:
+                best_len = length
+                best_off = pos - candidate
+            candidate = prev[candidate]
+            chain += 1
+
+        if best_len < MIN_MATCH:
+            insert(pos)
+            pos += 1
+            continue
+
+        literals = data[anchor:pos]
+        token_lit = min(len(literals), 15)
+        token_match = min(best_len - MIN_MATCH, 15)
+        out.append((token_lit << 4) | token_match)
+        if token_lit == 15:
+            _write_length(out, len(literals) - 15)
+        out += literals
+        out += bytes((best_off & 0xFF, best_off >> 8))
+        if token_match == 15:
+            _write_length(out, best_len - MIN_MATCH - 15)
+
+        for p in range(pos, min(pos + best_len, end - MIN_MATCH + 1)):
+            insert(p)
+        pos += best_len
+        anchor = pos
+
+    # Last sequence: literals only
+    literals = data[anchor:]
+    token_lit = min(len(literals), 15)
+    out.append(token_lit << 4)
+    if token_lit == 15:
+        _write_length(out, len(literals) - 15)
+    out += literals
+
+    return bytes(out)
+
+
+def decompress(stream, window):
+    """Reference decoder, with the same window limit as the C decoder"""
+    out = bytearray()
+    pos = 0
+    while pos < len(stream):
+        token = stream[pos]
+        pos += 1
+
+        length = token >> 4
+        if length == 15:
+            while True:
+                extra = stream[pos]
+                pos += 1
+                length += extra
+                if extra != 255:
+                    break
+        out += stream[pos:pos + length]
+        pos += length
+        if pos >= len(stream):
+            break
+
+        offset = stream[pos] | (stream[pos + 1] << 8)
+        pos += 2
+        if offset == 0 or offset > window or offset > len(out):
+            raise ValueError('invalid offset %d' % offset)
+
+        length = (token & 0x0F) + MIN_MATCH
+        if (token & 0x0F) == 15:
+            while True:
+                extra = stream[pos]
+                pos += 1
+                length += extra
+                if extra != 255:
+                    break
+        for _ in range(length):
+            out.append(out[-offset])
+
+    return bytes(out)
+
+
+def write_header(path, stream, size, window):
+    lines = [
+        '/**',
+        ' * VL53L7CX firmware, compressed (LZ4 block format, %d bytes window).' % window,
+        ' * Generated by tools/fw_compress.py from vl53l7cx_buffers.h: do not edit.',
+        ' * Included by src/vl53l7cx_api.c only.',
+        ' */',
+        '',
+        '#ifndef VL53L7CX_FIRMWARE_LZ_H_',
+        '#define VL53L7CX_FIRMWARE_LZ_H_',
+        '',
+        '#include <stdint.h>',
+        '',
+        '#define VL53L7CX_FIRMWARE_SIZE\t\t%dU' % size,
+        '#define VL53L7CX_FIRMWARE_LZ_WINDOW\t%dU' % window,
+        '',
+        'static const uint8_t VL53L7CX_FIRMWARE_LZ[] = {',
+    ]
+    for i in range(0, len(stream), 16):
+        chunk = stream[i:i + 16]
+        lines.append('\t' + ', '.join('0x%02x' % b for b in chunk) + ',')
+    lines += ['};', '', '#endif /* VL53L7CX_FIRMWARE_LZ_H_ */', '']
+
+    with open(path, 'w') as f:
+        f.write('\n'.join(lines))
+
+
+def main():
+    parser = argparse.ArgumentParser(description='Compress the VL53L7CX firmware')
+    parser.add_argument('buffers', help='vl53l7cx_buffers.h')
+    parser.add_argument('output', help='generated header')
+    parser.add_argument('--window', type=int, default=1024,
+                        help='back-reference window (bytes), must fit the '
+                             'driver temporary buffer')
+    args = parser.parse_args()
+    if args.window & (args.window - 1) or not 16 <= args.window <= 1024:
+        sys.exit('fw_compress: window must be a power of 2, from 16 to 1024')
+
+    with open(args.buffers) as f:
+        firmware = extract_array(f.read(), 'VL53L7CX_FIRMWARE')
+
+    stream = compress(firmware, args.window)
+
+    start = time.perf_counter()
+    decoded = decompress(stream, args.window)
+    elapsed = time.perf_counter() - start
+    if decoded != firmware:
+        sys.exit('fw_compress: round trip mismatch')
+
+    write_header(args.output, stream, len(firmware), args.window)
+    print('fw_compress: %d -> %d bytes (%.1f%%, %d bytes of flash saved), '
+          'round trip OK (reference decoder: %.1f MB/s)'
+          % (len(firmware), len(stream), 100.0 * len(stream) / len(firmware),
+             len(firmware) - len(stream), len(firmware) / elapsed / 1e6))
+
+
+if __name__ == '__main__':
+    main()
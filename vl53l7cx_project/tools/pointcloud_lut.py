@@ -0,0 +1,94 @@
+#!/usr/bin/env python3
+"""
+VL53L7CX Point Cloud Ray Tables
+===============================
+
+Writes vl53l7cx_pointcloud_lut.h: the unit vector of the ray through the
+centre of each zone, for the 4x4 and 8x8 resolutions, used by
+vl53l7cx_pointcloud_project() to turn distances into points with three
+multiplications per target.
+
+Model: the zones tile the focal plane of a pinhole camera whose field of view
+is fov_x by fov_y degrees (60 x 60 for the VL53L7CX, 90 diagonal). The ray of
+zone (row, column) of an n x n grid goes through
+
+    u = tan(fov_x / 2) * ((2 * column + 1) / n - 1)
+    v = tan(fov_y / 2) * ((2 * row + 1) / n - 1)
+
+on the plane z = 1; its unit vector (u, v, 1) / |(u, v, 1)| is stored in
+Q15 (32767 = 1.0). x grows with the column, y with the row, z is along the
+optical axis.
+
+The header is part of the sources; run this script again for another field of
+view (a cover glass or a lens in front of the sensor).
+
+Usage: pointcloud_lut.py <output.h> [--fov 60 60]
+"""
+
+import argparse
+import math
+import sys
+
+
+def rays(n, fov_x, fov_y):
+    """Q15 unit vectors (x, y, z lists) of the zones of an n x n grid"""
+    tx = math.tan(math.radians(fov_x) / 2)
+    ty = math.tan(math.radians(fov_y) / 2)
+    xs, ys, zs = [], [], []
+    for row in range(n):
+        for column in range(n):
+            u = tx * ((2 * column + 1) / n - 1)
+            v = ty * ((2 * row + 1) / n - 1)
+            norm = math.sqrt(u * u + v * v + 1)
+            for out, value in ((xs, u / norm), (ys, v / norm), (zs, 1 / norm)):
+                out.append(min(32767, int(round(value * 32768))))
+    return xs, ys, zs
+
+
+def c_array(name, n, values):
+    lines = []
+    for row in range(n):
+        lines.append('\t' + ', '.join('%6d' % v for v in values[row * n:(row + 1) * n]) + ',')
+    return '\t{ /* %s */\n%s\n\t}' % (name, '\n'.join(lines))
+
+
+def main():
+    parser = argparse.ArgumentParser(description='VL53L7CX point cloud ray tables')
+    parser.add_argument('output')
+    parser.add_argument('--fov', nargs=2, type=float, default=[60.0, 60.0],
+                        metavar=('X', 'Y'), help='field of view in degrees')
+    args = parser.parse_args()
+    fov_x, fov_y = args.fov
+
+    out = []
+    out.append('/**')
+    out.append(' * VL53L7CX Point Cloud Ray Tables')
+    out.append(' *')
+    out.append(' * Generated by tools/pointcloud_lut.py --fov %g %g, do not edit.' % (fov_x, fov_y))
+    out.append(' * Unit vector of the ray of each zone, Q15, x then y then z.')
+    out.append(' */')
+    out.append('')
+    out.append('#ifndef _VL53L7CX_POINTCLOUD_LUT_H_')
+    out.append('#define _VL53L7CX_POINTCLOUD_LUT_H_')
+    out.append('')
+    out.append('#include <stdint.h>')
+    out.append('')
+    out.append('#define VL53L7CX_POINTCLOUD_FOV_X_DEG\t%.1ff' % fov_x)
+    out.append('#define VL53L7CX_POINTCLOUD_FOV_Y_DEG\t%.1ff' % fov_y)
+    for n in (4, 8):
+        xs, ys, zs = rays(n, fov_x, fov_y)
+        out.append('')
+        out.append('static const int16_t vl53l7cx_pointcloud_rays_%dx%d[3][%d] = {' % (n, n, n * n))
+        out.append(',\n'.join([c_array('x', n, xs), c_array('y', n, ys), c_array('z', n, zs)]))
+        out.append('};')
+    out.append('')
+    out.append('#endif /* _VL53L7CX_POINTCLOUD_LUT_H_ */')
+
+    with open(args.output, 'w') as f:
+        f.write('\n'.join(out) + '\n')
+    print('%s: rays for a %g x %g deg field of view' % (args.output, fov_x, fov_y))
+    return 0
+
+
+if __name__ == '__main__':
+    sys.exit(main())
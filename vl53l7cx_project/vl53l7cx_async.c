@@ -0,0 +1,152 @@
+/**
+ * Asynchronous Transfer Engine Implementation for VL53L7CX Platform Layer
+ *
+ * Hardware independent part of the asynchronous transfers: submission, state
+ * tracking, completion callback and wait with timeout. See vl53l7cx_async.h.
+ */
+
+#include <stddef.h>
+#include "vl53l7cx_async.h"
+
+/**
+ * @brief Move the current transfer to a final state and notify its owner
+ * @param p_engine: Pointer to engine
+ * @param state: Final state (DONE, ERROR or TIMEOUT)
+ */
+static void _vl53l7cx_async_finish(
+        VL53L7CX_AsyncEngine *p_engine,
+        uint8_t state)
+{
+    VL53L7CX_AsyncXfer *p_xfer = p_engine->p_current;
+
+    // Release the engine first, so the callback can chain a new transfer
+    p_engine->p_current = NULL;
+    p_xfer->complete_time_us = p_engine->p_ops->time_us(p_engine->p_ctx);
+    p_xfer->state = state;
+
+    if (p_xfer->callback) {
+        p_xfer->callback(p_xfer, p_xfer->p_user);
+    }
+}
+
+/**
+ * @brief Bind an engine to its bus
+ * @param p_engine: Pointer to engine
+ * @param p_ops: Bus operations
+ * @param p_ctx: Bus context, passed to every operation
+ */
+void vl53l7cx_async_init(
+        VL53L7CX_AsyncEngine *p_engine,
+        const VL53L7CX_AsyncBusOps *p_ops,
+        void *p_ctx)
+{
+    p_engine->p_ops = p_ops;
+    p_engine->p_ctx = p_ctx;
+    p_engine->p_current = NULL;
+}
+
+/**
+ * @brief Start a transfer in the background
+ * @param p_engine: Pointer to engine
+ * @param p_xfer: Transfer to run. Must stay valid until it completes.
+ * @return 0 if the transfer is running, non-zero if error (engine busy,
+ * invalid transfer or bus refused it)
+ */
+uint8_t vl53l7cx_async_submit(
+        VL53L7CX_AsyncEngine *p_engine,
+        VL53L7CX_AsyncXfer *p_xfer)
+{
+    if (!p_engine || !p_engine->p_ops || !p_xfer || !p_xfer->p_data || p_xfer->size == 0) {
+        return 255; // Error: invalid parameters
+    }
+
+    if (p_engine->p_current) {
+        return 255; // Error: a transfer is already in flight
+    }
+
+    p_xfer->state = VL53L7CX_ASYNC_BUSY;
+    p_xfer->submit_time_us = p_engine->p_ops->time_us(p_engine->p_ctx);
+    p_xfer->complete_time_us = 0;
+    p_engine->p_current = p_xfer;
+
+    if (p_engine->p_ops->start(p_engine->p_ctx, p_xfer) != 0) {
+        _vl53l7cx_async_finish(p_engine, VL53L7CX_ASYNC_ERROR);
+        return 255; // Error: bus refused the transfer
+    }
+
+    return 0;
+}
+
+/**
+ * @brief Advance the current transfer. Safe to call when idle.
+ * @param p_engine: Pointer to engine
+ * @return State of the current transfer, VL53L7CX_ASYNC_IDLE if none
+ */
+uint8_t vl53l7cx_async_poll(
+        VL53L7CX_AsyncEngine *p_engine)
+{
+    VL53L7CX_AsyncXfer *p_xfer = p_engine->p_current;
+    uint8_t state;
+
+    if (!p_xfer) {
+        return VL53L7CX_ASYNC_IDLE;
+    }
+
+    state = p_engine->p_ops->poll(p_engine->p_ctx, p_xfer);
+    if (state != VL53L7CX_ASYNC_BUSY) {
+        _vl53l7cx_async_finish(p_engine, state);
+    }
+
+    return state;
+}
+
+/**
+ * @brief Wait for the current transfer to complete
+ * @param p_engine: Pointer to engine
+ * @param timeout_us: Maximum time to wait, in microseconds
+ * @return 0 if the transfer completed or nothing was running, non-zero if it
+ * failed or timed out. A timed out transfer is aborted. A transfer which
+ * already ended (in vl53l7cx_async_poll()) is not running: its state field
+ * tells how it ended.
+ */
+uint8_t vl53l7cx_async_wait(
+        VL53L7CX_AsyncEngine *p_engine,
+        uint32_t timeout_us)
+{
+    VL53L7CX_AsyncXfer *p_xfer = p_engine->p_current;
+    uint64_t start_us;
+    uint8_t state;
+
+    if (!p_xfer) {
+        return 0; // Nothing in flight
+    }
+
+    start_us = p_engine->p_ops->time_us(p_engine->p_ctx);
+
+    while ((state = vl53l7cx_async_poll(p_engine)) == VL53L7CX_ASYNC_BUSY) {
+        if ((p_engine->p_ops->time_us(p_engine->p_ctx) - start_us) >= timeout_us) {
+            if (p_engine->p_ops->abort) {
+                p_engine->p_ops->abort(p_engine->p_ctx, p_xfer);
+            }
+            _vl53l7cx_async_finish(p_engine, VL53L7CX_ASYNC_TIMEOUT);
+            return 255; // Error: timeout
+        }
+
+        if (p_engine->p_ops->idle) {
+            p_engine->p_ops->idle(p_engine->p_ctx);
+        }
+    }
+
+    return (state == VL53L7CX_ASYNC_DONE) ? 0 : 255;
+}
+
+/**
+ * @brief Check if a transfer is in flight
+ * @param p_engine: Pointer to engine
+ * @return 1 if busy, 0 otherwise
+ */
+uint8_t vl53l7cx_async_is_busy(
+        VL53L7CX_AsyncEngine *p_engine)
+{
+    return (p_engine->p_current != NULL) ? 1 : 0;
+}
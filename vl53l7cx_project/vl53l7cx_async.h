@@ -0,0 +1,98 @@
+/**
+ * Asynchronous Transfer Engine for VL53L7CX Platform Layer
+ *
+ * This file provides a small, hardware independent state machine used to run
+ * I2C transfers in the background (DMA on the Pico 2). The bus itself is
+ * reached through a table of operations, so the same engine can be driven by
+ * the RP2350 DMA backend or by a simulated bus on a host machine.
+ */
+
+#ifndef _VL53L7CX_ASYNC_H_
+#define _VL53L7CX_ASYNC_H_
+
+#include <stdint.h>
+
+/**
+ * @brief Transfer states. A transfer is BUSY from submission until the bus
+ * reports completion, then DONE, ERROR or TIMEOUT.
+ */
+
+#define VL53L7CX_ASYNC_IDLE             ((uint8_t) 0U)
+#define VL53L7CX_ASYNC_BUSY             ((uint8_t) 1U)
+#define VL53L7CX_ASYNC_DONE             ((uint8_t) 2U)
+#define VL53L7CX_ASYNC_ERROR            ((uint8_t) 3U)
+#define VL53L7CX_ASYNC_TIMEOUT          ((uint8_t) 4U)
+
+/**
+ * @brief Transfer directions.
+ */
+
+#define VL53L7CX_ASYNC_READ             ((uint8_t) 0U)
+#define VL53L7CX_ASYNC_WRITE            ((uint8_t) 1U)
+
+struct VL53L7CX_AsyncXfer;
+
+/**
+ * @brief Completion callback, called once when a transfer leaves the BUSY
+ * state. It runs in the context that polled the engine (main loop, or an IRQ
+ * handler if the backend polls from there).
+ */
+
+typedef void (*VL53L7CX_AsyncCallback)(struct VL53L7CX_AsyncXfer *p_xfer, void *p_user);
+
+/**
+ * @brief Description of one register access (16-bit register address followed
+ * by a data phase).
+ */
+
+typedef struct VL53L7CX_AsyncXfer
+{
+    uint8_t            direction;       /* VL53L7CX_ASYNC_READ or _WRITE */
+    uint16_t           register_address;
+    uint8_t            *p_data;         /* Destination (read) or source (write) */
+    uint32_t           size;            /* Number of data bytes */
+    VL53L7CX_AsyncCallback callback;    /* Optional completion callback */
+    void               *p_user;         /* Passed back to the callback */
+
+    /* Filled by the engine */
+    volatile uint8_t   state;
+    uint64_t           submit_time_us;
+    uint64_t           complete_time_us;
+} VL53L7CX_AsyncXfer;
+
+/**
+ * @brief Bus operations used by the engine. start() must return 0 once the
+ * transfer has been queued, poll() returns VL53L7CX_ASYNC_BUSY while running,
+ * then VL53L7CX_ASYNC_DONE or VL53L7CX_ASYNC_ERROR. abort() and idle() are
+ * optional (idle() is called while waiting, e.g. to sleep until an interrupt).
+ */
+
+typedef struct
+{
+    uint8_t  (*start)(void *p_ctx, VL53L7CX_AsyncXfer *p_xfer);
+    uint8_t  (*poll)(void *p_ctx, VL53L7CX_AsyncXfer *p_xfer);
+    void     (*abort)(void *p_ctx, VL53L7CX_AsyncXfer *p_xfer);
+    uint64_t (*time_us)(void *p_ctx);
+    void     (*idle)(void *p_ctx);
+} VL53L7CX_AsyncBusOps;
+
+/**
+ * @brief Engine instance. Only one transfer can be in flight at a time, as
+ * there is only one sensor transaction on the bus at a time.
+ */
+
+typedef struct
+{
+    const VL53L7CX_AsyncBusOps *p_ops;
+    void               *p_ctx;
+    VL53L7CX_AsyncXfer *p_current;
+} VL53L7CX_AsyncEngine;
+
+/* Engine API */
+void vl53l7cx_async_init(VL53L7CX_AsyncEngine *p_engine, const VL53L7CX_AsyncBusOps *p_ops, void *p_ctx);
+uint8_t vl53l7cx_async_submit(VL53L7CX_AsyncEngine *p_engine, VL53L7CX_AsyncXfer *p_xfer);
+uint8_t vl53l7cx_async_poll(VL53L7CX_AsyncEngine *p_engine);
+uint8_t vl53l7cx_async_wait(VL53L7CX_AsyncEngine *p_engine, uint32_t timeout_us);
+uint8_t vl53l7cx_async_is_busy(VL53L7CX_AsyncEngine *p_engine);
+
+#endif /* _VL53L7CX_ASYNC_H_ */
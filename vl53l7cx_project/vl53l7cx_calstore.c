@@ -0,0 +1,267 @@
+/**
+ * Calibration Store Implementation for VL53L7CX Driver
+ *
+ * Record capture, checks and storage. See vl53l7cx_calstore.h.
+ */
+
+#include <stddef.h>
+#include <stdio.h>
+#include <string.h>
+#include "vl53l7cx_calstore.h"
+#include "vl53l7cx_plugin_xtalk.h"
+#include "vl53l7cx_stream.h"
+
+/**
+ * @brief Identity of a sensor: FNV-1a hash of its NVM offsets
+ * @param p_offset_data: Offsets (VL53L7CX_OFFSET_BUFFER_SIZE bytes)
+ * @return Identity
+ */
+static uint32_t _vl53l7cx_calstore_identity(
+        const uint8_t *p_offset_data)
+{
+    uint32_t hash = 0x811C9DC5U;
+    uint32_t i;
+
+    for (i = 0; i < VL53L7CX_OFFSET_BUFFER_SIZE; i++) {
+        hash ^= p_offset_data[i];
+        hash *= 0x01000193U;
+    }
+
+    return hash;
+}
+
+/**
+ * @brief Initialize a calibration store
+ * @param p_store: Pointer to store
+ * @param p_ops: Storage operations
+ * @param p_ctx: Operations context, passed to every operation
+ * @param nb_slots: Number of slots (one record each)
+ * @return 0 if OK, non-zero if error
+ */
+uint8_t vl53l7cx_calstore_init(
+        VL53L7CX_CalStore *p_store,
+        const VL53L7CX_CalStoreOps *p_ops,
+        void *p_ctx,
+        uint8_t nb_slots)
+{
+    if (!p_store || !p_ops || !p_ops->read || !p_ops->write || nb_slots == 0) {
+        return VL53L7CX_CALSTORE_ERROR; // Error: invalid parameters
+    }
+
+    p_store->p_ops = p_ops;
+    p_store->p_ctx = p_ctx;
+    p_store->nb_slots = nb_slots;
+
+    return VL53L7CX_CALSTORE_OK;
+}
+
+/**
+ * @brief Capture the calibration of an initialized sensor. The sensor must not
+ * be ranging (the Xtalk buffer is read back from the firmware).
+ * @param p_dev: Sensor, after vl53l7cx_init() and an optional
+ * vl53l7cx_calibrate_xtalk()
+ * @param p_record: Record to fill, ready to be saved
+ * @return 0 if OK, non-zero if error
+ */
+uint8_t vl53l7cx_calstore_capture(
+        VL53L7CX_Configuration *p_dev,
+        VL53L7CX_CalRecord *p_record)
+{
+    uint8_t status = VL53L7CX_STATUS_OK;
+
+    memset(p_record, 0, sizeof(VL53L7CX_CalRecord));
+    status |= vl53l7cx_get_caldata_offset(p_dev, p_record->offset_data);
+    status |= vl53l7cx_get_caldata_xtalk(p_dev, p_record->xtalk_data);
+    status |= vl53l7cx_get_xtalk_margin(p_dev, &p_record->xtalk_margin);
+    if (status != VL53L7CX_STATUS_OK) {
+        return VL53L7CX_CALSTORE_ERROR; // Error: sensor access
+    }
+
+    p_record->magic = VL53L7CX_CALSTORE_MAGIC;
+    p_record->version = VL53L7CX_CALSTORE_VERSION;
+    p_record->size = sizeof(VL53L7CX_CalRecord);
+    p_record->identity = _vl53l7cx_calstore_identity(p_record->offset_data);
+    p_record->crc = vl53l7cx_stream_crc32(0, (const uint8_t *)p_record,
+            offsetof(VL53L7CX_CalRecord, crc));
+
+    return VL53L7CX_CALSTORE_OK;
+}
+
+/**
+ * @brief Write a record into a slot
+ * @param p_store: Pointer to store
+ * @param slot: Slot index
+ * @param p_record: Record returned by vl53l7cx_calstore_capture()
+ * @return 0 if OK, non-zero if error
+ */
+uint8_t vl53l7cx_calstore_save(
+        VL53L7CX_CalStore *p_store,
+        uint8_t slot,
+        const VL53L7CX_CalRecord *p_record)
+{
+    if (slot >= p_store->nb_slots || p_record->magic != VL53L7CX_CALSTORE_MAGIC) {
+        return VL53L7CX_CALSTORE_ERROR; // Error: invalid slot or record not captured
+    }
+
+    if (p_store->p_ops->write(p_store->p_ctx, slot, (const uint8_t *)p_record,
+            sizeof(VL53L7CX_CalRecord))) {
+        return VL53L7CX_CALSTORE_ERROR; // Error: storage
+    }
+
+    return VL53L7CX_CALSTORE_OK;
+}
+
+/**
+ * @brief Read and check the record of a slot
+ * @param p_store: Pointer to store
+ * @param slot: Slot index
+ * @param p_record: Record read (only valid if VL53L7CX_CALSTORE_OK is returned)
+ * @return VL53L7CX_CALSTORE_OK, EMPTY, CORRUPTED, OLD_VERSION or ERROR
+ */
+uint8_t vl53l7cx_calstore_load(
+        VL53L7CX_CalStore *p_store,
+        uint8_t slot,
+        VL53L7CX_CalRecord *p_record)
+{
+    if (slot >= p_store->nb_slots) {
+        return VL53L7CX_CALSTORE_ERROR; // Error: invalid slot
+    }
+
+    if (p_store->p_ops->read(p_store->p_ctx, slot, (uint8_t *)p_record,
+            sizeof(VL53L7CX_CalRecord))) {
+        return VL53L7CX_CALSTORE_ERROR; // Error: storage
+    }
+
+    if (p_record->magic != VL53L7CX_CALSTORE_MAGIC) {
+        return VL53L7CX_CALSTORE_EMPTY;
+    }
+
+    if (p_record->version != VL53L7CX_CALSTORE_VERSION) {
+        return VL53L7CX_CALSTORE_OLD_VERSION;
+    }
+
+    if (p_record->size != sizeof(VL53L7CX_CalRecord)
+            || p_record->crc != vl53l7cx_stream_crc32(0, (const uint8_t *)p_record,
+                    offsetof(VL53L7CX_CalRecord, crc))) {
+        return VL53L7CX_CALSTORE_CORRUPTED;
+    }
+
+    return VL53L7CX_CALSTORE_OK;
+}
+
+/**
+ * @brief Send the calibration of a record to its sensor. The sensor must not
+ * be ranging. If VL53L7CX_CONST_CALIBRATION is defined, the driver keeps using
+ * the Xtalk buffer of the record: it must stay valid.
+ * @param p_dev: Sensor, after vl53l7cx_init()
+ * @param p_record: Record returned by vl53l7cx_calstore_load()
+ * @return VL53L7CX_CALSTORE_OK, OTHER_SENSOR (nothing sent) or ERROR
+ */
+uint8_t vl53l7cx_calstore_apply(
+        VL53L7CX_Configuration *p_dev,
+        const VL53L7CX_CalRecord *p_record)
+{
+    uint8_t offset_data[VL53L7CX_OFFSET_BUFFER_SIZE];
+    uint8_t status = VL53L7CX_STATUS_OK;
+
+    // Offsets are read from the NVM by vl53l7cx_init(): checking them is free
+    status |= vl53l7cx_get_caldata_offset(p_dev, offset_data);
+    if (status != VL53L7CX_STATUS_OK) {
+        return VL53L7CX_CALSTORE_ERROR; // Error: sensor access
+    }
+
+    if (_vl53l7cx_calstore_identity(offset_data) != p_record->identity
+            || memcmp(offset_data, p_record->offset_data, sizeof(offset_data)) != 0) {
+        return VL53L7CX_CALSTORE_OTHER_SENSOR;
+    }
+
+    status |= vl53l7cx_set_caldata_xtalk(p_dev, p_record->xtalk_data);
+    status |= vl53l7cx_set_xtalk_margin(p_dev, p_record->xtalk_margin);
+    if (status != VL53L7CX_STATUS_OK) {
+        return VL53L7CX_CALSTORE_ERROR; // Error: sensor access
+    }
+
+    return VL53L7CX_CALSTORE_OK;
+}
+
+/**
+ * @brief Read a slot of the store file. Missing data reads as erased flash.
+ */
+static uint8_t _vl53l7cx_calstore_file_read(
+        void *p_ctx,
+        uint8_t slot,
+        uint8_t *p_data,
+        uint32_t size)
+{
+    FILE *p_file = fopen((const char *)p_ctx, "rb");
+    size_t nb_read = 0;
+
+    if (p_file) {
+        if (fseek(p_file, (long)slot * (long)size, SEEK_SET) == 0) {
+            nb_read = fread(p_data, 1, size, p_file);
+        }
+        fclose(p_file);
+    }
+
+    memset(&p_data[nb_read], 0xFF, size - nb_read);
+
+    return 0;
+}
+
+/**
+ * @brief Write a slot of the store file, creating the file if needed
+ */
+static uint8_t _vl53l7cx_calstore_file_write(
+        void *p_ctx,
+        uint8_t slot,
+        const uint8_t *p_data,
+        uint32_t size)
+{
+    FILE *p_file = fopen((const char *)p_ctx, "r+b");
+    uint8_t status = 0;
+
+    if (!p_file) {
+        p_file = fopen((const char *)p_ctx, "w+b");
+        if (!p_file) {
+            return 255; // Error: file can't be created
+        }
+    }
+
+    if (fseek(p_file, (long)slot * (long)size, SEEK_SET) != 0
+            || fwrite(p_data, 1, size, p_file) != size
+            || fflush(p_file) != 0) {
+        status = 255; // Error: write failed
+    }
+
+    if (fclose(p_file) != 0) {
+        status = 255; // Error: write failed
+    }
+
+    return status;
+}
+
+static const VL53L7CX_CalStoreOps vl53l7cx_calstore_file_ops = {
+    .read = _vl53l7cx_calstore_file_read,
+    .write = _vl53l7cx_calstore_file_write,
+};
+
+/**
+ * @brief Initialize a calibration store kept in a file (host machine). Slot n
+ * is stored at offset n * sizeof(VL53L7CX_CalRecord).
+ * @param p_store: Pointer to store
+ * @param p_path: File path, must stay valid
+ * @param nb_slots: Number of slots
+ * @return 0 if OK, non-zero if error
+ */
+uint8_t vl53l7cx_calstore_init_file(
+        VL53L7CX_CalStore *p_store,
+        const char *p_path,
+        uint8_t nb_slots)
+{
+    if (!p_path) {
+        return VL53L7CX_CALSTORE_ERROR; // Error: invalid parameters
+    }
+
+    return vl53l7cx_calstore_init(p_store, &vl53l7cx_calstore_file_ops,
+            (void *)p_path, nb_slots);
+}
@@ -0,0 +1,102 @@
+/**
+ * Calibration Store for VL53L7CX Driver
+ *
+ * Keeps the calibration of a sensor across power cycles, so the Xtalk
+ * calibration (several seconds, with a target in front of the sensor) only
+ * runs once:
+ * - Capture: offsets (NVM), Xtalk buffer and Xtalk margin of an initialized
+ *   sensor are copied into a record, with the identity of the sensor.
+ * - Save / load: the record is written to / read from a storage slot. It is
+ *   versioned and protected by a CRC-32, so an erased, partially written or
+ *   outdated slot is never applied.
+ * - Apply: after vl53l7cx_init(), the record is checked against the identity
+ *   of the sensor, then its Xtalk buffer and margin are sent.
+ *
+ * The identity is a hash of the factory offsets read from the sensor NVM,
+ * which are unique to each sensor: a record saved for another sensor (module
+ * swapped, slots mixed up) is rejected.
+ *
+ * Storage is reached through a table of operations: a flash sector per slot on
+ * the Pico 2 (see VL53L7CX_CalStoreInitPico() in platform_pico.c), or a file
+ * on a host machine (see vl53l7cx_calstore_init_file()).
+ */
+
+#ifndef _VL53L7CX_CALSTORE_H_
+#define _VL53L7CX_CALSTORE_H_
+
+#include <stdint.h>
+#include "vl53l7cx_api.h"
+
+/**
+ * @brief Record format. VL53L7CX_CALSTORE_VERSION must be incremented each
+ * time VL53L7CX_CalRecord changes.
+ */
+
+#define VL53L7CX_CALSTORE_MAGIC         0x53433737U     /* "77CS" */
+#define VL53L7CX_CALSTORE_VERSION       1U
+
+/**
+ * @brief Calibration store status.
+ */
+
+#define VL53L7CX_CALSTORE_OK            ((uint8_t) 0U)
+#define VL53L7CX_CALSTORE_EMPTY         ((uint8_t) 1U)  /* No record (erased slot) */
+#define VL53L7CX_CALSTORE_CORRUPTED     ((uint8_t) 2U)  /* Bad CRC or size */
+#define VL53L7CX_CALSTORE_OLD_VERSION   ((uint8_t) 3U)  /* Record from another format */
+#define VL53L7CX_CALSTORE_OTHER_SENSOR  ((uint8_t) 4U)  /* Identity mismatch */
+#define VL53L7CX_CALSTORE_ERROR         ((uint8_t) 255U) /* Storage or sensor error */
+
+/**
+ * @brief Calibration record, as stored. The CRC-32 covers every byte before
+ * it.
+ */
+
+typedef struct
+{
+    uint32_t           magic;
+    uint16_t           version;
+    uint16_t           size;           /* sizeof(VL53L7CX_CalRecord) */
+    uint32_t           identity;       /* Hash of the sensor NVM offsets */
+    uint32_t           xtalk_margin;   /* kcps/spads */
+    uint8_t            offset_data[VL53L7CX_OFFSET_BUFFER_SIZE];
+    uint8_t            xtalk_data[VL53L7CX_XTALK_BUFFER_SIZE];
+    uint32_t           crc;
+} VL53L7CX_CalRecord;
+
+/**
+ * @brief Storage operations. A slot holds one record. write() replaces the
+ * whole slot content (erase included).
+ */
+
+typedef struct
+{
+    uint8_t  (*read)(void *p_ctx, uint8_t slot, uint8_t *p_data, uint32_t size);
+    uint8_t  (*write)(void *p_ctx, uint8_t slot, const uint8_t *p_data, uint32_t size);
+} VL53L7CX_CalStoreOps;
+
+/**
+ * @brief Calibration store instance.
+ */
+
+typedef struct
+{
+    const VL53L7CX_CalStoreOps *p_ops;
+    void               *p_ctx;
+    uint8_t            nb_slots;
+} VL53L7CX_CalStore;
+
+/* Setup */
+uint8_t vl53l7cx_calstore_init(VL53L7CX_CalStore *p_store, const VL53L7CX_CalStoreOps *p_ops,
+        void *p_ctx, uint8_t nb_slots);
+uint8_t vl53l7cx_calstore_init_file(VL53L7CX_CalStore *p_store, const char *p_path, uint8_t nb_slots);
+
+/* Records */
+uint8_t vl53l7cx_calstore_capture(VL53L7CX_Configuration *p_dev, VL53L7CX_CalRecord *p_record);
+uint8_t vl53l7cx_calstore_save(VL53L7CX_CalStore *p_store, uint8_t slot, const VL53L7CX_CalRecord *p_record);
+uint8_t vl53l7cx_calstore_load(VL53L7CX_CalStore *p_store, uint8_t slot, VL53L7CX_CalRecord *p_record);
+uint8_t vl53l7cx_calstore_apply(VL53L7CX_Configuration *p_dev, const VL53L7CX_CalRecord *p_record);
+
+/* Platform calibration store (platform_pico.c) */
+uint8_t VL53L7CX_CalStoreInitPico(VL53L7CX_CalStore *p_store, uint8_t nb_slots);
+
+#endif /* _VL53L7CX_CALSTORE_H_ */
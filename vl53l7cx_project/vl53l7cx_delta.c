@@ -0,0 +1,131 @@
+/**
+ * Inter-frame Delta Coding Implementation for VL53L7CX Driver
+ *
+ * Token coding and decoding. See vl53l7cx_delta.h.
+ */
+
+#include "vl53l7cx_delta.h"
+
+#define VL53L7CX_DELTA_RUN              0x80U
+#define VL53L7CX_DELTA_WIDE             0x40U
+#define VL53L7CX_DELTA_MAX_RUN          128U
+
+/**
+ * @brief Code values against a reference
+ * @param p_values: Values of the new frame
+ * @param p_reference: Values of the previous frame
+ * @param count: Number of values
+ * @param p_out: Coded tokens
+ * @param out_size: Output capacity. The caller can give the raw size (2 bytes
+ * per value) and send the values as is when coding does not fit.
+ * @return Coded size, 0 if it does not fit into out_size
+ */
+uint32_t vl53l7cx_delta_encode(
+        const int16_t *p_values,
+        const int16_t *p_reference,
+        uint32_t count,
+        uint8_t *p_out,
+        uint32_t out_size)
+{
+    uint32_t i = 0, pos = 0, run, zz;
+    int32_t delta;
+
+    while (i < count) {
+        // Run of unchanged values
+        run = 0;
+        while (i + run < count && run < VL53L7CX_DELTA_MAX_RUN
+                && p_values[i + run] == p_reference[i + run]) {
+            run++;
+        }
+        if (run > 0U) {
+            if (pos + 1U > out_size) {
+                return 0; // Error: output too small
+            }
+            p_out[pos++] = (uint8_t)(VL53L7CX_DELTA_RUN | (run - 1U));
+            i += run;
+            continue;
+        }
+
+        delta = (int32_t)p_values[i] - (int32_t)p_reference[i];
+        zz = (delta >= 0) ? ((uint32_t)delta << 1) : (((uint32_t)(-delta) << 1) - 1U);
+
+        if (zz < 0x40U) {
+            if (pos + 1U > out_size) {
+                return 0; // Error: output too small
+            }
+            p_out[pos++] = (uint8_t)zz;
+        } else if (zz < 0x4000U) {
+            if (pos + 2U > out_size) {
+                return 0; // Error: output too small
+            }
+            p_out[pos++] = (uint8_t)(VL53L7CX_DELTA_WIDE | (zz >> 8));
+            p_out[pos++] = (uint8_t)zz;
+        } else {
+            if (pos + 3U > out_size) {
+                return 0; // Error: output too small
+            }
+            p_out[pos++] = 0x00;
+            p_out[pos++] = (uint8_t)p_values[i];
+            p_out[pos++] = (uint8_t)((uint16_t)p_values[i] >> 8);
+        }
+        i++;
+    }
+
+    return pos;
+}
+
+/**
+ * @brief Apply coded tokens to the reference
+ * @param p_in: Coded tokens
+ * @param in_size: Bytes available (may go past the tokens)
+ * @param p_values: Reference values, replaced by the new frame
+ * @param count: Number of values
+ * @return Bytes used, 0 if the tokens are invalid
+ */
+uint32_t vl53l7cx_delta_decode(
+        const uint8_t *p_in,
+        uint32_t in_size,
+        int16_t *p_values,
+        uint32_t count)
+{
+    uint32_t i = 0, pos = 0, zz;
+    uint8_t token;
+
+    while (i < count) {
+        if (pos >= in_size) {
+            return 0; // Error: tokens truncated
+        }
+        token = p_in[pos++];
+
+        if (token & VL53L7CX_DELTA_RUN) {
+            i += (uint32_t)(token & 0x7FU) + 1U;
+            if (i > count) {
+                return 0; // Error: run past the last value
+            }
+            continue;
+        }
+
+        if (token == 0x00U) {
+            if (pos + 2U > in_size) {
+                return 0; // Error: tokens truncated
+            }
+            p_values[i++] = (int16_t)((uint16_t)p_in[pos] | ((uint16_t)p_in[pos + 1U] << 8));
+            pos += 2U;
+            continue;
+        }
+
+        zz = token;
+        if (token & VL53L7CX_DELTA_WIDE) {
+            if (pos >= in_size) {
+                return 0; // Error: tokens truncated
+            }
+            zz = ((uint32_t)(token & 0x3FU) << 8) | p_in[pos++];
+        }
+        p_values[i] = (int16_t)((zz & 1U)
+                ? (int32_t)p_values[i] - (int32_t)((zz + 1U) >> 1)
+                : (int32_t)p_values[i] + (int32_t)(zz >> 1));
+        i++;
+    }
+
+    return pos;
+}
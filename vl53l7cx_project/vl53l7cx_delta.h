@@ -0,0 +1,36 @@
+/**
+ * Inter-frame Delta Coding for VL53L7CX Driver
+ *
+ * In a static scene most zones only move by a few mm between frames. A frame
+ * is coded against the previous one (the reference) as a sequence of tokens,
+ * one per changed value or per run of unchanged values:
+ *
+ *   1rrrrrrr              r + 1 unchanged values (1 to 128)
+ *   00zzzzzz              change of zigzag(delta) = z, 1 to 63 (-32 to +31)
+ *   01zzzzzz zzzzzzzz     change of zigzag(delta) = z, 14 bits (-8192 to +8191)
+ *   00000000 llllllll hhhhhhhh
+ *                         new value, int16 little-endian (any other change)
+ *
+ * zigzag(d) = 2d for d >= 0, -2d - 1 for d < 0. The token sequence covers
+ * exactly the number of values of the frame, so its size needs not be sent.
+ *
+ * This module only depends on stdint.h: host tools build it as is.
+ */
+
+#ifndef _VL53L7CX_DELTA_H_
+#define _VL53L7CX_DELTA_H_
+
+#include <stdint.h>
+
+/**
+ * @brief Largest coded size of count values (3 bytes each: new values).
+ */
+
+#define VL53L7CX_DELTA_MAX_SIZE(count)  (3U * (count))
+
+uint32_t vl53l7cx_delta_encode(const int16_t *p_values, const int16_t *p_reference,
+        uint32_t count, uint8_t *p_out, uint32_t out_size);
+uint32_t vl53l7cx_delta_decode(const uint8_t *p_in, uint32_t in_size, int16_t *p_values,
+        uint32_t count);
+
+#endif /* _VL53L7CX_DELTA_H_ */
@@ -0,0 +1,157 @@
+/**
+ * Event-Driven Frame Acquisition Implementation for VL53L7CX Driver
+ *
+ * Event queue, event source wait and the acquisition step used in place of
+ * the vl53l7cx_check_data_ready() polling loop. See vl53l7cx_events.h.
+ */
+
+#include <stddef.h>
+#include "vl53l7cx_events.h"
+
+/**
+ * @brief Reset an event queue
+ * @param p_queue: Pointer to queue
+ */
+void vl53l7cx_event_queue_init(
+        VL53L7CX_EventQueue *p_queue)
+{
+    p_queue->head = 0;
+    p_queue->tail = 0;
+    p_queue->dropped = 0;
+}
+
+/**
+ * @brief Push an event (producer side, interrupt safe)
+ * @param p_queue: Pointer to queue
+ * @param type: Event type
+ * @param timestamp_us: Time of the event
+ * @return 0 if OK, non-zero if the queue was full (event dropped)
+ */
+uint8_t vl53l7cx_event_push(
+        VL53L7CX_EventQueue *p_queue,
+        uint8_t type,
+        uint64_t timestamp_us)
+{
+    uint32_t head = p_queue->head;
+    uint32_t tail = __atomic_load_n(&p_queue->tail, __ATOMIC_ACQUIRE);
+    VL53L7CX_Event *p_event;
+
+    if ((head - tail) >= VL53L7CX_EVENT_QUEUE_SIZE) {
+        p_queue->dropped++;
+        return 255; // Error: queue full
+    }
+
+    p_event = &p_queue->events[head & (VL53L7CX_EVENT_QUEUE_SIZE - 1U)];
+    p_event->type = type;
+    p_event->timestamp_us = timestamp_us;
+
+    // Publish the event after its content
+    __atomic_store_n(&p_queue->head, head + 1U, __ATOMIC_RELEASE);
+
+    return 0;
+}
+
+/**
+ * @brief Pop the oldest event (consumer side)
+ * @param p_queue: Pointer to queue
+ * @param p_event: Pointer to store the event
+ * @return 0 if an event was popped, non-zero if the queue is empty
+ */
+uint8_t vl53l7cx_event_pop(
+        VL53L7CX_EventQueue *p_queue,
+        VL53L7CX_Event *p_event)
+{
+    uint32_t tail = p_queue->tail;
+    uint32_t head = __atomic_load_n(&p_queue->head, __ATOMIC_ACQUIRE);
+
+    if (head == tail) {
+        return 1; // Queue empty
+    }
+
+    *p_event = p_queue->events[tail & (VL53L7CX_EVENT_QUEUE_SIZE - 1U)];
+    __atomic_store_n(&p_queue->tail, tail + 1U, __ATOMIC_RELEASE);
+
+    return 0;
+}
+
+/**
+ * @brief Initialize an event source
+ * @param p_source: Pointer to event source
+ * @param p_ops: Source operations
+ * @param p_ctx: Source context, passed to every operation
+ */
+void vl53l7cx_event_source_init(
+        VL53L7CX_EventSource *p_source,
+        const VL53L7CX_EventSourceOps *p_ops,
+        void *p_ctx)
+{
+    vl53l7cx_event_queue_init(&p_source->queue);
+    p_source->p_ops = p_ops;
+    p_source->p_ctx = p_ctx;
+}
+
+/**
+ * @brief Wait for the next event
+ * @param p_source: Pointer to event source
+ * @param p_event: Pointer to store the event
+ * @param timeout_ms: Maximum time to wait in milliseconds
+ * @return 0 if an event was received, non-zero on timeout
+ */
+uint8_t vl53l7cx_event_wait(
+        VL53L7CX_EventSource *p_source,
+        VL53L7CX_Event *p_event,
+        uint32_t timeout_ms)
+{
+    uint64_t start_us = p_source->p_ops->time_us(p_source->p_ctx);
+    uint64_t timeout_us = (uint64_t)timeout_ms * 1000U;
+    uint64_t elapsed_us;
+
+    while (vl53l7cx_event_pop(&p_source->queue, p_event) != 0) {
+        elapsed_us = p_source->p_ops->time_us(p_source->p_ctx) - start_us;
+        if (elapsed_us >= timeout_us) {
+            return 1; // Timeout
+        }
+        p_source->p_ops->wait(p_source->p_ctx, (uint32_t)(timeout_us - elapsed_us));
+    }
+
+    return 0;
+}
+
+/**
+ * @brief Wait for the sensor to signal a new frame, read it and hand it on
+ * @param p_dev: VL53L7CX configuration structure (ranging started)
+ * @param p_source: Event source fed by the sensor INT pin
+ * @param p_results: Results structure to fill
+ * @param timeout_ms: Maximum time to wait for a frame in milliseconds
+ * @param handler: Optional callback receiving each valid frame
+ * @param p_user: Passed back to the handler
+ * @return VL53L7CX_STATUS_OK if a frame was read, VL53L7CX_STATUS_TIMEOUT_ERROR
+ * if no event arrived in time, or the vl53l7cx_get_ranging_data() status
+ */
+uint8_t vl53l7cx_events_acquire(
+        VL53L7CX_Configuration *p_dev,
+        VL53L7CX_EventSource *p_source,
+        VL53L7CX_ResultsData *p_results,
+        uint32_t timeout_ms,
+        VL53L7CX_FrameHandler handler,
+        void *p_user)
+{
+    VL53L7CX_Event event, newer;
+    uint8_t status;
+
+    if (vl53l7cx_event_wait(p_source, &event, timeout_ms) != 0) {
+        return VL53L7CX_STATUS_TIMEOUT_ERROR;
+    }
+
+    // The sensor only holds the latest frame: collapse any backlog
+    while (vl53l7cx_event_pop(&p_source->queue, &newer) == 0) {
+        event = newer;
+    }
+
+    status = vl53l7cx_get_ranging_data(p_dev, p_results);
+    if (status == VL53L7CX_STATUS_OK && handler) {
+        handler(p_dev, p_results, event.timestamp_us, p_user);
+    }
+
+    return status;
+}
@@ -0,0 +1,101 @@
+/**
+ * Event-Driven Frame Acquisition for VL53L7CX Driver
+ *
+ * The VL53L7CX pulls its INT pin low when a new frame is ready. Instead of
+ * polling vl53l7cx_check_data_ready() over I2C, the interrupt handler pushes an
+ * event into a small queue and the reader sleeps until an event arrives.
+ *
+ * The event source is an interface: the Pico 2 implementation is fed by a GPIO
+ * interrupt (see VL53L7CX_EventSourceInitGpio() in platform_pico.c), and a
+ * simulated source can feed the same queue on a host machine.
+ */
+
+#ifndef _VL53L7CX_EVENTS_H_
+#define _VL53L7CX_EVENTS_H_
+
+#include <stdint.h>
+#include "vl53l7cx_api.h"
+
+/**
+ * @brief Number of pending events kept by a queue. Must be a power of 2.
+ */
+
+#define VL53L7CX_EVENT_QUEUE_SIZE       8U
+
+/**
+ * @brief Event types.
+ */
+
+#define VL53L7CX_EVENT_DATA_READY       ((uint8_t) 1U)
+
+/**
+ * @brief One event, timestamped by the producer (interrupt time).
+ */
+
+typedef struct
+{
+    uint8_t            type;
+    uint64_t           timestamp_us;
+} VL53L7CX_Event;
+
+/**
+ * @brief Single-producer (interrupt) / single-consumer (reader) queue.
+ * head is only written by the producer, tail only by the consumer.
+ */
+
+typedef struct
+{
+    VL53L7CX_Event     events[VL53L7CX_EVENT_QUEUE_SIZE];
+    volatile uint32_t  head;
+    volatile uint32_t  tail;
+    volatile uint32_t  dropped;        /* Events lost because the queue was full */
+} VL53L7CX_EventQueue;
+
+/**
+ * @brief Event source operations. wait() blocks until an event may have been
+ * pushed or timeout_us elapsed (spurious returns are allowed). time_us()
+ * returns the clock used to timestamp events.
+ */
+
+typedef struct
+{
+    void     (*wait)(void *p_ctx, uint32_t timeout_us);
+    uint64_t (*time_us)(void *p_ctx);
+} VL53L7CX_EventSourceOps;
+
+/**
+ * @brief Event source: a queue and the operations used to wait on it.
+ */
+
+typedef struct
+{
+    VL53L7CX_EventQueue queue;
+    const VL53L7CX_EventSourceOps *p_ops;
+    void               *p_ctx;
+} VL53L7CX_EventSource;
+
+/**
+ * @brief Called for each acquired frame by vl53l7cx_events_acquire().
+ */
+
+typedef void (*VL53L7CX_FrameHandler)(VL53L7CX_Configuration *p_dev,
+        VL53L7CX_ResultsData *p_results, uint64_t timestamp_us, void *p_user);
+
+/* Queue API (vl53l7cx_event_push may be called from an interrupt handler) */
+void vl53l7cx_event_queue_init(VL53L7CX_EventQueue *p_queue);
+uint8_t vl53l7cx_event_push(VL53L7CX_EventQueue *p_queue, uint8_t type, uint64_t timestamp_us);
+uint8_t vl53l7cx_event_pop(VL53L7CX_EventQueue *p_queue, VL53L7CX_Event *p_event);
+
+/* Source API */
+void vl53l7cx_event_source_init(VL53L7CX_EventSource *p_source, const VL53L7CX_EventSourceOps *p_ops, void *p_ctx);
+uint8_t vl53l7cx_event_wait(VL53L7CX_EventSource *p_source, VL53L7CX_Event *p_event, uint32_t timeout_ms);
+
+/* Platform event sources (platform_pico.c) */
+uint8_t VL53L7CX_EventSourceInitGpio(VL53L7CX_EventSource *p_source, uint8_t int_pin);
+
+/* Acquisition */
+uint8_t vl53l7cx_events_acquire(VL53L7CX_Configuration *p_dev, VL53L7CX_EventSource *p_source,
+        VL53L7CX_ResultsData *p_results, uint32_t timeout_ms,
+        VL53L7CX_FrameHandler handler, void *p_user);
+
+#endif /* _VL53L7CX_EVENTS_H_ */
@@ -0,0 +1,376 @@
+/**
+ * Temporal Filter Implementation for VL53L7CX Driver
+ *
+ * See vl53l7cx_filter.h.
+ */
+
+#include <stddef.h>
+#include "vl53l7cx_filter.h"
+
+/* Fractional bits of the estimates */
+#define FILTER_FRAC         4
+
+/* Kalman measurement sigma when the sensor does not report it (mm) */
+#define FILTER_SIGMA_MM     10U
+
+#ifdef VL53L7CX_USE_RAW_FORMAT
+#define FILTER_UNITS_PER_MM 4U  /* Quarter mm */
+#else
+#define FILTER_UNITS_PER_MM 1U
+#endif
+
+/**
+ * @brief Restart the state of a target
+ */
+static void filter_restart(
+        VL53L7CX_FilterState *p_state)
+{
+    p_state->count = 0;
+    p_state->next = 0;
+}
+
+/**
+ * @brief Measurement variance of a target (distance unit^2)
+ */
+static uint32_t filter_measurement_variance(
+        const VL53L7CX_ResultsData *p_results,
+        uint16_t i)
+{
+    uint32_t variance;
+
+#ifndef VL53L7CX_DISABLE_RANGE_SIGMA_MM
+    uint32_t sigma = p_results->range_sigma_mm[i];
+#ifdef VL53L7CX_USE_RAW_FORMAT
+    // sigma is in 1/128 mm, the distance in 1/4 mm: (sigma / 32)^2
+    variance = (sigma * sigma) >> 10;
+#else
+    variance = sigma * sigma;
+#endif
+#else
+    (void)p_results;
+    (void)i;
+    variance = (FILTER_SIGMA_MM * FILTER_UNITS_PER_MM) * (FILTER_SIGMA_MM * FILTER_UNITS_PER_MM);
+#endif
+
+    return (variance != 0U) ? variance : 1U;
+}
+
+/**
+ * @brief Median of the last distances of a target
+ */
+static int16_t filter_median(
+        const VL53L7CX_Filter *p_filter,
+        VL53L7CX_FilterState *p_state,
+        int16_t distance)
+{
+    int16_t median = distance;
+    uint8_t n, i, j;
+
+    p_state->history[p_state->next] = distance;
+    p_state->next = (uint8_t)((p_state->next + 1U) % p_filter->median_size);
+    n = (p_state->count < p_filter->median_size) ? (uint8_t)(p_state->count + 1U)
+            : p_filter->median_size;
+
+    // Rank of each distance (ties broken by position), no data dependent
+    // branch: noisy distances would defeat the branch predictor of a sort
+    for (i = 0; i < n; i++) {
+        int16_t value = p_state->history[i];
+        uint8_t rank = 0;
+
+        for (j = 0; j < n; j++) {
+            rank = (uint8_t)(rank + (p_state->history[j] < value)
+                    + ((p_state->history[j] == value) & (j < i)));
+        }
+        median = (rank == n / 2U) ? value : median;
+    }
+
+    return median;
+}
+
+/**
+ * @brief Exponential moving average of a target
+ */
+static int16_t filter_exponential(
+        const VL53L7CX_Filter *p_filter,
+        VL53L7CX_FilterState *p_state,
+        int16_t distance)
+{
+    int32_t measured = (int32_t)distance * (1 << FILTER_FRAC);
+
+    if (p_state->count == 0U) {
+        p_state->estimate = measured;
+    } else {
+        p_state->estimate += ((int32_t)p_filter->alpha_q8 * (measured - p_state->estimate) + 128)
+                >> 8;
+    }
+
+    return (int16_t)((p_state->estimate + (1 << (FILTER_FRAC - 1))) >> FILTER_FRAC);
+}
+
+/**
+ * @brief 1D Kalman filter of a target, constant position model
+ */
+static int16_t filter_kalman(
+        VL53L7CX_Filter *p_filter,
+        VL53L7CX_FilterState *p_state,
+        int16_t distance,
+        uint32_t measurement_variance)
+{
+    int32_t measured = (int32_t)distance * (1 << FILTER_FRAC);
+    int32_t innovation;
+    uint64_t predicted, total;
+    uint32_t gain;
+    uint8_t shift = 0;
+
+    if (p_state->count == 0U) {
+        p_state->estimate = measured;
+        p_state->variance = measurement_variance;
+        p_state->rejected = 0;
+        return distance;
+    }
+
+    predicted = (uint64_t)p_state->variance + p_filter->process_noise;
+    total = predicted + measurement_variance;
+    innovation = measured - p_state->estimate;
+
+    // Beyond gate_sigma sigmas: a spike is ignored once, a second distance
+    // far from the estimate is another target, restart on it
+    if (p_filter->gate_sigma != 0U
+            && (uint64_t)((int64_t)innovation * innovation)
+            > (uint64_t)p_filter->gate_sigma * p_filter->gate_sigma * total
+            * (1U << (2 * FILTER_FRAC))) {
+        if (p_state->rejected == 0U) {
+            p_state->rejected = 1;
+            return (int16_t)((p_state->estimate + (1 << (FILTER_FRAC - 1))) >> FILTER_FRAC);
+        }
+        p_filter->restarts++;
+        p_state->rejected = 0;
+        p_state->estimate = measured;
+        p_state->variance = measurement_variance;
+        return distance;
+    }
+    p_state->rejected = 0;
+
+    // Gain in Q15, operands scaled to 16 bits for a 32-bit division
+    if (total > 0xFFFFU) {
+        shift = (uint8_t)(48 - __builtin_clzll(total));
+    }
+    gain = ((uint32_t)(predicted >> shift) << 15) / (uint32_t)(total >> shift);
+
+    p_state->estimate += (int32_t)(((int64_t)gain * innovation + (1 << 14)) >> 15);
+    p_state->variance = (uint32_t)((predicted * (32768U - gain) + (1U << 14)) >> 15);
+    if (p_state->variance == 0U) {
+        p_state->variance = 1U;
+    }
+
+    return (int16_t)((p_state->estimate + (1 << (FILTER_FRAC - 1))) >> FILTER_FRAC);
+}
+
+/**
+ * @brief Initialize a filter: every zone runs the same filter, default
+ * parameters
+ * @param p_filter: Pointer to filter
+ * @param mode: VL53L7CX_FILTER_xxx of every zone
+ */
+void vl53l7cx_filter_init(
+        VL53L7CX_Filter *p_filter,
+        uint8_t mode)
+{
+    uint8_t zone;
+
+    for (zone = 0; zone < 64U; zone++) {
+        p_filter->mode[zone] = mode;
+    }
+    p_filter->status_mask = VL53L7CX_FILTER_DEFAULT_STATUS_MASK;
+    p_filter->median_size = VL53L7CX_FILTER_DEFAULT_MEDIAN_SIZE;
+    p_filter->alpha_q8 = VL53L7CX_FILTER_DEFAULT_ALPHA_Q8;
+    (void)vl53l7cx_filter_set_kalman(p_filter, VL53L7CX_FILTER_DEFAULT_PROCESS_MM2,
+            VL53L7CX_FILTER_DEFAULT_GATE_SIGMA);
+    p_filter->resolution = 0;
+    p_filter->restarts = 0;
+    vl53l7cx_filter_reset(p_filter);
+}
+
+/**
+ * @brief Set the filter of one zone, and restart it
+ * @param p_filter: Pointer to filter
+ * @param zone: Zone index (0 to 63)
+ * @param mode: VL53L7CX_FILTER_xxx
+ * @return (uint8_t) status: 0 if OK, 255 for an invalid zone or mode
+ */
+uint8_t vl53l7cx_filter_set_zone_mode(
+        VL53L7CX_Filter *p_filter,
+        uint8_t zone,
+        uint8_t mode)
+{
+    uint32_t target;
+
+    if (zone >= 64U || mode > VL53L7CX_FILTER_KALMAN) {
+        return 255;
+    }
+
+    p_filter->mode[zone] = mode;
+    for (target = 0; target < VL53L7CX_NB_TARGET_PER_ZONE; target++) {
+        filter_restart(&p_filter->state[zone * VL53L7CX_NB_TARGET_PER_ZONE + target]);
+    }
+    return 0;
+}
+
+/**
+ * @brief Set the median window, and restart every zone
+ * @param p_filter: Pointer to filter
+ * @param size: Number of distances (1 to VL53L7CX_FILTER_MEDIAN_MAX)
+ * @return (uint8_t) status: 0 if OK, 255 for an invalid size
+ */
+uint8_t vl53l7cx_filter_set_median(
+        VL53L7CX_Filter *p_filter,
+        uint8_t size)
+{
+    if (size == 0U || size > VL53L7CX_FILTER_MEDIAN_MAX) {
+        return 255;
+    }
+
+    p_filter->median_size = size;
+    vl53l7cx_filter_reset(p_filter);
+    return 0;
+}
+
+/**
+ * @brief Set the weight of the new distance of the exponential filter
+ * @param p_filter: Pointer to filter
+ * @param alpha_q8: Weight in 1/256 (1 to 256, 256 disables the filter)
+ * @return (uint8_t) status: 0 if OK, 255 for an invalid weight
+ */
+uint8_t vl53l7cx_filter_set_exponential(
+        VL53L7CX_Filter *p_filter,
+        uint16_t alpha_q8)
+{
+    if (alpha_q8 == 0U || alpha_q8 > 256U) {
+        return 255;
+    }
+
+    p_filter->alpha_q8 = alpha_q8;
+    return 0;
+}
+
+/**
+ * @brief Set the Kalman filter parameters
+ * @param p_filter: Pointer to filter
+ * @param process_mm2: Variance added to the estimate at each frame (mm^2):
+ * higher follows moving targets faster, lower smooths more
+ * @param gate_sigma: Distance from the estimate, in sigmas, beyond which a
+ * distance is ignored, or restarts the zone if the previous one was also
+ * ignored (0: never)
+ * @return (uint8_t) status: 0 if OK, 255 if process_mm2 is too large
+ */
+uint8_t vl53l7cx_filter_set_kalman(
+        VL53L7CX_Filter *p_filter,
+        uint32_t process_mm2,
+        uint8_t gate_sigma)
+{
+    if (process_mm2 > (0xFFFFFFFFUL / (FILTER_UNITS_PER_MM * FILTER_UNITS_PER_MM))) {
+        return 255;
+    }
+
+    p_filter->process_noise = process_mm2 * FILTER_UNITS_PER_MM * FILTER_UNITS_PER_MM;
+    p_filter->gate_sigma = gate_sigma;
+    return 0;
+}
+
+/**
+ * @brief Set the accepted target status
+ * @param p_filter: Pointer to filter
+ * @param status_mask: Bit n accepts target_status n
+ */
+void vl53l7cx_filter_set_status_mask(
+        VL53L7CX_Filter *p_filter,
+        uint32_t status_mask)
+{
+    p_filter->status_mask = status_mask;
+}
+
+/**
+ * @brief Restart every zone
+ * @param p_filter: Pointer to filter
+ */
+void vl53l7cx_filter_reset(
+        VL53L7CX_Filter *p_filter)
+{
+    uint16_t i;
+
+    for (i = 0; i < (uint16_t)(64U * VL53L7CX_NB_TARGET_PER_ZONE); i++) {
+        filter_restart(&p_filter->state[i]);
+    }
+}
+
+/**
+ * @brief Filter the distances of a frame in place
+ * @param p_filter: Pointer to filter
+ * @param p_results: Results of the frame, distance_mm is replaced
+ * @param resolution: Resolution of the frame (VL53L7CX_RESOLUTION_4X4 or
+ * VL53L7CX_RESOLUTION_8X8)
+ * @return (uint8_t) status: 0 if OK, 255 if the resolution is not supported
+ */
+uint8_t vl53l7cx_filter_apply(
+        VL53L7CX_Filter *p_filter,
+        VL53L7CX_ResultsData *p_results,
+        uint8_t resolution)
+{
+    uint8_t zone;
+    uint32_t target;
+
+    if (resolution != VL53L7CX_RESOLUTION_4X4 && resolution != VL53L7CX_RESOLUTION_8X8) {
+        return 255;
+    }
+    if (resolution != p_filter->resolution) {
+        vl53l7cx_filter_reset(p_filter);
+        p_filter->resolution = resolution;
+    }
+
+    for (zone = 0; zone < resolution; zone++) {
+        uint8_t mode = p_filter->mode[zone];
+
+        for (target = 0; target < VL53L7CX_NB_TARGET_PER_ZONE; target++) {
+            uint16_t i = (uint16_t)(zone * VL53L7CX_NB_TARGET_PER_ZONE + target);
+            VL53L7CX_FilterState *p_state = &p_filter->state[i];
+            int16_t distance = p_results->distance_mm[i];
+            uint8_t valid = 1;
+
+#ifndef VL53L7CX_DISABLE_NB_TARGET_DETECTED
+            valid = (uint8_t)(target < p_results->nb_target_detected[zone]);
+#endif
+#ifndef VL53L7CX_DISABLE_TARGET_STATUS
+            if (p_results->target_status[i] >= 32U
+                    || ((p_filter->status_mask >> p_results->target_status[i]) & 1U) == 0U) {
+                valid = 0;
+            }
+#endif
+            if (!valid || mode == VL53L7CX_FILTER_NONE) {
+                if (p_state->count != 0U) {
+                    p_filter->restarts += valid ? 0U : 1U;
+                    filter_restart(p_state);
+                }
+                continue;
+            }
+
+            switch (mode) {
+                case VL53L7CX_FILTER_MEDIAN:
+                    distance = filter_median(p_filter, p_state, distance);
+                    break;
+                case VL53L7CX_FILTER_EXPONENTIAL:
+                    distance = filter_exponential(p_filter, p_state, distance);
+                    break;
+                default:
+                    distance = filter_kalman(p_filter, p_state, distance,
+                            filter_measurement_variance(p_results, i));
+                    break;
+            }
+            if (p_state->count < 255U) {
+                p_state->count++;
+            }
+            p_results->distance_mm[i] = distance;
+        }
+    }
+
+    return 0;
+}
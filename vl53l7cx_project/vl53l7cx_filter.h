@@ -0,0 +1,117 @@
+/**
+ * Temporal Filter for VL53L7CX Driver
+ *
+ * Smooths the distances of consecutive frames, zone by zone, in place in
+ * VL53L7CX_ResultsData. Each zone runs one of:
+ *   - median of the last N distances (spikes),
+ *   - exponential moving average,
+ *   - 1D Kalman filter whose measurement variance is range_sigma_mm^2: noisy
+ *     targets (far, dark) are smoothed more than clean ones. A distance
+ *     further than a few sigmas from the estimate is ignored as a spike, and
+ *     a second one restarts the zone (an object entering the zone is followed
+ *     after one frame). Without the range_sigma_mm output, a sigma of 10 mm
+ *     is assumed.
+ * A target whose target_status is not accepted, or which was not detected,
+ * restarts its zone and is left unchanged. In multi-target builds each target
+ * index of a zone is filtered on its own.
+ *
+ * Integer arithmetic only (32-bit, with 32 x 32 -> 64-bit products), so the
+ * filter runs on a Cortex-M33 without floating point. Distances are in the
+ * unit of the build (quarter mm with VL53L7CX_USE_RAW_FORMAT), estimates are
+ * kept with 4 more fractional bits.
+ */
+
+#ifndef _VL53L7CX_FILTER_H_
+#define _VL53L7CX_FILTER_H_
+
+#include <stdint.h>
+#include "vl53l7cx_api.h"
+
+#ifdef VL53L7CX_DISABLE_DISTANCE_MM
+#error "vl53l7cx_filter needs the distance output"
+#endif
+
+/**
+ * @brief Largest median window. Costs 2 bytes of RAM per target and zone.
+ */
+
+#ifndef VL53L7CX_FILTER_MEDIAN_MAX
+#define VL53L7CX_FILTER_MEDIAN_MAX      7U
+#endif
+
+/**
+ * @brief Filter of a zone.
+ */
+
+#define VL53L7CX_FILTER_NONE            ((uint8_t) 0U)
+#define VL53L7CX_FILTER_MEDIAN          ((uint8_t) 1U)
+#define VL53L7CX_FILTER_EXPONENTIAL     ((uint8_t) 2U)
+#define VL53L7CX_FILTER_KALMAN          ((uint8_t) 3U)
+
+/**
+ * @brief Default accepted target status: 5 and 9 (range valid). Bit n accepts
+ * status n.
+ */
+
+#define VL53L7CX_FILTER_DEFAULT_STATUS_MASK ((uint32_t)((1UL << 5) | (1UL << 9)))
+
+/**
+ * @brief Default parameters: median of 5, exponential weight 1/4 for the new
+ * distance, Kalman process noise 4 mm^2 per frame (a target moving by about
+ * 2 mm per frame), spikes beyond 4 sigmas.
+ */
+
+#define VL53L7CX_FILTER_DEFAULT_MEDIAN_SIZE     5U
+#define VL53L7CX_FILTER_DEFAULT_ALPHA_Q8        64U
+#define VL53L7CX_FILTER_DEFAULT_PROCESS_MM2     4U
+#define VL53L7CX_FILTER_DEFAULT_GATE_SIGMA      4U
+
+/**
+ * @brief State of one target of a zone.
+ */
+
+typedef struct
+{
+    int32_t            estimate;       /* Distance, 4 fractional bits */
+    uint32_t           variance;       /* Kalman estimate variance (distance unit^2) */
+    int16_t            history[VL53L7CX_FILTER_MEDIAN_MAX]; /* Last distances */
+    uint8_t            count;          /* Distances since the restart (saturated) */
+    uint8_t            next;           /* Next history slot */
+    uint8_t            rejected;       /* Kalman: last distance ignored as a spike */
+} VL53L7CX_FilterState;
+
+/**
+ * @brief Filter instance: configuration and the state of every target.
+ */
+
+typedef struct
+{
+    VL53L7CX_FilterState state[64U * VL53L7CX_NB_TARGET_PER_ZONE];
+    uint8_t            mode[64];       /* VL53L7CX_FILTER_xxx of each zone */
+    uint32_t           status_mask;
+    uint32_t           process_noise;  /* Kalman, distance unit^2 per frame */
+    uint16_t           alpha_q8;       /* Exponential weight of the new distance, 1 to 256 */
+    uint8_t            median_size;
+    uint8_t            gate_sigma;     /* Kalman spike distance (sigmas), 0: never */
+    uint8_t            resolution;     /* Of the last frame, 0 before the first */
+    uint32_t           restarts;       /* Targets restarted since the init */
+} VL53L7CX_Filter;
+
+/* Setup: every zone runs mode, with the default parameters */
+void vl53l7cx_filter_init(VL53L7CX_Filter *p_filter, uint8_t mode);
+uint8_t vl53l7cx_filter_set_zone_mode(VL53L7CX_Filter *p_filter, uint8_t zone, uint8_t mode);
+uint8_t vl53l7cx_filter_set_median(VL53L7CX_Filter *p_filter, uint8_t size);
+uint8_t vl53l7cx_filter_set_exponential(VL53L7CX_Filter *p_filter, uint16_t alpha_q8);
+uint8_t vl53l7cx_filter_set_kalman(VL53L7CX_Filter *p_filter, uint32_t process_mm2,
+        uint8_t gate_sigma);
+void vl53l7cx_filter_set_status_mask(VL53L7CX_Filter *p_filter, uint32_t status_mask);
+
+/* Restart every zone (scene change, ranging restarted) */
+void vl53l7cx_filter_reset(VL53L7CX_Filter *p_filter);
+
+/* Filter a frame in place. A change of resolution restarts every zone.
+ * Returns 0 if OK, 255 if the resolution is not 4x4 or 8x8. */
+uint8_t vl53l7cx_filter_apply(VL53L7CX_Filter *p_filter, VL53L7CX_ResultsData *p_results,
+        uint8_t resolution);
+
+#endif /* _VL53L7CX_FILTER_H_ */
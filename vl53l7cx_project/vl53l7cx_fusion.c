@@ -0,0 +1,456 @@
+/**
+ * Multi-Sensor Fusion Implementation for VL53L7CX Driver
+ *
+ * See vl53l7cx_fusion.h. The rings are the only state shared by the two
+ * sides; histories, counters and fused frames belong to the fusion side.
+ */
+
+#include <stddef.h>
+#include <string.h>
+#include "vl53l7cx_fusion.h"
+#include "vl53l7cx_pointcloud.h"
+
+#ifdef VL53L7CX_USE_RAW_FORMAT
+#define FUSION_UNITS_SHIFT      2   /* Quarter mm */
+#else
+#define FUSION_UNITS_SHIFT      0
+#endif
+
+/* Q15 product, rounded */
+#define FUSION_Q15(a, b)        ((int32_t)(((int32_t)(a) * (int32_t)(b) + (1L << 14)) >> 15))
+
+/**
+ * @brief Set up a fusion, with no sensor set
+ * @param p_fusion: Fusion
+ * @param nb_sensors: Number of sensors, 1 to VL53L7CX_FUSION_MAX_SENSORS
+ * @param mode: VL53L7CX_FUSION_NEAREST or VL53L7CX_FUSION_INTERPOLATE
+ * @return (uint8_t) status: 0 if OK, 255 for an invalid number of sensors or
+ * mode
+ */
+uint8_t vl53l7cx_fusion_init(
+        VL53L7CX_Fusion *p_fusion,
+        uint8_t nb_sensors,
+        uint8_t mode)
+{
+    uint8_t i;
+
+    if (nb_sensors == 0U || nb_sensors > VL53L7CX_FUSION_MAX_SENSORS
+            || mode > VL53L7CX_FUSION_INTERPOLATE) {
+        return 255;
+    }
+
+    p_fusion->nb_sensors = nb_sensors;
+    p_fusion->mode = mode;
+    p_fusion->gate_ratio_q8 = VL53L7CX_FUSION_DEFAULT_GATE_RATIO_Q8;
+    p_fusion->max_age_us = VL53L7CX_FUSION_DEFAULT_MAX_AGE_US;
+    p_fusion->status_mask = VL53L7CX_FUSION_DEFAULT_STATUS_MASK;
+    for (i = 0; i < VL53L7CX_FUSION_MAX_SENSORS; i++) {
+        VL53L7CX_FusionSensor *p_sensor = &p_fusion->sensor[i];
+
+        vl53l7cx_results_ring_init(&p_sensor->ring);
+        p_sensor->resolution = 0;
+        p_sensor->clock_offset_us = 0;
+        p_sensor->latency_us = 0;
+        p_sensor->nb_history = 0;
+        p_sensor->newest = 0;
+        p_sensor->streamcount = 0;
+        p_sensor->frames = 0;
+        p_sensor->missed = 0;
+        p_sensor->errors = 0;
+    }
+
+    return 0;
+}
+
+/**
+ * @brief Set the pose of a sensor
+ * @param p_fusion: Fusion
+ * @param sensor: Sensor, below the number of sensors
+ * @param resolution: VL53L7CX_RESOLUTION_4X4 or VL53L7CX_RESOLUTION_8X8
+ * @param x_mm: x of the sensor in the robot frame
+ * @param y_mm: y of the sensor in the robot frame
+ * @param z_mm: z of the sensor in the robot frame
+ * @param yaw_deg: Rotation about z, counterclockwise from x
+ * @param pitch_deg: Rotation about y, positive tilts the sensor down
+ * @param roll_deg: Rotation about the optical axis
+ * @return (uint8_t) status: 0 if OK, 255 for an invalid sensor or resolution
+ */
+uint8_t vl53l7cx_fusion_set_sensor(
+        VL53L7CX_Fusion *p_fusion,
+        uint8_t sensor,
+        uint8_t resolution,
+        int16_t x_mm,
+        int16_t y_mm,
+        int16_t z_mm,
+        int16_t yaw_deg,
+        int16_t pitch_deg,
+        int16_t roll_deg)
+{
+    const int16_t *rays = vl53l7cx_pointcloud_rays(resolution);
+    VL53L7CX_FusionSensor *p_sensor;
+    int32_t cy, sy, cp, sp, cr, sr, r[3][3];
+    uint8_t zone, i;
+
+    if (sensor >= p_fusion->nb_sensors || rays == NULL) {
+        return 255;
+    }
+
+    p_sensor = &p_fusion->sensor[sensor];
+    p_sensor->resolution = resolution;
+    p_sensor->x_mm = x_mm;
+    p_sensor->y_mm = y_mm;
+    p_sensor->z_mm = z_mm;
+
+    // Rotation yaw * pitch * roll (z, y, x axes), Q15
+    cy = vl53l7cx_pointcloud_sin((int32_t)yaw_deg + 90);
+    sy = vl53l7cx_pointcloud_sin(yaw_deg);
+    cp = vl53l7cx_pointcloud_sin((int32_t)pitch_deg + 90);
+    sp = vl53l7cx_pointcloud_sin(pitch_deg);
+    cr = vl53l7cx_pointcloud_sin((int32_t)roll_deg + 90);
+    sr = vl53l7cx_pointcloud_sin(roll_deg);
+    r[0][0] = FUSION_Q15(cy, cp);
+    r[0][1] = FUSION_Q15(FUSION_Q15(cy, sp), sr) - FUSION_Q15(sy, cr);
+    r[0][2] = FUSION_Q15(FUSION_Q15(cy, sp), cr) + FUSION_Q15(sy, sr);
+    r[1][0] = FUSION_Q15(sy, cp);
+    r[1][1] = FUSION_Q15(FUSION_Q15(sy, sp), sr) + FUSION_Q15(cy, cr);
+    r[1][2] = FUSION_Q15(FUSION_Q15(sy, sp), cr) - FUSION_Q15(cy, sr);
+    r[2][0] = -sp;
+    r[2][1] = FUSION_Q15(cp, sr);
+    r[2][2] = FUSION_Q15(cp, cr);
+
+    // Sensor frame: x to the right (columns), y down (rows), z forward; the
+    // body of an upright sensor is (forward, left, up) = (z, -x, -y)
+    for (zone = 0; zone < resolution; zone++) {
+        int32_t body[3];
+        int32_t ray[3];
+
+        body[0] = rays[2U * resolution + zone];
+        body[1] = -rays[zone];
+        body[2] = -rays[resolution + zone];
+        for (i = 0; i < 3U; i++) {
+            ray[i] = FUSION_Q15(r[i][0], body[0]) + FUSION_Q15(r[i][1], body[1])
+                    + FUSION_Q15(r[i][2], body[2]);
+        }
+        p_sensor->ray_x[zone] = (int16_t)ray[0];
+        p_sensor->ray_y[zone] = (int16_t)ray[1];
+        p_sensor->ray_z[zone] = (int16_t)ray[2];
+    }
+
+    return 0;
+}
+
+/**
+ * @brief Set the clock of a sensor: common time = timestamp + clock_offset_us
+ * - latency_us
+ * @param p_fusion: Fusion
+ * @param sensor: Sensor
+ * @param clock_offset_us: Common clock minus sensor clock
+ * @param latency_us: Time from the middle of the integration to the
+ * timestamp
+ */
+void vl53l7cx_fusion_set_timing(
+        VL53L7CX_Fusion *p_fusion,
+        uint8_t sensor,
+        int32_t clock_offset_us,
+        uint32_t latency_us)
+{
+    if (sensor < VL53L7CX_FUSION_MAX_SENSORS) {
+        p_fusion->sensor[sensor].clock_offset_us = clock_offset_us;
+        p_fusion->sensor[sensor].latency_us = latency_us;
+    }
+}
+
+/**
+ * @brief Set the alignment mode
+ * @param p_fusion: Fusion
+ * @param mode: VL53L7CX_FUSION_NEAREST or VL53L7CX_FUSION_INTERPOLATE
+ */
+void vl53l7cx_fusion_set_mode(
+        VL53L7CX_Fusion *p_fusion,
+        uint8_t mode)
+{
+    p_fusion->mode = mode;
+}
+
+/**
+ * @brief Set the maximum age of the last frame of a sensor
+ * @param p_fusion: Fusion
+ * @param max_age_us: Age at the fusion time beyond which a sensor is left out
+ */
+void vl53l7cx_fusion_set_max_age(
+        VL53L7CX_Fusion *p_fusion,
+        uint32_t max_age_us)
+{
+    p_fusion->max_age_us = max_age_us;
+}
+
+/**
+ * @brief Set the interpolation gate
+ * @param p_fusion: Fusion
+ * @param gate_ratio_q8: Largest difference of two distances interpolated,
+ * relative to the distance, in 1/256
+ */
+void vl53l7cx_fusion_set_gate(
+        VL53L7CX_Fusion *p_fusion,
+        uint8_t gate_ratio_q8)
+{
+    p_fusion->gate_ratio_q8 = gate_ratio_q8;
+}
+
+/**
+ * @brief Set the accepted target status
+ * @param p_fusion: Fusion
+ * @param status_mask: Bit n accepts status n
+ */
+void vl53l7cx_fusion_set_status_mask(
+        VL53L7CX_Fusion *p_fusion,
+        uint32_t status_mask)
+{
+    p_fusion->status_mask = status_mask;
+}
+
+/**
+ * @brief Get the slot of the next frame of a sensor (acquisition side)
+ * @param p_fusion: Fusion
+ * @param sensor: Sensor
+ * @return Slot to fill, or NULL if the ring is full (the frame is counted as
+ * an overrun)
+ */
+VL53L7CX_ResultsSlot *vl53l7cx_fusion_begin_write(
+        VL53L7CX_Fusion *p_fusion,
+        uint8_t sensor)
+{
+    return vl53l7cx_results_ring_begin_write(&p_fusion->sensor[sensor].ring);
+}
+
+/**
+ * @brief Publish the slot returned by vl53l7cx_fusion_begin_write()
+ * (acquisition side)
+ * @param p_fusion: Fusion
+ * @param sensor: Sensor
+ * @param timestamp_us: Acquisition time of the frame, sensor clock
+ * @param streamcount: Driver streamcount of the frame
+ * @param status: vl53l7cx_get_ranging_data() status
+ */
+void vl53l7cx_fusion_end_write(
+        VL53L7CX_Fusion *p_fusion,
+        uint8_t sensor,
+        uint64_t timestamp_us,
+        uint8_t streamcount,
+        uint8_t status)
+{
+    VL53L7CX_ResultsRing *p_ring = &p_fusion->sensor[sensor].ring;
+    VL53L7CX_ResultsSlot *p_slot =
+            &p_ring->slots[p_ring->head & (VL53L7CX_RESULTS_RING_SIZE - 1U)];
+
+    p_slot->timestamp_us = timestamp_us;
+    p_slot->streamcount = streamcount;
+    p_slot->status = status;
+    p_slot->sequence = p_ring->head;
+    vl53l7cx_results_ring_end_write(p_ring);
+}
+
+/**
+ * @brief Drain the rings into the histories (fusion side)
+ * @param p_fusion: Fusion
+ * @return (uint32_t) frames: slots drained
+ */
+uint32_t vl53l7cx_fusion_collect(
+        VL53L7CX_Fusion *p_fusion)
+{
+    uint32_t drained = 0;
+    uint8_t i;
+
+    for (i = 0; i < p_fusion->nb_sensors; i++) {
+        VL53L7CX_FusionSensor *p_sensor = &p_fusion->sensor[i];
+        uint32_t count = vl53l7cx_results_ring_count(&p_sensor->ring);
+        uint32_t k;
+
+        for (k = 0; k < count; k++) {
+            VL53L7CX_ResultsSlot *p_slot = vl53l7cx_results_ring_begin_read(&p_sensor->ring);
+
+            // Streamcounts run from 0 to 254
+            if (p_sensor->frames != 0U && p_slot->streamcount < 255U
+                    && p_sensor->streamcount < 255U) {
+                uint32_t step = ((uint32_t)p_slot->streamcount + 255U - p_sensor->streamcount)
+                        % 255U;
+
+                p_sensor->missed += (step > 1U) ? step - 1U : 0U;
+            }
+            p_sensor->streamcount = p_slot->streamcount;
+            p_sensor->frames++;
+
+            // Only the last two frames are kept: older ones are not copied
+            if (p_slot->status != 0U) {
+                p_sensor->errors++;
+            } else if (count - k <= 2U) {
+                uint8_t slot = (p_sensor->nb_history == 0U) ? 0U : (uint8_t)(p_sensor->newest ^ 1U);
+                int64_t time = (int64_t)p_slot->timestamp_us + p_sensor->clock_offset_us
+                        - (int64_t)p_sensor->latency_us;
+
+                memcpy(&p_sensor->history[slot], &p_slot->results, sizeof(VL53L7CX_ResultsData));
+                p_sensor->time_us[slot] = (time > 0) ? (uint64_t)time : 0U;
+                p_sensor->newest = slot;
+                if (p_sensor->nb_history < 2U) {
+                    p_sensor->nb_history++;
+                }
+            }
+            vl53l7cx_results_ring_end_read(&p_sensor->ring);
+        }
+        drained += count;
+    }
+
+    return drained;
+}
+
+/**
+ * @brief Distance of the first target of a zone, or -1 if it is not valid
+ */
+static int32_t fusion_distance(
+        const VL53L7CX_Fusion *p_fusion,
+        const VL53L7CX_ResultsData *p_results,
+        uint8_t zone)
+{
+    uint32_t i = (uint32_t)zone * VL53L7CX_NB_TARGET_PER_ZONE;
+
+#ifndef VL53L7CX_DISABLE_NB_TARGET_DETECTED
+    if (p_results->nb_target_detected[zone] == 0U) {
+        return -1;
+    }
+#endif
+#ifndef VL53L7CX_DISABLE_TARGET_STATUS
+    if (p_results->target_status[i] >= 32U
+            || ((p_fusion->status_mask >> p_results->target_status[i]) & 1U) == 0U) {
+        return -1;
+    }
+#else
+    (void)p_fusion;
+#endif
+    return (p_results->distance_mm[i] > 0) ? p_results->distance_mm[i] : -1;
+}
+
+/**
+ * @brief Build the fused frame at a time of the common clock (fusion side)
+ * @param p_fusion: Fusion
+ * @param time_us: Fusion time, or VL53L7CX_FUSION_TIME_LATEST for the oldest
+ * of the last frames of the sensors
+ * @param p_frame: Fused frame
+ * @return (uint8_t) status: 0 if OK, 255 if no sensor has a frame
+ */
+uint8_t vl53l7cx_fusion_fuse(
+        const VL53L7CX_Fusion *p_fusion,
+        uint64_t time_us,
+        VL53L7CX_FusedFrame *p_frame)
+{
+    uint64_t oldest = UINT64_MAX, newest = 0;
+    uint16_t nb_valid = 0;
+    uint8_t s, zone;
+
+    if (time_us == VL53L7CX_FUSION_TIME_LATEST) {
+        for (s = 0; s < p_fusion->nb_sensors; s++) {
+            const VL53L7CX_FusionSensor *p_sensor = &p_fusion->sensor[s];
+
+            if (p_sensor->nb_history != 0U && p_sensor->time_us[p_sensor->newest] < time_us) {
+                time_us = p_sensor->time_us[p_sensor->newest];
+            }
+        }
+        if (time_us == VL53L7CX_FUSION_TIME_LATEST) {
+            return 255;
+        }
+    }
+
+    p_frame->time_us = time_us;
+    p_frame->nb_used = 0;
+    memset(p_frame->x_mm, 0, sizeof(p_frame->x_mm));
+    memset(p_frame->y_mm, 0, sizeof(p_frame->y_mm));
+    memset(p_frame->z_mm, 0, sizeof(p_frame->z_mm));
+    memset(p_frame->distance_mm, 0, sizeof(p_frame->distance_mm));
+    memset(p_frame->valid_mask, 0, sizeof(p_frame->valid_mask));
+
+    for (s = 0; s < VL53L7CX_FUSION_MAX_SENSORS; s++) {
+        const VL53L7CX_FusionSensor *p_sensor = &p_fusion->sensor[s];
+        const VL53L7CX_ResultsData *p_old, *p_new, *p_near;
+        uint64_t t_old, t_new, t_near;
+        int64_t offset;
+        uint32_t weight = 0;   /* Q16, of the newest frame */
+        uint8_t interpolate = 0;
+
+        p_frame->used[s] = VL53L7CX_FUSION_UNUSED;
+        p_frame->offset_us[s] = 0;
+        if (s >= p_fusion->nb_sensors || p_sensor->resolution == 0U
+                || p_sensor->nb_history == 0U) {
+            continue;
+        }
+
+        p_new = &p_sensor->history[p_sensor->newest];
+        t_new = p_sensor->time_us[p_sensor->newest];
+        if (time_us > t_new && time_us - t_new > p_fusion->max_age_us) {
+            continue;   // Too old
+        }
+        p_old = p_new;
+        t_old = t_new;
+        if (p_sensor->nb_history == 2U) {
+            p_old = &p_sensor->history[p_sensor->newest ^ 1U];
+            t_old = p_sensor->time_us[p_sensor->newest ^ 1U];
+        }
+
+        // Frames around the fusion time: interpolate, else the nearest frame
+        if (p_fusion->mode == VL53L7CX_FUSION_INTERPOLATE && t_old <= time_us
+                && time_us <= t_new && t_new > t_old) {
+            weight = (uint32_t)(((time_us - t_old) << 16) / (t_new - t_old));
+            interpolate = 1;
+        }
+        if (interpolate ? (weight >= 32768U)
+                : (t_new >= time_us ? t_new - time_us : time_us - t_new)
+                <= (t_old >= time_us ? t_old - time_us : time_us - t_old)) {
+            p_near = p_new;
+            t_near = t_new;
+        } else {
+            p_near = p_old;
+            t_near = t_old;
+        }
+
+        offset = (int64_t)t_near - (int64_t)time_us;
+        offset = (offset > INT32_MAX) ? INT32_MAX : ((offset < INT32_MIN) ? INT32_MIN : offset);
+        p_frame->offset_us[s] = (int32_t)offset;
+        p_frame->used[s] = interpolate ? VL53L7CX_FUSION_USED_INTERPOLATED
+                : VL53L7CX_FUSION_USED_NEAREST;
+        p_frame->nb_used++;
+        oldest = (t_new < oldest) ? t_new : oldest;
+        newest = (t_new > newest) ? t_new : newest;
+
+        for (zone = 0; zone < p_sensor->resolution; zone++) {
+            uint16_t point = (uint16_t)(s * 64U + zone);
+            int32_t distance = fusion_distance(p_fusion, p_near, zone);
+            int32_t mm;
+
+            if (interpolate) {
+                int32_t d_old = fusion_distance(p_fusion, p_old, zone);
+                int32_t d_new = fusion_distance(p_fusion, p_new, zone);
+                int32_t gate = (int32_t)(((d_old > d_new ? d_old : d_new)
+                        * p_fusion->gate_ratio_q8) >> 8);
+                int32_t diff = d_new - d_old;
+
+                if (d_old >= 0 && d_new >= 0 && diff <= gate && -diff <= gate) {
+                    distance = d_old + (int32_t)(((int64_t)diff * weight + 32768) >> 16);
+                }
+            }
+            if (distance < 0) {
+                continue;
+            }
+
+            mm = (distance + ((1 << FUSION_UNITS_SHIFT) >> 1)) >> FUSION_UNITS_SHIFT;
+            p_frame->x_mm[point] = (int16_t)(p_sensor->x_mm + FUSION_Q15(mm, p_sensor->ray_x[zone]));
+            p_frame->y_mm[point] = (int16_t)(p_sensor->y_mm + FUSION_Q15(mm, p_sensor->ray_y[zone]));
+            p_frame->z_mm[point] = (int16_t)(p_sensor->z_mm + FUSION_Q15(mm, p_sensor->ray_z[zone]));
+            p_frame->distance_mm[point] = (int16_t)mm;
+            p_frame->valid_mask[point >> 5] |= 1UL << (point & 31U);
+            nb_valid++;
+        }
+    }
+
+    p_frame->skew_us = (p_frame->nb_used != 0U) ? (uint32_t)(newest - oldest) : 0U;
+    p_frame->nb_valid = nb_valid;
+
+    return 0;
+}
@@ -0,0 +1,184 @@
+/**
+ * Multi-Sensor Fusion for VL53L7CX Driver
+ *
+ * Merges the frames of several sensors on a robot into one fused frame at a
+ * single time, in the robot frame (x forward, y left, z up, in mm).
+ *
+ * Acquisition and fusion run on different threads (or RP2350 cores) and share
+ * no lock: each sensor has a lock-free ring (vl53l7cx_results_ring.h) that
+ * the acquisition side fills in place with the frame, its acquisition
+ * timestamp and the driver streamcount. The fusion side drains the rings
+ * into a history of the last two frames of each sensor
+ * (vl53l7cx_fusion_collect()), then builds a fused frame at a time of the
+ * common clock (vl53l7cx_fusion_fuse()):
+ *   - timestamps are moved to the common clock with the clock offset of the
+ *     sensor, minus its latency (data ready time to mid integration);
+ *   - each sensor contributes its frame nearest in time or, when its two last
+ *     frames surround the fusion time, their interpolation; a zone whose two
+ *     distances differ by more than the gate (another target) takes the
+ *     nearest one;
+ *   - sensors whose last frame is older than the maximum age are left out;
+ *   - the skew of the sensors (spread of their last frame times) and the
+ *     offset of each frame from the fusion time are reported.
+ *
+ * Each zone gives one point, from its first target, through the ray of the
+ * zone (vl53l7cx_pointcloud_lut.h) and the pose of its sensor: position and
+ * yaw, pitch and roll. The point of zone z of sensor s is at index
+ * s * 64 + z; invalid points are (0, 0, 0).
+ *
+ * Distances are read in the unit of the build: quarter mm with
+ * VL53L7CX_USE_RAW_FORMAT, mm otherwise.
+ */
+
+#ifndef _VL53L7CX_FUSION_H_
+#define _VL53L7CX_FUSION_H_
+
+#include <stdint.h>
+#include "vl53l7cx_api.h"
+#include "vl53l7cx_results_ring.h"
+
+#ifdef VL53L7CX_DISABLE_DISTANCE_MM
+#error "vl53l7cx_fusion needs the distance output"
+#endif
+
+/**
+ * @brief Largest number of sensors, and of points of a fused frame.
+ */
+
+#ifndef VL53L7CX_FUSION_MAX_SENSORS
+#define VL53L7CX_FUSION_MAX_SENSORS     4U
+#endif
+
+#define VL53L7CX_FUSION_MAX_POINTS      ((uint16_t)(VL53L7CX_FUSION_MAX_SENSORS * 64U))
+
+/**
+ * @brief Alignment modes.
+ */
+
+#define VL53L7CX_FUSION_NEAREST         ((uint8_t) 0U)
+#define VL53L7CX_FUSION_INTERPOLATE     ((uint8_t) 1U)
+
+/**
+ * @brief Use of a sensor in a fused frame.
+ */
+
+#define VL53L7CX_FUSION_UNUSED          ((uint8_t) 0U)  /* No frame, or too old */
+#define VL53L7CX_FUSION_USED_NEAREST    ((uint8_t) 1U)
+#define VL53L7CX_FUSION_USED_INTERPOLATED ((uint8_t) 2U)
+
+/**
+ * @brief Fusion time: the newest time every sensor has reached.
+ */
+
+#define VL53L7CX_FUSION_TIME_LATEST     UINT64_MAX
+
+/**
+ * @brief Default accepted target status (5 and 9), maximum age of a frame
+ * (100 ms) and interpolation gate (20/256 = 8 % of the distance).
+ */
+
+#define VL53L7CX_FUSION_DEFAULT_STATUS_MASK     ((uint32_t)((1UL << 5) | (1UL << 9)))
+#define VL53L7CX_FUSION_DEFAULT_MAX_AGE_US      100000U
+#define VL53L7CX_FUSION_DEFAULT_GATE_RATIO_Q8   20U
+
+/**
+ * @brief One sensor: ring (acquisition side), pose and timing (setup), and
+ * history (fusion side).
+ */
+
+typedef struct
+{
+    VL53L7CX_ResultsRing ring;
+    uint8_t            resolution;     /* 0 if the sensor is not set */
+    int16_t            x_mm;           /* Position in the robot frame */
+    int16_t            y_mm;
+    int16_t            z_mm;
+    int32_t            clock_offset_us; /* Added to the timestamps */
+    uint32_t           latency_us;     /* Subtracted from the timestamps */
+    /* Ray of each zone in the robot frame, Q15 */
+    int16_t            ray_x[64];
+    int16_t            ray_y[64];
+    int16_t            ray_z[64];
+    /* Last two valid frames and their common clock times */
+    VL53L7CX_ResultsData history[2];
+    uint64_t           time_us[2];
+    uint8_t            nb_history;
+    uint8_t            newest;         /* Index of the newest frame in history */
+    uint8_t            streamcount;    /* Of the last slot drained */
+    uint32_t           frames;         /* Slots drained */
+    uint32_t           missed;         /* Frames not read by the driver (streamcount gaps) */
+    uint32_t           errors;         /* Slots with a driver error */
+} VL53L7CX_FusionSensor;
+
+/**
+ * @brief Fusion of up to VL53L7CX_FUSION_MAX_SENSORS sensors.
+ */
+
+typedef struct
+{
+    uint8_t            nb_sensors;
+    uint8_t            mode;           /* VL53L7CX_FUSION_NEAREST or _INTERPOLATE */
+    uint8_t            gate_ratio_q8;
+    uint32_t           max_age_us;
+    uint32_t           status_mask;
+    VL53L7CX_FusionSensor sensor[VL53L7CX_FUSION_MAX_SENSORS];
+} VL53L7CX_Fusion;
+
+/**
+ * @brief Fused frame. Coordinate arrays are 32-byte aligned for vector loads.
+ */
+
+typedef struct
+{
+    uint64_t           time_us;        /* Common clock */
+    uint32_t           skew_us;        /* Newest minus oldest last frame of the sensors used */
+    uint8_t            nb_used;
+    uint8_t            used[VL53L7CX_FUSION_MAX_SENSORS]; /* VL53L7CX_FUSION_UNUSED, _USED_xxx */
+    int32_t            offset_us[VL53L7CX_FUSION_MAX_SENSORS]; /* Nearest frame time - time_us */
+    int16_t            x_mm[VL53L7CX_FUSION_MAX_POINTS] __attribute__((aligned(32)));
+    int16_t            y_mm[VL53L7CX_FUSION_MAX_POINTS] __attribute__((aligned(32)));
+    int16_t            z_mm[VL53L7CX_FUSION_MAX_POINTS] __attribute__((aligned(32)));
+    int16_t            distance_mm[VL53L7CX_FUSION_MAX_POINTS]; /* Aligned distance, mm */
+    uint32_t           valid_mask[(VL53L7CX_FUSION_MAX_POINTS + 31U) / 32U]; /* Bit i: point i */
+    uint16_t           nb_valid;
+} VL53L7CX_FusedFrame;
+
+/* Setup (before both sides start). Returns 0 if OK, 255 for an invalid number
+ * of sensors or mode. */
+uint8_t vl53l7cx_fusion_init(VL53L7CX_Fusion *p_fusion, uint8_t nb_sensors, uint8_t mode);
+
+/* Pose of a sensor: position, yaw (counterclockwise from x), pitch (positive
+ * tilts it down) and roll, in degrees. The sensor is upright at 0: zone
+ * columns horizontal, zone row 0 on top. Returns 0 if OK, 255 for an invalid
+ * sensor or resolution. */
+uint8_t vl53l7cx_fusion_set_sensor(VL53L7CX_Fusion *p_fusion, uint8_t sensor, uint8_t resolution,
+        int16_t x_mm, int16_t y_mm, int16_t z_mm, int16_t yaw_deg, int16_t pitch_deg,
+        int16_t roll_deg);
+
+/* Clock of a sensor: common time = timestamp + clock_offset_us - latency_us */
+void vl53l7cx_fusion_set_timing(VL53L7CX_Fusion *p_fusion, uint8_t sensor,
+        int32_t clock_offset_us, uint32_t latency_us);
+void vl53l7cx_fusion_set_mode(VL53L7CX_Fusion *p_fusion, uint8_t mode);
+void vl53l7cx_fusion_set_max_age(VL53L7CX_Fusion *p_fusion, uint32_t max_age_us);
+void vl53l7cx_fusion_set_gate(VL53L7CX_Fusion *p_fusion, uint8_t gate_ratio_q8);
+void vl53l7cx_fusion_set_status_mask(VL53L7CX_Fusion *p_fusion, uint32_t status_mask);
+
+/* Acquisition side, one producer per sensor: slot to fill with the results
+ * (NULL if the fusion side holds every slot: the frame is an overrun), then
+ * published with its acquisition time (sensor clock), driver streamcount and
+ * status */
+VL53L7CX_ResultsSlot *vl53l7cx_fusion_begin_write(VL53L7CX_Fusion *p_fusion, uint8_t sensor);
+void vl53l7cx_fusion_end_write(VL53L7CX_Fusion *p_fusion, uint8_t sensor, uint64_t timestamp_us,
+        uint8_t streamcount, uint8_t status);
+
+/* Fusion side: drain every ring into the histories. Returns the number of
+ * frames drained. */
+uint32_t vl53l7cx_fusion_collect(VL53L7CX_Fusion *p_fusion);
+
+/* Fusion side: fused frame at time_us of the common clock, or at
+ * VL53L7CX_FUSION_TIME_LATEST. Returns 0 if OK, 255 if no sensor has a
+ * frame. */
+uint8_t vl53l7cx_fusion_fuse(const VL53L7CX_Fusion *p_fusion, uint64_t time_us,
+        VL53L7CX_FusedFrame *p_frame);
+
+#endif /* _VL53L7CX_FUSION_H_ */
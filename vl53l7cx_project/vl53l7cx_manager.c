@@ -0,0 +1,404 @@
+/**
+ * Multi-Sensor Manager Implementation for VL53L7CX Driver
+ *
+ * Boot sequencing, staggered start and fair servicing of several sensors. See
+ * vl53l7cx_manager.h.
+ */
+
+#include <stddef.h>
+#include <string.h>
+#include "vl53l7cx_manager.h"
+
+/**
+ * @brief Time (ms) given to a sensor after its LPn pin changed
+ */
+#define VL53L7CX_MANAGER_LPN_DELAY_MS   10U
+
+/**
+ * @brief Move a sensor to a new I2C address. The register takes the 7-bit
+ * address, which is also what VL53L7CX_Platform.address holds on this port.
+ * @param p_dev: Sensor, answering at its current address
+ * @param address: New 7-bit address
+ * @return 0 if OK, non-zero if error
+ */
+static uint8_t _vl53l7cx_manager_set_address(
+        VL53L7CX_Configuration *p_dev,
+        uint16_t address)
+{
+    uint8_t status = 0;
+
+    status |= VL53L7CX_WrByte(&(p_dev->platform), 0x7fff, 0x00);
+    status |= VL53L7CX_WrByte(&(p_dev->platform), 0x4, (uint8_t)address);
+    p_dev->platform.address = address;
+    status |= VL53L7CX_WrByte(&(p_dev->platform), 0x7fff, 0x02);
+
+    return status;
+}
+
+/**
+ * @brief Wait until a given time
+ * @param p_mgr: Pointer to manager
+ * @param target_us: Time to reach
+ */
+static void _vl53l7cx_manager_wait_until(
+        VL53L7CX_Manager *p_mgr,
+        uint64_t target_us)
+{
+    uint64_t now_us = p_mgr->p_ops->time_us(p_mgr->p_ctx);
+
+    if (target_us > now_us) {
+        p_mgr->p_ops->wait_ms(p_mgr->p_ctx, (uint32_t)((target_us - now_us + 999U) / 1000U));
+    }
+}
+
+/**
+ * @brief Initialize a manager
+ * @param p_mgr: Pointer to manager
+ * @param p_ops: Pin and time operations
+ * @param p_ctx: Operations context, passed to every operation
+ * @return 0 if OK, non-zero if error
+ */
+uint8_t vl53l7cx_manager_init(
+        VL53L7CX_Manager *p_mgr,
+        const VL53L7CX_ManagerOps *p_ops,
+        void *p_ctx)
+{
+    if (!p_mgr || !p_ops || !p_ops->set_lpn || !p_ops->wait_ms || !p_ops->time_us) {
+        return 255; // Error: invalid parameters
+    }
+
+    memset(p_mgr, 0, sizeof(VL53L7CX_Manager));
+    p_mgr->p_ops = p_ops;
+    p_mgr->p_ctx = p_ctx;
+
+    return 0;
+}
+
+/**
+ * @brief Register a sensor. Sensors are booted in the order they are added,
+ * and their index (0, 1, ...) is the one passed to the operations.
+ * @param p_mgr: Pointer to manager
+ * @param p_dev: Sensor configuration, platform part filled (bus)
+ * @param p_results: Results structure filled for this sensor
+ * @param address: 7-bit I2C address given at boot, unique, not the default one
+ * @return 0 if OK, non-zero if error
+ */
+uint8_t vl53l7cx_manager_add(
+        VL53L7CX_Manager *p_mgr,
+        VL53L7CX_Configuration *p_dev,
+        VL53L7CX_ResultsData *p_results,
+        uint16_t address)
+{
+    VL53L7CX_ManagedSensor *p_sensor;
+    uint8_t i;
+
+    if (!p_dev || !p_results || p_mgr->nb_sensors >= VL53L7CX_MANAGER_MAX_SENSORS) {
+        return 255; // Error: invalid parameters or manager full
+    }
+
+    // A sensor still at the default address would answer for the next ones
+    if (address == (VL53L7CX_DEFAULT_I2C_ADDRESS >> 1)) {
+        return 255; // Error: default address
+    }
+
+    for (i = 0; i < p_mgr->nb_sensors; i++) {
+        if (p_mgr->sensors[i].address == address) {
+            return 255; // Error: address already used
+        }
+    }
+
+    p_sensor = &p_mgr->sensors[p_mgr->nb_sensors];
+    memset(p_sensor, 0, sizeof(VL53L7CX_ManagedSensor));
+    p_sensor->p_dev = p_dev;
+    p_sensor->p_results = p_results;
+    p_sensor->address = address;
+    p_sensor->state = VL53L7CX_SENSOR_OFF;
+    p_mgr->nb_sensors++;
+
+    return 0;
+}
+
+/**
+ * @brief Boot all sensors: hold them all in low power, then release them one
+ * at a time, move each to its address and initialize it
+ * @param p_mgr: Pointer to manager
+ * @return 0 if every sensor is READY, non-zero if at least one failed (its
+ * state is VL53L7CX_SENSOR_ERROR and its LPn pin is left low)
+ */
+uint8_t vl53l7cx_manager_boot(
+        VL53L7CX_Manager *p_mgr)
+{
+    VL53L7CX_ManagedSensor *p_sensor;
+    uint8_t i, is_alive, status, result = 0;
+
+    for (i = 0; i < p_mgr->nb_sensors; i++) {
+        p_mgr->p_ops->set_lpn(p_mgr->p_ctx, i, 0);
+        p_mgr->sensors[i].state = VL53L7CX_SENSOR_OFF;
+    }
+    p_mgr->p_ops->wait_ms(p_mgr->p_ctx, VL53L7CX_MANAGER_LPN_DELAY_MS);
+
+    for (i = 0; i < p_mgr->nb_sensors; i++) {
+        p_sensor = &p_mgr->sensors[i];
+
+        // Only this sensor answers at the default address
+        p_mgr->p_ops->set_lpn(p_mgr->p_ctx, i, 1);
+        p_mgr->p_ops->wait_ms(p_mgr->p_ctx, VL53L7CX_MANAGER_LPN_DELAY_MS);
+        p_sensor->p_dev->platform.address = VL53L7CX_DEFAULT_I2C_ADDRESS >> 1;
+
+        is_alive = 0;
+        status = vl53l7cx_is_alive(p_sensor->p_dev, &is_alive);
+        if (status == VL53L7CX_STATUS_OK && is_alive) {
+            status = _vl53l7cx_manager_set_address(p_sensor->p_dev, p_sensor->address);
+        } else {
+            status |= VL53L7CX_STATUS_ERROR;
+        }
+
+        if (status == VL53L7CX_STATUS_OK) {
+            status = vl53l7cx_init(p_sensor->p_dev);
+        }
+
+        p_sensor->last_status = status;
+        if (status != VL53L7CX_STATUS_OK) {
+            // Keep it silent, so it can't answer for the next sensor
+            p_mgr->p_ops->set_lpn(p_mgr->p_ctx, i, 0);
+            p_sensor->state = VL53L7CX_SENSOR_ERROR;
+            result = 255; // Error: sensor not booted
+        } else {
+            p_sensor->state = VL53L7CX_SENSOR_READY;
+        }
+    }
+
+    return result;
+}
+
+/**
+ * @brief Start ranging on every READY sensor, with a phase offset of
+ * period / N between them
+ * @param p_mgr: Pointer to manager
+ * @param frequency_hz: Ranging frequency of every sensor
+ * @return 0 if OK, non-zero if a sensor failed to start
+ */
+uint8_t vl53l7cx_manager_start(
+        VL53L7CX_Manager *p_mgr,
+        uint8_t frequency_hz)
+{
+    VL53L7CX_ManagedSensor *p_sensor;
+    uint64_t period_us, start_us;
+    uint8_t i, nb_ready = 0, slot = 0, status, result = 0;
+
+    if (frequency_hz == 0) {
+        return 255; // Error: invalid parameters
+    }
+
+    for (i = 0; i < p_mgr->nb_sensors; i++) {
+        p_sensor = &p_mgr->sensors[i];
+        if (p_sensor->state != VL53L7CX_SENSOR_READY) {
+            continue;
+        }
+
+        status = vl53l7cx_set_ranging_frequency_hz(p_sensor->p_dev, frequency_hz);
+        p_sensor->last_status = status;
+        if (status != VL53L7CX_STATUS_OK) {
+            p_sensor->state = VL53L7CX_SENSOR_ERROR;
+            result = 255; // Error: sensor not configured
+        } else {
+            nb_ready++;
+        }
+    }
+
+    if (nb_ready == 0) {
+        return 255; // Error: no sensor to start
+    }
+
+    period_us = 1000000U / frequency_hz;
+    start_us = p_mgr->p_ops->time_us(p_mgr->p_ctx);
+    p_mgr->start_us = start_us;
+    p_mgr->next = 0;
+
+    for (i = 0; i < p_mgr->nb_sensors; i++) {
+        p_sensor = &p_mgr->sensors[i];
+        if (p_sensor->state != VL53L7CX_SENSOR_READY) {
+            continue;
+        }
+
+        _vl53l7cx_manager_wait_until(p_mgr, start_us + (period_us * slot) / nb_ready);
+        slot++;
+
+        p_sensor->nb_frames = 0;
+        p_sensor->nb_errors = 0;
+        p_sensor->bus_time_us = 0;
+
+        status = vl53l7cx_start_ranging(p_sensor->p_dev);
+        p_sensor->last_status = status;
+        if (status != VL53L7CX_STATUS_OK) {
+            p_sensor->state = VL53L7CX_SENSOR_ERROR;
+            result = 255; // Error: sensor not started
+        } else {
+            p_sensor->state = VL53L7CX_SENSOR_RANGING;
+        }
+    }
+
+    return result;
+}
+
+/**
+ * @brief Check every ranging sensor once, and read the frames that are ready.
+ * Sensors are checked round-robin, starting after the last one served.
+ * @param p_mgr: Pointer to manager
+ * @param handler: Optional callback receiving each frame read
+ * @param p_user: Passed back to the handler
+ * @return Number of frames read
+ */
+uint8_t vl53l7cx_manager_service(
+        VL53L7CX_Manager *p_mgr,
+        VL53L7CX_ManagerHandler handler,
+        void *p_user)
+{
+    VL53L7CX_ManagedSensor *p_sensor;
+    uint64_t begin_us, end_us;
+    uint8_t n, i, is_ready, status, served = 0, next = p_mgr->next;
+
+    for (n = 0; n < p_mgr->nb_sensors; n++) {
+        i = (uint8_t)((p_mgr->next + n) % p_mgr->nb_sensors);
+        p_sensor = &p_mgr->sensors[i];
+        if (p_sensor->state != VL53L7CX_SENSOR_RANGING) {
+            continue;
+        }
+
+        begin_us = p_mgr->p_ops->time_us(p_mgr->p_ctx);
+        is_ready = 0;
+        status = VL53L7CX_STATUS_OK;
+        if (p_mgr->p_ops->data_ready) {
+            is_ready = p_mgr->p_ops->data_ready(p_mgr->p_ctx, i);
+        } else {
+            status |= vl53l7cx_check_data_ready(p_sensor->p_dev, &is_ready);
+        }
+
+        if (is_ready) {
+            status |= vl53l7cx_get_ranging_data(p_sensor->p_dev, p_sensor->p_results);
+        }
+        end_us = p_mgr->p_ops->time_us(p_mgr->p_ctx);
+        p_sensor->bus_time_us += end_us - begin_us;
+
+        if (status != VL53L7CX_STATUS_OK) {
+            p_sensor->nb_errors++;
+            p_sensor->last_status = status;
+        }
+
+        if (!is_ready) {
+            continue;
+        }
+
+        // Next service starts after the last sensor served
+        next = (uint8_t)((i + 1U) % p_mgr->nb_sensors);
+
+        if (status == VL53L7CX_STATUS_OK) {
+            if (p_sensor->nb_frames == 0) {
+                p_sensor->first_frame_us = end_us;
+            }
+            p_sensor->last_frame_us = end_us;
+            p_sensor->nb_frames++;
+            served++;
+
+            if (handler) {
+                handler(i, p_sensor->p_dev, p_sensor->p_results, end_us, p_user);
+            }
+        }
+    }
+
+    p_mgr->next = next;
+
+    return served;
+}
+
+/**
+ * @brief Stop ranging on every sensor
+ * @param p_mgr: Pointer to manager
+ * @return 0 if OK, non-zero if a sensor failed to stop
+ */
+uint8_t vl53l7cx_manager_stop(
+        VL53L7CX_Manager *p_mgr)
+{
+    VL53L7CX_ManagedSensor *p_sensor;
+    uint8_t i, status, result = 0;
+
+    for (i = 0; i < p_mgr->nb_sensors; i++) {
+        p_sensor = &p_mgr->sensors[i];
+        if (p_sensor->state != VL53L7CX_SENSOR_RANGING) {
+            continue;
+        }
+
+        status = vl53l7cx_stop_ranging(p_sensor->p_dev);
+        p_sensor->last_status = status;
+        p_sensor->state = VL53L7CX_SENSOR_READY;
+        if (status != VL53L7CX_STATUS_OK) {
+            result = 255; // Error: sensor not stopped
+        }
+    }
+
+    return result;
+}
+
+/**
+ * @brief Get the statistics of a sensor since vl53l7cx_manager_start()
+ * @param p_mgr: Pointer to manager
+ * @param sensor: Sensor index
+ * @param p_stats: Pointer to store the statistics
+ * @return 0 if OK, non-zero if error
+ */
+uint8_t vl53l7cx_manager_get_stats(
+        VL53L7CX_Manager *p_mgr,
+        uint8_t sensor,
+        VL53L7CX_ManagerStats *p_stats)
+{
+    VL53L7CX_ManagedSensor *p_sensor;
+    uint64_t elapsed_us;
+
+    if (sensor >= p_mgr->nb_sensors || !p_stats) {
+        return 255; // Error: invalid parameters
+    }
+
+    p_sensor = &p_mgr->sensors[sensor];
+    p_stats->nb_frames = p_sensor->nb_frames;
+    p_stats->nb_errors = p_sensor->nb_errors;
+
+    // Frame rate over the intervals between the first and the last frame
+    p_stats->frame_rate_mhz = 0;
+    if (p_sensor->nb_frames > 1 && p_sensor->last_frame_us > p_sensor->first_frame_us) {
+        p_stats->frame_rate_mhz = (uint32_t)(((uint64_t)(p_sensor->nb_frames - 1U) * 1000000000ULL)
+                / (p_sensor->last_frame_us - p_sensor->first_frame_us));
+    }
+
+    p_stats->bus_permille = 0;
+    elapsed_us = p_mgr->p_ops->time_us(p_mgr->p_ctx) - p_mgr->start_us;
+    if (elapsed_us > 0) {
+        p_stats->bus_permille = (uint32_t)((p_sensor->bus_time_us * 1000U) / elapsed_us);
+    }
+
+    return 0;
+}
+
+/**
+ * @brief Get the share of time spent on the bus by all sensors since
+ * vl53l7cx_manager_start(). With sensors on separate buses, the value can
+ * exceed 1000.
+ * @param p_mgr: Pointer to manager
+ * @return Bus time, in permille of the elapsed time
+ */
+uint32_t vl53l7cx_manager_get_bus_permille(
+        VL53L7CX_Manager *p_mgr)
+{
+    uint64_t bus_time_us = 0, elapsed_us;
+    uint8_t i;
+
+    for (i = 0; i < p_mgr->nb_sensors; i++) {
+        bus_time_us += p_mgr->sensors[i].bus_time_us;
+    }
+
+    elapsed_us = p_mgr->p_ops->time_us(p_mgr->p_ctx) - p_mgr->start_us;
+    if (elapsed_us == 0) {
+        return 0;
+    }
+
+    return (uint32_t)((bus_time_us * 1000U) / elapsed_us);
+}
@@ -0,0 +1,127 @@
+/**
+ * Multi-Sensor Manager for VL53L7CX Driver
+ *
+ * Brings up several VL53L7CX sharing I2C buses, and schedules their frame
+ * reads:
+ * - Boot: every sensor is held in low power (LPn low), then released one at a
+ *   time and moved to its own I2C address while the others are still silent.
+ * - Start: ranging is started with a phase offset of period / N between
+ *   sensors, so frames become ready (and are read) one after the other instead
+ *   of colliding on the bus.
+ * - Service: data-ready is checked round-robin, starting after the last
+ *   sensor served, so a fast or busy sensor can't starve the others.
+ * - Statistics: frame rate and bus time spent per sensor.
+ *
+ * Pins, time and sleep are reached through a table of operations, so the
+ * manager runs on the Pico 2 (see VL53L7CX_ManagerInitPico() in
+ * platform_pico.c) or against simulated sensors on a host machine.
+ */
+
+#ifndef _VL53L7CX_MANAGER_H_
+#define _VL53L7CX_MANAGER_H_
+
+#include <stdint.h>
+#include "vl53l7cx_api.h"
+
+/**
+ * @brief Maximum number of sensors handled by a manager.
+ */
+
+#define VL53L7CX_MANAGER_MAX_SENSORS    4U
+
+/**
+ * @brief Sensor states.
+ */
+
+#define VL53L7CX_SENSOR_OFF             ((uint8_t) 0U)
+#define VL53L7CX_SENSOR_READY           ((uint8_t) 1U)
+#define VL53L7CX_SENSOR_RANGING         ((uint8_t) 2U)
+#define VL53L7CX_SENSOR_ERROR           ((uint8_t) 3U)
+
+/**
+ * @brief Manager operations. set_lpn() drives the LPn pin of a sensor (0 =
+ * I2C interface disabled). data_ready() is optional: if NULL, the manager
+ * polls vl53l7cx_check_data_ready() over I2C.
+ */
+
+typedef struct
+{
+    void     (*set_lpn)(void *p_ctx, uint8_t sensor, uint8_t level);
+    void     (*wait_ms)(void *p_ctx, uint32_t time_ms);
+    uint64_t (*time_us)(void *p_ctx);
+    uint8_t  (*data_ready)(void *p_ctx, uint8_t sensor);
+} VL53L7CX_ManagerOps;
+
+/**
+ * @brief Called for each frame read by vl53l7cx_manager_service().
+ */
+
+typedef void (*VL53L7CX_ManagerHandler)(uint8_t sensor, VL53L7CX_Configuration *p_dev,
+        VL53L7CX_ResultsData *p_results, uint64_t timestamp_us, void *p_user);
+
+/**
+ * @brief One managed sensor. p_dev and p_results belong to the caller; the
+ * platform part of p_dev (bus, pins) must be filled before boot.
+ */
+
+typedef struct
+{
+    VL53L7CX_Configuration *p_dev;
+    VL53L7CX_ResultsData *p_results;
+    uint16_t           address;        /* I2C address after boot (7-bit, as platform.address) */
+    uint8_t            state;          /* VL53L7CX_SENSOR_* */
+    uint8_t            last_status;    /* Last driver status */
+
+    /* Statistics */
+    uint32_t           nb_frames;
+    uint32_t           nb_errors;
+    uint64_t           first_frame_us;
+    uint64_t           last_frame_us;
+    uint64_t           bus_time_us;    /* Time spent in data-ready checks and frame reads */
+} VL53L7CX_ManagedSensor;
+
+/**
+ * @brief Per-sensor statistics, computed by vl53l7cx_manager_get_stats().
+ */
+
+typedef struct
+{
+    uint32_t           nb_frames;
+    uint32_t           nb_errors;
+    uint32_t           frame_rate_mhz;     /* Frames per second x 1000 */
+    uint32_t           bus_permille;       /* Share of elapsed time spent on the bus */
+} VL53L7CX_ManagerStats;
+
+/**
+ * @brief Manager instance.
+ */
+
+typedef struct
+{
+    VL53L7CX_ManagedSensor sensors[VL53L7CX_MANAGER_MAX_SENSORS];
+    uint8_t            nb_sensors;
+    uint8_t            next;           /* First sensor checked by the next service */
+    const VL53L7CX_ManagerOps *p_ops;
+    void               *p_ctx;
+    uint64_t           start_us;       /* Time of vl53l7cx_manager_start() */
+} VL53L7CX_Manager;
+
+/* Setup */
+uint8_t vl53l7cx_manager_init(VL53L7CX_Manager *p_mgr, const VL53L7CX_ManagerOps *p_ops, void *p_ctx);
+uint8_t vl53l7cx_manager_add(VL53L7CX_Manager *p_mgr, VL53L7CX_Configuration *p_dev,
+        VL53L7CX_ResultsData *p_results, uint16_t address);
+uint8_t vl53l7cx_manager_boot(VL53L7CX_Manager *p_mgr);
+
+/* Ranging */
+uint8_t vl53l7cx_manager_start(VL53L7CX_Manager *p_mgr, uint8_t frequency_hz);
+uint8_t vl53l7cx_manager_service(VL53L7CX_Manager *p_mgr, VL53L7CX_ManagerHandler handler, void *p_user);
+uint8_t vl53l7cx_manager_stop(VL53L7CX_Manager *p_mgr);
+
+/* Statistics */
+uint8_t vl53l7cx_manager_get_stats(VL53L7CX_Manager *p_mgr, uint8_t sensor, VL53L7CX_ManagerStats *p_stats);
+uint32_t vl53l7cx_manager_get_bus_permille(VL53L7CX_Manager *p_mgr);
+
+/* Platform manager operations (platform_pico.c) */
+uint8_t VL53L7CX_ManagerInitPico(VL53L7CX_Manager *p_mgr, const uint8_t *p_lpn_pins, uint8_t nb_pins);
+
+#endif /* _VL53L7CX_MANAGER_H_ */
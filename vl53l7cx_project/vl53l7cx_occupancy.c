@@ -0,0 +1,602 @@
+/**
+ * Occupancy Grid Implementation for VL53L7CX Driver
+ *
+ * See vl53l7cx_occupancy.h. Integer only: the yaw of a pose comes from the sine
+ * table of the point cloud, rays are walked in half-cell steps in fixed point, and the polar
+ * cells use an integer square root and an approximate atan2 (within 0.25
+ * degree).
+ */
+
+#include <stddef.h>
+#include "vl53l7cx_occupancy.h"
+#include "vl53l7cx_pointcloud.h"
+
+#ifdef VL53L7CX_USE_RAW_FORMAT
+#define OCCUPANCY_UNITS_SHIFT   2   /* Quarter mm */
+#else
+#define OCCUPANCY_UNITS_SHIFT   0
+#endif
+
+/* Observation of a zone */
+#define OCCUPANCY_KIND_NONE     0U  /* Nothing to apply */
+#define OCCUPANCY_KIND_HIT      1U  /* Free ray, occupied end */
+#define OCCUPANCY_KIND_FREE     2U  /* Free ray and end */
+
+/**
+ * @brief Division rounded towards minus infinity
+ */
+static int32_t occupancy_floor_div(
+        int32_t value,
+        int32_t divisor)
+{
+    return (value >= 0) ? value / divisor : -((divisor - 1 - value) / divisor);
+}
+
+/**
+ * @brief Integer square root
+ */
+static uint32_t occupancy_sqrt(
+        uint32_t value)
+{
+    uint32_t root = 0;
+    uint32_t bit;
+
+    if (value == 0U) {
+        return 0;
+    }
+    bit = 1UL << ((31 - __builtin_clz(value)) & ~1);
+    while (bit != 0U) {
+        if (value >= root + bit) {
+            value -= root + bit;
+            root = (root >> 1) + bit;
+        } else {
+            root >>= 1;
+        }
+        bit >>= 2;
+    }
+    return root;
+}
+
+/**
+ * @brief Angle of a vector, 65536 per turn counterclockwise from x. The
+ * components are at most 32767.
+ */
+static uint32_t occupancy_angle(
+        int32_t x,
+        int32_t y)
+{
+    uint32_t ax = (uint32_t)((x >= 0) ? x : -x);
+    uint32_t ay = (uint32_t)((y >= 0) ? y : -y);
+    uint32_t t, angle;
+
+    if (ax == 0U && ay == 0U) {
+        return 0;
+    }
+
+    // atan(t) ~ t * (pi / 4 + 0.273 * (1 - t)) on the first octant
+    t = (ay <= ax) ? (ay << 15) / ax : (ax << 15) / ay;
+    angle = (t * (8192U + ((2847U * (32768U - t)) >> 15))) >> 15;
+    if (ay > ax) {
+        angle = 16384U - angle;
+    }
+    if (x < 0) {
+        angle = 32768U - angle;
+    }
+    if (y < 0) {
+        angle = (65536U - angle) & 0xFFFFU;
+    }
+    return angle;
+}
+
+/**
+ * @brief Cell of a point of the robot frame
+ * @param p_grid: Grid
+ * @param x_mm: x of the point
+ * @param y_mm: y of the point
+ * @return (uint16_t) index: cell, or VL53L7CX_OCCUPANCY_NO_CELL outside the
+ * grid
+ */
+uint16_t vl53l7cx_occupancy_cell(
+        const VL53L7CX_OccupancyGrid *p_grid,
+        int32_t x_mm,
+        int32_t y_mm)
+{
+    int32_t dx = x_mm - p_grid->origin_x_mm;
+    int32_t dy = y_mm - p_grid->origin_y_mm;
+
+    if (p_grid->type == VL53L7CX_OCCUPANCY_CARTESIAN) {
+        int32_t col = occupancy_floor_div(dx, p_grid->cell_mm) + p_grid->width / 2;
+        int32_t row = occupancy_floor_div(dy, p_grid->cell_mm) + p_grid->height / 2;
+
+        if (col < 0 || col >= p_grid->width || row < 0 || row >= p_grid->height) {
+            return VL53L7CX_OCCUPANCY_NO_CELL;
+        }
+        return (uint16_t)(row * p_grid->width + col);
+    } else {
+        // The radius of the grid is at most 32767 mm (checked by the init)
+        int32_t radius = (int32_t)p_grid->height * p_grid->cell_mm;
+        uint32_t ring, sector;
+
+        if (dx <= -radius || dx >= radius || dy <= -radius || dy >= radius) {
+            return VL53L7CX_OCCUPANCY_NO_CELL;
+        }
+        ring = occupancy_sqrt((uint32_t)(dx * dx) + (uint32_t)(dy * dy)) / p_grid->cell_mm;
+        if (ring >= p_grid->height) {
+            return VL53L7CX_OCCUPANCY_NO_CELL;
+        }
+        sector = (occupancy_angle(dx, dy) * p_grid->width) >> 16;
+        return (uint16_t)(ring * p_grid->width + sector);
+    }
+}
+
+/**
+ * @brief State of a cell
+ * @param p_grid: Grid
+ * @param cell: Index of the cell
+ * @return (uint8_t) state: VL53L7CX_OCCUPANCY_UNKNOWN (also outside the grid),
+ * VL53L7CX_OCCUPANCY_FREE or VL53L7CX_OCCUPANCY_OCCUPIED
+ */
+uint8_t vl53l7cx_occupancy_state(
+        const VL53L7CX_OccupancyGrid *p_grid,
+        uint16_t cell)
+{
+    int8_t value;
+
+    if (cell >= (uint32_t)p_grid->width * p_grid->height) {
+        return VL53L7CX_OCCUPANCY_UNKNOWN;
+    }
+    value = p_grid->cells[cell];
+    if (value >= p_grid->threshold) {
+        return VL53L7CX_OCCUPANCY_OCCUPIED;
+    } else if (value <= -p_grid->threshold) {
+        return VL53L7CX_OCCUPANCY_FREE;
+    }
+    return VL53L7CX_OCCUPANCY_UNKNOWN;
+}
+
+/**
+ * @brief Forget the zone observations of a sensor
+ */
+static void occupancy_forget(
+        VL53L7CX_OccupancySensor *p_sensor)
+{
+    uint8_t zone;
+
+    for (zone = 0; zone < 64U; zone++) {
+        p_sensor->last_kind[zone] = OCCUPANCY_KIND_NONE;
+        p_sensor->last_end[zone] = 0;
+        p_sensor->last_cell[zone] = VL53L7CX_OCCUPANCY_NO_CELL;
+        p_sensor->saturated[zone] = 0;
+    }
+}
+
+/**
+ * @brief Forget every cell and zone observation
+ * @param p_grid: Grid
+ */
+void vl53l7cx_occupancy_clear(
+        VL53L7CX_OccupancyGrid *p_grid)
+{
+    uint32_t i;
+    uint8_t sensor;
+
+    for (i = 0; i < VL53L7CX_OCCUPANCY_MAX_CELLS; i++) {
+        p_grid->cells[i] = 0;
+    }
+    for (sensor = 0; sensor < VL53L7CX_OCCUPANCY_MAX_SENSORS; sensor++) {
+        occupancy_forget(&p_grid->sensor[sensor]);
+    }
+}
+
+/**
+ * @brief Set up a grid, with the default log-odds, no height band and no
+ * sensor
+ * @param p_grid: Grid
+ * @param type: VL53L7CX_OCCUPANCY_CARTESIAN or VL53L7CX_OCCUPANCY_POLAR
+ * @param width: Columns, or sectors
+ * @param height: Rows, or rings
+ * @param cell_mm: Side of a cell, or width of a ring
+ * @param origin_x_mm: x of the centre of the grid in the robot frame
+ * @param origin_y_mm: y of the centre of the grid in the robot frame
+ * @return (uint8_t) status: 0 if OK, 255 for an invalid type, more than
+ * VL53L7CX_OCCUPANCY_MAX_CELLS cells, or a polar radius beyond 32767 mm
+ */
+uint8_t vl53l7cx_occupancy_init(
+        VL53L7CX_OccupancyGrid *p_grid,
+        uint8_t type,
+        uint16_t width,
+        uint16_t height,
+        uint16_t cell_mm,
+        int16_t origin_x_mm,
+        int16_t origin_y_mm)
+{
+    uint8_t sensor;
+
+    if ((type != VL53L7CX_OCCUPANCY_CARTESIAN && type != VL53L7CX_OCCUPANCY_POLAR)
+            || width == 0U || height == 0U || cell_mm == 0U
+            || (uint32_t)width * height > VL53L7CX_OCCUPANCY_MAX_CELLS
+            || (type == VL53L7CX_OCCUPANCY_POLAR && (uint32_t)height * cell_mm > 32767U)) {
+        return 255;
+    }
+
+    p_grid->type = type;
+    p_grid->width = width;
+    p_grid->height = height;
+    p_grid->cell_mm = cell_mm;
+    p_grid->origin_x_mm = origin_x_mm;
+    p_grid->origin_y_mm = origin_y_mm;
+    p_grid->incremental = 1;
+    p_grid->min_height_mm = INT16_MIN;
+    p_grid->max_height_mm = INT16_MAX;
+    p_grid->free_range_mm = 0;
+    p_grid->status_mask = VL53L7CX_OCCUPANCY_DEFAULT_STATUS_MASK;
+    p_grid->zones_applied = 0;
+    p_grid->zones_skipped = 0;
+    p_grid->cells_updated = 0;
+    (void)vl53l7cx_occupancy_set_log_odds(p_grid, VL53L7CX_OCCUPANCY_DEFAULT_HIT,
+            VL53L7CX_OCCUPANCY_DEFAULT_MISS, VL53L7CX_OCCUPANCY_DEFAULT_MIN,
+            VL53L7CX_OCCUPANCY_DEFAULT_MAX, VL53L7CX_OCCUPANCY_DEFAULT_THRESHOLD);
+    for (sensor = 0; sensor < VL53L7CX_OCCUPANCY_MAX_SENSORS; sensor++) {
+        p_grid->sensor[sensor].resolution = 0;
+    }
+    vl53l7cx_occupancy_clear(p_grid);
+
+    return 0;
+}
+
+/**
+ * @brief Set the pose of a sensor, and forget its zone observations
+ * @param p_grid: Grid
+ * @param sensor: Sensor, below VL53L7CX_OCCUPANCY_MAX_SENSORS
+ * @param resolution: VL53L7CX_RESOLUTION_4X4 or VL53L7CX_RESOLUTION_8X8
+ * @param x_mm: x of the sensor in the robot frame
+ * @param y_mm: y of the sensor in the robot frame
+ * @param height_mm: Height of the sensor above the floor
+ * @param yaw_deg: Direction of the sensor, counterclockwise from x
+ * @return (uint8_t) status: 0 if OK, 255 for an invalid sensor or resolution
+ */
+uint8_t vl53l7cx_occupancy_set_sensor(
+        VL53L7CX_OccupancyGrid *p_grid,
+        uint8_t sensor,
+        uint8_t resolution,
+        int16_t x_mm,
+        int16_t y_mm,
+        int16_t height_mm,
+        int16_t yaw_deg)
+{
+    const int16_t *rays = vl53l7cx_pointcloud_rays(resolution);
+    VL53L7CX_OccupancySensor *p_sensor;
+    int32_t c, s;
+    uint8_t zone;
+
+    if (sensor >= VL53L7CX_OCCUPANCY_MAX_SENSORS || rays == NULL) {
+        return 255;
+    }
+
+    p_sensor = &p_grid->sensor[sensor];
+    p_sensor->x_mm = x_mm;
+    p_sensor->y_mm = y_mm;
+    p_sensor->height_mm = height_mm;
+    p_sensor->yaw_deg = yaw_deg;
+    p_sensor->resolution = resolution;
+
+    // Sensor frame: x to the right (columns), y down (rows), z forward
+    c = vl53l7cx_pointcloud_sin((int32_t)yaw_deg + 90);
+    s = vl53l7cx_pointcloud_sin(yaw_deg);
+    for (zone = 0; zone < resolution; zone++) {
+        int32_t right = rays[zone];
+        int32_t down = rays[resolution + zone];
+        int32_t forward = rays[2U * resolution + zone];
+
+        p_sensor->ray_x[zone] = (int16_t)((forward * c + right * s + ((int32_t)1 << 14)) >> 15);
+        p_sensor->ray_y[zone] = (int16_t)((forward * s - right * c + ((int32_t)1 << 14)) >> 15);
+        p_sensor->ray_up[zone] = (int16_t)(-down);
+    }
+    occupancy_forget(p_sensor);
+
+    return 0;
+}
+
+/**
+ * @brief Set the log-odds of the updates, in 1/16 nat
+ * @param p_grid: Grid
+ * @param hit: Added to the cell of a target, above 0
+ * @param miss: Added to the cells crossed by a ray, below 0
+ * @param min: Lowest value of a cell, below 0
+ * @param max: Highest value of a cell, above 0
+ * @param threshold: Free at -threshold or below, occupied at threshold or
+ * above, from 1 to max
+ * @return (uint8_t) status: 0 if OK, 255 if the values are not consistent
+ */
+uint8_t vl53l7cx_occupancy_set_log_odds(
+        VL53L7CX_OccupancyGrid *p_grid,
+        int8_t hit,
+        int8_t miss,
+        int8_t min,
+        int8_t max,
+        int8_t threshold)
+{
+    uint8_t sensor;
+
+    if (hit <= 0 || miss >= 0 || min >= 0 || max <= 0 || threshold <= 0 || threshold > max
+            || -threshold < min) {
+        return 255;
+    }
+
+    p_grid->hit = hit;
+    p_grid->miss = miss;
+    p_grid->min = min;
+    p_grid->max = max;
+    p_grid->threshold = threshold;
+
+    // The cells are no longer at the bounds the zones saw
+    for (sensor = 0; sensor < VL53L7CX_OCCUPANCY_MAX_SENSORS; sensor++) {
+        occupancy_forget(&p_grid->sensor[sensor]);
+    }
+
+    return 0;
+}
+
+/**
+ * @brief Set the height band of the hits. Hits below it (the floor) only free
+ * their ray, hits above it are left out.
+ * @param p_grid: Grid
+ * @param min_height_mm: Lowest height above the floor
+ * @param max_height_mm: Highest height above the floor
+ */
+void vl53l7cx_occupancy_set_height_band(
+        VL53L7CX_OccupancyGrid *p_grid,
+        int16_t min_height_mm,
+        int16_t max_height_mm)
+{
+    p_grid->min_height_mm = min_height_mm;
+    p_grid->max_height_mm = max_height_mm;
+}
+
+/**
+ * @brief Set the range freed by zones without target (0: such zones are left
+ * out)
+ * @param p_grid: Grid
+ * @param free_range_mm: Range, below the range of the sensor in its mode
+ */
+void vl53l7cx_occupancy_set_free_range(
+        VL53L7CX_OccupancyGrid *p_grid,
+        uint16_t free_range_mm)
+{
+    p_grid->free_range_mm = free_range_mm;
+}
+
+/**
+ * @brief Set the accepted target status
+ * @param p_grid: Grid
+ * @param status_mask: Bit n accepts status n
+ */
+void vl53l7cx_occupancy_set_status_mask(
+        VL53L7CX_OccupancyGrid *p_grid,
+        uint32_t status_mask)
+{
+    p_grid->status_mask = status_mask;
+}
+
+/**
+ * @brief Skip the zones whose observation is unchanged and saturated (the
+ * default), or apply every zone of every frame
+ * @param p_grid: Grid
+ * @param incremental: 1 to skip, 0 to apply every zone
+ */
+void vl53l7cx_occupancy_set_incremental(
+        VL53L7CX_OccupancyGrid *p_grid,
+        uint8_t incremental)
+{
+    p_grid->incremental = incremental;
+}
+
+/**
+ * @brief Add a log-odds to a cell, clamped
+ * @return (uint8_t) saturated: 1 if the cell is at the bound of the delta
+ */
+static uint8_t occupancy_add(
+        VL53L7CX_OccupancyGrid *p_grid,
+        uint16_t cell,
+        int8_t delta)
+{
+    int32_t value = (int32_t)p_grid->cells[cell] + delta;
+
+    value = (value < p_grid->min) ? p_grid->min : value;
+    value = (value > p_grid->max) ? p_grid->max : value;
+    p_grid->cells[cell] = (int8_t)value;
+    p_grid->cells_updated++;
+    return (value == ((delta > 0) ? p_grid->max : p_grid->min)) ? 1U : 0U;
+}
+
+/**
+ * @brief Apply the ray of a zone: free from the sensor towards a point, up to
+ * the end cell, and the end cell occupied (hit) or free
+ * @return (uint8_t) saturated: 1 if every cell of the ray is at its bound
+ */
+static uint8_t occupancy_ray(
+        VL53L7CX_OccupancyGrid *p_grid,
+        const VL53L7CX_OccupancySensor *p_sensor,
+        int32_t to_x,
+        int32_t to_y,
+        uint16_t end,
+        uint8_t kind)
+{
+    int32_t dx = to_x - p_sensor->x_mm;
+    int32_t dy = to_y - p_sensor->y_mm;
+    int32_t length = ((dx >= 0) ? dx : -dx) > ((dy >= 0) ? dy : -dy)
+            ? ((dx >= 0) ? dx : -dx) : ((dy >= 0) ? dy : -dy);
+    int32_t step = (p_grid->cell_mm > 1U) ? p_grid->cell_mm / 2 : 1;
+    int32_t nb_steps = length / step + 1;
+    int32_t x = ((int32_t)p_sensor->x_mm << 8) + 128;
+    int32_t y = ((int32_t)p_sensor->y_mm << 8) + 128;
+    int32_t inc_x = dx * 256 / nb_steps;
+    int32_t inc_y = dy * 256 / nb_steps;
+    uint16_t previous = VL53L7CX_OCCUPANCY_NO_CELL;
+    uint8_t saturated = 1;
+    int32_t k;
+
+    // Samples at most half a cell apart along both axes, each cell once
+    for (k = 0; k < nb_steps; k++) {
+        uint16_t cell = vl53l7cx_occupancy_cell(p_grid, x >> 8, y >> 8);
+
+        if (cell == end && end != VL53L7CX_OCCUPANCY_NO_CELL) {
+            break;
+        }
+        if (cell != previous && cell != VL53L7CX_OCCUPANCY_NO_CELL) {
+            saturated &= occupancy_add(p_grid, cell, p_grid->miss);
+        }
+        previous = cell;
+        x += inc_x;
+        y += inc_y;
+    }
+
+    if (end != VL53L7CX_OCCUPANCY_NO_CELL) {
+        saturated &= occupancy_add(p_grid, end,
+                (kind == OCCUPANCY_KIND_HIT) ? p_grid->hit : p_grid->miss);
+    }
+    return saturated;
+}
+
+/**
+ * @brief Apply again the saturated zones whose last ray passes near a point,
+ * where a hit raised a cell their rays keep free. The test is widened by two
+ * cells: a ray crosses the whole of a cell.
+ */
+static void occupancy_unsaturate(
+        VL53L7CX_OccupancyGrid *p_grid,
+        int32_t x_mm,
+        int32_t y_mm)
+{
+    int64_t margin = 2 * (int64_t)p_grid->cell_mm;
+    int32_t unit = (p_grid->cell_mm >= 8U) ? p_grid->cell_mm / 8 : 1;
+    uint8_t sensor, zone;
+
+    for (sensor = 0; sensor < VL53L7CX_OCCUPANCY_MAX_SENSORS; sensor++) {
+        VL53L7CX_OccupancySensor *p_sensor = &p_grid->sensor[sensor];
+
+        for (zone = 0; zone < p_sensor->resolution; zone++) {
+            int64_t dx, dy, wx, wy, length, along, across;
+
+            if (p_sensor->saturated[zone] == 0U) {
+                continue;
+            }
+            // From the sensor to the point the ray aims at; |dx| + |dy| is at
+            // least its length
+            dx = (int64_t)(int16_t)(p_sensor->last_end[zone] >> 16) * unit + unit / 2
+                    - p_sensor->x_mm;
+            dy = (int64_t)(int16_t)(p_sensor->last_end[zone] & 0xFFFFU) * unit + unit / 2
+                    - p_sensor->y_mm;
+            wx = x_mm - p_sensor->x_mm;
+            wy = y_mm - p_sensor->y_mm;
+            length = ((dx >= 0) ? dx : -dx) + ((dy >= 0) ? dy : -dy);
+            along = wx * dx + wy * dy;
+            across = wx * dy - wy * dx;
+            if (((across >= 0) ? across : -across) <= margin * length
+                    && along >= -margin * length
+                    && along <= dx * dx + dy * dy + margin * length) {
+                p_sensor->saturated[zone] = 0;
+            }
+        }
+    }
+}
+
+/**
+ * @brief Accumulate a frame of a sensor
+ * @param p_grid: Grid
+ * @param sensor: Sensor, set by vl53l7cx_occupancy_set_sensor()
+ * @param p_results: Frame at the resolution of the sensor
+ * @return (uint8_t) status: 0 if OK, 255 if the sensor is not set
+ */
+uint8_t vl53l7cx_occupancy_update(
+        VL53L7CX_OccupancyGrid *p_grid,
+        uint8_t sensor,
+        const VL53L7CX_ResultsData *p_results)
+{
+    VL53L7CX_OccupancySensor *p_sensor;
+    uint8_t zone;
+
+    if (sensor >= VL53L7CX_OCCUPANCY_MAX_SENSORS
+            || p_grid->sensor[sensor].resolution == 0U) {
+        return 255;
+    }
+    p_sensor = &p_grid->sensor[sensor];
+
+    for (zone = 0; zone < p_sensor->resolution; zone++) {
+        uint32_t i = (uint32_t)zone * VL53L7CX_NB_TARGET_PER_ZONE;
+        uint8_t kind = OCCUPANCY_KIND_HIT;
+        int32_t range_mm = (p_results->distance_mm[i] + ((1 << OCCUPANCY_UNITS_SHIFT) >> 1))
+                >> OCCUPANCY_UNITS_SHIFT;
+        int32_t unit = (p_grid->cell_mm >= 8U) ? p_grid->cell_mm / 8 : 1;
+        int32_t end_x, end_y;
+        uint32_t end;
+        uint16_t cell;
+
+        // First (nearest) target: the obstacle of the zone
+#ifndef VL53L7CX_DISABLE_NB_TARGET_DETECTED
+        if (p_results->nb_target_detected[zone] == 0U) {
+            kind = (p_grid->free_range_mm != 0U) ? OCCUPANCY_KIND_FREE : OCCUPANCY_KIND_NONE;
+            range_mm = p_grid->free_range_mm;
+        }
+#endif
+#ifndef VL53L7CX_DISABLE_TARGET_STATUS
+        if (kind == OCCUPANCY_KIND_HIT && (p_results->target_status[i] >= 32U
+                || ((p_grid->status_mask >> p_results->target_status[i]) & 1U) == 0U)) {
+            kind = OCCUPANCY_KIND_NONE;
+        }
+#endif
+        if (kind == OCCUPANCY_KIND_HIT) {
+            int32_t up_mm = p_sensor->height_mm
+                    + ((range_mm * p_sensor->ray_up[zone] + ((int32_t)1 << 14)) >> 15);
+
+            if (up_mm < p_grid->min_height_mm) {
+                kind = OCCUPANCY_KIND_FREE;
+            } else if (up_mm > p_grid->max_height_mm) {
+                kind = OCCUPANCY_KIND_NONE;
+            }
+        }
+        if (kind == OCCUPANCY_KIND_NONE || range_mm <= 0) {
+            p_sensor->last_kind[zone] = OCCUPANCY_KIND_NONE;
+            continue;
+        }
+
+        end_x = p_sensor->x_mm + ((range_mm * p_sensor->ray_x[zone] + ((int32_t)1 << 14)) >> 15);
+        end_y = p_sensor->y_mm + ((range_mm * p_sensor->ray_y[zone] + ((int32_t)1 << 14)) >> 15);
+        cell = vl53l7cx_occupancy_cell(p_grid, end_x, end_y);
+
+        // The ray aims at the centre of the cell_mm / 8 square of the end
+        // point: the same end cell and square give the same ray, cell for
+        // cell
+        end = ((uint32_t)(occupancy_floor_div(end_x, unit) & 0xFFFF) << 16)
+                | (uint32_t)(occupancy_floor_div(end_y, unit) & 0xFFFF);
+
+        // Same observation, and its last application left its cells at their
+        // bounds: applying it again changes nothing, unless another zone has
+        // moved its end cell since (a ray crossing it)
+        if (p_grid->incremental && p_sensor->saturated[zone] != 0U
+                && kind == p_sensor->last_kind[zone] && end == p_sensor->last_end[zone]
+                && cell == p_sensor->last_cell[zone]) {
+            if (cell == VL53L7CX_OCCUPANCY_NO_CELL || p_grid->cells[cell]
+                    == ((kind == OCCUPANCY_KIND_HIT) ? p_grid->max : p_grid->min)) {
+                p_grid->zones_skipped++;
+                continue;
+            }
+        }
+
+        // A hit on a free cell: the zones keeping it free apply again
+        if (kind == OCCUPANCY_KIND_HIT && p_grid->incremental
+                && cell != VL53L7CX_OCCUPANCY_NO_CELL && p_grid->cells[cell] == p_grid->min) {
+            occupancy_unsaturate(p_grid, end_x, end_y);
+        }
+
+        p_sensor->last_kind[zone] = kind;
+        p_sensor->last_end[zone] = end;
+        p_sensor->last_cell[zone] = cell;
+        p_sensor->saturated[zone] = occupancy_ray(p_grid, p_sensor,
+                occupancy_floor_div(end_x, unit) * unit + unit / 2,
+                occupancy_floor_div(end_y, unit) * unit + unit / 2, cell, kind);
+        p_grid->zones_applied++;
+    }
+
+    return 0;
+}
@@ -0,0 +1,179 @@
+/**
+ * Occupancy Grid for VL53L7CX Driver
+ *
+ * Accumulates the frames of one or more sensors into a 2D occupancy grid of
+ * the robot frame (x forward, y left, in mm), Cartesian (square cells) or
+ * polar (sectors and rings around the origin), in log-odds: the cell of each
+ * valid zone is raised by the hit weight, the cells crossed by its ray from
+ * the sensor are lowered by the miss weight, and every cell is clamped.
+ *
+ * Each sensor has a pose on the robot: position, mounting height and yaw
+ * (0 = looking along x, 90 = along y). It is mounted upright, zone columns
+ * horizontal and zone row 0 on top, and its zone rays come from the point
+ * cloud tables (vl53l7cx_pointcloud_lut.h). The first target of a zone is the
+ * obstacle; hits outside the height band (the floor, overhangs) are left out.
+ *
+ * Memory is fixed: the grid and the state of every sensor live in
+ * VL53L7CX_OccupancyGrid. An update only touches the cells of the rays it
+ * applies, and a zone whose observation has not changed (same kind, same end
+ * cell and end point to an eighth of a cell, the ray aiming at the centre of
+ * that square) is applied again only until its cells are saturated, then
+ * skipped: once the scene is static, the cost of a frame follows the zones
+ * that changed, not the size of the grid. A skipped zone is applied again
+ * when another zone moves one of its cells off its bound: a miss on its end
+ * cell, or a hit near its ray. The grid then stays the one every zone applied
+ * would give, but for the order of the updates within a frame.
+ *
+ * Distances are read in the unit of the build: quarter mm with
+ * VL53L7CX_USE_RAW_FORMAT, mm otherwise.
+ */
+
+#ifndef _VL53L7CX_OCCUPANCY_H_
+#define _VL53L7CX_OCCUPANCY_H_
+
+#include <stdint.h>
+#include "vl53l7cx_api.h"
+
+#ifdef VL53L7CX_DISABLE_DISTANCE_MM
+#error "vl53l7cx_occupancy needs the distance output"
+#endif
+
+/**
+ * @brief Largest number of cells (1 byte each) and of sensors.
+ */
+
+#ifndef VL53L7CX_OCCUPANCY_MAX_CELLS
+#define VL53L7CX_OCCUPANCY_MAX_CELLS    16384U
+#endif
+
+#ifndef VL53L7CX_OCCUPANCY_MAX_SENSORS
+#define VL53L7CX_OCCUPANCY_MAX_SENSORS  4U
+#endif
+
+/**
+ * @brief Grid types.
+ */
+
+#define VL53L7CX_OCCUPANCY_CARTESIAN    ((uint8_t) 0U)
+#define VL53L7CX_OCCUPANCY_POLAR        ((uint8_t) 1U)
+
+/**
+ * @brief State of a cell, from its log-odds and the threshold.
+ */
+
+#define VL53L7CX_OCCUPANCY_UNKNOWN      ((uint8_t) 0U)
+#define VL53L7CX_OCCUPANCY_FREE         ((uint8_t) 1U)
+#define VL53L7CX_OCCUPANCY_OCCUPIED     ((uint8_t) 2U)
+
+/**
+ * @brief Cell index outside the grid.
+ */
+
+#define VL53L7CX_OCCUPANCY_NO_CELL      ((uint16_t) 0xFFFFU)
+
+/**
+ * @brief Default accepted target status (5 and 9) and log-odds, in 1/16 nat:
+ * a hit is p = 0.7 (+14), a miss p = 0.4 (-6), cells are clamped between
+ * p = 0.02 and p = 0.98 (-64, +64) and are free or occupied beyond p = 0.27
+ * and p = 0.73 (16).
+ */
+
+#define VL53L7CX_OCCUPANCY_DEFAULT_STATUS_MASK  ((uint32_t)((1UL << 5) | (1UL << 9)))
+#define VL53L7CX_OCCUPANCY_DEFAULT_HIT          14
+#define VL53L7CX_OCCUPANCY_DEFAULT_MISS         (-6)
+#define VL53L7CX_OCCUPANCY_DEFAULT_MIN          (-64)
+#define VL53L7CX_OCCUPANCY_DEFAULT_MAX          64
+#define VL53L7CX_OCCUPANCY_DEFAULT_THRESHOLD    16
+
+/**
+ * @brief Pose and zone state of a sensor.
+ */
+
+typedef struct
+{
+    int16_t            x_mm;           /* Position in the robot frame */
+    int16_t            y_mm;
+    int16_t            height_mm;      /* Height of the sensor above the floor */
+    int16_t            yaw_deg;
+    uint8_t            resolution;     /* 0 if the sensor is not set */
+    /* Ray of each zone in the robot frame, Q15: horizontal x, y and up */
+    int16_t            ray_x[64];
+    int16_t            ray_y[64];
+    int16_t            ray_up[64];
+    /* Last observation of each zone: kind, end point (in cell_mm / 8 units of
+     * the robot frame), end cell, and whether its last application left every
+     * cell of its ray at its bound */
+    uint8_t            last_kind[64];
+    uint32_t           last_end[64];
+    uint16_t           last_cell[64];
+    uint8_t            saturated[64];
+} VL53L7CX_OccupancySensor;
+
+/**
+ * @brief Occupancy grid, its parameters and sensors.
+ */
+
+typedef struct
+{
+    uint8_t            type;           /* VL53L7CX_OCCUPANCY_CARTESIAN or _POLAR */
+    uint16_t           width;          /* Columns, or sectors of 360 / width degrees */
+    uint16_t           height;         /* Rows, or rings */
+    uint16_t           cell_mm;        /* Cell side, or ring width */
+    int16_t            origin_x_mm;    /* Centre of the grid in the robot frame */
+    int16_t            origin_y_mm;
+    int8_t             hit;            /* Log-odds, 1/16 nat */
+    int8_t             miss;
+    int8_t             min;
+    int8_t             max;
+    int8_t             threshold;
+    uint8_t            incremental;    /* Skip saturated unchanged zones */
+    int16_t            min_height_mm;  /* Height band of the hits */
+    int16_t            max_height_mm;
+    uint16_t           free_range_mm;  /* Zones without target: free up to this range (0: off) */
+    uint32_t           status_mask;
+    /* Statistics since the init */
+    uint32_t           zones_applied;
+    uint32_t           zones_skipped;
+    uint32_t           cells_updated;
+    VL53L7CX_OccupancySensor sensor[VL53L7CX_OCCUPANCY_MAX_SENSORS];
+    int8_t             cells[VL53L7CX_OCCUPANCY_MAX_CELLS]; /* Row (ring) by row */
+} VL53L7CX_OccupancyGrid;
+
+/* Setup, with the default log-odds and no height band. Cartesian: width x
+ * height cells of cell_mm around the origin; polar: width sectors (sector 0
+ * starts along x, counterclockwise) and height rings of cell_mm from the
+ * origin. Returns 0 if OK, 255 for an invalid type or size. */
+uint8_t vl53l7cx_occupancy_init(VL53L7CX_OccupancyGrid *p_grid, uint8_t type, uint16_t width,
+        uint16_t height, uint16_t cell_mm, int16_t origin_x_mm, int16_t origin_y_mm);
+
+/* Pose of a sensor. Returns 0 if OK, 255 for an invalid sensor or
+ * resolution. */
+uint8_t vl53l7cx_occupancy_set_sensor(VL53L7CX_OccupancyGrid *p_grid, uint8_t sensor,
+        uint8_t resolution, int16_t x_mm, int16_t y_mm, int16_t height_mm, int16_t yaw_deg);
+
+/* Log-odds of a hit (> 0) and a miss (< 0), clamp and threshold. Returns 0 if
+ * OK, 255 if they are not consistent. */
+uint8_t vl53l7cx_occupancy_set_log_odds(VL53L7CX_OccupancyGrid *p_grid, int8_t hit, int8_t miss,
+        int8_t min, int8_t max, int8_t threshold);
+void vl53l7cx_occupancy_set_height_band(VL53L7CX_OccupancyGrid *p_grid, int16_t min_height_mm,
+        int16_t max_height_mm);
+void vl53l7cx_occupancy_set_free_range(VL53L7CX_OccupancyGrid *p_grid, uint16_t free_range_mm);
+void vl53l7cx_occupancy_set_status_mask(VL53L7CX_OccupancyGrid *p_grid, uint32_t status_mask);
+void vl53l7cx_occupancy_set_incremental(VL53L7CX_OccupancyGrid *p_grid, uint8_t incremental);
+
+/* Forget every cell and zone observation */
+void vl53l7cx_occupancy_clear(VL53L7CX_OccupancyGrid *p_grid);
+
+/* Accumulate a frame of a sensor, at the resolution of its pose. Returns 0 if
+ * OK, 255 if the sensor is not set. */
+uint8_t vl53l7cx_occupancy_update(VL53L7CX_OccupancyGrid *p_grid, uint8_t sensor,
+        const VL53L7CX_ResultsData *p_results);
+
+/* Cell of a point of the robot frame, or VL53L7CX_OCCUPANCY_NO_CELL */
+uint16_t vl53l7cx_occupancy_cell(const VL53L7CX_OccupancyGrid *p_grid, int32_t x_mm,
+        int32_t y_mm);
+
+/* VL53L7CX_OCCUPANCY_UNKNOWN, _FREE or _OCCUPIED */
+uint8_t vl53l7cx_occupancy_state(const VL53L7CX_OccupancyGrid *p_grid, uint16_t cell);
+
+#endif /* _VL53L7CX_OCCUPANCY_H_ */
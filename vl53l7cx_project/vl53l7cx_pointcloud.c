@@ -0,0 +1,173 @@
+/**
+ * Point Cloud Projection Implementation for VL53L7CX Driver
+ *
+ * See vl53l7cx_pointcloud.h. The validity of each point is found first, then
+ * the coordinates of every point are computed in a loop without branches
+ * (vectorized by the compiler on the host), then the mask is packed.
+ */
+
+#include <stddef.h>
+#include "vl53l7cx_pointcloud.h"
+#include "vl53l7cx_pointcloud_lut.h"
+
+/* Distance times a Q15 ray component, back to mm with rounding */
+#ifdef VL53L7CX_USE_RAW_FORMAT
+#define POINTCLOUD_SHIFT    17  /* Q15 and quarter mm */
+#else
+#define POINTCLOUD_SHIFT    15
+#endif
+
+#define POINTCLOUD_ROUND    ((int32_t)1 << (POINTCLOUD_SHIFT - 1))
+
+/* sin(0..90 degrees), Q15 */
+static const int16_t pointcloud_sine[91] = {
+        0,   572,  1144,  1715,  2286,  2856,  3425,  3993,  4560,  5126,
+     5690,  6252,  6813,  7371,  7927,  8481,  9032,  9580, 10126, 10668,
+    11207, 11743, 12275, 12803, 13328, 13848, 14364, 14876, 15383, 15886,
+    16383, 16876, 17364, 17846, 18323, 18794, 19260, 19720, 20173, 20621,
+    21062, 21497, 21925, 22347, 22762, 23170, 23571, 23964, 24351, 24730,
+    25101, 25465, 25821, 26169, 26509, 26841, 27165, 27481, 27788, 28087,
+    28377, 28659, 28932, 29196, 29451, 29697, 29934, 30162, 30381, 30591,
+    30791, 30982, 31163, 31335, 31498, 31650, 31794, 31927, 32051, 32165,
+    32269, 32364, 32448, 32523, 32587, 32642, 32687, 32722, 32747, 32762,
+    32767,
+};
+
+/**
+ * @brief Sine of an angle in degrees
+ * @param degrees: Angle, any value
+ * @return Sine, Q15
+ */
+int32_t vl53l7cx_pointcloud_sin(
+        int32_t degrees)
+{
+    degrees %= 360;
+    if (degrees < 0) {
+        degrees += 360;
+    }
+    if (degrees <= 90) {
+        return pointcloud_sine[degrees];
+    } else if (degrees <= 180) {
+        return pointcloud_sine[180 - degrees];
+    } else if (degrees <= 270) {
+        return -pointcloud_sine[degrees - 180];
+    }
+    return -pointcloud_sine[360 - degrees];
+}
+
+/**
+ * @brief Ray table of a resolution
+ * @param resolution: VL53L7CX_RESOLUTION_4X4 or VL53L7CX_RESOLUTION_8X8
+ * @return Table of 3 x resolution Q15 components (all x, all y, all z), or
+ * NULL for another resolution
+ */
+const int16_t *vl53l7cx_pointcloud_rays(
+        uint8_t resolution)
+{
+    switch (resolution) {
+        case VL53L7CX_RESOLUTION_4X4:
+            return &vl53l7cx_pointcloud_rays_4x4[0][0];
+        case VL53L7CX_RESOLUTION_8X8:
+            return &vl53l7cx_pointcloud_rays_8x8[0][0];
+        default:
+            return NULL;
+    }
+}
+
+/**
+ * @brief Project the targets of a frame into points
+ * @param p_results: Results of the frame
+ * @param resolution: Resolution of the frame (VL53L7CX_RESOLUTION_4X4 or
+ * VL53L7CX_RESOLUTION_8X8)
+ * @param status_mask: Accepted target status, bit n for status n
+ * @param p_cloud: Points of the frame
+ * @return (uint8_t) status: 0 if OK, 255 if the resolution is not supported
+ */
+uint8_t vl53l7cx_pointcloud_project(
+        const VL53L7CX_ResultsData *p_results,
+        uint8_t resolution,
+        uint32_t status_mask,
+        VL53L7CX_PointCloud *p_cloud)
+{
+    const int16_t *rays = vl53l7cx_pointcloud_rays(resolution);
+    uint16_t nb_points = (uint16_t)(resolution * VL53L7CX_NB_TARGET_PER_ZONE);
+    uint16_t i, zone;
+    uint32_t target, status;
+    uint16_t nb_valid = 0;
+    uint8_t valid[VL53L7CX_POINTCLOUD_MAX_POINTS];
+
+    if (rays == NULL) {
+        return 255;
+    }
+
+    const int16_t *ray_x = rays;
+    const int16_t *ray_y = rays + resolution;
+    const int16_t *ray_z = rays + 2U * resolution;
+
+    // Validity of each point: accepted status (one vectorized comparison pass
+    // per status of the mask), then detected target
+    for (i = 0; i < nb_points; i++) {
+#ifndef VL53L7CX_DISABLE_TARGET_STATUS
+        valid[i] = 0;
+#else
+        valid[i] = 1;
+#endif
+    }
+#ifndef VL53L7CX_DISABLE_TARGET_STATUS
+    for (status = 0; status < 32U; status++) {
+        if (((status_mask >> status) & 1U) == 0U) {
+            continue;
+        }
+        for (i = 0; i < nb_points; i++) {
+            valid[i] |= (uint8_t)(p_results->target_status[i] == status);
+        }
+    }
+#else
+    (void)status_mask;
+#endif
+#ifndef VL53L7CX_DISABLE_NB_TARGET_DETECTED
+    for (zone = 0; zone < resolution; zone++) {
+        for (target = 0; target < VL53L7CX_NB_TARGET_PER_ZONE; target++) {
+            i = (uint16_t)(zone * VL53L7CX_NB_TARGET_PER_ZONE + target);
+            valid[i] &= (uint8_t)(target < p_results->nb_target_detected[zone]);
+        }
+    }
+#endif
+
+    // Coordinates, (0, 0, 0) for invalid points: no branch, vectorized on the host
+    for (zone = 0; zone < resolution; zone++) {
+        int32_t rx = ray_x[zone];
+        int32_t ry = ray_y[zone];
+        int32_t rz = ray_z[zone];
+
+        for (target = 0; target < VL53L7CX_NB_TARGET_PER_ZONE; target++) {
+            i = (uint16_t)(zone * VL53L7CX_NB_TARGET_PER_ZONE + target);
+            int32_t d = p_results->distance_mm[i];
+            int32_t keep = -(int32_t)valid[i];
+
+            p_cloud->x_mm[i] = (int16_t)(((d * rx + POINTCLOUD_ROUND) >> POINTCLOUD_SHIFT) & keep);
+            p_cloud->y_mm[i] = (int16_t)(((d * ry + POINTCLOUD_ROUND) >> POINTCLOUD_SHIFT) & keep);
+            p_cloud->z_mm[i] = (int16_t)(((d * rz + POINTCLOUD_ROUND) >> POINTCLOUD_SHIFT) & keep);
+        }
+    }
+
+    // Validity mask, one word of 32 points at a time
+    for (i = 0; i < nb_points; i += 32U) {
+        uint16_t n = (uint16_t)(nb_points - i);
+        uint32_t word = 0;
+        uint16_t bit;
+
+        if (n > 32U) {
+            n = 32U;
+        }
+        for (bit = 0; bit < n; bit++) {
+            word |= (uint32_t)valid[i + bit] << bit;
+            nb_valid = (uint16_t)(nb_valid + valid[i + bit]);
+        }
+        p_cloud->valid_mask[i / 32U] = word;
+    }
+
+    p_cloud->nb_points = nb_points;
+    p_cloud->nb_valid = nb_valid;
+    return 0;
+}
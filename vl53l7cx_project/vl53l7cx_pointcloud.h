@@ -0,0 +1,74 @@
+/**
+ * Point Cloud Projection for VL53L7CX Driver
+ *
+ * Turns the distances of a frame into 3D points in the sensor frame: x grows
+ * with the zone column, y with the zone row, z is along the optical axis, in
+ * mm. The distance of a target is taken along the ray through the centre of
+ * its zone, whose unit vector comes from a table per resolution
+ * (vl53l7cx_pointcloud_lut.h, generated from the field of view by
+ * tools/pointcloud_lut.py): a point costs three 16 x 16-bit multiplications,
+ * with no trigonometry and no floating point at run time.
+ *
+ * Points are stored as a structure of arrays, in the order of the results
+ * arrays (zone * VL53L7CX_NB_TARGET_PER_ZONE + target), so multi-target builds
+ * give one point per target. A point is valid if its target was detected
+ * (nb_target_detected) and its target_status is accepted; invalid points are
+ * set to (0, 0, 0) so that vector code can process every lane and use the
+ * mask.
+ *
+ * Distances are read in the unit of the build: quarter mm with
+ * VL53L7CX_USE_RAW_FORMAT, mm otherwise.
+ */
+
+#ifndef _VL53L7CX_POINTCLOUD_H_
+#define _VL53L7CX_POINTCLOUD_H_
+
+#include <stdint.h>
+#include "vl53l7cx_api.h"
+
+#ifdef VL53L7CX_DISABLE_DISTANCE_MM
+#error "vl53l7cx_pointcloud needs the distance output"
+#endif
+
+/**
+ * @brief Largest number of points (8x8 zones, every target).
+ */
+
+#define VL53L7CX_POINTCLOUD_MAX_POINTS  ((uint16_t)(64U * VL53L7CX_NB_TARGET_PER_ZONE))
+
+/**
+ * @brief Default accepted target status: 5 (range valid) and 9 (range valid
+ * with large pulse). Bit n accepts status n.
+ */
+
+#define VL53L7CX_POINTCLOUD_DEFAULT_STATUS_MASK ((uint32_t)((1UL << 5) | (1UL << 9)))
+
+/**
+ * @brief Points of one frame. Coordinate arrays are 32-byte aligned for vector
+ * loads.
+ */
+
+typedef struct
+{
+    int16_t            x_mm[VL53L7CX_POINTCLOUD_MAX_POINTS] __attribute__((aligned(32)));
+    int16_t            y_mm[VL53L7CX_POINTCLOUD_MAX_POINTS] __attribute__((aligned(32)));
+    int16_t            z_mm[VL53L7CX_POINTCLOUD_MAX_POINTS] __attribute__((aligned(32)));
+    uint32_t           valid_mask[(VL53L7CX_POINTCLOUD_MAX_POINTS + 31U) / 32U]; /* Bit i: point i */
+    uint16_t           nb_points;      /* resolution * VL53L7CX_NB_TARGET_PER_ZONE */
+    uint16_t           nb_valid;
+} VL53L7CX_PointCloud;
+
+/* Ray table of a resolution: unit vectors in Q15 (32767 = 1.0), x of every
+ * zone, then y, then z. NULL if the resolution is not 4x4 or 8x8. */
+const int16_t *vl53l7cx_pointcloud_rays(uint8_t resolution);
+
+/* Sine of an angle in degrees, Q15, from a table (poses of sensors) */
+int32_t vl53l7cx_pointcloud_sin(int32_t degrees);
+
+/* Project a frame. status_mask selects the accepted target status
+ * (VL53L7CX_POINTCLOUD_DEFAULT_STATUS_MASK). Returns 0 if OK, 255 if the
+ * resolution is not 4x4 or 8x8. */
+uint8_t vl53l7cx_pointcloud_project(const VL53L7CX_ResultsData *p_results, uint8_t resolution,
+        uint32_t status_mask, VL53L7CX_PointCloud *p_cloud);
+
+#endif /* _VL53L7CX_POINTCLOUD_H_ */
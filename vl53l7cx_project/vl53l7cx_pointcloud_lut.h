@@ -0,0 +1,70 @@
+/**
+ * VL53L7CX Point Cloud Ray Tables
+ *
+ * Generated by tools/pointcloud_lut.py --fov 60 60, do not edit.
+ * Unit vector of the ray of each zone, Q15, x then y then z.
+ */
+
+#ifndef _VL53L7CX_POINTCLOUD_LUT_H_
+#define _VL53L7CX_POINTCLOUD_LUT_H_
+
+#include <stdint.h>
+
+#define VL53L7CX_POINTCLOUD_FOV_X_DEG	60.0f
+#define VL53L7CX_POINTCLOUD_FOV_Y_DEG	60.0f
+
+static const int16_t vl53l7cx_pointcloud_rays_4x4[3][16] = {
+	{ /* x */
+	-12100,  -4303,   4303,  12100,
+	-12908,  -4634,   4634,  12908,
+	-12908,  -4634,   4634,  12908,
+	-12100,  -4303,   4303,  12100,
+	},
+	{ /* y */
+	-12100, -12908, -12908, -12100,
+	 -4303,  -4634,  -4634,  -4303,
+	  4303,   4634,   4634,   4303,
+	 12100,  12908,  12908,  12100,
+	},
+	{ /* z */
+	 27945,  29810,  29810,  27945,
+	 29810,  32106,  32106,  29810,
+	 29810,  32106,  32106,  29810,
+	 27945,  29810,  29810,  27945,
+	}
+};
+
+static const int16_t vl53l7cx_pointcloud_rays_8x8[3][64] = {
+	{ /* x */
+	-13469, -10046,  -6217,  -2106,   2106,   6217,  10046,  13469,
+	-14064, -10532,  -6539,  -2219,   2219,   6539,  10532,  14064,
+	-14507, -10898,  -6784,  -2306,   2306,   6784,  10898,  14507,
+	-14745, -11097,  -6917,  -2353,   2353,   6917,  11097,  14745,
+	-14745, -11097,  -6917,  -2353,   2353,   6917,  11097,  14745,
+	-14507, -10898,  -6784,  -2306,   2306,   6784,  10898,  14507,
+	-14064, -10532,  -6539,  -2219,   2219,   6539,  10532,  14064,
+	-13469, -10046,  -6217,  -2106,   2106,   6217,  10046,  13469,
+	},
+	{ /* y */
+	-13469, -14064, -14507, -14745, -14745, -14507, -14064, -13469,
+	-10046, -10532, -10898, -11097, -11097, -10898, -10532, -10046,
+	 -6217,  -6539,  -6784,  -6917,  -6917,  -6784,  -6539,  -6217,
+	 -2106,  -2219,  -2306,  -2353,  -2353,  -2306,  -2219,  -2106,
+	  2106,   2219,   2306,   2353,   2353,   2306,   2219,   2106,
+	  6217,   6539,   6784,   6917,   6917,   6784,   6539,   6217,
+	 10046,  10532,  10898,  11097,  11097,  10898,  10532,  10046,
+	 13469,  14064,  14507,  14745,  14745,  14507,  14064,  13469,
+	},
+	{ /* z */
+	 26663,  27839,  28716,  29187,  29187,  28716,  27839,  26663,
+	 27839,  29187,  30203,  30752,  30752,  30203,  29187,  27839,
+	 28716,  30203,  31332,  31947,  31947,  31332,  30203,  28716,
+	 29187,  30752,  31947,  32599,  32599,  31947,  30752,  29187,
+	 29187,  30752,  31947,  32599,  32599,  31947,  30752,  29187,
+	 28716,  30203,  31332,  31947,  31947,  31332,  30203,  28716,
+	 27839,  29187,  30203,  30752,  30752,  30203,  29187,  27839,
+	 26663,  27839,  28716,  29187,  29187,  28716,  27839,  26663,
+	}
+};
+
+#endif /* _VL53L7CX_POINTCLOUD_LUT_H_ */
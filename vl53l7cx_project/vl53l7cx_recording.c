@@ -0,0 +1,386 @@
+/**
+ * Session Recording Implementation for VL53L7CX Driver
+ *
+ * Header, records and index writing. See vl53l7cx_recording.h.
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include "vl53l7cx_recording.h"
+
+#define VL53L7CX_RECORDING_IDLE         0U
+#define VL53L7CX_RECORDING_ACTIVE       1U
+#define VL53L7CX_RECORDING_FAILED       2U
+
+_Static_assert(sizeof(VL53L7CX_CalRecord) == VL53L7CX_RECORDING_CALIBRATION_SIZE,
+        "VL53L7CX_CalRecord changed: update VL53L7CX_RECORDING_CALIBRATION_SIZE "
+        "and VL53L7CX_RECORDING_VERSION");
+_Static_assert(VL53L7CX_STREAM_MAX_PACKET_SIZE >= VL53L7CX_RECORDING_SENSOR_SIZE,
+        "Sensor blocks are built in the record buffer");
+
+/**
+ * @brief Store little-endian values
+ */
+static void _vl53l7cx_recording_put_u16(
+        uint8_t *p_out,
+        uint16_t value)
+{
+    p_out[0] = (uint8_t)value;
+    p_out[1] = (uint8_t)(value >> 8);
+}
+
+static void _vl53l7cx_recording_put_u32(
+        uint8_t *p_out,
+        uint32_t value)
+{
+    _vl53l7cx_recording_put_u16(p_out, (uint16_t)value);
+    _vl53l7cx_recording_put_u16(&p_out[2], (uint16_t)(value >> 16));
+}
+
+static void _vl53l7cx_recording_put_u64(
+        uint8_t *p_out,
+        uint64_t value)
+{
+    _vl53l7cx_recording_put_u32(p_out, (uint32_t)value);
+    _vl53l7cx_recording_put_u32(&p_out[4], (uint32_t)(value >> 32));
+}
+
+/**
+ * @brief Append bytes, and stop the recording on the first error: a partial
+ * write would shift every record after it
+ */
+static uint8_t _vl53l7cx_recording_write(
+        VL53L7CX_Recording *p_rec,
+        const uint8_t *p_data,
+        uint32_t size)
+{
+    if (p_rec->state != VL53L7CX_RECORDING_ACTIVE) {
+        return 255; // Error: not recording
+    }
+    if (p_rec->p_ops->write(p_rec->p_ctx, p_data, size)) {
+        p_rec->state = VL53L7CX_RECORDING_FAILED;
+        return 255; // Error: write failed
+    }
+
+    return 0;
+}
+
+static uint8_t _vl53l7cx_recording_sync(
+        VL53L7CX_Recording *p_rec)
+{
+    if (p_rec->p_ops->sync && p_rec->p_ops->sync(p_rec->p_ctx)) {
+        p_rec->state = VL53L7CX_RECORDING_FAILED;
+        return 255; // Error: sync failed
+    }
+
+    return 0;
+}
+
+/**
+ * @brief Initialize a recording
+ * @param p_rec: Pointer to recording
+ * @param p_ops: Output operations
+ * @param p_ctx: Operations context, passed to every operation
+ * @return 0 if OK, non-zero if error
+ */
+uint8_t vl53l7cx_recording_init(
+        VL53L7CX_Recording *p_rec,
+        const VL53L7CX_RecordingOps *p_ops,
+        void *p_ctx)
+{
+    if (!p_rec || !p_ops || !p_ops->write) {
+        return 255; // Error: invalid parameters
+    }
+
+    memset(p_rec, 0, sizeof(*p_rec));
+    p_rec->p_ops = p_ops;
+    p_rec->p_ctx = p_ctx;
+    p_rec->sync_interval = VL53L7CX_RECORDING_SYNC_INTERVAL;
+
+    return 0;
+}
+
+/**
+ * @brief Fill the configuration of a sensor from the device
+ * @param p_dev: Initialized sensor
+ * @param sensor: Sensor index, as given to vl53l7cx_recording_add()
+ * @param p_sensor: Configuration, without calibration (p_calibration can be
+ * set afterwards, e.g. to a record loaded with vl53l7cx_calstore_load())
+ * @return 0 if OK, non-zero if error
+ */
+uint8_t vl53l7cx_recording_describe(
+        VL53L7CX_Configuration *p_dev,
+        uint8_t sensor,
+        VL53L7CX_RecordingSensor *p_sensor)
+{
+    uint8_t status = VL53L7CX_STATUS_OK;
+
+    memset(p_sensor, 0, sizeof(*p_sensor));
+    p_sensor->sensor = sensor;
+    p_sensor->i2c_address = p_dev->platform.address;
+
+    status |= vl53l7cx_get_ranging_mode(p_dev, &p_sensor->ranging_mode);
+    status |= vl53l7cx_get_ranging_frequency_hz(p_dev, &p_sensor->frequency_hz);
+    status |= vl53l7cx_get_target_order(p_dev, &p_sensor->target_order);
+    status |= vl53l7cx_get_sharpener_percent(p_dev, &p_sensor->sharpener_percent);
+    status |= vl53l7cx_get_integration_time_ms(p_dev, &p_sensor->integration_time_ms);
+
+    return status;
+}
+
+/**
+ * @brief Start a recording: write the header
+ * @param p_rec: Pointer to recording
+ * @param resolution: VL53L7CX_RESOLUTION_4X4 or VL53L7CX_RESOLUTION_8X8
+ * @param field_mask: Outputs kept in every record (VL53L7CX_OUTPUT_* bits,
+ * usually the output mask of the sensors)
+ * @param p_sensors: Sensor configurations, saved in the header
+ * @param nb_sensors: Number of sensor configurations (0 allowed)
+ * @param start_time_us: Start time, on the clock of the frame timestamps
+ * @return 0 if OK, non-zero if error
+ */
+uint8_t vl53l7cx_recording_begin(
+        VL53L7CX_Recording *p_rec,
+        uint8_t resolution,
+        uint16_t field_mask,
+        const VL53L7CX_RecordingSensor *p_sensors,
+        uint8_t nb_sensors,
+        uint64_t start_time_us)
+{
+    uint8_t *p_buf = p_rec->record;     // Header built block by block
+    uint32_t header_size = VL53L7CX_RECORDING_HEADER_SIZE
+            + (uint32_t)nb_sensors * VL53L7CX_RECORDING_SENSOR_SIZE + 4U;
+    uint32_t crc;
+    uint8_t i;
+
+    if (p_rec->state != VL53L7CX_RECORDING_IDLE || (nb_sensors && !p_sensors)) {
+        return 255; // Error: already started, or invalid parameters
+    }
+
+    p_rec->record_size = vl53l7cx_stream_packet_size(resolution, field_mask);
+    if (p_rec->record_size == 0U) {
+        return 255; // Error: invalid resolution
+    }
+    p_rec->resolution = resolution;
+    p_rec->field_mask = (uint16_t)(field_mask & VL53L7CX_OUTPUT_AVAILABLE
+            & ~VL53L7CX_OUTPUT_MANDATORY);     // As in the packets
+    p_rec->nb_records = 0;
+    p_rec->index_stride = 1;
+    p_rec->nb_entries = 0;
+    p_rec->state = VL53L7CX_RECORDING_ACTIVE;
+
+    memset(p_buf, 0, VL53L7CX_RECORDING_HEADER_SIZE);
+    _vl53l7cx_recording_put_u32(&p_buf[0], VL53L7CX_RECORDING_MAGIC);
+    _vl53l7cx_recording_put_u16(&p_buf[4], VL53L7CX_RECORDING_VERSION);
+    p_buf[6] = resolution;
+    p_buf[7] = VL53L7CX_NB_TARGET_PER_ZONE;
+    _vl53l7cx_recording_put_u16(&p_buf[8], p_rec->field_mask);
+    p_buf[10] = nb_sensors;
+    _vl53l7cx_recording_put_u32(&p_buf[12], header_size);
+    _vl53l7cx_recording_put_u32(&p_buf[16], p_rec->record_size);
+    _vl53l7cx_recording_put_u64(&p_buf[24], start_time_us);
+    crc = vl53l7cx_stream_crc32(0, p_buf, VL53L7CX_RECORDING_HEADER_SIZE);
+    if (_vl53l7cx_recording_write(p_rec, p_buf, VL53L7CX_RECORDING_HEADER_SIZE)) {
+        return 255; // Error: write failed
+    }
+
+    // Sensor blocks: configuration, then the calibration record as stored
+    for (i = 0; i < nb_sensors; i++) {
+        const VL53L7CX_RecordingSensor *p_sensor = &p_sensors[i];
+        const uint8_t *p_cal = (const uint8_t *)p_sensor->p_calibration;
+
+        memset(p_buf, 0, 16);
+        p_buf[0] = p_sensor->sensor;
+        p_buf[1] = p_sensor->ranging_mode;
+        p_buf[2] = p_sensor->frequency_hz;
+        p_buf[3] = p_sensor->target_order;
+        p_buf[4] = p_sensor->sharpener_percent;
+        _vl53l7cx_recording_put_u16(&p_buf[6], p_sensor->i2c_address);
+        _vl53l7cx_recording_put_u32(&p_buf[8], p_sensor->integration_time_ms);
+        _vl53l7cx_recording_put_u16(&p_buf[12],
+                p_cal ? (uint16_t)VL53L7CX_RECORDING_CALIBRATION_SIZE : 0U);
+        if (p_cal) {
+            memcpy(&p_buf[16], p_cal, VL53L7CX_RECORDING_CALIBRATION_SIZE);
+        } else {
+            memset(&p_buf[16], 0, VL53L7CX_RECORDING_CALIBRATION_SIZE);
+        }
+        crc = vl53l7cx_stream_crc32(crc, p_buf, VL53L7CX_RECORDING_SENSOR_SIZE);
+        if (_vl53l7cx_recording_write(p_rec, p_buf, VL53L7CX_RECORDING_SENSOR_SIZE)) {
+            return 255; // Error: write failed
+        }
+    }
+
+    _vl53l7cx_recording_put_u32(p_buf, crc);
+    if (_vl53l7cx_recording_write(p_rec, p_buf, 4)) {
+        return 255; // Error: write failed
+    }
+
+    return _vl53l7cx_recording_sync(p_rec);
+}
+
+/**
+ * @brief Append a frame
+ * @param p_rec: Pointer to recording
+ * @param sensor: Sensor index
+ * @param p_dev: Sensor the results come from (stream count)
+ * @param p_results: Frame results. Outputs of the recording field mask which
+ * the sensor does not send are recorded as they are in p_results.
+ * @param timestamp_us: Frame timestamp. Frames should be added in time order:
+ * readers look timestamps up by dichotomy.
+ * @return 0 if OK, non-zero if error
+ */
+uint8_t vl53l7cx_recording_add(
+        VL53L7CX_Recording *p_rec,
+        uint8_t sensor,
+        VL53L7CX_Configuration *p_dev,
+        const VL53L7CX_ResultsData *p_results,
+        uint64_t timestamp_us)
+{
+    VL53L7CX_StreamHeader header;
+    uint32_t size = 0;
+    uint32_t i;
+
+    if (p_rec->state != VL53L7CX_RECORDING_ACTIVE) {
+        return 255; // Error: not recording
+    }
+
+    header.sensor = sensor;
+    header.resolution = p_rec->resolution;
+    header.field_mask = p_rec->field_mask;
+    header.stream_count = p_dev->streamcount;
+    header.sequence = p_rec->nb_records;
+    header.timestamp_us = timestamp_us;
+    header.p_distance_ref = NULL;
+    if (vl53l7cx_stream_encode_packet(&header, p_results, p_rec->record,
+                sizeof(p_rec->record), &size)
+            || size != p_rec->record_size) {
+        return 255; // Error: encoding failed
+    }
+    if (_vl53l7cx_recording_write(p_rec, p_rec->record, size)) {
+        return 255; // Error: write failed
+    }
+
+    // Sparse index: when full, keep one entry out of two
+    if (p_rec->nb_records % p_rec->index_stride == 0U) {
+        if (p_rec->nb_entries == VL53L7CX_RECORDING_INDEX_SIZE) {
+            for (i = 0; i < VL53L7CX_RECORDING_INDEX_SIZE / 2U; i++) {
+                p_rec->index[i] = p_rec->index[2U * i];
+            }
+            p_rec->nb_entries = VL53L7CX_RECORDING_INDEX_SIZE / 2U;
+            p_rec->index_stride *= 2U;
+        }
+        if (p_rec->nb_records % p_rec->index_stride == 0U) {
+            p_rec->index[p_rec->nb_entries++] = timestamp_us;
+        }
+    }
+
+    p_rec->nb_records++;
+    if (p_rec->sync_interval != 0U && p_rec->nb_records % p_rec->sync_interval == 0U) {
+        return _vl53l7cx_recording_sync(p_rec);
+    }
+
+    return 0;
+}
+
+/**
+ * @brief End a recording: write the index and the trailer, then close the
+ * output. A failed recording is closed without index (readers recover it).
+ * @param p_rec: Pointer to recording
+ * @return 0 if OK, non-zero if error (recording failed before or now)
+ */
+uint8_t vl53l7cx_recording_end(
+        VL53L7CX_Recording *p_rec)
+{
+    uint8_t *p_buf = p_rec->record;
+    uint8_t status = (p_rec->state == VL53L7CX_RECORDING_ACTIVE) ? 0U : 255U;
+    uint32_t crc = 0;
+    uint32_t i;
+
+    if (status == 0U) {
+        // Index by blocks of the record buffer
+        for (i = 0; i < p_rec->nb_entries; i += sizeof(p_rec->record) / 8U) {
+            uint32_t count = p_rec->nb_entries - i;
+            uint32_t j;
+
+            if (count > sizeof(p_rec->record) / 8U) {
+                count = sizeof(p_rec->record) / 8U;
+            }
+            for (j = 0; j < count; j++) {
+                _vl53l7cx_recording_put_u64(&p_buf[8U * j], p_rec->index[i + j]);
+            }
+            crc = vl53l7cx_stream_crc32(crc, p_buf, 8U * count);
+            status |= _vl53l7cx_recording_write(p_rec, p_buf, 8U * count);
+        }
+
+        _vl53l7cx_recording_put_u32(&p_buf[0], VL53L7CX_RECORDING_INDEX_MAGIC);
+        _vl53l7cx_recording_put_u32(&p_buf[4], p_rec->nb_records);
+        _vl53l7cx_recording_put_u32(&p_buf[8], p_rec->index_stride);
+        _vl53l7cx_recording_put_u32(&p_buf[12], p_rec->nb_entries);
+        _vl53l7cx_recording_put_u32(&p_buf[16], 0);
+        crc = vl53l7cx_stream_crc32(crc, p_buf, VL53L7CX_RECORDING_TRAILER_SIZE - 4U);
+        _vl53l7cx_recording_put_u32(&p_buf[20], crc);
+        status |= _vl53l7cx_recording_write(p_rec, p_buf, VL53L7CX_RECORDING_TRAILER_SIZE);
+        status |= _vl53l7cx_recording_sync(p_rec);
+    }
+
+    if (p_rec->p_ops->close && p_rec->p_ops->close(p_rec->p_ctx)) {
+        status = 255; // Error: close failed
+    }
+    p_rec->state = VL53L7CX_RECORDING_IDLE;
+
+    return status;
+}
+
+/**
+ * @brief File output (host machine, or any target with a file system)
+ */
+static uint8_t _vl53l7cx_recording_file_write(
+        void *p_ctx,
+        const uint8_t *p_data,
+        uint32_t size)
+{
+    return (fwrite(p_data, 1, size, (FILE *)p_ctx) == size) ? 0U : 255U;
+}
+
+static uint8_t _vl53l7cx_recording_file_sync(
+        void *p_ctx)
+{
+    return (fflush((FILE *)p_ctx) == 0) ? 0U : 255U;
+}
+
+static uint8_t _vl53l7cx_recording_file_close(
+        void *p_ctx)
+{
+    return (fclose((FILE *)p_ctx) == 0) ? 0U : 255U;
+}
+
+static const VL53L7CX_RecordingOps vl53l7cx_recording_file_ops = {
+    .write = _vl53l7cx_recording_file_write,
+    .sync = _vl53l7cx_recording_file_sync,
+    .close = _vl53l7cx_recording_file_close,
+};
+
+/**
+ * @brief Initialize a recording into a new file (replaced if it exists),
+ * closed by vl53l7cx_recording_end()
+ * @param p_rec: Pointer to recording
+ * @param p_path: File path
+ * @return 0 if OK, non-zero if error
+ */
+uint8_t vl53l7cx_recording_init_file(
+        VL53L7CX_Recording *p_rec,
+        const char *p_path)
+{
+    FILE *p_file;
+
+    if (!p_rec || !p_path) {
+        return 255; // Error: invalid parameters
+    }
+
+    p_file = fopen(p_path, "wb");
+    if (!p_file) {
+        return 255; // Error: file can't be created
+    }
+
+    return vl53l7cx_recording_init(p_rec, &vl53l7cx_recording_file_ops, p_file);
+}
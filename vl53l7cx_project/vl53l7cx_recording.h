@@ -0,0 +1,161 @@
+/**
+ * Session Recording for VL53L7CX Driver
+ *
+ * Writes frames into a recording: an append-only file of fixed size records,
+ * so a reader maps it and reaches frame n at a computed offset, whatever the
+ * length of the session. All values are little-endian.
+ *
+ *   File header
+ *   0       4     Magic "VL7R"
+ *   4       2     Version (VL53L7CX_RECORDING_VERSION)
+ *   6       1     Resolution (number of zones, 16 or 64)
+ *   7       1     Targets per zone (VL53L7CX_NB_TARGET_PER_ZONE)
+ *   8       2     Field mask of every record (VL53L7CX_OUTPUT_* bits)
+ *   10      1     Number of sensor blocks
+ *   11      1     Reserved (0)
+ *   12      4     Header size: this header, the sensor blocks and the CRC
+ *   16      4     Record size
+ *   20      4     Reserved (0)
+ *   24      8     Start time (us, clock of the timestamps)
+ *   32      ...   Sensor blocks (VL53L7CX_RECORDING_SENSOR_SIZE each):
+ *                   0    1     Sensor index
+ *                   1    1     Ranging mode (VL53L7CX_RANGING_MODE_*)
+ *                   2    1     Ranging frequency (Hz)
+ *                   3    1     Target order (VL53L7CX_TARGET_ORDER_*)
+ *                   4    1     Sharpener (%)
+ *                   5    1     Reserved (0)
+ *                   6    2     I2C address
+ *                   8    4     Integration time (ms)
+ *                   12   2     Calibration size (0: none)
+ *                   14   2     Reserved (0)
+ *                   16   1284  Calibration: VL53L7CX_CalRecord, as stored by
+ *                              vl53l7cx_calstore.c, or zeros
+ *   end-4   4     CRC-32 of the header
+ *
+ *   Records, one per frame: an unframed packet of vl53l7cx_stream.h without
+ *   delta coding (vl53l7cx_stream_encode_packet()), so every record has the
+ *   same size. Its sequence field is the record number in the file.
+ *
+ *   Index and trailer, written by vl53l7cx_recording_end():
+ *   0       8 x n Timestamp of records 0, stride, 2 x stride, ...
+ *   end-24  4     Magic "VL7I"
+ *   end-20  4     Number of records
+ *   end-16  4     Index stride
+ *   end-12  4     Number of index entries (n)
+ *   end-8   4     Reserved (0)
+ *   end-4   4     CRC-32 of the index and trailer
+ *
+ * Writes are sequential and the file is valid at any time: a recording cut
+ * before vl53l7cx_recording_end() (power loss, crash) has no trailer, and a
+ * reader counts the records from the file size, dropping a torn last record
+ * (CRC and sequence checked). Records are synced every sync_interval frames.
+ *
+ * The index is sparse and bounded (VL53L7CX_RECORDING_INDEX_SIZE entries): the
+ * stride doubles each time it fills up, so hours of frames fit in 2 KB of RAM.
+ * A reader looks a timestamp up in the index, then in at most stride records.
+ *
+ * Output goes through a table of operations: a file (see
+ * vl53l7cx_recording_init_file()), or any sequential byte sink. Recordings are
+ * read on host machines with host/vl53l7cx_recording.hpp.
+ */
+
+#ifndef _VL53L7CX_RECORDING_H_
+#define _VL53L7CX_RECORDING_H_
+
+#include <stdint.h>
+#include "vl53l7cx_api.h"
+#include "vl53l7cx_calstore.h"
+#include "vl53l7cx_stream.h"
+
+/**
+ * @brief File format. VL53L7CX_RECORDING_VERSION must be incremented each time
+ * the layout changes.
+ */
+
+#define VL53L7CX_RECORDING_MAGIC        0x52374C56U     /* "VL7R" */
+#define VL53L7CX_RECORDING_INDEX_MAGIC  0x49374C56U     /* "VL7I" */
+#define VL53L7CX_RECORDING_VERSION      1U
+#define VL53L7CX_RECORDING_HEADER_SIZE  32U
+#define VL53L7CX_RECORDING_CALIBRATION_SIZE 1284U       /* sizeof(VL53L7CX_CalRecord) */
+#define VL53L7CX_RECORDING_SENSOR_SIZE  (16U + VL53L7CX_RECORDING_CALIBRATION_SIZE)
+#define VL53L7CX_RECORDING_TRAILER_SIZE 24U
+
+/**
+ * @brief Index entries kept in RAM (8 bytes each).
+ */
+
+#ifndef VL53L7CX_RECORDING_INDEX_SIZE
+#define VL53L7CX_RECORDING_INDEX_SIZE   256U
+#endif
+
+/**
+ * @brief Default number of records between two syncs (about 4 s at 15 Hz).
+ */
+
+#define VL53L7CX_RECORDING_SYNC_INTERVAL 64U
+
+/**
+ * @brief Configuration of a sensor, saved in the file header.
+ */
+
+typedef struct
+{
+    uint8_t            sensor;
+    uint8_t            ranging_mode;
+    uint8_t            frequency_hz;
+    uint8_t            target_order;
+    uint8_t            sharpener_percent;
+    uint16_t           i2c_address;
+    uint32_t           integration_time_ms;
+    const VL53L7CX_CalRecord *p_calibration;   /* NULL if none */
+} VL53L7CX_RecordingSensor;
+
+/**
+ * @brief Output operations. write() appends to the recording, sync() makes
+ * what was written durable, close() releases the output (both optional).
+ */
+
+typedef struct
+{
+    uint8_t  (*write)(void *p_ctx, const uint8_t *p_data, uint32_t size);
+    uint8_t  (*sync)(void *p_ctx);
+    uint8_t  (*close)(void *p_ctx);
+} VL53L7CX_RecordingOps;
+
+/**
+ * @brief Recording instance.
+ */
+
+typedef struct
+{
+    const VL53L7CX_RecordingOps *p_ops;
+    void               *p_ctx;
+    uint8_t            state;          /* Idle, recording or failed */
+    uint8_t            resolution;
+    uint16_t           field_mask;
+    uint32_t           record_size;
+    uint32_t           nb_records;
+    uint32_t           sync_interval;  /* Records between syncs, 0: never */
+    uint32_t           index_stride;
+    uint32_t           nb_entries;
+    uint64_t           index[VL53L7CX_RECORDING_INDEX_SIZE];
+    uint8_t            record[VL53L7CX_STREAM_MAX_PACKET_SIZE];
+} VL53L7CX_Recording;
+
+/* Setup */
+uint8_t vl53l7cx_recording_init(VL53L7CX_Recording *p_rec, const VL53L7CX_RecordingOps *p_ops,
+        void *p_ctx);
+uint8_t vl53l7cx_recording_init_file(VL53L7CX_Recording *p_rec, const char *p_path);
+uint8_t vl53l7cx_recording_describe(VL53L7CX_Configuration *p_dev, uint8_t sensor,
+        VL53L7CX_RecordingSensor *p_sensor);
+
+/* Recording */
+uint8_t vl53l7cx_recording_begin(VL53L7CX_Recording *p_rec, uint8_t resolution,
+        uint16_t field_mask, const VL53L7CX_RecordingSensor *p_sensors, uint8_t nb_sensors,
+        uint64_t start_time_us);
+uint8_t vl53l7cx_recording_add(VL53L7CX_Recording *p_rec, uint8_t sensor,
+        VL53L7CX_Configuration *p_dev, const VL53L7CX_ResultsData *p_results,
+        uint64_t timestamp_us);
+uint8_t vl53l7cx_recording_end(VL53L7CX_Recording *p_rec);
+
+#endif /* _VL53L7CX_RECORDING_H_ */
@@ -0,0 +1,110 @@
+/**
+ * Results Ring Implementation for VL53L7CX Driver
+ *
+ * Single-producer / single-consumer handoff of results slots. See
+ * vl53l7cx_results_ring.h.
+ */
+
+#include <stddef.h>
+#include "vl53l7cx_results_ring.h"
+
+/**
+ * @brief Reset a ring. Must not be called while a side is running.
+ * @param p_ring: Pointer to ring
+ */
+void vl53l7cx_results_ring_init(
+        VL53L7CX_ResultsRing *p_ring)
+{
+    p_ring->head = 0;
+    p_ring->tail = 0;
+    p_ring->overruns = 0;
+}
+
+/**
+ * @brief Get the next free slot (producer side)
+ * @param p_ring: Pointer to ring
+ * @return Slot to fill, or NULL if the consumer holds every slot. In that case
+ * the frame is counted as an overrun.
+ */
+VL53L7CX_ResultsSlot *vl53l7cx_results_ring_begin_write(
+        VL53L7CX_ResultsRing *p_ring)
+{
+    uint32_t head = p_ring->head;
+    uint32_t tail = __atomic_load_n(&p_ring->tail, __ATOMIC_ACQUIRE);
+
+    if ((head - tail) >= VL53L7CX_RESULTS_RING_SIZE) {
+        __atomic_store_n(&p_ring->overruns, p_ring->overruns + 1U, __ATOMIC_RELAXED);
+        return NULL; // Ring full
+    }
+
+    return &p_ring->slots[head & (VL53L7CX_RESULTS_RING_SIZE - 1U)];
+}
+
+/**
+ * @brief Publish the slot returned by vl53l7cx_results_ring_begin_write()
+ * @param p_ring: Pointer to ring
+ */
+void vl53l7cx_results_ring_end_write(
+        VL53L7CX_ResultsRing *p_ring)
+{
+    // Publish the slot after its content
+    __atomic_store_n(&p_ring->head, p_ring->head + 1U, __ATOMIC_RELEASE);
+}
+
+/**
+ * @brief Get the oldest published slot (consumer side)
+ * @param p_ring: Pointer to ring
+ * @return Slot to read, or NULL if the ring is empty
+ */
+VL53L7CX_ResultsSlot *vl53l7cx_results_ring_begin_read(
+        VL53L7CX_ResultsRing *p_ring)
+{
+    uint32_t tail = p_ring->tail;
+    uint32_t head = __atomic_load_n(&p_ring->head, __ATOMIC_ACQUIRE);
+
+    if (head == tail) {
+        return NULL; // Ring empty
+    }
+
+    return &p_ring->slots[tail & (VL53L7CX_RESULTS_RING_SIZE - 1U)];
+}
+
+/**
+ * @brief Give the slot returned by vl53l7cx_results_ring_begin_read() back to
+ * the producer
+ * @param p_ring: Pointer to ring
+ */
+void vl53l7cx_results_ring_end_read(
+        VL53L7CX_ResultsRing *p_ring)
+{
+    // Release the slot once it has been read
+    __atomic_store_n(&p_ring->tail, p_ring->tail + 1U, __ATOMIC_RELEASE);
+}
+
+/**
+ * @brief Number of published slots not yet released
+ * @param p_ring: Pointer to ring
+ * @return Number of slots (a snapshot when called from the other side)
+ */
+uint32_t vl53l7cx_results_ring_count(
+        VL53L7CX_ResultsRing *p_ring)
+{
+    uint32_t tail = __atomic_load_n(&p_ring->tail, __ATOMIC_ACQUIRE);
+    uint32_t head = __atomic_load_n(&p_ring->head, __ATOMIC_ACQUIRE);
+
+    return head - tail;
+}
+
+/**
+ * @brief Read the ring counters
+ * @param p_ring: Pointer to ring
+ * @param p_stats: Pointer to store the counters
+ */
+void vl53l7cx_results_ring_get_stats(
+        VL53L7CX_ResultsRing *p_ring,
+        VL53L7CX_ResultsRingStats *p_stats)
+{
+    p_stats->published = __atomic_load_n(&p_ring->head, __ATOMIC_ACQUIRE);
+    p_stats->consumed = __atomic_load_n(&p_ring->tail, __ATOMIC_ACQUIRE);
+    p_stats->overruns = __atomic_load_n(&p_ring->overruns, __ATOMIC_RELAXED);
+}
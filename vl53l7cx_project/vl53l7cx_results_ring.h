@@ -0,0 +1,80 @@
+/**
+ * Results Ring for VL53L7CX Driver
+ *
+ * Lock-free single-producer / single-consumer ring of results slots, used to
+ * hand frames from the core that owns the sensor to the core that consumes
+ * them. The producer fills a slot in place and publishes it, the consumer reads
+ * it in place and releases it: no frame is copied.
+ *
+ * Only GCC/Clang __atomic builtins are used (no SDK dependency), so the ring
+ * runs unchanged on both RP2350 cores and on two threads of a host machine.
+ */
+
+#ifndef _VL53L7CX_RESULTS_RING_H_
+#define _VL53L7CX_RESULTS_RING_H_
+
+#include <stdint.h>
+#include "vl53l7cx_api.h"
+
+/**
+ * @brief Number of results slots. Must be a power of 2 (2 gives ping-pong
+ * buffers).
+ */
+
+#ifndef VL53L7CX_RESULTS_RING_SIZE
+#define VL53L7CX_RESULTS_RING_SIZE      4U
+#endif
+
+/**
+ * @brief One frame and its acquisition metadata.
+ */
+
+typedef struct
+{
+    VL53L7CX_ResultsData results;
+    uint64_t           timestamp_us;   /* Frame ready time (producer clock) */
+    uint32_t           sequence;       /* Producer frame counter */
+    uint8_t            status;         /* vl53l7cx_get_ranging_data() status */
+    uint8_t            streamcount;    /* Driver streamcount of the frame */
+} VL53L7CX_ResultsSlot;
+
+/**
+ * @brief Ring counters. Each one is only written by one side.
+ */
+
+typedef struct
+{
+    uint32_t           published;      /* Slots published by the producer */
+    uint32_t           overruns;       /* Frames dropped: ring full (producer) */
+    uint32_t           consumed;       /* Slots released by the consumer */
+} VL53L7CX_ResultsRingStats;
+
+/**
+ * @brief Ring instance. head is only written by the producer, tail only by the
+ * consumer.
+ */
+
+typedef struct
+{
+    VL53L7CX_ResultsSlot slots[VL53L7CX_RESULTS_RING_SIZE];
+    volatile uint32_t  head;
+    volatile uint32_t  tail;
+    volatile uint32_t  overruns;
+} VL53L7CX_ResultsRing;
+
+/* Setup (before both sides start) */
+void vl53l7cx_results_ring_init(VL53L7CX_ResultsRing *p_ring);
+
+/* Producer side */
+VL53L7CX_ResultsSlot *vl53l7cx_results_ring_begin_write(VL53L7CX_ResultsRing *p_ring);
+void vl53l7cx_results_ring_end_write(VL53L7CX_ResultsRing *p_ring);
+
+/* Consumer side */
+VL53L7CX_ResultsSlot *vl53l7cx_results_ring_begin_read(VL53L7CX_ResultsRing *p_ring);
+void vl53l7cx_results_ring_end_read(VL53L7CX_ResultsRing *p_ring);
+
+/* Either side */
+uint32_t vl53l7cx_results_ring_count(VL53L7CX_ResultsRing *p_ring);
+void vl53l7cx_results_ring_get_stats(VL53L7CX_ResultsRing *p_ring, VL53L7CX_ResultsRingStats *p_stats);
+
+#endif /* _VL53L7CX_RESULTS_RING_H_ */
@@ -0,0 +1,553 @@
+/**
+ * Binary Frame Stream Implementation for VL53L7CX Driver
+ *
+ * Packet encoding and framing. See vl53l7cx_stream.h.
+ */
+
+#include <string.h>
+#include "vl53l7cx_delta.h"
+#include "vl53l7cx_stream.h"
+
+/**
+ * @brief CRC-32 (IEEE 802.3, reflected) nibble table: 64 bytes, about 4 times
+ * faster than the bitwise loop on a 1.4 KB packet
+ */
+static const uint32_t vl53l7cx_stream_crc_table[16] = {
+    0x00000000U, 0x1DB71064U, 0x3B6E20C8U, 0x26D930ACU,
+    0x76DC4190U, 0x6B6B51F4U, 0x4DB26158U, 0x5005713CU,
+    0xEDB88320U, 0xF00F9344U, 0xD6D6A3E8U, 0xCB61B38CU,
+    0x9B64C2B0U, 0x86D3D2D4U, 0xA00AE278U, 0xBDBDF21CU,
+};
+
+/**
+ * @brief Add one byte to a running CRC-32 (not inverted)
+ */
+static uint32_t _vl53l7cx_stream_crc_byte(
+        uint32_t crc,
+        uint8_t byte)
+{
+    crc ^= byte;
+    crc = (crc >> 4) ^ vl53l7cx_stream_crc_table[crc & 0x0FU];
+    return (crc >> 4) ^ vl53l7cx_stream_crc_table[crc & 0x0FU];
+}
+
+/**
+ * @brief CRC-32 (IEEE 802.3) of a buffer, the one of the stream packets. Also
+ * used by the calibration store and the recordings.
+ * @param crc: CRC of the previous bytes (0 to start)
+ * @param p_data: Data
+ * @param size: Number of bytes
+ * @return CRC-32 of the previous bytes and p_data
+ */
+uint32_t vl53l7cx_stream_crc32(
+        uint32_t crc,
+        const uint8_t *p_data,
+        uint32_t size)
+{
+    uint32_t i;
+
+    crc = ~crc;
+    for (i = 0; i < size; i++) {
+        crc = _vl53l7cx_stream_crc_byte(crc, p_data[i]);
+    }
+
+    return ~crc;
+}
+
+/**
+ * @brief Encoder state: the packet is COBS encoded and its CRC computed while
+ * it is written, in one pass and without an intermediate copy. Unframed
+ * packets (recordings) are written as is.
+ */
+typedef struct
+{
+    uint8_t            *p_out;
+    uint32_t           size;           /* Output capacity */
+    uint32_t           pos;            /* Next output byte */
+    uint32_t           code_pos;       /* Code byte of the current COBS block */
+    uint8_t            code;           /* Current COBS block length + 1 */
+    uint8_t            framed;
+    uint8_t            overflow;
+    uint32_t           crc;
+} VL53L7CX_StreamEncoder;
+
+/**
+ * @brief Start a frame
+ */
+static void _vl53l7cx_stream_begin(
+        VL53L7CX_StreamEncoder *p_enc,
+        uint8_t *p_out,
+        uint32_t size,
+        uint8_t framed)
+{
+    p_enc->p_out = p_out;
+    p_enc->size = size;
+    p_enc->pos = framed ? 2U : 0U;  // Leading delimiter, then the first code byte
+    p_enc->code_pos = 1;
+    p_enc->code = 1;
+    p_enc->framed = framed;
+    p_enc->overflow = framed && (size < 3U);
+    p_enc->crc = 0xFFFFFFFFU;
+
+    if (framed && !p_enc->overflow) {
+        p_out[0] = 0x00;
+    }
+}
+
+/**
+ * @brief Close the current COBS block and open the next one
+ */
+static void _vl53l7cx_stream_next_block(
+        VL53L7CX_StreamEncoder *p_enc)
+{
+    p_enc->p_out[p_enc->code_pos] = p_enc->code;
+    p_enc->code_pos = p_enc->pos++;
+    p_enc->code = 1;
+}
+
+/**
+ * @brief Append one byte to the frame (no CRC update)
+ */
+static void _vl53l7cx_stream_put_raw(
+        VL53L7CX_StreamEncoder *p_enc,
+        uint8_t byte)
+{
+    if (!p_enc->framed) {
+        if (p_enc->overflow || p_enc->pos >= p_enc->size) {
+            p_enc->overflow = 1;
+            return;
+        }
+        p_enc->p_out[p_enc->pos++] = byte;
+        return;
+    }
+
+    // A byte needs at most 2 output bytes: itself and a new code byte
+    if (p_enc->overflow || p_enc->pos + 2U > p_enc->size) {
+        p_enc->overflow = 1;
+        return;
+    }
+
+    if (byte == 0U) {
+        _vl53l7cx_stream_next_block(p_enc);
+        return;
+    }
+
+    p_enc->p_out[p_enc->pos++] = byte;
+    p_enc->code++;
+    if (p_enc->code == 0xFFU) {
+        _vl53l7cx_stream_next_block(p_enc);
+    }
+}
+
+/**
+ * @brief Append one byte to the packet
+ */
+static void _vl53l7cx_stream_put(
+        VL53L7CX_StreamEncoder *p_enc,
+        uint8_t byte)
+{
+    p_enc->crc = _vl53l7cx_stream_crc_byte(p_enc->crc, byte);
+    _vl53l7cx_stream_put_raw(p_enc, byte);
+}
+
+/**
+ * @brief Append little-endian values to the packet
+ */
+static void _vl53l7cx_stream_put_u8(
+        VL53L7CX_StreamEncoder *p_enc,
+        const uint8_t *p_values,
+        uint32_t count)
+{
+    uint32_t i;
+
+    for (i = 0; i < count; i++) {
+        _vl53l7cx_stream_put(p_enc, p_values[i]);
+    }
+}
+
+static void _vl53l7cx_stream_put_u16(
+        VL53L7CX_StreamEncoder *p_enc,
+        const uint16_t *p_values,
+        uint32_t count)
+{
+    uint32_t i;
+
+    for (i = 0; i < count; i++) {
+        _vl53l7cx_stream_put(p_enc, (uint8_t)p_values[i]);
+        _vl53l7cx_stream_put(p_enc, (uint8_t)(p_values[i] >> 8));
+    }
+}
+
+static void _vl53l7cx_stream_put_u32(
+        VL53L7CX_StreamEncoder *p_enc,
+        const uint32_t *p_values,
+        uint32_t count)
+{
+    uint32_t i;
+    uint8_t shift;
+
+    for (i = 0; i < count; i++) {
+        for (shift = 0; shift < 32U; shift += 8U) {
+            _vl53l7cx_stream_put(p_enc, (uint8_t)(p_values[i] >> shift));
+        }
+    }
+}
+
+/**
+ * @brief Close the packet: CRC, last COBS block and trailing delimiter
+ * @return Frame (or unframed packet) size, 0 if the output buffer is too small
+ */
+static uint32_t _vl53l7cx_stream_end(
+        VL53L7CX_StreamEncoder *p_enc)
+{
+    uint32_t crc = ~p_enc->crc;
+    uint8_t shift;
+
+    for (shift = 0; shift < 32U; shift += 8U) {
+        _vl53l7cx_stream_put_raw(p_enc, (uint8_t)(crc >> shift));
+    }
+
+    if (!p_enc->framed) {
+        return p_enc->overflow ? 0U : p_enc->pos;
+    }
+    if (p_enc->overflow || p_enc->pos >= p_enc->size) {
+        return 0;
+    }
+
+    p_enc->p_out[p_enc->code_pos] = p_enc->code;
+    p_enc->p_out[p_enc->pos++] = 0x00;
+
+    return p_enc->pos;
+}
+
+/**
+ * @brief Field mask actually sent: fields disabled at compile time and
+ * mandatory outputs removed
+ */
+static uint16_t _vl53l7cx_stream_mask(
+        uint16_t field_mask)
+{
+    return (uint16_t)(field_mask & VL53L7CX_OUTPUT_AVAILABLE & ~VL53L7CX_OUTPUT_MANDATORY);
+}
+
+/**
+ * @brief Encode one packet, framed or not (see vl53l7cx_stream_encode())
+ */
+static uint8_t _vl53l7cx_stream_encode(
+        const VL53L7CX_StreamHeader *p_header,
+        const VL53L7CX_ResultsData *p_results,
+        uint8_t *p_frame,
+        uint32_t frame_size,
+        uint8_t framed,
+        uint32_t *p_size,
+        uint8_t *p_delta)
+{
+    VL53L7CX_StreamEncoder enc;
+    uint16_t mask = _vl53l7cx_stream_mask(p_header->field_mask);
+    uint32_t zones = p_header->resolution;
+    uint32_t targets = zones * VL53L7CX_NB_TARGET_PER_ZONE;
+    uint64_t timestamp_us = p_header->timestamp_us;
+    uint8_t shift;
+#ifndef VL53L7CX_DISABLE_DISTANCE_MM
+    uint8_t delta[2U * VL53L7CX_RESOLUTION_8X8 * VL53L7CX_NB_TARGET_PER_ZONE];
+    uint32_t delta_size = 0;
+#endif
+
+    if (zones != VL53L7CX_RESOLUTION_4X4 && zones != VL53L7CX_RESOLUTION_8X8) {
+        return 255; // Error: invalid resolution
+    }
+
+#ifndef VL53L7CX_DISABLE_DISTANCE_MM
+    // Delta tokens only if they fit in the raw size
+    if ((mask & VL53L7CX_OUTPUT_DISTANCE_MM) && p_header->p_distance_ref) {
+        delta_size = vl53l7cx_delta_encode(p_results->distance_mm,
+                p_header->p_distance_ref, targets, delta, 2U * targets);
+        if (delta_size != 0U) {
+            mask |= VL53L7CX_STREAM_DELTA;
+        }
+    }
+#endif
+
+    _vl53l7cx_stream_begin(&enc, p_frame, frame_size, framed);
+
+    // Header
+    _vl53l7cx_stream_put(&enc, VL53L7CX_STREAM_VERSION);
+    _vl53l7cx_stream_put(&enc, p_header->sensor);
+    _vl53l7cx_stream_put(&enc, p_header->resolution);
+    _vl53l7cx_stream_put(&enc, VL53L7CX_NB_TARGET_PER_ZONE);
+    _vl53l7cx_stream_put_u16(&enc, &mask, 1);
+    _vl53l7cx_stream_put(&enc, p_header->stream_count);
+    _vl53l7cx_stream_put(&enc, (uint8_t)p_results->silicon_temp_degc);
+    _vl53l7cx_stream_put_u32(&enc, &p_header->sequence, 1);
+    for (shift = 0; shift < 64U; shift += 8U) {
+        _vl53l7cx_stream_put(&enc, (uint8_t)(timestamp_us >> shift));
+    }
+
+    // Fields, by increasing bit
+#ifndef VL53L7CX_DISABLE_AMBIENT_PER_SPAD
+    if (mask & VL53L7CX_OUTPUT_AMBIENT_PER_SPAD) {
+        _vl53l7cx_stream_put_u32(&enc, p_results->ambient_per_spad, zones);
+    }
+#endif
+#ifndef VL53L7CX_DISABLE_NB_SPADS_ENABLED
+    if (mask & VL53L7CX_OUTPUT_NB_SPADS_ENABLED) {
+        _vl53l7cx_stream_put_u32(&enc, p_results->nb_spads_enabled, zones);
+    }
+#endif
+#ifndef VL53L7CX_DISABLE_NB_TARGET_DETECTED
+    if (mask & VL53L7CX_OUTPUT_NB_TARGET_DETECTED) {
+        _vl53l7cx_stream_put_u8(&enc, p_results->nb_target_detected, zones);
+    }
+#endif
+#ifndef VL53L7CX_DISABLE_SIGNAL_PER_SPAD
+    if (mask & VL53L7CX_OUTPUT_SIGNAL_PER_SPAD) {
+        _vl53l7cx_stream_put_u32(&enc, p_results->signal_per_spad, targets);
+    }
+#endif
+#ifndef VL53L7CX_DISABLE_RANGE_SIGMA_MM
+    if (mask & VL53L7CX_OUTPUT_RANGE_SIGMA_MM) {
+        _vl53l7cx_stream_put_u16(&enc, p_results->range_sigma_mm, targets);
+    }
+#endif
+#ifndef VL53L7CX_DISABLE_DISTANCE_MM
+    if (mask & VL53L7CX_STREAM_DELTA) {
+        _vl53l7cx_stream_put_u8(&enc, delta, delta_size);
+    } else if (mask & VL53L7CX_OUTPUT_DISTANCE_MM) {
+        _vl53l7cx_stream_put_u16(&enc, (const uint16_t *)p_results->distance_mm, targets);
+    }
+#endif
+#ifndef VL53L7CX_DISABLE_REFLECTANCE_PERCENT
+    if (mask & VL53L7CX_OUTPUT_REFLECTANCE_PERCENT) {
+        _vl53l7cx_stream_put_u8(&enc, p_results->reflectance, targets);
+    }
+#endif
+#ifndef VL53L7CX_DISABLE_TARGET_STATUS
+    if (mask & VL53L7CX_OUTPUT_TARGET_STATUS) {
+        _vl53l7cx_stream_put_u8(&enc, p_results->target_status, targets);
+    }
+#endif
+#ifndef VL53L7CX_DISABLE_MOTION_INDICATOR
+    if (mask & VL53L7CX_OUTPUT_MOTION_INDICATOR) {
+        _vl53l7cx_stream_put_u32(&enc, &p_results->motion_indicator.global_indicator_1, 1);
+        _vl53l7cx_stream_put_u32(&enc, &p_results->motion_indicator.global_indicator_2, 1);
+        _vl53l7cx_stream_put(&enc, p_results->motion_indicator.status);
+        _vl53l7cx_stream_put(&enc, p_results->motion_indicator.nb_of_detected_aggregates);
+        _vl53l7cx_stream_put(&enc, p_results->motion_indicator.nb_of_aggregates);
+        _vl53l7cx_stream_put(&enc, p_results->motion_indicator.spare);
+        _vl53l7cx_stream_put_u32(&enc, p_results->motion_indicator.motion, 32);
+    }
+#endif
+
+    *p_size = _vl53l7cx_stream_end(&enc);
+    if (*p_size == 0U) {
+        return 255; // Error: output buffer too small
+    }
+    if (p_delta) {
+        *p_delta = (mask & VL53L7CX_STREAM_DELTA) ? 1U : 0U;
+    }
+
+    return 0;
+}
+
+/**
+ * @brief Encode and frame one packet
+ * @param p_header: Packet header. Fields disabled at compile time are removed
+ * from the mask. If p_distance_ref is set, distances are delta coded when it
+ * makes them smaller.
+ * @param p_results: Frame results
+ * @param p_frame: Output buffer, VL53L7CX_STREAM_MAX_FRAME_SIZE bytes is always
+ * enough
+ * @param frame_size: Output buffer size
+ * @param p_size: Frame size, delimiters included
+ * @param p_delta: Set to 1 if the distances were delta coded, 0 if they were
+ * sent raw (keyframe, or tokens larger than the raw distances). May be NULL.
+ * @return 0 if OK, non-zero if error
+ */
+uint8_t vl53l7cx_stream_encode(
+        const VL53L7CX_StreamHeader *p_header,
+        const VL53L7CX_ResultsData *p_results,
+        uint8_t *p_frame,
+        uint32_t frame_size,
+        uint32_t *p_size,
+        uint8_t *p_delta)
+{
+    return _vl53l7cx_stream_encode(p_header, p_results, p_frame, frame_size, 1, p_size,
+            p_delta);
+}
+
+/**
+ * @brief Encode one packet without framing and without delta coding: its size
+ * only depends on the resolution and the field mask (see
+ * vl53l7cx_stream_packet_size()). Used for the records of a recording.
+ * @param p_header: Packet header, p_distance_ref is ignored
+ * @param p_results: Frame results
+ * @param p_packet: Output buffer, VL53L7CX_STREAM_MAX_PACKET_SIZE bytes is
+ * always enough
+ * @param packet_size: Output buffer size
+ * @param p_size: Packet size
+ * @return 0 if OK, non-zero if error
+ */
+uint8_t vl53l7cx_stream_encode_packet(
+        const VL53L7CX_StreamHeader *p_header,
+        const VL53L7CX_ResultsData *p_results,
+        uint8_t *p_packet,
+        uint32_t packet_size,
+        uint32_t *p_size)
+{
+    VL53L7CX_StreamHeader header = *p_header;
+
+    header.p_distance_ref = NULL;
+    return _vl53l7cx_stream_encode(&header, p_results, p_packet, packet_size, 0, p_size,
+            NULL);
+}
+
+/**
+ * @brief Size of a packet without delta coding
+ * @param resolution: VL53L7CX_RESOLUTION_4X4 or VL53L7CX_RESOLUTION_8X8
+ * @param field_mask: VL53L7CX_OUTPUT_* bits, as given in the packet header
+ * @return Packet size, 0 if the resolution is invalid
+ */
+uint32_t vl53l7cx_stream_packet_size(
+        uint8_t resolution,
+        uint16_t field_mask)
+{
+    uint16_t mask = _vl53l7cx_stream_mask(field_mask);
+    uint32_t zones = resolution;
+    uint32_t targets = zones * VL53L7CX_NB_TARGET_PER_ZONE;
+    uint32_t size = VL53L7CX_STREAM_HEADER_SIZE + VL53L7CX_STREAM_CRC_SIZE;
+
+    if (zones != VL53L7CX_RESOLUTION_4X4 && zones != VL53L7CX_RESOLUTION_8X8) {
+        return 0; // Error: invalid resolution
+    }
+
+    size += (mask & VL53L7CX_OUTPUT_AMBIENT_PER_SPAD) ? 4U * zones : 0U;
+    size += (mask & VL53L7CX_OUTPUT_NB_SPADS_ENABLED) ? 4U * zones : 0U;
+    size += (mask & VL53L7CX_OUTPUT_NB_TARGET_DETECTED) ? zones : 0U;
+    size += (mask & VL53L7CX_OUTPUT_SIGNAL_PER_SPAD) ? 4U * targets : 0U;
+    size += (mask & VL53L7CX_OUTPUT_RANGE_SIGMA_MM) ? 2U * targets : 0U;
+    size += (mask & VL53L7CX_OUTPUT_DISTANCE_MM) ? 2U * targets : 0U;
+    size += (mask & VL53L7CX_OUTPUT_REFLECTANCE_PERCENT) ? targets : 0U;
+    size += (mask & VL53L7CX_OUTPUT_TARGET_STATUS) ? targets : 0U;
+    size += (mask & VL53L7CX_OUTPUT_MOTION_INDICATOR) ? VL53L7CX_STREAM_MOTION_SIZE : 0U;
+
+    return size;
+}
+
+/**
+ * @brief Initialize a stream
+ * @param p_stream: Pointer to stream
+ * @param p_ops: Stream operations
+ * @param p_ctx: Operations context, passed to every operation
+ * @param sensor: Sensor index, sent in each packet
+ * @return 0 if OK, non-zero if error
+ */
+uint8_t vl53l7cx_stream_init(
+        VL53L7CX_Stream *p_stream,
+        const VL53L7CX_StreamOps *p_ops,
+        void *p_ctx,
+        uint8_t sensor)
+{
+    if (!p_stream || !p_ops || !p_ops->write) {
+        return 255; // Error: invalid parameters
+    }
+
+    p_stream->p_ops = p_ops;
+    p_stream->p_ctx = p_ctx;
+    p_stream->sensor = sensor;
+    p_stream->sequence = 0;
+    p_stream->nb_errors = 0;
+    p_stream->nb_bytes = 0;
+#ifndef VL53L7CX_DISABLE_DISTANCE_MM
+    p_stream->keyframe_interval = 0;
+    p_stream->frames_since_key = 0;
+    p_stream->ref_resolution = 0;
+#endif
+
+    return 0;
+}
+
+/**
+ * @brief Enable delta coding of distances (vl53l7cx_delta.h): a static scene
+ * needs 1 byte per 128 unchanged zones, sensor noise of a few mm 1 byte per
+ * zone, instead of 2.
+ * @param p_stream: Pointer to stream
+ * @param keyframe_interval: One frame out of keyframe_interval is sent raw, so
+ * a reader which lost a frame recovers. 0 or 1 disables delta coding.
+ * @return 0 if OK, non-zero if error
+ */
+uint8_t vl53l7cx_stream_set_delta(
+        VL53L7CX_Stream *p_stream,
+        uint8_t keyframe_interval)
+{
+#ifndef VL53L7CX_DISABLE_DISTANCE_MM
+    p_stream->keyframe_interval = keyframe_interval;
+    p_stream->ref_resolution = 0;   // Start with a keyframe
+    return 0;
+#else
+    return 255; // Error: distances disabled at compile time
+#endif
+}
+
+/**
+ * @brief Send a frame: every output selected with vl53l7cx_set_output_mask()
+ * @param p_stream: Pointer to stream
+ * @param p_dev: Sensor the results come from
+ * @param p_results: Results of vl53l7cx_get_ranging_data()
+ * @param resolution: Current resolution (VL53L7CX_RESOLUTION_4X4 or 8X8)
+ * @param timestamp_us: Frame timestamp
+ * @return 0 if OK, non-zero if error
+ */
+uint8_t vl53l7cx_stream_send(
+        VL53L7CX_Stream *p_stream,
+        VL53L7CX_Configuration *p_dev,
+        const VL53L7CX_ResultsData *p_results,
+        uint8_t resolution,
+        uint64_t timestamp_us)
+{
+    VL53L7CX_StreamHeader header;
+    uint32_t size = 0;
+    uint8_t delta = 0;
+
+    header.sensor = p_stream->sensor;
+    header.resolution = resolution;
+    header.field_mask = (uint16_t)p_dev->output_mask;
+    header.stream_count = p_dev->streamcount;
+    header.sequence = p_stream->sequence++;
+    header.timestamp_us = timestamp_us;
+    header.p_distance_ref = NULL;
+#ifndef VL53L7CX_DISABLE_DISTANCE_MM
+    if (p_stream->ref_resolution == resolution
+            && p_stream->frames_since_key < p_stream->keyframe_interval) {
+        header.p_distance_ref = p_stream->ref_distance;
+    }
+#endif
+
+    if (vl53l7cx_stream_encode(&header, p_results, p_stream->frame,
+                sizeof(p_stream->frame), &size, &delta)
+            || p_stream->p_ops->write(p_stream->p_ctx, p_stream->frame, size)) {
+        p_stream->nb_errors++;
+#ifndef VL53L7CX_DISABLE_DISTANCE_MM
+        p_stream->ref_resolution = 0;   // Reader may have lost it: next is a keyframe
+#endif
+        return 255; // Error: encoding or write failed
+    }
+
+    p_stream->nb_bytes += size;
+
+#ifndef VL53L7CX_DISABLE_DISTANCE_MM
+    // The frame sent is the reference of the next one
+    if (p_stream->keyframe_interval > 1U
+            && (p_dev->output_mask & VL53L7CX_OUTPUT_DISTANCE_MM)) {
+        memcpy(p_stream->ref_distance, p_results->distance_mm,
+                (uint32_t)resolution * VL53L7CX_NB_TARGET_PER_ZONE * sizeof(int16_t));
+        // A raw frame (keyframe or delta fallback) restarts the interval
+        p_stream->frames_since_key = delta
+                ? (uint8_t)(p_stream->frames_since_key + 1U) : 1U;
+        p_stream->ref_resolution = resolution;
+    } else {
+        p_stream->ref_resolution = 0;
+    }
+#endif
+
+    return 0;
+}
@@ -0,0 +1,152 @@
+/**
+ * Binary Frame Stream for VL53L7CX Driver
+ *
+ * Sends each frame as a compact binary packet instead of a printf grid: every
+ * enabled output is sent lossless, for about the size of the text dump of the
+ * distances alone, and without formatting cost.
+ *
+ * Packet, before framing (all values little-endian):
+ *
+ *   Offset  Size  Content
+ *   0       1     Version (VL53L7CX_STREAM_VERSION)
+ *   1       1     Sensor index
+ *   2       1     Resolution (number of zones, 16 or 64)
+ *   3       1     Targets per zone (VL53L7CX_NB_TARGET_PER_ZONE)
+ *   4       2     Field mask (VL53L7CX_OUTPUT_* bits, VL53L7CX_STREAM_DELTA)
+ *   6       1     Sensor stream count
+ *   7       1     Silicon temperature (degC, signed)
+ *   8       4     Sequence (frames sent on this stream)
+ *   12      8     Timestamp (us)
+ *   20      ...   One array per field of the mask, by increasing bit:
+ *                   AMBIENT_PER_SPAD      uint32 x zones
+ *                   NB_SPADS_ENABLED      uint32 x zones
+ *                   NB_TARGET_DETECTED    uint8  x zones
+ *                   SIGNAL_PER_SPAD       uint32 x zones x targets
+ *                   RANGE_SIGMA_MM        uint16 x zones x targets
+ *                   DISTANCE_MM           int16  x zones x targets, or
+ *                                         delta tokens (VL53L7CX_STREAM_DELTA)
+ *                   REFLECTANCE_PERCENT   uint8  x zones x targets
+ *                   TARGET_STATUS         uint8  x zones x targets
+ *                   MOTION_INDICATOR      uint32 x 2, uint8 x 4, uint32 x 32
+ *   end-4   4     CRC-32 (IEEE 802.3) of every byte before it
+ *
+ * Delta coding (optional, see vl53l7cx_stream_set_delta()): distances are
+ * coded against the previous frame of the stream (vl53l7cx_delta.h), with a
+ * keyframe (raw distances) every keyframe_interval frames. A frame sent raw
+ * because its tokens would be larger counts as a keyframe. A reader which lost
+ * a frame recovers at the next keyframe.
+ *
+ * Framing: the packet is COBS encoded (no 0x00 byte inside), between two 0x00
+ * delimiters, so a reader joining mid-stream, or text mixed into the stream,
+ * only costs the frame it overlaps.
+ *
+ * Packets are written through a table of operations: USB CDC on the Pico 2
+ * (see VL53L7CX_StreamInitPico() in platform_pico.c), or any byte sink. A
+ * reference decoder for host machines is in host/vl53l7cx_stream.hpp.
+ */
+
+#ifndef _VL53L7CX_STREAM_H_
+#define _VL53L7CX_STREAM_H_
+
+#include <stdint.h>
+#include "vl53l7cx_api.h"
+
+/**
+ * @brief Packet format. VL53L7CX_STREAM_VERSION must be incremented each time
+ * the packet layout changes.
+ */
+
+#define VL53L7CX_STREAM_VERSION         2U
+#define VL53L7CX_STREAM_HEADER_SIZE     20U
+#define VL53L7CX_STREAM_CRC_SIZE        4U
+#define VL53L7CX_STREAM_MOTION_SIZE     140U
+
+/**
+ * @brief Field mask bit set when DISTANCE_MM holds delta tokens.
+ */
+
+#define VL53L7CX_STREAM_DELTA           0x1000U
+
+/**
+ * @brief Largest packet (8x8, every field) and its framed size (COBS adds one
+ * byte per 254, plus the code byte and the two delimiters).
+ */
+
+#define VL53L7CX_STREAM_MAX_PACKET_SIZE (VL53L7CX_STREAM_HEADER_SIZE \
+        + (64U * (4U + 4U + 1U)) \
+        + (64U * VL53L7CX_NB_TARGET_PER_ZONE * (4U + 2U + 2U + 1U + 1U)) \
+        + VL53L7CX_STREAM_MOTION_SIZE + VL53L7CX_STREAM_CRC_SIZE)
+#define VL53L7CX_STREAM_MAX_FRAME_SIZE  (VL53L7CX_STREAM_MAX_PACKET_SIZE \
+        + (VL53L7CX_STREAM_MAX_PACKET_SIZE / 254U) + 3U)
+
+/**
+ * @brief Packet header, as given to vl53l7cx_stream_encode().
+ */
+
+typedef struct
+{
+    uint8_t            sensor;
+    uint8_t            resolution;     /* VL53L7CX_RESOLUTION_4X4 or 8X8 */
+    uint16_t           field_mask;     /* VL53L7CX_OUTPUT_* bits, mandatory bits ignored */
+    uint8_t            stream_count;
+    uint32_t           sequence;
+    uint64_t           timestamp_us;
+    const int16_t      *p_distance_ref; /* Previous distances, NULL for a keyframe */
+} VL53L7CX_StreamHeader;
+
+/**
+ * @brief Stream operations. write() sends a whole frame (delimiters included).
+ */
+
+typedef struct
+{
+    uint8_t  (*write)(void *p_ctx, const uint8_t *p_data, uint32_t size);
+} VL53L7CX_StreamOps;
+
+/**
+ * @brief Stream instance.
+ */
+
+typedef struct
+{
+    const VL53L7CX_StreamOps *p_ops;
+    void               *p_ctx;
+    uint8_t            sensor;
+    uint32_t           sequence;       /* Next frame sequence */
+    uint32_t           nb_errors;      /* Frames not sent (encoding or write error) */
+    uint32_t           nb_bytes;       /* Bytes sent */
+    uint8_t            frame[VL53L7CX_STREAM_MAX_FRAME_SIZE];
+#ifndef VL53L7CX_DISABLE_DISTANCE_MM
+    /* Delta coding */
+    uint8_t            keyframe_interval;  /* 0: off */
+    uint8_t            frames_since_key;
+    uint8_t            ref_resolution;     /* 0: no reference */
+    int16_t            ref_distance[VL53L7CX_RESOLUTION_8X8 * VL53L7CX_NB_TARGET_PER_ZONE];
+#endif
+} VL53L7CX_Stream;
+
+/* Setup */
+uint8_t vl53l7cx_stream_init(VL53L7CX_Stream *p_stream, const VL53L7CX_StreamOps *p_ops,
+        void *p_ctx, uint8_t sensor);
+uint8_t vl53l7cx_stream_set_delta(VL53L7CX_Stream *p_stream, uint8_t keyframe_interval);
+
+/* Frames */
+uint8_t vl53l7cx_stream_encode(const VL53L7CX_StreamHeader *p_header,
+        const VL53L7CX_ResultsData *p_results, uint8_t *p_frame, uint32_t frame_size,
+        uint32_t *p_size, uint8_t *p_delta);
+uint8_t vl53l7cx_stream_send(VL53L7CX_Stream *p_stream, VL53L7CX_Configuration *p_dev,
+        const VL53L7CX_ResultsData *p_results, uint8_t resolution, uint64_t timestamp_us);
+
+/* Unframed packets (recordings, see vl53l7cx_recording.h) */
+uint8_t vl53l7cx_stream_encode_packet(const VL53L7CX_StreamHeader *p_header,
+        const VL53L7CX_ResultsData *p_results, uint8_t *p_packet, uint32_t packet_size,
+        uint32_t *p_size);
+uint32_t vl53l7cx_stream_packet_size(uint8_t resolution, uint16_t field_mask);
+
+/* CRC-32 of the packets, shared with the calibration store and the recordings */
+uint32_t vl53l7cx_stream_crc32(uint32_t crc, const uint8_t *p_data, uint32_t size);
+
+/* Platform stream (platform_pico.c) */
+uint8_t VL53L7CX_StreamInitPico(VL53L7CX_Stream *p_stream, uint8_t sensor);
+
+#endif /* _VL53L7CX_STREAM_H_ */
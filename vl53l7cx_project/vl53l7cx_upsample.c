@@ -0,0 +1,474 @@
+/**
+ * Depth Image Upsampling Implementation for VL53L7CX Driver
+ *
+ * See vl53l7cx_upsample.h. Both paths share the per-frame preparation of the
+ * zones (distance, confidence, edge threshold), in integers. The integer path
+ * then reads the 4 zones of each pixel directly. The vector path first
+ * expands each zone row to the output columns (the zones left and right of
+ * each column), so that every output row is computed with contiguous vector
+ * loads only, several pixels at a time.
+ */
+
+#include <stddef.h>
+#include "vl53l7cx_upsample.h"
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#define UPSAMPLE_AVX2
+#define UPSAMPLE_LANES      8U
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#define UPSAMPLE_SSE2
+#define UPSAMPLE_LANES      4U
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+#include <arm_neon.h>
+#define UPSAMPLE_NEON
+#define UPSAMPLE_LANES      4U
+#endif
+
+/* Output columns rounded up to whole vectors */
+#define UPSAMPLE_PADDED_SIZE    ((VL53L7CX_UPSAMPLE_MAX_SIZE + 7U) & ~7U)
+
+/**
+ * @brief Zones of a frame, ready for interpolation
+ */
+typedef struct
+{
+    int16_t            distance[64];
+    uint16_t           confidence[64]; /* 0 (invalid) to 256 */
+    int32_t            edge[64];       /* Largest difference to a zone on the same side */
+} UpsampleZones;
+
+/**
+ * @brief Distance, confidence and edge threshold of each zone
+ */
+static void upsample_prepare(
+        const VL53L7CX_Upsampler *p_up,
+        const VL53L7CX_ResultsData *p_results,
+        UpsampleZones *p_zones)
+{
+    uint8_t zone;
+    uint8_t valid[64];
+#ifndef VL53L7CX_DISABLE_RANGE_SIGMA_MM
+    uint32_t sigma_min = 0xFFFFU;
+#endif
+
+    for (zone = 0; zone < p_up->resolution; zone++) {
+        uint16_t i = (uint16_t)(zone * VL53L7CX_NB_TARGET_PER_ZONE);
+
+        valid[zone] = 1;
+#ifndef VL53L7CX_DISABLE_NB_TARGET_DETECTED
+        valid[zone] = (uint8_t)(p_results->nb_target_detected[zone] > 0U);
+#endif
+#ifndef VL53L7CX_DISABLE_TARGET_STATUS
+        if (p_results->target_status[i] >= 32U
+                || ((p_up->status_mask >> p_results->target_status[i]) & 1U) == 0U) {
+            valid[zone] = 0;
+        }
+#endif
+        p_zones->distance[zone] = p_results->distance_mm[i];
+        p_zones->confidence[zone] = valid[zone] ? 256U : 0U;
+        p_zones->edge[zone] = 0x7FFFFFFF;
+#ifndef VL53L7CX_DISABLE_RANGE_SIGMA_MM
+        if (valid[zone] && p_results->range_sigma_mm[i] < sigma_min) {
+            sigma_min = p_results->range_sigma_mm[i];
+        }
+#endif
+    }
+
+    if (p_up->mode != VL53L7CX_UPSAMPLE_EDGE_AWARE) {
+        return;
+    }
+
+    for (zone = 0; zone < p_up->resolution; zone++) {
+        int32_t distance = p_zones->distance[zone];
+        int32_t edge = (distance > 0) ? (distance * p_up->edge_ratio_q8) >> 8 : 0;
+
+        if (!valid[zone]) {
+            continue;
+        }
+#ifndef VL53L7CX_DISABLE_RANGE_SIGMA_MM
+        {
+            uint32_t sigma = p_results->range_sigma_mm[zone * VL53L7CX_NB_TARGET_PER_ZONE];
+            uint32_t ratio, confidence;
+            int32_t sigma_edge;
+
+            // (sigma_min / sigma)^2 in 1/256, at least 1 for a valid zone
+            ratio = (sigma != 0U) ? (sigma_min << 8) / sigma : 256U;
+            confidence = (ratio * ratio) >> 8;
+            p_zones->confidence[zone] = (uint16_t)((confidence != 0U) ? confidence : 1U);
+
+#ifdef VL53L7CX_USE_RAW_FORMAT
+            sigma_edge = (int32_t)((sigma * p_up->edge_sigma) >> 5);  /* 1/128 mm to 1/4 mm */
+#else
+            sigma_edge = (int32_t)(sigma * p_up->edge_sigma);
+#endif
+            if (sigma_edge > edge) {
+                edge = sigma_edge;
+            }
+        }
+#endif
+        p_zones->edge[zone] = edge;
+    }
+}
+
+/**
+ * @brief Initialize an upsampler
+ * @param p_up: Pointer to upsampler
+ * @param resolution: Resolution of the frames (VL53L7CX_RESOLUTION_4X4 or
+ * VL53L7CX_RESOLUTION_8X8)
+ * @param width: Image width (1 to VL53L7CX_UPSAMPLE_MAX_SIZE)
+ * @param height: Image height (1 to VL53L7CX_UPSAMPLE_MAX_SIZE)
+ * @param mode: VL53L7CX_UPSAMPLE_BILINEAR or VL53L7CX_UPSAMPLE_EDGE_AWARE
+ * @return (uint8_t) status: 0 if OK, 255 for an invalid parameter
+ */
+uint8_t vl53l7cx_upsample_init(
+        VL53L7CX_Upsampler *p_up,
+        uint8_t resolution,
+        uint16_t width,
+        uint16_t height,
+        uint8_t mode)
+{
+    uint8_t n = (resolution == VL53L7CX_RESOLUTION_4X4) ? 4U : 8U;
+    uint16_t i;
+
+    if ((resolution != VL53L7CX_RESOLUTION_4X4 && resolution != VL53L7CX_RESOLUTION_8X8)
+            || width == 0U || width > VL53L7CX_UPSAMPLE_MAX_SIZE
+            || height == 0U || height > VL53L7CX_UPSAMPLE_MAX_SIZE
+            || mode > VL53L7CX_UPSAMPLE_EDGE_AWARE) {
+        return 255;
+    }
+
+    p_up->width = width;
+    p_up->height = height;
+    p_up->resolution = resolution;
+    p_up->mode = mode;
+    p_up->status_mask = VL53L7CX_UPSAMPLE_DEFAULT_STATUS_MASK;
+    p_up->edge_sigma = VL53L7CX_UPSAMPLE_DEFAULT_EDGE_SIGMA;
+    p_up->edge_ratio_q8 = VL53L7CX_UPSAMPLE_DEFAULT_EDGE_RATIO_Q8;
+
+    // Pixel centres on the zone grid, zone centres at 0 to n - 1 (1/256)
+    for (i = 0; i < width; i++) {
+        int32_t x = (int32_t)(((2U * i + 1U) * n * 256U) / (2U * width)) - 128;
+
+        if (x <= 0) {
+            x = 0;
+        } else if (x >= (int32_t)(n - 1U) * 256) {
+            x = (int32_t)(n - 1U) * 256;
+        }
+        p_up->col_x0[i] = (uint8_t)(x >> 8);
+        p_up->col_x1[i] = (uint8_t)((p_up->col_x0[i] + 1U < n) ? p_up->col_x0[i] + 1U
+                : p_up->col_x0[i]);
+        p_up->col_wx[i] = (uint16_t)(x & 0xFF);
+    }
+    for (i = 0; i < height; i++) {
+        int32_t y = (int32_t)(((2U * i + 1U) * n * 256U) / (2U * height)) - 128;
+
+        if (y <= 0) {
+            y = 0;
+        } else if (y >= (int32_t)(n - 1U) * 256) {
+            y = (int32_t)(n - 1U) * 256;
+        }
+        p_up->row_y0[i] = (uint8_t)(y >> 8);
+        p_up->row_y1[i] = (uint8_t)((p_up->row_y0[i] + 1U < n) ? p_up->row_y0[i] + 1U
+                : p_up->row_y0[i]);
+        p_up->row_wy[i] = (uint16_t)(y & 0xFF);
+    }
+
+    return 0;
+}
+
+/**
+ * @brief Set the depth edge of the edge-aware mode
+ * @param p_up: Pointer to upsampler
+ * @param edge_sigma: Edge beyond this many range sigmas of the nearest zone
+ * @param edge_ratio_q8: ... and beyond this share of its distance (1/256)
+ */
+void vl53l7cx_upsample_set_edges(
+        VL53L7CX_Upsampler *p_up,
+        uint8_t edge_sigma,
+        uint8_t edge_ratio_q8)
+{
+    p_up->edge_sigma = edge_sigma;
+    p_up->edge_ratio_q8 = edge_ratio_q8;
+}
+
+/**
+ * @brief Set the accepted target status
+ * @param p_up: Pointer to upsampler
+ * @param status_mask: Bit n accepts target_status n
+ */
+void vl53l7cx_upsample_set_status_mask(
+        VL53L7CX_Upsampler *p_up,
+        uint32_t status_mask)
+{
+    p_up->status_mask = status_mask;
+}
+
+/**
+ * @brief Upsample a frame, integer arithmetic
+ * @param p_up: Pointer to upsampler
+ * @param p_results: Results of the frame
+ * @param p_image: Image of width * height distances
+ */
+void vl53l7cx_upsample_run_fixed(
+        const VL53L7CX_Upsampler *p_up,
+        const VL53L7CX_ResultsData *p_results,
+        int16_t *p_image)
+{
+    UpsampleZones zones;
+    uint8_t n = (p_up->resolution == VL53L7CX_RESOLUTION_4X4) ? 4U : 8U;
+    uint8_t edges = (uint8_t)(p_up->mode == VL53L7CX_UPSAMPLE_EDGE_AWARE);
+    uint16_t row, col;
+
+    upsample_prepare(p_up, p_results, &zones);
+
+    for (row = 0; row < p_up->height; row++) {
+        uint32_t wy = p_up->row_wy[row];
+        uint8_t r0 = (uint8_t)(p_up->row_y0[row] * n);
+        uint8_t r1 = (uint8_t)(p_up->row_y1[row] * n);
+        uint8_t rref = (wy < 128U) ? r0 : r1;
+
+        for (col = 0; col < p_up->width; col++) {
+            uint32_t wx = p_up->col_wx[col];
+            uint8_t x0 = p_up->col_x0[col];
+            uint8_t x1 = p_up->col_x1[col];
+            uint8_t z[4];
+            uint32_t b[4];
+            uint8_t ref = (uint8_t)(rref + ((wx < 128U) ? x0 : x1));
+            int32_t num = 0, den = 0;
+            uint8_t k;
+
+            z[0] = (uint8_t)(r0 + x0);
+            z[1] = (uint8_t)(r0 + x1);
+            z[2] = (uint8_t)(r1 + x0);
+            z[3] = (uint8_t)(r1 + x1);
+            b[0] = (256U - wx) * (256U - wy);
+            b[1] = wx * (256U - wy);
+            b[2] = (256U - wx) * wy;
+            b[3] = wx * wy;
+
+            for (k = 0; k < 4U; k++) {
+                int32_t d = zones.distance[z[k]];
+                /* The 4 weights add up to 65536 at most: num fits in 32 bits */
+                int32_t w = (int32_t)((b[k] * zones.confidence[z[k]]) >> 8);
+
+                if (edges && zones.confidence[ref] != 0U) {
+                    int32_t diff = d - zones.distance[ref];
+
+                    if (diff > zones.edge[ref] || -diff > zones.edge[ref]) {
+                        w = 0;
+                    }
+                }
+                num += w * d;
+                den += w;
+            }
+
+            if (den == 0) {
+                p_image[row * p_up->width + col] = 0;
+            } else {
+                num += (num >= 0) ? den / 2 : -den / 2;
+                p_image[row * p_up->width + col] = (int16_t)(num / den);
+            }
+        }
+    }
+}
+
+#ifdef UPSAMPLE_LANES
+
+#if defined(UPSAMPLE_AVX2)
+typedef __m256 upsample_v;
+#define V_LOAD(p)           _mm256_load_ps(p)
+#define V_SET1(x)           _mm256_set1_ps(x)
+#define V_ADD(a, b)         _mm256_add_ps(a, b)
+#define V_SUB(a, b)         _mm256_sub_ps(a, b)
+#define V_MUL(a, b)         _mm256_mul_ps(a, b)
+#define V_DIV(a, b)         _mm256_div_ps(a, b)
+#define V_AND(a, b)         _mm256_and_ps(a, b)
+#define V_ABS(a)            _mm256_andnot_ps(_mm256_set1_ps(-0.0f), a)
+#define V_LE(a, b)          _mm256_cmp_ps(a, b, _CMP_LE_OQ)
+#define V_GT(a, b)          _mm256_cmp_ps(a, b, _CMP_GT_OQ)
+#define V_EQ(a, b)          _mm256_cmp_ps(a, b, _CMP_EQ_OQ)
+#define V_OR(a, b)          _mm256_or_ps(a, b)
+#define V_SELECT(m, a, b)   _mm256_blendv_ps(b, a, m)   /* m ? a : b */
+#define V_STORE_I32(p, a)   _mm256_store_si256((__m256i *)(p), _mm256_cvtps_epi32(a))
+#elif defined(UPSAMPLE_SSE2)
+typedef __m128 upsample_v;
+#define V_LOAD(p)           _mm_load_ps(p)
+#define V_SET1(x)           _mm_set1_ps(x)
+#define V_ADD(a, b)         _mm_add_ps(a, b)
+#define V_SUB(a, b)         _mm_sub_ps(a, b)
+#define V_MUL(a, b)         _mm_mul_ps(a, b)
+#define V_DIV(a, b)         _mm_div_ps(a, b)
+#define V_AND(a, b)         _mm_and_ps(a, b)
+#define V_ABS(a)            _mm_andnot_ps(_mm_set1_ps(-0.0f), a)
+#define V_LE(a, b)          _mm_cmple_ps(a, b)
+#define V_GT(a, b)          _mm_cmpgt_ps(a, b)
+#define V_EQ(a, b)          _mm_cmpeq_ps(a, b)
+#define V_OR(a, b)          _mm_or_ps(a, b)
+#define V_SELECT(m, a, b)   _mm_or_ps(_mm_and_ps(m, a), _mm_andnot_ps(m, b))
+#define V_STORE_I32(p, a)   _mm_store_si128((__m128i *)(p), _mm_cvtps_epi32(a))
+#else
+typedef float32x4_t upsample_v;
+#define V_LOAD(p)           vld1q_f32(p)
+#define V_SET1(x)           vdupq_n_f32(x)
+#define V_ADD(a, b)         vaddq_f32(a, b)
+#define V_SUB(a, b)         vsubq_f32(a, b)
+#define V_MUL(a, b)         vmulq_f32(a, b)
+#define V_DIV(a, b)         vdivq_f32(a, b)
+#define V_AND(a, b)         vreinterpretq_f32_u32(vandq_u32(vreinterpretq_u32_f32(a), \
+                                    vreinterpretq_u32_f32(b)))
+#define V_ABS(a)            vabsq_f32(a)
+#define V_LE(a, b)          vreinterpretq_f32_u32(vcleq_f32(a, b))
+#define V_GT(a, b)          vreinterpretq_f32_u32(vcgtq_f32(a, b))
+#define V_EQ(a, b)          vreinterpretq_f32_u32(vceqq_f32(a, b))
+#define V_OR(a, b)          vreinterpretq_f32_u32(vorrq_u32(vreinterpretq_u32_f32(a), \
+                                    vreinterpretq_u32_f32(b)))
+#define V_SELECT(m, a, b)   vbslq_f32(vreinterpretq_u32_f32(m), a, b)
+#define V_STORE_I32(p, a)   vst1q_s32(p, vcvtnq_s32_f32(a))
+#endif
+
+/**
+ * @brief Zone rows expanded to the output columns: value of the zone left (0)
+ * and right (1) of each column
+ */
+typedef struct
+{
+    float              d0[8][UPSAMPLE_PADDED_SIZE] __attribute__((aligned(32)));
+    float              d1[8][UPSAMPLE_PADDED_SIZE] __attribute__((aligned(32)));
+    float              c0[8][UPSAMPLE_PADDED_SIZE] __attribute__((aligned(32)));
+    float              c1[8][UPSAMPLE_PADDED_SIZE] __attribute__((aligned(32)));
+    float              e0[8][UPSAMPLE_PADDED_SIZE] __attribute__((aligned(32)));
+    float              e1[8][UPSAMPLE_PADDED_SIZE] __attribute__((aligned(32)));
+    float              wx[UPSAMPLE_PADDED_SIZE] __attribute__((aligned(32)));
+    int32_t            out[UPSAMPLE_PADDED_SIZE] __attribute__((aligned(32)));
+} UpsampleRows;
+
+/**
+ * @brief Upsample a frame, vector float arithmetic
+ */
+static void upsample_run_vector(
+        const VL53L7CX_Upsampler *p_up,
+        const VL53L7CX_ResultsData *p_results,
+        int16_t *p_image)
+{
+    UpsampleZones zones;
+    UpsampleRows rows;
+    uint8_t n = (p_up->resolution == VL53L7CX_RESOLUTION_4X4) ? 4U : 8U;
+    uint16_t padded = (uint16_t)((p_up->width + UPSAMPLE_LANES - 1U) & ~(UPSAMPLE_LANES - 1U));
+    uint16_t row, col;
+    uint8_t y;
+    const upsample_v one = V_SET1(1.0f);
+    const upsample_v middle = V_SET1(127.5f / 256.0f);
+    const upsample_v zero = V_SET1(0.0f);
+    const upsample_v edges = V_SET1(p_up->mode == VL53L7CX_UPSAMPLE_EDGE_AWARE ? 1.0f : 0.0f);
+
+    upsample_prepare(p_up, p_results, &zones);
+
+    // Expansion, padding columns repeat the last one
+    for (col = 0; col < padded; col++) {
+        uint16_t c = (col < p_up->width) ? col : (uint16_t)(p_up->width - 1U);
+        uint8_t x0 = p_up->col_x0[c];
+        uint8_t x1 = p_up->col_x1[c];
+
+        rows.wx[col] = (float)p_up->col_wx[c] * (1.0f / 256.0f);
+        for (y = 0; y < n; y++) {
+            uint8_t z0 = (uint8_t)(y * n + x0);
+            uint8_t z1 = (uint8_t)(y * n + x1);
+
+            rows.d0[y][col] = (float)zones.distance[z0];
+            rows.d1[y][col] = (float)zones.distance[z1];
+            rows.c0[y][col] = (float)zones.confidence[z0] * (1.0f / 256.0f);
+            rows.c1[y][col] = (float)zones.confidence[z1] * (1.0f / 256.0f);
+            rows.e0[y][col] = (float)zones.edge[z0];
+            rows.e1[y][col] = (float)zones.edge[z1];
+        }
+    }
+
+    for (row = 0; row < p_up->height; row++) {
+        uint8_t y0 = p_up->row_y0[row];
+        uint8_t y1 = p_up->row_y1[row];
+        float fy = (float)p_up->row_wy[row] * (1.0f / 256.0f);
+        uint8_t yref = (p_up->row_wy[row] < 128U) ? y0 : y1;
+        const upsample_v by1 = V_SET1(fy);
+        const upsample_v by0 = V_SET1(1.0f - fy);
+
+        for (col = 0; col < padded; col += UPSAMPLE_LANES) {
+            upsample_v bx1 = V_LOAD(&rows.wx[col]);
+            upsample_v bx0 = V_SUB(one, bx1);
+            upsample_v d00 = V_LOAD(&rows.d0[y0][col]);
+            upsample_v d01 = V_LOAD(&rows.d1[y0][col]);
+            upsample_v d10 = V_LOAD(&rows.d0[y1][col]);
+            upsample_v d11 = V_LOAD(&rows.d1[y1][col]);
+            upsample_v w00 = V_MUL(V_MUL(bx0, by0), V_LOAD(&rows.c0[y0][col]));
+            upsample_v w01 = V_MUL(V_MUL(bx1, by0), V_LOAD(&rows.c1[y0][col]));
+            upsample_v w10 = V_MUL(V_MUL(bx0, by1), V_LOAD(&rows.c0[y1][col]));
+            upsample_v w11 = V_MUL(V_MUL(bx1, by1), V_LOAD(&rows.c1[y1][col]));
+            upsample_v num, den, out;
+
+            // Edge-aware: drop the zones beyond an edge from the nearest one
+            {
+                upsample_v right = V_GT(bx1, middle);  /* Nearest zone on the right */
+                upsample_v dref = V_SELECT(right, V_LOAD(&rows.d1[yref][col]),
+                        V_LOAD(&rows.d0[yref][col]));
+                upsample_v cref = V_SELECT(right, V_LOAD(&rows.c1[yref][col]),
+                        V_LOAD(&rows.c0[yref][col]));
+                upsample_v eref = V_SELECT(right, V_LOAD(&rows.e1[yref][col]),
+                        V_LOAD(&rows.e0[yref][col]));
+                upsample_v open = V_OR(V_EQ(edges, zero), V_EQ(cref, zero));
+
+                w00 = V_AND(w00, V_OR(open, V_LE(V_ABS(V_SUB(d00, dref)), eref)));
+                w01 = V_AND(w01, V_OR(open, V_LE(V_ABS(V_SUB(d01, dref)), eref)));
+                w10 = V_AND(w10, V_OR(open, V_LE(V_ABS(V_SUB(d10, dref)), eref)));
+                w11 = V_AND(w11, V_OR(open, V_LE(V_ABS(V_SUB(d11, dref)), eref)));
+            }
+
+            num = V_ADD(V_ADD(V_MUL(w00, d00), V_MUL(w01, d01)),
+                    V_ADD(V_MUL(w10, d10), V_MUL(w11, d11)));
+            den = V_ADD(V_ADD(w00, w01), V_ADD(w10, w11));
+            out = V_DIV(num, V_SELECT(V_GT(den, zero), den, one));
+            V_STORE_I32(&rows.out[col], V_AND(out, V_GT(den, zero)));
+        }
+
+        for (col = 0; col < p_up->width; col++) {
+            p_image[row * p_up->width + col] = (int16_t)rows.out[col];
+        }
+    }
+}
+
+#endif /* UPSAMPLE_LANES */
+
+/**
+ * @brief Upsample a frame, with the vector unit of the host if any
+ * @param p_up: Pointer to upsampler
+ * @param p_results: Results of the frame
+ * @param p_image: Image of width * height distances
+ */
+void vl53l7cx_upsample_run(
+        const VL53L7CX_Upsampler *p_up,
+        const VL53L7CX_ResultsData *p_results,
+        int16_t *p_image)
+{
+#ifdef UPSAMPLE_LANES
+    upsample_run_vector(p_up, p_results, p_image);
+#else
+    vl53l7cx_upsample_run_fixed(p_up, p_results, p_image);
+#endif
+}
+
+/**
+ * @brief Path taken by vl53l7cx_upsample_run()
+ * @return "avx2", "sse2", "neon" or "fixed"
+ */
+const char *vl53l7cx_upsample_path(void)
+{
+#if defined(UPSAMPLE_AVX2)
+    return "avx2";
+#elif defined(UPSAMPLE_SSE2)
+    return "sse2";
+#elif defined(UPSAMPLE_NEON)
+    return "neon";
+#else
+    return "fixed";
+#endif
+}
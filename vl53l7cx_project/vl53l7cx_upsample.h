@@ -0,0 +1,100 @@
+/**
+ * Depth Image Upsampling for VL53L7CX Driver
+ *
+ * Turns the 4x4 or 8x8 distances of a frame into a denser depth image of any
+ * size (16x16, 32x32, 40x30...), for display or obstacle detection. Each
+ * output pixel is a weighted mean of the 4 zones around it:
+ *   - bilinear: weights from the position only,
+ *   - edge-aware: weights also scaled by the confidence of each zone
+ *     (1 / range_sigma_mm^2), and zones beyond a depth edge from the zone
+ *     nearest to the pixel are left out, so no pixel is placed between a
+ *     foreground object and the background.
+ * Zones whose first target is not valid (nb_target_detected, target_status)
+ * have no weight; pixels with no valid zone around them are 0.
+ *
+ * The layout (zones and weights of each output row and column) is computed
+ * once by vl53l7cx_upsample_init(). vl53l7cx_upsample_run_fixed() is integer
+ * only, for the MCU; vl53l7cx_upsample_run() uses SSE2, AVX2 or NEON (float)
+ * when the compiler targets them, and the integer path otherwise. Both give
+ * the same image within 1 distance unit.
+ *
+ * Distances are in the unit of the build (quarter mm with
+ * VL53L7CX_USE_RAW_FORMAT), in the image as in the results.
+ */
+
+#ifndef _VL53L7CX_UPSAMPLE_H_
+#define _VL53L7CX_UPSAMPLE_H_
+
+#include <stdint.h>
+#include "vl53l7cx_api.h"
+
+#ifdef VL53L7CX_DISABLE_DISTANCE_MM
+#error "vl53l7cx_upsample needs the distance output"
+#endif
+
+/**
+ * @brief Largest output width and height.
+ */
+
+#ifndef VL53L7CX_UPSAMPLE_MAX_SIZE
+#define VL53L7CX_UPSAMPLE_MAX_SIZE      64U
+#endif
+
+/**
+ * @brief Interpolation modes.
+ */
+
+#define VL53L7CX_UPSAMPLE_BILINEAR      ((uint8_t) 0U)
+#define VL53L7CX_UPSAMPLE_EDGE_AWARE    ((uint8_t) 1U)
+
+/**
+ * @brief Default accepted target status (5 and 9) and depth edge: a zone is
+ * beyond an edge if it differs from the nearest zone by more than 4 sigmas
+ * and by more than 20/256 (8 %) of its distance.
+ */
+
+#define VL53L7CX_UPSAMPLE_DEFAULT_STATUS_MASK   ((uint32_t)((1UL << 5) | (1UL << 9)))
+#define VL53L7CX_UPSAMPLE_DEFAULT_EDGE_SIGMA    4U
+#define VL53L7CX_UPSAMPLE_DEFAULT_EDGE_RATIO_Q8 20U
+
+/**
+ * @brief Upsampler: output size, mode and layout.
+ */
+
+typedef struct
+{
+    uint16_t           width;
+    uint16_t           height;
+    uint8_t            resolution;     /* VL53L7CX_RESOLUTION_4X4 or _8X8 */
+    uint8_t            mode;           /* VL53L7CX_UPSAMPLE_xxx */
+    uint8_t            edge_sigma;
+    uint8_t            edge_ratio_q8;
+    uint32_t           status_mask;
+    /* Zone columns and weight of the right one (1/256) of each output column */
+    uint8_t            col_x0[VL53L7CX_UPSAMPLE_MAX_SIZE];
+    uint8_t            col_x1[VL53L7CX_UPSAMPLE_MAX_SIZE];
+    uint16_t           col_wx[VL53L7CX_UPSAMPLE_MAX_SIZE];
+    /* Zone rows and weight of the lower one (1/256) of each output row */
+    uint8_t            row_y0[VL53L7CX_UPSAMPLE_MAX_SIZE];
+    uint8_t            row_y1[VL53L7CX_UPSAMPLE_MAX_SIZE];
+    uint16_t           row_wy[VL53L7CX_UPSAMPLE_MAX_SIZE];
+} VL53L7CX_Upsampler;
+
+/* Setup. Returns 0 if OK, 255 for an invalid resolution, size or mode. */
+uint8_t vl53l7cx_upsample_init(VL53L7CX_Upsampler *p_up, uint8_t resolution, uint16_t width,
+        uint16_t height, uint8_t mode);
+void vl53l7cx_upsample_set_edges(VL53L7CX_Upsampler *p_up, uint8_t edge_sigma,
+        uint8_t edge_ratio_q8);
+void vl53l7cx_upsample_set_status_mask(VL53L7CX_Upsampler *p_up, uint32_t status_mask);
+
+/* Upsample a frame of the resolution given to vl53l7cx_upsample_init() into
+ * p_image (width * height distances, row by row) */
+void vl53l7cx_upsample_run(const VL53L7CX_Upsampler *p_up, const VL53L7CX_ResultsData *p_results,
+        int16_t *p_image);
+void vl53l7cx_upsample_run_fixed(const VL53L7CX_Upsampler *p_up,
+        const VL53L7CX_ResultsData *p_results, int16_t *p_image);
+
+/* Path of vl53l7cx_upsample_run(): "avx2", "sse2", "neon" or "fixed" */
+const char *vl53l7cx_upsample_path(void);
+
+#endif /* _VL53L7CX_UPSAMPLE_H_ */
@@ -0,0 +1,229 @@
+#!/usr/bin/env python3
+"""
+VL53L7CX Frame Reader (Python binding)
+======================================
+
+ctypes binding of the host frame reader (vl53l7cx_project/host/vl53l7cx_reader.h):
+a C++ thread reads the binary stream of the Pico 2 (BINARY_STREAM in
+main_st_driver.c) or a capture file, decodes it and keeps the frames in a
+ring, so Python only picks up finished frames.
+
+Build the library first:
+  cmake -S vl53l7cx_project/host -B vl53l7cx_project/host/build
+  cmake --build vl53l7cx_project/host/build
+
+It is looked up in VL53L7CX_READER_LIB (full path), then in that build
+directory, then on the system library path.
+
+Usage:
+  with Reader('/dev/ttyACM0') as reader:
+      for frame in reader:
+          print(frame.sequence, distance_grid(frame))
+
+Run on a capture file to measure the frames parsed per second:
+  python3 vl53l7cx_reader.py capture.bin
+"""
+
+import ctypes
+import ctypes.util
+import os
+import sys
+import time
+
+MAX_ZONES = 64
+MAX_TARGETS = 4
+
+# Field mask bits (VL53L7CX_OUTPUT_* in vl53l7cx_api.h)
+OUTPUT_AMBIENT_PER_SPAD = 0x0008
+OUTPUT_NB_SPADS_ENABLED = 0x0010
+OUTPUT_NB_TARGET_DETECTED = 0x0020
+OUTPUT_SIGNAL_PER_SPAD = 0x0040
+OUTPUT_RANGE_SIGMA_MM = 0x0080
+OUTPUT_DISTANCE_MM = 0x0100
+OUTPUT_REFLECTANCE_PERCENT = 0x0200
+OUTPUT_TARGET_STATUS = 0x0400
+OUTPUT_MOTION_INDICATOR = 0x0800
+
+
+class Frame(ctypes.Structure):
+    """VL53L7CX_ReaderFrame: arrays are valid for the fields of field_mask"""
+    _fields_ = [
+        ('timestamp_us', ctypes.c_uint64),
+        ('sequence', ctypes.c_uint32),
+        ('field_mask', ctypes.c_uint16),
+        ('sensor', ctypes.c_uint8),
+        ('resolution', ctypes.c_uint8),
+        ('nb_targets', ctypes.c_uint8),
+        ('stream_count', ctypes.c_uint8),
+        ('silicon_temp_degc', ctypes.c_int8),
+        ('motion_status', ctypes.c_uint8),
+        ('ambient_per_spad', ctypes.c_uint32 * MAX_ZONES),
+        ('nb_spads_enabled', ctypes.c_uint32 * MAX_ZONES),
+        ('signal_per_spad', ctypes.c_uint32 * (MAX_ZONES * MAX_TARGETS)),
+        ('distance_mm', ctypes.c_int16 * (MAX_ZONES * MAX_TARGETS)),
+        ('range_sigma_mm', ctypes.c_uint16 * (MAX_ZONES * MAX_TARGETS)),
+        ('nb_target_detected', ctypes.c_uint8 * MAX_ZONES),
+        ('reflectance', ctypes.c_uint8 * (MAX_ZONES * MAX_TARGETS)),
+        ('target_status', ctypes.c_uint8 * (MAX_ZONES * MAX_TARGETS)),
+        ('motion_global_indicator_1', ctypes.c_uint32),
+        ('motion_global_indicator_2', ctypes.c_uint32),
+        ('motion_nb_of_detected_aggregates', ctypes.c_uint8),
+        ('motion_nb_of_aggregates', ctypes.c_uint8),
+        ('motion_spare', ctypes.c_uint8 * 2),
+        ('motion', ctypes.c_uint32 * 32),
+    ]
+
+    def has(self, field):
+        return (self.field_mask & field) != 0
+
+
+class Stats(ctypes.Structure):
+    """VL53L7CX_ReaderStats"""
+    _fields_ = [
+        ('frames', ctypes.c_uint64),
+        ('bad_crc', ctypes.c_uint64),
+        ('bad_frames', ctypes.c_uint64),
+        ('lost', ctypes.c_uint64),
+        ('no_reference', ctypes.c_uint64),
+        ('bytes', ctypes.c_uint64),
+        ('nb_overruns', ctypes.c_uint64),
+        ('nb_queued', ctypes.c_uint32),
+        ('ended', ctypes.c_uint32),
+    ]
+
+
+def _load_library():
+    """Find libvl53l7cx_reader: environment, host build directory, system"""
+    candidates = []
+    if os.environ.get('VL53L7CX_READER_LIB'):
+        candidates.append(os.environ['VL53L7CX_READER_LIB'])
+    build_dir = os.path.join(os.path.dirname(os.path.abspath(__file__)),
+                             'vl53l7cx_project', 'host', 'build')
+    for name in ('libvl53l7cx_reader.so', 'libvl53l7cx_reader.dylib'):
+        candidates.append(os.path.join(build_dir, name))
+    system = ctypes.util.find_library('vl53l7cx_reader')
+    if system:
+        candidates.append(system)
+
+    for path in candidates:
+        if os.path.exists(path) or path == system:
+            lib = ctypes.CDLL(path, use_errno=True)
+            break
+    else:
+        raise OSError('libvl53l7cx_reader not found: build vl53l7cx_project/host '
+                      'or set VL53L7CX_READER_LIB')
+
+    lib.vl53l7cx_reader_open.argtypes = [ctypes.c_char_p, ctypes.c_uint32]
+    lib.vl53l7cx_reader_open.restype = ctypes.c_void_p
+    lib.vl53l7cx_reader_read.argtypes = [ctypes.c_void_p, ctypes.POINTER(Frame),
+                                         ctypes.c_uint32, ctypes.c_int32]
+    lib.vl53l7cx_reader_read.restype = ctypes.c_int32
+    lib.vl53l7cx_reader_latest.argtypes = [ctypes.c_void_p, ctypes.POINTER(Frame)]
+    lib.vl53l7cx_reader_latest.restype = ctypes.c_int32
+    lib.vl53l7cx_reader_get_stats.argtypes = [ctypes.c_void_p, ctypes.POINTER(Stats)]
+    lib.vl53l7cx_reader_get_stats.restype = None
+    lib.vl53l7cx_reader_close.argtypes = [ctypes.c_void_p]
+    lib.vl53l7cx_reader_close.restype = None
+    return lib
+
+
+_lib = None
+
+
+class Reader:
+    """
+    Frames of a serial port (read live, oldest frames dropped when the ring
+    is full) or of a capture file (replayed without loss).
+    """
+
+    def __init__(self, path, nb_frames=64):
+        global _lib
+        self._handle = None
+        if _lib is None:
+            _lib = _load_library()
+        self._handle = _lib.vl53l7cx_reader_open(os.fsencode(path), nb_frames)
+        if not self._handle:
+            error = ctypes.get_errno()
+            raise OSError(error, os.strerror(error), path)
+        self._batch = (Frame * 64)()
+
+    def close(self):
+        if self._handle:
+            _lib.vl53l7cx_reader_close(self._handle)
+            self._handle = None
+
+    def __enter__(self):
+        return self
+
+    def __exit__(self, *exc):
+        self.close()
+
+    def __del__(self):
+        self.close()
+
+    def read(self, timeout=None):
+        """
+        Take the frames waiting in the ring, oldest first. Waits up to
+        timeout seconds (None: forever) for the first one. Returns a list
+        of frames (empty on timeout), None once the stream has ended.
+        """
+        timeout_ms = -1 if timeout is None else int(timeout * 1000)
+        count = _lib.vl53l7cx_reader_read(self._handle, self._batch, len(self._batch), timeout_ms)
+        if count < 0:
+            return None
+        # Copies: the batch buffer is reused by the next call
+        return [Frame.from_buffer_copy(self._batch[i]) for i in range(count)]
+
+    def latest(self):
+        """
+        Take the newest frame and drop the older ones (display refresh).
+        Returns the frame, or None if no frame is waiting.
+        """
+        frame = Frame()
+        if _lib.vl53l7cx_reader_latest(self._handle, ctypes.byref(frame)) == 1:
+            return frame
+        return None
+
+    def stats(self):
+        stats = Stats()
+        _lib.vl53l7cx_reader_get_stats(self._handle, ctypes.byref(stats))
+        return stats
+
+    def __iter__(self):
+        while True:
+            frames = self.read()
+            if frames is None:
+                return
+            yield from frames
+
+
+def distance_grid(frame, target=0):
+    """Distances of one target as a width x width numpy array (mm)"""
+    import numpy as np
+
+    width = 8 if frame.resolution == 64 else 4
+    values = np.ctypeslib.as_array(frame.distance_mm)
+    values = values[:frame.resolution * frame.nb_targets]
+    return values[target::frame.nb_targets].reshape(width, width).copy()
+
+
+def main():
+    if len(sys.argv) != 2:
+        print(f'Usage: {sys.argv[0]} <device|capture.bin>', file=sys.stderr)
+        return 2
+
+    start = time.perf_counter()
+    count = 0
+    with Reader(sys.argv[1]) as reader:
+        for _ in reader:
+            count += 1
+        stats = reader.stats()
+    elapsed = time.perf_counter() - start
+
+    print(f'{count} frames in {elapsed:.3f} s: {count / elapsed:.0f} frames/s '
+          f'({stats.lost} lost, {stats.bad_crc} bad CRC, {stats.bad_frames} bad frames)')
+    return 0
+
+
+if __name__ == '__main__':
+    sys.exit(main())
@@ -6,10 +6,16 @@ VL53L7CX Real-Time Heat Map Visualizer
 This application reads distance data from the VL53L7CX sensor via USB serial
 and displays it as a real-time 8x8 heat map with color-coded distances.
 
+With --binary it reads the binary stream (BINARY_STREAM in main_st_driver.c)
+through the host frame reader (vl53l7cx_reader.py) instead of parsing the
+printed grid: frames are decoded on a C++ thread at the sensor rate, and each
+plot refresh shows the newest one.
+
 Requirements:
 - pyserial
 - matplotlib
 - numpy
+- libvl53l7cx_reader (--binary only, see vl53l7cx_reader.py)
 
 Install with: pip install pyserial matplotlib numpy
 """
@@ -24,17 +30,20 @@ from collections import deque
 import argparse
 
 class VL53L7CXVisualizer:
-    def __init__(self, port='/dev/cu.usbmodem23101', baudrate=115200):
+    def __init__(self, port='/dev/cu.usbmodem23101', baudrate=115200, binary=False):
         """
         Initialize the VL53L7CX visualizer
         
         Args:
             port: Serial port (default for macOS)
-            baudrate: Serial baud rate
+            baudrate: Serial baud rate (text output)
+            binary: Read the binary stream instead of the printed grid
         """
         self.port = port
         self.baudrate = baudrate
+        self.binary = binary
         self.serial_conn = None
+        self.reader = None
         self.distance_matrix = np.zeros((8, 8))  # 8x8 distance matrix
         self.max_distance = 2000  # Maximum distance in mm
         self.min_distance = 50    # Minimum distance in mm
@@ -48,9 +57,14 @@ class VL53L7CXVisualizer:
         self.measurement_count = 0
         self.last_update_time = time.time()
         self.fps = 0
+        self.last_frame_count = 0
+        self.lost_frames = 0
         
     def connect_serial(self):
         """Connect to the VL53L7CX sensor via serial"""
+        if self.binary:
+            return self.connect_reader()
+        
         try:
             self.serial_conn = serial.Serial(
                 port=self.port,
@@ -66,6 +80,33 @@ class VL53L7CXVisualizer:
             print(f"❌ Failed to connect to {self.port}: {e}")
             return False
     
+    def connect_reader(self):
+        """Start the frame reader thread on the binary stream"""
+        try:
+            from vl53l7cx_reader import Reader
+            self.reader = Reader(self.port)
+            print(f"✅ Reading binary frames from {self.port}")
+            return True
+        except OSError as e:
+            print(f"❌ Failed to open {self.port}: {e}")
+            return False
+    
+    def read_binary_frame(self):
+        """Show the newest decoded frame; older ones were counted, not drawn"""
+        from vl53l7cx_reader import OUTPUT_DISTANCE_MM, distance_grid
+        
+        frame = self.reader.latest()
+        stats = self.reader.stats()
+        self.measurement_count += stats.frames - self.last_frame_count
+        self.last_frame_count = stats.frames
+        self.lost_frames = stats.lost + stats.nb_overruns
+        if frame is None or not frame.has(OUTPUT_DISTANCE_MM):
+            return
+        
+        grid = distance_grid(frame)
+        valid = (grid >= self.min_distance) & (grid <= self.max_distance)
+        self.distance_matrix = np.where(valid, grid, 0)
+    
     def parse_distance_data(self, line):
         """
         Parse distance data from serial line
@@ -99,30 +140,32 @@ class VL53L7CXVisualizer:
     
     def update_plot(self, frame):
         """Update the heat map plot with new data"""
-        if not self.serial_conn or not self.serial_conn.is_open:
+        if self.reader:
+            self.read_binary_frame()
+        elif not self.serial_conn or not self.serial_conn.is_open:
             return
-        
-        # Read serial data
-        try:
-            while self.serial_conn.in_waiting > 0:
-                line = self.serial_conn.readline().decode('utf-8', errors='ignore').strip()
-                
-                # Look for measurement start
-                if "Measurement #" in line:
-                    self.measurement_count += 1
-                    # Clear the matrix for new measurement
-                    self.distance_matrix.fill(0)
-                
-                # Parse distance data
-                self.parse_distance_data(line)
-                
-                # Look for end of measurement
-                if "===============================================" in line:
-                    break
+        else:
+            # Read serial data
+            try:
+                while self.serial_conn.in_waiting > 0:
+                    line = self.serial_conn.readline().decode('utf-8', errors='ignore').strip()
                     
-        except Exception as e:
-            print(f"Serial read error: {e}")
-            return
+                    # Look for measurement start
+                    if "Measurement #" in line:
+                        self.measurement_count += 1
+                        # Clear the matrix for new measurement
+                        self.distance_matrix.fill(0)
+                    
+                    # Parse distance data
+                    self.parse_distance_data(line)
+                    
+                    # Look for end of measurement
+                    if "===============================================" in line:
+                        break
+                        
+            except Exception as e:
+                print(f"Serial read error: {e}")
+                return
         
         # Update the heat map
         if self.im is None:
@@ -154,8 +197,13 @@ class VL53L7CXVisualizer:
             self.ax.grid(True, alpha=0.3)
             
         else:
-            # Update existing heat map
-            self.im.set_array(self.distance_matrix)
+            # Update existing heat map (4x4 or 8x8 frames)
+            width = self.distance_matrix.shape[0]
+            if self.im.get_array().shape != self.distance_matrix.shape:
+                self.im.set_extent((-0.5, width - 0.5, width - 0.5, -0.5))
+                self.ax.set_xticks(range(width))
+                self.ax.set_yticks(range(width))
+            self.im.set_data(self.distance_matrix)
         
         # Clear previous text annotations
         for text in self.text_annotations:
@@ -163,8 +211,8 @@ class VL53L7CXVisualizer:
         self.text_annotations.clear()
         
         # Add distance values as text
-        for i in range(8):
-            for j in range(8):
+        for i in range(self.distance_matrix.shape[0]):
+            for j in range(self.distance_matrix.shape[1]):
                 distance = self.distance_matrix[i, j]
                 if distance > 0:
                     # Choose text color based on background
@@ -186,6 +234,8 @@ class VL53L7CXVisualizer:
         # Update title with statistics
         title = f'VL53L7CX Real-Time Distance Heat Map\n'
         title += f'Measurements: {self.measurement_count} | FPS: {self.fps:.1f}'
+        if self.reader:
+            title += f' | Lost: {self.lost_frames}'
         self.ax.set_title(title, fontsize=14, fontweight='bold')
         
         return [self.im] + self.text_annotations
@@ -218,6 +268,9 @@ class VL53L7CXVisualizer:
             if self.serial_conn and self.serial_conn.is_open:
                 self.serial_conn.close()
                 print("📡 Serial connection closed")
+            if self.reader:
+                self.reader.close()
+                print("📡 Frame reader closed")
 
 def main():
     """Main function with command line argument parsing"""
@@ -229,6 +282,7 @@ Examples:
   python vl53l7cx_visualizer.py
   python vl53l7cx_visualizer.py --port /dev/ttyUSB0
   python vl53l7cx_visualizer.py --port COM3 --baudrate 115200
+  python vl53l7cx_visualizer.py --port /dev/ttyACM0 --binary
         """
     )
     
@@ -245,10 +299,17 @@ Examples:
         help='Serial baud rate (default: 115200)'
     )
     
+    parser.add_argument(
+        '--binary',
+        action='store_true',
+        help='Read the binary stream (firmware built with BINARY_STREAM)'
+    )
+    
     args = parser.parse_args()
     
     # Create and run visualizer
-    visualizer = VL53L7CXVisualizer(port=args.port, baudrate=args.baudrate)
+    visualizer = VL53L7CXVisualizer(port=args.port, baudrate=args.baudrate,
+                                    binary=args.binary)
     visualizer.run()
 
 if __name__ == '__main__':